@@ -21,11 +21,17 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#include <algorithm>
 #include <cctype>
+#include <functional>
+
+#include "shared_per_database.hxx"
 
 #include <graphene/app/api.hpp>
 #include <graphene/app/api_access.hpp>
 #include <graphene/app/application.hpp>
+#include <graphene/account_history/account_history_plugin.hpp>
+#include <graphene/api_helper_indexes/api_helper_indexes.hpp>
 #include <graphene/chain/database.hpp>
 #include <graphene/chain/get_config.hpp>
 #include <graphene/utilities/key_conversion.hpp>
@@ -41,6 +47,8 @@
 #include <fc/rpc/api_connection.hpp>
 #include <fc/thread/future.hpp>
 
+#include <deque>
+
 template class fc::api<graphene::app::block_api>;
 template class fc::api<graphene::app::network_broadcast_api>;
 template class fc::api<graphene::app::network_node_api>;
@@ -49,7 +57,10 @@ template class fc::api<graphene::app::crypto_api>;
 template class fc::api<graphene::app::asset_api>;
 template class fc::api<graphene::app::orders_api>;
 template class fc::api<graphene::app::custom_operations_api>;
+template class fc::api<graphene::app::content_cards_api>;
+template class fc::api<graphene::app::metrics_api>;
 template class fc::api<graphene::debug_witness::debug_api>;
+template class fc::api<graphene::witness_plugin::witness_api>;
 template class fc::api<graphene::app::login_api>;
 
 
@@ -58,6 +69,10 @@ namespace graphene { namespace app {
     login_api::login_api(application& a)
     :_app(a)
     {
+       const auto& options = _app.get_options();
+       if( options.api_time_budget_per_second > 0 )
+          _budget = std::make_shared<api_call_budget>( options.api_time_budget_per_second * 1000,
+                                                       options.api_time_budget_max * 1000 );
     }
 
     login_api::~login_api()
@@ -81,61 +96,157 @@ namespace graphene { namespace app {
              return false;
        }
 
+       _user = user;
        for( const std::string& api_name : acc->allowed_apis )
           enable_api( api_name );
        return true;
     }
 
+    template<typename Api>
+    void login_api::instrument( fc::api<Api>& api, const string& api_name )const
+    {
+       std::shared_ptr<api_metrics> metrics;
+       if( _app.get_options().enable_api_metrics )
+          metrics = _app.get_api_metrics();
+       if( metrics || _budget )
+          api->visit( api_call_instrumenter( metrics, _budget, api_name, _user ) );
+    }
+
     void login_api::enable_api( const std::string& api_name )
     {
        if( api_name == "database_api" )
        {
           _database_api = std::make_shared< database_api >( std::ref( *_app.chain_database() ), &( _app.get_options() ) );
+          instrument( *_database_api, api_name );
        }
        else if( api_name == "block_api" )
        {
           _block_api = std::make_shared< block_api >( std::ref( *_app.chain_database() ) );
+          instrument( *_block_api, api_name );
        }
        else if( api_name == "network_broadcast_api" )
        {
           _network_broadcast_api = std::make_shared< network_broadcast_api >( std::ref( _app ) );
+          instrument( *_network_broadcast_api, api_name );
        }
        else if( api_name == "history_api" )
        {
           _history_api = std::make_shared< history_api >( _app );
+          instrument( *_history_api, api_name );
        }
        else if( api_name == "network_node_api" )
        {
           _network_node_api = std::make_shared< network_node_api >( std::ref(_app) );
+          instrument( *_network_node_api, api_name );
        }
        else if( api_name == "crypto_api" )
        {
           _crypto_api = std::make_shared< crypto_api >();
+          instrument( *_crypto_api, api_name );
        }
        else if( api_name == "asset_api" )
        {
           _asset_api = std::make_shared< asset_api >( _app );
+          instrument( *_asset_api, api_name );
        }
        else if( api_name == "orders_api" )
        {
           _orders_api = std::make_shared< orders_api >( std::ref( _app ) );
+          instrument( *_orders_api, api_name );
        }
        else if( api_name == "custom_operations_api" )
        {
           if( _app.get_plugin( "custom_operations" ) )
+          {
              _custom_operations_api = std::make_shared< custom_operations_api >( std::ref( _app ) );
+             instrument( *_custom_operations_api, api_name );
+          }
+       }
+       else if( api_name == "content_cards_api" )
+       {
+          if( _app.get_plugin( "content_cards" ) )
+          {
+             _content_cards_api = std::make_shared< content_cards_api >( std::ref( _app ) );
+             instrument( *_content_cards_api, api_name );
+          }
        }
        else if( api_name == "debug_api" )
        {
           // can only enable this API if the plugin was loaded
           if( _app.get_plugin( "debug_witness" ) )
+          {
              _debug_api = std::make_shared< graphene::debug_witness::debug_api >( std::ref(_app) );
+             instrument( *_debug_api, api_name );
+          }
+       }
+       else if( api_name == "witness_api" )
+       {
+          // can only enable this API if the plugin was loaded
+          if( _app.get_plugin( "witness" ) )
+          {
+             _witness_api = std::make_shared< graphene::witness_plugin::witness_api >( std::ref(_app) );
+             instrument( *_witness_api, api_name );
+          }
+       }
+       else if( api_name == "metrics_api" )
+       {
+          _metrics_api = std::make_shared< metrics_api >( std::ref( _app ) );
        }
        return;
     }
 
     // block_api
-    block_api::block_api(graphene::chain::database& db) : _db(db) { }
+    /**
+     * The merkle trees of recently requested blocks, shared by the block API sessions of a database. Trees are kept
+     * by block ID, so that they stay valid across chain reorganizations.
+     */
+    class merkle_tree_cache
+    {
+    public:
+       static constexpr size_t max_blocks = 256;
+
+       explicit merkle_tree_cache( graphene::chain::database& ) {}
+
+       /// The levels of the merkle tree of @p block, see @ref merkle_proof::calculate_tree
+       std::shared_ptr<const vector<vector<digest_type>>> get( const signed_block& block )
+       {
+          const block_id_type id = block.id();
+          {
+             std::lock_guard<std::mutex> guard( _mutex );
+             auto itr = _trees.find( id );
+             if( itr != _trees.end() )
+                return itr->second;
+          }
+
+          vector<digest_type> leaves;
+          leaves.reserve( block.transactions.size() );
+          for( const auto& trx : block.transactions )
+             leaves.push_back( trx.merkle_digest() );
+          auto tree = std::make_shared<const vector<vector<digest_type>>>(
+                graphene::protocol::merkle_proof::calculate_tree( std::move( leaves ) ) );
+
+          std::lock_guard<std::mutex> guard( _mutex );
+          if( _trees.emplace( id, tree ).second )
+          {
+             _order.push_back( id );
+             if( _order.size() > max_blocks )
+             {
+                _trees.erase( _order.front() );
+                _order.pop_front();
+             }
+          }
+          return tree;
+       }
+
+    private:
+       std::mutex _mutex;
+       std::map<block_id_type, std::shared_ptr<const vector<vector<digest_type>>>> _trees;
+       /// Cached blocks, oldest first
+       std::deque<block_id_type> _order;
+    };
+
+    block_api::block_api(graphene::chain::database& db)
+    : _db(db), _merkle_trees( get_shared_per_database<merkle_tree_cache>( db ) ) { }
     block_api::~block_api() { }
 
     vector<optional<signed_block>> block_api::get_blocks(uint32_t block_num_from, uint32_t block_num_to)const
@@ -148,6 +259,70 @@ namespace graphene { namespace app {
        return res;
     }
 
+    vector<optional<string>> block_api::get_packed_blocks(uint32_t block_num_from, uint32_t block_num_to)const
+    {
+       FC_ASSERT( block_num_to >= block_num_from );
+       vector<optional<string>> res;
+       vector<char> data;
+       for(uint32_t block_num=block_num_from; block_num<=block_num_to; block_num++) {
+          if( _db.fetch_packed_block_by_number( block_num, data ) )
+             res.push_back( fc::to_hex( data.data(), data.size() ) );
+          else
+             res.emplace_back();
+       }
+       return res;
+    }
+
+    vector<optional<signed_block_header>> block_api::get_block_headers(uint32_t block_num_from,
+                                                                       uint32_t block_num_to)const
+    {
+       FC_ASSERT( block_num_to >= block_num_from );
+       FC_ASSERT( block_num_to - block_num_from < max_block_headers,
+                  "Can not get more than ${m} block headers at once", ("m", max_block_headers) );
+       vector<optional<signed_block_header>> res;
+       res.reserve( block_num_to - block_num_from + 1 );
+       vector<char> data;
+       for(uint32_t block_num=block_num_from; block_num<=block_num_to; block_num++) {
+          if( _db.fetch_packed_block_by_number( block_num, data ) )
+          {
+             // the header is serialized before the transactions, which are left alone
+             fc::datastream<const char*> ds( data.data(), data.size() );
+             signed_block_header header;
+             fc::raw::unpack( ds, header );
+             res.push_back( std::move( header ) );
+          }
+          else
+             res.emplace_back();
+       }
+       return res;
+    }
+
+    optional<transaction_inclusion_proof> block_api::get_transaction_inclusion_proof(uint32_t block_num,
+                                                                                     uint32_t trx_in_block)const
+    {
+       const auto block = _db.fetch_block_by_number( block_num );
+       if( !block.valid() )
+          return {};
+       FC_ASSERT( trx_in_block < block->transactions.size(),
+                  "Block ${b} has no transaction ${t}", ("b", block_num)("t", trx_in_block) );
+       const auto tree = _merkle_trees->get( *block );
+       transaction_inclusion_proof result;
+       result.header = *block;
+       result.leaf = tree->front()[trx_in_block];
+       result.proof = graphene::protocol::merkle_proof( *tree, trx_in_block );
+       return result;
+    }
+
+    graphene::chain::block_cache_stats block_api::get_block_cache_stats()const
+    {
+       return _db.get_block_cache_stats();
+    }
+
+    graphene::chain::signature_cache_stats block_api::get_signature_cache_stats()const
+    {
+       return _db.get_signature_cache_stats();
+    }
+
     network_broadcast_api::network_broadcast_api(application& a):_app(a)
     {
        _applied_block_connection = _app.chain_database()->applied_block.connect([this](const signed_block& b){ on_applied_block(b); });
@@ -155,6 +330,38 @@ namespace graphene { namespace app {
 
     void network_broadcast_api::on_applied_block( const signed_block& b )
     {
+       if( !_batch_callbacks.empty() )
+       {
+          auto capture_this = shared_from_this();
+          const auto block_num = b.block_num();
+          std::map< std::shared_ptr<pending_batch>, vector<transaction_confirmation> > confirmed;
+          for( uint32_t trx_num = 0; trx_num < b.transactions.size(); ++trx_num )
+          {
+             const auto& trx = b.transactions[trx_num];
+             auto id = trx.id();
+             auto itr = _batch_callbacks.find( id );
+             if( itr == _batch_callbacks.end() )
+                continue;
+             confirmed[itr->second].push_back( transaction_confirmation{ id, block_num, trx_num, trx } );
+             _batch_callbacks.erase( itr );
+          }
+          for( auto& item : confirmed )
+          {
+             auto callback = item.first->callback;
+             auto v = fc::variant( item.second, GRAPHENE_MAX_NESTED_OBJECTS );
+             fc::async( [capture_this,v,callback]() {
+                callback(v);
+             } );
+          }
+          // transactions which can no longer be included
+          for( auto itr = _batch_callbacks.begin(); itr != _batch_callbacks.end(); )
+          {
+             if( itr->second->expiration < b.timestamp )
+                itr = _batch_callbacks.erase( itr );
+             else
+                ++itr;
+          }
+       }
        if( _callbacks.size() )
        {
           /// we need to ensure the database_api is not deleted for the life of the async operation
@@ -195,6 +402,68 @@ namespace graphene { namespace app {
        return fc::future<fc::variant>(prom).wait();
     }
 
+    vector<network_broadcast_api::transaction_result> network_broadcast_api::broadcast_transactions(
+          const vector<precomputable_transaction>& trxs )
+    {
+       return broadcast_transactions_with_callback( block_confirmation_callback(), trxs );
+    }
+
+    vector<network_broadcast_api::transaction_result> network_broadcast_api::broadcast_transactions_with_callback(
+          block_confirmation_callback cb, const vector<precomputable_transaction>& trxs )
+    {
+       FC_ASSERT( _app.p2p_node() != nullptr, "Not connected to P2P network, can't broadcast!" );
+       const auto& db = _app.chain_database();
+
+       // the signatures of all transactions are checked on the thread pool at the same time
+       vector< fc::future<void> > precomputed;
+       precomputed.reserve( trxs.size() );
+       for( const auto& trx : trxs )
+          precomputed.push_back( db->precompute_parallel( trx ) );
+
+       vector<transaction_result> result( trxs.size() );
+       for( size_t i = 0; i < trxs.size(); ++i )
+       {
+          result[i].id = trxs[i].id();
+          try
+          {
+             precomputed[i].wait();
+          }
+          catch( const fc::exception& e )
+          {
+             result[i].error = e.to_string();
+          }
+       }
+
+       std::shared_ptr<pending_batch> batch;
+       if( cb )
+       {
+          batch = std::make_shared<pending_batch>();
+          batch->callback = cb;
+       }
+       for( size_t i = 0; i < trxs.size(); ++i )
+       {
+          if( !result[i].error.empty() )
+             continue;
+          try
+          {
+             db->push_transaction( trxs[i] );
+          }
+          catch( const fc::exception& e )
+          {
+             result[i].error = e.to_string();
+             continue;
+          }
+          result[i].accepted = true;
+          _app.p2p_node()->broadcast_transaction( trxs[i] );
+          if( batch )
+          {
+             _batch_callbacks[result[i].id] = batch;
+             batch->expiration = std::max( batch->expiration, trxs[i].expiration );
+          }
+       }
+       return result;
+    }
+
     void network_broadcast_api::broadcast_block( const signed_block& b )
     {
        FC_ASSERT( _app.p2p_node() != nullptr, "Not connected to P2P network, can't broadcast!" );
@@ -256,6 +525,12 @@ namespace graphene { namespace app {
        return _app.p2p_node()->set_advanced_node_parameters(params);
     }
 
+    fc::variant_object network_node_api::get_network_usage_stats() const
+    {
+       FC_ASSERT( _app.p2p_node() != nullptr, "No P2P network!" );
+       return _app.p2p_node()->network_get_usage_stats();
+    }
+
     fc::api<network_broadcast_api> login_api::network_broadcast()const
     {
        FC_ASSERT(_network_broadcast_api);
@@ -310,12 +585,30 @@ namespace graphene { namespace app {
        return *_debug_api;
     }
 
+    fc::api<graphene::witness_plugin::witness_api> login_api::witness() const
+    {
+       FC_ASSERT(_witness_api);
+       return *_witness_api;
+    }
+
     fc::api<custom_operations_api> login_api::custom_operations() const
     {
        FC_ASSERT(_custom_operations_api);
        return *_custom_operations_api;
     }
 
+    fc::api<content_cards_api> login_api::content_cards() const
+    {
+       FC_ASSERT(_content_cards_api);
+       return *_content_cards_api;
+    }
+
+    fc::api<metrics_api> login_api::metrics() const
+    {
+       FC_ASSERT(_metrics_api);
+       return *_metrics_api;
+    }
+
     vector<order_history_object> history_api::get_fill_order_history( std::string asset_a, std::string asset_b,
                                                                       uint32_t limit )const
     {
@@ -346,6 +639,45 @@ namespace graphene { namespace app {
        return result;
     }
 
+    /**
+     * Continues a history query with the entries the account_history plugin moved to its archive, newest first
+     * @param visit called for each entry, returns false to end the query
+     */
+    template<typename Visitor>
+    static void visit_archived_history( const application& app, account_id_type account, uint64_t last_sequence,
+                                        Visitor visit )
+    {
+       if( last_sequence == 0 || !app.is_plugin_enabled( "account_history" ) )
+          return;
+       auto plugin = app.get_plugin<graphene::account_history::account_history_plugin>( "account_history" );
+       const graphene::account_history::account_history_archive* archive = plugin->history_archive();
+       if( archive == nullptr )
+          return;
+       const uint32_t entries_per_read = 100;
+       while( true )
+       {
+          const vector<operation_history_object> entries = archive->read( account, last_sequence, entries_per_read );
+          for( const operation_history_object& entry : entries )
+          {
+             if( !visit( entry ) )
+                return;
+          }
+          if( entries.size() < entries_per_read || last_sequence <= entries_per_read )
+             return;
+          last_sequence -= entries_per_read;
+       }
+    }
+
+    /// The history entries by operation type, null if the account_history plugin does not maintain them
+    static const graphene::account_history::account_history_by_type_index* get_history_by_type_index(
+          const application& app )
+    {
+       if( !app.is_plugin_enabled( "account_history" ) )
+          return nullptr;
+       return app.get_plugin<graphene::account_history::account_history_plugin>( "account_history" )
+                 ->history_by_type_index();
+    }
+
     vector<operation_history_object> history_api::get_account_history( const std::string account_id_or_name,
                                                                        operation_history_id_type stop,
                                                                        uint32_t limit,
@@ -370,14 +702,9 @@ namespace graphene { namespace app {
 
        if(_app.is_plugin_enabled("elasticsearch")) {
           auto es = _app.get_plugin<elasticsearch::elasticsearch_plugin>("elasticsearch");
-          if(es.get()->get_running_mode() != elasticsearch::mode::only_save) {
-             if(!_app.elasticsearch_thread)
-                _app.elasticsearch_thread= std::make_shared<fc::thread>("elasticsearch");
-
-             return _app.elasticsearch_thread->async([&es, &account, &stop, &limit, &start]() {
-                return es->get_account_history(account, stop, limit, start);
-             }, "thread invoke for method " BOOST_PP_STRINGIZE(method_name)).wait();
-          }
+          // the plugin sends the query from one of its own threads
+          if(es.get()->get_running_mode() != elasticsearch::mode::only_save)
+             return es->get_account_history(account, stop, limit, start);
        }
 
        const auto& hist_idx = db.get_index_type<account_transaction_history_index>();
@@ -395,6 +722,15 @@ namespace graphene { namespace app {
          result.push_back(itr->operation_id(db));
        }
 
+       visit_archived_history( _app, account, account(db).statistics(db).removed_ops,
+                               [&]( const operation_history_object& entry ) {
+          if( result.size() >= limit || entry.id.instance() <= stop.instance.value )
+             return false;
+          if( entry.id.instance() <= start.instance.value )
+             result.push_back( entry );
+          return true;
+       });
+
        return result;
     }
 
@@ -423,6 +759,28 @@ namespace graphene { namespace app {
        if( start == operation_history_id_type() )
           start = node->operation_id;
 
+       const auto* by_type = get_history_by_type_index( _app );
+       if( by_type != nullptr )
+       {
+          // the newest entry whose operation is not newer than start
+          const auto& hist_idx = db.get_index_type<account_transaction_history_index>();
+          const auto& by_op_idx = hist_idx.indices().get<by_op>();
+          const auto& by_seq_idx = hist_idx.indices().get<by_seq>();
+          auto itr = by_op_idx.upper_bound( boost::make_tuple( account, start ) );
+          node = nullptr;
+          if( itr != by_op_idx.begin() && (--itr)->account == account )
+          {
+             for( uint64_t sequence : by_type->get_sequences( account, static_cast<uint16_t>( operation_type ), 0,
+                                                              itr->sequence, limit ) )
+             {
+                const auto& entry = *by_seq_idx.find( boost::make_tuple( account, sequence ) );
+                if( entry.operation_id.instance.value <= stop.instance.value )
+                   break;
+                result.push_back( entry.operation_id(db) );
+             }
+          }
+       }
+
        while(node && node->operation_id.instance.value > stop.instance.value && result.size() < limit)
        {
           if( node->operation_id.instance.value <= start.instance.value ) {
@@ -434,11 +792,19 @@ namespace graphene { namespace app {
              node = nullptr;
           else node = &node->next(db);
        }
-       if( stop.instance.value == 0 && result.size() < limit ) {
+       if( by_type == nullptr && stop.instance.value == 0 && result.size() < limit ) {
           auto head = db.find(account_transaction_history_id_type());
           if (head != nullptr && head->account == account && head->operation_id(db).op.which() == operation_type)
             result.push_back(head->operation_id(db));
        }
+
+       visit_archived_history( _app, account, stats.removed_ops, [&]( const operation_history_object& entry ) {
+          if( result.size() >= limit || entry.id.instance() <= stop.instance.value )
+             return false;
+          if( entry.id.instance() <= start.instance.value && entry.op.which() == operation_type )
+             result.push_back( entry );
+          return true;
+       });
        return result;
     }
 
@@ -482,6 +848,18 @@ namespace graphene { namespace app {
           }
           while ( itr != itr_stop && result.size() < limit );
        }
+
+       if( start >= stop && stop <= stats.removed_ops && result.size() < limit )
+       {
+          uint64_t sequence = std::min( start, stats.removed_ops );
+          visit_archived_history( _app, account, sequence, [&]( const operation_history_object& entry ) {
+             if( result.size() >= limit || sequence < stop )
+                return false;
+             result.push_back( entry );
+             --sequence;
+             return true;
+          });
+       }
        return result;
     }
 
@@ -502,6 +880,37 @@ namespace graphene { namespace app {
                   ("configured_limit", configured_limit) );
 
        history_operation_detail result;
+       const auto* by_type = get_history_by_type_index( _app );
+       if( by_type != nullptr && !operation_types.empty() && limit > 0 )
+       {
+          FC_ASSERT( _app.chain_database() );
+          const auto& db = *_app.chain_database();
+          account_id_type account;
+          try {
+             account = database_api.get_account_id_from_string(account_id_or_name);
+          } catch(...) { return result; }
+          const auto& stats = account(db).statistics(db);
+          const uint64_t last_sequence = std::min( stats.total_ops, uint64_t( limit ) + start - 1 );
+          // the same entries as below when all of them are in memory, but without looking at the other types
+          if( start > stats.removed_ops && last_sequence >= start )
+          {
+             result.total_count = last_sequence - start + 1;
+             vector<uint64_t> sequences;
+             for( uint16_t operation_type : operation_types )
+             {
+                const vector<uint64_t> of_type = by_type->get_sequences( account, operation_type, start,
+                                                                         last_sequence, limit );
+                sequences.insert( sequences.end(), of_type.begin(), of_type.end() );
+             }
+             std::sort( sequences.begin(), sequences.end(), std::greater<uint64_t>() );
+             const auto& by_seq_idx = db.get_index_type<account_transaction_history_index>().indices().get<by_seq>();
+             for( uint64_t sequence : sequences )
+                result.operation_history_objs.push_back(
+                      by_seq_idx.find( boost::make_tuple( account, sequence ) )->operation_id(db) );
+             return result;
+          }
+       }
+
        vector<operation_history_object> objs = get_relative_account_history( account_id_or_name, start, limit,
                                                                              limit + start - 1 );
        result.total_count = objs.size();
@@ -533,11 +942,15 @@ namespace graphene { namespace app {
        const auto& db = *_app.chain_database();
        asset_id_type a = database_api.get_asset_id_from_string( asset_a );
        asset_id_type b = database_api.get_asset_id_from_string( asset_b );
-       vector<bucket_object> result;
-       result.reserve(200);
 
        if( a > b ) std::swap(a,b);
 
+       if( const auto* store = market_hist_plugin->get_bucket_store() )
+          return store->get_buckets( a, b, bucket_seconds, start, end, 200 );
+
+       vector<bucket_object> result;
+       result.reserve(200);
+
        const auto& bidx = db.get_index_type<bucket_index>();
        const auto& by_key_idx = bidx.indices().get<by_key>();
 
@@ -615,7 +1028,18 @@ namespace graphene { namespace app {
           _app(app),
           _db( *app.chain_database()),
           database_api( std::ref(*app.chain_database()), &(app.get_options())
-          ) { }
+          )
+    {
+       try
+       {
+          _holders_count_index = &_db.get_index_type< primary_index< account_balance_index > >()
+                                    .get_secondary_index<graphene::api_helper_indexes::asset_holders_count_index>();
+       }
+       catch( fc::assert_exception& e )
+       {
+          _holders_count_index = nullptr;
+       }
+    }
     asset_api::~asset_api() { }
 
     vector<account_asset_balance> asset_api::get_asset_holders( std::string asset, uint32_t start, uint32_t limit ) const
@@ -655,35 +1079,70 @@ namespace graphene { namespace app {
 
        return result;
     }
-    // get number of asset holders.
-    int asset_api::get_asset_holders_count( std::string asset ) const {
-       const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
+
+    vector<account_asset_balance> asset_api::get_asset_holders_after( std::string asset, share_type last_amount,
+                                                                      account_id_type last_account,
+                                                                      uint32_t limit ) const
+    {
+       const auto configured_limit = _app.get_options().api_limit_get_asset_holders;
+       FC_ASSERT( limit <= configured_limit,
+                  "limit can not be greater than ${configured_limit}",
+                  ("configured_limit", configured_limit) );
+
        asset_id_type asset_id = database_api.get_asset_id_from_string( asset );
-       auto range = bal_idx.equal_range( boost::make_tuple( asset_id ) );
+       const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
+       auto itr = bal_idx.upper_bound( boost::make_tuple( asset_id, last_amount, last_account ) );
 
-       int count = boost::distance(range) - 1;
+       vector<account_asset_balance> result;
+       // balances are ordered from the largest down, so the zero balances come last
+       for( ; itr != bal_idx.end() && itr->asset_type == asset_id && itr->balance.value > 0
+              && result.size() < limit; ++itr )
+       {
+          const auto& account = itr->owner(_db);
+
+          account_asset_balance aab;
+          aab.name       = account.name;
+          aab.account_id = account.id;
+          aab.amount     = itr->balance.value;
 
+          result.push_back(aab);
+       }
+       return result;
+    }
+
+    uint64_t asset_api::count_holders( asset_id_type asset_id ) const
+    {
+       if( _holders_count_index != nullptr )
+          return _holders_count_index->get_holders_count( asset_id );
+
+       const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
+       auto range = bal_idx.equal_range( boost::make_tuple( asset_id ) );
+       uint64_t count = 0;
+       for( const account_balance_object& bal : boost::make_iterator_range( range.first, range.second ) )
+       {
+          if( bal.balance.value == 0 )
+             break;
+          ++count;
+       }
        return count;
     }
+
+    // get number of asset holders.
+    int asset_api::get_asset_holders_count( std::string asset ) const {
+       asset_id_type asset_id = database_api.get_asset_id_from_string( asset );
+       return count_holders( asset_id );
+    }
     // function to get vector of system assets with holders count.
     vector<asset_holders> asset_api::get_all_asset_holders() const {
        vector<asset_holders> result;
        vector<asset_id_type> total_assets;
        for( const asset_object& asset_obj : _db.get_index_type<asset_index>().indices() )
        {
-          const auto& dasset_obj = asset_obj.dynamic_asset_data_id(_db);
-
-          asset_id_type asset_id;
-          asset_id = dasset_obj.id;
-
-          const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
-          auto range = bal_idx.equal_range( boost::make_tuple( asset_id ) );
-
-          int count = boost::distance(range) - 1;
+          asset_id_type asset_id = asset_obj.get_id();
 
           asset_holders ah;
           ah.asset_id       = asset_id;
-          ah.count     = count;
+          ah.count     = count_holders( asset_id );
 
           result.push_back(ah);
        }
@@ -692,6 +1151,30 @@ namespace graphene { namespace app {
     }
 
    // orders_api
+   /// Groups of orders selling @p base_asset_id for @p quote_asset_id, starting from @p start if it is set
+   static vector< limit_order_group > get_limit_order_groups(
+         const map< limit_order_group_key, limit_order_group_data >& limit_groups,
+         asset_id_type base_asset_id, asset_id_type quote_asset_id, uint16_t group,
+         const optional<price>& start, uint32_t limit )
+   {
+      vector< limit_order_group > result;
+
+      price max_price = price::max( base_asset_id, quote_asset_id );
+      price min_price = price::min( base_asset_id, quote_asset_id );
+      if( start.valid() && !start->is_null() )
+         max_price = std::max( std::min( max_price, *start ), min_price );
+
+      auto itr = limit_groups.lower_bound( limit_order_group_key( group, max_price ) );
+      // use an end iterator to try to avoid expensive price comparison
+      auto end = limit_groups.upper_bound( limit_order_group_key( group, min_price ) );
+      while( itr != end && result.size() < limit )
+      {
+         result.emplace_back( *itr );
+         ++itr;
+      }
+      return result;
+   }
+
    flat_set<uint16_t> orders_api::get_tracked_groups()const
    {
       auto plugin = _app.get_plugin<grouped_orders_plugin>( "grouped_orders" );
@@ -712,24 +1195,43 @@ namespace graphene { namespace app {
 
       auto plugin = _app.get_plugin<graphene::grouped_orders::grouped_orders_plugin>( "grouped_orders" );
       FC_ASSERT( plugin );
-      const auto& limit_groups = plugin->limit_order_groups();
-      vector< limit_order_group > result;
 
       asset_id_type base_asset_id = database_api.get_asset_id_from_string( base_asset );
       asset_id_type quote_asset_id = database_api.get_asset_id_from_string( quote_asset );
 
-      price max_price = price::max( base_asset_id, quote_asset_id );
-      price min_price = price::min( base_asset_id, quote_asset_id );
-      if( start.valid() && !start->is_null() )
-         max_price = std::max( std::min( max_price, *start ), min_price );
+      return get_limit_order_groups( plugin->limit_order_groups(), base_asset_id, quote_asset_id, group, start, limit );
+   }
 
-      auto itr = limit_groups.lower_bound( limit_order_group_key( group, max_price ) );
-      // use an end iterator to try to avoid expensive price comparison
-      auto end = limit_groups.upper_bound( limit_order_group_key( group, min_price ) );
-      while( itr != end && result.size() < limit )
+   vector< grouped_order_book > orders_api::get_grouped_order_books(
+         vector< std::pair<std::string, std::string> > markets, uint16_t group, uint32_t limit )const
+   {
+      const auto configured_limit = _app.get_options().api_limit_get_grouped_limit_orders;
+      FC_ASSERT( limit <= configured_limit,
+                 "limit can not be greater than ${configured_limit}",
+                 ("configured_limit", configured_limit) );
+      const auto configured_markets = _app.get_options().api_limit_get_grouped_order_books;
+      FC_ASSERT( markets.size() <= configured_markets,
+                 "Number of markets can not be greater than ${configured_markets}",
+                 ("configured_markets", configured_markets) );
+
+      auto plugin = _app.get_plugin<graphene::grouped_orders::grouped_orders_plugin>( "grouped_orders" );
+      FC_ASSERT( plugin );
+      const auto& limit_groups = plugin->limit_order_groups();
+      const optional<price> start;
+
+      vector< grouped_order_book > result;
+      result.reserve( markets.size() );
+      for( auto& market : markets )
       {
-         result.emplace_back( *itr );
-         ++itr;
+         asset_id_type base_asset_id = database_api.get_asset_id_from_string( market.first );
+         asset_id_type quote_asset_id = database_api.get_asset_id_from_string( market.second );
+
+         grouped_order_book book;
+         book.base = std::move( market.first );
+         book.quote = std::move( market.second );
+         book.bids = get_limit_order_groups( limit_groups, quote_asset_id, base_asset_id, group, start, limit );
+         book.asks = get_limit_order_groups( limit_groups, base_asset_id, quote_asset_id, group, start, limit );
+         result.push_back( std::move( book ) );
       }
       return result;
    }
@@ -751,4 +1253,97 @@ namespace graphene { namespace app {
       return results;
    }
 
+   vector<account_storage_object> custom_operations_api::get_storage_range(std::string account_id_or_name,
+         std::string catalog, std::string key_prefix, std::string start_key, uint32_t limit)const
+   {
+      auto plugin = _app.get_plugin<graphene::custom_operations::custom_operations_plugin>("custom_operations");
+      FC_ASSERT( plugin );
+      const auto configured_limit = _app.get_options().api_limit_get_storage_range;
+      FC_ASSERT( limit <= configured_limit,
+                 "limit can not be greater than ${configured_limit}",
+                 ("configured_limit", configured_limit) );
+
+      const auto account_id = database_api.get_account_id_from_string(account_id_or_name);
+      const auto& storage_index = _app.chain_database()->get_index_type<account_storage_index>();
+      const auto& by_account_catalog_idx = storage_index.indices().get<by_account_catalog_key>();
+      auto itr = by_account_catalog_idx.lower_bound(make_tuple(account_id, catalog, std::max(key_prefix, start_key)));
+
+      vector<account_storage_object> results;
+      while( itr != by_account_catalog_idx.end() && results.size() < limit && itr->account == account_id
+             && itr->catalog == catalog && itr->key.compare(0, key_prefix.size(), key_prefix) == 0 )
+      {
+         results.push_back(*itr);
+         ++itr;
+      }
+      return results;
+   }
+
+   // content cards api
+   constexpr uint32_t content_cards_api::max_read_size;
+
+   const graphene::content_cards::content_store& content_cards_api::get_store()const
+   {
+      auto plugin = _app.get_plugin<graphene::content_cards::content_cards_plugin>("content_cards");
+      FC_ASSERT( plugin && plugin->get_content_store(),
+                 "This api is switched off because content_cards plugin does not enabled" );
+      return *plugin->get_content_store();
+   }
+
+   optional<uint64_t> content_cards_api::get_content_size( const std::string& hash )const
+   {
+      return get_store().get_size( hash );
+   }
+
+   vector<char> content_cards_api::read_content( const std::string& hash, uint64_t offset, uint32_t size )const
+   {
+      FC_ASSERT( size <= max_read_size, "size can not be greater than ${max}", ("max", max_read_size) );
+      return get_store().read( hash, offset, size );
+   }
+
+   // metrics api
+   vector<api_method_metrics> metrics_api::get_api_metrics()const
+   {
+      return _app.get_api_metrics()->get_metrics();
+   }
+
+   void metrics_api::reset_api_metrics()
+   {
+      _app.get_api_metrics()->reset();
+   }
+
+   vector<graphene::db::index_memory_stats> metrics_api::get_index_memory_stats()const
+   {
+      return _app.chain_database()->get_index_memory_stats();
+   }
+
+   graphene::chain::apply_timing_report metrics_api::get_apply_timing()const
+   {
+      return _app.chain_database()->get_apply_timing();
+   }
+
+   void metrics_api::reset_apply_timing()
+   {
+      _app.chain_database()->reset_apply_timing();
+   }
+
+   vector<graphene::chain::async_block_handler_stats> metrics_api::get_async_block_handler_stats()const
+   {
+      return _app.chain_database()->get_async_block_handler_stats();
+   }
+
+   graphene::db::task_pool_stats metrics_api::get_task_pool_stats()const
+   {
+      return graphene::db::task_pool::instance().get_stats();
+   }
+
+   void metrics_api::reset_task_pool_stats()
+   {
+      graphene::db::task_pool::instance().reset_stats();
+   }
+
+   vector<startup_phase_timing> metrics_api::get_startup_timing()const
+   {
+      return _app.get_startup_timing();
+   }
+
 } } // graphene::app
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2022 Revolution Populi Limited, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <graphene/app/api_metrics.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/uint128.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace app {
+
+const std::array<uint64_t, 6>& api_metrics::latency_bucket_bounds_us()
+{
+   static const std::array<uint64_t, 6> bounds = { { 100, 1000, 10000, 100000, 1000000, 10000000 } };
+   return bounds;
+}
+
+void api_metrics::record( const std::string& api, const std::string& method, const std::string& user,
+                          uint64_t time_us, bool failed )
+{
+   const auto& bounds = latency_bucket_bounds_us();
+   const size_t bucket = std::lower_bound( bounds.begin(), bounds.end(), time_us ) - bounds.begin();
+
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _methods.find( std::make_tuple( api, method, user ) );
+   if( itr == _methods.end() )
+   {
+      api_method_metrics m;
+      m.api = api;
+      m.method = method;
+      m.user = user;
+      m.latency_histogram.resize( bounds.size() + 1 );
+      itr = _methods.emplace( std::make_tuple( api, method, user ), std::move( m ) ).first;
+   }
+   api_method_metrics& m = itr->second;
+   ++m.calls;
+   if( failed )
+      ++m.errors;
+   m.total_time_us += time_us;
+   m.max_time_us = std::max( m.max_time_us, time_us );
+   ++m.latency_histogram[bucket];
+}
+
+std::vector<api_method_metrics> api_metrics::get_metrics()const
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   std::vector<api_method_metrics> result;
+   result.reserve( _methods.size() );
+   for( const auto& item : _methods )
+      result.push_back( item.second );
+   return result;
+}
+
+void api_metrics::reset()
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   _methods.clear();
+}
+
+api_call_budget::api_call_budget( uint64_t refill_us_per_second, uint64_t max_us )
+: _refill_us_per_second( refill_us_per_second ), _max_us( static_cast<int64_t>( max_us ) ),
+  _available_us( static_cast<int64_t>( max_us ) ), _last_refill( fc::time_point::now() )
+{
+}
+
+void api_call_budget::refill()
+{
+   const auto now = fc::time_point::now();
+   const int64_t elapsed_us = ( now - _last_refill ).count();
+   if( elapsed_us <= 0 )
+      return;
+   const int64_t refill_us = static_cast<int64_t>( fc::uint128_t( elapsed_us ) * _refill_us_per_second
+                                                   / 1000000 );
+   if( refill_us <= 0 )
+      return;
+   _available_us = std::min( _max_us, _available_us + refill_us );
+   _last_refill = now;
+}
+
+void api_call_budget::admit()
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   refill();
+   if( _available_us > 0 )
+      return;
+   const int64_t retry_ms = _refill_us_per_second == 0 ? -1
+                          : ( 1 - _available_us ) * 1000 / static_cast<int64_t>( _refill_us_per_second ) + 1;
+   FC_THROW( "API time budget of this connection is used up, retry in ${ms} ms",
+             ("ms", retry_ms)("remaining_us", _available_us) );
+}
+
+void api_call_budget::charge( uint64_t time_us )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   refill();
+   _available_us -= static_cast<int64_t>( time_us );
+}
+
+int64_t api_call_budget::remaining_us()
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   refill();
+   return _available_us;
+}
+
+} } // graphene::app
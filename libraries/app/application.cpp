@@ -40,10 +40,13 @@
 #include <graphene/utilities/key_conversion.hpp>
 #include <graphene/chain/worker_evaluator.hpp>
 
+#include <graphene/db/task_pool.hpp>
+
 #include <fc/asio.hpp>
 #include <fc/io/fstream.hpp>
 #include <fc/rpc/api_connection.hpp>
 #include <fc/rpc/websocket_api.hpp>
+#include <fc/thread/thread.hpp>
 #include <fc/crypto/base64.hpp>
 
 #include <boost/filesystem/path.hpp>
@@ -59,6 +62,11 @@
 
 #include <boost/range/adaptor/reversed.hpp>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 namespace graphene { namespace app {
 using net::item_hash_t;
 using net::item_id;
@@ -106,6 +114,62 @@ namespace detail {
       return initial_state;
    }
 
+   /// Parses a list of CPU numbers and ranges, e.g. "0-3,8"
+   vector<uint32_t> parse_cpu_list( const string& list )
+   {
+      vector<uint32_t> result;
+      vector<string> parts;
+      boost::split( parts, list, boost::is_any_of(",") );
+      for( string part : parts )
+      {
+         boost::trim( part );
+         if( part.empty() )
+            continue;
+         vector<string> range;
+         boost::split( range, part, boost::is_any_of("-") );
+         FC_ASSERT( range.size() <= 2, "Invalid CPU range ${r}", ("r",part) );
+         const uint32_t first = fc::to_uint64( range.front() );
+         const uint32_t last = fc::to_uint64( range.back() );
+         FC_ASSERT( first <= last, "Invalid CPU range ${r}", ("r",part) );
+         for( uint32_t cpu = first; cpu <= last; ++cpu )
+            result.push_back( cpu );
+      }
+      FC_ASSERT( !result.empty(), "Empty CPU list" );
+      return result;
+   }
+
+   /// @return the CPUs the calling thread may run on, empty if unknown
+   vector<uint32_t> get_thread_cpus()
+   {
+      vector<uint32_t> result;
+#ifdef __linux__
+      cpu_set_t set;
+      CPU_ZERO( &set );
+      if( pthread_getaffinity_np( pthread_self(), sizeof(set), &set ) == 0 )
+         for( uint32_t cpu = 0; cpu < CPU_SETSIZE; ++cpu )
+            if( CPU_ISSET( cpu, &set ) )
+               result.push_back( cpu );
+#endif
+      return result;
+   }
+
+   /// Restricts the calling thread to @p cpus, threads it starts afterwards inherit the restriction
+   void set_thread_cpus( const vector<uint32_t>& cpus )
+   {
+#ifdef __linux__
+      cpu_set_t set;
+      CPU_ZERO( &set );
+      for( uint32_t cpu : cpus )
+      {
+         FC_ASSERT( cpu < CPU_SETSIZE, "Invalid CPU ${c}", ("c",cpu) );
+         CPU_SET( cpu, &set );
+      }
+      const int rc = pthread_setaffinity_np( pthread_self(), sizeof(set), &set );
+      FC_ASSERT( rc == 0, "Unable to set the CPU affinity to ${c}: error ${rc}", ("c",cpus)("rc",rc) );
+#else
+      FC_THROW( "Setting the CPU affinity of threads is not supported on this platform" );
+#endif
+   }
 
 }
 
@@ -148,6 +212,15 @@ void application_impl::reset_p2p_node(const fc::path& data_dir)
       _p2p_network->add_seed_nodes(seeds);
    }
 
+   if( _options->count("p2p-priority-peer") > 0 )
+   {
+      for( const string& endpoint_string : _options->at("p2p-priority-peer").as<vector<string>>() )
+      {
+         for( const fc::ip::endpoint& endpoint : net::node::resolve_string_to_ip_endpoints( endpoint_string ) )
+            _p2p_network->add_priority_peer( endpoint );
+      }
+   }
+
    if( _options->count("p2p-endpoint") > 0 )
       _p2p_network->listen_on_endpoint(fc::ip::endpoint::from_string(_options->at("p2p-endpoint").as<string>()), true);
    else
@@ -237,6 +310,7 @@ void application_impl::reset_websocket_tls_server()
 
 void application_impl::initialize(const fc::path& data_dir, shared_ptr<boost::program_options::variables_map> options)
 {
+   const fc::time_point start = fc::time_point::now();
    _data_dir = data_dir;
    _options = options;
 
@@ -245,6 +319,26 @@ void application_impl::initialize(const fc::path& data_dir, shared_ptr<boost::pr
       const uint16_t num_threads = _options->at("io-threads").as<uint16_t>();
       fc::asio::default_io_service_scope::set_num_threads(num_threads);
    }
+   if( _options->count("chain-task-threads") > 0 )
+      graphene::db::task_pool::instance().set_thread_count( _options->at("chain-task-threads").as<uint32_t>() );
+
+   // the IO and worker threads are started while the main thread runs on their CPUs, so that they inherit them
+   if( _options->count("worker-thread-cpus") > 0 )
+   {
+      const vector<uint32_t> main_cpus = get_thread_cpus();
+      set_thread_cpus( parse_cpu_list( _options->at("worker-thread-cpus").as<string>() ) );
+      fc::asio::default_io_service();
+      fc::do_parallel( [](){} ).wait();
+      graphene::db::task_pool::instance().start();
+      if( !main_cpus.empty() )
+         set_thread_cpus( main_cpus );
+      ilog( "IO and worker threads run on CPUs ${c}", ("c",_options->at("worker-thread-cpus").as<string>()) );
+   }
+   if( _options->count("chain-thread-cpus") > 0 )
+   {
+      set_thread_cpus( parse_cpu_list( _options->at("chain-thread-cpus").as<string>() ) );
+      ilog( "The main thread runs on CPUs ${c}", ("c",_options->at("chain-thread-cpus").as<string>()) );
+   }
 
    if( _options->count("force-validate") > 0 )
    {
@@ -255,6 +349,14 @@ void application_impl::initialize(const fc::path& data_dir, shared_ptr<boost::pr
    if ( _options->count("enable-subscribe-to-all") > 0 )
       _app_options.enable_subscribe_to_all = _options->at( "enable-subscribe-to-all" ).as<bool>();
 
+   if ( _options->count("enable-api-metrics") > 0 )
+      _app_options.enable_api_metrics = _options->at( "enable-api-metrics" ).as<bool>();
+
+   if ( _options->count("api-time-budget-per-second") > 0 )
+      _app_options.api_time_budget_per_second = _options->at( "api-time-budget-per-second" ).as<uint64_t>();
+   if ( _options->count("api-time-budget-max") > 0 )
+      _app_options.api_time_budget_max = _options->at( "api-time-budget-max" ).as<uint64_t>();
+
    set_api_limit();
 
    if( is_plugin_enabled( "market_history" ) )
@@ -292,8 +394,10 @@ void application_impl::initialize(const fc::path& data_dir, shared_ptr<boost::pr
       wild_access.allowed_apis.push_back( "history_api" );
       wild_access.allowed_apis.push_back( "orders_api" );
       wild_access.allowed_apis.push_back( "custom_operations_api" );
+      wild_access.allowed_apis.push_back( "content_cards_api" );
       _apiaccess.permission_map["*"] = wild_access;
    }
+   record_startup_phase( "initialize application", start );
 
    initialize_plugins();
 }
@@ -311,6 +415,10 @@ void application_impl::set_api_limit() {
       _app_options.api_limit_get_grouped_limit_orders =
             _options->at("api-limit-get-grouped-limit-orders").as<uint64_t>();
    }
+   if(_options->count("api-limit-get-grouped-order-books") > 0){
+      _app_options.api_limit_get_grouped_order_books =
+            _options->at("api-limit-get-grouped-order-books").as<uint64_t>();
+   }
    if(_options->count("api-limit-get-relative-account-history") > 0){
       _app_options.api_limit_get_relative_account_history =
             _options->at("api-limit-get-relative-account-history").as<uint64_t>();
@@ -415,6 +523,30 @@ void application_impl::set_api_limit() {
       _app_options.api_limit_get_tickets =
             _options->at("api-limit-get-tickets").as<uint64_t>();
    }
+   if(_options->count("api-limit-get-personal-data") > 0) {
+      _app_options.api_limit_get_personal_data =
+            _options->at("api-limit-get-personal-data").as<uint64_t>();
+   }
+   if(_options->count("api-limit-get-content-cards") > 0) {
+      _app_options.api_limit_get_content_cards =
+            _options->at("api-limit-get-content-cards").as<uint64_t>();
+   }
+   if(_options->count("api-limit-get-content-vote-counts") > 0) {
+      _app_options.api_limit_get_content_vote_counts =
+            _options->at("api-limit-get-content-vote-counts").as<uint64_t>();
+   }
+   if(_options->count("api-limit-get-permissions-by-object") > 0) {
+      _app_options.api_limit_get_permissions_by_object =
+            _options->at("api-limit-get-permissions-by-object").as<uint64_t>();
+   }
+   if(_options->count("api-limit-get-permissions") > 0) {
+      _app_options.api_limit_get_permissions =
+            _options->at("api-limit-get-permissions").as<uint64_t>();
+   }
+   if(_options->count("api-limit-get-storage-range") > 0) {
+      _app_options.api_limit_get_storage_range =
+            _options->at("api-limit-get-storage-range").as<uint64_t>();
+   }
 }
 
 graphene::chain::genesis_state_type application_impl::initialize_genesis_state() const
@@ -459,6 +591,12 @@ graphene::chain::genesis_state_type application_impl::initialize_genesis_state()
       }
       else
       {
+         graphene::chain::genesis_state_type packed_genesis;
+         if( graphene::egenesis::compute_egenesis_state( packed_genesis ) )
+         {
+            FC_ASSERT( packed_genesis.initial_chain_id == graphene::egenesis::get_egenesis_chain_id() );
+            return packed_genesis;
+         }
          std::string egenesis_json;
          graphene::egenesis::compute_egenesis_json( egenesis_json );
          FC_ASSERT( egenesis_json != "" );
@@ -488,38 +626,160 @@ void application_impl::open_chain_database() const
          loaded_checkpoints[item.first] = item.second;
       }
    }
+   // the embedded checkpoints are only used on the embedded chain, and not when revalidating it
+   if( _options->count("genesis-json") == 0 && _options->count("revalidate-blockchain") == 0
+         && _options->count("embedded-checkpoints") > 0 && _options->at("embedded-checkpoints").as<bool>() )
+   {
+      flat_map<uint32_t,block_id_type> embedded_checkpoints;
+      graphene::egenesis::compute_egenesis_checkpoints( embedded_checkpoints );
+      if( !embedded_checkpoints.empty() )
+         ilog( "Using ${n} embedded checkpoints up to block ${b}",
+               ("n", embedded_checkpoints.size())("b", embedded_checkpoints.rbegin()->first) );
+      // the configured checkpoints take precedence
+      for( const auto& item : loaded_checkpoints )
+         embedded_checkpoints[item.first] = item.second;
+      loaded_checkpoints = std::move( embedded_checkpoints );
+   }
    _chain_db->add_checkpoints( loaded_checkpoints );
 
+   if( _options->count("enable-apply-timing") > 0 )
+      _chain_db->enable_apply_timing( _options->at("enable-apply-timing").as<bool>() );
+
    if( _options->count("enable-standby-votes-tracking") > 0 )
    {
       _chain_db->enable_standby_votes_tracking( _options->at("enable-standby-votes-tracking").as<bool>() );
    }
 
-   if( _options->count("replay-blockchain") > 0 || _options->count("revalidate-blockchain") > 0 )
-      _chain_db->wipe( _data_dir / "blockchain", false );
+   if( _options->count("incremental-vote-tally") > 0 )
+   {
+      const bool verify = _options->count("verify-vote-tally") > 0 && _options->at("verify-vote-tally").as<bool>();
+      _chain_db->enable_incremental_vote_tally( _options->at("incremental-vote-tally").as<bool>(), verify );
+   }
+
+   if( _options->count("parallel-maintenance") > 0 )
+      _chain_db->enable_parallel_maintenance( _options->at("parallel-maintenance").as<bool>() );
+
+   if( _options->count("compact-undo-history") > 0 )
+      _chain_db->_undo_db.set_compact( _options->at("compact-undo-history").as<bool>() );
+
+   if( _options->count("undo-compact-depth") > 0 )
+      _chain_db->_undo_db.set_compact_depth( _options->at("undo-compact-depth").as<uint32_t>() );
+
+   if( _options->count("reindex-pipeline-depth") > 0 )
+      _chain_db->set_reindex_pipeline_depth( _options->at("reindex-pipeline-depth").as<uint32_t>() );
+
+   if( _options->count("block-log-compression-frame-size") > 0 )
+      _chain_db->set_block_log_compression( _options->at("block-log-compression-frame-size").as<uint32_t>() );
 
-   try
    {
-      // these flags are used in open() only, i. e. during replay
-      uint32_t skip;
-      if( _options->count("revalidate-blockchain") > 0 ) // see also handle_block()
+      graphene::chain::transaction_pool_limits limits;
+      if( _options->count("mempool-max-transactions") > 0 )
+         limits.max_transactions = _options->at("mempool-max-transactions").as<uint32_t>();
+      if( _options->count("mempool-max-size") > 0 )
+         limits.max_bytes = uint64_t( _options->at("mempool-max-size").as<uint32_t>() ) * 1024 * 1024;
+      if( _options->count("mempool-max-transactions-per-account") > 0 )
+         limits.max_transactions_per_account = _options->at("mempool-max-transactions-per-account").as<uint32_t>();
+      if( _options->count("mempool-reapply-limit") > 0 )
+         limits.max_reapplied = _options->at("mempool-reapply-limit").as<uint32_t>();
+      if( _options->count("mempool-network-pressure") > 0 )
+         limits.network_pressure_percent = _options->at("mempool-network-pressure").as<uint32_t>();
+      if( _options->count("mempool-network-max-cost") > 0 )
+         limits.network_max_cost_us = _options->at("mempool-network-max-cost").as<uint32_t>();
+      _chain_db->set_transaction_pool_limits( limits );
+   }
+
+   if( _options->count("block-cache-size") > 0 )
+      _chain_db->set_block_cache_size( _options->at("block-cache-size").as<uint32_t>() );
+
+   if( _options->count("p2p-block-message-cache-size") > 0 )
+      _served_block_cache_size = _options->at("p2p-block-message-cache-size").as<uint32_t>();
+
+   if( _options->count("signature-cache-size") > 0 )
+      _chain_db->set_signature_cache_size( _options->at("signature-cache-size").as<uint32_t>() );
+
+   if( _options->count("confidential-proof-cache-size") > 0 )
+      _chain_db->set_confidential_proof_cache_size(
+            _options->at("confidential-proof-cache-size").as<uint32_t>() );
+
+   if( _options->count("applied-ops-log") > 0 )
+      _chain_db->enable_applied_ops_log( _options->at("applied-ops-log").as<bool>() );
+
+   if( _options->count("state-delta-log") > 0 )
+      _chain_db->enable_state_delta_log( _options->at("state-delta-log").as<bool>() );
+
+   if( _options->count("state-hash-blocks") > 0 )
+      _chain_db->set_state_hash_blocks( _options->at("state-hash-blocks").as<uint32_t>() );
+
+   if( _options->count("block-log-retain-blocks") > 0 )
+      _chain_db->set_block_log_retain_blocks( _options->at("block-log-retain-blocks").as<uint32_t>() );
+
+   if( _options->count("node-pool-pages") > 0 )
+   {
+      const string pages = _options->at("node-pool-pages").as<string>();
+      if( pages == "heap" )
+         graphene::db::set_node_pool_pages( graphene::db::node_pool_pages::heap );
+      else if( pages == "transparent" )
+         graphene::db::set_node_pool_pages( graphene::db::node_pool_pages::transparent_huge );
+      else if( pages == "explicit" )
+         graphene::db::set_node_pool_pages( graphene::db::node_pool_pages::explicit_huge );
+      else
+         FC_THROW( "Invalid node-pool-pages ${p}, expected heap, transparent or explicit", ("p",pages) );
+   }
+
+   if( _options->count("pooled-object-types") > 0 )
+   {
+      for( const string& type_str : _options->at("pooled-object-types").as<vector<string>>() )
       {
-         if( !loaded_checkpoints.empty() )
-            wlog( "Warning - revalidate will not validate before last checkpoint" );
-         if( _options->count("force-validate") > 0 )
-            skip = graphene::chain::database::skip_nothing;
+         vector<string> parts;
+         boost::split( parts, type_str, boost::is_any_of(".") );
+         FC_ASSERT( parts.size() == 2, "Invalid object type ${t}, expected space.type", ("t",type_str) );
+         const uint8_t space_id = fc::to_int64( parts[0] );
+         const uint8_t type_id = fc::to_int64( parts[1] );
+         if( _chain_db->enable_node_pool( space_id, type_id ) )
+            ilog( "Enabled pooled node allocation for object type ${t}", ("t",type_str) );
          else
-            skip = graphene::chain::database::skip_transaction_signatures;
+            wlog( "Object type ${t} does not support pooled node allocation", ("t",type_str) );
       }
-      else // no revalidate, skip most checks
-         skip = graphene::chain::database::skip_witness_signature |
-                graphene::chain::database::skip_block_size_check |
-                graphene::chain::database::skip_merkle_check |
-                graphene::chain::database::skip_transaction_signatures |
-                graphene::chain::database::skip_transaction_dupe_check |
-                graphene::chain::database::skip_tapos_check |
-                graphene::chain::database::skip_witness_schedule_check;
+   }
+
+   // these flags are used in open() only, i. e. during replay
+   uint32_t skip;
+   if( _options->count("revalidate-blockchain") > 0 ) // see also handle_block()
+   {
+      if( !loaded_checkpoints.empty() )
+         wlog( "Warning - revalidate will not validate before last checkpoint" );
+      if( _options->count("force-validate") > 0 )
+         skip = graphene::chain::database::skip_nothing;
+      else
+         skip = graphene::chain::database::skip_transaction_signatures;
+   }
+   else // no revalidate, skip most checks
+      skip = graphene::chain::database::skip_witness_signature |
+             graphene::chain::database::skip_block_size_check |
+             graphene::chain::database::skip_merkle_check |
+             graphene::chain::database::skip_transaction_signatures |
+             graphene::chain::database::skip_transaction_dupe_check |
+             graphene::chain::database::skip_tapos_check |
+             graphene::chain::database::skip_witness_schedule_check;
+
+   if( _options->count("replay-checkpoint-interval") > 0 )
+      _chain_db->set_replay_checkpoint_interval( _options->at("replay-checkpoint-interval").as<uint32_t>() );
+   if( _options->count("replay-end-block") > 0 )
+      _chain_db->set_replay_end_block( _options->at("replay-end-block").as<uint32_t>() );
+   if( _options->count("replay-checkpoint-archive") > 0 )
+      _chain_db->set_replay_checkpoint_archive(
+            _options->at("replay-checkpoint-archive").as<boost::filesystem::path>() );
 
+   if( _options->count("replay-blockchain") > 0 || _options->count("revalidate-blockchain") > 0 )
+   {
+      if( graphene::chain::database::has_replay_checkpoint( _data_dir / "blockchain", skip ) )
+         ilog( "Resuming interrupted replay from checkpoint" );
+      else
+         _chain_db->wipe( _data_dir / "blockchain", false );
+   }
+
+   try
+   {
       auto genesis_loader = [this](){
          return initialize_genesis_state();
       };
@@ -541,17 +801,72 @@ void application_impl::startup()
    if( _options->count("enable-p2p-network") > 0 )
       enable_p2p_network = _options->at("enable-p2p-network").as<bool>();
 
+   const fc::time_point start = fc::time_point::now();
+   fc::time_point phase_start = start;
    open_chain_database();
+   record_startup_phase( "open chain database", phase_start );
 
+   if( _options->count("rebuild-plugins") > 0 )
+   {
+      phase_start = fc::time_point::now();
+      rebuild_plugins();
+      record_startup_phase( "rebuild plugins", phase_start );
+   }
    startup_plugins();
+   load_plugin_states();
 
    if( enable_p2p_network && _active_plugins.find( "delayed_node" ) == _active_plugins.end() )
+   {
+      phase_start = fc::time_point::now();
       reset_p2p_node(_data_dir);
+      record_startup_phase( "start p2p node", phase_start );
+   }
 
+   phase_start = fc::time_point::now();
    reset_websocket_server();
    reset_websocket_tls_server();
+   record_startup_phase( "start websocket servers", phase_start );
+
+   if( _options->count("index-memory-stats-interval") > 0 )
+      _index_memory_stats_interval = _options->at("index-memory-stats-interval").as<uint32_t>();
+   if( _index_memory_stats_interval > 0 )
+      _index_memory_stats_task = fc::schedule( [this]{ log_index_memory_stats(); },
+                                               fc::time_point::now() + fc::seconds( _index_memory_stats_interval ),
+                                               "Index memory statistics" );
+
+   ilog( "Startup took ${t} ms", ("t",( fc::time_point::now() - start ).count() / 1000) );
 } FC_LOG_AND_RETHROW() }
 
+void application_impl::record_startup_phase( const string& phase, const fc::time_point& start )
+{
+   startup_phase_timing timing;
+   timing.phase = phase;
+   timing.duration_us = ( fc::time_point::now() - start ).count();
+   ilog( "Startup phase ${p} took ${t} ms", ("p",phase)("t",timing.duration_us / 1000) );
+   _startup_timing.push_back( std::move( timing ) );
+}
+
+void application_impl::log_index_memory_stats()
+{
+   try {
+      const auto start = fc::time_point::now();
+      const auto stats = _chain_db->get_index_memory_stats();
+      uint64_t total = 0;
+      for( const auto& s : stats )
+         total += s.estimated_bytes;
+      ilog( "Estimated memory use of object indexes: ${t} MiB, computed in ${ms} ms",
+            ("t", total >> 20)("ms", ( fc::time_point::now() - start ).count() / 1000) );
+      constexpr size_t max_logged = 10;
+      for( size_t i = 0; i < stats.size() && i < max_logged && stats[i].object_count > 0; ++i )
+         ilog( "  ${s}.${t}: ${n} objects, ${b} MiB",
+               ("s", stats[i].space_id)("t", stats[i].type_id)("n", stats[i].object_count)
+               ("b", stats[i].estimated_bytes >> 20) );
+   } FC_CAPTURE_AND_LOG( (0) )
+   _index_memory_stats_task = fc::schedule( [this]{ log_index_memory_stats(); },
+                                            fc::time_point::now() + fc::seconds( _index_memory_stats_interval ),
+                                            "Index memory statistics" );
+}
+
 optional< api_access_info > application_impl::get_api_access_info(const string& username)const
 {
    optional< api_access_info > result;
@@ -583,7 +898,14 @@ bool application_impl::has_item(const net::item_id& id)
    try
    {
       if( id.item_type == graphene::net::block_message_type )
+      {
+         // irreversible blocks which are pruned from the block log need not be fetched again
+         const uint32_t block_num = block_header::num_from_id(id.item_hash);
+         if( block_num < _chain_db->first_stored_block_num()
+               && block_num <= _chain_db->get_dynamic_global_properties().last_irreversible_block_num )
+            return true;
          return _chain_db->is_known_block(id.item_hash);
+      }
       else
          return _chain_db->is_known_transaction(id.item_hash);
    }
@@ -623,8 +945,10 @@ bool application_impl::handle_block(const graphene::net::block_message& blk_msg,
                     "Rejecting block with timestamp in the future", );
 
    try {
-      const uint32_t skip = (_is_block_producer || _force_validate) ?
-                               database::skip_nothing : database::skip_transaction_signatures;
+      // below the last checkpoint nothing but the merkle root is checked, don't precompute signatures then
+      const uint32_t skip = _chain_db->checkpoint_skip_flags( blk_msg.block.block_num(),
+                               (_is_block_producer || _force_validate) ?
+                               database::skip_nothing : database::skip_transaction_signatures );
       bool result = valve.do_serial( [this,&blk_msg,skip] () {
          _chain_db->precompute_parallel( blk_msg.block, skip ).wait();
       }, [this,&blk_msg,skip] () {
@@ -683,6 +1007,8 @@ void application_impl::handle_transaction(const graphene::net::trx_message& tran
       trx_count = 0;
    }
 
+   // refused transactions are not relayed, so that a flood does not delay block production
+   _chain_db->check_network_transaction_admission( transaction_message.trx );
    _chain_db->precompute_parallel( transaction_message.trx ).wait();
    _chain_db->push_transaction( transaction_message.trx );
 } FC_CAPTURE_AND_RETHROW( (transaction_message) ) }
@@ -745,11 +1071,21 @@ std::vector<item_hash_t> application_impl::get_block_ids(const std::vector<item_
        FC_THROW_EXCEPTION( graphene::net::peer_is_on_an_unreachable_fork,
                            "Unable to provide a list of blocks starting at any of the blocks in peer's synopsis" );
    }
+   if( block_header::num_from_id(last_known_block_id) + 1 < _chain_db->first_stored_block_num() )
+   {
+      // the block log is pruned, so we do not have the blocks the peer needs
+      dlog( "Unable to provide blocks after #${n}, the block log starts at block #${f}",
+            ("n", block_header::num_from_id(last_known_block_id))("f", _chain_db->first_stored_block_num()) );
+      return result;
+   }
+   vector<uint32_t> block_nums;
+   block_nums.reserve(limit);
    for( uint32_t num = block_header::num_from_id(last_known_block_id);
-        num <= _chain_db->head_block_num() && result.size() < limit;
+        num <= _chain_db->head_block_num() && block_nums.size() < limit;
         ++num )
       if( num > 0 )
-         result.push_back(_chain_db->get_block_id_for_num(num));
+         block_nums.push_back(num);
+   result = _chain_db->get_block_ids_for_nums(block_nums);
 
    if( !result.empty() && block_header::num_from_id(result.back()) < _chain_db->head_block_num() )
       remaining_item_count = _chain_db->head_block_num() - block_header::num_from_id(result.back());
@@ -765,17 +1101,55 @@ message application_impl::get_item(const item_id& id)
   // ilog("Request for item ${id}", ("id", id));
    if( id.item_type == graphene::net::block_message_type )
    {
-      auto opt_block = _chain_db->fetch_block_by_id(id.item_hash);
-      if( !opt_block )
+      auto cached = _served_block_messages.find( id.item_hash );
+      if( cached != _served_block_messages.end() )
+         return cached->second;
+
+      // a block_message is the serialized block followed by its ID, so the stored block is sent as it is
+      message msg;
+      const bool found = _chain_db->fetch_packed_block_by_id( id.item_hash, msg.data );
+      if( !found )
          elog("Couldn't find block ${id} -- corresponding ID in our chain is ${id2}",
               ("id", id.item_hash)("id2", _chain_db->get_block_id_for_num(block_header::num_from_id(id.item_hash))));
-      FC_ASSERT( opt_block.valid() );
-      // ilog("Serving up block #${num}", ("num", opt_block->block_num()));
-      return block_message(std::move(*opt_block));
+      FC_ASSERT( found, "Block is not available, the block log starts at block #${n}",
+                 ("n", _chain_db->first_stored_block_num()) );
+      const auto packed_id = fc::raw::pack( id.item_hash );
+      msg.data.insert( msg.data.end(), packed_id.begin(), packed_id.end() );
+      msg.msg_type = graphene::net::block_message_type;
+      msg.size = static_cast<uint32_t>( msg.data.size() );
+
+      if( _served_block_cache_size > 0 )
+      {
+         _served_block_messages.emplace( id.item_hash, msg );
+         _served_block_order.push_back( id.item_hash );
+         while( _served_block_order.size() > _served_block_cache_size )
+         {
+            _served_block_messages.erase( _served_block_order.front() );
+            _served_block_order.pop_front();
+         }
+      }
+      return msg;
    }
    return trx_message( _chain_db->get_recent_transaction( id.item_hash ) );
 } FC_CAPTURE_AND_RETHROW( (id) ) }
 
+std::vector<fc::optional<graphene::net::signed_transaction>> application_impl::get_pending_transactions(
+      const std::vector<graphene::net::transaction_id_type>& ids)
+{
+   std::vector<fc::optional<graphene::net::signed_transaction>> result;
+   result.reserve( ids.size() );
+   const auto& pool = _chain_db->get_transaction_pool();
+   for( const auto& id : ids )
+   {
+      const auto* pooled = pool.find( id );
+      if( pooled )
+         result.emplace_back( graphene::net::signed_transaction( pooled->trx ) );
+      else
+         result.emplace_back();
+   }
+   return result;
+}
+
 chain_id_type application_impl::get_chain_id() const
 {
    return _chain_db->get_chain_id();
@@ -942,18 +1316,23 @@ std::vector<item_hash_t> application_impl::get_blockchain_synopsis(const item_ha
     // true_high_block_num is the ending block number after the network code appends any item ids it
     // knows about that we don't
     uint32_t true_high_block_num = high_block_num + number_of_blocks_after_reference_point;
+    // for each block in the synopsis, figure out where to pull the block id from.
+    // if it's <= non_fork_high_block_num, we grab it from the main blockchain;
+    // if it's not, we pull it from the fork history.
+    // The ids from the main blockchain are looked up together, they precede the ones from the fork.
+    std::vector<uint32_t> non_fork_block_nums;
+    non_fork_block_nums.reserve(30);
     do
     {
-      // for each block in the synopsis, figure out where to pull the block id from.
-      // if it's <= non_fork_high_block_num, we grab it from the main blockchain;
-      // if it's not, we pull it from the fork history
       if (low_block_num <= non_fork_high_block_num)
-        synopsis.push_back(_chain_db->get_block_id_for_num(low_block_num));
+        non_fork_block_nums.push_back(low_block_num);
       else
         synopsis.push_back(fork_history[low_block_num - non_fork_high_block_num - 1]);
       low_block_num += (true_high_block_num - low_block_num + 2) / 2;
     }
     while (low_block_num <= high_block_num);
+    std::vector<block_id_type> non_fork_ids = _chain_db->get_block_ids_for_nums(non_fork_block_nums);
+    synopsis.insert(synopsis.begin(), non_fork_ids.begin(), non_fork_ids.end());
 
     //idump((synopsis));
     return synopsis;
@@ -1019,6 +1398,14 @@ uint8_t application_impl::get_current_block_interval_in_seconds() const
 void application_impl::shutdown()
 {
    ilog( "Shutting down application" );
+   try {
+      if( _index_memory_stats_task.valid() )
+         _index_memory_stats_task.cancel_and_wait( __FUNCTION__ );
+   } catch( const fc::canceled_exception& ) {
+      // expected
+   } catch( const fc::exception& e ) {
+      edump( (e.to_detail_string()) );
+   }
    if( _websocket_tls_server )
       _websocket_tls_server.reset();
    if( _websocket_server )
@@ -1056,26 +1443,73 @@ void application_impl::enable_plugin( const string& name )
    _chain_db->node_properties().active_plugins.insert(name);
 }
 
-void application_impl::initialize_plugins() const
+void application_impl::initialize_plugins()
 {
    for( const auto& entry : _active_plugins )
    {
+      const fc::time_point start = fc::time_point::now();
       ilog( "Initializing plugin ${name}", ( "name", entry.second->plugin_name() ) );
       entry.second->plugin_initialize( *_options );
-      ilog( "Initialized plugin ${name}", ( "name", entry.second->plugin_name() ) );
+      record_startup_phase( "initialize plugin " + entry.second->plugin_name(), start );
    }
 }
 
-void application_impl::startup_plugins() const
+void application_impl::rebuild_plugins() const
+{
+   if( _options->count("rebuild-plugins") == 0 )
+      return;
+   const auto& log = _chain_db->get_applied_ops_log();
+   FC_ASSERT( log.is_open(), "The plugins can only be rebuilt with the applied operations log enabled" );
+   for( const string& name : _options->at("rebuild-plugins").as<vector<string>>() )
+   {
+      auto itr = _active_plugins.find( name );
+      FC_ASSERT( itr != _active_plugins.end(), "Plugin ${p} to rebuild is not enabled", ("p", name) );
+      ilog( "Rebuilding plugin ${name} from the applied operations log up to block ${b}",
+            ("name", name)("b", log.last_block_num()) );
+      if( itr->second->plugin_rebuild( log ) )
+         ilog( "Rebuilt plugin ${name}", ("name", name) );
+      else
+         wlog( "Plugin ${name} could not be rebuilt from the applied operations log", ("name", name) );
+   }
+}
+
+void application_impl::startup_plugins()
 {
    for( const auto& entry : _active_plugins )
    {
+      const fc::time_point start = fc::time_point::now();
       ilog( "Starting plugin ${name}", ( "name", entry.second->plugin_name() ) );
       entry.second->plugin_startup();
-      ilog( "Started plugin ${name}", ( "name", entry.second->plugin_name() ) );
+      record_startup_phase( "start plugin " + entry.second->plugin_name(), start );
    }
 }
 
+void application_impl::load_plugin_states()
+{
+   const fc::time_point start = fc::time_point::now();
+   vector<std::shared_ptr<abstract_plugin>> plugins;
+   plugins.reserve( _active_plugins.size() );
+   for( const auto& entry : _active_plugins )
+      plugins.push_back( entry.second );
+
+   vector<uint64_t> durations_us( plugins.size(), 0 );
+   graphene::db::task_pool::instance().run_and_wait( plugins.size(), [&plugins,&durations_us] ( size_t i ) {
+      const fc::time_point plugin_start = fc::time_point::now();
+      plugins[i]->plugin_load_state();
+      durations_us[i] = ( fc::time_point::now() - plugin_start ).count();
+   }, graphene::db::task_priority::high );
+
+   for( size_t i = 0; i < plugins.size(); ++i )
+   {
+      startup_phase_timing timing;
+      timing.phase = "load plugin state " + plugins[i]->plugin_name();
+      timing.duration_us = durations_us[i];
+      ilog( "Startup phase ${p} took ${t} ms", ("p",timing.phase)("t",timing.duration_us / 1000) );
+      _startup_timing.push_back( std::move( timing ) );
+   }
+   record_startup_phase( "load plugin states", start );
+}
+
 void application_impl::shutdown_plugins() const
 {
    for( const auto& entry : _active_plugins )
@@ -1125,8 +1559,14 @@ void application::set_program_options(boost::program_options::options_descriptio
           "P2P nodes to connect to on startup (may specify multiple times)")
          ("seed-nodes", bpo::value<string>()->composing(),
           "JSON array of P2P nodes to connect to on startup")
+         ("p2p-priority-peer", bpo::value<vector<string>>()->composing(),
+          "Trusted P2P nodes, e.g. other witnesses, to stay connected to and push new blocks and transactions to "
+          "without announcing them first. The peers must list this node too (may specify multiple times)")
          ("checkpoint,c", bpo::value<vector<string>>()->composing(),
           "Pairs of [BLOCK_NUM,BLOCK_ID] that should be enforced as checkpoints.")
+         ("embedded-checkpoints", bpo::value<bool>()->default_value(true),
+          "Whether to enforce the checkpoints compiled into the binary, which lets a new node sync the blocks "
+          "up to the last of them without verifying signatures and authorities")
          ("rpc-endpoint", bpo::value<string>()->implicit_value("127.0.0.1:8090"),
           "Endpoint for websocket RPC to listen on")
          ("rpc-tls-endpoint", bpo::value<string>()->implicit_value("127.0.0.1:8089"),
@@ -1145,9 +1585,111 @@ void application::set_program_options(boost::program_options::options_descriptio
           "Number of IO threads, default to 0 for auto-configuration")
          ("enable-subscribe-to-all", bpo::value<bool>()->implicit_value(true),
           "Whether allow API clients to subscribe to universal object creation and removal events")
+         ("enable-api-metrics", bpo::value<bool>()->implicit_value(true),
+          "Whether to collect call counts and latencies of API methods, served by the metrics API")
+         ("index-memory-stats-interval", bpo::value<uint32_t>()->default_value(0),
+          "Interval in seconds to log the estimated memory use of the largest object indexes, 0 to disable. "
+          "Each time all objects are walked, which blocks the node for a while on a large database")
+         ("api-time-budget-per-second", bpo::value<uint64_t>()->default_value(0),
+          "API execution time in milliseconds granted to each connection per second, 0 for no limit. "
+          "Calls are rejected while a connection has used up its time")
+         ("api-time-budget-max", bpo::value<uint64_t>()->default_value(5000),
+          "Maximum API execution time in milliseconds a connection can accumulate while idle")
+         ("enable-apply-timing", bpo::value<bool>()->implicit_value(true),
+          "Whether to time the application of each operation type, of transactions and of the applied_block "
+          "handlers of plugins, served by the metrics API and logged during replay")
          ("enable-standby-votes-tracking", bpo::value<bool>()->implicit_value(true),
           "Whether to enable tracking of votes of standby witnesses and committee members. "
           "Set it to true to provide accurate data to API clients, set to false for slightly better performance.")
+         ("incremental-vote-tally", bpo::value<bool>()->implicit_value(true),
+          "Whether to only tally the votes of accounts which changed since the last maintenance, "
+          "which makes maintenance faster on chains with many voting accounts")
+         ("verify-vote-tally", bpo::value<bool>()->implicit_value(true),
+          "For debugging, tally the votes of all accounts even with incremental-vote-tally, "
+          "log differences and use the full result")
+         ("parallel-maintenance", bpo::value<bool>()->implicit_value(true),
+          "Whether to tally the votes of accounts on multiple threads at chain maintenance, "
+          "not used together with incremental-vote-tally")
+         ("compact-undo-history", bpo::value<bool>()->implicit_value(true),
+          "Whether to keep pre-modification values in the undo history in serialized form. "
+          "Set it to true to reduce memory usage and copying for large objects, "
+          "at the cost of slower undo of blocks and pending transactions.")
+         ("undo-compact-depth", bpo::value<uint32_t>()->default_value(0),
+          "Undo states deeper than this number of sessions (roughly blocks) are kept in serialized form "
+          "to bound memory usage when the last irreversible block lags behind, 0 to disable")
+         ("replay-checkpoint-interval", bpo::value<uint32_t>()->default_value(0),
+          "Save the object database every this number of blocks while replaying the blockchain, "
+          "so that an interrupted replay continues from the last checkpoint, 0 to disable")
+         ("replay-end-block", bpo::value<uint32_t>(),
+          "Stop replaying the blockchain after this block and keep a replay checkpoint there, "
+          "the node exits after opening the chain database. Used to revalidate a range of blocks")
+         ("replay-checkpoint-archive", bpo::value<boost::filesystem::path>(),
+          "Directory to keep a copy of every replay checkpoint in, with the state hashes of the chain objects. "
+          "A checkpoint which is already in the archive is compared with the replayed state instead. "
+          "Revalidating ranges of blocks from archived checkpoints on several machines verifies the chain "
+          "in parallel")
+         ("reindex-pipeline-depth", bpo::value<uint32_t>()->default_value(20),
+          "Maximum number of blocks being read, deserialized and precomputed ahead of the block being applied "
+          "while replaying the blockchain")
+         ("block-log-compression-frame-size", bpo::value<uint32_t>()->default_value(0),
+          "Compress a newly created block log in frames of this number of blocks, 0 to store blocks uncompressed. "
+          "An existing block log keeps its format")
+         ("mempool-max-transactions", bpo::value<uint32_t>()->default_value(0),
+          "Maximum number of pending transactions, transactions with the lowest fee per byte are evicted first, "
+          "0 for no limit")
+         ("mempool-max-size", bpo::value<uint32_t>()->default_value(0),
+          "Maximum total size of pending transactions in MiB, 0 for no limit")
+         ("mempool-max-transactions-per-account", bpo::value<uint32_t>()->default_value(0),
+          "Maximum number of pending transactions whose first operation is paid by the same account, 0 for no limit")
+         ("mempool-reapply-limit", bpo::value<uint32_t>()->default_value(0),
+          "Maximum number of pending transactions applied again after each block, the others wait in the pool "
+          "until a block is produced, 0 for no limit")
+         ("mempool-network-pressure", bpo::value<uint32_t>()->default_value(0),
+          "Fill level of the mempool in percent of its limits from which transactions received from the network "
+          "are only accepted if they pay more per byte than the lowest paying pending transaction, transactions "
+          "of local API clients are not affected, 0 to disable")
+         ("mempool-network-max-cost", bpo::value<uint32_t>()->default_value(0),
+          "Under mempool pressure, refuse transactions from the network whose estimated application time in "
+          "microseconds exceeds this, 0 for no limit")
+         ("block-cache-size", bpo::value<uint32_t>()->default_value(0),
+          "Number of recently fetched blocks kept decoded in memory to speed up serving them to API clients "
+          "and peers, 0 to disable the cache")
+         ("p2p-block-message-cache-size", bpo::value<uint32_t>()->default_value(200),
+          "Number of block messages recently sent to peers kept in memory, so that blocks requested by many "
+          "syncing peers are read from the block log only once, 0 to disable the cache")
+         ("signature-cache-size", bpo::value<uint32_t>()->default_value(20000),
+          "Number of public keys recovered from transaction signatures kept in memory, so that transactions "
+          "seen before do not need to be verified again when they arrive in a block, 0 to disable the cache")
+         ("confidential-proof-cache-size", bpo::value<uint32_t>()->default_value(1000),
+          "Number of validated transactions with blinded transfers remembered, so that their range proofs "
+          "are not verified again when they arrive in a block, 0 to disable the cache")
+         ("applied-ops-log", bpo::value<bool>()->default_value(false),
+          "Whether to write the operations applied with the irreversible blocks, including virtual operations "
+          "and operation results, to a log from which plugins can be rebuilt with rebuild-plugins")
+         ("state-delta-log", bpo::value<bool>()->default_value(false),
+          "Whether to write the changes of the chain objects made by the irreversible blocks to a log, which "
+          "read replicas follow through the API instead of validating the blocks, see the delayed_node plugin. "
+          "Changes made by plugins when a block is applied, e.g. account statistics updated by account_history, "
+          "are not included, and the log starts over after a replay or an unclean restart")
+         ("state-hash-blocks", bpo::value<uint32_t>()->default_value(0),
+          "Number of recent blocks for which a hash of the chain state after the block is kept, to compare the "
+          "state of nodes through the API, 0 to disable. Updating the hash slows down block application a bit")
+         ("block-log-retain-blocks", bpo::value<uint32_t>()->default_value(0),
+          "Only keep this number of most recent blocks in the block log, 0 to keep all blocks. "
+          "A node with a pruned block log can not replay the blockchain nor serve older blocks to peers")
+         ("pooled-object-types", bpo::value<vector<string>>()->composing(),
+          "Object types, given as space.type (e.g. 2.9), whose index nodes are allocated from a slab pool "
+          "to reduce heap fragmentation (may specify multiple times)")
+         ("node-pool-pages", bpo::value<string>()->default_value("heap"),
+          "Memory the slab pools of pooled-object-types are allocated from: heap, transparent (transparent huge "
+          "pages) or explicit (reserved huge pages, falling back to transparent ones), huge pages need Linux")
+         ("chain-task-threads", bpo::value<uint32_t>()->default_value(0),
+          "Number of threads which precompute blocks and transactions, reindex and save the object database, "
+          "default to 0 for the number of IO threads")
+         ("chain-thread-cpus", bpo::value<string>(),
+          "CPUs the main thread, which applies blocks, runs on, e.g. 0-3,8 (Linux only)")
+         ("worker-thread-cpus", bpo::value<string>(),
+          "CPUs the IO threads and the parallel worker threads run on, e.g. 4-7 (Linux only)")
          ("api-limit-get-account-history-operations",
           bpo::value<uint64_t>()->default_value(default_opts.api_limit_get_account_history_operations),
           "For history_api::get_account_history_operations to set max limit value")
@@ -1157,6 +1699,9 @@ void application::set_program_options(boost::program_options::options_descriptio
          ("api-limit-get-grouped-limit-orders",
           bpo::value<uint64_t>()->default_value(default_opts.api_limit_get_grouped_limit_orders),
           "For orders_api::get_grouped_limit_orders to set max limit value")
+         ("api-limit-get-grouped-order-books",
+          bpo::value<uint64_t>()->default_value(default_opts.api_limit_get_grouped_order_books),
+          "For orders_api::get_grouped_order_books to set max number of markets")
          ("api-limit-get-relative-account-history",
           bpo::value<uint64_t>()->default_value(default_opts.api_limit_get_relative_account_history),
           "For history_api::get_relative_account_history to set max limit value")
@@ -1235,6 +1780,24 @@ void application::set_program_options(boost::program_options::options_descriptio
          ("api-limit-get-tickets",
           bpo::value<uint64_t>()->default_value(default_opts.api_limit_get_tickets),
           "Set maximum limit value for database APIs which query for tickets")
+         ("api-limit-get-personal-data",
+          bpo::value<uint64_t>()->default_value(default_opts.api_limit_get_personal_data),
+          "Set maximum limit value for database APIs which query for personal data")
+         ("api-limit-get-content-cards",
+          bpo::value<uint64_t>()->default_value(default_opts.api_limit_get_content_cards),
+          "Set maximum limit value for database APIs which query for content cards by type or time")
+         ("api-limit-get-content-vote-counts",
+          bpo::value<uint64_t>()->default_value(default_opts.api_limit_get_content_vote_counts),
+          "For database_api_impl::get_content_vote_counts to set max limit value")
+         ("api-limit-get-permissions-by-object",
+          bpo::value<uint64_t>()->default_value(default_opts.api_limit_get_permissions_by_object),
+          "For database_api_impl::get_permissions_by_object to set max limit value")
+         ("api-limit-get-permissions",
+          bpo::value<uint64_t>()->default_value(default_opts.api_limit_get_permissions),
+          "For database_api_impl::get_permissions_by_accounts to set max limit value")
+         ("api-limit-get-storage-range",
+          bpo::value<uint64_t>()->default_value(default_opts.api_limit_get_storage_range),
+          "For custom_operations_api::get_storage_range to set max limit value")
          ;
    command_line_options.add(configuration_file_options);
    command_line_options.add_options()
@@ -1242,6 +1805,9 @@ void application::set_program_options(boost::program_options::options_descriptio
          ("revalidate-blockchain", "Rebuild object graph by replaying all blocks with full validation")
          ("resync-blockchain", "Delete all blocks and re-sync with network from scratch")
          ("force-validate", "Force validation of all transactions during normal operation")
+         ("rebuild-plugins", bpo::value<vector<string>>()->composing(),
+          "Rebuild the data of these plugins from the applied operations log instead of replaying all blocks, "
+          "only supported by some plugins (may specify multiple times)")
          ("genesis-timestamp", bpo::value<uint32_t>(),
           "Replace timestamp from genesis.json with current time plus this many seconds (experts only!)")
          ;
@@ -1339,5 +1905,20 @@ const application_options& application::get_options()
    return my->_app_options;
 }
 
+std::shared_ptr<api_metrics> application::get_api_metrics()const
+{
+   return my->_api_metrics;
+}
+
+const vector<startup_phase_timing>& application::get_startup_timing()const
+{
+   return my->_startup_timing;
+}
+
+const fc::path& application::data_dir()const
+{
+   return my->_data_dir;
+}
+
 // namespace detail
 } }
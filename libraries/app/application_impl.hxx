@@ -9,6 +9,9 @@
 #include <graphene/protocol/types.hpp>
 #include <graphene/net/message.hpp>
 
+#include <deque>
+#include <map>
+
 namespace graphene { namespace app { namespace detail {
 
 
@@ -90,6 +93,9 @@ class application_impl : public net::node_delegate, public std::enable_shared_fr
        */
       graphene::net::message get_item(const graphene::net::item_id& id) override;
 
+      std::vector<fc::optional<graphene::net::signed_transaction>> get_pending_transactions(
+            const std::vector<graphene::net::transaction_id_type>& ids) override;
+
       graphene::chain::chain_id_type get_chain_id()const override;
 
       /**
@@ -197,14 +203,22 @@ class application_impl : public net::node_delegate, public std::enable_shared_fr
    private:
       void shutdown();
 
-      void initialize_plugins() const;
-      void startup_plugins() const;
+      void initialize_plugins();
+      /// Rebuild the plugins listed in the rebuild-plugins option from the applied operations log
+      void rebuild_plugins() const;
+      void startup_plugins();
+      /// Run plugin_load_state() of all plugins concurrently on the chain task pool
+      void load_plugin_states();
+      /// Record and log the time since @p start as the duration of @p phase
+      void record_startup_phase( const string& phase, const fc::time_point& start );
       void shutdown_plugins() const;
 
       /// Initialize genesis state. Called by open_chain_database().
       graphene::chain::genesis_state_type initialize_genesis_state() const;
       /// Open the chain database. Called by @ref startup.
       void open_chain_database() const;
+      /// Log the memory use of the largest indexes, then schedule the next time
+      void log_index_memory_stats();
 
       friend class graphene::app::application;
 
@@ -213,6 +227,8 @@ class application_impl : public net::node_delegate, public std::enable_shared_fr
       fc::path _data_dir;
       std::shared_ptr<boost::program_options::variables_map> _options;
       api_access _apiaccess;
+      std::shared_ptr<api_metrics> _api_metrics = std::make_shared<api_metrics>();
+      vector<startup_phase_timing> _startup_timing;
 
       std::shared_ptr<graphene::chain::database>            _chain_db;
       std::shared_ptr<graphene::net::node>                  _p2p_network;
@@ -224,6 +240,15 @@ class application_impl : public net::node_delegate, public std::enable_shared_fr
 
       bool _is_finished_syncing = false;
 
+      /// Serialized block messages recently sent to peers, so that blocks fetched by many syncing peers are only
+      /// read once. Only accessed by node delegate calls, which run on this thread.
+      std::map<graphene::chain::block_id_type, graphene::net::message> _served_block_messages;
+      std::deque<graphene::chain::block_id_type>                     _served_block_order;
+      uint32_t                                                        _served_block_cache_size = 0;
+
+      uint32_t         _index_memory_stats_interval = 0; ///< in seconds, 0 to disable
+      fc::future<void> _index_memory_stats_task;
+
       fc::serial_valve valve;
    };
 
@@ -24,6 +24,7 @@
  */
 
 #include "database_api_impl.hxx"
+#include "shared_per_database.hxx"
 
 #include <graphene/app/util.hpp>
 #include <graphene/chain/get_config.hpp>
@@ -34,9 +35,12 @@
 #include <fc/crypto/hex.hpp>
 #include <fc/rpc/api_connection.hpp>
 
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/range/iterator_range.hpp>
 
 #include <cctype>
+#include <mutex>
 
 template class fc::api<graphene::app::database_api>;
 
@@ -57,19 +61,10 @@ database_api_impl::database_api_impl( graphene::chain::database& db, const appli
 :_db(db), _app_options(app_options)
 {
    dlog("creating database api ${x}", ("x",int64_t(this)) );
-   _new_connection = _db.new_objects.connect([this](const vector<object_id_type>& ids,
-                                                    const flat_set<account_id_type>& impacted_accounts) {
-                                on_objects_new(ids, impacted_accounts);
-                                });
-   _change_connection = _db.changed_objects.connect([this](const vector<object_id_type>& ids,
-                                                           const flat_set<account_id_type>& impacted_accounts) {
-                                on_objects_changed(ids, impacted_accounts);
-                                });
-   _removed_connection = _db.removed_objects.connect([this](const vector<object_id_type>& ids,
-                                                            const vector<const object*>& objs,
-                                                            const flat_set<account_id_type>& impacted_accounts) {
-                                on_objects_removed(ids, objs, impacted_accounts);
-                                });
+   _dispatcher = subscription_dispatcher::get( _db );
+   _market_cache = market_result_cache::get( _db );
+   _fee_cache = fee_result_cache::get( _db );
+   _dispatcher->add_session( this );
    _applied_block_connection = _db.applied_block.connect([this](const signed_block&){ on_applied_block(); });
 
    _pending_trx_connection = _db.on_pending_transaction.connect([this](const signed_transaction& trx ){
@@ -85,11 +80,94 @@ database_api_impl::database_api_impl( graphene::chain::database& db, const appli
    {
       amount_in_collateral_index = nullptr;
    }
+   try
+   {
+      account_name_lookup_index = &_db.get_index_type< primary_index< account_index > >()
+                                   .get_secondary_index<graphene::api_helper_indexes::account_name_lookup_index>();
+   }
+   catch( fc::assert_exception& e )
+   {
+      account_name_lookup_index = nullptr;
+   }
+   try
+   {
+      asset_symbol_lookup_index = &_db.get_index_type< primary_index< asset_index > >()
+                                   .get_secondary_index<graphene::api_helper_indexes::asset_symbol_lookup_index>();
+   }
+   catch( fc::assert_exception& e )
+   {
+      asset_symbol_lookup_index = nullptr;
+   }
+   try
+   {
+      personal_data_merkle_index = &_db.get_index_type< primary_index< personal_data_v2_index > >()
+                                    .get_secondary_index<graphene::api_helper_indexes::personal_data_merkle_index>();
+   }
+   catch( fc::assert_exception& e )
+   {
+      personal_data_merkle_index = nullptr;
+   }
+   try
+   {
+      order_book_level_index = &_db.get_index_type< primary_index< limit_order_index > >()
+                                .get_secondary_index<graphene::api_helper_indexes::order_book_level_index>();
+   }
+   catch( fc::assert_exception& e )
+   {
+      order_book_level_index = nullptr;
+   }
+   try
+   {
+      content_card_feed_index = &_db.get_index_type< primary_index< content_card_v2_index > >()
+                                 .get_secondary_index<graphene::content_cards::content_card_feed_index>();
+   }
+   catch( fc::assert_exception& e )
+   {
+      content_card_feed_index = nullptr;
+   }
+   try
+   {
+      content_card_search_index = &_db.get_index_type< primary_index< content_card_v2_index > >()
+                                   .get_secondary_index<graphene::content_cards::content_card_search_index>();
+   }
+   catch( fc::assert_exception& e )
+   {
+      content_card_search_index = nullptr;
+   }
+   try
+   {
+      content_vote_count_index = &_db.get_index_type< primary_index< content_vote_index > >()
+                                  .get_secondary_index<graphene::content_cards::content_vote_count_index>();
+   }
+   catch( fc::assert_exception& e )
+   {
+      content_vote_count_index = nullptr;
+   }
+   try
+   {
+      permission_lookup_index = &_db.get_index_type< primary_index< permission_index > >()
+                                 .get_secondary_index<graphene::content_cards::permission_lookup_index>();
+   }
+   catch( fc::assert_exception& e )
+   {
+      permission_lookup_index = nullptr;
+   }
+   try
+   {
+      content_card_version_index = &_db.get_index_type< graphene::content_cards::content_card_version_index >();
+   }
+   catch( fc::assert_exception& e )
+   {
+      content_card_version_index = nullptr;
+   }
 }
 
 database_api_impl::~database_api_impl()
 {
    dlog("freeing database api ${x}", ("x",int64_t(this)) );
+   _dispatcher->unsubscribe_all( this, _subscribed_objects, _subscribed_accounts );
+   _dispatcher->unsubscribe_from_content_events( this, _content_event_filter );
+   _dispatcher->remove_session( this );
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -130,6 +208,336 @@ fc::variants database_api_impl::get_objects( const vector<object_id_type>& ids,
 //                                                                  //
 //////////////////////////////////////////////////////////////////////
 
+subscription_dispatcher::subscription_dispatcher( graphene::chain::database& db )
+: _db( db ),
+  _base_version( fc::time_point::now().time_since_epoch().count() ),
+  _last_version( _base_version ),
+  _last_block_id( db.head_block_id() )
+{
+   _applied_block_connection = _db.applied_block.connect([this](const signed_block& b) {
+      if( b.previous != _last_block_id )
+      {
+         // objects were reverted without notification
+         _account_versions.clear();
+         _base_version = ++_last_version;
+      }
+      _last_block_id = b.id();
+      dispatch_content_events();
+   });
+   _new_connection = _db.new_objects.connect([this](const vector<object_id_type>& ids,
+                                                    const impacted_accounts_provider& impacted_accounts) {
+      dispatch( true, true, ids, impacted_accounts.get(),
+                std::bind(&object_database::find_object, &_db, std::placeholders::_1) );
+   });
+   _change_connection = _db.changed_objects.connect([this](const vector<object_id_type>& ids,
+                                                           const impacted_accounts_provider& impacted_accounts) {
+      dispatch( false, true, ids, impacted_accounts.get(),
+                std::bind(&object_database::find_object, &_db, std::placeholders::_1) );
+   });
+   _removed_connection = _db.removed_objects.connect([this](const vector<object_id_type>& ids,
+                                                            const vector<const object*>& objs,
+                                                            const impacted_accounts_provider& impacted_accounts) {
+      dispatch( true, false, ids, impacted_accounts.get(),
+         [&objs](object_id_type id) -> const object* {
+            auto it = std::find_if(
+                  objs.begin(), objs.end(),
+                  [id](const object* o) {return o != nullptr && o->id == id;});
+
+            if (it != objs.end())
+               return *it;
+
+            return nullptr;
+         }
+      );
+   });
+}
+
+std::shared_ptr<subscription_dispatcher> subscription_dispatcher::get( graphene::chain::database& db )
+{
+   return get_shared_per_database<subscription_dispatcher>( db );
+}
+
+market_result_cache::market_result_cache( graphene::chain::database& db )
+: _db( db )
+{
+   // pending transactions can add and remove orders
+   _pending_trx_connection = _db.on_pending_transaction.connect( [this]( const signed_transaction& ) {
+      clear();
+   });
+}
+
+std::shared_ptr<market_result_cache> market_result_cache::get( graphene::chain::database& db )
+{
+   return get_shared_per_database<market_result_cache>( db );
+}
+
+void market_result_cache::check_head_block()
+{
+   const block_id_type head = _db.head_block_id();
+   if( head == _head_block_id )
+      return;
+   clear();
+   _head_block_id = head;
+}
+
+void market_result_cache::clear()
+{
+   _tickers.clear();
+   _order_books.clear();
+   _top_markets.clear();
+}
+
+fee_result_cache::fee_result_cache( graphene::chain::database& db )
+: _db( db )
+{
+   // pending transactions can change the fee schedule and exchange rates
+   _pending_trx_connection = _db.on_pending_transaction.connect( [this]( const signed_transaction& ) {
+      _fees.clear();
+   });
+}
+
+std::shared_ptr<fee_result_cache> fee_result_cache::get( graphene::chain::database& db )
+{
+   return get_shared_per_database<fee_result_cache>( db );
+}
+
+void subscription_dispatcher::add_session( database_api_impl* session )
+{
+   _sessions.insert( session );
+}
+
+void subscription_dispatcher::remove_session( database_api_impl* session )
+{
+   _sessions.erase( session );
+}
+
+void subscription_dispatcher::subscribe_to_object( database_api_impl* session, const object_id_type& id )
+{
+   _by_object[id.number].insert( session );
+}
+
+void subscription_dispatcher::subscribe_to_account( database_api_impl* session, const account_id_type& account )
+{
+   _by_account[account].insert( session );
+}
+
+void subscription_dispatcher::unsubscribe_all( database_api_impl* session,
+                                               const std::unordered_set<uint64_t>& objects,
+                                               const std::set<account_id_type>& accounts )
+{
+   for( uint64_t number : objects )
+   {
+      auto itr = _by_object.find( number );
+      if( itr == _by_object.end() )
+         continue;
+      itr->second.erase( session );
+      if( itr->second.empty() )
+         _by_object.erase( itr );
+   }
+   for( const account_id_type& account : accounts )
+   {
+      auto itr = _by_account.find( account );
+      if( itr == _by_account.end() )
+         continue;
+      itr->second.erase( session );
+      if( itr->second.empty() )
+         _by_account.erase( itr );
+   }
+}
+
+void subscription_dispatcher::subscribe_to_content_events( database_api_impl* session,
+                                                           const content_event_filter& filter )
+{
+   if( filter.types.empty() && filter.subjects.empty() && filter.operators.empty() )
+      _content_all.insert( session );
+   for( const string& type : filter.types )
+      _content_by_type[type].insert( session );
+   for( const account_id_type& account : filter.subjects )
+      _content_by_subject[account].insert( session );
+   for( const account_id_type& account : filter.operators )
+      _content_by_operator[account].insert( session );
+}
+
+void subscription_dispatcher::unsubscribe_from_content_events( database_api_impl* session,
+                                                               const content_event_filter& filter )
+{
+   auto erase_from = [session]( auto& index, const auto& keys ) {
+      for( const auto& key : keys )
+      {
+         auto itr = index.find( key );
+         if( itr == index.end() )
+            continue;
+         itr->second.erase( session );
+         if( itr->second.empty() )
+            index.erase( itr );
+      }
+   };
+   _content_all.erase( session );
+   erase_from( _content_by_type, filter.types );
+   erase_from( _content_by_subject, filter.subjects );
+   erase_from( _content_by_operator, filter.operators );
+}
+
+uint64_t subscription_dispatcher::get_account_version( const account_id_type& account )const
+{
+   auto itr = _account_versions.find( account.instance.value );
+   return itr == _account_versions.end() ? _base_version : itr->second;
+}
+
+void subscription_dispatcher::dispatch( bool notify_remove_create,
+                                        bool full_object,
+                                        const vector<object_id_type>& ids,
+                                        const flat_set<account_id_type>& impacted_accounts,
+                                        const std::function<const object*(object_id_type id)>& find_object )
+{
+   if( !impacted_accounts.empty() )
+   {
+      ++_last_version;
+      for( const account_id_type& account : impacted_accounts )
+         _account_versions[account.instance.value] = _last_version;
+   }
+
+   // Sessions which receive all of the objects, in order of the ids
+   flat_set<database_api_impl*> all_objects;
+   for( const account_id_type& account : impacted_accounts )
+   {
+      auto itr = _by_account.find( account );
+      if( itr != _by_account.end() )
+         all_objects.insert( itr->second.begin(), itr->second.end() );
+   }
+   if( notify_remove_create )
+   {
+      for( database_api_impl* session : _sessions )
+      {
+         if( session->_notify_remove_create )
+            all_objects.insert( session );
+      }
+   }
+
+   std::map<database_api_impl*, vector<object_id_type>> matched;
+   if( !_by_object.empty() )
+   {
+      for( const object_id_type& id : ids )
+      {
+         auto itr = _by_object.find( id.number );
+         if( itr == _by_object.end() )
+            continue;
+         for( database_api_impl* session : itr->second )
+         {
+            if( all_objects.find( session ) == all_objects.end() )
+               matched[session].push_back( id );
+         }
+      }
+   }
+
+   // An object is serialized once, then shared by all sessions it is sent to
+   std::unordered_map<uint64_t, variant> serialized;
+   auto collect_updates = [&]( const vector<object_id_type>& session_ids ) {
+      vector<variant> updates;
+      updates.reserve( session_ids.size() );
+      for( const object_id_type& id : session_ids )
+      {
+         auto itr = serialized.find( id.number );
+         if( itr == serialized.end() )
+         {
+            variant update;
+            if( !full_object )
+               update = fc::variant( id, 1 );
+            else if( const object* obj = find_object( id ) )
+               update = obj->to_variant();
+            itr = serialized.emplace( id.number, std::move( update ) ).first;
+         }
+         if( !itr->second.is_null() )
+            updates.push_back( itr->second );
+      }
+      return updates;
+   };
+
+   if( !all_objects.empty() )
+   {
+      const vector<variant> updates = collect_updates( ids );
+      for( database_api_impl* session : all_objects )
+         session->notify_objects_changed( updates );
+   }
+   for( const auto& item : matched )
+      item.first->notify_objects_changed( collect_updates( item.second ) );
+
+   for( database_api_impl* session : _sessions )
+      session->notify_market_changes( full_object, ids, find_object );
+}
+
+void subscription_dispatcher::dispatch_content_events()
+{
+   if( _content_all.empty() && _content_by_type.empty() && _content_by_subject.empty()
+         && _content_by_operator.empty() )
+      return;
+
+   // Looks up the sessions subscribed to one value of an operation
+   flat_set<database_api_impl*> sessions;
+   auto match = [&sessions]( const auto& index, const auto& key ) {
+      auto itr = index.find( key );
+      if( itr != index.end() )
+         sessions.insert( itr->second.begin(), itr->second.end() );
+   };
+
+   std::map<database_api_impl*, fc::variants> matched;
+   for( const optional<operation_history_object>& o_op : _db.get_applied_operations() )
+   {
+      if( !o_op.valid() )
+         continue;
+      const operation& op = o_op->op;
+      sessions = _content_all;
+      switch( op.which() )
+      {
+         case operation::tag<content_card_v2_create_operation>::value:
+         {
+            const auto& o = op.get<content_card_v2_create_operation>();
+            match( _content_by_type, o.type );
+            match( _content_by_subject, o.subject_account );
+            break;
+         }
+         case operation::tag<content_card_v2_update_operation>::value:
+         {
+            const auto& o = op.get<content_card_v2_update_operation>();
+            match( _content_by_type, o.type );
+            match( _content_by_subject, o.subject_account );
+            break;
+         }
+         case operation::tag<content_card_v2_remove_operation>::value:
+            match( _content_by_subject, op.get<content_card_v2_remove_operation>().subject_account );
+            break;
+         case operation::tag<content_vote_create_operation>::value:
+            match( _content_by_subject, op.get<content_vote_create_operation>().subject_account );
+            break;
+         case operation::tag<content_vote_remove_operation>::value:
+            match( _content_by_subject, op.get<content_vote_remove_operation>().subject_account );
+            break;
+         case operation::tag<permission_create_operation>::value:
+         {
+            const auto& o = op.get<permission_create_operation>();
+            match( _content_by_type, o.permission_type );
+            match( _content_by_subject, o.subject_account );
+            match( _content_by_operator, o.operator_account );
+            break;
+         }
+         case operation::tag<permission_remove_operation>::value:
+            match( _content_by_subject, op.get<permission_remove_operation>().subject_account );
+            break;
+         default:
+            continue;
+      }
+      if( sessions.empty() )
+         continue;
+      // An operation is serialized once, then shared by all sessions it is sent to
+      const variant event( *o_op, GRAPHENE_NET_MAX_NESTED_OBJECTS );
+      for( database_api_impl* session : sessions )
+         matched[session].push_back( event );
+   }
+
+   for( auto& item : matched )
+      item.first->notify_content_events( item.second );
+}
+
 void database_api::set_subscribe_callback( std::function<void(const variant&)> cb, bool notify_remove_create )
 {
    my->set_subscribe_callback( cb, notify_remove_create );
@@ -190,12 +598,15 @@ void database_api_impl::cancel_all_subscriptions( bool reset_callback, bool rese
       _subscribe_callback = std::function<void(const fc::variant&)>();
 
    if ( reset_market_subscriptions )
+   {
       _market_subscriptions.clear();
+      unsubscribe_from_content_events();
+   }
 
    _notify_remove_create = false;
+   _dispatcher->unsubscribe_all( this, _subscribed_objects, _subscribed_accounts );
    _subscribed_accounts.clear();
-   static fc::bloom_parameters param(10000, 1.0/100, 1024*8*8*2);
-   _subscribe_filter = fc::bloom_filter(param);
+   _subscribed_objects.clear();
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -269,6 +680,34 @@ optional<signed_transaction> database_api_impl::get_recent_transaction_by_id(con
    }
 }
 
+optional<block_state_hash> database_api::get_block_state_hash( uint32_t block_num )const
+{
+   return my->get_block_state_hash( block_num );
+}
+
+optional<block_state_hash> database_api_impl::get_block_state_hash( uint32_t block_num )const
+{
+   return _db.get_block_state_hash( block_num );
+}
+
+vector<string> database_api::get_packed_state_deltas( uint32_t block_num_from, uint32_t limit )const
+{
+   return my->get_packed_state_deltas( block_num_from, limit );
+}
+
+vector<string> database_api_impl::get_packed_state_deltas( uint32_t block_num_from, uint32_t limit )const
+{
+   FC_ASSERT( limit <= 100, "At most 100 state deltas can be retrieved at once" );
+   vector<string> result;
+   const auto& log = _db.get_state_delta_log();
+   if( !log.is_open() )
+      return result;
+   log.read_packed( block_num_from, limit, [&result]( const vector<char>& packed ) {
+      result.push_back( fc::to_hex( packed.data(), packed.size() ) );
+   });
+   return result;
+}
+
 //////////////////////////////////////////////////////////////////////
 //                                                                  //
 // Globals                                                          //
@@ -447,6 +886,33 @@ account_id_type database_api::get_account_id_from_string(const std::string& name
    return my->get_account_from_string( name_or_id )->id;
 }
 
+vector<optional<account_id_type>> database_api::get_account_ids_from_strings(
+      const vector<std::string>& names_or_ids )const
+{
+   return my->get_account_ids_from_strings( names_or_ids );
+}
+
+vector<optional<account_id_type>> database_api_impl::get_account_ids_from_strings(
+      const vector<std::string>& names_or_ids )const
+{
+   FC_ASSERT( _app_options, "Internal error" );
+   const auto configured_limit = _app_options->api_limit_lookup_accounts;
+   FC_ASSERT( names_or_ids.size() <= configured_limit,
+              "Number of querying accounts can not be greater than ${configured_limit}",
+              ("configured_limit", configured_limit) );
+
+   vector<optional<account_id_type>> result;
+   result.reserve( names_or_ids.size() );
+   for( const account_object* account : get_accounts_from_strings( names_or_ids, false ) )
+   {
+      if( account == nullptr )
+         result.emplace_back();
+      else
+         result.emplace_back( account->id );
+   }
+   return result;
+}
+
 vector<optional<account_object>> database_api::get_accounts( const vector<std::string>& account_names_or_ids,
                                                              optional<bool> subscribe )const
 {
@@ -458,16 +924,17 @@ vector<optional<account_object>> database_api_impl::get_accounts( const vector<s
 {
    bool to_subscribe = get_whether_to_subscribe( subscribe );
    vector<optional<account_object>> result; result.reserve(account_names_or_ids.size());
-   std::transform(account_names_or_ids.begin(), account_names_or_ids.end(), std::back_inserter(result),
-                  [this,to_subscribe](std::string id_or_name) -> optional<account_object> {
-
-      const account_object *account = get_account_from_string(id_or_name, false);
-      if(account == nullptr)
-         return {};
+   for( const account_object* account : get_accounts_from_strings( account_names_or_ids, false ) )
+   {
+      if( account == nullptr )
+      {
+         result.emplace_back();
+         continue;
+      }
       if( to_subscribe )
          subscribe_to_item( account->id );
-      return *account;
-   });
+      result.emplace_back( *account );
+   }
    return result;
 }
 
@@ -499,161 +966,210 @@ std::map<std::string, full_account> database_api_impl::get_full_accounts( const
       if( to_subscribe )
       {
          if(_subscribed_accounts.size() < 100) {
-            _subscribed_accounts.insert( account->get_id() );
+            subscribe_to_account( account->get_id() );
             subscribe_to_item( account->id );
          }
       }
 
-      full_account acnt;
-      acnt.account = *account;
-      acnt.statistics = account->statistics(_db);
-      acnt.registrar_name = account->registrar(_db).name;
-      acnt.referrer_name = account->referrer(_db).name;
-      acnt.lifetime_referrer_name = account->lifetime_referrer(_db).name;
-      acnt.votes = lookup_vote_ids( vector<vote_id_type>( account->options.votes.begin(),
-                                                          account->options.votes.end() ) );
+      results[account_name_or_id] = get_full_account( *account );
+   }
+   return results;
+}
+
+std::map<string,versioned_full_account> database_api::get_changed_full_accounts(
+      const std::map<string, uint64_t>& known_versions, optional<bool> subscribe )
+{
+   return my->get_changed_full_accounts( known_versions, subscribe );
+}
+
+std::map<std::string, versioned_full_account> database_api_impl::get_changed_full_accounts(
+      const std::map<std::string, uint64_t>& known_versions, optional<bool> subscribe )
+{
+   FC_ASSERT( _app_options, "Internal error" );
+   const auto configured_limit = _app_options->api_limit_get_full_accounts;
+   FC_ASSERT( known_versions.size() <= configured_limit,
+              "Number of querying accounts can not be greater than ${configured_limit}",
+              ("configured_limit", configured_limit) );
+
+   bool to_subscribe = get_whether_to_subscribe( subscribe );
+
+   std::map<std::string, versioned_full_account> results;
+
+   for( const auto& item : known_versions )
+   {
+      const account_object* account = get_account_from_string( item.first, false );
+      if( account == nullptr )
+         continue;
 
-      if (account->cashback_vb)
+      if( to_subscribe )
       {
-         acnt.cashback_balance = account->cashback_balance(_db);
+         if(_subscribed_accounts.size() < 100) {
+            subscribe_to_account( account->get_id() );
+            subscribe_to_item( account->id );
+         }
       }
 
-      size_t api_limit_get_full_accounts_lists = static_cast<size_t>(
-                _app_options->api_limit_get_full_accounts_lists );
+      const uint64_t version = _dispatcher->get_account_version( account->get_id() );
+      if( version <= item.second )
+         continue;
 
-      // Add the account's proposals (if the data is available)
-      if( _app_options && _app_options->has_api_helper_indexes_plugin )
-      {
-         const auto& proposal_idx = _db.get_index_type< primary_index< proposal_index > >();
-         const auto& proposals_by_account = proposal_idx.get_secondary_index<
-                                                  graphene::chain::required_approval_index>();
+      versioned_full_account& result = results[item.first];
+      result.version = version;
+      result.account = get_full_account( *account );
+   }
+   return results;
+}
+
+full_account database_api_impl::get_full_account( const account_object& account )const
+{
+   full_account acnt;
+   acnt.account = account;
+   acnt.statistics = account.statistics(_db);
+   acnt.registrar_name = account.registrar(_db).name;
+   acnt.referrer_name = account.referrer(_db).name;
+   acnt.lifetime_referrer_name = account.lifetime_referrer(_db).name;
+   acnt.votes = lookup_vote_ids( vector<vote_id_type>( account.options.votes.begin(),
+                                                       account.options.votes.end() ) );
 
-         auto required_approvals_itr = proposals_by_account._account_to_proposals.find( account->id );
-         if( required_approvals_itr != proposals_by_account._account_to_proposals.end() )
+   if (account.cashback_vb)
+   {
+      acnt.cashback_balance = account.cashback_balance(_db);
+   }
+
+   size_t api_limit_get_full_accounts_lists = static_cast<size_t>(
+             _app_options->api_limit_get_full_accounts_lists );
+
+   // Add the account's proposals (if the data is available)
+   if( _app_options && _app_options->has_api_helper_indexes_plugin )
+   {
+      const auto& proposal_idx = _db.get_index_type< primary_index< proposal_index > >();
+      const auto& proposals_by_account = proposal_idx.get_secondary_index<
+                                               graphene::chain::required_approval_index>();
+
+      auto required_approvals_itr = proposals_by_account._account_to_proposals.find( account.id );
+      if( required_approvals_itr != proposals_by_account._account_to_proposals.end() )
+      {
+         acnt.proposals.reserve( std::min(required_approvals_itr->second.size(),
+                                          api_limit_get_full_accounts_lists) );
+         for( auto proposal_id : required_approvals_itr->second )
          {
-            acnt.proposals.reserve( std::min(required_approvals_itr->second.size(),
-                                             api_limit_get_full_accounts_lists) );
-            for( auto proposal_id : required_approvals_itr->second )
-            {
-               if(acnt.proposals.size() >= api_limit_get_full_accounts_lists) {
-                  acnt.more_data_available.proposals = true;
-                  break;
-               }
-               acnt.proposals.push_back(proposal_id(_db));
+            if(acnt.proposals.size() >= api_limit_get_full_accounts_lists) {
+               acnt.more_data_available.proposals = true;
+               break;
             }
+            acnt.proposals.push_back(proposal_id(_db));
          }
       }
+   }
 
-      // Add the account's balances
-      const auto& balances = _db.get_index_type< primary_index< account_balance_index > >().
-            get_secondary_index< balances_by_account_index >().get_account_balances( account->id );
-      for( const auto& balance : balances )
-      {
-         if(acnt.balances.size() >= api_limit_get_full_accounts_lists) {
-            acnt.more_data_available.balances = true;
-            break;
-         }
-         acnt.balances.emplace_back(*balance.second);
+   // Add the account's balances
+   const auto& balances = _db.get_index_type< primary_index< account_balance_index > >().
+         get_secondary_index< balances_by_account_index >().get_account_balances( account.id );
+   for( const auto& balance : balances )
+   {
+      if(acnt.balances.size() >= api_limit_get_full_accounts_lists) {
+         acnt.more_data_available.balances = true;
+         break;
       }
+      acnt.balances.emplace_back(*balance.second);
+   }
 
-      // Add the account's vesting balances
-      auto vesting_range = _db.get_index_type<vesting_balance_index>().indices().get<by_account>()
-                              .equal_range(account->id);
-      for(auto itr = vesting_range.first; itr != vesting_range.second; ++itr)
-      {
-         if(acnt.vesting_balances.size() >= api_limit_get_full_accounts_lists) {
-            acnt.more_data_available.vesting_balances = true;
-            break;
-         }
-         acnt.vesting_balances.emplace_back(*itr);
+   // Add the account's vesting balances
+   auto vesting_range = _db.get_index_type<vesting_balance_index>().indices().get<by_account>()
+                           .equal_range(account.id);
+   for(auto itr = vesting_range.first; itr != vesting_range.second; ++itr)
+   {
+      if(acnt.vesting_balances.size() >= api_limit_get_full_accounts_lists) {
+         acnt.more_data_available.vesting_balances = true;
+         break;
       }
+      acnt.vesting_balances.emplace_back(*itr);
+   }
 
-      // Add the account's orders
-      auto order_range = _db.get_index_type<limit_order_index>().indices().get<by_account>()
-                            .equal_range(account->id);
-      for(auto itr = order_range.first; itr != order_range.second; ++itr)
-      {
-         if(acnt.limit_orders.size() >= api_limit_get_full_accounts_lists) {
-            acnt.more_data_available.limit_orders = true;
-            break;
-         }
-         acnt.limit_orders.emplace_back(*itr);
+   // Add the account's orders
+   auto order_range = _db.get_index_type<limit_order_index>().indices().get<by_account>()
+                         .equal_range(account.id);
+   for(auto itr = order_range.first; itr != order_range.second; ++itr)
+   {
+      if(acnt.limit_orders.size() >= api_limit_get_full_accounts_lists) {
+         acnt.more_data_available.limit_orders = true;
+         break;
       }
-      auto call_range = _db.get_index_type<call_order_index>().indices().get<by_account>().equal_range(account->id);
-      for(auto itr = call_range.first; itr != call_range.second; ++itr)
-      {
-         if(acnt.call_orders.size() >= api_limit_get_full_accounts_lists) {
-            acnt.more_data_available.call_orders = true;
-            break;
-         }
-         acnt.call_orders.emplace_back(*itr);
+      acnt.limit_orders.emplace_back(*itr);
+   }
+   auto call_range = _db.get_index_type<call_order_index>().indices().get<by_account>().equal_range(account.id);
+   for(auto itr = call_range.first; itr != call_range.second; ++itr)
+   {
+      if(acnt.call_orders.size() >= api_limit_get_full_accounts_lists) {
+         acnt.more_data_available.call_orders = true;
+         break;
       }
-      auto settle_range = _db.get_index_type<force_settlement_index>().indices().get<by_account>()
-                             .equal_range(account->id);
-      for(auto itr = settle_range.first; itr != settle_range.second; ++itr)
-      {
-         if(acnt.settle_orders.size() >= api_limit_get_full_accounts_lists) {
-            acnt.more_data_available.settle_orders = true;
-            break;
-         }
-         acnt.settle_orders.emplace_back(*itr);
+      acnt.call_orders.emplace_back(*itr);
+   }
+   auto settle_range = _db.get_index_type<force_settlement_index>().indices().get<by_account>()
+                          .equal_range(account.id);
+   for(auto itr = settle_range.first; itr != settle_range.second; ++itr)
+   {
+      if(acnt.settle_orders.size() >= api_limit_get_full_accounts_lists) {
+         acnt.more_data_available.settle_orders = true;
+         break;
       }
+      acnt.settle_orders.emplace_back(*itr);
+   }
 
-      // get assets issued by user
-      auto asset_range = _db.get_index_type<asset_index>().indices().get<by_issuer>().equal_range(account->id);
-      for(auto itr = asset_range.first; itr != asset_range.second; ++itr)
-      {
-         if(acnt.assets.size() >= api_limit_get_full_accounts_lists) {
-            acnt.more_data_available.assets = true;
-            break;
-         }
-         acnt.assets.emplace_back(itr->id);
+   // get assets issued by user
+   auto asset_range = _db.get_index_type<asset_index>().indices().get<by_issuer>().equal_range(account.id);
+   for(auto itr = asset_range.first; itr != asset_range.second; ++itr)
+   {
+      if(acnt.assets.size() >= api_limit_get_full_accounts_lists) {
+         acnt.more_data_available.assets = true;
+         break;
       }
+      acnt.assets.emplace_back(itr->id);
+   }
 
-      // get withdraws permissions
-      auto withdraw_indices = _db.get_index_type<withdraw_permission_index>().indices();
-      auto withdraw_from_range = withdraw_indices.get<by_from>().equal_range(account->id);
-      for(auto itr = withdraw_from_range.first; itr != withdraw_from_range.second; ++itr)
-      {
-         if(acnt.withdraws_from.size() >= api_limit_get_full_accounts_lists) {
-            acnt.more_data_available.withdraws_from = true;
-            break;
-         }
-         acnt.withdraws_from.emplace_back(*itr);
+   // get withdraws permissions
+   auto withdraw_indices = _db.get_index_type<withdraw_permission_index>().indices();
+   auto withdraw_from_range = withdraw_indices.get<by_from>().equal_range(account.id);
+   for(auto itr = withdraw_from_range.first; itr != withdraw_from_range.second; ++itr)
+   {
+      if(acnt.withdraws_from.size() >= api_limit_get_full_accounts_lists) {
+         acnt.more_data_available.withdraws_from = true;
+         break;
       }
-      auto withdraw_authorized_range = withdraw_indices.get<by_authorized>().equal_range(account->id);
-      for(auto itr = withdraw_authorized_range.first; itr != withdraw_authorized_range.second; ++itr)
-      {
-         if(acnt.withdraws_to.size() >= api_limit_get_full_accounts_lists) {
-            acnt.more_data_available.withdraws_to = true;
-            break;
-         }
-         acnt.withdraws_to.emplace_back(*itr);
+      acnt.withdraws_from.emplace_back(*itr);
+   }
+   auto withdraw_authorized_range = withdraw_indices.get<by_authorized>().equal_range(account.id);
+   for(auto itr = withdraw_authorized_range.first; itr != withdraw_authorized_range.second; ++itr)
+   {
+      if(acnt.withdraws_to.size() >= api_limit_get_full_accounts_lists) {
+         acnt.more_data_available.withdraws_to = true;
+         break;
       }
+      acnt.withdraws_to.emplace_back(*itr);
+   }
 
-      // get htlcs
-      auto htlc_from_range = _db.get_index_type<htlc_index>().indices().get<by_from_id>().equal_range(account->id);
-      for(auto itr = htlc_from_range.first; itr != htlc_from_range.second; ++itr)
-      {
-         if(acnt.htlcs_from.size() >= api_limit_get_full_accounts_lists) {
-            acnt.more_data_available.htlcs_from = true;
-            break;
-         }
-         acnt.htlcs_from.emplace_back(*itr);
+   // get htlcs
+   auto htlc_from_range = _db.get_index_type<htlc_index>().indices().get<by_from_id>().equal_range(account.id);
+   for(auto itr = htlc_from_range.first; itr != htlc_from_range.second; ++itr)
+   {
+      if(acnt.htlcs_from.size() >= api_limit_get_full_accounts_lists) {
+         acnt.more_data_available.htlcs_from = true;
+         break;
       }
-      auto htlc_to_range = _db.get_index_type<htlc_index>().indices().get<by_to_id>().equal_range(account->id);
-      for(auto itr = htlc_to_range.first; itr != htlc_to_range.second; ++itr)
-      {
-         if(acnt.htlcs_to.size() >= api_limit_get_full_accounts_lists) {
-            acnt.more_data_available.htlcs_to = true;
-            break;
-         }
-         acnt.htlcs_to.emplace_back(*itr);
+      acnt.htlcs_from.emplace_back(*itr);
+   }
+   auto htlc_to_range = _db.get_index_type<htlc_index>().indices().get<by_to_id>().equal_range(account.id);
+   for(auto itr = htlc_to_range.first; itr != htlc_to_range.second; ++itr)
+   {
+      if(acnt.htlcs_to.size() >= api_limit_get_full_accounts_lists) {
+         acnt.more_data_available.htlcs_to = true;
+         break;
       }
-
-      results[account_name_or_id] = acnt;
+      acnt.htlcs_to.emplace_back(*itr);
    }
-   return results;
+
+   return acnt;
 }
 
 optional<account_object> database_api::get_account_by_name( string name )const
@@ -742,6 +1258,30 @@ map<string,account_id_type> database_api_impl::lookup_accounts( const string& lo
    return result;
 }
 
+map<string,account_id_type> database_api::search_accounts( const string& prefix, uint32_t limit )const
+{
+   return my->search_accounts( prefix, limit );
+}
+
+map<string,account_id_type> database_api_impl::search_accounts( const string& prefix, uint32_t limit )const
+{
+   FC_ASSERT( _app_options, "Internal error" );
+   const auto configured_limit = _app_options->api_limit_lookup_accounts;
+   FC_ASSERT( limit <= configured_limit,
+              "limit can not be greater than ${configured_limit}",
+              ("configured_limit", configured_limit) );
+
+   const string lower_prefix = boost::algorithm::to_lower_copy( prefix );
+   const auto& accounts_by_name = _db.get_index_type<account_index>().indices().get<by_name>();
+   map<string,account_id_type> result;
+   // names with the prefix are adjacent in the index, the search ends at the first name without it
+   for( auto itr = accounts_by_name.lower_bound( lower_prefix );
+        limit > 0 && itr != accounts_by_name.end() && boost::algorithm::starts_with( itr->name, lower_prefix );
+        ++itr, --limit )
+      result.emplace( itr->name, itr->get_id() );
+   return result;
+}
+
 uint64_t database_api::get_account_count()const
 {
    return my->get_account_count();
@@ -864,6 +1404,37 @@ vector<vesting_balance_object> database_api_impl::get_vesting_balances( const st
    FC_CAPTURE_AND_RETHROW( (account_id_or_name) );
 }
 
+vector<vector<extended_vesting_balance_object>> database_api::get_withdrawable_vesting_balances(
+      const vector<std::string>& account_names_or_ids )const
+{
+   return my->get_withdrawable_vesting_balances( account_names_or_ids );
+}
+
+vector<vector<extended_vesting_balance_object>> database_api_impl::get_withdrawable_vesting_balances(
+      const vector<std::string>& account_names_or_ids )const
+{
+   FC_ASSERT( _app_options, "Internal error" );
+   const auto configured_limit = _app_options->api_limit_get_full_accounts;
+   FC_ASSERT( account_names_or_ids.size() <= configured_limit,
+              "Number of querying accounts can not be greater than ${configured_limit}",
+              ("configured_limit", configured_limit) );
+
+   const auto now = _db.head_block_time();
+   const auto& by_account_idx = _db.get_index_type<vesting_balance_index>().indices().get<by_account>();
+   vector<vector<extended_vesting_balance_object>> result;
+   result.reserve( account_names_or_ids.size() );
+   for( const std::string& account_name_or_id : account_names_or_ids )
+   {
+      const account_id_type account_id = get_account_from_string( account_name_or_id )->id;
+      result.emplace_back();
+      auto& balances = result.back();
+      auto vesting_range = by_account_idx.equal_range( account_id );
+      for( auto itr = vesting_range.first; itr != vesting_range.second; ++itr )
+         balances.emplace_back( *itr, now );
+   }
+   return result;
+}
+
 //////////////////////////////////////////////////////////////////////
 //                                                                  //
 // Assets                                                           //
@@ -926,6 +1497,29 @@ vector<extended_asset_object> database_api_impl::list_assets(const string& lower
    return result;
 }
 
+map<string,asset_id_type> database_api::search_asset_symbols( const string& prefix, uint32_t limit )const
+{
+   return my->search_asset_symbols( prefix, limit );
+}
+
+map<string,asset_id_type> database_api_impl::search_asset_symbols( const string& prefix, uint32_t limit )const
+{
+   FC_ASSERT( _app_options, "Internal error" );
+   const auto configured_limit = _app_options->api_limit_get_assets;
+   FC_ASSERT( limit <= configured_limit,
+              "limit can not be greater than ${configured_limit}",
+              ("configured_limit", configured_limit) );
+
+   const string upper_prefix = boost::algorithm::to_upper_copy( prefix );
+   const auto& assets_by_symbol = _db.get_index_type<asset_index>().indices().get<by_symbol>();
+   map<string,asset_id_type> result;
+   for( auto itr = assets_by_symbol.lower_bound( upper_prefix );
+        limit > 0 && itr != assets_by_symbol.end() && boost::algorithm::starts_with( itr->symbol, upper_prefix );
+        ++itr, --limit )
+      result.emplace( itr->symbol, itr->get_id() );
+   return result;
+}
+
 uint64_t database_api::get_asset_count()const
 {
    return my->get_asset_count();
@@ -1307,6 +1901,40 @@ void database_api_impl::unsubscribe_from_market(const std::string& a, const std:
    _market_subscriptions.erase(std::make_pair(asset_a_id,asset_b_id));
 }
 
+void database_api::subscribe_to_content_events( std::function<void(const variant&)> callback,
+                                                const content_event_filter& filter )
+{
+   my->subscribe_to_content_events( callback, filter );
+}
+
+void database_api_impl::subscribe_to_content_events( std::function<void(const variant&)> callback,
+                                                     const content_event_filter& filter )
+{
+   FC_ASSERT( filter.types.size() + filter.subjects.size() + filter.operators.size()
+                 <= max_content_event_filter_size,
+              "Content event filter can not contain more than ${max} items",
+              ("max", max_content_event_filter_size) );
+
+   unsubscribe_from_content_events();
+   _content_event_callback = callback;
+   _content_event_filter = filter;
+   _dispatcher->subscribe_to_content_events( this, _content_event_filter );
+}
+
+void database_api::unsubscribe_from_content_events()
+{
+   my->unsubscribe_from_content_events();
+}
+
+void database_api_impl::unsubscribe_from_content_events()
+{
+   if( !_content_event_callback )
+      return;
+   _dispatcher->unsubscribe_from_content_events( this, _content_event_filter );
+   _content_event_callback = std::function<void(const fc::variant&)>();
+   _content_event_filter = content_event_filter();
+}
+
 market_ticker database_api::get_ticker( const string& base, const string& quote )const
 {
     return my->get_ticker( base, quote );
@@ -1314,31 +1942,33 @@ market_ticker database_api::get_ticker( const string& base, const string& quote
 
 market_ticker database_api_impl::get_ticker( const string& base, const string& quote, bool skip_order_book )const
 {
-   FC_ASSERT( _app_options && _app_options->has_market_history_plugin, "Market history plugin is not enabled." );
+   return _market_cache->get_ticker( base, quote, skip_order_book, [&]() -> market_ticker {
+      FC_ASSERT( _app_options && _app_options->has_market_history_plugin, "Market history plugin is not enabled." );
 
-   const auto assets = lookup_asset_symbols( {base, quote} );
+      const auto assets = lookup_asset_symbols( {base, quote} );
 
-   FC_ASSERT( assets[0], "Invalid base asset symbol: ${s}", ("s",base) );
-   FC_ASSERT( assets[1], "Invalid quote asset symbol: ${s}", ("s",quote) );
+      FC_ASSERT( assets[0], "Invalid base asset symbol: ${s}", ("s",base) );
+      FC_ASSERT( assets[1], "Invalid quote asset symbol: ${s}", ("s",quote) );
 
-   auto base_id = assets[0]->id;
-   auto quote_id = assets[1]->id;
-   if( base_id > quote_id ) std::swap( base_id, quote_id );
-   const auto& ticker_idx = _db.get_index_type<market_ticker_index>().indices().get<by_market>();
-   auto itr = ticker_idx.find( std::make_tuple( base_id, quote_id ) );
-   const fc::time_point_sec now = _db.head_block_time();
-   if( itr != ticker_idx.end() )
-   {
-      order_book orders;
-      if (!skip_order_book)
+      auto base_id = assets[0]->id;
+      auto quote_id = assets[1]->id;
+      if( base_id > quote_id ) std::swap( base_id, quote_id );
+      const auto& ticker_idx = _db.get_index_type<market_ticker_index>().indices().get<by_market>();
+      auto itr = ticker_idx.find( std::make_tuple( base_id, quote_id ) );
+      const fc::time_point_sec now = _db.head_block_time();
+      if( itr != ticker_idx.end() )
       {
-         orders = get_order_book(assets[0]->symbol, assets[1]->symbol, 1);
+         order_book orders;
+         if (!skip_order_book)
+         {
+            orders = get_order_book(assets[0]->symbol, assets[1]->symbol, 1);
+         }
+         return market_ticker(*itr, now, *assets[0], *assets[1], orders);
       }
-      return market_ticker(*itr, now, *assets[0], *assets[1], orders);
-   }
-   // if no ticker is found for this market we return an empty ticker
-   market_ticker empty_result(now, *assets[0], *assets[1]);
-   return empty_result;
+      // if no ticker is found for this market we return an empty ticker
+      market_ticker empty_result(now, *assets[0], *assets[1]);
+      return empty_result;
+   });
 }
 
 market_volume database_api::get_24_volume( const string& base, const string& quote )const
@@ -1367,49 +1997,68 @@ order_book database_api::get_order_book( const string& base, const string& quote
 
 order_book database_api_impl::get_order_book( const string& base, const string& quote, unsigned limit )const
 {
-   FC_ASSERT( _app_options, "Internal error" );
-   const auto configured_limit = _app_options->api_limit_get_order_book;
-   FC_ASSERT( limit <= configured_limit,
-              "limit can not be greater than ${configured_limit}",
-              ("configured_limit", configured_limit) );
+   return _market_cache->get_order_book( base, quote, limit, [&]() -> order_book {
+      FC_ASSERT( _app_options, "Internal error" );
+      const auto configured_limit = _app_options->api_limit_get_order_book;
+      FC_ASSERT( limit <= configured_limit,
+                 "limit can not be greater than ${configured_limit}",
+                 ("configured_limit", configured_limit) );
 
-   order_book result;
-   result.base = base;
-   result.quote = quote;
+      order_book result;
+      result.base = base;
+      result.quote = quote;
 
-   auto assets = lookup_asset_symbols( {base, quote} );
-   FC_ASSERT( assets[0], "Invalid base asset symbol: ${s}", ("s",base) );
-   FC_ASSERT( assets[1], "Invalid quote asset symbol: ${s}", ("s",quote) );
+      auto assets = lookup_asset_symbols( {base, quote} );
+      FC_ASSERT( assets[0], "Invalid base asset symbol: ${s}", ("s",base) );
+      FC_ASSERT( assets[1], "Invalid quote asset symbol: ${s}", ("s",quote) );
 
-   auto base_id = assets[0]->id;
-   auto quote_id = assets[1]->id;
-   auto orders = get_limit_orders( base_id, quote_id, limit );
+      auto base_id = assets[0]->id;
+      auto quote_id = assets[1]->id;
 
-   for( const auto& o : orders )
-   {
-      if( o.sell_price.base.asset_id == base_id )
-      {
+      auto make_order = [&]( const price& sell_price, share_type for_sale ) {
          order ord;
-         ord.price = price_to_string( o.sell_price, *assets[0], *assets[1] );
-         ord.quote = assets[1]->amount_to_string( share_type( fc::uint128_t( o.for_sale.value )
-                                                              * o.sell_price.quote.amount.value
-                                                              / o.sell_price.base.amount.value ) );
-         ord.base = assets[0]->amount_to_string( o.for_sale );
-         result.bids.push_back( ord );
+         ord.price = price_to_string( sell_price, *assets[0], *assets[1] );
+         const share_type received( fc::uint128_t( for_sale.value ) * sell_price.quote.amount.value
+                                    / sell_price.base.amount.value );
+         if( sell_price.base.asset_id == base_id )
+         {
+            ord.quote = assets[1]->amount_to_string( received );
+            ord.base = assets[0]->amount_to_string( for_sale );
+         }
+         else
+         {
+            ord.quote = assets[1]->amount_to_string( for_sale );
+            ord.base = assets[0]->amount_to_string( received );
+         }
+         return ord;
+      };
+
+      if( order_book_level_index != nullptr )
+      {
+         // the orders are summed up by price as they change, only the returned levels are visited
+         auto add_levels = [&]( asset_id_type sell, asset_id_type receive, vector<order>& side ) {
+            for( const auto& item : order_book_level_index->get_levels( sell, receive ) )
+            {
+               if( side.size() >= limit )
+                  break;
+               side.push_back( make_order( item.first, item.second.for_sale ) );
+            }
+         };
+         add_levels( base_id, quote_id, result.bids );
+         add_levels( quote_id, base_id, result.asks );
+         return result;
       }
-      else
+
+      for( const auto& o : get_limit_orders( base_id, quote_id, limit ) )
       {
-         order ord;
-         ord.price = price_to_string( o.sell_price, *assets[0], *assets[1] );
-         ord.quote = assets[1]->amount_to_string( o.for_sale );
-         ord.base = assets[0]->amount_to_string( share_type( fc::uint128_t( o.for_sale.value )
-                                                             * o.sell_price.quote.amount.value
-                                                             / o.sell_price.base.amount.value ) );
-         result.asks.push_back( ord );
+         if( o.sell_price.base.asset_id == base_id )
+            result.bids.push_back( make_order( o.sell_price, o.for_sale ) );
+         else
+            result.asks.push_back( make_order( o.sell_price, o.for_sale ) );
       }
-   }
 
-   return result;
+      return result;
+   });
 }
 
 vector<market_ticker> database_api::get_top_markets(uint32_t limit)const
@@ -1419,30 +2068,27 @@ vector<market_ticker> database_api::get_top_markets(uint32_t limit)const
 
 vector<market_ticker> database_api_impl::get_top_markets(uint32_t limit)const
 {
-   FC_ASSERT( _app_options && _app_options->has_market_history_plugin, "Market history plugin is not enabled." );
-
-   const auto configured_limit = _app_options->api_limit_get_top_markets;
-   FC_ASSERT( limit <= configured_limit,
-              "limit can not be greater than ${configured_limit}",
-              ("configured_limit", configured_limit) );
+   return _market_cache->get_top_markets( limit, [&]() -> vector<market_ticker> {
+      FC_ASSERT( _app_options && _app_options->has_market_history_plugin, "Market history plugin is not enabled." );
 
-   const auto& volume_idx = _db.get_index_type<market_ticker_index>().indices().get<by_volume>();
-   auto itr = volume_idx.rbegin();
-   vector<market_ticker> result;
-   result.reserve(limit);
-   const fc::time_point_sec now = _db.head_block_time();
+      const auto configured_limit = _app_options->api_limit_get_top_markets;
+      FC_ASSERT( limit <= configured_limit,
+                 "limit can not be greater than ${configured_limit}",
+                 ("configured_limit", configured_limit) );
 
-   while( itr != volume_idx.rend() && result.size() < limit)
-   {
-      const asset_object base = itr->base(_db);
-      const asset_object quote = itr->quote(_db);
-      order_book orders;
-      orders = get_order_book(base.symbol, quote.symbol, 1);
+      // the tickers are kept sorted by volume, and are shared with get_ticker through the cache
+      const auto& volume_idx = _db.get_index_type<market_ticker_index>().indices().get<by_volume>();
+      auto itr = volume_idx.rbegin();
+      vector<market_ticker> result;
+      result.reserve(limit);
 
-      result.emplace_back(market_ticker(*itr, now, base, quote, orders));
-      ++itr;
-   }
-   return result;
+      while( itr != volume_idx.rend() && result.size() < limit)
+      {
+         result.emplace_back( get_ticker( itr->base(_db).symbol, itr->quote(_db).symbol, false ) );
+         ++itr;
+      }
+      return result;
+   });
 }
 
 vector<market_trade> database_api::get_trade_history( const string& base,
@@ -2158,7 +2804,13 @@ processed_transaction database_api::validate_transaction( const signed_transacti
 
 processed_transaction database_api_impl::validate_transaction( const signed_transaction& trx )const
 {
-   return _db.validate_transaction(trx);
+   // digests, operation validation and signature recovery are done on the thread pool, so that the chain
+   // thread only spends the time for applying the transaction in its temporary undo session.
+   // An object_view can not take the application: it is read-only and read on the chain thread as well, while
+   // evaluators modify the live objects through the database.
+   const precomputable_transaction precomputed( trx );
+   _db.precompute_parallel( precomputed ).wait();
+   return _db.validate_transaction( precomputed );
 }
 
 vector< fc::variant > database_api::get_required_fees( const vector<operation>& ops,
@@ -2226,12 +2878,6 @@ struct get_required_fees_helper
 vector< fc::variant > database_api_impl::get_required_fees( const vector<operation>& ops,
                                                             const std::string& asset_id_or_symbol )const
 {
-   vector< operation > _ops = ops;
-   //
-   // we copy the ops because we need to mutate an operation to reliably
-   // determine its fee, see #435
-   //
-
    vector< fc::variant > result;
    result.reserve(ops.size());
    const asset_object& a = *get_asset_from_string(asset_id_or_symbol);
@@ -2239,13 +2885,42 @@ vector< fc::variant > database_api_impl::get_required_fees( const vector<operati
       _db.current_fee_schedule(),
       a.options.core_exchange_rate,
       GET_REQUIRED_FEES_MAX_RECURSION );
-   for( operation& op : _ops )
+   for( const operation& op : ops )
    {
-      result.push_back( helper.set_op_fees( op ) );
+      result.push_back( _fee_cache->get_fee( a.id, op, [&helper,&op]() {
+         //
+         // we copy the op because we need to mutate an operation to reliably
+         // determine its fee, see #435
+         //
+         operation mutable_op = op;
+         return helper.set_op_fees( mutable_op );
+      }) );
    }
    return result;
 }
 
+vector< vector< fc::variant > > database_api::get_required_fees_in_assets( const vector<operation>& ops,
+                                                   const vector<std::string>& assets_id_or_symbol )const
+{
+   return my->get_required_fees_in_assets( ops, assets_id_or_symbol );
+}
+
+vector< vector< fc::variant > > database_api_impl::get_required_fees_in_assets( const vector<operation>& ops,
+                                                   const vector<std::string>& assets_id_or_symbol )const
+{
+   FC_ASSERT( _app_options, "Internal error" );
+   const auto configured_limit = _app_options->api_limit_get_assets;
+   FC_ASSERT( assets_id_or_symbol.size() <= configured_limit,
+              "Number of querying assets can not be greater than ${configured_limit}",
+              ("configured_limit", configured_limit) );
+
+   vector< vector< fc::variant > > result;
+   result.reserve( assets_id_or_symbol.size() );
+   for( const std::string& asset_id_or_symbol : assets_id_or_symbol )
+      result.push_back( get_required_fees( ops, asset_id_or_symbol ) );
+   return result;
+}
+
 //////////////////////////////////////////////////////////////////////
 //                                                                  //
 // Proposed transactions                                            //
@@ -2522,20 +3197,42 @@ vector<htlc_object> database_api_impl::list_htlcs(const htlc_id_type start, uint
 //////////////////////////////////////////////////////////////////////
 
 vector<personal_data_object> database_api::get_personal_data( const account_id_type subject_account,
-                                                              const account_id_type operator_account) const
+                                                              const account_id_type operator_account,
+                                                              optional<personal_data_id_type> start_id,
+                                                              optional<uint32_t> limit ) const
 {
-   return my->get_personal_data(subject_account, operator_account);
+   return my->get_personal_data(subject_account, operator_account, start_id, limit);
 }
 
 vector<personal_data_object> database_api_impl::get_personal_data( const account_id_type subject_account,
-                                                                   const account_id_type operator_account) const
+                                                                   const account_id_type operator_account,
+                                                                   optional<personal_data_id_type> start_id,
+                                                                   optional<uint32_t> olimit ) const
 {
+   FC_ASSERT( _app_options, "Internal error" );
+   const auto configured_limit = _app_options->api_limit_get_personal_data;
+   uint32_t limit = olimit.valid() ? *olimit : configured_limit;
+   FC_ASSERT( limit <= configured_limit,
+              "limit can not be greater than ${configured_limit}",
+              ("configured_limit", configured_limit) );
+
    const auto& pd_idx = _db.get_index_type<personal_data_index>();
    const auto& by_op_idx = pd_idx.indices().get<by_subject_account>();
    auto itr = by_op_idx.lower_bound(boost::make_tuple(subject_account, operator_account));
+   if( start_id.valid() )
+   {
+      // the index is sorted by hash within the accounts, so the cursor object tells where to continue
+      const personal_data_object* start = _db.find(*start_id);
+      FC_ASSERT( start != nullptr && start->subject_account == subject_account
+                    && start->operator_account == operator_account,
+                 "Personal data ${id} does not belong to the given accounts", ("id", *start_id) );
+      itr = by_op_idx.iterator_to(*start);
+   }
 
    vector<personal_data_object> result;
-   while( itr->subject_account == subject_account && itr->operator_account == operator_account )
+   result.reserve( std::min<size_t>( limit, pd_idx.indices().size() ) );
+   while( itr != by_op_idx.end() && itr->subject_account == subject_account
+          && itr->operator_account == operator_account && result.size() < limit )
    {
       result.push_back(*itr);
       ++itr;
@@ -2557,13 +3254,13 @@ fc::optional<personal_data_object> database_api_impl::get_last_personal_data( co
    const auto& by_op_idx = pd_idx.indices().get<by_subject_account>();
    auto itr = by_op_idx.lower_bound(boost::make_tuple(subject_account, operator_account));
 
-   if ( itr->subject_account != subject_account || itr->operator_account != operator_account ){
+   if ( itr == by_op_idx.end() || itr->subject_account != subject_account || itr->operator_account != operator_account ){
       return fc::optional<personal_data_object>();
    }
 
    auto last_pd = *itr;
    ++itr;
-   while( itr->subject_account == subject_account && itr->operator_account == operator_account )
+   while( itr != by_op_idx.end() && itr->subject_account == subject_account && itr->operator_account == operator_account )
    {
       if (itr->id > last_pd.id){
          last_pd = *itr;
@@ -2575,20 +3272,42 @@ fc::optional<personal_data_object> database_api_impl::get_last_personal_data( co
 }
 
 vector<personal_data_v2_object> database_api::get_personal_data_v2( const account_id_type subject_account,
-                                                              const account_id_type operator_account) const
+                                                              const account_id_type operator_account,
+                                                              optional<personal_data_v2_id_type> start_id,
+                                                              optional<uint32_t> limit ) const
 {
-   return my->get_personal_data_v2(subject_account, operator_account);
+   return my->get_personal_data_v2(subject_account, operator_account, start_id, limit);
 }
 
 vector<personal_data_v2_object> database_api_impl::get_personal_data_v2( const account_id_type subject_account,
-                                                                   const account_id_type operator_account) const
+                                                                   const account_id_type operator_account,
+                                                                   optional<personal_data_v2_id_type> start_id,
+                                                                   optional<uint32_t> olimit ) const
 {
+   FC_ASSERT( _app_options, "Internal error" );
+   const auto configured_limit = _app_options->api_limit_get_personal_data;
+   uint32_t limit = olimit.valid() ? *olimit : configured_limit;
+   FC_ASSERT( limit <= configured_limit,
+              "limit can not be greater than ${configured_limit}",
+              ("configured_limit", configured_limit) );
+
    const auto& pd_idx = _db.get_index_type<personal_data_v2_index>();
    const auto& by_op_idx = pd_idx.indices().get<by_subject_account>();
    auto itr = by_op_idx.lower_bound(boost::make_tuple(subject_account, operator_account));
+   if( start_id.valid() )
+   {
+      // the index is sorted by hash within the accounts, so the cursor object tells where to continue
+      const personal_data_v2_object* start = _db.find(*start_id);
+      FC_ASSERT( start != nullptr && start->subject_account == subject_account
+                    && start->operator_account == operator_account,
+                 "Personal data ${id} does not belong to the given accounts", ("id", *start_id) );
+      itr = by_op_idx.iterator_to(*start);
+   }
 
    vector<personal_data_v2_object> result;
-   while( itr->subject_account == subject_account && itr->operator_account == operator_account )
+   result.reserve( std::min<size_t>( limit, pd_idx.indices().size() ) );
+   while( itr != by_op_idx.end() && itr->subject_account == subject_account
+          && itr->operator_account == operator_account && result.size() < limit )
    {
       result.push_back(*itr);
       ++itr;
@@ -2597,6 +3316,46 @@ vector<personal_data_v2_object> database_api_impl::get_personal_data_v2( const a
    return result;
 }
 
+vector<vector<personal_data_v2_object>> database_api::get_personal_data_v2_by_accounts(
+      const vector<std::pair<account_id_type, account_id_type>>& account_pairs, uint32_t limit ) const
+{
+   return my->get_personal_data_v2_by_accounts( account_pairs, limit );
+}
+
+vector<vector<personal_data_v2_object>> database_api_impl::get_personal_data_v2_by_accounts(
+      const vector<std::pair<account_id_type, account_id_type>>& account_pairs, uint32_t limit ) const
+{
+   FC_ASSERT( _app_options, "Internal error" );
+   const auto configured_limit = _app_options->api_limit_get_personal_data;
+   FC_ASSERT( limit <= configured_limit && account_pairs.size() <= configured_limit,
+              "limit and number of querying account pairs can not be greater than ${configured_limit}",
+              ("configured_limit", configured_limit) );
+
+   vector<vector<personal_data_v2_object>> result;
+   result.reserve( account_pairs.size() );
+   for( const auto& accounts : account_pairs )
+   {
+      result.push_back( get_personal_data_v2( accounts.first, accounts.second, {}, limit ) );
+      limit -= result.back().size();
+   }
+   return result;
+}
+
+optional<graphene::api_helper_indexes::personal_data_proof> database_api::get_personal_data_proof(
+      const account_id_type subject_account, const account_id_type operator_account, const string& hash ) const
+{
+   return my->get_personal_data_proof( subject_account, operator_account, hash );
+}
+
+optional<graphene::api_helper_indexes::personal_data_proof> database_api_impl::get_personal_data_proof(
+      const account_id_type subject_account, const account_id_type operator_account, const string& hash ) const
+{
+   // api_helper_indexes plugin is required for accessing the secondary index
+   FC_ASSERT( personal_data_merkle_index != nullptr,
+              "api_helper_indexes plugin is not enabled on this server." );
+   return personal_data_merkle_index->get_proof( subject_account, operator_account, hash );
+}
+
 fc::optional<personal_data_v2_object> database_api::get_last_personal_data_v2( const account_id_type subject_account,
                                                                          const account_id_type operator_account) const
 {
@@ -2610,13 +3369,13 @@ fc::optional<personal_data_v2_object> database_api_impl::get_last_personal_data_
    const auto& by_op_idx = pd_idx.indices().get<by_subject_account>();
    auto itr = by_op_idx.lower_bound(boost::make_tuple(subject_account, operator_account));
 
-   if ( itr->subject_account != subject_account || itr->operator_account != operator_account ){
+   if ( itr == by_op_idx.end() || itr->subject_account != subject_account || itr->operator_account != operator_account ){
       return fc::optional<personal_data_v2_object>();
    }
 
    auto last_pd = *itr;
    ++itr;
-   while( itr->subject_account == subject_account && itr->operator_account == operator_account )
+   while( itr != by_op_idx.end() && itr->subject_account == subject_account && itr->operator_account == operator_account )
    {
       if (itr->id > last_pd.id){
          last_pd = *itr;
@@ -2714,7 +3473,7 @@ vector<content_card_v2_object> database_api_impl::get_content_cards_v2( const ac
    auto itr = by_op_idx.lower_bound(boost::make_tuple(subject_account, content_id));
 
    vector<content_card_v2_object> result;
-   while( itr->subject_account == subject_account && limit-- )
+   while( itr != by_op_idx.end() && itr->subject_account == subject_account && limit-- )
    {
       result.push_back(*itr);
       ++itr;
@@ -2723,6 +3482,166 @@ vector<content_card_v2_object> database_api_impl::get_content_cards_v2( const ac
    return result;
 }
 
+vector<vector<content_card_v2_object>> database_api::get_content_cards_v2_by_accounts(
+      const vector<account_id_type>& subject_accounts, uint32_t limit ) const
+{
+   return my->get_content_cards_v2_by_accounts( subject_accounts, limit );
+}
+
+vector<vector<content_card_v2_object>> database_api_impl::get_content_cards_v2_by_accounts(
+      const vector<account_id_type>& subject_accounts, uint32_t limit ) const
+{
+   FC_ASSERT( _app_options, "Internal error" );
+   const auto configured_limit = _app_options->api_limit_get_content_cards;
+   FC_ASSERT( limit <= configured_limit && subject_accounts.size() <= configured_limit,
+              "limit and number of querying accounts can not be greater than ${configured_limit}",
+              ("configured_limit", configured_limit) );
+
+   vector<vector<content_card_v2_object>> result;
+   result.reserve( subject_accounts.size() );
+   for( const auto& account : subject_accounts )
+   {
+      result.push_back( get_content_cards_v2( account, content_card_v2_id_type(), limit ) );
+      limit -= result.back().size();
+   }
+   return result;
+}
+
+vector<content_card_v2_object> database_api::get_content_cards_v2_by_type( const string& type,
+                                                                         fc::time_point_sec from, fc::time_point_sec to,
+                                                                         uint32_t limit ) const
+{
+   return my->get_content_cards_v2_by_type(type, from, to, limit);
+}
+
+vector<content_card_v2_object> database_api_impl::get_content_cards_v2_by_type( const string& type,
+                                                                              fc::time_point_sec from, fc::time_point_sec to,
+                                                                              uint32_t limit ) const
+{
+   check_content_card_feed_query( limit );
+   return get_content_cards_v2_by_ids( content_card_feed_index->get_cards_by_type( type, from, to, limit ) );
+}
+
+vector<content_card_v2_object> database_api::get_content_cards_v2_by_time( const account_id_type subject_account,
+                                                                         fc::time_point_sec from, fc::time_point_sec to,
+                                                                         uint32_t limit ) const
+{
+   return my->get_content_cards_v2_by_time(subject_account, from, to, limit);
+}
+
+vector<content_card_v2_object> database_api_impl::get_content_cards_v2_by_time( const account_id_type subject_account,
+                                                                              fc::time_point_sec from, fc::time_point_sec to,
+                                                                              uint32_t limit ) const
+{
+   check_content_card_feed_query( limit );
+   return get_content_cards_v2_by_ids( content_card_feed_index->get_cards_by_subject( subject_account, from, to, limit ) );
+}
+
+vector<content_card_v2_id_type> database_api::search_content_cards( const string& query, uint32_t limit ) const
+{
+   return my->search_content_cards( query, limit );
+}
+
+vector<content_card_v2_id_type> database_api_impl::search_content_cards( const string& query, uint32_t limit ) const
+{
+   // content_cards plugin is required for accessing the secondary index
+   FC_ASSERT( content_card_search_index != nullptr,
+              "This api is switched off because content_cards plugin does not enabled" );
+   FC_ASSERT( _app_options, "Internal error" );
+   const auto configured_limit = _app_options->api_limit_get_content_cards;
+   FC_ASSERT( limit <= configured_limit,
+              "limit can not be greater than ${configured_limit}",
+              ("configured_limit", configured_limit) );
+   return content_card_search_index->search( query, limit );
+}
+
+vector<graphene::content_cards::content_vote_count> database_api::get_content_vote_counts(
+      const vector<string>& content_ids ) const
+{
+   return my->get_content_vote_counts( content_ids );
+}
+
+vector<graphene::content_cards::content_vote_count> database_api_impl::get_content_vote_counts(
+      const vector<string>& content_ids ) const
+{
+   // content_cards plugin is required for accessing the secondary index
+   FC_ASSERT( content_vote_count_index != nullptr,
+              "This api is switched off because content_cards plugin does not enabled" );
+   FC_ASSERT( _app_options, "Internal error" );
+   const auto configured_limit = _app_options->api_limit_get_content_vote_counts;
+   FC_ASSERT( content_ids.size() <= configured_limit,
+              "Number of querying content ids can not be greater than ${configured_limit}",
+              ("configured_limit", configured_limit) );
+
+   vector<graphene::content_cards::content_vote_count> result;
+   result.reserve( content_ids.size() );
+   for( const auto& content_id : content_ids )
+      result.push_back( content_vote_count_index->get_vote_count( content_id ) );
+   return result;
+}
+
+vector<graphene::content_cards::content_card_version> database_api::get_content_card_history(
+      const content_card_v2_id_type content_card_id, uint32_t limit ) const
+{
+   return my->get_content_card_history( content_card_id, limit );
+}
+
+vector<graphene::content_cards::content_card_version> database_api_impl::get_content_card_history(
+      const content_card_v2_id_type content_card_id, uint32_t limit ) const
+{
+   // content_cards plugin is required for accessing the version index
+   FC_ASSERT( content_card_version_index != nullptr,
+              "This api is switched off because content_cards plugin does not keep the history" );
+   FC_ASSERT( _app_options, "Internal error" );
+   const auto configured_limit = _app_options->api_limit_get_content_cards;
+   FC_ASSERT( limit <= configured_limit,
+              "limit can not be greater than ${configured_limit}",
+              ("configured_limit", configured_limit) );
+
+   vector<graphene::content_cards::content_card_version> result;
+   const content_card_v2_object* card = _db.find( content_card_id );
+   if( card == nullptr || limit == 0 )
+      return result;
+
+   // prior versions are rebuilt from the current one, newest first
+   const auto& idx = content_card_version_index->indices().get<graphene::content_cards::by_card>();
+   const auto first = idx.lower_bound( boost::make_tuple( content_card_id ) );
+   auto itr = idx.upper_bound( boost::make_tuple( content_card_id ) );
+   graphene::content_cards::content_card_version version( *card );
+   version.version = ( itr == first ? 0 : std::prev( itr )->version ) + 1;
+   result.reserve( std::min<size_t>( limit, version.version ) );
+   result.push_back( version );
+   while( result.size() < limit && itr != first )
+   {
+      --itr;
+      version.revert( *itr );
+      result.push_back( version );
+   }
+   return result;
+}
+
+void database_api_impl::check_content_card_feed_query( uint32_t limit ) const
+{
+   // content_cards plugin is required for accessing the secondary index
+   FC_ASSERT( content_card_feed_index != nullptr,
+              "This api is switched off because content_cards plugin does not enabled" );
+   FC_ASSERT( _app_options, "Internal error" );
+   const auto configured_limit = _app_options->api_limit_get_content_cards;
+   FC_ASSERT( limit <= configured_limit,
+              "limit can not be greater than ${configured_limit}",
+              ("configured_limit", configured_limit) );
+}
+
+vector<content_card_v2_object> database_api_impl::get_content_cards_v2_by_ids(
+                                     const vector<content_card_v2_id_type>& ids ) const
+{
+   vector<content_card_v2_object> result;
+   result.reserve( ids.size() );
+   for( const auto& id : ids )
+      result.push_back( id(_db) );
+   return result;
+}
+
 fc::optional<permission_object> database_api::get_permission_by_id( const permission_id_type permission_id ) const
 {
    return my->get_permission_by_id(permission_id);
@@ -2754,7 +3673,7 @@ vector<permission_object> database_api_impl::get_permissions( const account_id_t
    auto itr = by_op_idx.lower_bound(boost::make_tuple(operator_account, permission_id));
 
    vector<permission_object> result;
-   while( itr->operator_account == operator_account && limit-- )
+   while( itr != by_op_idx.end() && itr->operator_account == operator_account && limit-- )
    {
       result.push_back(*itr);
       ++itr;
@@ -2763,16 +3682,105 @@ vector<permission_object> database_api_impl::get_permissions( const account_id_t
    return result;
 }
 
+vector<vector<permission_object>> database_api::get_permissions_by_accounts(
+      const vector<account_id_type>& operator_accounts, uint32_t limit ) const
+{
+   return my->get_permissions_by_accounts( operator_accounts, limit );
+}
+
+vector<vector<permission_object>> database_api_impl::get_permissions_by_accounts(
+      const vector<account_id_type>& operator_accounts, uint32_t limit ) const
+{
+   FC_ASSERT( _app_options, "Internal error" );
+   const auto configured_limit = _app_options->api_limit_get_permissions;
+   FC_ASSERT( limit <= configured_limit && operator_accounts.size() <= configured_limit,
+              "limit and number of querying accounts can not be greater than ${configured_limit}",
+              ("configured_limit", configured_limit) );
+
+   vector<vector<permission_object>> result;
+   result.reserve( operator_accounts.size() );
+   for( const auto& account : operator_accounts )
+   {
+      result.push_back( get_permissions( account, permission_id_type(), limit ) );
+      limit -= result.back().size();
+   }
+   return result;
+}
+
+vector<permission_object> database_api::get_permissions_by_object( const account_id_type operator_account,
+                                                                   const object_id_type object_id, uint32_t limit ) const
+{
+   return my->get_permissions_by_object( operator_account, object_id, limit );
+}
+
+vector<permission_object> database_api_impl::get_permissions_by_object( const account_id_type operator_account,
+                                                                        const object_id_type object_id,
+                                                                        uint32_t limit ) const
+{
+   // content_cards plugin is required for accessing the secondary index
+   FC_ASSERT( permission_lookup_index != nullptr,
+              "This api is switched off because content_cards plugin does not enabled" );
+   FC_ASSERT( _app_options, "Internal error" );
+   const auto configured_limit = _app_options->api_limit_get_permissions_by_object;
+   FC_ASSERT( limit <= configured_limit,
+              "limit can not be greater than ${configured_limit}",
+              ("configured_limit", configured_limit) );
+
+   const auto& perms = permission_lookup_index->get_permissions( operator_account, object_id );
+   vector<permission_object> result;
+   result.reserve( std::min<size_t>( perms.size(), limit ) );
+   for( const permission_object* perm : perms )
+   {
+      if( result.size() >= limit )
+         break;
+      result.push_back( *perm );
+   }
+   return result;
+}
+
 //////////////////////////////////////////////////////////////////////
 //                                                                  //
 // Private methods                                                  //
 //                                                                  //
 //////////////////////////////////////////////////////////////////////
 
+namespace {
+
+/// Parses a plain "space.type.instance" id of type ID, invalid if @p s is anything else
+template<typename ID>
+optional<ID> parse_object_id( const std::string& s )
+{
+   uint64_t parts[3] = { 0, 0, 0 };
+   size_t part = 0;
+   size_t digits = 0;
+   for( char c : s )
+   {
+      if( c == '.' )
+      {
+         if( digits == 0 || ++part > 2 )
+            return {};
+         digits = 0;
+      }
+      else if( c >= '0' && c <= '9' )
+      {
+         // at most 14 digits so that the instance fits into 48 bits
+         if( ++digits > 14 )
+            return {};
+         parts[part] = parts[part] * 10 + static_cast<uint64_t>( c - '0' );
+      }
+      else
+         return {};
+   }
+   if( part != 2 || digits == 0 || parts[0] != ID::space_id || parts[1] != ID::type_id )
+      return {};
+   return ID( parts[2] );
+}
+
+}
+
 const account_object* database_api_impl::get_account_from_string( const std::string& name_or_id,
                                                                   bool throw_if_not_found ) const
 {
-   // TODO cache the result to avoid repeatly fetching from db
    if( name_or_id.empty() )
    {
       if( throw_if_not_found )
@@ -2782,7 +3790,12 @@ const account_object* database_api_impl::get_account_from_string( const std::str
    }
    const account_object* account_ptr = nullptr;
    if( 0 != std::isdigit(name_or_id[0]) )
-      account_ptr = _db.find(fc::variant(name_or_id, 1).as<account_id_type>(1));
+   {
+      const auto id = parse_object_id<account_id_type>( name_or_id );
+      account_ptr = _db.find( id.valid() ? *id : fc::variant(name_or_id, 1).as<account_id_type>(1) );
+   }
+   else if( account_name_lookup_index )
+      account_ptr = account_name_lookup_index->find( name_or_id );
    else
    {
       const auto& idx = _db.get_index_type<account_index>().indices().get<by_name>();
@@ -2795,10 +3808,19 @@ const account_object* database_api_impl::get_account_from_string( const std::str
    return account_ptr;
 }
 
+vector<const account_object*> database_api_impl::get_accounts_from_strings( const vector<std::string>& names_or_ids,
+                                                                            bool throw_if_not_found ) const
+{
+   vector<const account_object*> result;
+   result.reserve( names_or_ids.size() );
+   for( const auto& name_or_id : names_or_ids )
+      result.push_back( get_account_from_string( name_or_id, throw_if_not_found ) );
+   return result;
+}
+
 const asset_object* database_api_impl::get_asset_from_string( const std::string& symbol_or_id,
                                                               bool throw_if_not_found ) const
 {
-   // TODO cache the result to avoid repeatly fetching from db
    if( symbol_or_id.empty() )
    {
       if( throw_if_not_found )
@@ -2808,7 +3830,12 @@ const asset_object* database_api_impl::get_asset_from_string( const std::string&
    }
    const asset_object* asset_ptr = nullptr;
    if( 0 != std::isdigit(symbol_or_id[0]) )
-      asset_ptr = _db.find(fc::variant(symbol_or_id, 1).as<asset_id_type>(1));
+   {
+      const auto id = parse_object_id<asset_id_type>( symbol_or_id );
+      asset_ptr = _db.find( id.valid() ? *id : fc::variant(symbol_or_id, 1).as<asset_id_type>(1) );
+   }
+   else if( asset_symbol_lookup_index )
+      asset_ptr = asset_symbol_lookup_index->find( symbol_or_id );
    else
    {
       const auto& idx = _db.get_index_type<asset_index>().indices().get<by_symbol>();
@@ -2878,16 +3905,6 @@ vector<limit_order_object> database_api_impl::get_limit_orders( const asset_id_t
    return result;
 }
 
-bool database_api_impl::is_impacted_account( const flat_set<account_id_type>& accounts)
-{
-   if( _subscribed_accounts.empty() || accounts.empty() )
-      return false;
-
-   return std::any_of(accounts.begin(), accounts.end(), [this](const account_id_type& account) {
-      return _subscribed_accounts.find(account) != _subscribed_accounts.end();
-   });
-}
-
 void database_api_impl::broadcast_updates( const vector<variant>& updates )
 {
    if( !updates.empty() && _subscribe_callback ) {
@@ -2915,97 +3932,51 @@ void database_api_impl::broadcast_market_updates( const market_queue_type& queue
    }
 }
 
-void database_api_impl::on_objects_removed( const vector<object_id_type>& ids,
-                                            const vector<const object*>& objs,
-                                            const flat_set<account_id_type>& impacted_accounts )
+void database_api_impl::notify_objects_changed( const vector<variant>& updates )
 {
-   handle_object_changed(_notify_remove_create, false, ids, impacted_accounts,
-      [objs](object_id_type id) -> const object* {
-         auto it = std::find_if(
-               objs.begin(), objs.end(),
-               [id](const object* o) {return o != nullptr && o->id == id;});
-
-         if (it != objs.end())
-            return *it;
-
-         return nullptr;
-      }
-   );
+   if( _subscribe_callback && !updates.empty() )
+      broadcast_updates( updates );
 }
 
-void database_api_impl::on_objects_new( const vector<object_id_type>& ids,
-                                        const flat_set<account_id_type>& impacted_accounts )
+void database_api_impl::notify_market_changes( bool full_object, const vector<object_id_type>& ids,
+                                               const std::function<const object*(object_id_type id)>& find_object )
 {
-   handle_object_changed(_notify_remove_create, true, ids, impacted_accounts,
-      std::bind(&object_database::find_object, &_db, std::placeholders::_1)
-   );
-}
+   if( _market_subscriptions.empty() )
+      return;
 
-void database_api_impl::on_objects_changed( const vector<object_id_type>& ids,
-                                            const flat_set<account_id_type>& impacted_accounts )
-{
-   handle_object_changed(false, true, ids, impacted_accounts,
-      std::bind(&object_database::find_object, &_db, std::placeholders::_1)
-   );
-}
+   market_queue_type broadcast_queue;
 
-void database_api_impl::handle_object_changed( bool force_notify,
-                                               bool full_object,
-                                               const vector<object_id_type>& ids,
-                                               const flat_set<account_id_type>& impacted_accounts,
-                                               std::function<const object*(object_id_type id)> find_object )
-{
-   if( _subscribe_callback )
+   for(auto id : ids)
    {
-      vector<variant> updates;
-
-      for(auto id : ids)
+      if( id.is<call_order_object>() )
       {
-         if( force_notify || is_subscribed_to_item(id) || is_impacted_account(impacted_accounts) )
-         {
-            if( full_object )
-            {
-               auto obj = find_object(id);
-               if( obj )
-               {
-                  updates.emplace_back( obj->to_variant() );
-               }
-            }
-            else
-            {
-               updates.emplace_back( fc::variant( id, 1 ) );
-            }
-         }
+         enqueue_if_subscribed_to_market<call_order_object>( find_object(id), broadcast_queue, full_object );
       }
-
-      if( !updates.empty() )
-         broadcast_updates(updates);
-   }
-
-   if( !_market_subscriptions.empty() )
-   {
-      market_queue_type broadcast_queue;
-
-      for(auto id : ids)
+      else if( id.is<limit_order_object>() )
       {
-         if( id.is<call_order_object>() )
-         {
-            enqueue_if_subscribed_to_market<call_order_object>( find_object(id), broadcast_queue, full_object );
-         }
-         else if( id.is<limit_order_object>() )
-         {
-            enqueue_if_subscribed_to_market<limit_order_object>( find_object(id), broadcast_queue, full_object );
-         }
-         else if( id.is<force_settlement_object>() )
-         {
-            enqueue_if_subscribed_to_market<force_settlement_object>( find_object(id), broadcast_queue,
-                                                                      full_object );
-         }
+         enqueue_if_subscribed_to_market<limit_order_object>( find_object(id), broadcast_queue, full_object );
+      }
+      else if( id.is<force_settlement_object>() )
+      {
+         enqueue_if_subscribed_to_market<force_settlement_object>( find_object(id), broadcast_queue,
+                                                                   full_object );
       }
-
-      if( !broadcast_queue.empty() )
-         broadcast_market_updates(broadcast_queue);
    }
+
+   if( !broadcast_queue.empty() )
+      broadcast_market_updates(broadcast_queue);
+}
+
+void database_api_impl::notify_content_events( const fc::variants& events )
+{
+   if( !_content_event_callback )
+      return;
+   /// we need to ensure the database_api is not deleted for the life of the async operation
+   auto capture_this = shared_from_this();
+   fc::async([this,capture_this,events](){
+      if( _content_event_callback )
+         _content_event_callback( fc::variant( events ) );
+   });
 }
 
 /** note: this method cannot yield because it is called in the middle of
@@ -25,7 +25,8 @@
 
 #include <graphene/app/database_api.hpp>
 
-#include <fc/bloom_filter.hpp>
+#include <unordered_map>
+#include <unordered_set>
 
 #define GET_REQUIRED_FEES_MAX_RECURSION 4
 
@@ -34,8 +35,205 @@ namespace graphene { namespace app {
 typedef std::map< std::pair<graphene::chain::asset_id_type, graphene::chain::asset_id_type>,
                   std::vector<fc::variant> > market_queue_type;
 
+class database_api_impl;
+
+/**
+ * @brief Dispatches object changes to the database API sessions which subscribed to them
+ *
+ * A single dispatcher serves all sessions of a database. It keeps a reverse index from subscribed objects and
+ * accounts to sessions, so that each changed object is looked up once, rather than once in every session. Changed
+ * objects are serialized once per notification and the result is shared by all sessions they are sent to.
+ *
+ * Must only be used on the thread which applies blocks.
+ */
+class subscription_dispatcher
+{
+   public:
+      explicit subscription_dispatcher( graphene::chain::database& db );
+
+      /// The dispatcher of @p db, created on first use and destroyed with the last session using it
+      static std::shared_ptr<subscription_dispatcher> get( graphene::chain::database& db );
+
+      void add_session( database_api_impl* session );
+      void remove_session( database_api_impl* session );
+
+      void subscribe_to_object( database_api_impl* session, const object_id_type& id );
+      void subscribe_to_account( database_api_impl* session, const account_id_type& account );
+      /// Drops the object and account subscriptions of @p session
+      void unsubscribe_all( database_api_impl* session, const std::unordered_set<uint64_t>& objects,
+                            const std::set<account_id_type>& accounts );
+
+      void subscribe_to_content_events( database_api_impl* session, const content_event_filter& filter );
+      void unsubscribe_from_content_events( database_api_impl* session, const content_event_filter& filter );
+
+      /**
+       * @brief The version of the objects relevant to an account
+       *
+       * Versions start at the time the dispatcher was created in microseconds, so that they still increase if the
+       * dispatcher is recreated, and are increased whenever an object relevant to the account changes. After
+       * switching to another fork, all accounts get a new version.
+       */
+      uint64_t get_account_version( const account_id_type& account )const;
+
+   private:
+      void dispatch( bool notify_remove_create,
+                     bool full_object,
+                     const vector<object_id_type>& ids,
+                     const flat_set<account_id_type>& impacted_accounts,
+                     const std::function<const object*(object_id_type id)>& find_object );
+      /// Sends the content operations of the applied block to the sessions with a matching filter
+      void dispatch_content_events();
+
+      graphene::chain::database& _db;
+
+      std::set<database_api_impl*>                                      _sessions;
+      /// Keyed by object_id_type::number
+      std::unordered_map<uint64_t, flat_set<database_api_impl*>>        _by_object;
+      std::map<account_id_type, flat_set<database_api_impl*>>           _by_account;
+
+      /// Sessions subscribed to content events, by the values in their filters
+      std::map<string, flat_set<database_api_impl*>>                    _content_by_type;
+      std::map<account_id_type, flat_set<database_api_impl*>>           _content_by_subject;
+      std::map<account_id_type, flat_set<database_api_impl*>>           _content_by_operator;
+      /// Sessions subscribed to all content events
+      flat_set<database_api_impl*>                                      _content_all;
+
+      /// Version of the accounts which did not change since then
+      uint64_t                                                          _base_version;
+      uint64_t                                                          _last_version;
+      std::unordered_map<uint64_t, uint64_t>                            _account_versions;
+      block_id_type                                                     _last_block_id;
+
+      boost::signals2::scoped_connection _applied_block_connection;
+      boost::signals2::scoped_connection _new_connection;
+      boost::signals2::scoped_connection _change_connection;
+      boost::signals2::scoped_connection _removed_connection;
+};
+
+/**
+ * @brief Results of market API calls for the current head block, shared by all database API sessions
+ *
+ * The market history and the order books only change with blocks and pending transactions, so results are reused
+ * until the head block changes or another transaction is pushed. Results for more than @ref max_entries different
+ * arguments per call are not cached.
+ *
+ * Must only be used on the thread which applies blocks.
+ */
+class market_result_cache
+{
+   public:
+      static constexpr size_t max_entries = 1000;
+
+      explicit market_result_cache( graphene::chain::database& db );
+
+      /// The cache of @p db, created on first use and destroyed with the last session using it
+      static std::shared_ptr<market_result_cache> get( graphene::chain::database& db );
+
+      template<typename Compute>
+      market_ticker get_ticker( const string& base, const string& quote, bool skip_order_book, Compute&& compute )
+      {
+         return get_or_compute( _tickers, std::make_tuple( base, quote, skip_order_book ),
+                                std::forward<Compute>( compute ) );
+      }
+
+      template<typename Compute>
+      order_book get_order_book( const string& base, const string& quote, unsigned limit, Compute&& compute )
+      {
+         return get_or_compute( _order_books, std::make_tuple( base, quote, limit ),
+                                std::forward<Compute>( compute ) );
+      }
+
+      /// A cached result for a higher limit is cut down rather than computed again
+      template<typename Compute>
+      vector<market_ticker> get_top_markets( uint32_t limit, Compute&& compute )
+      {
+         check_head_block();
+         auto itr = _top_markets.lower_bound( limit );
+         if( itr != _top_markets.end() )
+         {
+            const auto& markets = itr->second;
+            return vector<market_ticker>( markets.begin(),
+                                          markets.begin() + std::min<size_t>( limit, markets.size() ) );
+         }
+         return get_or_compute( _top_markets, limit, std::forward<Compute>( compute ) );
+      }
+
+   private:
+      /// Drops all results if the head block changed since they were computed
+      void check_head_block();
+      void clear();
+
+      template<typename Key, typename Value, typename Compute>
+      Value get_or_compute( std::map<Key, Value>& results, const Key& key, Compute&& compute )
+      {
+         check_head_block();
+         auto itr = results.find( key );
+         if( itr != results.end() )
+            return itr->second;
+         Value value = compute();
+         if( results.size() < max_entries )
+            results.emplace( key, value );
+         return value;
+      }
+
+      graphene::chain::database& _db;
+      block_id_type              _head_block_id;
+
+      std::map<std::tuple<string, string, bool>, market_ticker>   _tickers;
+      std::map<std::tuple<string, string, unsigned>, order_book>  _order_books;
+      std::map<uint32_t, vector<market_ticker>>                   _top_markets;
+
+      boost::signals2::scoped_connection _pending_trx_connection;
+};
+
+/**
+ * Results of get_required_fees() shared by all sessions of a database. Fees depend on the fee schedule and on
+ * core exchange rates, which can change with any block or pending transaction, so they are cached like the
+ * market results.
+ */
+class fee_result_cache
+{
+   public:
+      static constexpr size_t max_entries = 10000;
+
+      explicit fee_result_cache( graphene::chain::database& db );
+
+      /// The cache of @p db, created on first use and destroyed with the last session using it
+      static std::shared_ptr<fee_result_cache> get( graphene::chain::database& db );
+
+      template<typename Compute>
+      fc::variant get_fee( asset_id_type fee_asset, const operation& op, Compute&& compute )
+      {
+         const block_id_type head = _db.head_block_id();
+         if( head != _head_block_id )
+         {
+            _fees.clear();
+            _head_block_id = head;
+         }
+         auto key = std::make_pair( fee_asset, fc::raw::pack( op ) );
+         auto itr = _fees.find( key );
+         if( itr != _fees.end() )
+            return itr->second;
+         fc::variant value = compute();
+         if( _fees.size() < max_entries )
+            _fees.emplace( std::move( key ), value );
+         return value;
+      }
+
+   private:
+      graphene::chain::database& _db;
+      block_id_type              _head_block_id;
+
+      /// Fees by fee asset and serialized operation
+      std::map<std::pair<asset_id_type, vector<char>>, fc::variant> _fees;
+
+      boost::signals2::scoped_connection _pending_trx_connection;
+};
+
 class database_api_impl : public std::enable_shared_from_this<database_api_impl>
 {
+   friend class subscription_dispatcher;
+
    public:
       explicit database_api_impl( graphene::chain::database& db, const application_options* app_options );
       virtual ~database_api_impl();
@@ -56,6 +254,8 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       optional<signed_block> get_block(uint32_t block_num)const;
       processed_transaction get_transaction( uint32_t block_num, uint32_t trx_in_block )const;
       optional<signed_transaction> get_recent_transaction_by_id(const transaction_id_type& id )const;
+      optional<block_state_hash> get_block_state_hash( uint32_t block_num )const;
+      vector<string> get_packed_state_deltas( uint32_t block_num_from, uint32_t limit )const;
 
       // Globals
       chain_property_object get_chain_properties()const;
@@ -71,8 +271,11 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
 
       // Accounts
       account_id_type get_account_id_from_string(const std::string& name_or_id)const;
+      vector<optional<account_id_type>> get_account_ids_from_strings( const vector<std::string>& names_or_ids )const;
       vector<optional<account_object>> get_accounts( const vector<std::string>& account_names_or_ids,
                                                      optional<bool> subscribe )const;
+      std::map<string,versioned_full_account> get_changed_full_accounts(
+            const std::map<string, uint64_t>& known_versions, optional<bool> subscribe );
       std::map<string,full_account> get_full_accounts( const vector<string>& names_or_ids,
                                                        optional<bool> subscribe );
       optional<account_object> get_account_by_name( string name )const;
@@ -81,6 +284,7 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       map<string,account_id_type> lookup_accounts( const string& lower_bound_name,
                                                    uint32_t limit,
                                                    optional<bool> subscribe )const;
+      map<string,account_id_type> search_accounts( const string& prefix, uint32_t limit )const;
       uint64_t get_account_count()const;
 
       // Balances
@@ -90,6 +294,8 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       vector<balance_object> get_balance_objects( const vector<address>& addrs )const;
       vector<asset> get_vested_balances( const vector<balance_id_type>& objs )const;
       vector<vesting_balance_object> get_vesting_balances( const std::string account_id_or_name )const;
+      vector<vector<extended_vesting_balance_object>> get_withdrawable_vesting_balances(
+            const vector<std::string>& account_names_or_ids )const;
 
       // Assets
       uint64_t get_asset_count()const;
@@ -97,6 +303,7 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       vector<optional<extended_asset_object>> get_assets( const vector<std::string>& asset_symbols_or_ids,
                                                           optional<bool> subscribe )const;
       vector<extended_asset_object>           list_assets(const string& lower_bound_symbol, uint32_t limit)const;
+      map<string,asset_id_type>               search_asset_symbols( const string& prefix, uint32_t limit )const;
       vector<optional<extended_asset_object>> lookup_asset_symbols(const vector<string>& symbols_or_ids)const;
       vector<extended_asset_object>           get_assets_by_issuer(const std::string& issuer_name_or_id,
                                                                    asset_id_type start, uint32_t limit)const;
@@ -125,6 +332,10 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
                                 const std::string& a, const std::string& b );
       void unsubscribe_from_market(const std::string& a, const std::string& b);
 
+      void subscribe_to_content_events( std::function<void(const variant&)> callback,
+                                        const content_event_filter& filter );
+      void unsubscribe_from_content_events();
+
       market_ticker                      get_ticker( const string& base, const string& quote,
                                                      bool skip_order_book = false )const;
       market_volume                      get_24_volume( const string& base, const string& quote )const;
@@ -175,6 +386,8 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       processed_transaction validate_transaction( const signed_transaction& trx )const;
       vector< fc::variant > get_required_fees( const vector<operation>& ops,
                                                const std::string& asset_id_or_symbol )const;
+      vector< vector< fc::variant > > get_required_fees_in_assets( const vector<operation>& ops,
+                                                                   const vector<std::string>& assets_id_or_symbol )const;
 
       // Proposed transactions
       vector<proposal_object> get_proposed_transactions( const std::string account_id_or_name )const;
@@ -201,22 +414,48 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
 
       // RevPop personal data
       vector<personal_data_object> get_personal_data( const account_id_type subject_account,
-                                                      const account_id_type operator_account ) const;
+                                                      const account_id_type operator_account,
+                                                      optional<personal_data_id_type> start_id,
+                                                      optional<uint32_t> limit ) const;
       fc::optional<personal_data_object> get_last_personal_data( const account_id_type subject_account,
                                                                  const account_id_type operator_account ) const;
       vector<personal_data_v2_object> get_personal_data_v2( const account_id_type subject_account,
-                                                      const account_id_type operator_account ) const;
+                                                      const account_id_type operator_account,
+                                                      optional<personal_data_v2_id_type> start_id,
+                                                      optional<uint32_t> limit ) const;
       fc::optional<personal_data_v2_object> get_last_personal_data_v2( const account_id_type subject_account,
                                                                  const account_id_type operator_account ) const;
+      vector<vector<personal_data_v2_object>> get_personal_data_v2_by_accounts(
+            const vector<std::pair<account_id_type, account_id_type>>& account_pairs, uint32_t limit ) const;
+      optional<graphene::api_helper_indexes::personal_data_proof> get_personal_data_proof(
+            const account_id_type subject_account, const account_id_type operator_account,
+            const string& hash ) const;
       fc::optional<content_card_object> get_content_card_by_id( const content_card_id_type content_id ) const;
       vector<content_card_object> get_content_cards( const account_id_type subject_account,
                                                      const content_card_id_type content_id, uint32_t limit ) const;
       fc::optional<content_card_v2_object> get_content_card_v2_by_id( const content_card_v2_id_type content_id ) const;
       vector<content_card_v2_object> get_content_cards_v2( const account_id_type subject_account,
                                                      const content_card_v2_id_type content_id, uint32_t limit ) const;
+      vector<vector<content_card_v2_object>> get_content_cards_v2_by_accounts(
+            const vector<account_id_type>& subject_accounts, uint32_t limit ) const;
+      vector<content_card_v2_object> get_content_cards_v2_by_type( const string& type,
+                                                                   fc::time_point_sec from, fc::time_point_sec to,
+                                                                   uint32_t limit ) const;
+      vector<content_card_v2_object> get_content_cards_v2_by_time( const account_id_type subject_account,
+                                                                   fc::time_point_sec from, fc::time_point_sec to,
+                                                                   uint32_t limit ) const;
+      vector<content_card_v2_id_type> search_content_cards( const string& query, uint32_t limit ) const;
+      vector<graphene::content_cards::content_vote_count> get_content_vote_counts(
+            const vector<string>& content_ids ) const;
+      vector<graphene::content_cards::content_card_version> get_content_card_history(
+            const content_card_v2_id_type content_card_id, uint32_t limit ) const;
       fc::optional<permission_object> get_permission_by_id( const permission_id_type permission_id ) const;
       vector<permission_object> get_permissions( const account_id_type operator_account,
                                                  const permission_id_type permission_id, uint32_t limit ) const;
+      vector<vector<permission_object>> get_permissions_by_accounts(
+            const vector<account_id_type>& operator_accounts, uint32_t limit ) const;
+      vector<permission_object> get_permissions_by_object( const account_id_type operator_account,
+                                                           const object_id_type object_id, uint32_t limit ) const;
 
       ////////////////////////////////////////////////
       // Accounts
@@ -224,6 +463,10 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
 
       const account_object* get_account_from_string( const std::string& name_or_id,
                                                      bool throw_if_not_found = true ) const;
+      full_account get_full_account( const account_object& account )const;
+      /// Resolves a batch of names or IDs, results are in the order of @p names_or_ids
+      vector<const account_object*> get_accounts_from_strings( const vector<std::string>& names_or_ids,
+                                                               bool throw_if_not_found = true ) const;
 
       ////////////////////////////////////////////////
       // Assets
@@ -276,40 +519,30 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       //   For example, both `account_id_type a=1.2.0` and `asset_id_type b=1.3.0` will become `0` after packed.
       //   In order to avoid collision, we don't use a template function here, instead, we implicitly convert all
       //   object IDs to `object_id_type` when subscribing.
-      //
-      //   If need to subscribe to other data types, override this function with the types as parameter.
-      //   For example, we had a `get_subscription_key( const public_key_type& item )` function here, which was
-      //   removed lately since we no longer subscribe to public keys.
-      vector<char> get_subscription_key( const object_id_type& item )const
-      {
-         return fc::raw::pack(item);
-      }
-
-      template<typename T>
-      void subscribe_to_item( const T& item )const
+      void subscribe_to_item( const object_id_type& item )const
       {
          if( !_subscribe_callback )
             return;
 
-         vector<char> key = get_subscription_key( item );
-         if( !_subscribe_filter.contains( key.data(), key.size() ) )
-         {
-            _subscribe_filter.insert( key.data(), key.size() );
-         }
+         if( _subscribed_objects.size() >= max_subscribed_objects )
+            return;
+         if( _subscribed_objects.insert( item.number ).second )
+            _dispatcher->subscribe_to_object( const_cast<database_api_impl*>( this ), item );
       }
 
-      template<typename T>
-      bool is_subscribed_to_item( const T& item )const
+      bool is_subscribed_to_item( const object_id_type& item )const
       {
          if( !_subscribe_callback )
             return false;
 
-         vector<char> key = get_subscription_key( item );
-         return _subscribe_filter.contains( key.data(), key.size() );
+         return _subscribed_objects.find( item.number ) != _subscribed_objects.end();
       }
 
-      // for full-account subscription
-      bool is_impacted_account( const flat_set<account_id_type>& accounts );
+      void subscribe_to_account( const account_id_type& account )
+      {
+         if( _subscribed_accounts.insert( account ).second )
+            _dispatcher->subscribe_to_account( this, account );
+      }
 
       // for market subscription
       template<typename T>
@@ -344,18 +577,14 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
 
       void broadcast_updates( const vector<variant>& updates );
       void broadcast_market_updates( const market_queue_type& queue);
-      void handle_object_changed( bool force_notify,
-                                  bool full_object,
-                                  const vector<object_id_type>& ids,
-                                  const flat_set<account_id_type>& impacted_accounts,
-                                  std::function<const object*(object_id_type id)> find_object );
-
-      /** called every time a block is applied to report the objects that were changed */
-      void on_objects_new(const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts);
-      void on_objects_changed(const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts);
-      void on_objects_removed(const vector<object_id_type>& ids, const vector<const object*>& objs,
-                              const flat_set<account_id_type>& impacted_accounts);
+      /** called by the subscription dispatcher with the changed objects this session subscribed to */
+      void notify_objects_changed( const vector<variant>& updates );
+      /** called by the subscription dispatcher with all changed objects if this session subscribed to markets */
+      void notify_market_changes( bool full_object, const vector<object_id_type>& ids,
+                                  const std::function<const object*(object_id_type id)>& find_object );
       void on_applied_block();
+      /** called by the subscription dispatcher with the content operations of a block matching the filter */
+      void notify_content_events( const fc::variants& events );
 
       ////////////////////////////////////////////////
       // Member variables
@@ -364,25 +593,45 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       bool _notify_remove_create = false;
       bool _enabled_auto_subscription = true;
 
-      mutable fc::bloom_filter  _subscribe_filter;
-      std::set<account_id_type> _subscribed_accounts;
+      /// Same capacity the bloom filter used to be sized for
+      static constexpr size_t max_subscribed_objects = 10000;
+      /// Keyed by object_id_type::number
+      mutable std::unordered_set<uint64_t> _subscribed_objects;
+      std::set<account_id_type>            _subscribed_accounts;
+      std::shared_ptr<subscription_dispatcher> _dispatcher;
+      std::shared_ptr<market_result_cache>     _market_cache;
+      std::shared_ptr<fee_result_cache>        _fee_cache;
 
       std::function<void(const fc::variant&)> _subscribe_callback;
       std::function<void(const fc::variant&)> _pending_trx_callback;
       std::function<void(const fc::variant&)> _block_applied_callback;
 
-      boost::signals2::scoped_connection _new_connection;
-      boost::signals2::scoped_connection _change_connection;
-      boost::signals2::scoped_connection _removed_connection;
       boost::signals2::scoped_connection _applied_block_connection;
       boost::signals2::scoped_connection _pending_trx_connection;
 
       map< pair<asset_id_type,asset_id_type>, std::function<void(const variant&)> > _market_subscriptions;
 
+      /// Maximum number of types and accounts in a content event filter
+      static constexpr size_t max_content_event_filter_size = 1000;
+      std::function<void(const fc::variant&)> _content_event_callback;
+      content_event_filter                    _content_event_filter;
+
       graphene::chain::database& _db;
       const application_options* _app_options = nullptr;
 
       const graphene::api_helper_indexes::amount_in_collateral_index* amount_in_collateral_index;
+      const graphene::api_helper_indexes::account_name_lookup_index* account_name_lookup_index = nullptr;
+      const graphene::api_helper_indexes::asset_symbol_lookup_index* asset_symbol_lookup_index = nullptr;
+      const graphene::api_helper_indexes::personal_data_merkle_index* personal_data_merkle_index = nullptr;
+      const graphene::api_helper_indexes::order_book_level_index* order_book_level_index = nullptr;
+      const graphene::content_cards::content_card_feed_index* content_card_feed_index = nullptr;
+      const graphene::content_cards::content_card_search_index* content_card_search_index = nullptr;
+      const graphene::content_cards::content_vote_count_index* content_vote_count_index = nullptr;
+      const graphene::content_cards::permission_lookup_index* permission_lookup_index = nullptr;
+      const graphene::content_cards::content_card_version_index* content_card_version_index = nullptr;
+
+      vector<content_card_v2_object> get_content_cards_v2_by_ids( const vector<content_card_v2_id_type>& ids ) const;
+      void check_content_card_feed_query( uint32_t limit ) const;
 };
 
 } } // graphene::app
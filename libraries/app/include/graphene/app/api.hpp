@@ -23,18 +23,23 @@
  */
 #pragma once
 
+#include <graphene/app/api_metrics.hpp>
 #include <graphene/app/database_api.hpp>
 
 #include <graphene/protocol/types.hpp>
 #include <graphene/protocol/confidential.hpp>
 
+#include <graphene/db/task_pool.hpp>
+
 #include <graphene/market_history/market_history_plugin.hpp>
 #include <graphene/grouped_orders/grouped_orders_plugin.hpp>
+#include <graphene/content_cards/content_cards.hpp>
 #include <graphene/custom_operations/custom_operations_plugin.hpp>
 
 #include <graphene/elasticsearch/elasticsearch_plugin.hpp>
 
 #include <graphene/debug_witness/debug_api.hpp>
+#include <graphene/witness/witness_api.hpp>
 
 #include <graphene/net/node.hpp>
 
@@ -50,6 +55,10 @@
 #include <string>
 #include <vector>
 
+namespace graphene { namespace api_helper_indexes {
+   class asset_holders_count_index;
+} }
+
 namespace graphene { namespace app {
    using namespace graphene::chain;
    using namespace graphene::market_history;
@@ -114,6 +123,14 @@ namespace graphene { namespace app {
       share_type    total_for_sale; ///< total amount of asset for sale, asset id is min_price.base.asset_id
    };
 
+   struct grouped_order_book
+   {
+      string                        base;
+      string                        quote;
+      vector< limit_order_group >   bids; ///< groups of orders selling quote asset, best first
+      vector< limit_order_group >   asks; ///< groups of orders selling base asset, best first
+   };
+
    /**
     * @brief The history_api class implements the RPC API for account history
     *
@@ -229,9 +246,28 @@ namespace graphene { namespace app {
    /**
     * @brief Block api
     */
+   /**
+    * @brief The proof that a transaction is included in a block, see @ref block_api::get_transaction_inclusion_proof
+    *
+    * The transaction is included if header.transaction_merkle_root equals proof.calculate_merkle_root() of its
+    * merkle digest.
+    */
+   struct transaction_inclusion_proof
+   {
+      signed_block_header              header;
+      /// The merkle digest of the transaction
+      digest_type                      leaf;
+      graphene::protocol::merkle_proof proof;
+   };
+
+   class merkle_tree_cache;
+
    class block_api
    {
    public:
+      /// Maximum number of headers returned by @ref get_block_headers
+      static constexpr uint32_t max_block_headers = 1000;
+
       block_api(graphene::chain::database& db);
       ~block_api();
 
@@ -243,8 +279,54 @@ namespace graphene { namespace app {
           */
       vector<optional<signed_block>> get_blocks(uint32_t block_num_from, uint32_t block_num_to)const;
 
+      /**
+          * @brief Get signed blocks in their binary serialization
+          * @param block_num_from The lowest block number
+          * @param block_num_to The highest block number
+          * @return The hex encoded fc::raw serialization of the blocks from block_num_from till block_num_to,
+          *         null for unknown blocks
+          *
+          * Stored blocks are returned as they are read from the block log, without decoding them.
+          */
+      vector<optional<string>> get_packed_blocks(uint32_t block_num_from, uint32_t block_num_to)const;
+
+      /**
+          * @brief Get the headers of signed blocks, e.g. for light clients following the chain
+          * @param block_num_from The lowest block number
+          * @param block_num_to The highest block number, at most @ref max_block_headers blocks after block_num_from
+          * @return The headers of the blocks from block_num_from till block_num_to, null for unknown blocks
+          *
+          * Headers are read from the stored blocks without decoding their transactions.
+          */
+      vector<optional<signed_block_header>> get_block_headers(uint32_t block_num_from, uint32_t block_num_to)const;
+
+      /**
+          * @brief Get the proof that a transaction is included in a block
+          * @param block_num The number of the block
+          * @param trx_in_block The position of the transaction in the block
+          * @return The header of the block and the merkle branch of the transaction, null for unknown blocks
+          *
+          * The merkle trees of recently requested blocks are cached, so that proofs of further transactions of a
+          * block are looked up rather than computed.
+          */
+      optional<transaction_inclusion_proof> get_transaction_inclusion_proof(uint32_t block_num,
+                                                                            uint32_t trx_in_block)const;
+
+      /**
+          * @brief Get the counters of the cache of decoded blocks
+          * @return Hits, misses and the number of cached blocks
+          */
+      graphene::chain::block_cache_stats get_block_cache_stats()const;
+
+      /**
+          * @brief Get the counters of the cache of public keys recovered from transaction signatures
+          * @return Hits, misses and the number of cached keys
+          */
+      graphene::chain::signature_cache_stats get_signature_cache_stats()const;
+
    private:
       graphene::chain::database& _db;
+      std::shared_ptr<merkle_tree_cache> _merkle_trees;
    };
 
 
@@ -264,7 +346,16 @@ namespace graphene { namespace app {
             processed_transaction trx;
          };
 
+         /// The outcome of a transaction of broadcast_transactions()
+         struct transaction_result
+         {
+            transaction_id_type   id;
+            bool                  accepted = false;
+            string                error; ///< why the transaction was not accepted
+         };
+
          typedef std::function<void(variant/*transaction_confirmation*/)> confirmation_callback;
+         typedef std::function<void(variant/*vector<transaction_confirmation>*/)> block_confirmation_callback;
 
          /**
           * @brief Broadcast a transaction to the network
@@ -290,6 +381,26 @@ namespace graphene { namespace app {
           */
          fc::variant broadcast_transaction_synchronous(const precomputable_transaction& trx);
 
+         /**
+          * @brief Broadcast many transactions to the network
+          * @param trxs the transactions, they are applied in the given order
+          * @return for each transaction whether it was accepted, a rejected transaction does not stop the others
+          *
+          * The signatures of all transactions are checked in parallel off the main thread, then the transactions
+          * are checked for validity in the local database and broadcast one after another without interruption.
+          */
+         vector<transaction_result> broadcast_transactions( const vector<precomputable_transaction>& trxs );
+
+         /** This version of broadcast_transactions registers a callback method that will be called once for each
+          * block which includes accepted transactions of the batch, with the confirmations of those transactions.
+          * Transactions which expire without being included are forgotten.
+          * @param cb the callback method
+          * @param trxs the transactions
+          * @return for each transaction whether it was accepted
+          */
+         vector<transaction_result> broadcast_transactions_with_callback( block_confirmation_callback cb,
+                                                                          const vector<precomputable_transaction>& trxs );
+
          /**
           * @brief Broadcast a signed block to the network
           * @param block The signed block to broadcast
@@ -306,8 +417,16 @@ namespace graphene { namespace app {
           */
          void on_applied_block( const signed_block& b );
       private:
+         /// A batch of transactions waiting to be included
+         struct pending_batch
+         {
+            block_confirmation_callback callback;
+            fc::time_point_sec          expiration; ///< of the last expiring transaction
+         };
+
          boost::signals2::scoped_connection             _applied_block_connection;
          map<transaction_id_type,confirmation_callback> _callbacks;
+         map<transaction_id_type,std::shared_ptr<pending_batch>> _batch_callbacks;
          application&                                   _app;
    };
 
@@ -353,6 +472,13 @@ namespace graphene { namespace app {
           */
          std::vector<net::potential_peer_record> get_potential_peers() const;
 
+         /**
+          * @brief Get bandwidth usage, per message type traffic of the current connections and the time
+          *        spent applying blocks while syncing
+          * @note Per peer traffic, queue depths and latencies are reported by @ref get_connected_peers
+          */
+         fc::variant_object get_network_usage_stats() const;
+
       private:
          application& _app;
    };
@@ -463,9 +589,21 @@ namespace graphene { namespace app {
           * @param start The start index
           * @param limit Maximum limit must not exceed 100
           * @return A list of asset holders for the specified asset
+          * @note Skipping to @p start takes time linear in @p start, use @ref get_asset_holders_after for paging
           */
          vector<account_asset_balance> get_asset_holders( std::string asset, uint32_t start, uint32_t limit  )const;
 
+         /**
+          * @brief Get the asset holders which follow a given holder, by descending balance and then account ID
+          * @param asset The specific asset id or symbol
+          * @param last_amount The balance of the last holder of the previous page
+          * @param last_account The account of the last holder of the previous page
+          * @param limit Maximum limit must not exceed api_limit_get_asset_holders
+          * @return The next page of asset holders, the first page is returned by @ref get_asset_holders
+          */
+         vector<account_asset_balance> get_asset_holders_after( std::string asset, share_type last_amount,
+                                                                account_id_type last_account, uint32_t limit )const;
+
          /**
           * @brief Get asset holders count for a specific asset
           * @param asset The specific asset id or symbol
@@ -480,9 +618,14 @@ namespace graphene { namespace app {
          vector<asset_holders> get_all_asset_holders() const;
 
       private:
+         /// Number of accounts with a non-zero balance of @p asset_id
+         uint64_t count_holders( asset_id_type asset_id )const;
+
          graphene::app::application& _app;
          graphene::chain::database& _db;
          graphene::app::database_api database_api;
+         /// Holder counts kept by the api_helper_indexes plugin, nullptr if it is not enabled
+         const graphene::api_helper_indexes::asset_holders_count_index* _holders_count_index = nullptr;
    };
 
    /**
@@ -517,6 +660,21 @@ namespace graphene { namespace app {
                                                                optional<price> start,
                                                                uint32_t limit )const;
 
+         /**
+          * @brief Get the best grouped limit orders of both sides of many markets.
+          *
+          * @param markets pairs of symbols or IDs of the base and quote assets of the markets
+          * @param group Maximum price diff within each order group, have to be one of configured values
+          * @param limit Maximum number of order groups to retrieve on each side of each market
+          *              (must not exceed the limit of @ref get_grouped_limit_orders)
+          * @return The grouped order books, in the same order as @p markets
+          *
+          * @note The number of markets must not exceed the configured api-limit-get-grouped-order-books.
+          */
+         vector< grouped_order_book > get_grouped_order_books( vector< std::pair<std::string, std::string> > markets,
+                                                               uint16_t group,
+                                                               uint32_t limit )const;
+
       private:
          application& _app;
          graphene::app::database_api database_api;
@@ -542,10 +700,121 @@ namespace graphene { namespace app {
           */
          vector<account_storage_object> get_storage_info(std::string account_name_or_id, std::string catalog)const;
 
+         /**
+          * @brief Get stored objects of an account in a catalog whose keys start with a prefix
+          *
+          * @param account_name_or_id The account name or ID to get info from
+          * @param catalog Category classification
+          * @param key_prefix Prefix of the keys to return, empty for all keys of the catalog
+          * @param start_key First key to return, for paging pass the key after the last one returned
+          * @param limit Maximum number of objects to return
+          *
+          * @return The objects sorted by key
+          */
+         vector<account_storage_object> get_storage_range(std::string account_name_or_id, std::string catalog,
+                                                          std::string key_prefix, std::string start_key,
+                                                          uint32_t limit)const;
+
    private:
          application& _app;
          graphene::app::database_api database_api;
    };
+
+   /**
+    * @brief The content_cards_api class serves content from the content store of the content_cards_plugin
+    */
+   class content_cards_api
+   {
+      public:
+         /// Maximum number of bytes returned by one read_content call
+         static constexpr uint32_t max_read_size = 1024 * 1024;
+
+         content_cards_api(application& app):_app(app){}
+
+         /**
+          * @brief Get the size of stored content
+          * @param hash The hash of the content, as in content cards
+          * @return The size in bytes, or empty if the content is not stored on this node
+          */
+         optional<uint64_t> get_content_size( const std::string& hash )const;
+
+         /**
+          * @brief Read a range of stored content
+          * @param hash The hash of the content, as in content cards
+          * @param offset Position of the first byte to read
+          * @param size Number of bytes to read, may not exceed @ref max_read_size
+          * @return The bytes read, fewer than @p size at the end of the content
+          */
+         vector<char> read_content( const std::string& hash, uint64_t offset, uint32_t size )const;
+
+   private:
+         const graphene::content_cards::content_store& get_store()const;
+
+         application& _app;
+   };
+
+   /**
+    * @brief The metrics_api class exposes statistics of the API calls served by this node and of its memory use
+    *
+    * API call statistics are only collected if the node runs with @a enable-api-metrics.
+    */
+   class metrics_api
+   {
+      public:
+         metrics_api( application& app ) : _app( app ) {}
+
+         /**
+          * @brief Get the call statistics of API methods
+          * @return For each API method and api-access user which made calls, the number of calls and errors and
+          *         the latencies, sorted by API, method and user
+          */
+         vector<api_method_metrics> get_api_metrics()const;
+
+         /// @brief Clear the collected statistics
+         void reset_api_metrics();
+
+         /**
+          * @brief Estimate the memory used by the object indexes of the chain database
+          * @return For each index, the number of objects and their estimated memory use, largest first
+          * @note This walks all objects of the database and blocks the node for a while on a large database
+          */
+         vector<graphene::db::index_memory_stats> get_index_memory_stats()const;
+
+         /**
+          * @brief Get the time spent applying blocks, if the node runs with enable-apply-timing
+          * @return Count, total and histogram of durations per operation type, of transactions and of
+          *         the applied_block handlers of plugins
+          */
+         graphene::chain::apply_timing_report get_apply_timing()const;
+
+         /// @brief Clear the collected apply timing
+         void reset_apply_timing();
+
+         /**
+          * @brief Get the state of the plugins which handle applied blocks on their own thread
+          * @return Queue size and the last queued and handled block per handler, the difference is how far
+          *         a plugin lags behind the chain
+          */
+         vector<graphene::chain::async_block_handler_stats> get_async_block_handler_stats()const;
+
+         /**
+          * @brief Get the state of the threads which run the parallel work of the chain
+          * @return Busy threads, and per priority the queued tasks and the wait and run times of completed tasks
+          */
+         graphene::db::task_pool_stats get_task_pool_stats()const;
+
+         /// @brief Clear the wait and run times of completed tasks
+         void reset_task_pool_stats();
+
+         /**
+          * @brief Get the time the node spent starting up
+          * @return The phases of the startup in the order they ran, with the time spent in each
+          */
+         vector<startup_phase_timing> get_startup_timing()const;
+
+      private:
+         application& _app;
+   };
 } } // graphene::app
 
 extern template class fc::api<graphene::app::block_api>;
@@ -556,7 +825,10 @@ extern template class fc::api<graphene::app::crypto_api>;
 extern template class fc::api<graphene::app::asset_api>;
 extern template class fc::api<graphene::app::orders_api>;
 extern template class fc::api<graphene::debug_witness::debug_api>;
+extern template class fc::api<graphene::witness_plugin::witness_api>;
 extern template class fc::api<graphene::app::custom_operations_api>;
+extern template class fc::api<graphene::app::content_cards_api>;
+extern template class fc::api<graphene::app::metrics_api>;
 
 namespace graphene { namespace app {
    /**
@@ -598,12 +870,26 @@ namespace graphene { namespace app {
          fc::api<orders_api> orders()const;
          /// @brief Retrieve the debug API (if available)
          fc::api<graphene::debug_witness::debug_api> debug()const;
+         /// @brief Retrieve the witness API (if available)
+         fc::api<graphene::witness_plugin::witness_api> witness()const;
          /// @brief Retrieve the custom operations API
          fc::api<custom_operations_api> custom_operations()const;
+         /// @brief Retrieve the content cards API
+         fc::api<content_cards_api> content_cards()const;
+         /// @brief Retrieve the metrics API
+         fc::api<metrics_api> metrics()const;
 
          /// @brief Called to enable an API, not reflected.
          void enable_api( const string& api_name );
       private:
+         /// Records the calls to @p api in the API metrics and limits them by the budget, if enabled
+         template<typename Api>
+         void instrument( fc::api<Api>& api, const string& api_name )const;
+
+         /// The api-access user the APIs were enabled for
+         string _user;
+         /// Shared by all APIs of the connection, null if calls are not limited
+         std::shared_ptr<api_call_budget> _budget;
 
          application& _app;
          optional< fc::api<block_api> > _block_api;
@@ -615,7 +901,10 @@ namespace graphene { namespace app {
          optional< fc::api<asset_api> > _asset_api;
          optional< fc::api<orders_api> > _orders_api;
          optional< fc::api<graphene::debug_witness::debug_api> > _debug_api;
+         optional< fc::api<graphene::witness_plugin::witness_api> > _witness_api;
          optional< fc::api<custom_operations_api> > _custom_operations_api;
+         optional< fc::api<content_cards_api> > _content_cards_api;
+         optional< fc::api<metrics_api> > _metrics_api;
    };
 
 }}  // graphene::app
@@ -624,6 +913,9 @@ extern template class fc::api<graphene::app::login_api>;
 
 FC_REFLECT( graphene::app::network_broadcast_api::transaction_confirmation,
         (id)(block_num)(trx_num)(trx) )
+FC_REFLECT( graphene::app::network_broadcast_api::transaction_result,
+        (id)(accepted)(error) )
+FC_REFLECT( graphene::app::transaction_inclusion_proof, (header)(leaf)(proof) )
 FC_REFLECT( graphene::app::verify_range_result,
         (success)(min_val)(max_val) )
 FC_REFLECT( graphene::app::verify_range_proof_rewind_result,
@@ -632,6 +924,8 @@ FC_REFLECT( graphene::app::history_operation_detail,
             (total_count)(operation_history_objs) )
 FC_REFLECT( graphene::app::limit_order_group,
             (min_price)(max_price)(total_for_sale) )
+FC_REFLECT( graphene::app::grouped_order_book,
+            (base)(quote)(bids)(asks) )
 //FC_REFLECT_TYPENAME( fc::ecc::compact_signature )
 //FC_REFLECT_TYPENAME( fc::ecc::commitment_type )
 
@@ -649,11 +943,18 @@ FC_API(graphene::app::history_api,
      )
 FC_API(graphene::app::block_api,
        (get_blocks)
+       (get_packed_blocks)
+       (get_block_headers)
+       (get_transaction_inclusion_proof)
+       (get_block_cache_stats)
+       (get_signature_cache_stats)
      )
 FC_API(graphene::app::network_broadcast_api,
        (broadcast_transaction)
        (broadcast_transaction_with_callback)
        (broadcast_transaction_synchronous)
+       (broadcast_transactions)
+       (broadcast_transactions_with_callback)
        (broadcast_block)
      )
 FC_API(graphene::app::network_node_api,
@@ -663,6 +964,7 @@ FC_API(graphene::app::network_node_api,
        (get_potential_peers)
        (get_advanced_node_parameters)
        (set_advanced_node_parameters)
+       (get_network_usage_stats)
      )
 FC_API(graphene::app::crypto_api,
        (blind)
@@ -675,15 +977,33 @@ FC_API(graphene::app::crypto_api,
      )
 FC_API(graphene::app::asset_api,
        (get_asset_holders)
+       (get_asset_holders_after)
 	   (get_asset_holders_count)
        (get_all_asset_holders)
      )
 FC_API(graphene::app::orders_api,
        (get_tracked_groups)
        (get_grouped_limit_orders)
+       (get_grouped_order_books)
      )
 FC_API(graphene::app::custom_operations_api,
        (get_storage_info)
+       (get_storage_range)
+     )
+FC_API(graphene::app::content_cards_api,
+       (get_content_size)
+       (read_content)
+     )
+FC_API(graphene::app::metrics_api,
+       (get_api_metrics)
+       (reset_api_metrics)
+       (get_index_memory_stats)
+       (get_apply_timing)
+       (reset_apply_timing)
+       (get_async_block_handler_stats)
+       (get_task_pool_stats)
+       (reset_task_pool_stats)
+       (get_startup_timing)
      )
 FC_API(graphene::app::login_api,
        (login)
@@ -696,5 +1016,8 @@ FC_API(graphene::app::login_api,
        (asset)
        (orders)
        (debug)
+       (witness)
        (custom_operations)
+       (content_cards)
+       (metrics)
      )
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2022 Revolution Populi Limited, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <fc/reflect/reflect.hpp>
+#include <fc/time.hpp>
+
+#include <array>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace graphene { namespace app {
+
+   /// Call statistics of an API method for an api-access user
+   struct api_method_metrics
+   {
+      std::string api;
+      std::string method;
+      std::string user;
+      uint64_t    calls = 0;
+      uint64_t    errors = 0;             ///< calls which threw an exception
+      uint64_t    total_time_us = 0;
+      uint64_t    max_time_us = 0;
+      /// Number of calls by latency, bucket i counts calls up to latency_bucket_bounds_us[i], the last bucket
+      /// counts slower calls
+      std::vector<uint64_t> latency_histogram;
+   };
+
+   /**
+    * @brief Collects per-method statistics of API calls
+    *
+    * This class is thread-safe.
+    */
+   class api_metrics
+   {
+      public:
+         /// Upper bounds of the latency buckets in microseconds
+         static const std::array<uint64_t, 6>& latency_bucket_bounds_us();
+
+         void record( const std::string& api, const std::string& method, const std::string& user,
+                      uint64_t time_us, bool failed );
+
+         /// Statistics of all methods which were called, sorted by api, method and user
+         std::vector<api_method_metrics> get_metrics()const;
+
+         void reset();
+
+      private:
+         mutable std::mutex _mutex;
+         std::map<std::tuple<std::string, std::string, std::string>, api_method_metrics> _methods;
+   };
+
+   /**
+    * @brief A token bucket of API execution time
+    *
+    * The bucket is refilled continuously at a configured rate up to a maximum, calls are charged the time they
+    * took. A call is admitted as long as the bucket is not empty, so a single expensive call can overdraw it.
+    *
+    * This class is thread-safe.
+    */
+   class api_call_budget
+   {
+      public:
+         /**
+          * @param refill_us_per_second execution time granted per second, in microseconds
+          * @param max_us maximum execution time which can be accumulated, in microseconds
+          */
+         api_call_budget( uint64_t refill_us_per_second, uint64_t max_us );
+
+         /// @throws fc::exception if the budget is used up, with the time until calls are admitted again
+         void admit();
+
+         void charge( uint64_t time_us );
+
+         /// Execution time in microseconds which is currently available, negative if overdrawn
+         int64_t remaining_us();
+
+      private:
+         void refill();
+
+         const uint64_t _refill_us_per_second;
+         const int64_t  _max_us;
+         std::mutex     _mutex;
+         int64_t        _available_us;
+         fc::time_point _last_refill;
+   };
+
+   /// Records a call in the metrics and charges it to the budget when it goes out of scope, both are optional
+   class api_call_timer
+   {
+      public:
+         api_call_timer( api_metrics* metrics, api_call_budget* budget, const std::string& api,
+                         const std::string& method, const std::string& user )
+         : _metrics( metrics ), _budget( budget ), _api( api ), _method( method ), _user( user ),
+           _start( fc::time_point::now() ) {}
+
+         ~api_call_timer()
+         {
+            const uint64_t time_us = ( fc::time_point::now() - _start ).count();
+            if( _metrics )
+               _metrics->record( _api, _method, _user, time_us, _failed );
+            if( _budget )
+               _budget->charge( time_us );
+         }
+
+         void failed() { _failed = true; }
+
+      private:
+         api_metrics*         _metrics;
+         api_call_budget*     _budget;
+         const std::string&   _api;
+         const std::string&   _method;
+         const std::string&   _user;
+         const fc::time_point _start;
+         bool                 _failed = false;
+   };
+
+   /**
+    * @brief Visitor for the vtable of an fc::api which wraps all methods to record their calls in an api_metrics
+    *        and to admit them through an api_call_budget
+    *
+    * Either of them can be null. Must be applied before the API is registered with a connection.
+    */
+   class api_call_instrumenter
+   {
+      public:
+         api_call_instrumenter( std::shared_ptr<api_metrics> metrics, std::shared_ptr<api_call_budget> budget,
+                                std::string api, std::string user )
+         : _metrics( std::move( metrics ) ), _budget( std::move( budget ) ),
+           _api( std::move( api ) ), _user( std::move( user ) ) {}
+
+         template<typename R, typename... Args>
+         void operator()( const char* name, std::function<R(Args...)>& method )const
+         {
+            auto inner = method;
+            auto metrics = _metrics;
+            auto budget = _budget;
+            auto api = _api;
+            auto user = _user;
+            std::string method_name( name );
+            method = [inner, metrics, budget, api, user, method_name]( Args... args ) -> R {
+               if( budget )
+                  budget->admit();
+               api_call_timer timer( metrics.get(), budget.get(), api, method_name, user );
+               try
+               {
+                  return inner( args... );
+               }
+               catch( ... )
+               {
+                  timer.failed();
+                  throw;
+               }
+            };
+         }
+
+      private:
+         std::shared_ptr<api_metrics>     _metrics;
+         std::shared_ptr<api_call_budget> _budget;
+         std::string                      _api;
+         std::string                      _user;
+   };
+
+} } // graphene::app
+
+FC_REFLECT( graphene::app::api_method_metrics,
+            (api)(method)(user)(calls)(errors)(total_time_us)(max_time_us)(latency_histogram) )
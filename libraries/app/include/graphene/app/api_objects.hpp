@@ -32,6 +32,7 @@
 #include <graphene/chain/htlc_object.hpp>
 
 #include <graphene/api_helper_indexes/api_helper_indexes.hpp>
+#include <graphene/content_cards/content_cards.hpp>
 #include <graphene/market_history/market_history_plugin.hpp>
 
 #include <fc/optional.hpp>
@@ -78,6 +79,13 @@ namespace graphene { namespace app {
       more_data                        more_data_available;
    };
 
+   struct versioned_full_account
+   {
+      /// Increases whenever an object relevant to the account changes, pass it back to skip unchanged accounts
+      uint64_t                         version = 0;
+      full_account                     account;
+   };
+
    struct order
    {
       string                     price;
@@ -152,6 +160,31 @@ namespace graphene { namespace app {
       optional<share_type> total_backing_collateral;
    };
 
+   /// A vesting balance with the amount which can be withdrawn from it at the head block time
+   struct extended_vesting_balance_object : vesting_balance_object
+   {
+      extended_vesting_balance_object() {}
+      extended_vesting_balance_object( const vesting_balance_object& b, fc::time_point_sec now )
+      : vesting_balance_object( b ), allowed_withdraw( b.get_allowed_withdraw( now ) ) {}
+
+      asset allowed_withdraw;
+   };
+
+   /**
+    * Selects the content operations sent by @ref database_api::subscribe_to_content_events. An operation matches
+    * if any of the sets contains its type, subject account or operator account; an empty filter matches all
+    * content operations.
+    */
+   struct content_event_filter
+   {
+      /// content card types and permission types
+      flat_set<string>           types;
+      /// accounts owning the content cards, votes or permissions
+      flat_set<account_id_type>  subjects;
+      /// accounts which are granted permissions
+      flat_set<account_id_type>  operators;
+   };
+
 } }
 
 FC_REFLECT( graphene::app::more_data,
@@ -181,6 +214,8 @@ FC_REFLECT( graphene::app::full_account,
             (more_data_available)
           )
 
+FC_REFLECT( graphene::app::versioned_full_account, (version)(account) )
+
 FC_REFLECT( graphene::app::order, (price)(quote)(base) )
 FC_REFLECT( graphene::app::order_book, (base)(quote)(bids)(asks) )
 FC_REFLECT( graphene::app::market_ticker,
@@ -192,3 +227,6 @@ FC_REFLECT( graphene::app::market_trade, (sequence)(date)(price)(amount)(value)(
 
 FC_REFLECT_DERIVED( graphene::app::extended_asset_object, (graphene::chain::asset_object),
                     (total_in_collateral)(total_backing_collateral) )
+FC_REFLECT_DERIVED( graphene::app::extended_vesting_balance_object, (graphene::chain::vesting_balance_object),
+                    (allowed_withdraw) )
+FC_REFLECT( graphene::app::content_event_filter, (types)(subjects)(operators) )
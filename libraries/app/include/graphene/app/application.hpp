@@ -24,6 +24,7 @@
 #pragma once
 
 #include <graphene/app/api_access.hpp>
+#include <graphene/app/api_metrics.hpp>
 #include <graphene/net/node.hpp>
 #include <graphene/chain/database.hpp>
 
@@ -39,6 +40,11 @@ namespace graphene { namespace app {
    {
       public:
          bool enable_subscribe_to_all = false;
+         bool enable_api_metrics = false;
+         /// API execution time in milliseconds granted to each connection per second, 0 for no limit
+         uint64_t api_time_budget_per_second = 0;
+         /// Maximum API execution time in milliseconds a connection can accumulate
+         uint64_t api_time_budget_max = 5000;
 
          bool has_api_helper_indexes_plugin = false;
          bool has_market_history_plugin = false;
@@ -46,6 +52,7 @@ namespace graphene { namespace app {
          uint64_t api_limit_get_account_history_operations = 100;
          uint64_t api_limit_get_account_history = 100;
          uint64_t api_limit_get_grouped_limit_orders = 101;
+         uint64_t api_limit_get_grouped_order_books = 50;
          uint64_t api_limit_get_relative_account_history = 100;
          uint64_t api_limit_get_account_history_by_operations = 100;
          uint64_t api_limit_get_asset_holders = 100;
@@ -72,6 +79,12 @@ namespace graphene { namespace app {
          uint64_t api_limit_get_withdraw_permissions_by_giver = 101;
          uint64_t api_limit_get_withdraw_permissions_by_recipient = 101;
          uint64_t api_limit_get_tickets = 101;
+         uint64_t api_limit_get_personal_data = 100;
+         uint64_t api_limit_get_content_cards = 100;
+         uint64_t api_limit_get_content_vote_counts = 1000;
+         uint64_t api_limit_get_permissions_by_object = 100;
+         uint64_t api_limit_get_permissions = 100;
+         uint64_t api_limit_get_storage_range = 100;
 
          static const application_options& get_default()
          {
@@ -80,6 +93,13 @@ namespace graphene { namespace app {
          }
    };
 
+   /// Time spent in a phase of the node startup
+   struct startup_phase_timing
+   {
+      string   phase;
+      uint64_t duration_us = 0;
+   };
+
    class application
    {
       public:
@@ -143,12 +163,19 @@ namespace graphene { namespace app {
 
          const application_options& get_options();
 
+         /// Statistics of API calls, only collected if enabled in the options
+         std::shared_ptr<api_metrics> get_api_metrics()const;
+
+         /// Time spent in the phases of initialize() and startup(), in the order they ran
+         const vector<startup_phase_timing>& get_startup_timing()const;
+
+         /// @return the data directory passed to initialize()
+         const fc::path& data_dir()const;
+
          void enable_plugin( const string& name ) const;
 
          bool is_plugin_enabled(const string& name) const;
 
-         std::shared_ptr<fc::thread> elasticsearch_thread;
-
    private:
          /// Add an available plugin
          void add_available_plugin( std::shared_ptr<abstract_plugin> p ) const;
@@ -160,3 +187,5 @@ namespace graphene { namespace app {
    };
 
 } }
+
+FC_REFLECT( graphene::app::startup_phase_timing, (phase)(duration_us) )
@@ -74,6 +74,10 @@ class database_api_impl;
  * This API exposes accessors on the database which query state tracked by a blockchain validating node. This API is
  * read-only; all modifications to the database must be performed via transactions. Transactions are broadcast via
  * the @ref network_broadcast_api.
+ *
+ * The methods read the object database in place, without taking a snapshot, and the secondary indexes used by
+ * some of them are updated as blocks are applied. They must therefore run on the thread which applies blocks,
+ * concurrent calls from other threads are not supported.
  */
 class database_api
 {
@@ -197,6 +201,30 @@ class database_api
        */
       optional<signed_transaction> get_recent_transaction_by_id( const transaction_id_type& txid )const;
 
+      /**
+       * @brief Retrieve the hash of the chain state after a block was applied
+       * @param block_num height of the block
+       * @return the state hash of the block, or null if the node does not keep it (see the state-hash-blocks
+       *         option) or the block is too old
+       *
+       * Nodes with the same state hash for the same block ID have the same chain objects. If the state hashes
+       * differ, the hashes of the indexes tell which object types differ.
+       */
+      optional<block_state_hash> get_block_state_hash( uint32_t block_num )const;
+
+      /**
+       * @brief Retrieve the changes of the chain objects made by irreversible blocks, to follow this node
+       * @param block_num_from height of the first block
+       * @param limit maximum number of blocks, at most 100
+       * @return the packed @ref graphene::chain::state_delta of consecutive blocks from @p block_num_from on,
+       *         empty if the node does not write state deltas (see the state-delta-log option) or has none of
+       *         the block
+       *
+       * A node with the chain state at the block before @p block_num_from reaches the state of this node at the
+       * last returned block by applying the deltas, without validating the blocks.
+       */
+      vector<string> get_packed_state_deltas( uint32_t block_num_from, uint32_t limit )const;
+
       /////////////
       // Globals //
       /////////////
@@ -264,6 +292,16 @@ class database_api
        */
       account_id_type get_account_id_from_string(const std::string& name_or_id) const;
 
+      /**
+       * @brief Get account IDs from a list of names or IDs
+       * @param names_or_ids names or IDs of the accounts
+       * @return The IDs of the accounts in the order of @p names_or_ids, null for unknown accounts
+       *
+       * @note The number of names or IDs can not be greater than the configured value of
+       *       @a api_limit_lookup_accounts
+       */
+      vector<optional<account_id_type>> get_account_ids_from_strings( const vector<std::string>& names_or_ids )const;
+
       /**
        * @brief Get a list of accounts by names or IDs
        * @param account_names_or_ids names or IDs of the accounts to retrieve
@@ -293,6 +331,25 @@ class database_api
       std::map<string,full_account> get_full_accounts( const vector<string>& names_or_ids,
                                                        optional<bool> subscribe = optional<bool>() );
 
+      /**
+       * @brief Fetch all objects relevant to the specified accounts if they changed since a known version
+       * @param known_versions Map of the names or IDs of the accounts to the versions the caller already has,
+       *                       0 if it has none
+       * @param subscribe @a true to subscribe to the queried full account objects; @a false to not subscribe;
+       *                  @a null to subscribe or not subscribe according to current auto-subscription setting
+       *                  (see @ref set_auto_subscription)
+       * @return Map of string from @p known_versions to the current version and the full account, only for the
+       *         accounts which changed since the known version
+       *
+       * This works like @ref get_full_accounts, but skips the accounts for which no relevant object was created,
+       * changed or removed since the known version. Versions are specific to the node which returned them.
+       *
+       * @note Changes of objects which only refer to the account indirectly, e.g. the objects the account votes
+       *       for, do not change its version.
+       */
+      std::map<string,versioned_full_account> get_changed_full_accounts(
+            const std::map<string, uint64_t>& known_versions, optional<bool> subscribe = optional<bool>() );
+
       /**
        * @brief Get info of an account by name
        * @param name Name of the account to retrieve
@@ -332,6 +389,18 @@ class database_api
                                                    uint32_t limit,
                                                    optional<bool> subscribe = optional<bool>() )const;
 
+      /**
+       * @brief Get names and IDs of the accounts whose names start with a prefix, e.g. for autocompletion
+       * @param prefix the start of the names, upper case letters match the lower case ones of the names
+       * @param limit Maximum number of results to return -- must not exceed
+       *              @a api_limit_lookup_accounts
+       * @return Map of account names to corresponding IDs, the first names with the prefix in alphabetical order
+       *
+       * Unlike @ref lookup_accounts this stops at the last name with the prefix, so clients do not need to fetch
+       * and filter more names than they show.
+       */
+      map<string,account_id_type> search_accounts( const string& prefix, uint32_t limit )const;
+
       //////////////
       // Balances //
       //////////////
@@ -370,6 +439,15 @@ class database_api
        */
       vector<vesting_balance_object> get_vesting_balances( const std::string account_name_or_id )const;
 
+      /**
+       * @brief Return the vesting balance objects of several accounts with the amounts which can be withdrawn
+       * @param account_names_or_ids names or IDs of the accounts, at most as many as get_full_accounts accepts
+       * @return for each account, all vesting balance objects it owns with the amount which can be withdrawn
+       *         from them at the head block time
+       */
+      vector<vector<extended_vesting_balance_object>> get_withdrawable_vesting_balances(
+            const vector<std::string>& account_names_or_ids )const;
+
       /**
        * @brief Get the total number of accounts registered with the blockchain
        */
@@ -407,6 +485,14 @@ class database_api
        */
       vector<extended_asset_object> list_assets(const string& lower_bound_symbol, uint32_t limit)const;
 
+      /**
+       * @brief Get symbols and IDs of the assets whose symbols start with a prefix, e.g. for autocompletion
+       * @param prefix the start of the symbols, lower case letters match the upper case ones of the symbols
+       * @param limit Maximum number of results to return -- must not exceed @a api_limit_get_assets
+       * @return Map of asset symbols to corresponding IDs, the first symbols with the prefix in alphabetical order
+       */
+      map<string,asset_id_type> search_asset_symbols( const string& prefix, uint32_t limit )const;
+
       /**
        * @brief Get a list of assets by symbol names or IDs
        * @param symbols_or_ids symbol names or IDs of the assets to retrieve
@@ -581,6 +667,9 @@ class database_api
        * @param quote symbol name or ID of the quote asset
        * @param limit depth of the order book to retrieve, for bids and asks each, capped at 50
        * @return Order book of the market
+       *
+       * With the api_helper_indexes plugin, each entry is a price level summing up the orders at that price,
+       * otherwise each entry is an order.
        */
       order_book get_order_book( const string& base, const string& quote, unsigned limit = 50 )const;
 
@@ -815,6 +904,16 @@ class database_api
       vector< fc::variant > get_required_fees( const vector<operation>& ops,
                                                const std::string& asset_symbol_or_id )const;
 
+      /**
+       * @brief For each asset calculate the required fees of the operations, same as get_required_fees()
+       * @param ops a list of operations to be query for required fees
+       * @param assets_symbol_or_id symbol names or IDs of the assets to be used to pay the fees,
+       *                            the maximum number is configured by api_limit_get_assets
+       * @return for each asset a list of objects which indicates required fees of each operation
+       */
+      vector< vector< fc::variant > > get_required_fees_in_assets( const vector<operation>& ops,
+                                                   const vector<std::string>& assets_symbol_or_id )const;
+
       ///////////////////////////
       // Proposed transactions //
       ///////////////////////////
@@ -880,10 +979,17 @@ class database_api
        * @brief Get personal data
        * @param owner_account The owner of personal data.
        * @param permission_account An account who is permitted to use personal data.
-       * @return The personal data object list
+       * @param start_id ID of the first object to return, as a cursor for paging
+       * @param limit Maximum number of objects to return, defaults to and may not exceed the configured limit
+       * @return The personal data object list, sorted by hash
+       *
+       * @note To fetch the next page, pass the ID of the last object returned, which is then returned again
+       *       as the first element.
       */
       vector<personal_data_object> get_personal_data( const account_id_type subject_account,
-                                                      const account_id_type operator_account ) const;
+                                                      const account_id_type operator_account,
+                                                      optional<personal_data_id_type> start_id = optional<personal_data_id_type>(),
+                                                      optional<uint32_t> limit = optional<uint32_t>() ) const;
       /**
        * @brief Get personal data with maximum id
        * @param owner_account The owner of personal data.
@@ -897,10 +1003,14 @@ class database_api
        * @brief Get personal data v2
        * @param owner_account The owner of personal data.
        * @param permission_account An account who is permitted to use personal data.
-       * @return The personal data object list
+       * @param start_id ID of the first object to return, as a cursor for paging
+       * @param limit Maximum number of objects to return, defaults to and may not exceed the configured limit
+       * @return The personal data object list, sorted by hash
       */
       vector<personal_data_v2_object> get_personal_data_v2( const account_id_type subject_account,
-                                                      const account_id_type operator_account ) const;
+                                                      const account_id_type operator_account,
+                                                      optional<personal_data_v2_id_type> start_id = optional<personal_data_v2_id_type>(),
+                                                      optional<uint32_t> limit = optional<uint32_t>() ) const;
       /**
        * @brief Get personal data v2 with maximum id
        * @param owner_account The owner of personal data.
@@ -910,6 +1020,30 @@ class database_api
       fc::optional<personal_data_v2_object> get_last_personal_data_v2( const account_id_type subject_account,
                                                                  const account_id_type operator_account ) const;
 
+      /**
+       * @brief Get personal data v2 of several pairs of accounts at once
+       * @param account_pairs Pairs of subject account and operator account
+       * @param limit Maximum number of objects to return in total
+       * @return For each pair, its personal data objects sorted by hash; once @p limit is reached the
+       *         remaining lists are empty
+       */
+      vector<vector<personal_data_v2_object>> get_personal_data_v2_by_accounts(
+            const vector<std::pair<account_id_type, account_id_type>>& account_pairs, uint32_t limit ) const;
+
+      /**
+       * @brief Get a Merkle proof that a hash is among the personal data v2 of a pair of accounts
+       * @param subject_account The owner of personal data.
+       * @param operator_account An account who is permitted to use personal data.
+       * @param hash The hash of the personal data
+       * @return The proof, empty if the accounts have no personal data with this hash
+       *
+       * @note This API requires the api_helper_indexes plugin. The root is computed by this node and is not
+       *       part of the chain state.
+       */
+      optional<graphene::api_helper_indexes::personal_data_proof> get_personal_data_proof(
+            const account_id_type subject_account, const account_id_type operator_account,
+            const string& hash ) const;
+
       /**
        * @brief Get content card by id
        * @param content_id The id of content card
@@ -944,6 +1078,72 @@ class database_api
       vector<content_card_v2_object> get_content_cards_v2( const account_id_type subject_account,
                                                      const content_card_v2_id_type content_id, uint32_t limit ) const;
 
+      /**
+       * @brief Get content cards of several accounts at once
+       * @param subject_accounts The owner accounts of the content
+       * @param limit Maximum number of content card objects to fetch in total
+       * @return For each account, its content cards sorted by id; once @p limit is reached the remaining
+       *         lists are empty
+       */
+      vector<vector<content_card_v2_object>> get_content_cards_v2_by_accounts(
+            const vector<account_id_type>& subject_accounts, uint32_t limit ) const;
+
+      /**
+       * @brief Get the newest content cards of a type
+       * @param type The content type, e.g. a MIME type
+       * @param from Earliest timestamp of the cards to return, inclusive
+       * @param to Latest timestamp of the cards to return, exclusive
+       * @param limit Maximum number of content card objects to fetch
+       * @return The content card object list, newest first
+       *
+       * @note To page through older cards, pass the timestamp of the last card returned as @p to.
+       */
+      vector<content_card_v2_object> get_content_cards_v2_by_type( const string& type,
+                                                                   fc::time_point_sec from, fc::time_point_sec to,
+                                                                   uint32_t limit ) const;
+
+      /**
+       * @brief Get the newest content cards of an account within a time window
+       * @param subject_account The owner account of the content
+       * @param from Earliest timestamp of the cards to return, inclusive
+       * @param to Latest timestamp of the cards to return, exclusive
+       * @param limit Maximum number of content card objects to fetch
+       * @return The content card object list, newest first
+       */
+      vector<content_card_v2_object> get_content_cards_v2_by_time( const account_id_type subject_account,
+                                                                   fc::time_point_sec from, fc::time_point_sec to,
+                                                                   uint32_t limit ) const;
+
+      /**
+       * @brief Search content cards by the words of their description
+       * @param query Words separated by spaces, a word ending with '*' matches all words starting with it
+       * @param limit Maximum number of ids to return
+       * @return The ids of the matching content cards, those matching most words first, then newest first
+       *
+       * @note This API requires the content_cards plugin
+       */
+      vector<content_card_v2_id_type> search_content_cards( const string& query, uint32_t limit ) const;
+
+      /**
+       * @brief Get the number of votes of several contents
+       * @param content_ids The ids of the voted contents
+       * @return The vote counts in the order of @p content_ids, empty for contents without votes
+       */
+      vector<graphene::content_cards::content_vote_count> get_content_vote_counts(
+            const vector<string>& content_ids ) const;
+
+      /**
+       * @brief Get the versions of a content card, newest first
+       * @param content_card_id The id of the content card
+       * @param limit The maximum number of versions to return, including the current one
+       * @return The current version of the card followed by its prior versions
+       *
+       * @note This API requires the content_cards plugin with content-cards-history enabled. Prior versions are
+       *       kept from the time it was enabled, and dropped with the card.
+       */
+      vector<graphene::content_cards::content_card_version> get_content_card_history(
+            const content_card_v2_id_type content_card_id, uint32_t limit ) const;
+
       /**
        * @brief Get permission object by id
        * @param permission_id The id of permission object
@@ -961,6 +1161,46 @@ class database_api
       vector<permission_object> get_permissions( const account_id_type operator_account,
                                                  const permission_id_type permission_id, uint32_t limit ) const;
 
+      /**
+       * @brief Get permission objects of several accounts at once
+       * @param operator_accounts The owner accounts of the permissions
+       * @param limit Maximum number of permission objects to fetch in total
+       * @return For each account, its permissions sorted by id; once @p limit is reached the remaining
+       *         lists are empty
+       */
+      vector<vector<permission_object>> get_permissions_by_accounts(
+            const vector<account_id_type>& operator_accounts, uint32_t limit ) const;
+
+      /**
+       * @brief Get the permissions granted to an account on an object
+       * @param operator_account The account which is permitted to use the object
+       * @param object_id The id of the object, e.g. a content card
+       * @param limit Maximum number of permission objects to fetch
+       * @return The permission objects, oldest first
+       *
+       * @note This API requires the content_cards plugin
+       */
+      vector<permission_object> get_permissions_by_object( const account_id_type operator_account,
+                                                           const object_id_type object_id, uint32_t limit ) const;
+
+      /**
+       * @brief Request notification of the content operations matching a filter as blocks are applied
+       * @param callback Callback method which is called with the matching operations of each block
+       * @param filter The content card and permission types, subject accounts and operator accounts to match
+       *
+       * Content operations are the create, update and remove operations of content cards (v2), content votes
+       * and permissions. The callback is passed a variant containing a vector<operation_history_object> with the
+       * matching operations of a block in the order they were applied. A new subscription replaces the previous
+       * one of the session.
+       */
+      void subscribe_to_content_events( std::function<void(const variant&)> callback,
+                                        const content_event_filter& filter );
+
+      /**
+       * @brief Stop the notification of content operations
+       */
+      void unsubscribe_from_content_events();
+
       //////////
       // HTLC //
       //////////
@@ -1030,6 +1270,8 @@ FC_API(graphene::app::database_api,
    (get_block)
    (get_transaction)
    (get_recent_transaction_by_id)
+   (get_block_state_hash)
+   (get_packed_state_deltas)
 
    // Globals
    (get_chain_properties)
@@ -1045,12 +1287,15 @@ FC_API(graphene::app::database_api,
 
    // Accounts
    (get_account_id_from_string)
+   (get_account_ids_from_strings)
    (get_accounts)
    (get_full_accounts)
+   (get_changed_full_accounts)
    (get_account_by_name)
    (get_account_references)
    (lookup_account_names)
    (lookup_accounts)
+   (search_accounts)
    (get_account_count)
 
    // Balances
@@ -1059,10 +1304,12 @@ FC_API(graphene::app::database_api,
    (get_balance_objects)
    (get_vested_balances)
    (get_vesting_balances)
+   (get_withdrawable_vesting_balances)
 
    // Assets
    (get_assets)
    (list_assets)
+   (search_asset_symbols)
    (lookup_asset_symbols)
    (get_asset_count)
    (get_assets_by_issuer)
@@ -1116,6 +1363,7 @@ FC_API(graphene::app::database_api,
    (verify_account_authority)
    (validate_transaction)
    (get_required_fees)
+   (get_required_fees_in_assets)
 
    // Proposed transactions
    (get_proposed_transactions)
@@ -1135,9 +1383,21 @@ FC_API(graphene::app::database_api,
    (get_content_cards)
    (get_permission_by_id)
    (get_permissions)
+   (get_permissions_by_accounts)
+   (get_permissions_by_object)
+   (subscribe_to_content_events)
+   (unsubscribe_from_content_events)
    (get_content_card_v2_by_id)
    (get_content_cards_v2)
+   (get_content_cards_v2_by_accounts)
+   (get_content_cards_v2_by_type)
+   (get_content_cards_v2_by_time)
+   (search_content_cards)
+   (get_content_vote_counts)
+   (get_content_card_history)
    (get_personal_data_v2)
+   (get_personal_data_v2_by_accounts)
+   (get_personal_data_proof)
    (get_last_personal_data_v2)
 
    // HTLC
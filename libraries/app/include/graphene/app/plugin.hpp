@@ -24,6 +24,7 @@
 #pragma once
 
 #include <graphene/app/application.hpp>
+#include <graphene/chain/applied_ops_log.hpp>
 
 #include <boost/program_options.hpp>
 #include <fc/io/json.hpp>
@@ -67,6 +68,26 @@ class abstract_plugin
        */
       virtual void plugin_startup() = 0;
 
+      /**
+       * @brief Fill the data of the plugin which is derived from the chain state, e.g. secondary indexes
+       *
+       * This is called after startup() of all plugins, on a worker thread and concurrently with the other plugins.
+       * It MUST only read the chain state and change data of the plugin itself, indexes must be added in startup().
+       */
+      virtual void plugin_load_state() {}
+
+      /**
+       * @brief Rebuild the data of the plugin from the operations applied with the irreversible blocks
+       *
+       * This is called after the database is open and before startup() for the plugins listed in the
+       * rebuild-plugins option. Plugins which keep their data outside of the object database may support this
+       * instead of a replay, the others keep this default implementation.
+       *
+       * @param log The log of the operations applied with the blocks up to the head block
+       * @return true if the plugin was rebuilt
+       */
+      virtual bool plugin_rebuild( const graphene::chain::applied_ops_log& log ) { return false; }
+
       /**
        * @brief Cleanly shut down the plugin.
        *
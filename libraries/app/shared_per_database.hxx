@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2018-2022 Revolution Populi Limited, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/database.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace graphene { namespace app {
+
+/// The instance of T which is shared by all API sessions of @p db, created on first use and destroyed with the
+/// last session using it
+template<typename T>
+std::shared_ptr<T> get_shared_per_database( graphene::chain::database& db )
+{
+   static std::mutex registry_mutex;
+   static std::map<const graphene::chain::database*, std::weak_ptr<T>> registry;
+
+   std::lock_guard<std::mutex> guard( registry_mutex );
+   for( auto itr = registry.begin(); itr != registry.end(); )
+   {
+      if( itr->second.expired() )
+         itr = registry.erase( itr );
+      else
+         ++itr;
+   }
+   auto& entry = registry[&db];
+   auto result = entry.lock();
+   if( !result )
+   {
+      result = std::make_shared<T>( db );
+      entry = result;
+   }
+   return result;
+}
+
+} } // graphene::app
@@ -112,18 +112,74 @@ void account_statistics_object::pay_fee( share_type core_fee, share_type cashbac
       pending_vested_fees += core_fee;
 }
 
-set<account_id_type> account_member_index::get_account_members(const account_object& a)const
+namespace detail {
+
+   /// Removes @p id from the set of accounts referencing @p item, and @p item itself once nothing references it
+   template<typename Map, typename Key>
+   void remove_member( Map& memberships, const Key& item, const account_id_type& id )
+   {
+      auto itr = memberships.find( item );
+      if( itr == memberships.end() )
+         return;
+      itr->second.erase( id );
+      if( itr->second.empty() )
+         memberships.erase( itr );
+   }
+
+   /// Adds the accounts which were added to @p after and removes those removed from @p before
+   template<typename Map, typename Set>
+   void update_members( Map& memberships, const Set& before, const Set& after, const account_id_type& id )
+   {
+      Set removed;
+      std::set_difference( before.begin(), before.end(), after.begin(), after.end(),
+                           std::inserter( removed, removed.end() ), before.key_comp() );
+      for( const auto& item : removed )
+         remove_member( memberships, item, id );
+
+      Set added;
+      std::set_difference( after.begin(), after.end(), before.begin(), before.end(),
+                           std::inserter( added, added.end() ), after.key_comp() );
+      for( const auto& item : added )
+         memberships[item].insert( id );
+   }
+
+   /// Builds all sets of @p memberships from unsorted (item, account) pairs
+   template<typename Map, typename Key, typename Compare>
+   void load_members( Map& memberships, vector< std::pair<Key, account_id_type> >& pairs, Compare comp )
+   {
+      std::sort( pairs.begin(), pairs.end(),
+                 [&comp]( const std::pair<Key, account_id_type>& a, const std::pair<Key, account_id_type>& b ) {
+         return comp( a.first, b.first ) || ( !comp( b.first, a.first ) && a.second < b.second );
+      });
+      memberships.reserve( pairs.size() );
+      for( auto itr = pairs.begin(); itr != pairs.end(); )
+      {
+         auto next = itr;
+         while( next != pairs.end() && !comp( itr->first, next->first ) )
+            ++next;
+         account_member_index::account_set& accounts = memberships[itr->first];
+         accounts.reserve( std::distance( itr, next ) );
+         for( ; itr != next; ++itr )
+            accounts.insert( accounts.end(), itr->second ); // sorted, so this is an append
+      }
+   }
+
+} // detail
+
+flat_set<account_id_type> account_member_index::get_account_members(const account_object& a)const
 {
-   set<account_id_type> result;
+   flat_set<account_id_type> result;
+   result.reserve( a.owner.account_auths.size() + a.active.account_auths.size() );
    for( auto auth : a.owner.account_auths )
       result.insert(auth.first);
    for( auto auth : a.active.account_auths )
       result.insert(auth.first);
    return result;
 }
-set<public_key_type, pubkey_comparator> account_member_index::get_key_members(const account_object& a)const
+flat_set<public_key_type, pubkey_comparator> account_member_index::get_key_members(const account_object& a)const
 {
-   set<public_key_type, pubkey_comparator> result;
+   flat_set<public_key_type, pubkey_comparator> result;
+   result.reserve( a.owner.key_auths.size() + a.active.key_auths.size() + 1 );
    for( auto auth : a.owner.key_auths )
       result.insert(auth.first);
    for( auto auth : a.active.key_auths )
@@ -131,9 +187,10 @@ set<public_key_type, pubkey_comparator> account_member_index::get_key_members(co
    result.insert( a.options.memo_key );
    return result;
 }
-set<address> account_member_index::get_address_members(const account_object& a)const
+flat_set<address> account_member_index::get_address_members(const account_object& a)const
 {
-   set<address> result;
+   flat_set<address> result;
+   result.reserve( a.owner.address_auths.size() + a.active.address_auths.size() + 1 );
    for( auto auth : a.owner.address_auths )
       result.insert(auth.first);
    for( auto auth : a.active.address_auths )
@@ -165,23 +222,18 @@ void account_member_index::object_removed(const object& obj)
     assert( dynamic_cast<const account_object*>(&obj) ); // for debug only
     const account_object& a = static_cast<const account_object&>(obj);
 
-    auto key_members = get_key_members(a);
-    for( auto item : key_members )
-       account_to_key_memberships[item].erase( obj.id );
+    for( const auto& item : get_key_members(a) )
+       detail::remove_member( account_to_key_memberships, item, obj.id );
 
-    auto address_members = get_address_members(a);
-    for( auto item : address_members )
-       account_to_address_memberships[item].erase( obj.id );
+    for( const auto& item : get_address_members(a) )
+       detail::remove_member( account_to_address_memberships, item, obj.id );
 
-    auto account_members = get_account_members(a);
-    for( auto item : account_members )
-       account_to_account_memberships[item].erase( obj.id );
+    for( const auto& item : get_account_members(a) )
+       detail::remove_member( account_to_account_memberships, item, obj.id );
 }
 
 void account_member_index::about_to_modify(const object& before)
 {
-   before_key_members.clear();
-   before_account_members.clear();
    assert( dynamic_cast<const account_object*>(&before) ); // for debug only
    const account_object& a = static_cast<const account_object&>(before);
    before_key_members     = get_key_members(a);
@@ -194,66 +246,37 @@ void account_member_index::object_modified(const object& after)
     assert( dynamic_cast<const account_object*>(&after) ); // for debug only
     const account_object& a = static_cast<const account_object&>(after);
 
-    {
-       set<account_id_type> after_account_members = get_account_members(a);
-       vector<account_id_type> removed; removed.reserve(before_account_members.size());
-       std::set_difference(before_account_members.begin(), before_account_members.end(),
-                           after_account_members.begin(), after_account_members.end(),
-                           std::inserter(removed, removed.end()));
-
-       for( auto itr = removed.begin(); itr != removed.end(); ++itr )
-          account_to_account_memberships[*itr].erase(after.id);
-
-       vector<object_id_type> added; added.reserve(after_account_members.size());
-       std::set_difference(after_account_members.begin(), after_account_members.end(),
-                           before_account_members.begin(), before_account_members.end(),
-                           std::inserter(added, added.end()));
-
-       for( auto itr = added.begin(); itr != added.end(); ++itr )
-          account_to_account_memberships[*itr].insert(after.id);
-    }
-
-
-    {
-       set<public_key_type, pubkey_comparator> after_key_members = get_key_members(a);
-
-       vector<public_key_type> removed; removed.reserve(before_key_members.size());
-       std::set_difference(before_key_members.begin(), before_key_members.end(),
-                           after_key_members.begin(), after_key_members.end(),
-                           std::inserter(removed, removed.end()));
-
-       for( auto itr = removed.begin(); itr != removed.end(); ++itr )
-          account_to_key_memberships[*itr].erase(after.id);
-
-       vector<public_key_type> added; added.reserve(after_key_members.size());
-       std::set_difference(after_key_members.begin(), after_key_members.end(),
-                           before_key_members.begin(), before_key_members.end(),
-                           std::inserter(added, added.end()));
-
-       for( auto itr = added.begin(); itr != added.end(); ++itr )
-          account_to_key_memberships[*itr].insert(after.id);
-    }
-
-    {
-       set<address> after_address_members = get_address_members(a);
-
-       vector<address> removed; removed.reserve(before_address_members.size());
-       std::set_difference(before_address_members.begin(), before_address_members.end(),
-                           after_address_members.begin(), after_address_members.end(),
-                           std::inserter(removed, removed.end()));
-
-       for( auto itr = removed.begin(); itr != removed.end(); ++itr )
-          account_to_address_memberships[*itr].erase(after.id);
-
-       vector<address> added; added.reserve(after_address_members.size());
-       std::set_difference(after_address_members.begin(), after_address_members.end(),
-                           before_address_members.begin(), before_address_members.end(),
-                           std::inserter(added, added.end()));
-
-       for( auto itr = added.begin(); itr != added.end(); ++itr )
-          account_to_address_memberships[*itr].insert(after.id);
-    }
+    detail::update_members( account_to_account_memberships, before_account_members, get_account_members(a), after.id );
+    detail::update_members( account_to_key_memberships, before_key_members, get_key_members(a), after.id );
+    detail::update_members( account_to_address_memberships, before_address_members, get_address_members(a), after.id );
+}
 
+void account_member_index::load( const index& accounts )
+{
+   FC_ASSERT( account_to_account_memberships.empty() && account_to_key_memberships.empty()
+              && account_to_address_memberships.empty(), "Index must be empty to be loaded" );
+
+   vector< std::pair<account_id_type, account_id_type> > account_pairs;
+   vector< std::pair<public_key_type, account_id_type> > key_pairs;
+   vector< std::pair<address, account_id_type> >         address_pairs;
+   const size_t account_count = accounts.get_next_id().instance();
+   key_pairs.reserve( account_count * 2 );
+   address_pairs.reserve( account_count * 2 );
+   accounts.inspect_all_objects( [&]( const object& obj ) {
+      assert( dynamic_cast<const account_object*>(&obj) ); // for debug only
+      const account_object& a = static_cast<const account_object&>(obj);
+      const account_id_type id = a.get_id();
+      for( const auto& item : get_account_members(a) )
+         account_pairs.emplace_back( item, id );
+      for( const auto& item : get_key_members(a) )
+         key_pairs.emplace_back( item, id );
+      for( const auto& item : get_address_members(a) )
+         address_pairs.emplace_back( item, id );
+   });
+
+   detail::load_members( account_to_account_memberships, account_pairs, std::less<account_id_type>() );
+   detail::load_members( account_to_key_memberships, key_pairs, pubkey_comparator() );
+   detail::load_members( account_to_address_memberships, address_pairs, std::less<address>() );
 }
 
 const uint8_t  balances_by_account_index::bits = 20;
@@ -289,9 +312,10 @@ void balances_by_account_index::object_modified( const object& after  )
    ids_being_modified.pop();
 }
 
-const map< asset_id_type, const account_balance_object* >& balances_by_account_index::get_account_balances( const account_id_type& acct )const
+const balances_by_account_index::account_balances& balances_by_account_index::get_account_balances(
+      const account_id_type& acct )const
 {
-   static const map< asset_id_type, const account_balance_object* > _empty;
+   static const account_balances _empty;
 
    if( balances.size() < (acct.instance.value >> bits) + 1 ) return _empty;
    return balances[acct.instance.value >> bits][acct.instance.value & mask];
@@ -0,0 +1,157 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <graphene/chain/applied_ops_log.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/io/raw.hpp>
+
+#include <fstream>
+
+namespace graphene { namespace chain {
+
+namespace {
+
+   /// Reads the entry at the current position of @p in, @return false at the end of the log
+   bool read_entry( std::istream& in, uint64_t file_size, applied_ops_log_entry& entry )
+   {
+      const uint64_t position = in.tellg();
+      uint32_t packed_size = 0;
+      if( position + sizeof(packed_size) > file_size )
+         return false;
+      in.read( reinterpret_cast<char*>( &packed_size ), sizeof(packed_size) );
+      if( !in || position + sizeof(packed_size) + packed_size > file_size )
+         return false;
+      std::vector<char> packed( packed_size );
+      in.read( packed.data(), packed.size() );
+      if( !in )
+         return false;
+      entry = fc::raw::unpack<applied_ops_log_entry>( packed );
+      return true;
+   }
+
+   /// Packs the same bytes as an applied_ops_log_entry with the valid operations of @p ops, without copying them
+   std::vector<char> pack_entry( uint32_t block_num, fc::time_point_sec timestamp,
+                                 const vector<optional<operation_history_object>>& ops )
+   {
+      uint32_t count = 0;
+      size_t size = fc::raw::pack_size( block_num ) + fc::raw::pack_size( timestamp );
+      for( const auto& op : ops )
+         if( op.valid() )
+         {
+            ++count;
+            size += fc::raw::pack_size( *op );
+         }
+      size += fc::raw::pack_size( fc::unsigned_int( count ) );
+      std::vector<char> packed( size );
+      fc::datastream<char*> ds( packed.data(), packed.size() );
+      fc::raw::pack( ds, block_num );
+      fc::raw::pack( ds, timestamp );
+      fc::raw::pack( ds, fc::unsigned_int( count ) );
+      for( const auto& op : ops )
+         if( op.valid() )
+            fc::raw::pack( ds, *op );
+      return packed;
+   }
+
+} // anonymous
+
+void applied_ops_log::open( const fc::path& file )
+{ try {
+   close();
+   _file = file;
+   _last_block_num = 0;
+   if( fc::exists( _file ) )
+   {
+      const uint64_t file_size = fc::file_size( _file );
+      uint64_t valid_size = 0;
+      {
+         std::ifstream in( _file.generic_string().c_str(), std::ios::binary );
+         FC_ASSERT( in, "Unable to read ", ("f", _file) );
+         applied_ops_log_entry entry;
+         while( read_entry( in, file_size, entry ) )
+         {
+            _last_block_num = entry.block_num;
+            valid_size = in.tellg();
+         }
+      }
+      if( valid_size < file_size )
+      {
+         wlog( "Dropping an incomplete entry at the end of ", ("f", _file) );
+         fc::resize_file( _file, valid_size );
+      }
+   }
+   else
+   {
+      fc::create_directories( _file.parent_path() );
+      std::ofstream out( _file.generic_string().c_str(), std::ios::binary | std::ios::trunc );
+      FC_ASSERT( out, "Unable to write ", ("f", _file) );
+   }
+   _open = true;
+} FC_CAPTURE_AND_RETHROW( (file) ) }
+
+void applied_ops_log::close()
+{
+   _pending.clear();
+   _open = false;
+}
+
+void applied_ops_log::add_block( uint32_t block_num, fc::time_point_sec timestamp,
+                                 const shared_applied_operations& ops )
+{
+   // the log must not have gaps, blocks are only taken if they follow the log or the blocks kept in memory
+   if( !_open || block_num <= _last_block_num || block_num > _last_block_num + _pending.size() + 1 )
+      return;
+   _pending.erase( _pending.lower_bound( block_num ), _pending.end() );
+   pending_block& pending = _pending[ block_num ];
+   pending.timestamp = timestamp;
+   pending.ops = ops;
+}
+
+void applied_ops_log::write_irreversible( uint32_t last_irreversible )
+{ try {
+   if( !_open || _pending.empty() || _pending.begin()->first > last_irreversible )
+      return;
+   std::ofstream out( _file.generic_string().c_str(), std::ios::binary | std::ios::app );
+   auto itr = _pending.begin();
+   for( ; itr != _pending.end() && itr->first <= last_irreversible; ++itr )
+   {
+      static const vector<optional<operation_history_object>> no_ops;
+      const std::vector<char> packed = pack_entry( itr->first, itr->second.timestamp,
+                                                   itr->second.ops ? *itr->second.ops : no_ops );
+      const uint32_t packed_size = static_cast<uint32_t>( packed.size() );
+      out.write( reinterpret_cast<const char*>( &packed_size ), sizeof(packed_size) );
+      out.write( packed.data(), packed.size() );
+      _last_block_num = itr->first;
+   }
+   out.close();
+   FC_ASSERT( out, "Unable to write ", ("f", _file) );
+   _pending.erase( _pending.begin(), itr );
+} FC_CAPTURE_AND_RETHROW( (last_irreversible) ) }
+
+void applied_ops_log::for_each( const std::function<void(const applied_ops_log_entry&)>& f )const
+{ try {
+   FC_ASSERT( _open, "The applied operations log is not open" );
+   const uint64_t file_size = fc::file_size( _file );
+   std::ifstream in( _file.generic_string().c_str(), std::ios::binary );
+   FC_ASSERT( in, "Unable to read ", ("f", _file) );
+   applied_ops_log_entry entry;
+   while( read_entry( in, file_size, entry ) )
+      f( entry );
+} FC_CAPTURE_AND_RETHROW( (_file) ) }
+
+} } // graphene::chain
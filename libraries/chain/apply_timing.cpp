@@ -0,0 +1,46 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <graphene/chain/apply_timing.hpp>
+
+namespace graphene { namespace chain {
+
+apply_timing_stats apply_timer::get_stats( const string& name )const
+{
+   apply_timing_stats result;
+   result.name = name;
+   result.count = _count.load( std::memory_order_relaxed );
+   result.total_ns = _total_ns.load( std::memory_order_relaxed );
+   result.histogram.reserve( num_buckets );
+   for( const auto& bucket : _buckets )
+      result.histogram.push_back( bucket.load( std::memory_order_relaxed ) );
+   // trailing empty buckets carry no information
+   while( !result.histogram.empty() && result.histogram.back() == 0 )
+      result.histogram.pop_back();
+   return result;
+}
+
+void apply_timer::reset()
+{
+   _count.store( 0, std::memory_order_relaxed );
+   _total_ns.store( 0, std::memory_order_relaxed );
+   for( auto& bucket : _buckets )
+      bucket.store( 0, std::memory_order_relaxed );
+}
+
+} } // graphene::chain
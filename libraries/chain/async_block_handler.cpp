@@ -0,0 +1,105 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <graphene/chain/async_block_handler.hpp>
+
+#include <fc/thread/thread.hpp>
+
+namespace graphene { namespace chain {
+
+async_block_handler::async_block_handler( const string& name, uint32_t capacity, handler_type handler )
+: _name( name ), _capacity( std::max<uint32_t>( capacity, 1 ) ), _handler( std::move( handler ) ),
+  _thread( new fc::thread( name ) )
+{
+   _stats.name = _name;
+   _stats.capacity = _capacity;
+}
+
+async_block_handler::~async_block_handler()
+{
+   drain();
+   _thread->quit();
+}
+
+void async_block_handler::post( applied_block_event&& event )
+{
+   bool start = false;
+   {
+      std::unique_lock<std::mutex> lock( _mutex );
+      if( _events.size() >= _capacity )
+      {
+         ++_stats.producer_waits;
+         _changed.wait( lock, [this]{ return _events.size() < _capacity; } );
+      }
+      _stats.last_queued_block = event.block.block_num();
+      _events.push_back( std::move( event ) );
+      _stats.max_queued = std::max<uint64_t>( _stats.max_queued, _events.size() );
+      if( !_running )
+         _running = start = true;
+   }
+   if( start )
+      _thread->async( [this]{ run(); }, "async_block_handler" );
+}
+
+void async_block_handler::run()
+{
+   std::unique_lock<std::mutex> lock( _mutex );
+   while( !_events.empty() )
+   {
+      applied_block_event event = std::move( _events.front() );
+      _events.pop_front();
+      lock.unlock();
+      _changed.notify_all();
+
+      bool failed = false;
+      try {
+         _handler( event );
+      } catch( const fc::exception& e ) {
+         failed = true;
+         elog( "${n}: failed to handle block ${b}: ${e}",
+               ("n", _name)("b", event.block.block_num())("e", e.to_detail_string()) );
+      } catch( const std::exception& e ) {
+         failed = true;
+         elog( "${n}: failed to handle block ${b}: ${e}", ("n", _name)("b", event.block.block_num())("e", e.what()) );
+      }
+
+      lock.lock();
+      _stats.last_handled_block = event.block.block_num();
+      if( failed )
+         ++_stats.failures;
+   }
+   _running = false;
+   lock.unlock();
+   _changed.notify_all();
+}
+
+void async_block_handler::drain()
+{
+   std::unique_lock<std::mutex> lock( _mutex );
+   _changed.wait( lock, [this]{ return _events.empty() && !_running; } );
+}
+
+async_block_handler_stats async_block_handler::get_stats()const
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   async_block_handler_stats result = _stats;
+   result.queued = _events.size();
+   return result;
+}
+
+} } // graphene::chain
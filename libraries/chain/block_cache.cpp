@@ -0,0 +1,65 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <graphene/chain/block_cache.hpp>
+
+namespace graphene { namespace chain {
+
+block_cache::block_ptr block_cache::get( uint32_t block_num, const block_id_type& id )const
+{
+   entry result;
+   _blocks.find( block_num, result, [&id]( const entry& e ) { return e.id == id; } );
+   return result.block;
+}
+
+block_cache::block_ptr block_cache::get( uint32_t block_num )const
+{
+   entry result;
+   _blocks.find( block_num, result );
+   return result.block;
+}
+
+void block_cache::put( const block_id_type& id, const signed_block& block, uint64_t generation )
+{
+   if( _blocks.capacity() == 0 || _generation != generation )
+      return;
+   entry e{ id, std::make_shared<const signed_block>( block ) };
+   // removals bump the generation before taking the lock, so a stale block is either rejected here or removed
+   _blocks.put( block_header::num_from_id( id ), std::move( e ),
+                [this,generation]() { return _generation == generation; } );
+}
+
+void block_cache::erase( uint32_t block_num )
+{
+   ++_generation;
+   _blocks.erase( block_num );
+}
+
+void block_cache::erase_below( uint32_t block_num )
+{
+   ++_generation;
+   _blocks.erase_if( [block_num]( uint32_t num ) { return num < block_num; } );
+}
+
+void block_cache::clear()
+{
+   ++_generation;
+   _blocks.clear();
+}
+
+} } // graphene::chain
@@ -23,9 +23,22 @@
  */
 #include <graphene/chain/block_database.hpp>
 #include <graphene/protocol/fee_schedule.hpp>
+#include <fc/interprocess/file_mapping.hpp>
 #include <fc/io/raw.hpp>
 #include <boost/endian/buffers.hpp>
 
+#include <cstring>
+#include <limits>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef GRAPHENE_BLOCK_LOG_COMPRESSION
+#include <zlib.h>
+#endif
+
 namespace graphene { namespace chain {
 
 struct index_entry
@@ -38,11 +51,246 @@ struct index_entry
    boost::endian::little_uint32_buf_t block_size;
    block_id_type                      block_id;
 };
- }}
+}}
 FC_REFLECT( graphene::chain::index_entry, (block_pos)(block_size)(block_id) );
 
 namespace graphene { namespace chain {
 
+namespace {
+
+/// In a compressed block log, blocks are stored in frames which can be decompressed independently
+struct frame_header
+{
+   boost::endian::little_uint32_buf_t compressed_size;
+   boost::endian::little_uint32_buf_t raw_size;
+};
+
+/// Block numbers and packed blocks of a frame
+typedef vector< std::pair< uint32_t, vector<char> > > frame_content;
+
+vector<char> compress_frame( const frame_content& content )
+{
+#ifdef GRAPHENE_BLOCK_LOG_COMPRESSION
+   const vector<char> raw = fc::raw::pack( content );
+   uLongf size = compressBound( raw.size() );
+   vector<char> result( sizeof(frame_header) + size );
+   const int rc = compress2( (Bytef*)result.data() + sizeof(frame_header), &size,
+                             (const Bytef*)raw.data(), raw.size(), Z_DEFAULT_COMPRESSION );
+   FC_ASSERT( rc == Z_OK, "Failed to compress block log frame: ${rc}", ("rc", rc) );
+   frame_header header;
+   header.compressed_size = size;
+   header.raw_size = raw.size();
+   memcpy( result.data(), (const char*)&header, sizeof(header) );
+   result.resize( sizeof(header) + size );
+   return result;
+#else
+   FC_THROW( "Block log compression is not supported by this build" );
+#endif
+}
+
+/// @return false if the frame is truncated or corrupt
+bool decompress_frame( const char* data, uint64_t available, frame_content& content )
+{
+#ifdef GRAPHENE_BLOCK_LOG_COMPRESSION
+   frame_header header;
+   if( available < sizeof(header) )
+      return false;
+   memcpy( (char*)&header, data, sizeof(header) );
+   if( header.compressed_size.value() > available - sizeof(header) )
+      return false;
+   vector<char> raw( header.raw_size.value() );
+   uLongf size = raw.size();
+   if( uncompress( (Bytef*)raw.data(), &size, (const Bytef*)data + sizeof(header),
+                   header.compressed_size.value() ) != Z_OK || size != raw.size() )
+      return false;
+   try
+   {
+      content = fc::raw::unpack<frame_content>( raw );
+      return true;
+   }
+   catch( const fc::exception& )
+   {
+   }
+   return false;
+#else
+   FC_THROW( "Block log compression is not supported by this build" );
+#endif
+}
+
+/// Releases the disk space of the first @p size bytes of a file without changing offsets of the rest
+void release_file_head( const fc::path& filename, uint64_t size )
+{
+   if( size == 0 )
+      return;
+#if defined(__linux__) && defined(FALLOC_FL_PUNCH_HOLE)
+   const int fd = ::open( filename.generic_string().c_str(), O_WRONLY );
+   if( fd < 0 || ::fallocate( fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, 0, size ) != 0 )
+      wlog( "Unable to release disk space of pruned blocks in ${f}", ("f", filename) );
+   if( fd >= 0 )
+      ::close( fd );
+#endif
+}
+
+/**
+ * A read-only mapping of a file in segments of equal size. Complete segments are shared with later mappings of the
+ * same file, so that a growing file is mapped step by step instead of as a whole after every write.
+ */
+class segmented_mapping
+{
+   public:
+      /// 64 MiB, a multiple of the page size and of the size of an index entry
+      static constexpr uint64_t segment_size = uint64_t(1) << 26;
+
+      /// Maps the first @p size bytes of @p filename, reusing the complete segments of @p previous if not null
+      segmented_mapping( const fc::path& filename, uint64_t size, const segmented_mapping* previous )
+      : _size( size )
+      {
+         const size_t count = ( size + segment_size - 1 ) / segment_size;
+         _segments.reserve( count );
+         if( previous != nullptr )
+            for( const auto& segment : previous->_segments )
+            {
+               if( _segments.size() == count || segment->get_size() != segment_size )
+                  break;
+               _segments.push_back( segment );
+            }
+         if( _segments.size() == count )
+            return;
+         // the regions stay valid after the file mapping is closed
+         fc::file_mapping file( filename.generic_string().c_str(), fc::read_only );
+         for( uint64_t offset = _segments.size() * segment_size; offset < size; offset += segment_size )
+         {
+            const uint64_t length = ( size - offset < segment_size ) ? size - offset : segment_size;
+            _segments.push_back( std::make_shared<const fc::mapped_region>( file, fc::read_only, offset, length ) );
+         }
+      }
+
+      uint64_t size()const { return _size; }
+
+      /// Copies @p count bytes at @p pos, which must be within the mapped size
+      void read( uint64_t pos, char* out, uint64_t count )const
+      {
+         while( count > 0 )
+         {
+            const fc::mapped_region& segment = *_segments[ pos / segment_size ];
+            const uint64_t offset = pos % segment_size;
+            const uint64_t n = std::min<uint64_t>( count, segment.get_size() - offset );
+            memcpy( out, (const char*)segment.get_address() + offset, n );
+            out += n;
+            pos += n;
+            count -= n;
+         }
+      }
+
+      /// @return the address of @p count bytes at @p pos if they are within a single segment, otherwise null
+      const char* contiguous( uint64_t pos, uint64_t count )const
+      {
+         const fc::mapped_region& segment = *_segments[ pos / segment_size ];
+         const uint64_t offset = pos % segment_size;
+         return offset + count <= segment.get_size() ? (const char*)segment.get_address() + offset : nullptr;
+      }
+
+   private:
+      uint64_t                                              _size;
+      vector< std::shared_ptr<const fc::mapped_region> >    _segments;
+};
+
+} // anonymous namespace
+
+/// Read-only mappings of the index and the block log as of the last write
+struct block_database::mapped_files
+{
+   /// Maps the files, sharing the complete segments of the mappings of @p previous if not null
+   mapped_files( const fc::path& index_filename, const fc::path& blocks_filename, bool compressed_log,
+                 const mapped_files* previous = nullptr )
+   : compressed( compressed_log ),
+     index( index_filename, fc::file_size( index_filename ), previous ? &previous->index : nullptr ),
+     blocks( blocks_filename, fc::file_size( blocks_filename ), previous ? &previous->blocks : nullptr )
+   {
+   }
+
+   bool read_entry( uint32_t block_num, index_entry& e )const
+   {
+      const uint64_t index_pos = sizeof(e) * uint64_t(block_num);
+      if( index_pos + sizeof(e) > index.size() )
+         return false;
+      index.read( index_pos, (char*)&e, sizeof(e) );
+      if( e.block_size.value() == 0 )
+         return false;
+      if( compressed )
+         return e.block_pos.value() + sizeof(frame_header) <= blocks.size();
+      return e.block_pos.value() + e.block_size.value() <= blocks.size();
+   }
+
+   /// @return false if the block could not be read
+   bool read_block( uint32_t block_num, const index_entry& e, vector<char>& data )const
+   {
+      const uint64_t pos = e.block_pos.value();
+      if( !compressed )
+      {
+         data.resize( e.block_size.value() );
+         blocks.read( pos, data.data(), data.size() );
+         return true;
+      }
+      frame_header header;
+      blocks.read( pos, (char*)&header, sizeof(header) );
+      const uint64_t frame_size = sizeof(header) + header.compressed_size.value();
+      if( frame_size > blocks.size() - pos )
+         return false;
+      // frames are only copied if they cross the border of two segments
+      const char* frame = blocks.contiguous( pos, frame_size );
+      vector<char> buffer;
+      if( frame == nullptr )
+      {
+         buffer.resize( frame_size );
+         blocks.read( pos, buffer.data(), frame_size );
+         frame = buffer.data();
+      }
+      frame_content content;
+      if( !decompress_frame( frame, frame_size, content ) )
+         return false;
+      for( auto& item : content )
+         if( item.first == block_num )
+         {
+            data = std::move( item.second );
+            return data.size() == e.block_size.value();
+         }
+      return false;
+   }
+
+   /// @return the position after the frame or block referenced by @p e
+   uint64_t end_of( const index_entry& e )const
+   {
+      if( !compressed )
+         return e.block_pos.value() + e.block_size.value();
+      frame_header header;
+      blocks.read( e.block_pos.value(), (char*)&header, sizeof(header) );
+      return e.block_pos.value() + sizeof(header) + header.compressed_size.value();
+   }
+
+   const bool              compressed;
+   const segmented_mapping index;
+   const segmented_mapping blocks;
+};
+
+block_database::block_database() {}
+
+block_database::~block_database()
+{
+   try
+   {
+      close();
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "Failed to write block database: ${e}", ("e", e.to_detail_string()) );
+   }
+   catch( const std::exception& e )
+   {
+      elog( "Failed to write block database: ${e}", ("e", e.what()) );
+   }
+}
+
 void block_database::open( const fc::path& dbdir )
 { try {
    fc::create_directories(dbdir);
@@ -50,16 +298,56 @@ void block_database::open( const fc::path& dbdir )
    _blocks.exceptions(std::ios_base::failbit | std::ios_base::badbit);
 
    _index_filename = dbdir / "index";
+   // the format of an existing block log is kept, compression only applies to new ones
+   if( fc::exists( _index_filename ) )
+      _compressed = fc::exists( dbdir / "blocks.z" );
+   else
+      _compressed = ( _frame_size > 0 );
+   if( _compressed )
+   {
+#ifndef GRAPHENE_BLOCK_LOG_COMPRESSION
+      FC_THROW( "Block log compression is not supported by this build" );
+#endif
+      _write_batch_size = _frame_size > 0 ? _frame_size : 64;
+      ilog( "Using compressed block log with frames of ${n} blocks", ("n", _write_batch_size) );
+   }
+   else if( _frame_size > 0 )
+      wlog( "Existing block log in ${d} is not compressed and will stay uncompressed", ("d", dbdir) );
+   _blocks_filename = dbdir / ( _compressed ? "blocks.z" : "blocks" );
    if( !fc::exists( _index_filename ) )
    {
      _block_num_to_pos.open( _index_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
-     _blocks.open( (dbdir/"blocks").generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
+     _blocks.open( _blocks_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
    }
    else
    {
      _block_num_to_pos.open( _index_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
-     _blocks.open( (dbdir/"blocks").generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
+     _blocks.open( _blocks_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
+   }
+   repair_index();
+   remap( 0 );
+
+   // pruned blocks are always at the start of the index, removed blocks only at the end
+   _first_block_num = 1;
+   optional<uint32_t> last = last_block_num();
+   if( last.valid() && *last > 1 )
+   {
+      index_entry e;
+      uint32_t low = 1;
+      uint32_t high = *last;
+      while( low < high )
+      {
+         const uint32_t mid = low + ( high - low ) / 2;
+         if( _files->read_entry( mid, e ) )
+            high = mid;
+         else
+            low = mid + 1;
+      }
+      _first_block_num = low;
+      if( low > 1 )
+         ilog( "Block log is pruned, it starts at block #${n}", ("n", low) );
    }
+   _prune_below = _first_block_num;
 } FC_CAPTURE_AND_RETHROW( (dbdir) ) }
 
 bool block_database::is_open()const
@@ -69,14 +357,117 @@ bool block_database::is_open()const
 
 void block_database::close()
 {
+  if( !is_open() )
+     return;
+  flush();
   _blocks.close();
   _block_num_to_pos.close();
+  _cache.clear();
+  std::lock_guard<std::mutex> lock( _mutex );
+  _files.reset();
 }
 
 void block_database::flush()
 {
-  _blocks.flush();
-  _block_num_to_pos.flush();
+   write_pending( std::numeric_limits<uint32_t>::max() );
+}
+
+void block_database::flush_through( uint32_t block_num )
+{
+   if( !_pending.empty() && _pending.begin()->first <= block_num )
+      write_pending( block_num );
+}
+
+void block_database::write_pending( uint32_t last_block_num )
+{
+   // only this thread modifies _pending, readers keep finding the blocks there until the new mappings are in place
+   const auto end = _pending.upper_bound( last_block_num );
+   const bool written = ( end != _pending.begin() );
+   if( written )
+   {
+      _blocks.seekp( 0, _blocks.end );
+      if( _compressed )
+      {
+         frame_content content;
+         for( auto itr = _pending.begin(); itr != end; ++itr )
+            content.emplace_back( itr->first, *itr->second.data );
+         const vector<char> frame = compress_frame( content );
+         const uint64_t frame_pos = _blocks.tellp();
+         _blocks.write( frame.data(), frame.size() );
+         for( auto itr = _pending.begin(); itr != end; ++itr )
+         {
+            index_entry e;
+            e.block_pos  = frame_pos;
+            e.block_size = itr->second.data->size();
+            e.block_id   = itr->second.id;
+            _block_num_to_pos.seekp( sizeof( index_entry ) * int64_t(itr->first) );
+            _block_num_to_pos.write( (char*)&e, sizeof(e) );
+         }
+      }
+      else for( auto itr = _pending.begin(); itr != end; ++itr )
+      {
+         index_entry e;
+         e.block_pos  = _blocks.tellp();
+         e.block_size = itr->second.data->size();
+         e.block_id   = itr->second.id;
+         _blocks.write( itr->second.data->data(), itr->second.data->size() );
+         _block_num_to_pos.seekp( sizeof( index_entry ) * int64_t(itr->first) );
+         _block_num_to_pos.write( (char*)&e, sizeof(e) );
+      }
+   }
+   _blocks.flush();
+   _block_num_to_pos.flush();
+   if( written )
+   {
+      remap( last_block_num );
+      apply_pruning();
+   }
+}
+
+void block_database::prune( uint32_t first_block_to_keep )
+{
+   if( first_block_to_keep > _prune_below )
+      _prune_below = first_block_to_keep;
+}
+
+void block_database::apply_pruning()
+{
+   // blocks pruned with the previous batch are no longer in use by readers
+   release_file_head( _blocks_filename, _release_blocks_end );
+   release_file_head( _index_filename, _release_index_end );
+   _release_blocks_end = 0;
+   _release_index_end = 0;
+
+   const uint32_t first = _first_block_num;
+   if( _prune_below <= first || !_files )
+      return;
+
+   index_entry keep;
+   if( !_files->read_entry( _prune_below, keep ) )
+      return; // not stored yet
+
+   const uint64_t begin = sizeof(index_entry) * uint64_t(first);
+   const uint64_t end = sizeof(index_entry) * uint64_t(_prune_below);
+   const vector<char> zeros( std::min<uint64_t>( end - begin, 1024 * 1024 ), 0 );
+   _block_num_to_pos.seekp( begin );
+   for( uint64_t pos = begin; pos < end; pos += zeros.size() )
+      _block_num_to_pos.write( zeros.data(), std::min<uint64_t>( end - pos, zeros.size() ) );
+   _block_num_to_pos.flush();
+   _first_block_num = _prune_below;
+   _cache.erase_below( _prune_below );
+
+   // blocks are appended in the order of their numbers, in a compressed log the frame of the first block
+   // which is kept can contain pruned blocks too
+   _release_blocks_end = keep.block_pos.value();
+   _release_index_end = end;
+}
+
+void block_database::remap( uint32_t written_through )
+{
+   auto files = std::make_shared<const mapped_files>( _index_filename, _blocks_filename, _compressed, _files.get() );
+   std::lock_guard<std::mutex> lock( _mutex );
+   _files = std::move( files );
+   _pending.erase( _pending.begin(), _pending.upper_bound( written_through ) );
 }
 
 void block_database::store( const block_id_type& _id, const signed_block& b )
@@ -87,89 +478,157 @@ void block_database::store( const block_id_type& _id, const signed_block& b )
       id = b.id();
       elog( "id argument of block_database::store() was not initialized for block ${id}", ("id", id) );
    }
-   _block_num_to_pos.seekp( sizeof( index_entry ) * int64_t(block_header::num_from_id(id)) );
-   index_entry e;
-   _blocks.seekp( 0, _blocks.end );
-   auto vec = fc::raw::pack( b );
-   e.block_pos  = _blocks.tellp();
-   e.block_size = vec.size();
-   e.block_id   = id;
-   _blocks.write( vec.data(), vec.size() );
-   _block_num_to_pos.write( (char*)&e, sizeof(e) );
+   store( id, std::make_shared<const vector<char>>( fc::raw::pack( b ) ) );
+}
+
+void block_database::store( const block_id_type& id, std::shared_ptr<const vector<char>> packed )
+{
+   FC_ASSERT( packed, "No block data to store" );
+   pending_block pending;
+   pending.id = id;
+   pending.data = std::move( packed );
+   size_t pending_count;
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      _pending[ block_header::num_from_id(id) ] = std::move( pending );
+      pending_count = _pending.size();
+   }
+   _cache.erase( block_header::num_from_id(id) );
+   if( pending_count >= _write_batch_size )
+      flush();
 }
 
 void block_database::remove( const block_id_type& id )
 { try {
+   const uint32_t block_num = block_header::num_from_id(id);
+   std::shared_ptr<const mapped_files> files;
+   bool removed_pending = false;
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      auto itr = _pending.find( block_num );
+      if( itr != _pending.end() && itr->second.id == id )
+      {
+         _pending.erase( itr );
+         removed_pending = true;
+      }
+      files = _files;
+   }
+
    index_entry e;
-   int64_t index_pos = sizeof(e) * int64_t(block_header::num_from_id(id));
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( _block_num_to_pos.tellg() <= index_pos )
+   const int64_t index_pos = sizeof(e) * int64_t(block_num);
+   if( !removed_pending && ( !files || int64_t(files->index.size()) <= index_pos ) )
       FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block ${id} not contained in block database", ("id", id));
 
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
-   if( e.block_id == id )
+   if( files && files->read_entry( block_num, e ) && e.block_id == id )
    {
       e.block_size = 0;
-      _block_num_to_pos.seekp( sizeof(e) * int64_t(block_header::num_from_id(id)) );
+      _block_num_to_pos.seekp( index_pos );
       _block_num_to_pos.write( (char*)&e, sizeof(e) );
+      _block_num_to_pos.flush();
    }
+   // after the block is gone, so that readers which found it do not cache it again
+   _cache.erase( block_num );
 } FC_CAPTURE_AND_RETHROW( (id) ) }
 
-bool block_database::contains( const block_id_type& id )const
+bool block_database::lookup( uint32_t block_num, block_id_type& id, vector<char>* data )const
 {
-   if( id == block_id_type() )
+   std::shared_ptr<const mapped_files> files;
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      auto itr = _pending.find( block_num );
+      if( itr != _pending.end() )
+      {
+         id = itr->second.id;
+         if( data != nullptr )
+            *data = *itr->second.data;
+         return true;
+      }
+      files = _files;
+   }
+   index_entry e;
+   if( !files || !files->read_entry( block_num, e ) )
       return false;
+   id = e.block_id;
+   if( data != nullptr )
+   {
+      if( !files->read_block( block_num, e, *data ) )
+         return false;
+      _current_position = files->end_of( e );
+   }
+   return true;
+}
 
-   index_entry e;
-   int64_t index_pos = sizeof(e) * int64_t(block_header::num_from_id(id));
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( _block_num_to_pos.tellg() < int64_t(index_pos + sizeof(e)) )
+bool block_database::contains( const block_id_type& id )const
+{
+   if( id == block_id_type() )
       return false;
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
 
-   return e.block_id == id && e.block_size.value() > 0;
+   block_id_type found_id;
+   return lookup( block_header::num_from_id(id), found_id, nullptr ) && found_id == id;
 }
 
 block_id_type block_database::fetch_block_id( uint32_t block_num )const
 {
    assert( block_num != 0 );
-   index_entry e;
-   int64_t index_pos = sizeof(e) * int64_t(block_num);
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( _block_num_to_pos.tellg() <= index_pos )
+   block_id_type id;
+   if( !lookup( block_num, id, nullptr ) )
       FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block number ${block_num} not contained in block database", ("block_num", block_num));
 
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
+   FC_ASSERT( id != block_id_type(), "Empty block_id in block_database (maybe corrupt on disk?)" );
+   return id;
+}
 
-   FC_ASSERT( e.block_id != block_id_type(), "Empty block_id in block_database (maybe corrupt on disk?)" );
-   return e.block_id;
+vector<block_id_type> block_database::fetch_block_ids( const vector<uint32_t>& block_nums )const
+{
+   vector<block_id_type> result( block_nums.size() );
+   vector<bool> found( block_nums.size(), false );
+   std::shared_ptr<const mapped_files> files;
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      if( !_pending.empty() )
+         for( size_t i = 0; i < block_nums.size(); ++i )
+         {
+            auto itr = _pending.find( block_nums[i] );
+            if( itr != _pending.end() )
+            {
+               result[i] = itr->second.id;
+               found[i] = true;
+            }
+         }
+      files = _files;
+   }
+   index_entry e;
+   for( size_t i = 0; i < block_nums.size(); ++i )
+   {
+      if( found[i] )
+         continue;
+      if( !files || !files->read_entry( block_nums[i], e ) )
+         FC_THROW_EXCEPTION( fc::key_not_found_exception, "Block number ${block_num} not contained in block database",
+                             ("block_num", block_nums[i]) );
+      FC_ASSERT( e.block_id != block_id_type(), "Empty block_id in block_database (maybe corrupt on disk?)" );
+      result[i] = e.block_id;
+   }
+   return result;
 }
 
 optional<signed_block> block_database::fetch_optional( const block_id_type& id )const
 {
    try
    {
-      index_entry e;
-      int64_t index_pos = sizeof(e) * int64_t(block_header::num_from_id(id));
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      if ( _block_num_to_pos.tellg() <= index_pos )
-         return {};
-
-      _block_num_to_pos.seekg( index_pos );
-      _block_num_to_pos.read( (char*)&e, sizeof(e) );
+      const uint32_t block_num = block_header::num_from_id(id);
+      if( auto cached = _cache.get( block_num, id ) )
+         return *cached;
 
-      if( e.block_id != id ) return optional<signed_block>();
+      // taken before reading, so that a block replaced in the meantime is not cached
+      const uint64_t generation = _cache.generation();
+      block_id_type found_id;
+      vector<char> data;
+      if( !lookup( block_num, found_id, &data ) || found_id != id )
+         return optional<signed_block>();
 
-      vector<char> data( e.block_size.value() );
-      _blocks.seekg( e.block_pos.value() );
-      if (e.block_size.value())
-         _blocks.read( data.data(), e.block_size.value() );
       auto result = fc::raw::unpack<signed_block>(data);
-      FC_ASSERT( result.id() == e.block_id );
+      FC_ASSERT( result.id() == id );
+      _cache.put( id, result, generation );
       return result;
    }
    catch (const fc::exception&)
@@ -185,20 +644,17 @@ optional<signed_block> block_database::fetch_by_number( uint32_t block_num )cons
 {
    try
    {
-      index_entry e;
-      int64_t index_pos = sizeof(e) * int64_t(block_num);
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      if ( _block_num_to_pos.tellg() <= index_pos )
-         return {};
+      if( auto cached = _cache.get( block_num ) )
+         return *cached;
 
-      _block_num_to_pos.seekg( index_pos, _block_num_to_pos.beg );
-      _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
-      vector<char> data( e.block_size.value() );
-      _blocks.seekg( e.block_pos.value() );
-      _blocks.read( data.data(), e.block_size.value() );
+      const uint64_t generation = _cache.generation();
+      block_id_type id;
+      vector<char> data;
+      if( !fetch_packed_by_number( block_num, id, data ) )
+         return {};
       auto result = fc::raw::unpack<signed_block>(data);
-      FC_ASSERT( result.id() == e.block_id );
+      FC_ASSERT( result.id() == id );
+      _cache.put( id, result, generation );
       return result;
    }
    catch (const fc::exception&)
@@ -210,37 +666,29 @@ optional<signed_block> block_database::fetch_by_number( uint32_t block_num )cons
    return optional<signed_block>();
 }
 
-optional<index_entry> block_database::last_index_entry()const {
-   try
-   {
-      index_entry e;
-
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      std::streampos pos = _block_num_to_pos.tellg();
-      if( pos < long(sizeof(index_entry)) )
-         return optional<index_entry>();
-
-      pos -= pos % sizeof(index_entry);
+bool block_database::fetch_packed_by_number( uint32_t block_num, block_id_type& id, vector<char>& data )const
+{
+   return lookup( block_num, id, &data );
+}
 
-      _blocks.seekg( 0, _block_num_to_pos.end );
-      const std::streampos blocks_size = _blocks.tellg();
-      while( pos > 0 )
+void block_database::repair_index()
+{
+   uint64_t valid_size = 0;
+   uint64_t index_size = 0;
+   {
+      const mapped_files files( _index_filename, _blocks_filename, _compressed );
+      index_size = files.index.size();
+      for( uint32_t block_num = index_size / sizeof(index_entry); block_num > 0; --block_num )
       {
-         pos -= sizeof(index_entry);
-         _block_num_to_pos.seekg( pos );
-         _block_num_to_pos.read( (char*)&e, sizeof(e) );
-         if( _block_num_to_pos.gcount() == sizeof(e) && e.block_size.value() > 0
-                && int64_t(e.block_pos.value() + e.block_size.value()) <= blocks_size )
+         index_entry e;
+         vector<char> data;
+         if( files.read_entry( block_num - 1, e ) && files.read_block( block_num - 1, e, data ) )
             try
             {
-               vector<char> data( e.block_size.value() );
-               _blocks.seekg( e.block_pos.value() );
-               _blocks.read( data.data(), e.block_size.value() );
-               if( _blocks.gcount() == long(e.block_size.value()) )
+               if( fc::raw::unpack<signed_block>(data).id() == e.block_id )
                {
-                  const signed_block block = fc::raw::unpack<signed_block>(data);
-                  if( block.id() == e.block_id )
-                     return e;
+                  valid_size = uint64_t(block_num) * sizeof(index_entry);
+                  break;
                }
             }
             catch (const fc::exception&)
@@ -249,41 +697,66 @@ optional<index_entry> block_database::last_index_entry()const {
             catch (const std::exception&)
             {
             }
-         fc::resize_file( _index_filename, pos );
       }
    }
-   catch (const fc::exception&)
+   if( valid_size < index_size )
    {
+      wlog( "Truncating invalid entries at the end of the block index" );
+      fc::resize_file( _index_filename, valid_size );
    }
-   catch (const std::exception&)
+}
+
+optional<uint32_t> block_database::last_block_num()const
+{
+   optional<uint32_t> result;
+   std::shared_ptr<const mapped_files> files;
    {
+      std::lock_guard<std::mutex> lock( _mutex );
+      if( !_pending.empty() )
+         result = _pending.rbegin()->first;
+      files = _files;
+   }
+   if( !files )
+      return result;
+   // removed blocks leave empty entries at the end of the index
+   for( uint32_t block_num = files->index.size() / sizeof(index_entry); block_num > 0; --block_num )
+   {
+      if( result.valid() && *result >= block_num - 1 )
+         break;
+      index_entry e;
+      if( files->read_entry( block_num - 1, e ) )
+         return block_num - 1;
    }
-   return optional<index_entry>();
+   return result;
 }
 
 optional<signed_block> block_database::last()const
 {
-   optional<index_entry> entry = last_index_entry();
-   if( entry.valid() ) return fetch_by_number( block_header::num_from_id(entry->block_id) );
+   optional<uint32_t> block_num = last_block_num();
+   if( block_num.valid() ) return fetch_by_number( *block_num );
    return optional<signed_block>();
 }
 
 optional<block_id_type> block_database::last_id()const
 {
-   optional<index_entry> entry = last_index_entry();
-   if( entry.valid() ) return entry->block_id;
+   optional<uint32_t> block_num = last_block_num();
+   block_id_type id;
+   if( block_num.valid() && lookup( *block_num, id, nullptr ) ) return id;
    return optional<block_id_type>();
 }
 
 size_t block_database::blocks_current_position()const
 {
-   return (size_t)_blocks.tellg();
+   return _current_position;
 }
 
 size_t block_database::total_block_size()const
 {
-   _blocks.seekg( 0, _blocks.end );
-   return (size_t)_blocks.tellg();
+   std::lock_guard<std::mutex> lock( _mutex );
+   size_t result = _files ? _files->blocks.size() : 0;
+   for( const auto& item : _pending )
+      result += item.second.data->size();
+   return result;
 }
 
 } }
@@ -0,0 +1,48 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <graphene/chain/confidential_proof_cache.hpp>
+
+namespace graphene { namespace chain {
+
+bool confidential_proof_cache::has_confidential_operations( const transaction& trx )
+{
+   for( const auto& op : trx.operations )
+      if( op.is_type<transfer_to_blind_operation>() || op.is_type<blind_transfer_operation>()
+            || op.is_type<transfer_from_blind_operation>() )
+         return true;
+   return false;
+}
+
+void confidential_proof_cache::validate( const precomputable_transaction& trx )const
+{
+   if( _ids.capacity() == 0 || !has_confidential_operations( trx ) )
+   {
+      trx.validate();
+      return;
+   }
+
+   bool known = false;
+   trx.validate( [this,&known]( const transaction_id_type& id ) {
+      validated v;
+      return known = _ids.find( id, v );
+   } );
+   if( !known )
+      _ids.put( trx.id(), validated() );
+}
+
+} } // graphene::chain
@@ -40,8 +40,8 @@ void_result content_card_create_evaluator::do_evaluate( const content_card_creat
    const auto& content_idx = d.get_index_type<content_card_index>();
    const auto& content_op_idx = content_idx.indices().get<by_subject_account_and_hash>();
 
-   auto itr = content_op_idx.lower_bound(boost::make_tuple(op.subject_account, op.hash));
-   FC_ASSERT(itr->subject_account != op.subject_account || itr->hash != op.hash, "Content card already exists.");
+   auto itr = content_op_idx.find(boost::make_tuple(op.subject_account, op.hash));
+   FC_ASSERT(itr == content_op_idx.end(), "Content card already exists.");
 
    return void_result();
 } FC_CAPTURE_AND_RETHROW( (op) ) }
@@ -75,8 +75,8 @@ void_result content_card_update_evaluator::do_evaluate( const content_card_updat
    const auto& content_idx = d.get_index_type<content_card_index>();
    const auto& content_op_idx = content_idx.indices().get<by_subject_account_and_hash>();
 
-   auto itr = content_op_idx.lower_bound(boost::make_tuple(op.subject_account, op.hash));
-   FC_ASSERT(itr->subject_account == op.subject_account && itr->hash == op.hash, "Content card does not exists.");
+   auto itr = content_op_idx.find(boost::make_tuple(op.subject_account, op.hash));
+   FC_ASSERT(itr != content_op_idx.end(), "Content card does not exists.");
 
    return void_result();
 } FC_CAPTURE_AND_RETHROW( (op) ) }
@@ -88,7 +88,7 @@ object_id_type content_card_update_evaluator::do_apply( const content_card_updat
    const auto& content_idx = d.get_index_type<content_card_index>();
    const auto& content_op_idx = content_idx.indices().get<by_subject_account_and_hash>();
 
-   auto itr = content_op_idx.lower_bound(boost::make_tuple(o.subject_account, o.hash));
+   auto itr = content_op_idx.find(boost::make_tuple(o.subject_account, o.hash));
 
    d.modify( *itr, [&o](content_card_object& obj){
          obj.subject_account = o.subject_account;
@@ -44,8 +44,8 @@ void_result content_card_v2_create_evaluator::do_evaluate( const content_card_v2
    const auto& content_idx = d.get_index_type<content_card_v2_index>();
    const auto& content_op_idx = content_idx.indices().get<by_subject_account_and_hash>();
 
-   auto itr = content_op_idx.lower_bound(boost::make_tuple(op.subject_account, op.hash));
-   FC_ASSERT(itr->subject_account != op.subject_account || itr->hash != op.hash, "Content card already exists.");
+   auto itr = content_op_idx.find(boost::make_tuple(op.subject_account, op.hash));
+   FC_ASSERT(itr == content_op_idx.end(), "Content card already exists.");
 
    return void_result();
 } FC_CAPTURE_AND_RETHROW( (op) ) }
@@ -85,8 +85,9 @@ void_result content_card_v2_update_evaluator::do_evaluate( const content_card_v2
    const auto& content_idx = d.get_index_type<content_card_v2_index>();
    const auto& content_op_idx = content_idx.indices().get<by_subject_account_and_hash>();
 
-   auto itr = content_op_idx.lower_bound(boost::make_tuple(op.subject_account, op.hash));
-   FC_ASSERT(itr->subject_account == op.subject_account && itr->hash == op.hash, "Content card does not exists.");
+   auto itr = content_op_idx.find(boost::make_tuple(op.subject_account, op.hash));
+   FC_ASSERT(itr != content_op_idx.end(), "Content card does not exists.");
+   content_card = &(*itr);
 
    return void_result();
 } FC_CAPTURE_AND_RETHROW( (op) ) }
@@ -95,14 +96,8 @@ object_id_type content_card_v2_update_evaluator::do_apply( const content_card_v2
 { try {
    database& d = db();
 
-   const auto& content_idx = d.get_index_type<content_card_v2_index>();
-   const auto& content_op_idx = content_idx.indices().get<by_subject_account_and_hash>();
-
-   auto itr = content_op_idx.lower_bound(boost::make_tuple(o.subject_account, o.hash));
-
-   d.modify( *itr, [&o](content_card_v2_object& obj){
-         obj.subject_account = o.subject_account;
-         obj.hash            = o.hash;
+   // found by do_evaluate(), subject account and hash are the lookup key and therefore unchanged
+   d.modify( *content_card, [&o](content_card_v2_object& obj){
          obj.url             = o.url;
          obj.type            = o.type;
          obj.description     = o.description;
@@ -111,7 +106,7 @@ object_id_type content_card_v2_update_evaluator::do_apply( const content_card_v2
          obj.storage_data    = o.storage_data;
    });
 
-   return itr->id;
+   return content_card->id;
 } FC_CAPTURE_AND_RETHROW((o)) }
 
 void_result content_card_v2_remove_evaluator::do_evaluate( const content_card_v2_remove_operation& op )
@@ -22,7 +22,6 @@
 #include <graphene/chain/exceptions.hpp>
 #include <graphene/chain/special_authority_object.hpp>
 #include <graphene/chain/witness_object.hpp>
-#include <graphene/chain/vote_master_summary_object.hpp>
 
 #include <algorithm>
 
@@ -36,8 +35,7 @@ void_result content_vote_create_evaluator::do_evaluate( const content_vote_creat
    const auto& vote_idx = d.get_index_type<content_vote_index>();
    const auto& by_op_idx = vote_idx.indices().get<by_subject_account>();
 
-   auto itr = by_op_idx.lower_bound(boost::make_tuple(op.subject_account, op.content_id));
-   FC_ASSERT(itr->subject_account != op.subject_account || itr->content_id != op.content_id,
+   FC_ASSERT(by_op_idx.find(boost::make_tuple(op.subject_account, compact_content_id(op.content_id))) == by_op_idx.end(),
                 "Content vote already exists.");
 
    return void_result();
@@ -51,22 +49,14 @@ object_id_type content_vote_create_evaluator::do_apply( const content_vote_creat
       obj.subject_account = o.subject_account;
       obj.content_id      = o.content_id;
    });
-   // Update vote master summary with new vote created
-   const auto& vms_idx = d.get_index_type<vote_master_summary_index>();
-   const auto& by_master_idx = vms_idx.indices().get<by_master_account>();
-   auto itr = by_master_idx.lower_bound(o.master_account);
-   if (itr->master_account == o.master_account) {
-      d.modify( *itr, [&o](vote_master_summary_object& obj){
-         obj.total_votes++;
-      });
-   } else {
-      d.create<vote_master_summary_object>( [&o]( vote_master_summary_object& obj )
-      {
-         obj.master_account = o.master_account;
-         obj.total_votes    = 1;
-         obj.updated_votes  = 0;
-      });
-   }
+   // The vote master summary is updated once per transaction, see database::apply_pending_master_votes
+   auto& pending = trx_state->pending_master_votes;
+   auto itr = std::find_if( pending.begin(), pending.end(),
+                            [&o]( const std::pair<account_id_type, uint64_t>& p ) { return p.first == o.master_account; } );
+   if( itr != pending.end() )
+      ++itr->second;
+   else
+      pending.emplace_back( o.master_account, 1 );
    return new_vote_object.id;
 } FC_CAPTURE_AND_RETHROW((o)) }
 
@@ -24,6 +24,50 @@
 
 namespace graphene { namespace chain {
 
+namespace {
+   /// Parses a decimal number without sign and leading zeros
+   bool parse_id_part( const char*& p, const char* end, uint64_t max, uint64_t& result )
+   {
+      const char* start = p;
+      result = 0;
+      for( ; p != end && *p >= '0' && *p <= '9'; ++p )
+      {
+         if( p != start && result == 0 )
+            return false;
+         result = result * 10 + uint64_t( *p - '0' );
+         if( result > max )
+            return false;
+      }
+      return p != start;
+   }
+}
+
+compact_content_id::compact_content_id( const string& s )
+{
+   const char* p = s.data();
+   const char* end = p + s.size();
+   uint64_t space = 0;
+   uint64_t type = 0;
+   uint64_t instance = 0;
+   if( parse_id_part( p, end, 0xff, space ) && p != end && *p++ == '.'
+         && parse_id_part( p, end, 0xff, type ) && p != end && *p++ == '.'
+         && parse_id_part( p, end, GRAPHENE_DB_MAX_INSTANCE_ID, instance ) && p == end )
+   {
+      _number = ( space << 56 ) | ( type << 48 ) | instance;
+      _text.reset();
+   }
+   else
+      _text.reset( new string( s ) );
+}
+
+string compact_content_id::str()const
+{
+   if( _text )
+      return *_text;
+   return std::to_string( _number >> 56 ) + "." + std::to_string( ( _number >> 48 ) & 0xff ) + "."
+          + std::to_string( _number & GRAPHENE_DB_MAX_INSTANCE_ID );
+}
+
 } } // graphene::chain
 
 FC_REFLECT_DERIVED_NO_TYPENAME( graphene::chain::content_vote_object,
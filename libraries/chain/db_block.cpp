@@ -26,12 +26,15 @@
 #include <graphene/chain/db_with.hpp>
 #include <graphene/chain/hardfork.hpp>
 
+#include <graphene/chain/asset_object.hpp>
 #include <graphene/chain/block_summary_object.hpp>
+#include <graphene/chain/custom_authority_object.hpp>
 #include <graphene/chain/global_property_object.hpp>
 #include <graphene/chain/operation_history_object.hpp>
 
 #include <graphene/chain/proposal_object.hpp>
 #include <graphene/chain/transaction_history_object.hpp>
+#include <graphene/chain/vote_master_summary_object.hpp>
 #include <graphene/chain/witness_object.hpp>
 #include <graphene/chain/exceptions.hpp>
 #include <graphene/chain/evaluator.hpp>
@@ -40,7 +43,9 @@
 #include <graphene/protocol/fee_schedule.hpp>
 
 #include <fc/io/raw.hpp>
-#include <fc/thread/parallel.hpp>
+#include <graphene/db/task_pool.hpp>
+
+#include <atomic>
 
 namespace graphene { namespace chain {
 
@@ -56,7 +61,7 @@ bool database::is_known_block( const block_id_type& id )const
 bool database::is_known_transaction( const transaction_id_type& id )const
 {
    const auto& trx_idx = get_index_type<transaction_index>().indices().get<by_trx_id>();
-   return trx_idx.find( id ) != trx_idx.end();
+   return trx_idx.find( id ) != trx_idx.end() || _pending_tx.contains( id );
 }
 
 block_id_type  database::get_block_id_for_num( uint32_t block_num )const
@@ -64,28 +69,64 @@ block_id_type  database::get_block_id_for_num( uint32_t block_num )const
    return _block_id_to_block.fetch_block_id( block_num );
 } FC_CAPTURE_AND_RETHROW( (block_num) ) }
 
+vector<block_id_type> database::get_block_ids_for_nums( const vector<uint32_t>& block_nums )const
+{ try {
+   return _block_id_to_block.fetch_block_ids( block_nums );
+} FC_CAPTURE_AND_RETHROW( (block_nums) ) }
+
 optional<signed_block> database::fetch_block_by_id( const block_id_type& id )const
 {
    auto b = _fork_db.fetch_block( id );
    if( !b )
       return _block_id_to_block.fetch_optional(id);
-   return b->data;
+   return *b->block();
 }
 
 optional<signed_block> database::fetch_block_by_number( uint32_t num )const
 {
    auto results = _fork_db.fetch_block_by_number(num);
    if( results.size() == 1 )
-      return results[0]->data;
+      return *results[0]->block();
    else
       return _block_id_to_block.fetch_by_number(num);
 }
 
+bool database::fetch_packed_block_by_number( uint32_t num, vector<char>& data )const
+{
+   auto results = _fork_db.fetch_block_by_number(num);
+   if( results.size() == 1 )
+   {
+      data = *results[0]->packed;
+      return true;
+   }
+   block_id_type id;
+   return _block_id_to_block.fetch_packed_by_number( num, id, data );
+}
+
+bool database::fetch_packed_block_by_id( const block_id_type& id, vector<char>& data )const
+{
+   auto item = _fork_db.fetch_block( id );
+   if( item )
+   {
+      data = *item->packed;
+      return true;
+   }
+   block_id_type stored_id;
+   return _block_id_to_block.fetch_packed_by_number( block_header::num_from_id( id ), stored_id, data )
+          && stored_id == id;
+}
+
 const signed_transaction& database::get_recent_transaction(const transaction_id_type& trx_id) const
 {
    auto& index = get_index_type<transaction_index>().indices().get<by_trx_id>();
    auto itr = index.find(trx_id);
-   FC_ASSERT(itr != index.end());
+   if( itr == index.end() )
+   {
+      // transactions which are not applied to the pending state are only in the pool
+      const pooled_transaction* pooled = _pending_tx.find( trx_id );
+      FC_ASSERT( pooled != nullptr );
+      return pooled->trx;
+   }
    return itr->trx;
 }
 
@@ -119,7 +160,8 @@ bool database::push_block(const signed_block& new_block, uint32_t skip)
    bool result;
    detail::with_skip_flags( *this, skip, [&]()
    {
-      detail::without_pending_transactions( *this, std::move(_pending_tx),
+      _pending_tx.trim();
+      detail::without_pending_transactions( *this, _pending_tx.extract(),
       [&]()
       {
          result = _push_block(new_block);
@@ -128,6 +170,12 @@ bool database::push_block(const signed_block& new_block, uint32_t skip)
    return result;
 }
 
+/// Checks which only depend on a block and the state it is applied to, a block which has been applied successfully
+/// passes them again when it is applied to the same state while switching forks
+static const uint32_t skip_revalidation = database::skip_witness_signature | database::skip_transaction_signatures
+                                          | database::skip_tapos_check | database::skip_merkle_check
+                                          | database::skip_block_size_check | database::skip_witness_schedule_check;
+
 bool database::_push_block(const signed_block& new_block)
 { try {
    uint32_t skip = get_node_properties().skip_flags;
@@ -144,17 +192,17 @@ bool database::_push_block(const signed_block& new_block)
 
    const shared_ptr<fork_item> new_head = _fork_db.push_block(new_block);
    //If the head block from the longest chain does not build off of the current head, we need to switch forks.
-   if( new_head->data.previous != head_block_id() )
+   if( new_head->previous != head_block_id() )
    {
       //If the newly pushed block is the same height as head, we get head back in new_head
       //Only switch forks if new_head is actually higher than head
-      if( new_head->data.block_num() > head_block_num() )
+      if( new_head->num > head_block_num() )
       {
-         wlog( "Switching to fork: ${id}", ("id",new_head->data.id()) );
-         auto branches = _fork_db.fetch_branch_from(new_head->data.id(), head_block_id());
+         wlog( "Switching to fork: ${id}", ("id",new_head->id) );
+         auto branches = _fork_db.fetch_branch_from(new_head->id, head_block_id());
 
          // pop blocks until we hit the forked block
-         while( head_block_id() != branches.second.back()->data.previous )
+         while( head_block_id() != branches.second.back()->previous )
          {
             ilog( "popping block #${n} ${id}", ("n",head_block_num())("id",head_block_id()) );
             pop_block();
@@ -163,14 +211,18 @@ bool database::_push_block(const signed_block& new_block)
          // push all blocks on the new fork
          for( auto ritr = branches.first.rbegin(); ritr != branches.first.rend(); ++ritr )
          {
-               ilog( "pushing block from fork #${n} ${id}", ("n",(*ritr)->data.block_num())("id",(*ritr)->id) );
+               ilog( "pushing block from fork #${n} ${id}", ("n",(*ritr)->num)("id",(*ritr)->id) );
                optional<fc::exception> except;
                try {
                   undo_database::session session = _undo_db.start_undo_session();
-                  apply_block( (*ritr)->data, skip );
+                  apply_block( *(*ritr)->block(), (*ritr)->applied ? ( skip | skip_revalidation ) : skip );
                   update_witnesses( **ritr );
-                  _block_id_to_block.store( (*ritr)->id, (*ritr)->data );
+                  _block_id_to_block.store( (*ritr)->id, (*ritr)->packed );
                   session.commit();
+                  (*ritr)->applied = true;
+                  // the decoded blocks of the other branch were kept for their precomputed signees
+                  if( *ritr != new_head )
+                     (*ritr)->release_decoded();
                }
                catch ( const fc::exception& e ) { except = e; }
                if( except )
@@ -179,32 +231,33 @@ bool database::_push_block(const signed_block& new_block)
                   // remove the rest of branches.first from the fork_db, those blocks are invalid
                   while( ritr != branches.first.rend() )
                   {
-                     ilog( "removing block from fork_db #${n} ${id}", ("n",(*ritr)->data.block_num())("id",(*ritr)->id) );
+                     ilog( "removing block from fork_db #${n} ${id}", ("n",(*ritr)->num)("id",(*ritr)->id) );
                      _fork_db.remove( (*ritr)->id );
                      ++ritr;
                   }
                   _fork_db.set_head( branches.second.front() );
 
                   // pop all blocks from the bad fork
-                  while( head_block_id() != branches.second.back()->data.previous )
+                  while( head_block_id() != branches.second.back()->previous )
                   {
                      ilog( "popping block #${n} ${id}", ("n",head_block_num())("id",head_block_id()) );
                      pop_block();
                   }
 
-                  ilog( "Switching back to fork: ${id}", ("id",branches.second.front()->data.id()) );
-                  // restore all blocks from the good fork
+                  ilog( "Switching back to fork: ${id}", ("id",branches.second.front()->id) );
+                  // restore all blocks from the good fork, they have been applied to the same state before
                   for( auto ritr2 = branches.second.rbegin(); ritr2 != branches.second.rend(); ++ritr2 )
                   {
-                     ilog( "pushing block #${n} ${id}", ("n",(*ritr2)->data.block_num())("id",(*ritr2)->id) );
+                     ilog( "pushing block #${n} ${id}", ("n",(*ritr2)->num)("id",(*ritr2)->id) );
                      auto session = _undo_db.start_undo_session();
-                     apply_block( (*ritr2)->data, skip );
-                     _block_id_to_block.store( (*ritr2)->id, (*ritr2)->data );
+                     apply_block( *(*ritr2)->block(), skip | skip_revalidation );
+                     _block_id_to_block.store( (*ritr2)->id, (*ritr2)->packed );
                      session.commit();
                   }
                   throw *except;
                }
          }
+         _block_id_to_block.flush_through( get_dynamic_global_properties().last_irreversible_block_num );
          return true;
       }
       else return false;
@@ -215,8 +268,13 @@ bool database::_push_block(const signed_block& new_block)
       apply_block(new_block, skip);
       if( new_block.timestamp.sec_since_epoch() > now - 86400 )
          update_witnesses( *new_head );
-      _block_id_to_block.store(new_block.id(), new_block);
+      _block_id_to_block.store(new_block.id(), new_head->packed);
+      _block_id_to_block.flush_through( get_dynamic_global_properties().last_irreversible_block_num );
+      if( _block_log_retain_blocks > 0 && head_block_num() > _block_log_retain_blocks )
+         _block_id_to_block.prune( std::min( head_block_num() - _block_log_retain_blocks + 1,
+                                             get_dynamic_global_properties().last_irreversible_block_num ) );
       session.commit();
+      new_head->applied = true;
    } catch ( const fc::exception& e ) {
       elog("Failed to push new block:\n${e}", ("e", e.to_detail_string()));
       _fork_db.remove( new_block.id() );
@@ -278,6 +336,9 @@ processed_transaction database::push_transaction( const precomputable_transactio
 
 processed_transaction database::_push_transaction( const precomputable_transaction& trx )
 {
+   pooled_transaction entry = make_pooled_transaction( trx );
+   _pending_tx.check_admission( entry );
+
    // If this is the first transaction pushed after applying a block, start a new undo session.
    // This allows us to quickly rewind to the clean state of the head block, in case a new block arrives.
    if( !_pending_tx_session.valid() )
@@ -289,8 +350,17 @@ processed_transaction database::_push_transaction( const precomputable_transacti
    // apply the changes.
 
    auto temp_session = _undo_db.start_undo_session();
+   const fc::time_point apply_start = fc::time_point::now();
    auto processed_trx = _apply_transaction( trx );
-   _pending_tx.push_back(processed_trx);
+   note_transaction_cost( trx, fc::time_point::now() - apply_start );
+   if( _speculative_block_assembly )
+   {
+      _pending_state_skip_flags |= get_node_properties().skip_flags;
+      _pending_state_size += fc::raw::pack_size( processed_trx );
+   }
+   entry.trx = processed_trx;
+   entry.applied = true;
+   _pending_tx.insert( std::move( entry ) );
 
    // notify_changed_objects();
    // The transaction applied successfully. Merge its changes into the pending block session.
@@ -301,6 +371,101 @@ processed_transaction database::_push_transaction( const precomputable_transacti
    return processed_trx;
 }
 
+void database::check_network_transaction_admission( const precomputable_transaction& trx )const
+{
+   _pending_tx.check_network_admission( make_pooled_transaction( trx ), estimate_transaction_cost( trx ) );
+}
+
+void database::set_block_packing_budget( fc::microseconds packing_budget, fc::microseconds transaction_budget )
+{
+   FC_ASSERT( packing_budget.count() >= 0 && transaction_budget.count() >= 0 );
+   _block_packing_budget = packing_budget;
+   _transaction_cost_budget = transaction_budget;
+}
+
+void database::set_speculative_block_assembly( bool enable )
+{
+   _speculative_block_assembly = enable;
+   // the sizes of the transactions applied so far are not known
+   _pending_state_complete = _pending_state_complete && _pending_tx.empty();
+}
+
+fc::microseconds database::estimate_transaction_cost( const transaction& trx )const
+{
+   uint64_t cost = 0;
+   for( const operation& op : trx.operations )
+   {
+      const size_t tag = op.which();
+      if( tag < _recent_operation_cost_us.size() )
+         cost += _recent_operation_cost_us[tag];
+   }
+   return fc::microseconds( cost );
+}
+
+void database::note_transaction_cost( const transaction& trx, fc::microseconds elapsed )
+{
+   if( trx.operations.empty() )
+      return;
+   if( _recent_operation_cost_us.empty() )
+      _recent_operation_cost_us.resize( operation::count(), 0 );
+   // without a per-operation measurement, attribute the time evenly to the operations of the transaction,
+   // count at least the timer resolution, no operation is free
+   const uint64_t sample = std::max<uint64_t>( std::max<int64_t>( elapsed.count(), 0 ) / trx.operations.size(), 1 );
+   for( const operation& op : trx.operations )
+   {
+      uint64_t& cost = _recent_operation_cost_us[op.which()];
+      cost = ( cost == 0 ) ? sample : ( cost * 7 + sample ) / 8;
+   }
+}
+
+void database::_defer_transaction( pooled_transaction entry )
+{
+   // keep the invariant that there is a pending session whenever there are pending transactions
+   if( !_pending_tx_session.valid() )
+      _pending_tx_session = _undo_db.start_undo_session();
+   entry.applied = false;
+   _pending_tx.check_admission( entry );
+   _pending_tx.insert( std::move( entry ) );
+}
+
+/// Extracts the fee and the fee paying account of an operation
+struct pooled_transaction_fee_visitor
+{
+   struct result
+   {
+      asset           fee;
+      account_id_type payer;
+   };
+   typedef result result_type;
+
+   template<typename Op>
+   result operator()( const Op& op )const { return result{ op.fee, op.fee_payer() }; }
+};
+
+pooled_transaction database::make_pooled_transaction( const precomputable_transaction& trx )const
+{
+   pooled_transaction entry;
+   entry.id = trx.id();
+   entry.expiration = trx.expiration;
+   entry.size = fc::raw::pack_size( trx );
+
+   // the fee is converted to core asset, so that transactions paying in different assets are comparable
+   share_type core_fee = 0;
+   for( const operation& op : trx.operations )
+   {
+      const asset fee = op.visit( pooled_transaction_fee_visitor() ).fee;
+      if( fee.asset_id == asset_id_type() )
+         core_fee += fee.amount;
+      else if( const asset_object* a = find( fee.asset_id ) )
+         core_fee += ( fee * a->options.core_exchange_rate ).amount;
+   }
+   if( core_fee > 0 && entry.size > 0 )
+      entry.fee_per_kb = uint64_t( core_fee.value ) * 1024 / entry.size;
+   if( !trx.operations.empty() )
+      entry.account = trx.operations.front().visit( pooled_transaction_fee_visitor() ).payer;
+   return entry;
+}
+
 processed_transaction database::validate_transaction( const signed_transaction& trx )
 {
    auto session = _undo_db.start_undo_session();
@@ -341,7 +506,12 @@ processed_transaction database::push_proposal(const proposal_object& proposal)
          _undo_db.set_max_size( _undo_db.size() + 1 );
       auto session = _undo_db.start_undo_session(true);
       for( auto& op : proposal.proposed_transaction.operations )
+      {
+         if( !op.is_type<content_vote_create_operation>() )
+            apply_pending_master_votes(eval_state);
          eval_state.operation_results.emplace_back(apply_operation(eval_state, op));
+      }
+      apply_pending_master_votes(eval_state);
       remove(proposal);
       session.merge();
    } catch ( const fc::exception& e ) {
@@ -382,6 +552,33 @@ signed_block database::_generate_block(
    witness_id_type scheduled_witness = get_scheduled_witness( slot_num );
    FC_ASSERT( scheduled_witness == witness_id );
 
+   static const size_t max_partial_block_header_size = fc::raw::pack_size( signed_block_header() )
+                                                       - fc::raw::pack_size( witness_id_type() ) // witness_id
+                                                       + 3; // max space to store size of transactions (out of block header),
+                                                            // +3 means 3*7=21 bits so it's practically safe
+   const size_t max_block_header_size = max_partial_block_header_size + fc::raw::pack_size( witness_id );
+
+   if( _speculative_block_assembly )
+   {
+      try
+      {
+         optional<signed_block> block = _generate_block_from_pending_state( when, witness_id,
+                                                                           block_signing_private_key,
+                                                                           max_block_header_size );
+         if( block.valid() )
+            return *block;
+      }
+      catch( const fc::canceled_exception& )
+      {
+         throw;
+      }
+      catch( const fc::exception& e )
+      {
+         wlog( "Failed to generate a block from the pending state, applying the pending transactions again: ${e}",
+               ("e", e.to_detail_string()) );
+      }
+   }
+
    //
    // The following code throws away existing pending_tx_session and
    // rebuilds it by re-applying pending transactions.
@@ -396,6 +593,9 @@ signed_block database::_generate_block(
 
    // pop pending state (reset to head block state)
    _pending_tx_session.reset();
+   _pending_state_complete = false;
+   // expired transactions would fail anyway
+   _pending_tx.remove_expired( when );
 
    // Check witness signing key
    if( !(skip & skip_witness_signature) )
@@ -408,21 +608,23 @@ signed_block database::_generate_block(
       FC_ASSERT( witness_id(*this).signing_key == block_signing_private_key.get_public_key() );
    }
 
-   static const size_t max_partial_block_header_size = fc::raw::pack_size( signed_block_header() )
-                                                       - fc::raw::pack_size( witness_id_type() ) // witness_id
-                                                       + 3; // max space to store size of transactions (out of block header),
-                                                            // +3 means 3*7=21 bits so it's practically safe
-   const size_t max_block_header_size = max_partial_block_header_size + fc::raw::pack_size( witness_id );
    auto maximum_block_size = get_global_properties().parameters.maximum_block_size;
    size_t total_block_size = max_block_header_size;
 
    signed_block pending_block;
+   block_generation_timings timings;
+   fc::time_point step_start = fc::time_point::now();
 
    _pending_tx_session = _undo_db.start_undo_session();
 
+   const fc::time_point packing_deadline = ( _block_packing_budget.count() > 0 )
+                                           ? step_start + _block_packing_budget : fc::time_point::maximum();
    uint64_t postponed_tx_count = 0;
-   for( const processed_transaction& tx : _pending_tx )
+   uint64_t budget_deferred_tx_count = 0;
+   bool over_budget_tx_packed = false;
+   for( const pooled_transaction& entry : _pending_tx.transactions() )
    {
+      const processed_transaction& tx = entry.trx;
       size_t new_total_size = total_block_size + fc::raw::pack_size( tx );
 
       // postpone transaction if it would make block too big
@@ -432,10 +634,30 @@ signed_block database::_generate_block(
          continue;
       }
 
+      // postpone transaction if it is expected to be too expensive or to miss the deadline, but pack one of
+      // them per block while time is left, so that no type of operation can be starved by the budgets
+      const fc::time_point apply_start = fc::time_point::now();
+      if( _block_packing_budget.count() > 0 || _transaction_cost_budget.count() > 0 )
+      {
+         const fc::microseconds estimated_cost = estimate_transaction_cost( tx );
+         if( ( _transaction_cost_budget.count() > 0 && estimated_cost > _transaction_cost_budget )
+               || apply_start + estimated_cost > packing_deadline )
+         {
+            if( over_budget_tx_packed || apply_start >= packing_deadline )
+            {
+               postponed_tx_count++;
+               budget_deferred_tx_count++;
+               continue;
+            }
+            over_budget_tx_packed = true;
+         }
+      }
+
       try
       {
          auto temp_session = _undo_db.start_undo_session();
          processed_transaction ptx = _apply_transaction( tx );
+         note_transaction_cost( tx, fc::time_point::now() - apply_start );
 
          // We have to recompute pack_size(ptx) because it may be different
          // than pack_size(tx) (i.e. if one or more results increased
@@ -462,7 +684,8 @@ signed_block database::_generate_block(
    }
    if( postponed_tx_count > 0 )
    {
-      wlog( "Postponed ${n} transactions due to block size limit", ("n", postponed_tx_count) );
+      wlog( "Postponed ${n} transactions due to block size limit or packing time budget, ${b} of them due to time",
+            ("n", postponed_tx_count)("b", budget_deferred_tx_count) );
    }
 
    _pending_tx_session.reset();
@@ -473,18 +696,99 @@ signed_block database::_generate_block(
    // However, the push_block() call below will re-create the
    // _pending_tx_session.
 
+   timings.postponed_transactions = postponed_tx_count;
+   timings.deferred_by_budget = budget_deferred_tx_count;
+   _finish_generated_block( pending_block, when, witness_id, block_signing_private_key, timings, step_start );
+
+   return pending_block;
+} FC_CAPTURE_AND_RETHROW( (witness_id) ) }
+
+optional<signed_block> database::_generate_block_from_pending_state(
+   fc::time_point_sec when,
+   witness_id_type witness_id,
+   const fc::ecc::private_key& block_signing_private_key,
+   size_t max_block_header_size )
+{
+   // transactions applied with fewer checks than the generation does might not be valid
+   const uint32_t skip = get_node_properties().skip_flags;
+   if( !_pending_state_complete || ( _pending_state_skip_flags & ~skip ) != 0 || !_popped_tx.empty() )
+      return {};
+
+   const size_t maximum_block_size = get_global_properties().parameters.maximum_block_size;
+   // only compute the sizes of the transactions one by one if they do not fit
+   const bool all_fit = max_block_header_size + _pending_state_size <= maximum_block_size;
+   size_t total_block_size = max_block_header_size;
+
+   signed_block pending_block;
+   block_generation_timings timings;
+   const fc::time_point step_start = fc::time_point::now();
+
+   uint64_t postponed_tx_count = 0;
+   for( const pooled_transaction& entry : _pending_tx.transactions() )
+   {
+      // transactions which are not applied do not affect the pending state
+      if( !entry.applied )
+         continue;
+      // the transactions following one which does not fit are postponed too
+      if( postponed_tx_count > 0 )
+      {
+         postponed_tx_count++;
+         continue;
+      }
+      // leaving out a transaction would change the state the following transactions were applied to
+      if( entry.expiration < when )
+         return {};
+      if( !all_fit )
+      {
+         total_block_size += fc::raw::pack_size( entry.trx );
+         if( total_block_size > maximum_block_size )
+         {
+            postponed_tx_count++;
+            continue;
+         }
+      }
+      pending_block.transactions.push_back( entry.trx );
+   }
+
+   timings.postponed_transactions = postponed_tx_count;
+   timings.from_pending_state = true;
+   // push_block() rebuilds the pending state from the pool
+   _finish_generated_block( pending_block, when, witness_id, block_signing_private_key, timings, step_start );
+
+   return pending_block;
+}
+
+void database::_finish_generated_block(
+   signed_block& pending_block,
+   fc::time_point_sec when,
+   witness_id_type witness_id,
+   const fc::ecc::private_key& block_signing_private_key,
+   block_generation_timings& timings,
+   fc::time_point packing_start )
+{
+   const uint32_t skip = get_node_properties().skip_flags;
+
    pending_block.previous = head_block_id();
    pending_block.timestamp = when;
    pending_block.transaction_merkle_root = pending_block.calculate_merkle_root();
    pending_block.witness = witness_id;
 
+   fc::time_point now = fc::time_point::now();
+   timings.packing = now - packing_start;
+   fc::time_point step_start = now;
+
    if( !(skip & skip_witness_signature) )
       pending_block.sign( block_signing_private_key );
 
+   now = fc::time_point::now();
+   timings.signing = now - step_start;
+   step_start = now;
+
    push_block( pending_block, skip | skip_transaction_signatures ); // skip authority check when pushing self-generated blocks
 
-   return pending_block;
-} FC_CAPTURE_AND_RETHROW( (witness_id) ) }
+   timings.pushing = fc::time_point::now() - step_start;
+   _last_generation_timings = timings;
+}
 
 /**
  * Removes the most recent block from the database and
@@ -502,8 +806,11 @@ void database::pop_block()
       fork_db_head = _fork_db.fetch_block( head_block_id() );
       FC_ASSERT( fork_db_head, "Trying to pop() block that's not in fork database!?" );
    }
+   _pending_state_complete = false;
    pop_undo();
-   _popped_tx.insert( _popped_tx.begin(), fork_db_head->data.transactions.begin(), fork_db_head->data.transactions.end() );
+   _block_state_hashes.erase( _block_state_hashes.upper_bound( head_block_num() ), _block_state_hashes.end() );
+   const auto popped_block = fork_db_head->block();
+   _popped_tx.insert( _popped_tx.begin(), popped_block->transactions.begin(), popped_block->transactions.end() );
 } FC_CAPTURE_AND_RETHROW() }
 
 void database::clear_pending()
@@ -511,6 +818,9 @@ void database::clear_pending()
    assert( (_pending_tx.size() == 0) || _pending_tx_session.valid() );
    _pending_tx.clear();
    _pending_tx_session.reset();
+   _pending_state_complete = true;
+   _pending_state_skip_flags = 0;
+   _pending_state_size = 0;
 } FC_CAPTURE_AND_RETHROW() }
 
 uint32_t database::push_applied_operation( const operation& op )
@@ -536,7 +846,7 @@ void database::set_applied_operation_result( uint32_t op_id, const operation_res
 
 const vector<optional< operation_history_object > >& database::get_applied_operations() const
 {
-   return _applied_ops;
+   return _shared_applied_ops ? *_shared_applied_ops : _applied_ops;
 }
 
 //////////////////// private methods ////////////////////
@@ -549,10 +859,8 @@ void database::apply_block( const signed_block& next_block, uint32_t skip )
       auto itr = _checkpoints.find( block_num );
       if( itr != _checkpoints.end() )
          FC_ASSERT( next_block.id() == itr->second, "Block did not match checkpoint", ("checkpoint",*itr)("block_id",next_block.id()) );
-
-      if( _checkpoints.rbegin()->first >= block_num )
-         skip = ~0;// WE CAN SKIP ALMOST EVERYTHING
    }
+   skip = checkpoint_skip_flags( block_num, skip );
 
    detail::with_skip_flags( *this, skip, [&]()
    {
@@ -566,6 +874,7 @@ void database::_apply_block( const signed_block& next_block )
    uint32_t next_block_num = next_block.block_num();
    uint32_t skip = get_node_properties().skip_flags;
    _applied_ops.clear();
+   _shared_applied_ops.reset();
 
    if( !(skip & skip_block_size_check) )
    {
@@ -579,6 +888,12 @@ void database::_apply_block( const signed_block& next_block )
               ("next_block",next_block)
               ("id",next_block.id()) );
 
+#ifdef GRAPHENE_PAST_HARDFORKS_TIME
+   FC_ASSERT( next_block.timestamp > fc::time_point_sec( GRAPHENE_PAST_HARDFORKS_TIME ),
+              "This node is built to take the hardforks up to ${t} as passed and can not apply older blocks",
+              ("t", fc::time_point_sec( GRAPHENE_PAST_HARDFORKS_TIME )) );
+#endif
+
    const witness_object& signing_witness = validate_block_header(skip, next_block);
    const auto& global_props = get_global_properties();
    const auto& dynamic_global_props = get_dynamic_global_properties();
@@ -593,6 +908,8 @@ void database::_apply_block( const signed_block& next_block )
    _current_block_num    = next_block_num;
    _current_trx_in_block = 0;
 
+   const vector<char> pre_verified = verify_authorities_parallel( next_block );
+
    for( const auto& trx : next_block.transactions )
    {
       /* We do not need to push the undo state for each transaction
@@ -601,7 +918,10 @@ void database::_apply_block( const signed_block& next_block )
        * for transactions when validating broadcast transactions or
        * when building a block.
        */
-      apply_transaction( trx, skip );
+      if( !pre_verified.empty() && pre_verified[_current_trx_in_block] )
+         apply_transaction( trx, skip | skip_transaction_signatures );
+      else
+         apply_transaction( trx, skip );
       ++_current_trx_in_block;
    }
 
@@ -638,13 +958,132 @@ void database::_apply_block( const signed_block& next_block )
    if( !_node_property_object.debug_updates.empty() )
       apply_debug_updates();
 
+   if( _state_hash_blocks > 0 )
+   {
+      _block_state_hashes.erase( _block_state_hashes.lower_bound( next_block_num ), _block_state_hashes.end() );
+      block_state_hash& h = _block_state_hashes[ next_block_num ];
+      h.block_num = next_block_num;
+      h.block_id = next_block.id();
+      h.indexes = get_index_state_hashes();
+      h.state_hash = fc::sha256::hash( h.indexes );
+      while( _block_state_hashes.size() > _state_hash_blocks )
+         _block_state_hashes.erase( _block_state_hashes.begin() );
+   }
+
+   _shared_applied_ops = std::make_shared< const vector< optional< operation_history_object > > >(
+                               std::move( _applied_ops ) );
+   _applied_ops.clear();
+
+   if( _applied_ops_log.is_open() )
+   {
+      _applied_ops_log.add_block( next_block_num, next_block.timestamp, _shared_applied_ops );
+      _applied_ops_log.write_irreversible( get_dynamic_global_properties().last_irreversible_block_num );
+   }
+
+   if( _state_delta_log.is_open() && _undo_db.enabled() && _undo_db.active_sessions() > 0 )
+   {
+      _state_delta_log.add_block( make_state_delta( next_block ) );
+      _state_delta_log.write_irreversible( get_dynamic_global_properties().last_irreversible_block_num );
+   }
+
    // notify observers that the block has been applied
    notify_applied_block( next_block ); //emit
-   _applied_ops.clear();
+   _shared_applied_ops.reset();
 
    notify_changed_objects();
 } FC_CAPTURE_AND_RETHROW( (next_block.block_num()) )  }
 
+state_delta database::make_state_delta( const signed_block& block )const
+{
+   using graphene::db::undo_entry;
+   state_delta delta;
+   delta.block = block;
+   const auto& head_undo = _undo_db.head();
+   // an object has a single entry in the undo state, modified objects keep the order of their first change
+   vector<object_id_type> changed_ids;
+   vector<object_id_type> created_ids;
+   for( const auto& entry : head_undo.changes )
+   {
+      if( entry.kind == undo_entry::modified )
+         changed_ids.push_back( entry.id );
+      else if( entry.kind == undo_entry::created )
+         created_ids.push_back( entry.id );
+      else if( entry.kind == undo_entry::removed )
+         delta.removed.push_back( entry.id );
+   }
+   // objects are created in order of their IDs, so that replicas create them with the same IDs
+   std::sort( created_ids.begin(), created_ids.end() );
+   changed_ids.insert( changed_ids.end(), created_ids.begin(), created_ids.end() );
+   delta.objects.reserve( changed_ids.size() );
+   for( const object_id_type& id : changed_ids )
+   {
+      const object* obj = find_object( id );
+      if( obj != nullptr )
+         delta.objects.push_back( { id, obj->pack() } );
+   }
+   if( _shared_applied_ops )
+      delta.applied_ops = *_shared_applied_ops;
+   delta.next_ids.reserve( head_undo.old_index_next_ids.size() );
+   for( const auto& item : head_undo.old_index_next_ids )
+      delta.next_ids.push_back( get_index( item.first ).get_next_id() );
+   return delta;
+}
+
+void database::apply_state_delta( const state_delta& delta )
+{ try {
+   FC_ASSERT( delta.block.previous == head_block_id(),
+              "The state delta of block ${n} does not follow the head block ${h}",
+              ("n", delta.block.block_num())("h", head_block_num()) );
+   _pending_tx.trim();
+   detail::without_pending_transactions( *this, _pending_tx.extract(), [&]()
+   {
+      // the session makes the delta apply atomically and collects the changes for the observers
+      auto session = _undo_db.start_undo_session();
+      // removals first and creations last, so that unique keys freed by the block are free when they are taken
+      // again, changes in the order the block made them
+      for( const object_id_type& id : delta.removed )
+         remove( get_object( id ) );
+      vector<const state_delta_object*> created;
+      for( const state_delta_object& item : delta.objects )
+      {
+         const object* obj = find_object( item.id );
+         if( obj == nullptr )
+         {
+            created.push_back( &item );
+            continue;
+         }
+         modify( *obj, [&item]( object& o ) {
+            const uint64_t undo_seq = o.undo_seq;
+            o.unpack_from( item.data );
+            o.undo_seq = undo_seq;
+         });
+      }
+      for( const state_delta_object* item : created )
+      {
+         // IDs of objects which were created and removed again by the block are skipped
+         auto& idx = get_mutable_index( item->id );
+         idx.set_next_id( item->id );
+         idx.create( [item]( object& o ) {
+            o.unpack_from( item->data );
+         });
+      }
+      for( const object_id_type& next_id : delta.next_ids )
+         get_mutable_index( next_id ).set_next_id( next_id );
+
+      // the block is irreversible, so it is the only one the fork database needs to know
+      _block_id_to_block.store( delta.block.id(), delta.block );
+      _fork_db.reset();
+      _fork_db.start_block( delta.block );
+
+      _shared_applied_ops = std::make_shared< const vector< optional< operation_history_object > > >(
+                                  delta.applied_ops );
+      notify_applied_block( delta.block );
+      _shared_applied_ops.reset();
+      notify_changed_objects();
+      session.commit();
+   });
+} FC_CAPTURE_AND_RETHROW( (delta.block.block_num()) ) }
+
 
 
 processed_transaction database::apply_transaction(const signed_transaction& trx, uint32_t skip)
@@ -659,6 +1098,7 @@ processed_transaction database::apply_transaction(const signed_transaction& trx,
 
 processed_transaction database::_apply_transaction(const signed_transaction& trx)
 { try {
+   scoped_apply_timer timer( _apply_timing_enabled ? &_transaction_timer : nullptr );
    uint32_t skip = get_node_properties().skip_flags;
 
    trx.validate();
@@ -728,9 +1168,12 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
    for( const auto& op : ptrx.operations )
    {
       _current_virtual_op = 0;
+      if( !op.is_type<content_vote_create_operation>() )
+         apply_pending_master_votes(eval_state);
       eval_state.operation_results.emplace_back(apply_operation(eval_state, op));
       ++_current_op_in_trx;
    }
+   apply_pending_master_votes(eval_state);
    ptrx.operation_results = std::move(eval_state.operation_results);
 
    return ptrx;
@@ -742,14 +1185,137 @@ operation_result database::apply_operation(transaction_evaluation_state& eval_st
    uint64_t u_which = uint64_t( i_which );
    FC_ASSERT( i_which >= 0, "Negative operation tag in operation ${op}", ("op",op) );
    FC_ASSERT( u_which < _operation_evaluators.size(), "No registered evaluator for operation ${op}", ("op",op) );
-   unique_ptr<op_evaluator>& eval = _operation_evaluators[ u_which ];
+   const op_evaluator_function eval = _operation_evaluators[ u_which ];
    FC_ASSERT( eval, "No registered evaluator for operation ${op}", ("op",op) );
    auto op_id = push_applied_operation( op );
-   auto result = eval->evaluate( eval_state, op, true );
+   scoped_apply_timer timer( _apply_timing_enabled ? &_operation_timers[ u_which ] : nullptr );
+   auto result = eval( eval_state, op, true );
    set_applied_operation_result( op_id, result );
    return result;
 } FC_CAPTURE_AND_RETHROW( (op) ) }
 
+namespace {
+   struct operation_name_visitor
+   {
+      typedef string result_type;
+      template<typename T>
+      string operator()( const T& )const
+      {
+         const string name = fc::get_typename<T>::name();
+         const auto pos = name.rfind( ':' );
+         return pos == string::npos ? name : name.substr( pos + 1 );
+      }
+   };
+}
+
+apply_timing_report database::get_apply_timing()const
+{
+   apply_timing_report result;
+   result.enabled = _apply_timing_enabled;
+   for( int64_t i = 0; i < operation::count(); ++i )
+   {
+      if( _operation_timers[i].count() == 0 )
+         continue;
+      operation op;
+      op.set_which( i );
+      result.operations.push_back( _operation_timers[i].get_stats( op.visit( operation_name_visitor() ) ) );
+   }
+   result.handlers.push_back( _transaction_timer.get_stats( "transaction" ) );
+   std::lock_guard<std::mutex> guard( _handler_timers_mutex );
+   for( const auto& item : _handler_timers )
+      result.handlers.push_back( item.second.get_stats( "applied_block:" + item.first ) );
+   return result;
+}
+
+void database::reset_apply_timing()
+{
+   for( int64_t i = 0; i < operation::count(); ++i )
+      _operation_timers[i].reset();
+   _transaction_timer.reset();
+   std::lock_guard<std::mutex> guard( _handler_timers_mutex );
+   for( auto& item : _handler_timers )
+      item.second.reset();
+}
+
+void database::set_state_hash_blocks( uint32_t blocks )
+{
+   _state_hash_blocks = blocks;
+   if( blocks > 0 )
+   {
+      for( const auto& type : _chain_index_types )
+         enable_state_hash( type.first, type.second );
+   }
+   while( _block_state_hashes.size() > _state_hash_blocks )
+      _block_state_hashes.erase( _block_state_hashes.begin() );
+}
+
+optional<block_state_hash> database::get_block_state_hash( uint32_t block_num )const
+{
+   auto itr = _block_state_hashes.find( block_num );
+   if( itr == _block_state_hashes.end() )
+      return {};
+   return itr->second;
+}
+
+std::shared_ptr<async_block_handler> database::connect_applied_block_async( const string& name, uint32_t capacity,
+                                                                              async_block_handler::handler_type handler )
+{
+   auto result = std::make_shared<async_block_handler>( name, capacity, std::move( handler ) );
+   std::weak_ptr<async_block_handler> weak = result;
+   connect_applied_block( name + " (queue)", [this,weak]( const signed_block& b ) {
+      auto h = weak.lock();
+      if( h )
+         h->post( applied_block_event{ b, get_shared_applied_operations() } );
+   });
+   std::lock_guard<std::mutex> guard( _async_block_handlers_mutex );
+   _async_block_handlers.push_back( weak );
+   return result;
+}
+
+vector<async_block_handler_stats> database::get_async_block_handler_stats()const
+{
+   vector<async_block_handler_stats> result;
+   std::lock_guard<std::mutex> guard( _async_block_handlers_mutex );
+   for( const auto& weak : _async_block_handlers )
+   {
+      auto h = weak.lock();
+      if( h )
+         result.push_back( h->get_stats() );
+   }
+   return result;
+}
+
+apply_timer& database::add_handler_timer( const string& name )
+{
+   std::lock_guard<std::mutex> guard( _handler_timers_mutex );
+   _handler_timers.emplace_back( std::piecewise_construct, std::forward_as_tuple( name ), std::forward_as_tuple() );
+   return _handler_timers.back().second;
+}
+
+void database::apply_pending_master_votes( transaction_evaluation_state& eval_state )
+{
+   const auto& by_master_idx = get_index_type<vote_master_summary_index>().indices().get<by_master_account>();
+   for( const auto& votes : eval_state.pending_master_votes )
+   {
+      auto itr = by_master_idx.find( votes.first );
+      if( itr != by_master_idx.end() )
+      {
+         modify( *itr, [&votes]( vote_master_summary_object& obj ) {
+            obj.total_votes += votes.second;
+         });
+      }
+      else
+      {
+         create<vote_master_summary_object>( [&votes]( vote_master_summary_object& obj ) {
+            obj.master_account = votes.first;
+            obj.total_votes    = votes.second;
+            obj.updated_votes  = 0;
+         });
+      }
+   }
+   eval_state.pending_master_votes.clear();
+}
+
 const witness_object& database::validate_block_header( uint32_t skip, const signed_block& next_block )const
 {
    FC_ASSERT( head_block_id() == next_block.previous, "", ("head_block_id",head_block_id())("next.prev",next_block.previous) );
@@ -792,6 +1358,75 @@ bool database::before_last_checkpoint()const
    return (_checkpoints.size() > 0) && (_checkpoints.rbegin()->first >= head_block_num());
 }
 
+uint32_t database::checkpoint_skip_flags( uint32_t block_num, uint32_t skip )const
+{
+   if( _checkpoints.size() && _checkpoints.rbegin()->second != block_id_type()
+         && _checkpoints.rbegin()->first >= block_num )
+      skip |= ~skip_merkle_check; // WE CAN SKIP ALMOST EVERYTHING, the merkle root ties the transactions to the ID
+   return skip;
+}
+
+
+/// @return true if the operation can change the outcome of authority verification of other transactions
+static bool operation_may_change_authorities( const operation& op )
+{
+   if( op.is_type<account_update_operation>() )
+   {
+      const auto& update = op.get<account_update_operation>();
+      return update.owner.valid() || update.active.valid();
+   }
+   // proposal updates can execute arbitrary proposed operations
+   return op.is_type<proposal_update_operation>()
+       || op.is_type<custom_authority_create_operation>()
+       || op.is_type<custom_authority_update_operation>();
+}
+
+vector<char> database::verify_authorities_parallel( const signed_block& block )const
+{ try {
+   vector<char> verified;
+   const uint32_t skip = get_node_properties().skip_flags;
+   const size_t count = block.transactions.size();
+   const uint32_t threads = graphene::db::task_pool::instance().thread_count();
+   if( (skip & skip_transaction_signatures) || count < 2 || threads < 2 )
+      return verified;
+
+   // Conflict detection: if any transaction can change authorities, transactions verified against the state
+   // before the block could be accepted wrongly, so the whole block is verified serially in that case.
+   for( const auto& trx : block.transactions )
+      for( const auto& op : trx.operations )
+         if( operation_may_change_authorities( op ) )
+            return verified;
+
+   verified.resize( count, 0 );
+   const chain_id_type& chain_id = get_chain_id();
+   const uint32_t max_depth = get_global_properties().parameters.max_authority_depth;
+   const auto& custom_idx = get_index_type<custom_authority_index>().indices().get<by_account_custom>();
+
+   auto get_active = [this]( account_id_type id ) { return &id(*this).active; };
+   auto get_owner  = [this]( account_id_type id ) { return &id(*this).owner;  };
+   // Evaluating custom authority predicates is not thread-safe, leave such transactions to serial verification
+   auto get_custom = [&custom_idx]( account_id_type id, const operation& op, rejected_predicate_map* ) {
+      auto range = custom_idx.equal_range( boost::make_tuple( id, unsigned_int( op.which() ), true ) );
+      FC_ASSERT( range.first == range.second, "Custom authorities can only be verified serially" );
+      return vector<authority>();
+   };
+
+   const size_t chunk_size = ( count + threads - 1 ) / threads;
+   graphene::db::task_pool::instance().run_and_wait( ( count + chunk_size - 1 ) / chunk_size, [&] ( size_t chunk ) {
+      const size_t end = std::min( ( chunk + 1 ) * chunk_size, count );
+      for( size_t i = chunk * chunk_size; i < end; ++i )
+      {
+         try {
+            block.transactions[i].verify_authority( chain_id, get_active, get_owner, get_custom,
+                                                    true, false, max_depth );
+            verified[i] = 1;
+         } catch( ... ) {
+            // verified again when the transaction is applied
+         }
+      }
+   }, graphene::db::task_priority::high );
+   return verified;
+} FC_CAPTURE_AND_RETHROW( (block.block_num()) ) }
 
 static const uint32_t skip_expensive = database::skip_transaction_signatures | database::skip_witness_signature
                                        | database::skip_merkle_check | database::skip_transaction_dupe_check;
@@ -801,14 +1436,100 @@ void database::_precompute_parallel( const Trx* trx, const size_t count, const u
 {
    for( size_t i = 0; i < count; ++i, ++trx )
    {
-      trx->validate(); // TODO - parallelize wrt confidential operations
+      _confidential_proof_cache.validate( *trx );
       if ( !(skip & skip_block_size_check) )
          trx->get_packed_size();
       if( !(skip&skip_transaction_dupe_check) )
          trx->id();
       if( !(skip&skip_transaction_signatures) )
-         trx->get_signature_keys( get_chain_id() );
+         trx->get_signature_keys( get_chain_id(), [this]( const signature_type& sig, const digest_type& d ) {
+            return _signature_cache.recover( sig, d );
+         });
+   }
+}
+
+/// Runs @p work on @p count workers of the thread pool and waits for all of them
+/// @return false if any worker failed
+template<typename Work>
+static bool run_precompute_workers( uint32_t count, const Work& work )
+{
+   std::vector<fc::future<void>> workers;
+   workers.reserve( count );
+   for( uint32_t i = 0; i < count; ++i )
+      workers.push_back( graphene::db::task_pool::instance().run( [&work] () { work(); }, graphene::db::task_priority::high ) );
+   bool success = true;
+   for( auto& worker : workers )
+   {
+      try
+      {
+         worker.wait();
+      }
+      catch( const fc::exception& )
+      {
+         success = false;
+      }
+      catch( const std::exception& )
+      {
+         success = false;
+      }
+   }
+   return success;
+}
+
+bool database::_precompute_signatures_parallel( const signed_block& block, const uint32_t skip )const
+{
+   const size_t count = block.transactions.size();
+   const uint32_t threads = graphene::db::task_pool::instance().thread_count();
+   const chain_id_type& chain_id = get_chain_id();
+
+   // step 1: stateless checks and signature digests, the workers take the next transaction when done
+   std::vector<digest_type> digests( count );
+   std::vector<size_t> first_key( count + 1, 0 );
+   for( size_t i = 0; i < count; ++i )
+      first_key[i + 1] = first_key[i] + block.transactions[i].signatures.size();
+   std::atomic<size_t> next_trx{0};
+   if( !run_precompute_workers( threads, [&] () {
+         for( size_t i = next_trx++; i < count; i = next_trx++ )
+         {
+            const auto& trx = block.transactions[i];
+            _precompute_parallel( &trx, 1, skip | skip_transaction_signatures );
+            digests[i] = trx.sig_digest( chain_id );
+         }
+      }) )
+      return false;
+
+   // step 2: key recovery of all signatures of the block, so that the workers stay busy even if a few
+   // transactions carry most of the signatures
+   const size_t sig_count = first_key[count];
+   std::vector<public_key_type> keys( sig_count );
+   std::atomic<size_t> next_sig{0};
+   if( !run_precompute_workers( std::min<size_t>( threads, sig_count ), [&] () {
+         size_t trx_num = 0;
+         for( size_t k = next_sig++; k < sig_count; k = next_sig++ )
+         {
+            while( first_key[trx_num + 1] <= k )
+               ++trx_num;
+            const auto& sig = block.transactions[trx_num].signatures[k - first_key[trx_num]];
+            keys[k] = _signature_cache.recover( sig, digests[trx_num] );
+         }
+      }) )
+      return false;
+
+   // step 3: hand the keys over to the transactions
+   for( size_t i = 0; i < count; ++i )
+   {
+      size_t k = first_key[i];
+      try
+      {
+         block.transactions[i].extract_signature_keys( digests[i],
+               [&keys,&k]( const signature_type&, const digest_type& ) { return keys[k++]; } );
+      }
+      catch( const fc::exception& )
+      {
+         return false;
+      }
    }
+   return true;
 }
 
 fc::future<void> database::precompute_parallel( const signed_block& block, const uint32_t skip )const
@@ -818,24 +1539,53 @@ fc::future<void> database::precompute_parallel( const signed_block& block, const
    {
       if( (skip & skip_expensive) == skip_expensive )
          _precompute_parallel( &block.transactions[0], block.transactions.size(), skip );
+      else if( !(skip & skip_transaction_signatures) && graphene::db::task_pool::instance().thread_count() > 1 )
+      {
+         // on failure, precompute again the usual way to report the error through the returned future
+         if( !_precompute_signatures_parallel( block, skip ) )
+            workers.push_back( graphene::db::task_pool::instance().run( [this,&block,skip] () {
+               _precompute_parallel( &block.transactions[0], block.transactions.size(), skip );
+            }, graphene::db::task_priority::high ) );
+      }
       else
       {
-         uint32_t chunks = fc::asio::default_io_service_scope::get_num_threads();
+         uint32_t chunks = graphene::db::task_pool::instance().thread_count();
          uint32_t chunk_size = ( block.transactions.size() + chunks - 1 ) / chunks;
          workers.reserve( chunks + 1 );
          for( size_t base = 0; base < block.transactions.size(); base += chunk_size )
-            workers.push_back( fc::do_parallel( [this,&block,base,chunk_size,skip] () {
+            workers.push_back( graphene::db::task_pool::instance().run( [this,&block,base,chunk_size,skip] () {
                _precompute_parallel( &block.transactions[base],
                                      base + chunk_size < block.transactions.size() ? chunk_size : block.transactions.size() - base,
                                      skip );
-            }) );
+            }, graphene::db::task_priority::high ) );
       }
    }
 
    if( !(skip&skip_witness_signature) )
-      workers.push_back( fc::do_parallel( [&block] () { block.signee(); } ) );
+      workers.push_back( graphene::db::task_pool::instance().run( [&block] () { block.signee(); }, graphene::db::task_priority::high ) );
    if( !(skip&skip_merkle_check) )
-      block.calculate_merkle_root();
+   {
+      const uint32_t threads = graphene::db::task_pool::instance().thread_count();
+      if( threads > 1 && block.transactions.size() > 1 )
+      {
+         // hash the leaves in parallel, only the upper levels of the tree are cheap enough to do here
+         vector<digest_type> leaves( block.transactions.size() );
+         std::vector<fc::future<void>> leaf_workers;
+         const size_t chunk_size = ( leaves.size() + threads - 1 ) / threads;
+         leaf_workers.reserve( threads );
+         for( size_t base = 0; base < leaves.size(); base += chunk_size )
+            leaf_workers.push_back( graphene::db::task_pool::instance().run( [&block,&leaves,base,chunk_size] () {
+               const size_t end = std::min( base + chunk_size, leaves.size() );
+               for( size_t i = base; i < end; ++i )
+                  leaves[i] = block.transactions[i].merkle_digest();
+            }, graphene::db::task_priority::high ) );
+         for( auto& leaf_worker : leaf_workers )
+            leaf_worker.wait();
+         block.calculate_merkle_root( std::move( leaves ) );
+      }
+      else
+         block.calculate_merkle_root();
+   }
    block.id();
 
    if( workers.empty() )
@@ -850,9 +1600,9 @@ fc::future<void> database::precompute_parallel( const signed_block& block, const
 
 fc::future<void> database::precompute_parallel( const precomputable_transaction& trx )const
 {
-   return fc::do_parallel([this,&trx] () {
+   return graphene::db::task_pool::instance().run( [this,&trx] () {
       _precompute_parallel( &trx, 1, skip_nothing );
-   });
+   }, graphene::db::task_priority::high );
 }
 
 } }
@@ -17,112 +17,87 @@
  */
 
 #include <graphene/chain/database.hpp>
+#include <graphene/chain/commit_reveal_object.hpp>
+#include <graphene/chain/commit_reveal_v2_object.hpp>
+#include <graphene/chain/hardfork.hpp>
+
+#include <algorithm>
 
 namespace graphene
 {
    namespace chain
    {
 
-      uint64_t database::get_commit_reveal_seed(const vector<account_id_type> &accounts) const
-      {
-         const auto &cr_idx = get_index_type<commit_reveal_index>();
-         const auto &by_op_idx = cr_idx.indices().get<by_account>();
-
-         uint64_t seed = 0;
-         for (const auto &acc : accounts)
-         {
-            auto itr = by_op_idx.lower_bound(acc);
-            if (itr != by_op_idx.end() && itr->account == acc)
-            {
-               seed += itr->value;
-            }
-         }
-         return seed;
-      }
-
-      vector<account_id_type> database::filter_commit_reveal_participant(const vector<account_id_type> &accounts) const
-      {
-         const auto &cr_idx = get_index_type<commit_reveal_index>();
-         const auto &by_op_idx = cr_idx.indices().get<by_account>();
-
-         vector<account_id_type> result;
-         for (const auto &acc : accounts)
-         {
-            auto itr = by_op_idx.lower_bound(acc);
-            if (itr != by_op_idx.end() && itr->account == acc && itr->value != 0)
-            {
-               result.push_back(itr->account);
-            }
-         }
-         return result;
-      }
-
-      uint64_t database::get_commit_reveal_seed_v2(const vector<account_id_type> &accounts) const
+      namespace
       {
-         const auto &cr_idx = get_index_type<commit_reveal_v2_index>();
-         const auto &by_op_idx = cr_idx.indices().get<by_account>();
+         /// Account and revealed value of a commit-reveal object of the current round
+         typedef std::pair<account_id_type, uint64_t> commit_reveal_entry;
 
-         uint64_t seed = 0;
-         uint32_t maintenance_time = get_dynamic_global_properties().next_maintenance_time.sec_since_epoch();
-         if (HARDFORK_REVPOP_13_PASSED(head_block_time()))
+         /**
+          * Sums up the values of the given accounts found in the entries and lists the accounts with a
+          * non-zero reveal. Both v1 and v2 end up here, so the selection rules are kept in one place.
+          *
+          * @param entries round entries sorted by account
+          */
+         database::commit_reveal_round tally_commit_reveal_round(const vector<commit_reveal_entry> &entries,
+                                                                 const vector<account_id_type> &accounts)
          {
-            uint32_t prev_maintenance_time = maintenance_time - get_global_properties().parameters.maintenance_interval;
+            database::commit_reveal_round round;
+            if (entries.empty())
+               return round;
+            round.participants.reserve(std::min(entries.size(), accounts.size()));
             for (const auto &acc : accounts)
             {
-               auto itr = by_op_idx.lower_bound(acc);
-               if (itr != by_op_idx.end() && itr->account == acc && prev_maintenance_time <= itr->maintenance_time && itr->maintenance_time < maintenance_time)
+               auto itr = std::lower_bound(entries.begin(), entries.end(), acc,
+                                           [](const commit_reveal_entry &e, const account_id_type &a) { return e.first < a; });
+               if (itr != entries.end() && itr->first == acc)
                {
-                  seed += itr->value;
+                  round.seed += itr->second;
+                  if (itr->second != 0)
+                     round.participants.push_back(acc);
                }
             }
+            return round;
          }
-         else
-         {
-            for (const auto &acc : accounts)
-            {
-               auto itr = by_op_idx.lower_bound(acc);
-               if (itr != by_op_idx.end() && itr->account == acc && itr->maintenance_time == maintenance_time)
-               {
-                  seed += itr->value;
-               }
-            }
-         }
-         return seed;
       }
 
-      vector<account_id_type> database::filter_commit_reveal_participant_v2(const vector<account_id_type> &accounts) const
+      database::commit_reveal_round database::get_commit_reveal_round(const vector<account_id_type> &accounts) const
       {
-         const auto &cr_idx = get_index_type<commit_reveal_v2_index>();
-         const auto &by_op_idx = cr_idx.indices().get<by_account>();
+         vector<commit_reveal_entry> entries;
 
-         vector<account_id_type> result;
-         uint32_t maintenance_time = get_dynamic_global_properties().next_maintenance_time.sec_since_epoch();
-         if (HARDFORK_REVPOP_13_PASSED(head_block_time()))
+         if (HARDFORK_REVPOP_11_PASSED(head_block_time()))
          {
-            uint32_t prev_maintenance_time = maintenance_time - get_global_properties().parameters.maintenance_interval;
-            for (const auto &acc : accounts)
-            {
-               auto itr = by_op_idx.lower_bound(acc);
-               if (itr != by_op_idx.end() && itr->account == acc && itr->value != 0 && prev_maintenance_time <= itr->maintenance_time && itr->maintenance_time < maintenance_time)
+            // Only the objects committed for the current round are visited, instead of every known account
+            const auto &by_mt_idx = get_index_type<commit_reveal_v2_index>().indices().get<by_maintenance_time>();
 
-               {
-                  result.push_back(itr->account);
-               }
+            uint32_t maintenance_time = get_dynamic_global_properties().next_maintenance_time.sec_since_epoch();
+            auto itr = by_mt_idx.lower_bound(maintenance_time);
+            auto end = by_mt_idx.upper_bound(maintenance_time);
+            if (HARDFORK_REVPOP_13_PASSED(head_block_time()))
+            {
+               uint32_t prev_maintenance_time = maintenance_time - get_global_properties().parameters.maintenance_interval;
+               itr = by_mt_idx.lower_bound(prev_maintenance_time);
+               end = by_mt_idx.lower_bound(maintenance_time);
             }
+            for (; itr != end; ++itr)
+               entries.emplace_back(itr->account, itr->value);
+            // The range spans several maintenance times after HARDFORK_REVPOP_13
+            std::sort(entries.begin(), entries.end());
          }
          else
          {
+            const auto &by_account_idx = get_index_type<commit_reveal_index>().indices().get<by_account>();
+            entries.reserve(accounts.size());
             for (const auto &acc : accounts)
             {
-               auto itr = by_op_idx.lower_bound(acc);
-               if (itr != by_op_idx.end() && itr->account == acc && itr->value != 0 && itr->maintenance_time == maintenance_time)
-
-               {
-                  result.push_back(itr->account);
-               }
+               auto itr = by_account_idx.find(acc);
+               if (itr != by_account_idx.end())
+                  entries.emplace_back(itr->account, itr->value);
             }
+            std::sort(entries.begin(), entries.end());
          }
-         return result;
+
+         return tally_commit_reveal_round(entries, accounts);
       }
 
    }
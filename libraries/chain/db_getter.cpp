@@ -31,46 +31,11 @@
 
 namespace graphene { namespace chain {
 
-const asset_object& database::get_core_asset() const
-{
-   return *_p_core_asset_obj;
-}
-
-const asset_dynamic_data_object& database::get_core_dynamic_data() const
-{
-   return *_p_core_dynamic_data_obj;
-}
-
-const global_property_object& database::get_global_properties()const
-{
-   return *_p_global_prop_obj;
-}
-
-const chain_property_object& database::get_chain_properties()const
-{
-   return *_p_chain_property_obj;
-}
-
-const dynamic_global_property_object& database::get_dynamic_global_properties() const
-{
-   return *_p_dyn_global_prop_obj;
-}
-
 const fee_schedule&  database::current_fee_schedule()const
 {
    return get_global_properties().parameters.get_current_fees();
 }
 
-time_point_sec database::head_block_time()const
-{
-   return get_dynamic_global_properties().time;
-}
-
-uint32_t database::head_block_num()const
-{
-   return get_dynamic_global_properties().head_block_number;
-}
-
 block_id_type database::head_block_id()const
 {
    return get_dynamic_global_properties().head_block_id;
@@ -103,21 +68,24 @@ vector<authority> database::get_viable_custom_authorities(
    const auto& index = get_index_type<custom_authority_index>().indices().get<by_account_custom>();
    auto range = index.equal_range(boost::make_tuple(account, unsigned_int(op.which()), true));
 
-   auto is_valid = [now=head_block_time()](const custom_authority_object& auth) { return auth.is_valid(now); };
-   vector<std::reference_wrapper<const custom_authority_object>> valid_auths;
-   std::copy_if(range.first, range.second, std::back_inserter(valid_auths), is_valid);
-
    vector<authority> results;
-   for (const auto& cust_auth : valid_auths) {
+   if (range.first == range.second)
+      return results;
+
+   const auto now = head_block_time();
+   for (auto itr = range.first; itr != range.second; ++itr) {
+      const custom_authority_object& cust_auth = *itr;
+      if (!cust_auth.is_valid(now))
+         continue;
       try {
-         auto result = cust_auth.get().get_predicate()(op);
+         auto result = cust_auth.get_predicate()(op);
          if (result.success)
-            results.emplace_back(cust_auth.get().auth);
+            results.emplace_back(cust_auth.auth);
          else if (rejected_authorities != nullptr)
-            rejected_authorities->insert(std::make_pair(cust_auth.get().id, std::move(result)));
+            rejected_authorities->insert(std::make_pair(cust_auth.id, std::move(result)));
       } catch (fc::exception& e) {
          if (rejected_authorities != nullptr)
-            rejected_authorities->insert(std::make_pair(cust_auth.get().id, std::move(e)));
+            rejected_authorities->insert(std::make_pair(cust_auth.id, std::move(e)));
       }
    }
 
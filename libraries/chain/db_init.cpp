@@ -92,7 +92,7 @@ namespace graphene { namespace chain {
 
 void database::initialize_evaluators()
 {
-   _operation_evaluators.resize(255);
+   _operation_evaluators.resize( operation::count(), nullptr );
    register_evaluator<account_create_evaluator>();
    register_evaluator<account_update_evaluator>();
    register_evaluator<account_upgrade_evaluator>();
@@ -174,14 +174,18 @@ void database::initialize_indexes()
    add_index< primary_index<asset_index, 13> >(); // 8192 assets per chunk
    add_index< primary_index<force_settlement_index> >();
 
-   add_index< primary_index<account_index, 20> >(); // ~1 million accounts per chunk
+   auto acnt_idx = add_index< primary_index<account_index, 20> >(); // ~1 million accounts per chunk
+   acnt_idx->add_secondary_index< vote_tally_observer<account_object> >( &_vote_tally_cache );
    add_index< primary_index<committee_member_index, 8> >(); // 256 members per chunk
    add_index< primary_index<witness_index, 10> >(); // 1024 witnesses per chunk
-   add_index< primary_index<limit_order_index > >();
-   add_index< primary_index<call_order_index > >();
+   auto limit_idx = add_index< primary_index<limit_order_index, 10 > >(); // orders come and go, small chunks
+   limit_idx->add_secondary_index< margin_call_observer<limit_order_object> >( &_markets_without_margin_calls );
+   auto call_idx = add_index< primary_index<call_order_index, 10 > >();
+   call_idx->add_secondary_index< margin_call_observer<call_order_object> >( &_markets_without_margin_calls );
    add_index< primary_index<proposal_index > >();
    add_index< primary_index<withdraw_permission_index > >();
-   add_index< primary_index<vesting_balance_index> >();
+   auto vb_idx = add_index< primary_index<vesting_balance_index, 12> >();
+   vb_idx->add_secondary_index< vote_tally_observer<vesting_balance_object> >( &_vote_tally_cache );
    add_index< primary_index<worker_index> >();
    add_index< primary_index<balance_index> >();
    add_index< primary_index<blinded_balance_index> >();
@@ -192,13 +196,16 @@ void database::initialize_indexes()
    //Implementation object indexes
    add_index< primary_index<transaction_index                             > >();
 
-   auto bal_idx = add_index< primary_index<account_balance_index          > >();
+   auto bal_idx = add_index< primary_index<account_balance_index, 16      > >(); // 64 Ki balances per chunk
    bal_idx->add_secondary_index<balances_by_account_index>();
 
-   add_index< primary_index<asset_bitasset_data_index,                 13 > >(); // 8192
+   auto bitasset_idx = add_index< primary_index<asset_bitasset_data_index, 13 > >(); // 8192
+   bitasset_idx->add_secondary_index< margin_call_observer<asset_bitasset_data_object> >(
+                                         &_markets_without_margin_calls );
    add_index< primary_index<simple_index<global_property_object          >> >();
    add_index< primary_index<simple_index<dynamic_global_property_object  >> >();
-   add_index< primary_index<account_stats_index,                       20 > >(); // 1 Mi
+   auto stats_idx = add_index< primary_index<account_stats_index,      20 > >(); // 1 Mi
+   stats_idx->add_secondary_index< vote_tally_observer<account_statistics_object> >( &_vote_tally_cache );
    add_index< primary_index<simple_index<asset_dynamic_data_object       >> >();
    add_index< primary_index<simple_index<block_summary_object            >> >();
    add_index< primary_index<simple_index<chain_property_object          > > >();
@@ -215,6 +222,9 @@ void database::initialize_indexes()
    add_index< primary_index< permission_index,                          20> >();
    add_index< primary_index< commit_reveal_index,                       20> >();
    add_index< primary_index< commit_reveal_v2_index,                    20> >();
+
+   // the indexes added by plugins later are not part of the chain state
+   _chain_index_types = get_index_types();
 }
 
 void database::init_genesis(const genesis_state_type& genesis_state)
@@ -467,12 +477,17 @@ void database::init_genesis(const genesis_state_type& genesis_state)
    };
 
    // Helper function to get asset ID by symbol
+   // Genesis balances usually come in long runs of the same asset, so the last asset found is checked first
    const auto& assets_by_symbol = get_index_type<asset_index>().indices().get<by_symbol>();
-   const auto get_asset_id = [&assets_by_symbol](const string& symbol) {
+   const asset_object* last_asset_found = nullptr;
+   const auto get_asset_id = [&assets_by_symbol,&last_asset_found](const string& symbol) {
+      if( last_asset_found != nullptr && last_asset_found->symbol == symbol )
+         return last_asset_found->get_id();
       auto itr = assets_by_symbol.find(symbol);
       FC_ASSERT(itr != assets_by_symbol.end(),
                 "Unable to find asset '${sym}'. Did you forget to add a record for it to initial_assets?",
                 ("sym", symbol));
+      last_asset_found = &*itr;
       return itr->get_id();
    };
 
@@ -548,17 +563,26 @@ void database::init_genesis(const genesis_state_type& genesis_state)
    }
 
    // Create initial balances
-   share_type total_allocation;
+   // The supplies are summed up per run of the same asset, instead of looking up the map for every balance
+   asset_id_type run_asset_id;
+   share_type run_supply;
    for( const auto& handout : genesis_state.initial_balances )
    {
       const auto asset_id = get_asset_id(handout.asset_symbol);
-      create<balance_object>([&handout,total_allocation,asset_id](balance_object& b) {
+      create<balance_object>([&handout,asset_id](balance_object& b) {
          b.balance = asset(handout.amount, asset_id);
          b.owner = handout.owner;
       });
 
-      total_supplies[ asset_id ] += handout.amount;
+      if( asset_id != run_asset_id )
+      {
+         total_supplies[ run_asset_id ] += run_supply;
+         run_asset_id = asset_id;
+         run_supply = 0;
+      }
+      run_supply += handout.amount;
    }
+   total_supplies[ run_asset_id ] += run_supply;
 
    // Create initial vesting balances
    for( const genesis_state_type::initial_vesting_balance_type& vest : genesis_state.initial_vesting_balances )
@@ -45,6 +45,10 @@
 #include <graphene/chain/worker_object.hpp>
 #include <graphene/chain/custom_authority_object.hpp>
 
+#include <graphene/db/task_pool.hpp>
+
+#include <atomic>
+
 namespace graphene { namespace chain {
 
 template<class Index>
@@ -75,27 +79,23 @@ template<class Type>
 void database::perform_account_maintenance(Type tally_helper)
 {
    const auto& bal_idx = get_index_type< account_balance_index >().indices().get< by_maintenance_flag >();
-   if( bal_idx.begin() != bal_idx.end() )
-   {
-      auto bal_itr = bal_idx.rbegin();
-      while( bal_itr->maintenance_flag )
-      {
-         const account_balance_object& bal_obj = *bal_itr;
-
-         modify( get_account_stats_by_owner( bal_obj.owner ), [&bal_obj](account_statistics_object& aso) {
-            aso.core_in_balance = bal_obj.balance;
-         });
-
-         modify( bal_obj, []( account_balance_object& abo ) {
-            abo.maintenance_flag = false;
-         });
+   vector<const account_balance_object*> flagged_balances;
+   for( auto bal_itr = bal_idx.rbegin(); bal_itr != bal_idx.rend() && bal_itr->maintenance_flag; ++bal_itr )
+      flagged_balances.push_back( &*bal_itr );
 
-         bal_itr = bal_idx.rbegin();
-      }
+   for( const account_balance_object* bal_obj : flagged_balances )
+   {
+      modify( get_account_stats_by_owner( bal_obj->owner ), [bal_obj](account_statistics_object& aso) {
+         aso.core_in_balance = bal_obj->balance;
+      });
    }
+   modify_batch( flagged_balances, []( account_balance_object& abo ) {
+      abo.maintenance_flag = false;
+   });
 
    const auto& stats_idx = get_index_type< account_stats_index >().indices().get< by_maintenance_seq >();
    auto stats_itr = stats_idx.lower_bound( true );
+   tally_helper.prepare();
 
    while( stats_itr != stats_idx.end() )
    {
@@ -109,6 +109,7 @@ void database::perform_account_maintenance(Type tally_helper)
       if( acc_stat.has_pending_fees() )
          acc_stat.process_fees( acc_obj, *this );
    }
+   _vote_tally_cache.stop_tracking();
 
 }
 
@@ -134,18 +135,16 @@ struct worker_pay_visitor
 void database::update_worker_votes()
 {
    const auto& idx = get_index_type<worker_index>().indices().get<by_account>();
-   auto itr = idx.begin();
-   auto itr_end = idx.end();
-   while( itr != itr_end )
+   vector<const worker_object*> workers;
+   workers.reserve( idx.size() );
+   for( const worker_object& w : idx )
+      workers.push_back( &w );
+   modify_batch( workers, [this]( worker_object& obj )
    {
-      modify( *itr, [this]( worker_object& obj )
-      {
-         obj.total_votes_for = _vote_tally_buffer[obj.vote_for];
-         obj.total_cm_votes_for = _cm_vote_for_worker_buffer[obj.vote_for];
-         obj.cm_support.swap(_cm_support_worker_buffer[obj.vote_for]);
-      });
-      ++itr;
-   }
+      obj.total_votes_for = _vote_tally_buffer[obj.vote_for];
+      obj.total_cm_votes_for = _cm_vote_for_worker_buffer[obj.vote_for];
+      obj.cm_support.swap(_cm_support_worker_buffer[obj.vote_for]);
+   });
 }
 
 void database::pay_workers( share_type& budget )
@@ -157,8 +156,7 @@ void database::pay_workers( share_type& budget )
    if (cm_size == 0)
       return;
    // TODO optimization: add by_expiration index to avoid iterating through all objects
-   get_index_type<worker_index>().inspect_all_objects([head_time, &active_workers, cm_size](const object& o) {
-      const worker_object& w = static_cast<const worker_object&>(o);
+   get_index_type<worker_index>().for_each_object([head_time, &active_workers, cm_size](const worker_object& w) {
       if( w.is_active(head_time) && w.cm_support_size() * 2 >= cm_size + 1 )
          active_workers.emplace_back(w);
    });
@@ -177,6 +175,8 @@ void database::pay_workers( share_type& budget )
    const auto passed_time_ms = head_time - last_budget_time;
    const auto passed_time_count = passed_time_ms.count();
    const auto day_count = fc::days(1).count();
+   vector<const worker_object*> paid_workers;
+   flat_map<object_id_type, share_type> worker_pay;
    for( uint32_t i = 0; i < active_workers.size() && budget > 0; ++i )
    {
       const worker_object& active_worker = active_workers[i];
@@ -192,12 +192,14 @@ void database::pay_workers( share_type& budget )
 
       share_type actual_pay = std::min(budget, requested_pay);
       //ilog(" ==> Paying ${a} to worker ${w}", ("w", active_worker.id)("a", actual_pay));
-      modify(active_worker, [&](worker_object& w) {
-         w.worker.visit(worker_pay_visitor(actual_pay, *this));
-      });
+      paid_workers.push_back( &active_worker );
+      worker_pay[active_worker.id] = actual_pay;
 
       budget -= actual_pay;
    }
+   modify_batch( paid_workers, [this,&worker_pay](worker_object& w) {
+      w.worker.visit(worker_pay_visitor(worker_pay.at(w.id), *this));
+   });
 }
 
 fc::uint128_t database::calculate_workers_budget()
@@ -214,8 +216,7 @@ fc::uint128_t database::calculate_workers_budget()
    if (cm_size == 0)
       return worker_budget_u128;
    // TODO optimization: add by_expiration index to avoid iterating through all objects
-   get_index_type<worker_index>().inspect_all_objects([head_time, &active_workers, cm_size, &worker_budget_u128](const object& o) {
-      const worker_object& w = static_cast<const worker_object&>(o);
+   get_index_type<worker_index>().for_each_object([head_time, cm_size, &worker_budget_u128](const worker_object& w) {
       if( w.is_active(head_time) && w.cm_support_size() * 2 >= cm_size + 1 )
          worker_budget_u128 += w.daily_pay.value;
       });
@@ -261,9 +262,10 @@ void database::update_active_witnesses()
    }
 
    // RevPop: seed maintenance PRNG from commit-reveal scheme or chain_id + head block number
+   auto reveal_round = get_commit_reveal_round(wits_acc);
    if (HARDFORK_REVPOP_11_PASSED(head_block_time()))
    {
-      uint64_t prng_seed = get_commit_reveal_seed_v2(wits_acc);
+      uint64_t prng_seed = reveal_round.seed;
       if (prng_seed == 0)
       {
          // Fallback: seed PRNG from chain_id + head block num
@@ -278,16 +280,13 @@ void database::update_active_witnesses()
                ((*(const uint64_t *)get_chain_id().data()) + dpo.head_block_number)
                :
                // Normal: seed PRNG from commit-reveal scheme
-               get_commit_reveal_seed(wits_acc);
+               reveal_round.seed;
       _maintenance_prng.seed(prng_seed);
    }
 
    // RevPop: remove from top list witnesses without reveals
    {
-      auto wits_acc_w_reveals = HARDFORK_REVPOP_11_PASSED(head_block_time()) ?
-                     filter_commit_reveal_participant_v2(wits_acc)
-                     :
-                     filter_commit_reveal_participant(wits_acc);
+      const auto& wits_acc_w_reveals = reveal_round.participants;
       decltype(wits) enabled_wits;
       enabled_wits.reserve( wits_acc_w_reveals.size() );
       std::copy_if( wits.begin(), wits.end(), std::back_inserter( enabled_wits ),
@@ -384,28 +383,24 @@ void database::update_active_witnesses()
                 return _vote_tally_buffer[a.vote_id] > _vote_tally_buffer[b.vote_id];
              });
 
-   auto update_witness_total_votes = [this]( const witness_object& wit ) {
-      modify( wit, [this]( witness_object& obj )
-      {
-         obj.total_votes = _vote_tally_buffer[obj.vote_id];
-      });
-   };
-
+   vector<const witness_object*> witnesses_to_update;
    if( _track_standby_votes )
    {
       const auto& all_witnesses = get_index_type<witness_index>().indices();
+      witnesses_to_update.reserve( all_witnesses.size() );
       for( const witness_object& wit : all_witnesses )
-      {
-         update_witness_total_votes( wit );
-      }
+         witnesses_to_update.push_back( &wit );
    }
    else
    {
+      witnesses_to_update.reserve( wits.size() );
       for( const witness_object& wit : wits )
-      {
-         update_witness_total_votes( wit );
-      }
+         witnesses_to_update.push_back( &wit );
    }
+   modify_batch( witnesses_to_update, [this]( witness_object& obj )
+   {
+      obj.total_votes = _vote_tally_buffer[obj.vote_id];
+   });
 
    // Update witness authority
    modify( get(GRAPHENE_WITNESS_ACCOUNT), [this,&wits]( account_object& a )
@@ -452,28 +447,24 @@ void database::update_active_committee_members()
    committee_member_count = std::max( committee_member_count*2+1, (size_t)cpo.immutable_parameters.min_committee_member_count );
    auto committee_members = sort_votable_objects<committee_member_index>( committee_member_count );
 
-   auto update_committee_member_total_votes = [this]( const committee_member_object& cm ) {
-      modify( cm, [this]( committee_member_object& obj )
-      {
-         obj.total_votes = _vote_tally_buffer[obj.vote_id];
-      });
-   };
-
+   vector<const committee_member_object*> committee_members_to_update;
    if( _track_standby_votes )
    {
       const auto& all_committee_members = get_index_type<committee_member_index>().indices();
+      committee_members_to_update.reserve( all_committee_members.size() );
       for( const committee_member_object& cm : all_committee_members )
-      {
-         update_committee_member_total_votes( cm );
-      }
+         committee_members_to_update.push_back( &cm );
    }
    else
    {
+      committee_members_to_update.reserve( committee_members.size() );
       for( const committee_member_object& cm : committee_members )
-      {
-         update_committee_member_total_votes( cm );
-      }
+         committee_members_to_update.push_back( &cm );
    }
+   modify_batch( committee_members_to_update, [this]( committee_member_object& obj )
+   {
+      obj.total_votes = _vote_tally_buffer[obj.vote_id];
+   });
 
    // Update committee authorities
    if( !committee_members.empty() )
@@ -693,18 +684,65 @@ void update_top_n_authorities( database& db )
                 break;
          }
 
+         // the holders rarely change between maintenances, the account is only modified if its authority does
+         const authority& current = is_owner ? acct.owner : acct.active;
+         authority updated = current;
+         vc.finish( updated );
+         const uint8_t flag = is_owner ? account_object::top_n_control_owner : account_object::top_n_control_active;
+         const bool set_flag = !vc.is_empty() && !( acct.top_n_control_flags & flag );
+         if( !set_flag && updated == current )
+            return;
+
          db.modify( acct, [&]( account_object& a )
          {
-            vc.finish( is_owner ? a.owner : a.active );
+            ( is_owner ? a.owner : a.active ) = std::move( updated );
             if( !vc.is_empty() )
-               a.top_n_control_flags |= (is_owner ? account_object::top_n_control_owner : account_object::top_n_control_active);
+               a.top_n_control_flags |= flag;
          } );
       }
    } );
 }
 
+/**
+ * Collects the results of splitting all FBA accumulators so that the core supply is updated once and every
+ * recipient's balance is credited once per maintenance, instead of once per FBA.  Credits are kept in the
+ * order their recipients first appear, so balance objects are created in the same order as before.
+ */
+struct fba_distribution
+{
+   share_type                                       network_amount;
+   vector< std::pair< account_id_type, share_type > > credits;
+
+   void credit( account_id_type account, share_type amount )
+   {
+      for( auto& c : credits )
+      {
+         if( c.first == account )
+         {
+            c.second += amount;
+            return;
+         }
+      }
+      credits.emplace_back( account, amount );
+   }
+
+   void apply( database& db )const
+   {
+      if( network_amount != 0 )
+      {
+         db.modify( db.get_core_dynamic_data(), [&]( asset_dynamic_data_object& _core_dd )
+         {
+            _core_dd.current_supply -= network_amount;
+         } );
+      }
+      for( const auto& c : credits )
+         db.adjust_balance( c.first, asset(c.second) );
+   }
+};
+
 void split_fba_balance(
    database& db,
+   fba_distribution& dist,
    uint64_t fba_id,
    uint16_t network_pct,
    uint16_t designated_asset_buyback_pct,
@@ -716,15 +754,10 @@ void split_fba_balance(
    if( fba.accumulated_fba_fees == 0 )
       return;
 
-   const asset_dynamic_data_object& core_dd = db.get_core_dynamic_data();
-
    if( !fba.is_configured(db) )
    {
       ilog( "${n} core given to network at block ${b} due to non-configured FBA", ("n", fba.accumulated_fba_fees)("b", db.head_block_time()) );
-      db.modify( core_dd, [&]( asset_dynamic_data_object& _core_dd )
-      {
-         _core_dd.current_supply -= fba.accumulated_fba_fees;
-      } );
+      dist.network_amount += fba.accumulated_fba_fees;
       db.modify( fba, [&]( fba_accumulator_object& _fba )
       {
          _fba.accumulated_fba_fees = 0;
@@ -745,25 +778,17 @@ void split_fba_balance(
    // this assert should never fail
    FC_ASSERT( buyback_amount + issuer_amount <= fba.accumulated_fba_fees );
 
-   share_type network_amount = fba.accumulated_fba_fees - (buyback_amount + issuer_amount);
+   dist.network_amount += fba.accumulated_fba_fees - (buyback_amount + issuer_amount);
 
    const asset_object& designated_asset = (*fba.designated_asset)(db);
 
-   if( network_amount != 0 )
-   {
-      db.modify( core_dd, [&]( asset_dynamic_data_object& _core_dd )
-      {
-         _core_dd.current_supply -= network_amount;
-      } );
-   }
-
    fba_distribute_operation vop;
    vop.account_id = *designated_asset.buyback_account;
    vop.fba_id = fba.id;
    vop.amount = buyback_amount;
    if( vop.amount != 0 )
    {
-      db.adjust_balance( *designated_asset.buyback_account, asset(buyback_amount) );
+      dist.credit( *designated_asset.buyback_account, buyback_amount );
       db.push_applied_operation(vop);
    }
 
@@ -772,7 +797,7 @@ void split_fba_balance(
    vop.amount = issuer_amount;
    if( vop.amount != 0 )
    {
-      db.adjust_balance( designated_asset.issuer, asset(issuer_amount) );
+      dist.credit( designated_asset.issuer, issuer_amount );
       db.push_applied_operation(vop);
    }
 
@@ -784,9 +809,11 @@ void split_fba_balance(
 
 void distribute_fba_balances( database& db )
 {
-   split_fba_balance( db, fba_accumulator_id_transfer_to_blind  , 20*GRAPHENE_1_PERCENT, 60*GRAPHENE_1_PERCENT, 20*GRAPHENE_1_PERCENT );
-   split_fba_balance( db, fba_accumulator_id_blind_transfer     , 20*GRAPHENE_1_PERCENT, 60*GRAPHENE_1_PERCENT, 20*GRAPHENE_1_PERCENT );
-   split_fba_balance( db, fba_accumulator_id_transfer_from_blind, 20*GRAPHENE_1_PERCENT, 60*GRAPHENE_1_PERCENT, 20*GRAPHENE_1_PERCENT );
+   fba_distribution dist;
+   split_fba_balance( db, dist, fba_accumulator_id_transfer_to_blind  , 20*GRAPHENE_1_PERCENT, 60*GRAPHENE_1_PERCENT, 20*GRAPHENE_1_PERCENT );
+   split_fba_balance( db, dist, fba_accumulator_id_blind_transfer     , 20*GRAPHENE_1_PERCENT, 60*GRAPHENE_1_PERCENT, 20*GRAPHENE_1_PERCENT );
+   split_fba_balance( db, dist, fba_accumulator_id_transfer_from_blind, 20*GRAPHENE_1_PERCENT, 60*GRAPHENE_1_PERCENT, 20*GRAPHENE_1_PERCENT );
+   dist.apply( db );
 }
 
 void create_buyback_orders( database& db )
@@ -1007,6 +1034,19 @@ namespace detail {
          stake_to_subtract /= GRAPHENE_100_PERCENT;
          return stake - static_cast<uint64_t>(stake_to_subtract);
       }
+
+      /// @return the first time after the one @p recalc_times were computed for, at which
+      ///         @ref get_recalced_voting_stake may return a different result
+      time_point_sec get_next_change_time( const time_point_sec last_vote_time,
+                                           const vote_recalc_times& recalc_times ) const
+      {
+         if( last_vote_time > recalc_times.full_power_time )
+            return last_vote_time + full_power_seconds;
+         if( last_vote_time <= recalc_times.zero_power_time )
+            return time_point_sec::maximum();
+         uint32_t diff = recalc_times.full_power_time.sec_since_epoch() - last_vote_time.sec_since_epoch();
+         return last_vote_time + full_power_seconds + ( diff / seconds_per_step + 1 ) * seconds_per_step;
+      }
    };
 
    const vote_recalc_options vote_recalc_options::witness()
@@ -1045,6 +1085,7 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
       const dynamic_global_property_object& dprops;
       const time_point_sec now;
       const bool pob_activated;
+      const bool use_cache;
 
       optional<detail::vote_recalc_times> witness_recalc_times;
       optional<detail::vote_recalc_times> committee_recalc_times;
@@ -1053,10 +1094,15 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
 
       vector<account_id_type> committee_members;
 
+      /// Contributions tallied ahead on the thread pool, see @ref prepare
+      vector<vote_tally_contribution>       prepared;
+      std::unordered_map<uint64_t, size_t>  prepared_index;
+
       vote_tally_helper( database& db )
          : d(db), props( d.get_global_properties() ), dprops( d.get_dynamic_global_properties() ),
            now( d.head_block_time() ),
-           pob_activated( dprops.total_pob > 0 || dprops.total_inactive > 0 )
+           pob_activated( dprops.total_pob > 0 || dprops.total_inactive > 0 ),
+           use_cache( d._vote_tally_cache.enabled() )
       {
          d._vote_tally_buffer.resize( props.next_available_vote_id, 0 );
          d._cm_vote_for_worker_buffer.resize( props.next_available_vote_id, 0 );
@@ -1076,6 +1122,17 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
                         [&](committee_member_id_type c)
                         { return c(d).committee_member_account; });
          std::sort(committee_members.begin(), committee_members.end());
+
+         if( use_cache )
+         {
+            vote_tally_context context;
+            context.next_available_vote_id = props.next_available_vote_id;
+            context.maximum_witness_count = props.parameters.maximum_witness_count;
+            context.maximum_committee_count = props.parameters.maximum_committee_count;
+            context.count_non_member_votes = props.parameters.count_non_member_votes;
+            context.pob_activated = pob_activated;
+            d._vote_tally_cache.begin( context );
+         }
          /*
          ilog( "committee_members:");
          for (auto c : committee_members)
@@ -1087,18 +1144,143 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
 
       void operator()( const account_object& stake_account, const account_statistics_object& stats )
       {
+         if( !use_cache )
+         {
+            const vote_tally_contribution* ready = find_prepared( stake_account.id );
+            if( ready != nullptr )
+            {
+               add( *ready );
+               return;
+            }
+            vote_tally_contribution c;
+            compute( stake_account, stats, c );
+            add( c );
+            return;
+         }
+
+         // committee members are always tallied, because their votes for workers are tracked separately
+         const bool is_committee_member = std::binary_search( committee_members.begin(), committee_members.end(),
+                                                              stake_account.id );
+         const vote_tally_contribution* cached = d._vote_tally_cache.find( stake_account.id, now );
+         if( cached != nullptr && !is_committee_member && !d._vote_tally_cache.verify() )
+         {
+            d._vote_tally_cache.keep( stake_account.id );
+            return;
+         }
+
+         vote_tally_contribution c;
+         compute( stake_account, stats, c );
+         if( cached != nullptr && !cached->same_tally( c ) )
+         {
+            elog( "Cached vote tally of account ${a} differs from the current one", ("a", stake_account.name) );
+            d._vote_tally_cache.report_mismatch();
+         }
+         d._vote_tally_cache.update( stake_account.id, std::move( c ) );
+      }
+
+      /**
+       * Tally the voting accounts on the thread pool before the serial maintenance loop.
+       *
+       * The fee processing in the loop may change accounts which come later in it, so a result is only used if
+       * neither the stake account nor the opinion account changed in the meantime. Everything else is tallied
+       * in the loop as before, therefore the totals are the same as of a serial tally.
+       */
+      void prepare()
+      {
+         if( use_cache || !d._parallel_maintenance )
+            return;
+         const uint32_t threads = graphene::db::task_pool::instance().thread_count();
+         if( threads < 2 )
+            return;
+
+         // committee members are left to the loop, because their votes for workers are tallied in order
+         vector< std::pair<const account_object*, const account_statistics_object*> > work;
+         const auto& stats_idx = d.get_index_type< account_stats_index >().indices().get< by_maintenance_seq >();
+         for( auto itr = stats_idx.lower_bound( true ); itr != stats_idx.end(); ++itr )
+         {
+            if( !itr->has_some_core_voting() )
+               continue;
+            const account_object& acc = itr->owner( d );
+            if( !std::binary_search( committee_members.begin(), committee_members.end(), acc.id ) )
+               work.emplace_back( &acc, &(*itr) );
+         }
+         if( work.size() < threads * 4 ) // not worth the overhead
+            return;
+
+         prepared.resize( work.size() );
+         vector<char> prepared_ok( work.size(), 0 );
+         std::atomic<size_t> next{0};
+         graphene::db::task_pool::instance().run_and_wait( threads, [this,&work,&prepared_ok,&next] ( size_t ) {
+            for( size_t i = next++; i < work.size(); i = next++ )
+            {
+               try {
+                  compute( *work[i].first, *work[i].second, prepared[i] );
+                  prepared_ok[i] = 1;
+               } catch( const fc::exception& ) {
+                  // tallied again in the loop
+               } catch( const std::exception& ) {
+               }
+            }
+         });
+
+         prepared_index.reserve( work.size() );
+         for( size_t i = 0; i < work.size(); ++i )
+            if( prepared_ok[i] )
+               prepared_index[ work[i].first->id.instance.value ] = i;
+         d._vote_tally_cache.start_tracking();
+      }
+
+      /// @return the contribution tallied by @ref prepare if it is still up to date, otherwise null
+      const vote_tally_contribution* find_prepared( const account_id_type account )const
+      {
+         auto itr = prepared_index.find( account.instance.value );
+         if( itr == prepared_index.end() )
+            return nullptr;
+         const vote_tally_contribution& c = prepared[itr->second];
+         if( d._vote_tally_cache.touched( account ) || d._vote_tally_cache.touched( c.opinion_account ) )
+            return nullptr;
+         return &c;
+      }
+
+      void add( const vote_tally_contribution& c )
+      {
+         c.add_votes( d._vote_tally_buffer );
+         d._witness_count_histogram_buffer[c.witness_count_offset] += c.witness_count_stake;
+         d._committee_count_histogram_buffer[c.committee_count_offset] += c.committee_count_stake;
+         d._total_voting_stake[0] += c.total_committee_stake;
+         d._total_voting_stake[1] += c.total_witness_stake;
+      }
+
+      static void limit_validity( vote_tally_contribution& c, const detail::vote_recalc_options& options,
+                                  const time_point_sec last_vote_time, const detail::vote_recalc_times& times )
+      {
+         c.valid_until = std::min( c.valid_until, options.get_next_change_time( last_vote_time, times ) );
+      }
+
+      /// Compute what the stake of an account adds to the tally,
+      /// votes of committee members for workers are added to the committee member buffers directly
+      void compute( const account_object& stake_account, const account_statistics_object& stats,
+                    vote_tally_contribution& c )
+      {
+         c.computed_at = now;
+         c.opinion_account = stake_account.id;
+
          // PoB activation
          if( pob_activated && stats.total_core_pob == 0 && stats.total_core_inactive == 0 )
             return;
 
          if( props.parameters.count_non_member_votes || stake_account.is_member( now ) )
          {
+            if( !props.parameters.count_non_member_votes && !stake_account.is_lifetime_member() )
+               c.valid_until = stake_account.membership_expiration_date + 1;
+
             // There may be a difference between the account whose stake is voting and the one specifying opinions.
             // Usually they're the same, but if the stake account has specified a voting_account, that account is the
             // one specifying the opinions.
             bool directly_voting = ( stake_account.options.voting_account == GRAPHENE_PROXY_TO_SELF_ACCOUNT );
             const account_object& opinion_account = ( directly_voting ? stake_account
                                                       : d.get(stake_account.options.voting_account) );
+            c.opinion_account = opinion_account.id;
 
             uint64_t voting_stake[3]; // 0=committee, 1=witness, 2=worker, as in vote_id_type::vote_type
             uint64_t num_committee_voting_stake; // number of committee members
@@ -1160,6 +1342,8 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
             {
                voting_stake[2] = detail::vote_recalc_options::delegator().get_recalced_voting_stake(
                                        voting_stake[2], stats.last_vote_time, *delegator_recalc_times );
+               limit_validity( c, detail::vote_recalc_options::delegator(), stats.last_vote_time,
+                               *delegator_recalc_times );
             }
             const account_statistics_object& opinion_account_stats = ( directly_voting ? stats
                                        : opinion_account.statistics( d ) );
@@ -1172,11 +1356,18 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
                voting_stake[0] /= opinion_account.num_committee_voted;
             voting_stake[2] = detail::vote_recalc_options::worker().get_recalced_voting_stake(
                                  voting_stake[2], opinion_account_stats.last_vote_time, *worker_recalc_times );
+            const time_point_sec opinion_vote_time = opinion_account_stats.last_vote_time;
+            limit_validity( c, detail::vote_recalc_options::witness(), opinion_vote_time, *witness_recalc_times );
+            limit_validity( c, detail::vote_recalc_options::committee(), opinion_vote_time,
+                            *committee_recalc_times );
+            limit_validity( c, detail::vote_recalc_options::worker(), opinion_vote_time, *worker_recalc_times );
 
             bool is_committee_members = false;
             const account_id_type account = stake_account.id;
             auto itr = std::lower_bound(committee_members.begin(), committee_members.end(), account);
             if( itr != committee_members.end() && *itr == account ) is_committee_members = true;
+            for( uint32_t type = 0; type < 3; ++type )
+               c.vote_stake[type] = voting_stake[type];
             for( vote_id_type id : opinion_account.options.votes )
             {
                uint32_t offset = id.instance();
@@ -1194,31 +1385,35 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
                   d._cm_support_worker_buffer[offset].push_back(account);
                }
 
-               d._vote_tally_buffer[offset] += voting_stake[type];
+               if( voting_stake[type] != 0 )
+                  c.vote_instances[type].push_back( offset );
             }
 
             // votes for a number greater than maximum_witness_count are skipped here
             if( voting_stake[1] > 0
                   && opinion_account.options.num_witness <= props.parameters.maximum_witness_count )
             {
-               uint16_t offset = opinion_account.options.num_witness / 2;
-               d._witness_count_histogram_buffer[offset] += voting_stake[1];
+               c.witness_count_offset = opinion_account.options.num_witness / 2;
+               c.witness_count_stake = voting_stake[1];
             }
             // votes for a number greater than maximum_committee_count are skipped here
             if( num_committee_voting_stake > 0
                   && opinion_account.options.num_committee <= props.parameters.maximum_committee_count )
             {
-               uint16_t offset = opinion_account.options.num_committee / 2;
-               d._committee_count_histogram_buffer[offset] += num_committee_voting_stake;
+               c.committee_count_offset = opinion_account.options.num_committee / 2;
+               c.committee_count_stake = num_committee_voting_stake;
             }
 
-            d._total_voting_stake[0] += num_committee_voting_stake;
-            d._total_voting_stake[1] += voting_stake[1];
+            c.total_committee_stake = num_committee_voting_stake;
+            c.total_witness_stake = voting_stake[1];
          }
       }
    } tally_helper(*this);
 
    perform_account_maintenance( tally_helper );
+   if( tally_helper.use_cache )
+      _vote_tally_cache.finish( _vote_tally_buffer, _witness_count_histogram_buffer,
+                                _committee_count_histogram_buffer, _total_voting_stake );
 
    struct clear_canary {
       clear_canary(vector<uint64_t>& target): target(target){}
@@ -28,20 +28,26 @@
 #include <graphene/chain/witness_schedule_object.hpp>
 #include <graphene/chain/special_authority_object.hpp>
 #include <graphene/chain/operation_history_object.hpp>
+#include <graphene/chain/transaction_history_object.hpp>
 
 #include <graphene/protocol/fee_schedule.hpp>
 
 #include <fc/io/fstream.hpp>
+#include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
+#include <graphene/db/task_pool.hpp>
 
+#include <boost/filesystem.hpp>
+
+#include <deque>
 #include <fstream>
 #include <functional>
 #include <iostream>
-#include <queue>
-#include <tuple>
 
 namespace graphene { namespace chain {
 
 database::database()
+: _operation_timers( new apply_timer[ operation::count() ] )
 {
    initialize_indexes();
    initialize_evaluators();
@@ -52,6 +58,151 @@ database::~database()
    clear_pending();
 }
 
+namespace {
+
+/// A block read from the block database, not yet deserialized
+struct reindex_packed_block
+{
+   uint32_t        block_num = 0;
+   size_t          position = 0; ///< position in the block file before reading, for progress reporting
+   bool            valid = false;
+   block_id_type   id;
+   vector<char>    data;
+};
+
+/// A block travelling through the deserialize and precompute stages of the reindex pipeline
+struct reindex_block
+{
+   explicit reindex_block( reindex_packed_block&& p ) : packed( std::move(p) ) {}
+
+   reindex_packed_block  packed;
+   signed_block          block;
+   bool                  valid = false;
+   bool                  precompute_started = false;
+   fc::future<void>      unpacked;
+   fc::future<void>      precomputed;
+};
+
+const char* const replay_checkpoint_file = "replay_checkpoint";
+
+/// Number of applied blocks which are released together on the thread pool during a replay
+const size_t reindex_release_batch = 64;
+
+/// Marks the object database as saved by an unfinished replay
+void write_replay_checkpoint( const fc::path& data_dir, uint32_t block_num, const block_id_type& block_id,
+                              uint32_t skip )
+{
+   fc::json::save_to_file( fc::variant( fc::mutable_variant_object()
+                                           ("block_num", block_num)
+                                           ("block_id", block_id)
+                                           ("skip_flags", skip), 2 ),
+                           data_dir / replay_checkpoint_file );
+}
+
+/// Copies the files of a directory and its subdirectories
+void copy_directory_tree( const boost::filesystem::path& from, const boost::filesystem::path& to )
+{
+   boost::filesystem::create_directories( to );
+   for( const auto& entry : boost::filesystem::directory_iterator( from ) )
+   {
+      if( boost::filesystem::is_directory( entry.status() ) )
+         copy_directory_tree( entry.path(), to / entry.path().filename() );
+      else
+         boost::filesystem::copy_file( entry.path(), to / entry.path().filename() );
+   }
+}
+
+} // anonymous namespace
+
+bool database::has_replay_checkpoint( const fc::path& data_dir, uint32_t skip )
+{
+   const fc::path checkpoint_file = data_dir / replay_checkpoint_file;
+   if( !fc::exists( checkpoint_file ) || !fc::exists( data_dir / "object_database" )
+         || fc::exists( data_dir / "object_database" / "lock" ) )
+      return false;
+   try
+   {
+      const fc::variant_object checkpoint = fc::json::from_file( checkpoint_file ).get_object();
+      // The state after a block does not depend on the skipped checks, except for the transactions kept for
+      // the duplicate check. So an archived checkpoint can start a range revalidation after a fast replay.
+      if( checkpoint.contains( "archived" ) )
+      {
+         ilog( "Found archived replay checkpoint at block ${n}", ("n", checkpoint["block_num"]) );
+         return true;
+      }
+      if( checkpoint["skip_flags"].as_uint64() != skip )
+      {
+         wlog( "Ignoring replay checkpoint at block ${n} which was created with different skip flags",
+               ("n", checkpoint["block_num"]) );
+         return false;
+      }
+      ilog( "Found replay checkpoint at block ${n}", ("n", checkpoint["block_num"]) );
+      return true;
+   }
+   catch( const fc::exception& e )
+   {
+      wlog( "Ignoring invalid replay checkpoint: ${e}", ("e", e.to_detail_string()) );
+   }
+   return false;
+}
+
+void database::set_replay_checkpoint_archive( const fc::path& dir )
+{
+   _replay_checkpoint_archive = dir;
+   if( !dir.empty() )
+   {
+      for( const auto& type : _chain_index_types )
+         enable_state_hash( type.first, type.second );
+   }
+}
+
+void database::archive_replay_checkpoint( const fc::path& data_dir )
+{
+   if( _replay_checkpoint_archive.empty() )
+      return;
+   const fc::path dir = _replay_checkpoint_archive / fc::to_string( head_block_num() );
+   // the transactions kept for the duplicate check depend on where the replay started
+   vector<graphene::db::index_state_hash> hashes;
+   for( const auto& h : get_index_state_hashes() )
+      if( h.space_id != transaction_history_object::space_id || h.type_id != transaction_history_object::type_id )
+         hashes.push_back( h );
+
+   if( fc::exists( dir / replay_checkpoint_file ) )
+   {
+      const fc::variant_object archived = fc::json::from_file( dir / replay_checkpoint_file ).get_object();
+      FC_ASSERT( archived["block_id"].as<block_id_type>( 1 ) == head_block_id(),
+                 "The archived checkpoint at block ${n} is of a different chain", ("n", head_block_num()) );
+      const auto expected = archived["indexes"].as< vector<graphene::db::index_state_hash> >( 4 );
+      vector<string> differing;
+      for( const auto& h : hashes )
+      {
+         auto itr = std::find_if( expected.begin(), expected.end(), [&h]( const graphene::db::index_state_hash& e ) {
+            return e.space_id == h.space_id && e.type_id == h.type_id;
+         });
+         if( itr == expected.end() || itr->hash != h.hash || itr->object_count != h.object_count )
+            differing.push_back( fc::to_string( h.space_id ) + "." + fc::to_string( h.type_id ) );
+      }
+      FC_ASSERT( differing.empty(), "State at block ${n} differs from the archived checkpoint in object types ${t}",
+                 ("n", head_block_num())("t", differing) );
+      ilog( "State at block ${n} matches the archived checkpoint", ("n", head_block_num()) );
+      return;
+   }
+
+   ilog( "Archiving replay checkpoint at block ${n} in ${d}", ("n", head_block_num())("d", dir) );
+   fc::remove_all( dir );
+   fc::create_directories( dir );
+   copy_directory_tree( boost::filesystem::path( ( data_dir / "object_database" ).generic_string() ),
+                        boost::filesystem::path( ( dir / "object_database" ).generic_string() ) );
+   fc::json::save_to_file( fc::variant( fc::mutable_variant_object()
+                                           ("block_num", head_block_num())
+                                           ("block_id", head_block_id())
+                                           ("skip_flags", node_properties().skip_flags)
+                                           ("archived", true)
+                                           ("state_hash", fc::sha256::hash( hashes ))
+                                           ("indexes", fc::variant( hashes, 3 )), 4 ),
+                           dir / replay_checkpoint_file );
+}
+
 void database::reindex( fc::path data_dir )
 { try {
    auto last_block = _block_id_to_block.last();
@@ -61,10 +212,22 @@ void database::reindex( fc::path data_dir )
       return;
    }
    if( last_block->block_num() <= head_block_num()) return;
+   FC_ASSERT( _block_id_to_block.first_block_num() <= head_block_num() + 1,
+              "Unable to replay, the block log is pruned and starts at block #${n}",
+              ("n", _block_id_to_block.first_block_num()) );
 
    ilog( "reindexing blockchain" );
    auto start = fc::time_point::now();
-   const auto last_block_num = last_block->block_num();
+   auto last_block_num = last_block->block_num();
+   if( _replay_end_block > 0 && _replay_end_block < last_block_num )
+   {
+      FC_ASSERT( _replay_end_block > head_block_num(), "The replay end block ${e} is not after the head block ${h}",
+                 ("e", _replay_end_block)("h", head_block_num()) );
+      ilog( "Replaying up to block ${e} only", ("e", _replay_end_block) );
+      last_block_num = _replay_end_block;
+      last_block = fetch_block_by_number( last_block_num );
+      FC_ASSERT( last_block.valid(), "Block ${e} is not in the block database", ("e", _replay_end_block) );
+   }
    uint32_t undo_point = last_block_num < GRAPHENE_MAX_UNDO_HISTORY ? 0 : last_block_num - GRAPHENE_MAX_UNDO_HISTORY;
 
    ilog( "Replaying blocks, starting at ${next}...", ("next",head_block_num() + 1) );
@@ -77,87 +240,276 @@ void database::reindex( fc::path data_dir )
       _undo_db.disable();
 
    uint32_t skip = node_properties().skip_flags;
+   const uint32_t replay_skip = skip;
 
    size_t total_block_size = _block_id_to_block.total_block_size();
    const auto& gpo = get_global_properties();
-   std::queue< std::tuple< size_t, signed_block, fc::future< void > > > blocks;
+
+   // The replay is a pipeline of three stages:
+   // 1. a background task reads packed blocks from the block database, one batch at a time to keep them
+   //    in order,
+   // 2. each block is deserialized on the thread pool, then precompute_parallel() is started on it,
+   // 3. this thread applies the blocks in order.
+   // Blocks at or after undo_point are pushed and therefore stored again, so they are read on this thread.
+   const uint32_t depth = _reindex_pipeline_depth;
+   auto read_blocks = [this,last_block_num]( uint32_t first, uint32_t count ) {
+      vector<reindex_packed_block> result;
+      result.reserve( count );
+      for( uint32_t num = first; num < first + count && num <= last_block_num; ++num )
+      {
+         result.emplace_back();
+         reindex_packed_block& packed = result.back();
+         packed.block_num = num;
+         packed.position = _block_id_to_block.blocks_current_position();
+         packed.valid = _block_id_to_block.fetch_packed_by_number( num, packed.id, packed.data );
+         if( !packed.valid )
+            break;
+      }
+      return result;
+   };
+
+   std::deque< reindex_block > blocks;
+   vector< reindex_packed_block > read_batch; // filled by the background reader
+   fc::future< void > reading;
+   uint32_t reading_count = 0;
    uint32_t next_block_num = head_block_num() + 1;
    uint32_t i = next_block_num;
-   while( next_block_num <= last_block_num || !blocks.empty() )
-   {
-      if( next_block_num <= last_block_num && blocks.size() < 20 )
+   // how often the apply stage had to wait for the reader, deserialization and precomputation
+   uint64_t waited_for_read = 0;
+   uint64_t waited_for_unpack = 0;
+   uint64_t waited_for_precompute = 0;
+   // Applied blocks are destroyed in batches on the thread pool. A decoded block consists of many small
+   // allocations for its transactions, operations, strings and signatures, freeing them would otherwise take
+   // a noticeable share of the apply stage.
+   auto retired = std::make_shared< vector< signed_block > >();
+   fc::future< void > releasing;
+   auto release_retired = [&retired,&releasing]() {
+      if( releasing.valid() )
+         releasing.wait();
+      releasing = graphene::db::task_pool::instance().run( [batch = retired] () {
+         batch->clear();
+      }, graphene::db::task_priority::low );
+      retired = std::make_shared< vector< signed_block > >();
+      retired->reserve( reindex_release_batch );
+   };
+   retired->reserve( reindex_release_batch );
+
+   auto enqueue = [&blocks,&next_block_num,last_block_num]( vector< reindex_packed_block >&& batch ) {
+      for( reindex_packed_block& packed : batch )
       {
-         const size_t processed_block_size = _block_id_to_block.blocks_current_position();
-         fc::optional< signed_block > block = _block_id_to_block.fetch_by_number( next_block_num++ );
-         if( block.valid() )
+         if( !packed.valid )
          {
-            if( block->timestamp >= last_block->timestamp - gpo.parameters.maximum_time_until_expiration )
-               skip &= ~skip_transaction_dupe_check;
-            blocks.emplace( processed_block_size, std::move(*block), fc::future<void>() );
-            std::get<2>(blocks.back()) = precompute_parallel( std::get<1>(blocks.back()), skip );
+            // let the apply stage handle the gap when it gets there
+            blocks.emplace_back( std::move(packed) );
+            next_block_num = last_block_num + 1; // don't load more blocks
+            return;
          }
-         else
-         {
-            wlog( "Reindexing terminated due to gap:  Block ${i} does not exist!", ("i", i) );
-            uint32_t dropped_count = 0;
-            while( true )
+         blocks.emplace_back( std::move(packed) );
+         reindex_block& entry = blocks.back();
+         entry.unpacked = graphene::db::task_pool::instance().run( [&entry] () {
+            try
             {
-               fc::optional< block_id_type > last_id = _block_id_to_block.last_id();
-               // this can trigger if we attempt to e.g. read a file that has block #2 but no block #1
-               if( !last_id.valid() )
-                  break;
-               // we've caught up to the gap
-               if( block_header::num_from_id( *last_id ) <= i )
-                  break;
-               _block_id_to_block.remove( *last_id );
-               dropped_count++;
+               entry.block = fc::raw::unpack<signed_block>( entry.packed.data );
+               entry.valid = ( entry.block.id() == entry.packed.id );
             }
-            wlog( "Dropped ${n} blocks from after the gap", ("n", dropped_count) );
-            next_block_num = last_block_num + 1; // don't load more blocks
+            catch( const fc::exception& ) {}
+            catch( const std::exception& ) {}
+            entry.packed.data = vector<char>();
+         });
+      }
+   };
+
+   auto start_precompute = [this,&blocks,&skip,&last_block,&gpo]() {
+      for( reindex_block& entry : blocks )
+      {
+         if( entry.precompute_started )
+            continue;
+         if( !entry.packed.valid || !entry.unpacked.ready() )
+            break;
+         entry.precompute_started = true;
+         if( !entry.valid )
+            break;
+         if( entry.block.timestamp >= last_block->timestamp - gpo.parameters.maximum_time_until_expiration )
+            skip &= ~skip_transaction_dupe_check;
+         entry.precomputed = precompute_parallel( entry.block, skip );
+      }
+   };
+
+   while( !blocks.empty() || reading.valid() || next_block_num <= last_block_num )
+   {
+      // stage 1: hand over a finished batch, start reading the next one
+      if( reading.valid() && ( reading.ready() || blocks.empty() ) )
+      {
+         if( !reading.ready() )
+            ++waited_for_read;
+         reading.wait();
+         enqueue( std::move(read_batch) );
+         read_batch.clear();
+         reading = fc::future< void >();
+         reading_count = 0;
+      }
+      if( !reading.valid() && next_block_num <= last_block_num && blocks.size() < depth )
+      {
+         const uint32_t first = next_block_num;
+         uint32_t count = std::min( depth - uint32_t(blocks.size()), last_block_num - first + 1 );
+         if( first < undo_point )
+            count = std::min( count, undo_point - first );
+         next_block_num += count;
+         if( first < undo_point )
+         {
+            reading = graphene::db::task_pool::instance().run( [&read_batch,&read_blocks,first,count] () {
+               read_batch = read_blocks( first, count );
+            });
+            reading_count = count;
          }
+         else
+            enqueue( read_blocks( first, count ) );
       }
-      else
+
+      // stage 2: start precomputation of deserialized blocks in order, because it may change the skip flags
+      start_precompute();
+
+      if( blocks.empty() )
+         continue;
+
+      // stage 3: apply the oldest block
+      reindex_block& front = blocks.front();
+      if( front.packed.valid )
+      {
+         if( !front.unpacked.ready() )
+            ++waited_for_unpack;
+         front.unpacked.wait();
+         start_precompute();
+      }
+      if( !front.valid )
       {
-         std::get<2>(blocks.front()).wait();
-         const signed_block& block = std::get<1>(blocks.front());
+         // wait until no other stage touches the block database or the queued blocks
+         if( reading.valid() )
+            reading.wait();
+         reading = fc::future< void >();
+         read_batch.clear();
+         for( reindex_block& entry : blocks )
+         {
+            if( entry.unpacked.valid() )
+               entry.unpacked.wait();
+            if( entry.precomputed.valid() )
+               entry.precomputed.wait();
+         }
+         blocks.clear();
 
-         if( i % 10000 == 0 )
+         wlog( "Reindexing terminated due to gap:  Block ${i} does not exist!", ("i", i) );
+         uint32_t dropped_count = 0;
+         while( true )
          {
-            std::stringstream bysize;
-            std::stringstream bynum;
-            size_t current_pos = std::get<0>(blocks.front());
-            if( current_pos > total_block_size )
-               total_block_size = current_pos;
-            bysize << std::fixed << std::setprecision(5) << double(current_pos) / total_block_size * 100;
-            bynum << std::fixed << std::setprecision(5) << double(i)*100/last_block_num;
-            ilog(
-               "   [by size: ${size}%   ${processed} of ${total}]   [by num: ${num}%   ${i} of ${last}]",
-               ("size", bysize.str())
-               ("processed", current_pos)
-               ("total", total_block_size)
-               ("num", bynum.str())
-               ("i", i)
-               ("last", last_block_num)
-            );
+            fc::optional< block_id_type > last_id = _block_id_to_block.last_id();
+            // this can trigger if we attempt to e.g. read a file that has block #2 but no block #1
+            if( !last_id.valid() )
+               break;
+            // we've caught up to the gap
+            if( block_header::num_from_id( *last_id ) < i )
+               break;
+            _block_id_to_block.remove( *last_id );
+            dropped_count++;
          }
-         if( i == undo_point )
+         wlog( "Dropped ${n} blocks from after the gap", ("n", dropped_count) );
+         next_block_num = last_block_num + 1; // don't load more blocks
+         continue;
+      }
+      if( !front.precomputed.ready() )
+         ++waited_for_precompute;
+      front.precomputed.wait();
+      const signed_block& block = front.block;
+
+      if( i % 10000 == 0 )
+      {
+         std::stringstream bysize;
+         std::stringstream bynum;
+         size_t current_pos = front.packed.position;
+         if( current_pos > total_block_size )
+            total_block_size = current_pos;
+         bysize << std::fixed << std::setprecision(5) << double(current_pos) / total_block_size * 100;
+         bynum << std::fixed << std::setprecision(5) << double(i)*100/last_block_num;
+         ilog(
+            "   [by size: ${size}%   ${processed} of ${total}]   [by num: ${num}%   ${i} of ${last}]",
+            ("size", bysize.str())
+            ("processed", current_pos)
+            ("total", total_block_size)
+            ("num", bynum.str())
+            ("i", i)
+            ("last", last_block_num)
+         );
+         uint32_t unpacking = 0;
+         uint32_t precomputing = 0;
+         for( const reindex_block& entry : blocks )
          {
-            ilog( "Writing database to disk at block ${i}", ("i",i) );
-            flush();
-            ilog( "Done" );
+            if( !entry.precompute_started )
+               ++unpacking;
+            else if( entry.precomputed.valid() && !entry.precomputed.ready() )
+               ++precomputing;
          }
-         if( i < undo_point )
-            apply_block( block, skip );
-         else
+         ilog(
+            "   [pipeline: reading ${r}, deserializing ${d}, precomputing ${p}, ready ${a} of ${depth}]"
+            "   [apply waited: for read ${wr}, for deserialize ${wd}, for precompute ${wp}]",
+            ("r", reading_count)("d", unpacking)("p", precomputing)
+            ("a", blocks.size() - unpacking - precomputing)("depth", depth)
+            ("wr", waited_for_read)("wd", waited_for_unpack)("wp", waited_for_precompute)
+         );
+         if( _apply_timing_enabled )
          {
-            _undo_db.enable();
-            push_block( block, skip );
+            // the slowest kinds of work so far, by total time
+            auto timing = get_apply_timing();
+            auto& all = timing.operations;
+            all.insert( all.end(), timing.handlers.begin(), timing.handlers.end() );
+            std::sort( all.begin(), all.end(), []( const apply_timing_stats& a, const apply_timing_stats& b ) {
+               return a.total_ns > b.total_ns;
+            });
+            std::stringstream slowest;
+            for( size_t k = 0; k < all.size() && k < 8; ++k )
+               slowest << " " << all[k].name << ": " << all[k].total_ns / 1000000 << "ms/" << all[k].count;
+            ilog( "   [apply timing:${s}]", ("s", slowest.str()) );
          }
-         blocks.pop();
-         i++;
       }
+      if( i == undo_point )
+      {
+         ilog( "Writing database to disk at block ${i}", ("i",i) );
+         flush();
+         write_replay_checkpoint( data_dir, head_block_num(), head_block_id(), replay_skip );
+         archive_replay_checkpoint( data_dir );
+         ilog( "Done" );
+      }
+      if( i < undo_point )
+         apply_block( block, skip );
+      else
+      {
+         _undo_db.enable();
+         push_block( block, skip );
+      }
+      if( i < undo_point && _replay_checkpoint_interval > 0 && i % _replay_checkpoint_interval == 0 )
+      {
+         ilog( "Writing replay checkpoint at block ${i}", ("i",i) );
+         flush();
+         write_replay_checkpoint( data_dir, head_block_num(), head_block_id(), replay_skip );
+         archive_replay_checkpoint( data_dir );
+      }
+      retired->emplace_back( std::move( front.block ) );
+      blocks.pop_front();
+      if( retired->size() >= reindex_release_batch )
+         release_retired();
+      i++;
    }
+   if( releasing.valid() )
+      releasing.wait();
    _undo_db.enable();
+   if( _replay_end_block > 0 && head_block_num() == _replay_end_block )
+   {
+      // keep the end of the range as a checkpoint, the remaining blocks are replayed when it is resumed
+      ilog( "Writing replay checkpoint at the replay end block ${i}", ("i",head_block_num()) );
+      flush();
+      write_replay_checkpoint( data_dir, head_block_num(), head_block_id(), replay_skip );
+      archive_replay_checkpoint( data_dir );
+   }
+   else
+      fc::remove_all( data_dir / replay_checkpoint_file );
    auto end = fc::time_point::now();
    ilog( "Done reindexing, elapsed time: ${t} sec", ("t",double((end-start).count())/1000000.0 ) );
 } FC_CAPTURE_AND_RETHROW( (data_dir) ) }
@@ -169,6 +521,7 @@ void database::wipe(const fc::path& data_dir, bool include_blocks)
      close();
    }
    object_database::wipe(data_dir);
+   fc::remove_all( data_dir / replay_checkpoint_file );
    if( include_blocks )
       fc::remove_all( data_dir / "database" );
 }
@@ -201,6 +554,10 @@ void database::open(
       object_database::open(data_dir);
 
       _block_id_to_block.open(data_dir / "database" / "block_num_to_block");
+      if( _applied_ops_log_enabled )
+         _applied_ops_log.open( data_dir / "database" / "applied_ops" );
+      if( _state_delta_log_enabled )
+         _state_delta_log.open( data_dir / "database" / "state_deltas" );
 
       if( !find(global_property_id_type()) )
          init_genesis(genesis_loader());
@@ -222,6 +579,9 @@ void database::open(
                     ("last_block->id", last_block)("head_block_id",head_block_num()) );
          reindex( data_dir );
       }
+      if( _applied_ops_log.is_open() && _applied_ops_log.last_block_num() < head_block_num() )
+         wlog( "The applied operations log ends at block ${l} but the chain is at block ${h}, "
+               "it is only continued after a replay", ("l",_applied_ops_log.last_block_num())("h",head_block_num()) );
       _opened = true;
    }
    FC_CAPTURE_LOG_AND_RETHROW( (data_dir) )
@@ -262,13 +622,21 @@ void database::close(bool rewind)
    // DB state (issue #336).
    clear_pending();
 
+   // the object database must not be ahead of the block database on disk
+   if( _block_id_to_block.is_open() )
+      _block_id_to_block.flush();
    object_database::flush();
    object_database::close();
 
    if( _block_id_to_block.is_open() )
       _block_id_to_block.close();
+   // the blocks which are not in the log yet were rewound
+   _applied_ops_log.close();
+   _state_delta_log.close();
 
    _fork_db.reset();
+   // the tally is rebuilt from whatever state is loaded next
+   _vote_tally_cache.clear();
 
    _opened = false;
 }
@@ -870,6 +870,10 @@ bool database::check_call_orders( const asset_object& mia, bool enable_black_swa
 
     if( !mia.is_market_issued() ) return false;
 
+    // nothing changed in the market since the last check found nothing to call
+    if( _markets_without_margin_calls.find( mia.id ) != _markets_without_margin_calls.end() )
+       return false;
+
     const asset_bitasset_data_object& bitasset = ( bitasset_ptr ? *bitasset_ptr : mia.bitasset_data(*this) );
     
     // price feeds can cause black swans in prediction markets
@@ -886,6 +890,24 @@ bool database::check_call_orders( const asset_object& mia, bool enable_black_swa
     if( bitasset.is_prediction_market ) return false;
     if( bitasset.current_feed.settlement_price.is_null() ) return false;
 
+    const call_order_index& call_index = get_index_type<call_order_index>();
+    const auto& call_collateral_index = call_index.indices().get<by_collateral>();
+
+    auto call_min = price::min( bitasset.options.short_backing_asset, mia.id );
+    auto call_max = price::max( bitasset.options.short_backing_asset, mia.id );
+
+    auto call_collateral_itr = call_collateral_index.lower_bound( call_min );
+    auto call_collateral_end = call_collateral_index.upper_bound( call_max );
+
+    // Cheap precheck: nothing can be called if there is no call order or the least collateralized one
+    // is feed protected, this is the common case and needs no look at the order book
+    if( call_collateral_itr == call_collateral_end
+          || bitasset.current_maintenance_collateralization < call_collateral_itr->collateralization() )
+    {
+       _markets_without_margin_calls.insert( mia.id );
+       return false;
+    }
+
     const limit_order_index& limit_index = get_index_type<limit_order_index>();
     const auto& limit_price_index = limit_index.indices().get<by_price>();
 
@@ -902,19 +924,14 @@ bool database::check_call_orders( const asset_object& mia, bool enable_black_swa
     auto limit_end = limit_price_index.upper_bound( min_price );
 
     if( limit_itr == limit_end )
+    {
+       _markets_without_margin_calls.insert( mia.id );
        return false;
+    }
 
-    const call_order_index& call_index = get_index_type<call_order_index>();
-    const auto& call_collateral_index = call_index.indices().get<by_collateral>();
-
-    auto call_min = price::min( bitasset.options.short_backing_asset, mia.id );
-    auto call_max = price::max( bitasset.options.short_backing_asset, mia.id );
-
-    auto call_collateral_itr = call_collateral_index.begin();
-    auto call_collateral_end = call_collateral_itr;
-
-    call_collateral_itr = call_collateral_index.lower_bound( call_min );
-    call_collateral_end = call_collateral_index.upper_bound( call_max );
+    // Same for all matches
+    const ratio_type margin_call_pays_ratio = bitasset.current_feed.margin_call_pays_ratio(
+                                                 bitasset.options.extensions.value.margin_call_fee_ratio );
 
     bool margin_called = false;         // toggles true once/if we actually execute a margin call
 
@@ -934,8 +951,7 @@ bool database::check_call_orders( const asset_object& mia, bool enable_black_swa
 
        price match_price  = limit_order.sell_price;
        // There was a check `match_price.validate();` here, which is removed now because it always passes
-       price call_pays_price = match_price * bitasset.current_feed.margin_call_pays_ratio(
-                                                bitasset.options.extensions.value.margin_call_fee_ratio);
+       price call_pays_price = match_price * margin_call_pays_ratio;
        // Since BSIP74, the call "pays" a bit more collateral per debt than the match price, with the
        // excess being kept by the asset issuer as a margin call fee. In what follows, we use
        // call_pays_price for the black swan check, and for the TCR, but we still use the match_price,
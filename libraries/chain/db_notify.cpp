@@ -654,20 +654,24 @@ void database::notify_changed_objects()
 { try {
    if( _undo_db.enabled() ) 
    {
+      using graphene::db::undo_entry;
       const auto& head_undo = _undo_db.head();
 
       // New
       if( !new_objects.empty() )
       {
-        vector<object_id_type> new_ids;  new_ids.reserve(head_undo.new_ids.size());
-        flat_set<account_id_type> new_accounts_impacted;
-        for( const auto& item : head_undo.new_ids )
-        {
-          new_ids.push_back(item);
-          auto obj = find_object(item);
-          if(obj != nullptr)
-            get_relevant_accounts(obj, new_accounts_impacted, false);
-        }
+        vector<object_id_type> new_ids;
+        for( const auto& entry : head_undo.changes )
+          if( entry.kind == undo_entry::created )
+            new_ids.push_back( entry.id );
+        impacted_accounts_provider new_accounts_impacted( [this,&new_ids]( flat_set<account_id_type>& accounts ) {
+          for( const auto& item : new_ids )
+          {
+            auto obj = find_object(item);
+            if(obj != nullptr)
+              get_relevant_accounts(obj, accounts, false);
+          }
+        });
 
         if( new_ids.size() )
            GRAPHENE_TRY_NOTIFY( new_objects, new_ids, new_accounts_impacted)
@@ -676,13 +680,30 @@ void database::notify_changed_objects()
       // Changed
       if( !changed_objects.empty() )
       {
-        vector<object_id_type> changed_ids;  changed_ids.reserve(head_undo.old_values.size());
-        flat_set<account_id_type> changed_accounts_impacted;
-        for( const auto& item : head_undo.old_values )
-        {
-          changed_ids.push_back(item.first);
-          get_relevant_accounts(item.second.get(), changed_accounts_impacted, false);
-        }
+        vector<object_id_type> changed_ids;
+        for( const auto& entry : head_undo.changes )
+          if( entry.kind == undo_entry::modified )
+            changed_ids.push_back( entry.id );
+        impacted_accounts_provider changed_accounts_impacted( [this,&head_undo]( flat_set<account_id_type>& accounts ) {
+          for( const auto& entry : head_undo.changes )
+          {
+            if( entry.kind != undo_entry::modified )
+              continue;
+            if( entry.old_value )
+              get_relevant_accounts(entry.old_value.get(), accounts, false);
+            else
+            {
+              // old values in compact form are only unpacked when an observer asks for the impacted accounts
+              auto obj = find_object(entry.id);
+              if(obj != nullptr)
+              {
+                unique_ptr<object> old_value = obj->clone();
+                old_value->unpack_from( entry.packed_old_value );
+                get_relevant_accounts(old_value.get(), accounts, false);
+              }
+            }
+          }
+        });
 
         if( changed_ids.size() )
            GRAPHENE_TRY_NOTIFY( changed_objects, changed_ids, changed_accounts_impacted)
@@ -691,16 +712,19 @@ void database::notify_changed_objects()
       // Removed
       if( !removed_objects.empty() )
       {
-        vector<object_id_type> removed_ids; removed_ids.reserve( head_undo.removed.size() );
-        vector<const object*> removed; removed.reserve( head_undo.removed.size() );
-        flat_set<account_id_type> removed_accounts_impacted;
-        for( const auto& item : head_undo.removed )
+        vector<object_id_type> removed_ids;
+        vector<const object*> removed;
+        for( const auto& entry : head_undo.changes )
         {
-          removed_ids.emplace_back( item.first );
-          auto obj = item.second.get();
-          removed.emplace_back( obj );
-          get_relevant_accounts(obj, removed_accounts_impacted, false);
+          if( entry.kind != undo_entry::removed )
+            continue;
+          removed_ids.emplace_back( entry.id );
+          removed.emplace_back( entry.old_value.get() );
         }
+        impacted_accounts_provider removed_accounts_impacted( [this,&removed]( flat_set<account_id_type>& accounts ) {
+          for( const object* obj : removed )
+            get_relevant_accounts(obj, accounts, false);
+        });
 
         if( removed_ids.size() )
            GRAPHENE_TRY_NOTIFY( removed_objects, removed_ids, removed, removed_accounts_impacted )
@@ -147,14 +147,17 @@ void database::clear_expired_transactions()
    auto& transaction_idx = static_cast<transaction_index&>(get_mutable_index(implementation_ids,
                                                                              impl_transaction_history_object_type));
    const auto& dedupe_index = transaction_idx.indices().get<by_expiration>();
-   while( (!dedupe_index.empty()) && (head_block_time() > dedupe_index.begin()->trx.expiration) )
+   // find the end of the expired range once instead of comparing every expiration with the head block time
+   const auto end = dedupe_index.lower_bound( head_block_time() );
+   while( dedupe_index.begin() != end )
       transaction_idx.remove(*dedupe_index.begin());
 } FC_CAPTURE_AND_RETHROW() }
 
 void database::clear_expired_proposals()
 {
+   const auto head_time = head_block_time();
    const auto& proposal_expiration_index = get_index_type<proposal_index>().indices().get<by_expiration>();
-   while( !proposal_expiration_index.empty() && proposal_expiration_index.begin()->expiration_time <= head_block_time() )
+   while( !proposal_expiration_index.empty() && proposal_expiration_index.begin()->expiration_time <= head_time )
    {
       const proposal_object& proposal = *proposal_expiration_index.begin();
       processed_transaction result;
@@ -512,16 +515,18 @@ void database::update_maintenance_flag( bool new_maintenance_flag )
 
 void database::update_withdraw_permissions()
 {
+   const auto head_time = head_block_time();
    auto& permit_index = get_index_type<withdraw_permission_index>().indices().get<by_expiration>();
-   while( !permit_index.empty() && permit_index.begin()->expiration <= head_block_time() )
+   while( !permit_index.empty() && permit_index.begin()->expiration <= head_time )
       remove(*permit_index.begin());
 }
 
 void database::clear_expired_htlcs()
 {
+   const auto head_time = head_block_time();
    const auto& htlc_idx = get_index_type<htlc_index>().indices().get<by_expiration>();
    while ( htlc_idx.begin() != htlc_idx.end()
-         && htlc_idx.begin()->conditions.time_lock.expiration <= head_block_time() )
+         && htlc_idx.begin()->conditions.time_lock.expiration <= head_time )
    {
       const htlc_object& obj = *htlc_idx.begin();
       const auto amount = asset(obj.transfer.amount, obj.transfer.asset_id);
@@ -539,19 +544,30 @@ generic_operation_result database::process_tickets()
    generic_operation_result result;
    share_type total_delta_pob;
    share_type total_delta_inactive;
+
+   // Changes of the ticket totals of the accounts, applied once per account after all tickets are processed
+   struct stat_delta
+   {
+      share_type inactive_amount;
+      share_type forever_amount;
+      share_type forever_value;
+      share_type other_amount;
+      share_type other_value;
+   };
+   flat_map<account_id_type, stat_delta> stat_deltas;
+
+   const auto head_time = head_block_time();
    auto& idx = get_index_type<ticket_index>().indices().get<by_next_update>();
-   while( !idx.empty() && idx.begin()->next_auto_update_time <= head_block_time() )
+   while( !idx.empty() && idx.begin()->next_auto_update_time <= head_time )
    {
       const ticket_object& ticket = *idx.begin();
-      const auto& stat = get_account_stats_by_owner( ticket.account );
+      stat_delta& delta = stat_deltas[ ticket.account ];
       if( ticket.status == withdrawing && ticket.current_type == liquid )
       {
          adjust_balance( ticket.account, ticket.amount );
          // Note: amount.asset_id is checked when creating the ticket, so no check here
-         modify( stat, [&ticket](account_statistics_object& aso) {
-            aso.total_core_pol -= ticket.amount.amount;
-            aso.total_pol_value -= ticket.value;
-         });
+         delta.other_amount -= ticket.amount.amount;
+         delta.other_value -= ticket.value;
          result.removed_objects.insert( ticket.id );
          remove( ticket );
       }
@@ -564,53 +580,49 @@ generic_operation_result database::process_tickets()
          });
          result.updated_objects.insert( ticket.id );
 
-         share_type delta_inactive_amount;
-         share_type delta_forever_amount;
-         share_type delta_forever_value;
-         share_type delta_other_amount;
-         share_type delta_other_value;
-
          if( old_type == lock_forever ) // It implies that the new type is lock_forever too
          {
             if( ticket.value == 0 )
             {
                total_delta_pob -= ticket.amount.amount;
                total_delta_inactive += ticket.amount.amount;
-               delta_inactive_amount = ticket.amount.amount;
-               delta_forever_amount = -ticket.amount.amount;
+               delta.inactive_amount += ticket.amount.amount;
+               delta.forever_amount -= ticket.amount.amount;
             }
-            delta_forever_value = ticket.value - old_value;
+            delta.forever_value += ticket.value - old_value;
          }
          else // old_type != lock_forever
          {
             if( ticket.current_type == lock_forever )
             {
                total_delta_pob += ticket.amount.amount;
-               delta_forever_amount = ticket.amount.amount;
-               delta_forever_value = ticket.value;
-               delta_other_amount = -ticket.amount.amount;
-               delta_other_value = -old_value;
+               delta.forever_amount += ticket.amount.amount;
+               delta.forever_value += ticket.value;
+               delta.other_amount -= ticket.amount.amount;
+               delta.other_value -= old_value;
             }
             else // ticket.current_type != lock_forever
             {
-               delta_other_value = ticket.value - old_value;
+               delta.other_value += ticket.value - old_value;
             }
          }
-
-         // Note: amount.asset_id is checked when creating the ticket, so no check here
-         modify( stat, [delta_inactive_amount,delta_forever_amount,delta_forever_value,
-                        delta_other_amount,delta_other_value](account_statistics_object& aso) {
-            aso.total_core_inactive += delta_inactive_amount;
-            aso.total_core_pob += delta_forever_amount;
-            aso.total_core_pol += delta_other_amount;
-            aso.total_pob_value += delta_forever_value;
-            aso.total_pol_value += delta_other_value;
-         });
-
       }
       // TODO if a lock_forever ticket lost all the value, remove it
    }
 
+   // Note: amount.asset_id is checked when creating the ticket, so no check here
+   for( const auto& item : stat_deltas )
+   {
+      const stat_delta& delta = item.second;
+      modify( get_account_stats_by_owner( item.first ), [&delta](account_statistics_object& aso) {
+         aso.total_core_inactive += delta.inactive_amount;
+         aso.total_core_pob += delta.forever_amount;
+         aso.total_core_pol += delta.other_amount;
+         aso.total_pob_value += delta.forever_value;
+         aso.total_pol_value += delta.other_value;
+      });
+   }
+
    // TODO merge stable tickets with the same account and the same type
 
    // Update global data
@@ -84,14 +84,18 @@ uint32_t database::update_witness_missed_blocks( const signed_block& b )
    uint32_t missed_blocks = get_slot_at_time( b.timestamp );
    FC_ASSERT( missed_blocks != 0, "Trying to push double-produced block onto current block?!" );
    missed_blocks--;
-   const auto& witnesses = witness_schedule_id_type()(*this).current_shuffled_witnesses;
+   const auto& witnesses = get_witness_schedule_object().current_shuffled_witnesses;
    if( missed_blocks < witnesses.size() )
+   {
+      // Same as get_scheduled_witness( i+1 ), without looking up the schedule for every slot
+      const uint64_t first_aslot = get_dynamic_global_properties().current_aslot + 1;
       for( uint32_t i = 0; i < missed_blocks; ++i ) {
-         const auto& witness_missed = get_scheduled_witness( i+1 )(*this);
+         const auto& witness_missed = witnesses[ ( first_aslot + i ) % witnesses.size() ](*this);
          modify( witness_missed, []( witness_object& w ) {
             w.total_missed++;
          });
       }
+   }
    return missed_blocks;
 }
 
@@ -108,30 +112,30 @@ void database::update_witness_schedule()
 
    if( head_block_num() % gpo.active_witnesses.size() == 0 )
    {
-      modify( wso, [&]( witness_schedule_object& _wso )
+      // The order of the whole round is computed up front, so the undo copy of the schedule object
+      // is the only allocation done inside modify()
+      vector<witness_id_type> shuffled( gpo.active_witnesses.begin(), gpo.active_witnesses.end() );
+
+      const uint64_t now_hi = uint64_t(head_block_time().sec_since_epoch()) << 32;
+      const uint32_t count = shuffled.size();
+      for( uint32_t i = 0; i < count; ++i )
+      {
+         /// High performance random generator
+         /// http://xorshift.di.unimi.it/
+         uint64_t k = now_hi + uint64_t(i)*2685821657736338717ULL;
+         k ^= (k >> 12);
+         k ^= (k << 25);
+         k ^= (k >> 27);
+         k *= 2685821657736338717ULL;
+
+         uint32_t jmax = count - i;
+         uint32_t j = i + k%jmax;
+         std::swap( shuffled[i], shuffled[j] );
+      }
+
+      modify( wso, [&shuffled]( witness_schedule_object& _wso )
       {
-         _wso.current_shuffled_witnesses.clear();
-         _wso.current_shuffled_witnesses.reserve( gpo.active_witnesses.size() );
-
-         for( const witness_id_type& w : gpo.active_witnesses )
-            _wso.current_shuffled_witnesses.push_back( w );
-
-         auto now_hi = uint64_t(head_block_time().sec_since_epoch()) << 32;
-         for( uint32_t i = 0; i < _wso.current_shuffled_witnesses.size(); ++i )
-         {
-            /// High performance random generator
-            /// http://xorshift.di.unimi.it/
-            uint64_t k = now_hi + uint64_t(i)*2685821657736338717ULL;
-            k ^= (k >> 12);
-            k ^= (k << 25);
-            k ^= (k >> 27);
-            k *= 2685821657736338717ULL;
-
-            uint32_t jmax = _wso.current_shuffled_witnesses.size() - i;
-            uint32_t j = i + k%jmax;
-            std::swap( _wso.current_shuffled_witnesses[i],
-                       _wso.current_shuffled_witnesses[j] );
-         }
+         _wso.current_shuffled_witnesses = std::move( shuffled );
       });
    }
 }
@@ -55,8 +55,17 @@ database& generic_evaluator::db()const { return trx_state->db(); }
       fee_paying_account = &account_id(d);
       fee_paying_account_statistics = &fee_paying_account->statistics(d);
 
-      fee_asset = &fee.asset_id(d);
-      fee_asset_dyn_data = &fee_asset->dynamic_asset_data_id(d);
+      // Most operations pay in the core asset, whose objects are cached by the database
+      if( fee.asset_id == asset_id_type() )
+      {
+         fee_asset = &d.get_core_asset();
+         fee_asset_dyn_data = &d.get_core_dynamic_data();
+      }
+      else
+      {
+         fee_asset = &fee.asset_id(d);
+         fee_asset_dyn_data = &fee_asset->dynamic_asset_data_id(d);
+      }
 
       FC_ASSERT( is_authorized_asset( d, *fee_paying_account, *fee_asset ), 
             "Account ${acct} '${name}' attempted to pay fee by using asset ${a} '${sym}', "
@@ -24,7 +24,32 @@
 #include <graphene/chain/fork_database.hpp>
 #include <graphene/chain/exceptions.hpp>
 
+#include <fc/io/raw.hpp>
+
 namespace graphene { namespace chain {
+
+fork_item::fork_item( signed_block d )
+: num( d.block_num() ), id( d.id() ), previous( d.previous ),
+  packed( std::make_shared< const vector<char> >( fc::raw::pack( d ) ) ),
+  _decoded( std::make_shared< const signed_block >( std::move( d ) ) )
+{
+}
+
+shared_ptr< const signed_block > fork_item::block()const
+{
+   auto result = std::atomic_load( &_decoded );
+   if( result )
+      return result;
+   auto decoded = std::make_shared< signed_block >( fc::raw::unpack< signed_block >( *packed ) );
+   decoded->id(); // computed once here, the shared object must not be modified later
+   return decoded;
+}
+
+void fork_item::release_decoded()const
+{
+   std::atomic_store( &_decoded, shared_ptr< const signed_block >() );
+}
+
 fork_database::fork_database()
 {
 }
@@ -62,7 +87,7 @@ shared_ptr<fork_item>  fork_database::push_block(const signed_block& b)
    catch ( const unlinkable_block_exception& e )
    {
       wlog( "Pushing block to fork database that failed to link: ${id}, ${num}", ("id",b.id())("num",b.block_num()) );
-      wlog( "Head: ${num}, ${id}", ("num",_head->data.block_num())("id",_head->data.id()) );
+      wlog( "Head: ${num}, ${id}", ("num",_head->num)("id",_head->id) );
       throw;
    }
    return _head;
@@ -89,12 +114,15 @@ void  fork_database::_push_block(const item_ptr& item)
    if( !_head ) _head = item;
    else if( item->num > _head->num )
    {
+      _head->release_decoded();
       _head = item;
       uint32_t min_num = _head->num - std::min( _max_size, _head->num );
       auto& num_idx = _index.get<block_num>();
       while( num_idx.size() && (*num_idx.begin())->num < min_num )
          num_idx.erase( num_idx.begin() );
    }
+   // the blocks of other branches keep their decoded form with the precomputed signees,
+   // they are applied when switching forks
 }
 
 void fork_database::set_max_size( uint32_t s )
@@ -160,19 +188,19 @@ pair<fork_database::branch_type,fork_database::branch_type>
    auto second_branch = *second_branch_itr;
 
 
-   while( first_branch->data.block_num() > second_branch->data.block_num() )
+   while( first_branch->num > second_branch->num )
    {
       result.first.push_back(first_branch);
       first_branch = first_branch->prev.lock();
       FC_ASSERT(first_branch);
    }
-   while( second_branch->data.block_num() > first_branch->data.block_num() )
+   while( second_branch->num > first_branch->num )
    {
       result.second.push_back( second_branch );
       second_branch = second_branch->prev.lock();
       FC_ASSERT(second_branch);
    }
-   while( first_branch->data.previous != second_branch->data.previous )
+   while( first_branch->previous != second_branch->previous )
    {
       result.first.push_back(first_branch);
       result.second.push_back(second_branch);
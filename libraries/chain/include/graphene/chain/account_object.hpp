@@ -29,6 +29,9 @@
 
 #include <boost/multi_index/composite_key.hpp>
 
+#include <cstring>
+#include <unordered_map>
+
 namespace graphene { namespace chain {
    class database;
    class account_object;
@@ -316,6 +319,9 @@ namespace graphene { namespace chain {
    /**
     *  @brief This secondary index will allow a reverse lookup of all accounts that a particular key or account
     *  is an potential signing authority.
+    *
+    *  The lookups are hash tables of sorted vectors, nearly all keys are referenced by one or two accounts only,
+    *  and a key which is no longer referenced is removed.
     */
    class account_member_index : public secondary_index
    {
@@ -325,38 +331,71 @@ namespace graphene { namespace chain {
          virtual void about_to_modify( const object& before ) override;
          virtual void object_modified( const object& after  ) override;
 
+         /// Fills the (empty) index from all existing accounts at once
+         void load( const index& accounts );
+
+         /// Keys and addresses are hashes already, so a part of their bytes does as their hash
+         struct account_id_hash
+         {
+            size_t operator()( const account_id_type& id )const { return std::hash<uint64_t>()( id.instance.value ); }
+         };
+         struct public_key_hash
+         {
+            size_t operator()( const public_key_type& k )const
+            {
+               size_t s;
+               std::memcpy( (char*)&s, k.key_data.data() + 1, sizeof(s) ); // skip the parity byte
+               return s;
+            }
+         };
+         struct address_hash
+         {
+            size_t operator()( const address& a )const
+            {
+               size_t s;
+               std::memcpy( (char*)&s, a.addr.data(), sizeof(s) );
+               return s;
+            }
+         };
+
+         typedef flat_set<account_id_type>      account_set;
 
          /** given an account or key, map it to the set of accounts that reference it in an active or owner authority */
-         map< account_id_type, set<account_id_type> >                    account_to_account_memberships;
-         map< public_key_type, set<account_id_type>, pubkey_comparator > account_to_key_memberships;
+         std::unordered_map< account_id_type, account_set, account_id_hash > account_to_account_memberships;
+         std::unordered_map< public_key_type, account_set, public_key_hash > account_to_key_memberships;
          /** some accounts use address authorities in the genesis block */
-         map< address, set<account_id_type> >                            account_to_address_memberships;
+         std::unordered_map< address, account_set, address_hash >            account_to_address_memberships;
 
 
       protected:
-         set<account_id_type>                    get_account_members( const account_object& a )const;
-         set<public_key_type, pubkey_comparator> get_key_members( const account_object& a )const;
-         set<address>                            get_address_members( const account_object& a )const;
+         flat_set<account_id_type>                    get_account_members( const account_object& a )const;
+         flat_set<public_key_type, pubkey_comparator> get_key_members( const account_object& a )const;
+         flat_set<address>                            get_address_members( const account_object& a )const;
 
-         set<account_id_type>                    before_account_members;
-         set<public_key_type, pubkey_comparator> before_key_members;
-         set<address>                            before_address_members;
+         flat_set<account_id_type>                    before_account_members;
+         flat_set<public_key_type, pubkey_comparator> before_key_members;
+         flat_set<address>                            before_address_members;
    };
 
 
    /**
     *  @brief This secondary index will allow fast access to the balance objects
     *         that belonging to an account.
+    *
+    *  The balances of an account are kept in a vector sorted by asset, most accounts hold only a few assets, so
+    *  the lookup of a balance stays within a cache line or two.
     */
    class balances_by_account_index : public secondary_index
    {
       public:
+         typedef flat_map< asset_id_type, const account_balance_object* > account_balances;
+
          virtual void object_inserted( const object& obj ) override;
          virtual void object_removed( const object& obj ) override;
          virtual void about_to_modify( const object& before ) override;
          virtual void object_modified( const object& after  ) override;
 
-         const map< asset_id_type, const account_balance_object* >& get_account_balances( const account_id_type& acct )const;
+         const account_balances& get_account_balances( const account_id_type& acct )const;
          const account_balance_object* get_account_balance( const account_id_type& acct, const asset_id_type& asset )const;
 
       private:
@@ -364,7 +403,7 @@ namespace graphene { namespace chain {
          static const uint64_t mask;
 
          /** Maps each account to its balance objects */
-         vector< vector< map< asset_id_type, const account_balance_object* > > > balances;
+         vector< vector< account_balances > > balances;
          std::stack< object_id_type > ids_being_modified;
    };
 
@@ -0,0 +1,82 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <graphene/chain/operation_history_object.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <functional>
+#include <map>
+
+namespace graphene { namespace chain {
+
+   /// The real and virtual operations which were applied with a block
+   struct applied_ops_log_entry
+   {
+      uint32_t                          block_num = 0;
+      fc::time_point_sec                timestamp;
+      vector<operation_history_object>  ops;
+   };
+
+   /**
+    * @class applied_ops_log
+    * @brief An append-only log of the operations applied with the irreversible blocks
+    *
+    * The operations of a block, including the virtual operations and the operation results, are only known while
+    * the block is applied. They are kept in memory until the block is irreversible, and written to the log then,
+    * so that plugins can be rebuilt from the log without replaying the chain.
+    *
+    * Each entry is written as its packed size followed by the packed entry, an incomplete entry at the end of the
+    * log, e.g. after a crash, is dropped when the log is opened.
+    */
+   class applied_ops_log
+   {
+      public:
+         void open( const fc::path& file );
+         bool is_open()const { return _open; }
+         void close();
+
+         /// Keeps the operations of a block until it is irreversible, replacing those of the blocks with the same
+         /// or higher numbers, which were undone. Blocks which are in the log already, or would leave a gap in it,
+         /// are ignored. The operations are shared with the other consumers of the block, not copied.
+         void add_block( uint32_t block_num, fc::time_point_sec timestamp, const shared_applied_operations& ops );
+         /// Writes the operations of the blocks up to @p last_irreversible
+         void write_irreversible( uint32_t last_irreversible );
+
+         /// @return the number of the last block in the log, 0 if the log is empty
+         uint32_t last_block_num()const { return _last_block_num; }
+
+         /// Calls @p f with the entries of the log in block order
+         void for_each( const std::function<void(const applied_ops_log_entry&)>& f )const;
+
+      private:
+         fc::path                                   _file;
+         bool                                       _open = false;
+         uint32_t                                   _last_block_num = 0;
+         struct pending_block
+         {
+            fc::time_point_sec         timestamp;
+            shared_applied_operations  ops;
+         };
+         std::map<uint32_t, pending_block>          _pending;
+   };
+
+} } // graphene::chain
+
+FC_REFLECT( graphene::chain::applied_ops_log_entry, (block_num)(timestamp)(ops) )
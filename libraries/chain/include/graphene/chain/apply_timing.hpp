@@ -0,0 +1,107 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <graphene/protocol/types.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief Accumulated duration of one kind of work done while applying blocks
+    */
+   struct apply_timing_stats
+   {
+      string           name;
+      uint64_t         count    = 0;
+      uint64_t         total_ns = 0;
+      /// Entry i counts the durations between 2^i and 2^(i+1) nanoseconds, the last one also all longer ones
+      vector<uint64_t> histogram;
+   };
+
+   /**
+    * @class apply_timer
+    * @brief Lock-free collector of durations, it can be read while it is updated from another thread
+    */
+   class apply_timer
+   {
+      public:
+         static constexpr uint32_t num_buckets = 32;
+
+         void add( std::chrono::steady_clock::duration elapsed )
+         {
+            const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>( elapsed ).count();
+            uint32_t bucket = 0;
+            while( bucket + 1 < num_buckets && ( ns >> ( bucket + 1 ) ) != 0 )
+               ++bucket;
+            _count.fetch_add( 1, std::memory_order_relaxed );
+            _total_ns.fetch_add( ns, std::memory_order_relaxed );
+            _buckets[bucket].fetch_add( 1, std::memory_order_relaxed );
+         }
+
+         uint64_t count()const { return _count.load( std::memory_order_relaxed ); }
+
+         apply_timing_stats get_stats( const string& name )const;
+         void reset();
+
+      private:
+         std::atomic<uint64_t>                          _count{0};
+         std::atomic<uint64_t>                          _total_ns{0};
+         std::array<std::atomic<uint64_t>, num_buckets> _buckets{};
+   };
+
+   /**
+    * @brief Times a piece of work into an apply_timer, if there is one
+    */
+   class scoped_apply_timer
+   {
+      public:
+         explicit scoped_apply_timer( apply_timer* timer )
+         : _timer( timer ), _start( timer ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point() )
+         {}
+         ~scoped_apply_timer()
+         {
+            if( _timer )
+               _timer->add( std::chrono::steady_clock::now() - _start );
+         }
+
+      private:
+         apply_timer* const                          _timer;
+         const std::chrono::steady_clock::time_point _start;
+   };
+
+   /**
+    * @brief Where the time of block application went, see database::get_apply_timing()
+    */
+   struct apply_timing_report
+   {
+      bool                       enabled = false;
+      /// Per operation type which was applied, nested operations of proposals are also counted in the outer one
+      vector<apply_timing_stats> operations;
+      /// Whole transactions and the named handlers of applied_block
+      vector<apply_timing_stats> handlers;
+   };
+
+} } // graphene::chain
+
+FC_REFLECT( graphene::chain::apply_timing_stats, (name)(count)(total_ns)(histogram) )
+FC_REFLECT( graphene::chain::apply_timing_report, (enabled)(operations)(handlers) )
@@ -0,0 +1,103 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <graphene/chain/operation_history_object.hpp>
+#include <graphene/protocol/block.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace fc { class thread; }
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief Everything a plugin learns about an applied block without reading the database
+    */
+   struct applied_block_event
+   {
+      signed_block                                block;
+      shared_applied_operations                   applied_operations;
+   };
+
+   /**
+    * @brief Progress of an async_block_handler
+    */
+   struct async_block_handler_stats
+   {
+      string   name;
+      uint32_t capacity           = 0; ///< maximum number of queued blocks
+      uint64_t queued             = 0; ///< blocks waiting to be handled
+      uint64_t max_queued         = 0; ///< highest number of queued blocks seen
+      uint32_t last_queued_block  = 0;
+      uint32_t last_handled_block = 0; ///< the lag of the handler is the difference to last_queued_block
+      uint64_t producer_waits     = 0; ///< times block application waited because the queue was full
+      uint64_t failures           = 0; ///< blocks whose handler threw
+   };
+
+   /**
+    * @class async_block_handler
+    * @brief Hands applied blocks to a plugin handler running in order on its own thread
+    *
+    * This is for plugins which only need the block and its operations and do not read the database while
+    * handling them, since the chain moves on meanwhile. Plugins which need the database state of the block
+    * must use the synchronous signals of the database.
+    *
+    * The queue is bounded: when it is full, block application waits for the handler (back-pressure) rather than
+    * letting the handler fall behind without limit. See database::connect_applied_block_async().
+    */
+   class async_block_handler
+   {
+      public:
+         typedef std::function<void( const applied_block_event& )> handler_type;
+
+         async_block_handler( const string& name, uint32_t capacity, handler_type handler );
+         /// Handles the queued blocks before returning
+         ~async_block_handler();
+
+         /// Queues a block, waits while the queue is full
+         void post( applied_block_event&& event );
+         /// Waits until all queued blocks are handled
+         void drain();
+
+         async_block_handler_stats get_stats()const;
+
+      private:
+         void run();
+
+         const string                      _name;
+         const uint32_t                    _capacity;
+         const handler_type                _handler;
+         std::unique_ptr<fc::thread>       _thread;
+
+         mutable std::mutex                _mutex;
+         std::condition_variable           _changed;
+         std::deque<applied_block_event>   _events;
+         bool                              _running = false;  ///< whether a task of _thread handles the queue
+         async_block_handler_stats         _stats;
+   };
+
+} } // graphene::chain
+
+FC_REFLECT( graphene::chain::async_block_handler_stats,
+            (name)(capacity)(queued)(max_queued)(last_queued_block)(last_handled_block)(producer_waits)(failures) )
@@ -0,0 +1,87 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <graphene/chain/lru_cache.hpp>
+#include <graphene/protocol/block.hpp>
+
+#include <atomic>
+#include <memory>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief Hit and miss counters of a block_cache
+    */
+   struct block_cache_stats
+   {
+      uint64_t hits     = 0; ///< number of lookups which found the block
+      uint64_t misses   = 0; ///< number of lookups which had to decode the block
+      uint64_t size     = 0; ///< number of cached blocks
+      uint64_t capacity = 0; ///< maximum number of cached blocks, 0 if the cache is disabled
+   };
+
+   /**
+    * @class block_cache
+    * @brief A thread-safe LRU cache of decoded blocks by block number
+    *
+    * Blocks are kept as immutable shared objects, so the lock is only held for looking them up.
+    */
+   class block_cache
+   {
+      public:
+         typedef std::shared_ptr<const signed_block> block_ptr;
+
+         /// Set the maximum number of cached blocks, 0 to disable caching
+         void set_capacity( size_t capacity ) { _blocks.set_capacity( capacity ); }
+         size_t capacity()const { return _blocks.capacity(); }
+
+         /// @return the cached block with the given number and id, or null
+         block_ptr get( uint32_t block_num, const block_id_type& id )const;
+         /// @return the cached block with the given number, or null
+         block_ptr get( uint32_t block_num )const;
+
+         /// @return the number of removals so far, to be passed to put() by readers of the underlying storage
+         uint64_t generation()const { return _generation; }
+
+         /// Add a block, @p block must be the decoded block with the given id and have its id computed already,
+         /// so that the shared copy is never modified. The block is dropped if anything was removed from the cache
+         /// since @p generation was taken, as it may have been read before being replaced in the storage.
+         void put( const block_id_type& id, const signed_block& block, uint64_t generation );
+         void erase( uint32_t block_num );
+         /// Remove all blocks with numbers lower than @p block_num
+         void erase_below( uint32_t block_num );
+         void clear();
+
+         block_cache_stats get_stats()const { return _blocks.get_stats<block_cache_stats>(); }
+
+      private:
+         struct entry
+         {
+            block_id_type id;
+            block_ptr     block;
+         };
+
+         mutable lru_cache<uint32_t, entry> _blocks;
+         std::atomic<uint64_t>              _generation{0};
+   };
+
+} } // graphene::chain
+
+FC_REFLECT( graphene::chain::block_cache_stats, (hits)(misses)(size)(capacity) )
@@ -24,36 +24,132 @@
 #pragma once
 #include <fstream>
 #include <graphene/protocol/block.hpp>
+#include <graphene/chain/block_cache.hpp>
 
 #include <fc/filesystem.hpp>
 
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+
 namespace graphene { namespace chain {
    struct index_entry;
    using namespace graphene::protocol;
 
+   /**
+    * @brief Stores blocks in an append-only block log and an index of their positions by block number
+    *
+    * Stored blocks are buffered in memory and written to disk in batches, optionally compressed, and at the latest
+    * when they become irreversible, see flush_through(). Both files are read through memory mappings of fixed
+    * size segments, only the segments at their ends are replaced after each batch, so readers only hold a lock
+    * for looking up the write buffer and the current mappings. Reading is thread-safe, writing (store, remove,
+    * flush, close) must be done by a single thread.
+    */
    class block_database 
    {
       public:
+         block_database();
+         ~block_database();
+
          void open( const fc::path& dbdir );
          bool is_open()const;
+         /// Writes all buffered blocks to disk
          void flush();
+         /// Writes the buffered blocks up to @p block_num to disk, so that irreversible blocks are not lost in a crash.
+         /// In a compressed log, they are written as a frame of their own, which may be shorter than the frame size.
+         void flush_through( uint32_t block_num );
          void close();
 
+         /// Set the number of stored blocks which are buffered before they are written to disk together
+         void set_write_batch_size( uint32_t size ) { _write_batch_size = size > 0 ? size : 1; }
+
+         /**
+          * @brief Create new block logs in compressed format, must be called before open()
+          * @param frame_size the number of blocks which are compressed together, 0 to disable compression
+          *
+          * Blocks are buffered and compressed together in frames which can be decompressed independently, so that
+          * reading a block only needs to decompress a single frame. Existing block logs keep their format.
+          */
+         void set_compression( uint32_t frame_size ) { _frame_size = frame_size; }
+         bool is_compressed()const { return _compressed; }
+
+         /// Set the maximum number of decoded blocks kept in memory for fetch_optional() and fetch_by_number(),
+         /// 0 to disable the cache
+         void set_cache_size( size_t blocks ) { _cache.set_capacity( blocks ); }
+         block_cache_stats get_cache_stats()const { return _cache.get_stats(); }
+
          void store( const block_id_type& id, const signed_block& b );
+         /// Store an already serialized block, the buffer is kept until it is written
+         void store( const block_id_type& id, std::shared_ptr<const vector<char>> packed );
          void remove( const block_id_type& id );
 
+         /**
+          * @brief Drop all blocks before @p first_block_to_keep
+          *
+          * The blocks are removed from the index with the next write batch. Their disk space is released with
+          * the batch after that, so that concurrent readers never see a block being overwritten. Space is only
+          * released on platforms which support punching holes into files, i.e. Linux.
+          */
+         void prune( uint32_t first_block_to_keep );
+         /// @return the lowest block number which has not been pruned
+         uint32_t first_block_num()const { return _first_block_num; }
+
          bool                   contains( const block_id_type& id )const;
          block_id_type          fetch_block_id( uint32_t block_num )const;
+         /// Looks up the ids of several blocks with a single access to the write buffer and the index,
+         /// throws if any of them is not stored
+         vector<block_id_type>  fetch_block_ids( const vector<uint32_t>& block_nums )const;
          optional<signed_block> fetch_optional( const block_id_type& id )const;
          optional<signed_block> fetch_by_number( uint32_t block_num )const;
+         /// Reads a block without deserializing it, @return false if the block is not available
+         bool                   fetch_packed_by_number( uint32_t block_num, block_id_type& id,
+                                                        vector<char>& data )const;
          optional<signed_block> last()const;
          optional<block_id_type> last_id()const;
+         /// @return the position in the block log after the most recently read block
          size_t                 blocks_current_position()const;
          size_t                 total_block_size()const;
       private:
-         optional<index_entry> last_index_entry()const;
+         struct mapped_files;
+         struct pending_block
+         {
+            block_id_type                       id;
+            std::shared_ptr<const vector<char>> data;
+         };
+
+         /// Looks up a block among the buffered and the written blocks, @p data is only filled if not null
+         bool lookup( uint32_t block_num, block_id_type& id, vector<char>* data )const;
+         optional<uint32_t> last_block_num()const;
+         /// Truncates invalid entries at the end of the index, e.g. after a crash
+         void repair_index();
+         /// Writes the buffered blocks up to @p last_block_num
+         void write_pending( uint32_t last_block_num );
+         /// Maps the files as written and drops the buffered blocks up to @p written_through
+         void remap( uint32_t written_through );
+         /// Removes blocks requested by prune() from the index and releases the space of blocks pruned before
+         void apply_pruning();
+
          fc::path _index_filename;
-         mutable std::fstream _blocks;
-         mutable std::fstream _block_num_to_pos;
+         fc::path _blocks_filename;
+         /// Only used for writing
+         std::fstream _blocks;
+         std::fstream _block_num_to_pos;
+
+         uint32_t                             _write_batch_size = 32;
+         uint32_t                             _frame_size = 0;
+         bool                                 _compressed = false;
+         /// Guards _pending and _files
+         mutable std::mutex                   _mutex;
+         std::map<uint32_t, pending_block>    _pending;
+         std::shared_ptr<const mapped_files>  _files;
+         mutable std::atomic<size_t>          _current_position{0};
+         mutable block_cache                  _cache;
+
+         std::atomic<uint32_t>                _first_block_num{1};
+         uint32_t                             _prune_below = 0;
+         /// Ranges of the files which can be released with the next write batch
+         uint64_t                             _release_blocks_end = 0;
+         uint64_t                             _release_index_end = 0;
    };
 } }
@@ -33,6 +33,10 @@ namespace graphene { namespace chain {
          * @ingroup protocol
          *
          * Commit-reveal data the primary unit to give and store commit-reveal object.
+         *
+         * There is at most one object per witness account: a new commit overwrites the previous round in
+         * place, so the index is bounded by the number of witnesses and needs no pruning. Removing stale
+         * objects would change the IDs returned by later commits and thus has to be a hardfork.
          */
         class commit_reveal_v2_object : public graphene::db::abstract_object<commit_reveal_v2_object>
         {
@@ -47,6 +51,7 @@ namespace graphene { namespace chain {
         };
 
         struct by_account;
+        struct by_maintenance_time;
 
         typedef multi_index_container<
                commit_reveal_v2_object,
@@ -56,6 +61,12 @@ namespace graphene { namespace chain {
                            composite_key< commit_reveal_v2_object,
                                  member< commit_reveal_v2_object, account_id_type, &commit_reveal_v2_object::account>
                            >
+                     >,
+                     ordered_unique< tag<by_maintenance_time>,
+                           composite_key< commit_reveal_v2_object,
+                                 member< commit_reveal_v2_object, uint32_t, &commit_reveal_v2_object::maintenance_time>,
+                                 member< commit_reveal_v2_object, account_id_type, &commit_reveal_v2_object::account>
+                           >
                      >
                >
         > commit_reveal_v2_multi_index_type;
@@ -0,0 +1,82 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <graphene/chain/lru_cache.hpp>
+#include <graphene/protocol/transaction.hpp>
+
+#include <cstring>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief Hit and miss counters of a confidential_proof_cache
+    */
+   struct confidential_proof_cache_stats
+   {
+      uint64_t hits     = 0; ///< number of transactions whose proofs were known to be valid
+      uint64_t misses   = 0; ///< number of transactions whose proofs had to be verified
+      uint64_t size     = 0; ///< number of cached transaction IDs
+      uint64_t capacity = 0; ///< maximum number of cached transaction IDs, 0 if the cache is disabled
+   };
+
+   /**
+    * @class confidential_proof_cache
+    * @brief A thread-safe LRU set of IDs of transactions with confidential operations which passed validation
+    *
+    * Validating a blinded transfer verifies commitment sums and range proofs, which is by far the most expensive
+    * stateless check of any operation. The ID of a transaction covers all of its operations, so a transaction
+    * which arrives again in a block does not need to be validated twice.
+    */
+   class confidential_proof_cache
+   {
+      public:
+         /// Set the maximum number of cached transaction IDs, 0 to disable caching
+         void set_capacity( size_t capacity ) { _ids.set_capacity( capacity ); }
+         size_t capacity()const { return _ids.capacity(); }
+
+         /// @return whether @p trx has operations with commitments or range proofs to verify
+         static bool has_confidential_operations( const transaction& trx );
+
+         /// Validates @p trx, unless a transaction with the same ID was validated before
+         void validate( const precomputable_transaction& trx )const;
+
+         void clear() { _ids.clear(); }
+
+         confidential_proof_cache_stats get_stats()const
+         { return _ids.get_stats<confidential_proof_cache_stats>(); }
+
+      private:
+         struct id_hash
+         {
+            size_t operator()( const transaction_id_type& id )const
+            {
+               // the ID is a hash already
+               size_t s;
+               std::memcpy( &s, id.data(), sizeof(s) );
+               return s;
+            }
+         };
+         struct validated {};
+
+         mutable lru_cache<transaction_id_type, validated, id_hash> _ids;
+   };
+
+} } // graphene::chain
+
+FC_REFLECT( graphene::chain::confidential_proof_cache_stats, (hits)(misses)(size)(capacity) )
@@ -23,6 +23,7 @@
 #include <graphene/protocol/account.hpp>
 
 #include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/hashed_index.hpp>
 
 namespace graphene { namespace chain {
         class database;
@@ -65,17 +66,15 @@ namespace graphene { namespace chain {
                                  member< object, object_id_type, &object::id>
                            >
                      >,
-                     ordered_unique< tag<by_subject_account_and_hash>,
+                     // only exact lookups are done by subject account and hash, which a hash table serves in O(1)
+                     hashed_unique< tag<by_subject_account_and_hash>,
                            composite_key< content_card_object,
                                  member< content_card_object, account_id_type, &content_card_object::subject_account>,
                                  member< content_card_object, string, &content_card_object::hash>
                            >
                      >,
-                     ordered_unique< tag<by_hash>,
-                           composite_key< content_card_object,
-                                 member< content_card_object, string, &content_card_object::hash>,
-                                 member< object, object_id_type, &object::id>
-                           >
+                     hashed_non_unique< tag<by_hash>,
+                           member< content_card_object, string, &content_card_object::hash>
                      >
                >
         > content_card_multi_index_type;
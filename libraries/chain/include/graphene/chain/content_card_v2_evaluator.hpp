@@ -38,6 +38,8 @@ public:
 
    void_result do_evaluate( const content_card_v2_update_operation& o );
    object_id_type do_apply( const content_card_v2_update_operation& o );
+
+   const content_card_v2_object* content_card = nullptr;
 };
 
 class content_card_v2_remove_evaluator : public evaluator<content_card_v2_remove_evaluator>
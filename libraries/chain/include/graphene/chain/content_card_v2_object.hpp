@@ -20,9 +20,12 @@
 
 #include <graphene/chain/types.hpp>
 #include <graphene/db/generic_index.hpp>
+#include <graphene/db/interned_string.hpp>
+#include <graphene/db/node_allocator.hpp>
 #include <graphene/protocol/account.hpp>
 
 #include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/hashed_index.hpp>
 
 namespace graphene { namespace chain {
         class database;
@@ -45,7 +48,8 @@ namespace graphene { namespace chain {
             string   hash;
             string   url;
             uint64_t timestamp;
-            string   type;
+            /// Few distinct values shared by many cards, stored once per value
+            graphene::db::interned_string type;
             string   description;
             string   content_key;
             uint64_t vote_counter;
@@ -66,19 +70,18 @@ namespace graphene { namespace chain {
                                  member< object, object_id_type, &object::id>
                            >
                      >,
-                     ordered_unique< tag<by_subject_account_and_hash>,
+                     // only exact lookups are done by subject account and hash, which a hash table serves in O(1)
+                     hashed_unique< tag<by_subject_account_and_hash>,
                            composite_key< content_card_v2_object,
                                  member< content_card_v2_object, account_id_type, &content_card_v2_object::subject_account>,
                                  member< content_card_v2_object, string, &content_card_v2_object::hash>
                            >
                      >,
-                     ordered_unique< tag<by_hash>,
-                           composite_key< content_card_v2_object,
-                                 member< content_card_v2_object, string, &content_card_v2_object::hash>,
-                                 member< object, object_id_type, &object::id>
-                           >
+                     hashed_non_unique< tag<by_hash>,
+                           member< content_card_v2_object, string, &content_card_v2_object::hash>
                      >
-               >
+               >,
+               graphene::db::node_allocator< content_card_v2_object >
         > content_card_v2_multi_index_type;
 
         typedef generic_index<content_card_v2_object, content_card_v2_multi_index_type> content_card_v2_index;
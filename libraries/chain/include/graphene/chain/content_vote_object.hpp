@@ -24,10 +24,66 @@
 
 #include <boost/multi_index/composite_key.hpp>
 
+#include <memory>
+
 namespace graphene { namespace chain {
         class database;
         class content_vote_object;
 
+        /**
+         * @brief The id of a voted content, stored as a 64-bit key when it is an object id
+         *
+         * Content ids are free-form strings, but in practice they are object ids such as "1.20.5". Those are
+         * kept as the packed object id, so that index keys need no heap memory and compare as integers. Other
+         * values fall back to a string. Object ids which do not print back to the same text, e.g. "1.20.05",
+         * also keep their text, so that two keys are equal exactly when their strings are equal.
+         *
+         * Packed ids order before strings. Serialized as the original string.
+         */
+        class compact_content_id
+        {
+        public:
+            compact_content_id() = default;
+            compact_content_id( const string& s );
+            compact_content_id( const char* s ) : compact_content_id( string( s ) ) {}
+            compact_content_id( const compact_content_id& other )
+            : _number( other._number ), _text( other._text ? new string( *other._text ) : nullptr ) {}
+            compact_content_id( compact_content_id&& other ) = default;
+
+            compact_content_id& operator=( const compact_content_id& other )
+            {
+               if( this != &other )
+                  *this = compact_content_id( other );
+               return *this;
+            }
+            compact_content_id& operator=( compact_content_id&& other ) = default;
+
+            string str()const;
+            operator string()const { return str(); }
+
+            bool empty()const { return _text && _text->empty(); }
+            /// true if the value is stored as a packed object id
+            bool is_object_id()const { return !_text; }
+
+            friend bool operator==( const compact_content_id& a, const compact_content_id& b )
+            {
+               if( !a._text || !b._text )
+                  return !a._text && !b._text && a._number == b._number;
+               return *a._text == *b._text;
+            }
+            friend bool operator!=( const compact_content_id& a, const compact_content_id& b ) { return !( a == b ); }
+            friend bool operator<( const compact_content_id& a, const compact_content_id& b )
+            {
+               if( !a._text )
+                  return b._text || a._number < b._number;
+               return b._text && *a._text < *b._text;
+            }
+
+        private:
+            uint64_t                      _number = 0;
+            std::unique_ptr<const string> _text { new string() };
+        };
+
         /**
          * @brief This class represents an votes on the object graph
          * @ingroup object
@@ -42,7 +98,7 @@ namespace graphene { namespace chain {
             static constexpr uint8_t type_id  = content_vote_object_type;
 
             account_id_type subject_account;
-            string content_id;
+            compact_content_id content_id;
         };
 
         struct by_subject_account;
@@ -55,12 +111,12 @@ namespace graphene { namespace chain {
                      ordered_unique< tag<by_subject_account>,
                            composite_key< content_vote_object,
                                  member< content_vote_object, account_id_type, &content_vote_object::subject_account>,
-                                 member< content_vote_object, string, &content_vote_object::content_id>
+                                 member< content_vote_object, compact_content_id, &content_vote_object::content_id>
                            >
                      >,
                      ordered_unique< tag<by_content_id>,
                            composite_key< content_vote_object,
-                                 member< content_vote_object, string, &content_vote_object::content_id>,
+                                 member< content_vote_object, compact_content_id, &content_vote_object::content_id>,
                                  member< object, object_id_type, &object::id >
                            >
                      >
@@ -71,6 +127,34 @@ namespace graphene { namespace chain {
 
     }}
 
+namespace fc {
+   inline void to_variant( const graphene::chain::compact_content_id& id, variant& v, uint32_t max_depth = 1 )
+   {
+      v = id.str();
+   }
+   inline void from_variant( const variant& v, graphene::chain::compact_content_id& id, uint32_t max_depth = 1 )
+   {
+      id = v.as_string();
+   }
+
+   namespace raw {
+      template<typename Stream>
+      inline void pack( Stream& s, const graphene::chain::compact_content_id& id, uint32_t _max_depth = FC_PACK_MAX_DEPTH )
+      {
+         fc::raw::pack( s, id.str(), _max_depth );
+      }
+      template<typename Stream>
+      inline void unpack( Stream& s, graphene::chain::compact_content_id& id, uint32_t _max_depth = FC_PACK_MAX_DEPTH )
+      {
+         std::string tmp;
+         fc::raw::unpack( s, tmp, _max_depth );
+         id = tmp;
+      }
+   }
+
+   template<> struct get_typename<graphene::chain::compact_content_id> { static const char* name() { return "string"; } };
+} // fc
+
 MAP_OBJECT_ID_TO_TYPE(graphene::chain::content_vote_object)
 FC_REFLECT_TYPENAME( graphene::chain::content_vote_object )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::chain::content_vote_object )
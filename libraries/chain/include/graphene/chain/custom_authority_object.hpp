@@ -39,7 +39,8 @@ namespace graphene { namespace chain {
    class custom_authority_object : public abstract_object<custom_authority_object> {
       /// Unreflected field to store a cache of the predicate function
       /// Note that this cache can be modified when the object is const!
-      mutable optional<restriction_predicate_function> predicate_cache;
+      /// It is shared, so that copies of the object, e.g. for undo, do not copy the whole predicate
+      mutable std::shared_ptr<const restriction_predicate_function> predicate_cache;
 
    public:
       static constexpr uint8_t space_id = protocol_ids;
@@ -65,18 +66,22 @@ namespace graphene { namespace chain {
          return rs;
       }
       /// Get predicate, from cache if possible, and update cache if not (modifies const object!)
-      restriction_predicate_function get_predicate() const {
-         if (!predicate_cache.valid())
+      const restriction_predicate_function& get_predicate() const {
+         if (!predicate_cache)
             update_predicate_cache();
 
          return *predicate_cache;
       }
       /// Regenerate predicate function and update predicate cache
       void update_predicate_cache() const {
-         predicate_cache = get_restriction_predicate(get_restrictions(), operation_type);
+         predicate_cache = std::make_shared<const restriction_predicate_function>(
+                              get_restriction_predicate(get_restrictions(), operation_type));
       }
       /// Clear the cache of the predicate function
       void clear_predicate_cache() { predicate_cache.reset(); }
+
+      /// The predicate cache is not serialized, keep it in undo states
+      bool packs_whole_state()const override { return false; }
    };
 
    struct by_account_custom;
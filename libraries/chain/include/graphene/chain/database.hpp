@@ -32,8 +32,16 @@
 #include <graphene/chain/asset_object.hpp>
 #include <graphene/chain/commit_reveal_object.hpp>
 #include <graphene/chain/commit_reveal_v2_object.hpp>
+#include <graphene/chain/apply_timing.hpp>
+#include <graphene/chain/async_block_handler.hpp>
 #include <graphene/chain/fork_database.hpp>
 #include <graphene/chain/block_database.hpp>
+#include <graphene/chain/signature_cache.hpp>
+#include <graphene/chain/confidential_proof_cache.hpp>
+#include <graphene/chain/applied_ops_log.hpp>
+#include <graphene/chain/state_delta_log.hpp>
+#include <graphene/chain/transaction_pool.hpp>
+#include <graphene/chain/vote_tally.hpp>
 #include <graphene/chain/genesis_state.hpp>
 #include <graphene/chain/evaluator.hpp>
 
@@ -45,13 +53,13 @@
 #include <fc/log/logger.hpp>
 
 #include <map>
+#include <mutex>
 
 namespace graphene { namespace protocol { struct predicate_result; } }
 
 namespace graphene { namespace chain {
    using graphene::db::abstract_object;
    using graphene::db::object;
-   class op_evaluator;
    class transaction_evaluation_state;
    class proposal_object;
    class operation_history_object;
@@ -65,6 +73,43 @@ namespace graphene { namespace chain {
    struct budget_record;
    enum class vesting_balance_type;
 
+   /// The state of the chain objects after a block was applied, see database::set_state_hash_blocks()
+   struct block_state_hash
+   {
+      uint32_t                                 block_num = 0;
+      block_id_type                            block_id;
+      fc::sha256                               state_hash; ///< the hash of the index hashes
+      vector<graphene::db::index_state_hash>   indexes;    ///< to find the objects which differ
+   };
+
+   /**
+    *  @class impacted_accounts_provider
+    *  @brief The accounts impacted by the objects of a change notification, computed when first asked for
+    *
+    *  Subscribers which only need the object IDs never pay for walking the objects.
+    */
+   class impacted_accounts_provider
+   {
+      public:
+         explicit impacted_accounts_provider( std::function<void(flat_set<account_id_type>&)> compute )
+         : _compute( std::move( compute ) ) {}
+
+         const flat_set<account_id_type>& get()const
+         {
+            if( !_computed )
+            {
+               _compute( _accounts );
+               _computed = true;
+            }
+            return _accounts;
+         }
+
+      private:
+         std::function<void(flat_set<account_id_type>&)> _compute;
+         mutable flat_set<account_id_type>               _accounts;
+         mutable bool                                    _computed = false;
+   };
+
    /**
     *   @class database
     *   @brief tracks the blockchain state in an extensible manner
@@ -118,6 +163,15 @@ namespace graphene { namespace chain {
           */
          void reindex(fc::path data_dir);
 
+         /**
+          * @brief Check whether the object database in @p data_dir was saved by an interrupted replay
+          * @param data_dir the data directory of the chain database
+          * @param skip the skip flags of the new replay, which must match those of the interrupted replay
+          *
+          * If so, a new replay can continue from that checkpoint instead of wiping the object database.
+          */
+         static bool has_replay_checkpoint( const fc::path& data_dir, uint32_t skip );
+
          /**
           * @brief wipe Delete database from disk, and potentially the raw chain as well.
           * @param data_dir the path to store the database
@@ -127,6 +181,10 @@ namespace graphene { namespace chain {
           */
          void wipe(const fc::path& data_dir, bool include_blocks);
          void close(bool rewind = true);
+      private:
+         /// Copies the replay checkpoint just written to the archive, or compares the state with the archived one
+         void archive_replay_checkpoint( const fc::path& data_dir );
+      public:
 
          //////////////////// db_block.cpp ////////////////////
 
@@ -137,8 +195,14 @@ namespace graphene { namespace chain {
          bool                       is_known_block( const block_id_type& id )const;
          bool                       is_known_transaction( const transaction_id_type& id )const;
          block_id_type              get_block_id_for_num( uint32_t block_num )const;
+         /// Same as get_block_id_for_num() for several blocks, but looks them up together
+         vector<block_id_type>      get_block_ids_for_nums( const vector<uint32_t>& block_nums )const;
          optional<signed_block>     fetch_block_by_id( const block_id_type& id )const;
          optional<signed_block>     fetch_block_by_number( uint32_t num )const;
+         /// Reads the serialized block @p num, without decoding stored blocks, @return false if it is not known
+         bool                       fetch_packed_block_by_number( uint32_t num, vector<char>& data )const;
+         /// Reads the serialized block @p id, without decoding stored blocks, @return false if it is not known
+         bool                       fetch_packed_block_by_id( const block_id_type& id, vector<char>& data )const;
          const signed_transaction&  get_recent_transaction( const transaction_id_type& trx_id )const;
          std::vector<block_id_type> get_block_ids_on_fork(block_id_type head_of_fork) const;
 
@@ -151,11 +215,27 @@ namespace graphene { namespace chain {
          void                              add_checkpoints( const flat_map<uint32_t,block_id_type>& checkpts );
          const flat_map<uint32_t,block_id_type> get_checkpoints()const { return _checkpoints; }
          bool before_last_checkpoint()const;
+         /**
+          * @return the skip flags to apply block @p block_num with: up to the last checkpoint all checks but the
+          * merkle check are skipped, since the checkpointed block IDs only cover the block headers
+          */
+         uint32_t checkpoint_skip_flags( uint32_t block_num, uint32_t skip )const;
 
          bool push_block( const signed_block& b, uint32_t skip = skip_nothing );
          processed_transaction push_transaction( const precomputable_transaction& trx, uint32_t skip = skip_nothing );
          bool _push_block( const signed_block& b );
          processed_transaction _push_transaction( const precomputable_transaction& trx );
+         /// Keep a pending transaction in the transaction pool without applying it to the pending state
+         void _defer_transaction( pooled_transaction entry );
+
+         void set_transaction_pool_limits( const transaction_pool_limits& limits ) { _pending_tx.set_limits( limits ); }
+         /**
+          * @brief Check whether a transaction received from the network is admitted under the current load
+          * @throws fc::exception if the transaction pool is under pressure and the transaction pays too little or
+          * is expected to be too expensive to apply, see transaction_pool::check_network_admission()
+          */
+         void check_network_transaction_admission( const precomputable_transaction& trx )const;
+         const transaction_pool& get_transaction_pool()const { return _pending_tx; }
 
          ///@throws fc::exception if the proposed transaction fails to apply.
          processed_transaction push_proposal( const proposal_object& proposal );
@@ -172,6 +252,42 @@ namespace graphene { namespace chain {
             const fc::ecc::private_key& block_signing_private_key
             );
 
+         /// Time spent in the steps of generating a block
+         struct block_generation_timings
+         {
+            fc::microseconds packing;  ///< applying pending transactions
+            fc::microseconds signing;
+            fc::microseconds pushing;  ///< push_block() of the new block
+            uint32_t         postponed_transactions = 0;
+            uint32_t         deferred_by_budget = 0; ///< postponed because of the packing time or cost budget
+            bool             from_pending_state = false; ///< packed from the pending state without applying again
+         };
+         /// @return the timings of the most recent successful generate_block() call
+         const block_generation_timings& get_last_block_generation_timings()const { return _last_generation_timings; }
+
+         /**
+          * @brief Limit the time spent on applying pending transactions when generating a block
+          * @param packing_budget stop packing once this much time is spent, 0 for no limit
+          * @param transaction_budget defer transactions whose estimated cost exceeds this, 0 for no limit
+          *
+          * Costs are estimated from the recently measured times needed to apply operations of the same type.
+          * Deferred transactions stay in the pool and are considered again for the next block. One transaction
+          * exceeding the budgets is packed per block while the packing time is not used up, so that transactions
+          * of an expensive type are delayed but never excluded.
+          */
+         void set_block_packing_budget( fc::microseconds packing_budget, fc::microseconds transaction_budget );
+         /**
+          * @brief Pack generated blocks from the pending state when possible
+          *
+          * The pending state is kept as the candidate of the next block while transactions arrive. If all of its
+          * transactions were applied with the checks of the block generation and none of them expires before the
+          * block time, generate_block() packs them without applying them again. Otherwise, or if pushing the
+          * packed block fails, the pending transactions are applied again as usual.
+          */
+         void set_speculative_block_assembly( bool enable );
+         /// @return the recent average time in microseconds needed to apply each operation type, by tag
+         const vector<uint64_t>& get_recent_operation_costs()const { return _recent_operation_cost_us; }
+
          void pop_block();
          void clear_pending();
 
@@ -187,6 +303,9 @@ namespace graphene { namespace chain {
          uint32_t  push_applied_operation( const operation& op );
          void      set_applied_operation_result( uint32_t op_id, const operation_result& r );
          const vector<optional< operation_history_object > >& get_applied_operations()const;
+         /// @return the applied operations of the block, only while the applied_block observers are called,
+         ///         for consumers which keep them beyond that, e.g. in another thread
+         const shared_applied_operations& get_shared_applied_operations()const { return _shared_applied_ops; }
 
          string to_pretty_string( const asset& a )const;
 
@@ -208,20 +327,23 @@ namespace graphene { namespace chain {
 
          /**
           *  Emitted After a block has been applied and committed.  The callback
-          *  should not yield and should execute quickly.
+          *  should not yield and should execute quickly.  The impacted accounts are only
+          *  valid during the callback.
           */
-         fc::signal<void(const vector<object_id_type>&, const flat_set<account_id_type>&)> new_objects;
+         fc::signal<void(const vector<object_id_type>&, const impacted_accounts_provider&)> new_objects;
 
          /**
           *  Emitted After a block has been applied and committed.  The callback
-          *  should not yield and should execute quickly.
+          *  should not yield and should execute quickly.  The impacted accounts are only
+          *  valid during the callback.
           */
-         fc::signal<void(const vector<object_id_type>&, const flat_set<account_id_type>&)> changed_objects;
+         fc::signal<void(const vector<object_id_type>&, const impacted_accounts_provider&)> changed_objects;
 
          /** this signal is emitted any time an object is removed and contains a
           * pointer to the last value of every object that was removed.
           */
-         fc::signal<void(const vector<object_id_type>&, const vector<const object*>&, const flat_set<account_id_type>&)>  removed_objects;
+         fc::signal<void(const vector<object_id_type>&, const vector<const object*>&,
+                         const impacted_accounts_provider&)>  removed_objects;
 
          //////////////////// db_witness_schedule.cpp ////////////////////
 
@@ -264,27 +386,38 @@ namespace graphene { namespace chain {
          void update_witness_schedule();
 
          //////////////////// db_commit_reveal.cpp ////////////////////
+      public:
+         /// Outcome of the commit-reveal scheme among a set of accounts
+         struct commit_reveal_round
+         {
+            uint64_t                seed = 0;     ///< sum of the revealed values
+            vector<account_id_type> participants; ///< accounts with a non-zero reveal, in the order of the input
+         };
       private:
-         uint64_t get_commit_reveal_seed(const vector<account_id_type>& accounts) const;
-         vector<account_id_type> filter_commit_reveal_participant(const vector<account_id_type>& accounts) const;
-         uint64_t get_commit_reveal_seed_v2(const vector<account_id_type>& accounts) const;
-         vector<account_id_type> filter_commit_reveal_participant_v2(const vector<account_id_type>& accounts) const;
+         /**
+          * @brief Collects the seed and the participants of the current commit-reveal round in one pass
+          *
+          * Uses the v2 objects after HARDFORK_REVPOP_11 and the v1 objects before it.
+          */
+         commit_reveal_round get_commit_reveal_round(const vector<account_id_type>& accounts) const;
          //////////////////// db_getter.cpp ////////////////////
       public:
 
          const chain_id_type&                   get_chain_id()const;
-         const asset_object&                    get_core_asset()const;
-         const asset_dynamic_data_object&       get_core_dynamic_data()const;
-         const chain_property_object&           get_chain_properties()const;
-         const global_property_object&          get_global_properties()const;
-         const dynamic_global_property_object&  get_dynamic_global_properties()const;
+         /// The singletons are cached on startup, and undo modifies them in place, so the pointers stay valid
+         const asset_object&                    get_core_asset()const { return *_p_core_asset_obj; }
+         const asset_dynamic_data_object&       get_core_dynamic_data()const { return *_p_core_dynamic_data_obj; }
+         const chain_property_object&           get_chain_properties()const { return *_p_chain_property_obj; }
+         const global_property_object&          get_global_properties()const { return *_p_global_prop_obj; }
+         const dynamic_global_property_object&  get_dynamic_global_properties()const
+         { return *_p_dyn_global_prop_obj; }
          const node_property_object&            get_node_properties()const;
          const fee_schedule&                    current_fee_schedule()const;
          const account_statistics_object&       get_account_stats_by_owner( account_id_type owner )const;
          const witness_schedule_object&         get_witness_schedule_object()const;
 
-         time_point_sec   head_block_time()const;
-         uint32_t         head_block_num()const;
+         time_point_sec   head_block_time()const { return get_dynamic_global_properties().time; }
+         uint32_t         head_block_num()const { return get_dynamic_global_properties().head_block_number; }
          block_id_type    head_block_id()const;
          witness_id_type  head_block_witness()const;
 
@@ -316,7 +449,7 @@ namespace graphene { namespace chain {
          void register_evaluator()
          {
             _operation_evaluators[operation::tag<typename EvaluatorType::operation_type>::value]
-                  = std::make_unique<op_evaluator_impl<EvaluatorType>>();
+                  = &evaluate_operation<EvaluatorType>;
          }
 
          //////////////////// db_balance.cpp ////////////////////
@@ -525,9 +658,117 @@ namespace graphene { namespace chain {
           * @}
           */
 
+         /// Enable or disable timing of operations, transactions and applied_block handlers
+         inline void enable_apply_timing(bool enable)  { _apply_timing_enabled = enable; }
+         inline bool apply_timing_enabled()const       { return _apply_timing_enabled; }
+         /// Thread-safe, the durations are read while blocks are applied
+         apply_timing_report get_apply_timing()const;
+         void reset_apply_timing();
+
+         /**
+          * Connects @p handler to applied_block, timing it under @p name when apply timing is enabled.
+          * Plugins should use this instead of connecting to applied_block directly.
+          */
+         template<typename Handler>
+         auto connect_applied_block( const string& name, Handler handler )
+         {
+            apply_timer& timer = add_handler_timer( name );
+            return applied_block.connect( [this,&timer,handler]( const signed_block& b ) {
+               scoped_apply_timer t( _apply_timing_enabled ? &timer : nullptr );
+               handler( b );
+            });
+         }
+
+         /**
+          * Hands every applied block with its operations to @p handler, which runs in order on a thread of its
+          * own and must not read the database. At most @p capacity blocks are queued, then block application
+          * waits for the handler.
+          * @return the handler, which stays connected as long as the caller keeps it
+          */
+         std::shared_ptr<async_block_handler> connect_applied_block_async( const string& name, uint32_t capacity,
+                                                                           async_block_handler::handler_type handler );
+         /// Queue lengths and lags of the connected asynchronous handlers
+         vector<async_block_handler_stats> get_async_block_handler_stats()const;
+
          /// Enable or disable tracking of votes of standby witnesses and committee members
          inline void enable_standby_votes_tracking(bool enable)  { _track_standby_votes = enable; }
 
+         /// Tally only the votes of accounts which changed since the last maintenance,
+         /// @p verify to tally all accounts anyway and report differences
+         inline void enable_incremental_vote_tally(bool enable, bool verify = false)
+         { _vote_tally_cache.enable( enable, verify ); }
+         vote_tally_stats get_vote_tally_stats()const { return _vote_tally_cache.get_stats(); }
+
+         /// Tally the votes of accounts on the thread pool during chain maintenance, the result is the same
+         /// as of the serial tally. Not used together with the incremental tally.
+         inline void enable_parallel_maintenance(bool enable)  { _parallel_maintenance = enable; }
+
+         /// Save the object database every @p interval blocks while reindexing to make the replay resumable,
+         /// 0 to save it only at the undo point
+         inline void set_replay_checkpoint_interval(uint32_t interval)  { _replay_checkpoint_interval = interval; }
+
+         /// Stop reindexing after block @p block_num and keep a replay checkpoint there, 0 to replay all blocks
+         inline void set_replay_end_block(uint32_t block_num)  { _replay_end_block = block_num; }
+
+         /**
+          * Keep a copy of every replay checkpoint in a subdirectory of @p dir named by its block number, together
+          * with the state hashes of the chain indexes. If the archive already has a checkpoint of the block, the
+          * state is compared with it instead, and the replay fails if they differ.
+          *
+          * This allows to revalidate ranges of the chain independently: a fast replay archives checkpoints at
+          * the range boundaries, then each range is revalidated from the archived checkpoint of its start up to
+          * the end block of the range, where the result is checked against the next archived checkpoint.
+          */
+         void set_replay_checkpoint_archive( const fc::path& dir );
+
+         /// Set the maximum number of blocks being read, deserialized and precomputed ahead while reindexing
+         inline void set_reindex_pipeline_depth(uint32_t depth)  { _reindex_pipeline_depth = depth > 0 ? depth : 1; }
+
+         /// Compress a newly created block log in frames of @p frame_size blocks, 0 to store blocks uncompressed,
+         /// must be called before open()
+         inline void set_block_log_compression(uint32_t frame_size)  { _block_id_to_block.set_compression( frame_size ); }
+
+         /// Keep only the last @p count blocks in the block log, and at least all blocks since the last
+         /// irreversible block, 0 to keep all blocks
+         inline void set_block_log_retain_blocks(uint32_t count)  { _block_log_retain_blocks = count; }
+         /// @return the number of the first block which can still be fetched, 1 unless the block log is pruned
+         uint32_t first_stored_block_num()const { return _block_id_to_block.first_block_num(); }
+
+         /// Keep up to @p blocks recently fetched blocks from the block log decoded in memory, 0 to disable
+         inline void set_block_cache_size(size_t blocks)  { _block_id_to_block.set_cache_size( blocks ); }
+         block_cache_stats get_block_cache_stats()const { return _block_id_to_block.get_cache_stats(); }
+
+         /// Keep up to @p keys public keys recovered from transaction signatures, so that transactions
+         /// received again inside a block are not recovered twice, 0 to disable
+         inline void set_signature_cache_size(size_t keys)  { _signature_cache.set_capacity( keys ); }
+         signature_cache_stats get_signature_cache_stats()const { return _signature_cache.get_stats(); }
+
+         /// Keep the IDs of up to @p transactions validated transactions with confidential operations, so that
+         /// their range proofs are not verified again when they arrive in a block, 0 to disable
+         inline void set_confidential_proof_cache_size(size_t transactions)
+         { _confidential_proof_cache.set_capacity( transactions ); }
+         confidential_proof_cache_stats get_confidential_proof_cache_stats()const
+         { return _confidential_proof_cache.get_stats(); }
+
+         /// Write the operations applied with the irreversible blocks to a log, from which plugins can be rebuilt,
+         /// must be called before open(). The log only grows from its last block on, enabling it on an existing
+         /// chain needs a replay to fill it from the first block.
+         inline void enable_applied_ops_log(bool enable)  { _applied_ops_log_enabled = enable; }
+         const applied_ops_log& get_applied_ops_log()const { return _applied_ops_log; }
+
+         /// Write the state deltas of the irreversible blocks to a log, from which read replicas follow this node,
+         /// must be called before open(). The log starts with the first block applied after it was enabled.
+         inline void enable_state_delta_log(bool enable)  { _state_delta_log_enabled = enable; }
+         const state_delta_log& get_state_delta_log()const { return _state_delta_log; }
+
+         /// Keep the state hash of the chain objects after each of the last @p blocks applied blocks, 0 to disable.
+         /// Enabling it hashes the existing chain objects once, later the hashes are updated with every change.
+         /// The objects of the plugins are not included, but plugins like account history also update chain
+         /// objects, so hashes are only comparable between nodes running such plugins alike.
+         void set_state_hash_blocks( uint32_t blocks );
+         /// @return the state hash after the block with @p block_num was applied, if it is among the recent blocks
+         optional<block_state_hash> get_block_state_hash( uint32_t block_num )const;
+
          /** Precomputes digests, signatures and operation validations depending
           *  on skip flags. "Expensive" computations may be done in a parallel
           *  thread.
@@ -550,6 +791,9 @@ namespace graphene { namespace chain {
    private:
          template<typename Trx>
          void _precompute_parallel( const Trx* trx, const size_t count, const uint32_t skip )const;
+         /// Precomputes the transactions of a block with signature recovery balanced over all signatures
+         /// @return false if any transaction failed
+         bool _precompute_signatures_parallel( const signed_block& block, const uint32_t skip )const;
 
    protected:
          //Mark pop_undo() as protected -- we do not want outside calling pop_undo(); it should call pop_block() instead
@@ -560,7 +804,10 @@ namespace graphene { namespace chain {
 
       private:
          optional<undo_database::session>       _pending_tx_session;
-         vector< unique_ptr<op_evaluator> >     _operation_evaluators;
+         /// Evaluation functions indexed by operation tag, null for operations without an evaluator
+         typedef operation_result (*op_evaluator_function)( transaction_evaluation_state& eval_state,
+                                                            const operation& op, bool apply );
+         vector< op_evaluator_function >        _operation_evaluators;
 
          template<class Index>
          vector<std::reference_wrapper<const typename Index::object_type>> sort_votable_objects(size_t count)const;
@@ -572,19 +819,43 @@ namespace graphene { namespace chain {
          void                  apply_block( const signed_block& next_block, uint32_t skip = skip_nothing );
          processed_transaction apply_transaction( const signed_transaction& trx, uint32_t skip = skip_nothing );
          operation_result      apply_operation( transaction_evaluation_state& eval_state, const operation& op );
+         /**
+          * Moves a read replica to the state after the block of @p delta, which must follow the head block, by
+          * writing the objects of the delta without evaluating the block. The block is stored and the observers
+          * are notified like for an applied block, but no operations are reported to them.
+          */
+         void                  apply_state_delta( const state_delta& delta );
 
       private:
          void                  _apply_block( const signed_block& next_block );
+         /// @return the changes of the chain objects made by @p block, from the undo state of the block
+         state_delta           make_state_delta( const signed_block& block )const;
          processed_transaction _apply_transaction( const signed_transaction& trx );
+         /// Writes the vote counts collected by content_vote_create_evaluator to the vote master summaries,
+         /// called before any other operation so that it always observes the same state as without batching
+         void                  apply_pending_master_votes( transaction_evaluation_state& eval_state );
          void                  _cancel_bids_and_revive_mpa( const asset_object& bitasset, const asset_bitasset_data_object& bad );
 
          ///Steps involved in applying a new block
          ///@{
 
+         /**
+          * Verifies the authorities of the transactions in the block in parallel, against the state before the
+          * block is applied. Nothing is done if a transaction in the block may change the result for others.
+          * @return a flag per transaction that is set if the authorities are satisfied, or an empty vector
+          */
+         vector<char> verify_authorities_parallel( const signed_block& block )const;
+
          const witness_object& validate_block_header( uint32_t skip, const signed_block& next_block )const;
          const witness_object& _validate_block_header( const signed_block& next_block )const;
          void verify_signing_witness( const signed_block& new_block, const fork_item& fork_entry )const;
          void update_witnesses( fork_item& fork_entry )const;
+         /// Compute the data the transaction pool needs for admission and eviction of a transaction
+         pooled_transaction make_pooled_transaction( const precomputable_transaction& trx )const;
+         /// @return the estimated time needed to apply the transaction, based on recent operation costs
+         fc::microseconds estimate_transaction_cost( const transaction& trx )const;
+         /// Record the time spent on applying a transaction in the recent operation costs
+         void note_transaction_cost( const transaction& trx, fc::microseconds elapsed );
          void create_block_summary(const signed_block& next_block);
 
          //////////////////// db_witness_schedule.cpp ////////////////////
@@ -622,6 +893,17 @@ namespace graphene { namespace chain {
          void update_active_witnesses();
          void update_active_committee_members();
          void update_worker_votes();
+         /// @return the block packed from the pending state, or nothing if the pending state can not be used
+         optional<signed_block> _generate_block_from_pending_state( fc::time_point_sec when,
+                                                                    witness_id_type witness_id,
+                                                                    const fc::ecc::private_key& block_signing_private_key,
+                                                                    size_t max_block_header_size );
+         /// Fill in the header of a generated block, sign and push it
+         void _finish_generated_block( signed_block& pending_block, fc::time_point_sec when,
+                                       witness_id_type witness_id,
+                                       const fc::ecc::private_key& block_signing_private_key,
+                                       block_generation_timings& timings, fc::time_point packing_start );
+
          void process_bids( const asset_bitasset_data_object& bad );
          void process_bitassets();
 
@@ -630,7 +912,7 @@ namespace graphene { namespace chain {
          ///@}
          ///@}
 
-         vector< processed_transaction >        _pending_tx;
+         transaction_pool                       _pending_tx;
          fork_database                          _fork_db;
 
          /**
@@ -643,6 +925,12 @@ namespace graphene { namespace chain {
           *  the fork tree relatively simple.
           */
          block_database   _block_id_to_block;
+         signature_cache  _signature_cache;
+         confidential_proof_cache _confidential_proof_cache;
+         applied_ops_log  _applied_ops_log;
+         bool             _applied_ops_log_enabled = false;
+         state_delta_log  _state_delta_log;
+         bool             _state_delta_log_enabled = false;
 
          /**
           * Contains the set of ops that are in the process of being applied from
@@ -651,6 +939,8 @@ namespace graphene { namespace chain {
           * emited.
           */
          vector<optional<operation_history_object> >  _applied_ops;
+         /// the operations of the applied block, while the applied_block observers are called
+         shared_applied_operations                     _shared_applied_ops;
 
          uint32_t                          _current_block_num    = 0;
          uint16_t                          _current_trx_in_block = 0;
@@ -664,15 +954,70 @@ namespace graphene { namespace chain {
          vector<uint64_t>                  _committee_count_histogram_buffer;
          uint64_t                          _total_voting_stake[2]; // 0=committee, 1=witness,
                                                                    // as in vote_id_type::vote_type
+         vote_tally_cache                  _vote_tally_cache;
+
+         /// Market issued assets in which check_call_orders found nothing to call, and nothing changed since
+         flat_set<asset_id_type>           _markets_without_margin_calls;
 
          flat_map<uint32_t,block_id_type>  _checkpoints;
 
          node_property_object              _node_property_object;
 
+         apply_timer& add_handler_timer( const string& name );
+
+         bool                                          _apply_timing_enabled = false;
+         /// One per operation type, indexed by operation::which()
+         std::unique_ptr<apply_timer[]>                _operation_timers;
+         apply_timer                                   _transaction_timer;
+         /// Never shrinks, so that the timers stay at their address while the handlers are connected
+         std::deque<std::pair<string, apply_timer>>    _handler_timers;
+         mutable std::mutex                            _handler_timers_mutex;
+
+         vector<std::weak_ptr<async_block_handler>>    _async_block_handlers;
+         mutable std::mutex                            _async_block_handlers_mutex;
+
          /// Whether to update votes of standby witnesses and committee members when performing chain maintenance.
          /// Set it to true to provide accurate data to API clients, set to false to have better performance.
          bool                              _track_standby_votes = true;
 
+         /// Whether to tally votes on the thread pool during chain maintenance
+         bool                              _parallel_maintenance = false;
+
+         /// Maximum number of blocks in flight between the reader and the apply stage of reindex()
+         uint32_t                          _reindex_pipeline_depth = 20;
+
+         /// Number of blocks between replay checkpoints, 0 for none
+         uint32_t                          _replay_checkpoint_interval = 0;
+         uint32_t                          _replay_end_block = 0;
+         fc::path                          _replay_checkpoint_archive;
+
+         /// Number of blocks kept in the block log, 0 for all
+         uint32_t                          _block_log_retain_blocks = 0;
+
+         /// Number of recent blocks whose state hash is kept, 0 for none
+         uint32_t                                _state_hash_blocks = 0;
+         /// the space and type IDs of the indexes of the chain state, without those of the plugins
+         vector< std::pair<uint8_t,uint8_t> >   _chain_index_types;
+         std::map<uint32_t, block_state_hash>   _block_state_hashes;
+
+         block_generation_timings          _last_generation_timings;
+
+         /// Time budget of packing transactions into a generated block, 0 for no limit
+         fc::microseconds                  _block_packing_budget;
+         /// Maximum estimated cost of a transaction to be packed into a generated block, 0 for no limit
+         fc::microseconds                  _transaction_cost_budget;
+         /// Exponential moving average of the time needed to apply an operation, indexed by operation tag
+         vector<uint64_t>                  _recent_operation_cost_us;
+
+         /// Whether generate_block() may pack the pending state as it is
+         bool                              _speculative_block_assembly = false;
+         /// Whether the pending state consists of exactly the applied transactions of the pool, in their order
+         bool                              _pending_state_complete = true;
+         /// Union of the skip flags the pending transactions were applied with
+         uint32_t                          _pending_state_skip_flags = 0;
+         /// Packed size of the applied pending transactions
+         uint64_t                          _pending_state_size = 0;
+
          /**
           * Whether database is successfully opened or not.
           *
@@ -737,3 +1082,5 @@ namespace graphene { namespace chain {
    }
 
 } }
+
+FC_REFLECT( graphene::chain::block_state_hash, (block_num)(block_id)(state_hash)(indexes) )
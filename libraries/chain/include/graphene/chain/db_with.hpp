@@ -65,10 +65,13 @@ struct skip_flags_restorer
  *
  * TODO:  Change the name of this class to better reflect the fact
  * that it restores popped transactions as well as pending transactions.
+ *
+ * Expired and included transactions are dropped without applying them. If the transaction pool limits the
+ * number of reapplied transactions, the remaining ones are kept in the pool without being applied.
  */
 struct pending_transactions_restorer
 {
-   pending_transactions_restorer( database& db, std::vector<processed_transaction>&& pending_transactions )
+   pending_transactions_restorer( database& db, std::vector<pooled_transaction>&& pending_transactions )
       : _db(db), _pending_transactions( std::move(pending_transactions) )
    {
       _db.clear_pending();
@@ -86,12 +89,23 @@ struct pending_transactions_restorer
          }
       }
       _db._popped_tx.clear();
-      for( const processed_transaction& tx : _pending_transactions )
+      const fc::time_point_sec now = _db.head_block_time();
+      const uint32_t max_reapplied = _db.get_transaction_pool().get_limits().max_reapplied;
+      uint32_t reapplied = 0;
+      for( pooled_transaction& entry : _pending_transactions )
       {
+         if( entry.expiration < now )
+            continue;
          try
          {
-            if( !_db.is_known_transaction( tx.id() ) ) {
-               _db._push_transaction( tx );
+            if( _db.is_known_transaction( entry.id ) )
+               continue;
+            if( max_reapplied > 0 && reapplied >= max_reapplied )
+               _db._defer_transaction( std::move( entry ) );
+            else
+            {
+               ++reapplied;
+               _db._push_transaction( entry.trx );
             }
          }
          catch( const fc::exception& )
@@ -101,7 +115,7 @@ struct pending_transactions_restorer
    }
 
    database& _db;
-   std::vector< processed_transaction > _pending_transactions;
+   std::vector< pooled_transaction > _pending_transactions;
 };
 
 /**
@@ -131,7 +145,7 @@ void with_skip_flags(
 template< typename Lambda >
 void without_pending_transactions(
    database& db,
-   std::vector<processed_transaction>&& pending_transactions,
+   std::vector<pooled_transaction>&& pending_transactions,
    Lambda callback )
 {
     pending_transactions_restorer restorer( db, std::move(pending_transactions) );
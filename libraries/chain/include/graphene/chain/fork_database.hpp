@@ -37,22 +37,40 @@ namespace graphene { namespace chain {
    using boost::multi_index_container;
    using namespace boost::multi_index;
 
+   /**
+    * A block in the fork database. The block is kept in serialized form, which is shared with the block
+    * database. The decoded block is only kept while the item is the head of the fork database, otherwise
+    * it is decoded again on access.
+    */
    struct fork_item
    {
-      fork_item( signed_block d )
-      :num(d.block_num()),id(d.id()),data( std::move(d) ){}
+      explicit fork_item( signed_block d );
+
+      block_id_type previous_id()const { return previous; }
 
-      block_id_type previous_id()const { return data.previous; }
+      /// @return the decoded block
+      shared_ptr< const signed_block > block()const;
+      /// Drop the decoded block, so that only the serialized block is kept in memory
+      void release_decoded()const;
 
       weak_ptr< fork_item > prev;
       uint32_t              num;    // initialized in ctor
       block_id_type         id;
-      signed_block          data;
+      block_id_type         previous;
+      shared_ptr< const vector<char> > packed;
 
       // contains witness block signing keys scheduled *after* the block has been applied
       shared_ptr< vector< pair< witness_id_type, public_key_type > > > scheduled_witnesses;
       uint64_t                                                         next_block_aslot = 0;
       fc::time_point_sec                                               next_block_time;
+
+      /// Whether the block has been applied successfully, so that the checks which only depend on the block and
+      /// the state it is applied to can be skipped when it is applied again
+      bool                  applied = false;
+
+   private:
+      /// Accessed atomically, because blocks are fetched by API threads too
+      mutable shared_ptr< const signed_block > _decoded;
    };
    typedef shared_ptr<fork_item> item_ptr;
 
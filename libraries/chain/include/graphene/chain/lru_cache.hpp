@@ -0,0 +1,170 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @class lru_cache
+    * @brief A thread-safe map of limited size which drops the least recently used entries
+    *
+    * The lock is only held for looking up, adding and removing entries, values are copied out, so they should be
+    * cheap to copy, e.g. keys or shared pointers. Callers compute missing values without holding the lock, so
+    * other threads may compute the same value meanwhile.
+    */
+   template<typename Key, typename Value, typename Hash = std::hash<Key>>
+   class lru_cache
+   {
+      public:
+         /// Set the maximum number of entries, 0 to disable caching
+         void set_capacity( size_t capacity )
+         {
+            std::lock_guard<std::mutex> lock( _mutex );
+            _capacity = capacity;
+            shrink();
+         }
+         size_t capacity()const { return _capacity; }
+
+         /// Looks up @p key, a hit if it is cached and @p accept returns true for its value, which then is marked as
+         /// most recently used and copied to @p value, a miss otherwise. Nothing is counted if caching is disabled.
+         template<typename Accept>
+         bool find( const Key& key, Value& value, const Accept& accept )const
+         {
+            if( _capacity == 0 )
+               return false;
+            {
+               std::lock_guard<std::mutex> lock( _mutex );
+               auto itr = _by_key.find( key );
+               if( itr != _by_key.end() && accept( itr->second->second ) )
+               {
+                  _lru.splice( _lru.begin(), _lru, itr->second );
+                  value = itr->second->second;
+                  ++_hits;
+                  return true;
+               }
+            }
+            ++_misses;
+            return false;
+         }
+         bool find( const Key& key, Value& value )const
+         {
+            return find( key, value, []( const Value& ) { return true; } );
+         }
+
+         /// Adds @p value or replaces the cached one if @p condition returns true, it is called holding the lock
+         template<typename Condition>
+         void put( const Key& key, Value value, const Condition& condition )
+         {
+            if( _capacity == 0 )
+               return;
+            std::lock_guard<std::mutex> lock( _mutex );
+            if( !condition() )
+               return;
+            auto itr = _by_key.find( key );
+            if( itr != _by_key.end() )
+            {
+               itr->second->second = std::move( value );
+               _lru.splice( _lru.begin(), _lru, itr->second );
+               return;
+            }
+            _lru.emplace_front( key, std::move( value ) );
+            _by_key[ key ] = _lru.begin();
+            shrink();
+         }
+         void put( const Key& key, Value value )
+         {
+            put( key, std::move( value ), []() { return true; } );
+         }
+
+         void erase( const Key& key )
+         {
+            std::lock_guard<std::mutex> lock( _mutex );
+            auto itr = _by_key.find( key );
+            if( itr == _by_key.end() )
+               return;
+            _lru.erase( itr->second );
+            _by_key.erase( itr );
+         }
+
+         /// Removes the entries whose keys @p pred returns true for
+         template<typename Predicate>
+         void erase_if( const Predicate& pred )
+         {
+            std::lock_guard<std::mutex> lock( _mutex );
+            for( auto itr = _lru.begin(); itr != _lru.end(); )
+            {
+               if( pred( itr->first ) )
+               {
+                  _by_key.erase( itr->first );
+                  itr = _lru.erase( itr );
+               }
+               else
+                  ++itr;
+            }
+         }
+
+         void clear()
+         {
+            std::lock_guard<std::mutex> lock( _mutex );
+            _lru.clear();
+            _by_key.clear();
+         }
+
+         /// @return @p Stats with its hits, misses, size and capacity members set
+         template<typename Stats>
+         Stats get_stats()const
+         {
+            Stats result;
+            result.hits = _hits;
+            result.misses = _misses;
+            result.capacity = _capacity;
+            std::lock_guard<std::mutex> lock( _mutex );
+            result.size = _lru.size();
+            return result;
+         }
+
+      private:
+         typedef std::list< std::pair<Key, Value> > lru_list;
+
+         void shrink()
+         {
+            while( _lru.size() > _capacity )
+            {
+               _by_key.erase( _lru.back().first );
+               _lru.pop_back();
+            }
+         }
+
+         std::atomic<size_t>                                           _capacity{0};
+         mutable std::mutex                                            _mutex;
+         /// Most recently used first
+         mutable lru_list                                              _lru;
+         std::unordered_map<Key, typename lru_list::iterator, Hash>    _by_key;
+         mutable std::atomic<uint64_t>                                 _hits{0};
+         mutable std::atomic<uint64_t>                                 _misses{0};
+   };
+
+} } // graphene::chain
@@ -23,6 +23,7 @@
  */
 #pragma once
 
+#include <graphene/chain/asset_object.hpp>
 #include <graphene/chain/types.hpp>
 #include <graphene/db/generic_index.hpp>
 #include <graphene/protocol/asset.hpp>
@@ -232,6 +233,40 @@ typedef multi_index_container<
 typedef generic_index<call_order_object, call_order_multi_index_type>                      call_order_index;
 typedef generic_index<force_settlement_object, force_settlement_object_multi_index_type>   force_settlement_index;
 
+/**
+ * @brief Forgets that a market has nothing to margin call when its orders or its feed change
+ *
+ * Undo goes through the same notifications, so a market stays in the set only while nothing changed in it
+ * since database::check_call_orders found nothing to call there.
+ */
+template<typename ObjectType>
+class margin_call_observer : public secondary_index
+{
+   public:
+      explicit margin_call_observer( flat_set<asset_id_type>* uncallable_markets ) : _markets( uncallable_markets ) {}
+
+      virtual void object_inserted( const object& obj ) override { mark( obj ); }
+      virtual void object_removed( const object& obj ) override { mark( obj ); }
+      virtual void object_modified( const object& after ) override { mark( after ); }
+
+   private:
+      void changed( const limit_order_object& o )
+      {
+         _markets->erase( o.sell_asset_id() );
+         _markets->erase( o.receive_asset_id() );
+      }
+      void changed( const call_order_object& o ) { _markets->erase( o.debt_type() ); }
+      void changed( const asset_bitasset_data_object& o ) { _markets->erase( o.asset_id ); }
+
+      void mark( const object& obj )
+      {
+         if( !_markets->empty() )
+            changed( static_cast<const ObjectType&>( obj ) );
+      }
+
+      flat_set<asset_id_type>* _markets;
+};
+
 } } // graphene::chain
 
 MAP_OBJECT_ID_TO_TYPE(graphene::chain::limit_order_object)
@@ -25,9 +25,12 @@
 
 #include <graphene/protocol/operations.hpp>
 #include <graphene/db/object.hpp>
+#include <graphene/db/node_allocator.hpp>
 
 #include <boost/multi_index/composite_key.hpp>
 
+#include <memory>
+
 namespace graphene { namespace chain {
 
    /**
@@ -66,6 +69,10 @@ namespace graphene { namespace chain {
          uint32_t          virtual_op = 0;
    };
 
+   /// The operations applied with a block, they do not change any more and are shared read-only by the
+   /// consumers of the block instead of being copied by each of them
+   typedef std::shared_ptr< const vector< optional< operation_history_object > > > shared_applied_operations;
+
    /**
     *  @brief a node in a linked list of operation_history_objects
     *  @ingroup implementation
@@ -130,7 +137,8 @@ namespace graphene { namespace chain {
          ordered_non_unique< tag<by_opid>,
             member< account_transaction_history_object, operation_history_id_type, &account_transaction_history_object::operation_id>
          >
-      >
+      >,
+      graphene::db::node_allocator< account_transaction_history_object >
    > account_transaction_history_multi_index_type;
 
    typedef generic_index<account_transaction_history_object, account_transaction_history_multi_index_type> account_transaction_history_index;
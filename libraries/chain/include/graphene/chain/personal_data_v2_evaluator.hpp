@@ -38,6 +38,8 @@ public:
 
    void_result do_evaluate( const personal_data_v2_remove_operation& o );
    object_id_type do_apply( const personal_data_v2_remove_operation& o ) ;
+
+   const personal_data_v2_object* personal_data = nullptr;
 };
 
 } } // graphene::chain
@@ -0,0 +1,86 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <graphene/chain/lru_cache.hpp>
+#include <graphene/protocol/types.hpp>
+
+#include <cstring>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief Hit and miss counters of a signature_cache
+    */
+   struct signature_cache_stats
+   {
+      uint64_t hits     = 0; ///< number of signatures whose key was found in the cache
+      uint64_t misses   = 0; ///< number of signatures which had to be recovered
+      uint64_t size     = 0; ///< number of cached keys
+      uint64_t capacity = 0; ///< maximum number of cached keys, 0 if the cache is disabled
+   };
+
+   /**
+    * @class signature_cache
+    * @brief A thread-safe LRU cache of public keys recovered from signatures, keyed by signature and digest
+    *
+    * A transaction is usually received alone first and later again inside a block. Both copies are separate
+    * objects, so without this cache the (expensive) key recovery of every signature would run twice.
+    */
+   class signature_cache
+   {
+      public:
+         /// Set the maximum number of cached keys, 0 to disable caching
+         void set_capacity( size_t capacity ) { _keys.set_capacity( capacity ); }
+         size_t capacity()const { return _keys.capacity(); }
+
+         /// @return the key which created @p sig for @p digest, recovered only if it is not in the cache
+         public_key_type recover( const signature_type& sig, const digest_type& digest )const;
+
+         void clear() { _keys.clear(); }
+
+         signature_cache_stats get_stats()const { return _keys.get_stats<signature_cache_stats>(); }
+
+      private:
+         struct key_type
+         {
+            signature_type sig;
+            digest_type    digest;
+            bool operator==( const key_type& other )const
+            { return digest == other.digest && sig == other.sig; }
+         };
+         struct key_hash
+         {
+            size_t operator()( const key_type& k )const
+            {
+               // the digest is a hash already
+               size_t d;
+               size_t s;
+               std::memcpy( &d, k.digest.data(), sizeof(d) );
+               std::memcpy( &s, k.sig.data + 1, sizeof(s) ); // skip the recovery id
+               return d ^ s;
+            }
+         };
+
+         mutable lru_cache<key_type, public_key_type, key_hash> _keys;
+   };
+
+} } // graphene::chain
+
+FC_REFLECT( graphene::chain::signature_cache_stats, (hits)(misses)(size)(capacity) )
@@ -0,0 +1,114 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <graphene/chain/operation_history_object.hpp>
+#include <graphene/chain/types.hpp>
+#include <graphene/protocol/block.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <functional>
+#include <map>
+
+namespace graphene { namespace chain {
+
+   /// An object which was created or changed by a block, with its value after the block
+   struct state_delta_object
+   {
+      object_id_type  id;
+      vector<char>    data;
+   };
+
+   /**
+    * The changes of the chain objects made by a block, so that a node with the state before the block can reach the
+    * state after it without evaluating the block.
+    *
+    * The delta is made before the applied_block observers are notified, so changes which plugins make in them,
+    * e.g. the account statistics updated by account_history, are not included. The applied operations are, so
+    * that the plugins of replicas can make them.
+    */
+   struct state_delta
+   {
+      signed_block                block;
+      /// the objects changed by the block in the order they were first changed, followed by the objects created by
+      /// it in order of their IDs
+      vector<state_delta_object>  objects;
+      vector<object_id_type>      removed;
+      /// the next IDs of the indexes objects were created in
+      vector<object_id_type>      next_ids;
+      /// the operations applied with the block, for the applied_block observers of replicas
+      vector<optional<operation_history_object>> applied_ops;
+   };
+
+   /**
+    * @class state_delta_log
+    * @brief An append-only log of the state deltas of the irreversible blocks
+    *
+    * Read replicas apply the deltas instead of the blocks, see @ref database::apply_state_delta. Deltas are kept in
+    * memory until their block is irreversible, so that replicas never have to undo them. The log starts with the
+    * first block applied after it was enabled and has no gaps, a replica needs the state of the node at a block in
+    * the log to follow it. A block which does not follow the log, e.g. the first one after a replay, starts it
+    * over.
+    *
+    * Entries are stored like those of the @ref applied_ops_log, as the packed size followed by the packed delta.
+    */
+   class state_delta_log
+   {
+      public:
+         void open( const fc::path& file );
+         bool is_open()const { return _open; }
+         void close();
+
+         /// Keeps the delta of a block until it is irreversible, replacing those of the blocks with the same or
+         /// higher numbers, which were undone. A block which is in the log already, or would leave a gap in it,
+         /// empties the log and starts it over.
+         void add_block( state_delta&& delta );
+         /// Writes the deltas of the blocks up to @p last_irreversible
+         void write_irreversible( uint32_t last_irreversible );
+
+         /// @return the number of the first block in the log, 0 if the log is empty
+         uint32_t first_block_num()const { return _first_block_num; }
+         /// @return the number of the last block in the log, 0 if the log is empty
+         uint32_t last_block_num()const { return _last_block_num; }
+
+         /// Calls @p f with the packed deltas of up to @p limit blocks from @p block_num on, in block order
+         void read_packed( uint32_t block_num, uint32_t limit,
+                           const std::function<void(const vector<char>&)>& f )const;
+
+      private:
+         /// Drops all deltas, in memory and in the file
+         void restart();
+
+         /// an offset into the file is remembered for every this many blocks, entries in between are skipped
+         static constexpr uint32_t offset_interval = 256;
+
+         fc::path                          _file;
+         bool                              _open = false;
+         uint32_t                          _first_block_num = 0;
+         uint32_t                          _last_block_num = 0;
+         uint64_t                          _file_size = 0;
+         /// file offsets of the entries of the blocks _first_block_num + i * offset_interval
+         vector<uint64_t>                  _offsets;
+         std::map<uint32_t, state_delta>   _pending;
+   };
+
+} } // graphene::chain
+
+FC_REFLECT( graphene::chain::state_delta_object, (id)(data) )
+FC_REFLECT( graphene::chain::state_delta, (block)(objects)(removed)(next_ids)(applied_ops) )
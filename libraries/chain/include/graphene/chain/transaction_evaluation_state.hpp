@@ -49,5 +49,8 @@ namespace chain {
          bool                             _is_proposed_trx = false;
          bool                             skip_fee = false;
          bool                             skip_fee_schedule_check = false;
+
+         /// New content votes per vote master in order of the first vote, applied once after a run of votes
+         vector<std::pair<protocol::account_id_type, uint64_t>> pending_master_votes;
    };
 } } // namespace graphene::chain
@@ -0,0 +1,161 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <graphene/protocol/transaction.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+
+namespace graphene { namespace chain {
+   using namespace graphene::protocol;
+
+   /**
+    * @brief A transaction waiting in the transaction_pool
+    */
+   struct pooled_transaction
+   {
+      processed_transaction trx;
+      transaction_id_type   id;
+      /// Order of arrival, transactions are applied in this order
+      uint64_t              sequence = 0;
+      fc::time_point_sec    expiration;
+      /// Fee paying account of the first operation
+      account_id_type       account;
+      /// Fee in core asset per kilobyte of the serialized transaction
+      uint64_t              fee_per_kb = 0;
+      size_t                size = 0;
+      /// Whether the transaction is included in the pending state of the database
+      bool                  applied = false;
+   };
+
+   /**
+    * @brief Limits of a transaction_pool, 0 for no limit
+    */
+   struct transaction_pool_limits
+   {
+      uint32_t max_transactions             = 0;
+      uint64_t max_bytes                    = 0;
+      uint32_t max_transactions_per_account = 0;
+      /// Maximum number of transactions applied to the pending state again after a block has been pushed
+      uint32_t max_reapplied                = 0;
+      /// Fill level of the pool in percent from which transactions received from the network are throttled
+      uint32_t network_pressure_percent     = 0;
+      /// Maximum estimated time in microseconds to apply a transaction received from the network under pressure
+      uint32_t network_max_cost_us          = 0;
+   };
+
+   /**
+    * @class transaction_pool
+    * @brief The pending transactions of the database, indexed for eviction
+    *
+    * The pool enforces memory caps when transactions are admitted, evicting the transactions with the lowest
+    * fee per byte when a better paying transaction arrives. Evicted transactions which are applied to the
+    * pending state are only dropped when the pending state is rebuilt, i.e. after the next block.
+    */
+   class transaction_pool
+   {
+      public:
+         struct by_id;
+         struct by_sequence;
+         struct by_expiration;
+         struct by_fee;
+         struct by_account;
+         typedef boost::multi_index_container<
+            pooled_transaction,
+            boost::multi_index::indexed_by<
+               boost::multi_index::ordered_unique< boost::multi_index::tag<by_sequence>,
+                  boost::multi_index::member< pooled_transaction, uint64_t, &pooled_transaction::sequence > >,
+               boost::multi_index::hashed_unique< boost::multi_index::tag<by_id>,
+                  boost::multi_index::member< pooled_transaction, transaction_id_type, &pooled_transaction::id >,
+                  std::hash<transaction_id_type> >,
+               boost::multi_index::ordered_non_unique< boost::multi_index::tag<by_expiration>,
+                  boost::multi_index::member< pooled_transaction, fc::time_point_sec, &pooled_transaction::expiration > >,
+               boost::multi_index::ordered_unique< boost::multi_index::tag<by_fee>,
+                  boost::multi_index::composite_key< pooled_transaction,
+                     boost::multi_index::member< pooled_transaction, uint64_t, &pooled_transaction::fee_per_kb >,
+                     boost::multi_index::member< pooled_transaction, uint64_t, &pooled_transaction::sequence >
+                  >,
+                  boost::multi_index::composite_key_compare< std::less<uint64_t>, std::greater<uint64_t> >
+               >,
+               boost::multi_index::ordered_non_unique< boost::multi_index::tag<by_account>,
+                  boost::multi_index::member< pooled_transaction, account_id_type, &pooled_transaction::account > >
+            >
+         > index_type;
+
+         void set_limits( const transaction_pool_limits& limits ) { _limits = limits; }
+         const transaction_pool_limits& get_limits()const { return _limits; }
+
+         /**
+          * @brief Check whether a transaction would be admitted
+          * @throws fc::exception if the pool is full of better paying transactions or the account reached its limit
+          */
+         void check_admission( const pooled_transaction& entry )const;
+         /**
+          * @brief Check whether a transaction received from the network would be admitted under the current load
+          * @param estimated_cost the expected time needed to apply the transaction
+          * @throws fc::exception if the pool is filled beyond the pressure level and the transaction does not pay
+          * more than the lowest paying pending transaction or is expected to be too expensive to apply
+          *
+          * Transactions of local API clients are not throttled this way, so that they are preferred under load.
+          */
+         void check_network_admission( const pooled_transaction& entry, fc::microseconds estimated_cost )const;
+         /// Add a transaction which has passed check_admission()
+         void insert( pooled_transaction entry );
+
+         bool contains( const transaction_id_type& id )const;
+         /// @return the transaction or null
+         const pooled_transaction* find( const transaction_id_type& id )const;
+
+         /// Evict the lowest paying transactions until the pool is within its limits
+         void trim();
+         /// Remove all transactions which expire before @p now
+         size_t remove_expired( fc::time_point_sec now );
+
+         /// Remove and return all transactions in order of arrival
+         vector<pooled_transaction> extract();
+         void clear();
+
+         /// All transactions in order of arrival
+         const index_type::index<by_sequence>::type& transactions()const { return _index.get<by_sequence>(); }
+         size_t size()const { return _index.size(); }
+         bool empty()const { return _index.empty(); }
+         uint64_t total_bytes()const { return _total_bytes; }
+         /// @return how full the pool is in percent of its stricter limit, 0 if it is not limited
+         uint32_t fill_percent()const;
+
+      private:
+         /// @return true if there is no room for another transaction of the given size
+         bool is_full( size_t extra_bytes )const;
+         bool over_limits()const;
+
+         index_type               _index;
+         transaction_pool_limits  _limits;
+         uint64_t                 _total_bytes = 0;
+         uint64_t                 _next_sequence = 0;
+   };
+
+} } // graphene::chain
+
+FC_REFLECT( graphene::chain::transaction_pool_limits,
+            (max_transactions)(max_bytes)(max_transactions_per_account)(max_reapplied)
+            (network_pressure_percent)(network_max_cost_us) )
@@ -0,0 +1,225 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/vesting_balance_object.hpp>
+
+#include <unordered_map>
+#include <unordered_set>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief Chain parameters which all cached vote tallies depend on, the cache is rebuilt when any of them changes
+    */
+   struct vote_tally_context
+   {
+      uint32_t next_available_vote_id  = 0;
+      uint16_t maximum_witness_count   = 0;
+      uint16_t maximum_committee_count = 0;
+      bool     count_non_member_votes  = true;
+      bool     pob_activated           = false;
+
+      bool operator==( const vote_tally_context& o )const
+      {
+         return next_available_vote_id == o.next_available_vote_id
+               && maximum_witness_count == o.maximum_witness_count
+               && maximum_committee_count == o.maximum_committee_count
+               && count_non_member_votes == o.count_non_member_votes
+               && pob_activated == o.pob_activated;
+      }
+   };
+
+   /**
+    * @brief What the stake of one account adds to the vote tally buffers during chain maintenance
+    *
+    * Votes of active committee members for workers are not included, they are tallied separately.
+    */
+   struct vote_tally_contribution
+   {
+      /// Instances of the votes by vote type (committee, witness, worker), sorted
+      vector<uint32_t> vote_instances[3];
+      /// Stake added to each vote of the type
+      uint64_t         vote_stake[3] = { 0, 0, 0 };
+      uint16_t        witness_count_offset   = 0;
+      uint64_t        witness_count_stake    = 0;
+      uint16_t        committee_count_offset = 0;
+      uint64_t        committee_count_stake  = 0;
+      uint64_t        total_committee_stake  = 0;
+      uint64_t        total_witness_stake    = 0;
+
+      /// The account which specified the votes
+      account_id_type opinion_account;
+      /// The contribution is valid in [computed_at, valid_until) unless the involved objects change
+      time_point_sec  computed_at;
+      time_point_sec  valid_until = time_point_sec::maximum();
+
+      /// Adds the stake to (or subtracts it from) the tally of each vote
+      void add_votes( vector<uint64_t>& tally, bool subtract = false )const
+      {
+         for( int type = 0; type < 3; ++type )
+         {
+            const uint64_t stake = subtract ? uint64_t(0) - vote_stake[type] : vote_stake[type];
+            for( const uint32_t instance : vote_instances[type] )
+               tally[instance] += stake;
+         }
+      }
+
+      /// Compares the tallied amounts only
+      bool same_tally( const vote_tally_contribution& o )const
+      {
+         for( int type = 0; type < 3; ++type )
+            if( vote_instances[type] != o.vote_instances[type] || vote_stake[type] != o.vote_stake[type] )
+               return false;
+         return witness_count_offset == o.witness_count_offset && witness_count_stake == o.witness_count_stake
+               && committee_count_offset == o.committee_count_offset
+               && committee_count_stake == o.committee_count_stake
+               && total_committee_stake == o.total_committee_stake
+               && total_witness_stake == o.total_witness_stake;
+      }
+   };
+
+   /**
+    * @brief Counters of the incremental vote tally
+    */
+   struct vote_tally_stats
+   {
+      bool     enabled      = false;
+      uint64_t accounts     = 0; ///< number of cached contributions
+      uint64_t recomputed   = 0; ///< contributions computed in the last maintenance
+      uint64_t reused       = 0; ///< contributions reused in the last maintenance
+      uint64_t rebuilds     = 0; ///< number of times the whole cache was rebuilt
+      uint64_t mismatches   = 0; ///< differences found by verification since startup
+   };
+
+   /**
+    * @class vote_tally_cache
+    * @brief Keeps the vote tally of the last chain maintenance, so that only the stake of accounts which changed
+    *        since then needs to be tallied again
+    *
+    * Accounts are marked dirty by secondary indexes on the account, account statistics and vesting balance
+    * indexes, including changes made by undo. Contributions which depend on time (vote decay, membership
+    * expiration) carry the period in which they are valid.
+    *
+    * The cache lives in memory only and is rebuilt by the first maintenance after startup.
+    */
+   class vote_tally_cache
+   {
+      public:
+         /// Switch the cache on or off, @p verify to tally every account anyway and compare for debugging
+         void enable( bool enabled, bool verify );
+         bool enabled()const { return _enabled; }
+         bool verify()const { return _verify; }
+
+         /// Start a maintenance, the cache is reset if @p context differs from the one of the last maintenance
+         void begin( const vote_tally_context& context );
+
+         /// @return the cached contribution of the account if it is still valid at @p now, otherwise null
+         const vote_tally_contribution* find( account_id_type account, time_point_sec now )const;
+         /// Keep the cached contribution of the account in this maintenance
+         void keep( account_id_type account );
+         /// Replace the contribution of the account in this maintenance
+         void update( account_id_type account, vote_tally_contribution&& contribution );
+         /// Record a difference found by verification
+         void report_mismatch() { ++_stats.mismatches; }
+
+         /**
+          * @brief Finish a maintenance, drop the contributions of accounts which were not tallied in it and
+          *        add the totals to the given buffers
+          */
+         void finish( vector<uint64_t>& vote_tally, vector<uint64_t>& witness_count_histogram,
+                      vector<uint64_t>& committee_count_histogram, uint64_t total_voting_stake[2] );
+
+         /// Mark the account and the accounts which delegated their votes to it
+         void mark_dirty( account_id_type account );
+         void clear();
+
+         /// Record changed accounts even if the cache is disabled, until @ref stop_tracking is called
+         void start_tracking() { _touched.clear(); _tracking = true; }
+         void stop_tracking() { _tracking = false; _touched.clear(); }
+         bool tracking()const { return _tracking; }
+         /// @return whether the account changed since @ref start_tracking was called
+         bool touched( account_id_type account )const
+         { return _touched.find( account.instance.value ) != _touched.end(); }
+
+         vote_tally_stats get_stats()const;
+
+      private:
+         struct entry
+         {
+            vote_tally_contribution contribution;
+            uint64_t                generation = 0;
+         };
+         typedef std::unordered_map< uint64_t, entry > entry_map;
+
+         void add( const vote_tally_contribution& c, bool subtract );
+         void set_opinion_account( uint64_t account, account_id_type old_opinion, account_id_type new_opinion );
+
+         bool                     _enabled = false;
+         bool                     _verify  = false;
+         bool                     _valid   = false;
+         bool                     _tracking = false;
+         std::unordered_set< uint64_t > _touched;
+         vote_tally_context       _context;
+         uint64_t                 _generation = 0;
+
+         entry_map                                                   _entries;
+         std::unordered_set< uint64_t >                              _dirty;
+         /// accounts by the account which specifies their votes, if different
+         std::unordered_map< uint64_t, std::unordered_set<uint64_t> > _delegators;
+
+         vector<uint64_t>         _vote_tally;
+         vector<uint64_t>         _witness_count_histogram;
+         vector<uint64_t>         _committee_count_histogram;
+         uint64_t                 _total_voting_stake[2] = { 0, 0 };
+
+         vote_tally_stats         _stats;
+   };
+
+   /**
+    * @brief Marks the accounts whose votes may change when objects of the primary index change
+    */
+   template<typename ObjectType>
+   class vote_tally_observer : public secondary_index
+   {
+      public:
+         explicit vote_tally_observer( vote_tally_cache* cache ) : _cache( cache ) {}
+
+         virtual void object_inserted( const object& obj ) override { mark( obj ); }
+         virtual void object_removed( const object& obj ) override { mark( obj ); }
+         virtual void object_modified( const object& after ) override { mark( after ); }
+
+      private:
+         static account_id_type account_of( const account_object& o ) { return o.id; }
+         static account_id_type account_of( const account_statistics_object& o ) { return o.owner; }
+         static account_id_type account_of( const vesting_balance_object& o ) { return o.owner; }
+
+         void mark( const object& obj )
+         {
+            if( _cache->enabled() || _cache->tracking() )
+               _cache->mark_dirty( account_of( static_cast<const ObjectType&>( obj ) ) );
+         }
+
+         vote_tally_cache* _cache;
+   };
+
+} } // graphene::chain
+
+FC_REFLECT( graphene::chain::vote_tally_stats, (enabled)(accounts)(recomputed)(reused)(rebuilds)(mismatches) )
@@ -75,6 +75,7 @@ void_result personal_data_v2_remove_evaluator::do_evaluate( const personal_data_
    auto itr = by_op_idx.lower_bound(boost::make_tuple(op.subject_account, op.operator_account, op.hash));
    FC_ASSERT( itr->subject_account == op.subject_account && itr->operator_account == op.operator_account && itr->hash == op.hash,
          "Personal data does not exists.");
+   personal_data = &(*itr);
 
    return void_result();
 } FC_CAPTURE_AND_RETHROW( (op) ) }
@@ -82,11 +83,9 @@ void_result personal_data_v2_remove_evaluator::do_evaluate( const personal_data_
 object_id_type personal_data_v2_remove_evaluator::do_apply( const personal_data_v2_remove_operation& o )
 { try {
    database& d = db();
-   const auto& pd_idx = d.get_index_type<personal_data_v2_index>();
-   const auto& by_op_idx = pd_idx.indices().get<by_subject_account>();
-   auto itr = by_op_idx.lower_bound(boost::make_tuple(o.subject_account, o.operator_account, o.hash));
-   auto pd_id = itr->id;
-   d.remove(d.get_object(pd_id));
+   // found by do_evaluate()
+   auto pd_id = personal_data->id;
+   d.remove(*personal_data);
    return pd_id;
 } FC_CAPTURE_AND_RETHROW((o)) }
 
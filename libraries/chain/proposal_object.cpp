@@ -33,11 +33,11 @@ namespace graphene { namespace chain {
 
 bool proposal_object::is_authorized_to_execute( database& db ) const
 {
-   transaction_evaluation_state dry_run_eval( &db );
-
+   // this runs on every approval change of a proposal which is usually not authorized yet, so do not build
+   // an exception for the missing authorities, only the lookups of missing accounts still throw
    try {
       bool allow_non_immediate_owner = true;
-      verify_authority( proposed_transaction.operations,
+      return is_authorized( proposed_transaction.operations,
                         available_key_approvals,
                         [&db]( account_id_type id ){ return &id( db ).active; },
                         [&db]( account_id_type id ){ return &id( db ).owner;  },
@@ -54,7 +54,6 @@ bool proposal_object::is_authorized_to_execute( database& db ) const
    {
       return false;
    }
-   return true;
 }
 
 void required_approval_index::object_inserted( const object& obj )
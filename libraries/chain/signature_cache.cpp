@@ -0,0 +1,38 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <graphene/chain/signature_cache.hpp>
+
+namespace graphene { namespace chain {
+
+public_key_type signature_cache::recover( const signature_type& sig, const digest_type& digest )const
+{
+   if( _keys.capacity() == 0 )
+      return fc::ecc::public_key( sig, digest );
+
+   key_type key{ sig, digest };
+   public_key_type pub_key;
+   if( !_keys.find( key, pub_key ) )
+   {
+      pub_key = fc::ecc::public_key( sig, digest );
+      _keys.put( key, pub_key );
+   }
+   return pub_key;
+}
+
+} } // graphene::chain
@@ -0,0 +1,186 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <graphene/chain/state_delta_log.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/io/raw.hpp>
+
+#include <fstream>
+
+namespace graphene { namespace chain {
+
+namespace {
+
+   /// Reads the block number of the entry at the current position of @p in and moves to the next entry,
+   /// @return false at the end of the log
+   bool skip_entry( std::istream& in, uint64_t file_size, uint32_t& block_num )
+   {
+      const uint64_t position = in.tellg();
+      uint32_t packed_size = 0;
+      if( position + sizeof(packed_size) > file_size )
+         return false;
+      in.read( reinterpret_cast<char*>( &packed_size ), sizeof(packed_size) );
+      if( !in || position + sizeof(packed_size) + packed_size > file_size )
+         return false;
+      // a delta starts with its block, which starts with the ID of the previous block
+      std::vector<char> previous( fc::raw::pack_size( block_id_type() ) );
+      if( packed_size < previous.size() )
+         return false;
+      in.read( previous.data(), previous.size() );
+      if( !in )
+         return false;
+      block_num = block_header::num_from_id( fc::raw::unpack<block_id_type>( previous ) ) + 1;
+      in.seekg( position + sizeof(packed_size) + packed_size );
+      return bool( in );
+   }
+
+} // anonymous
+
+void state_delta_log::open( const fc::path& file )
+{ try {
+   close();
+   _file = file;
+   _first_block_num = 0;
+   _last_block_num = 0;
+   _file_size = 0;
+   _offsets.clear();
+   if( fc::exists( _file ) )
+   {
+      const uint64_t file_size = fc::file_size( _file );
+      {
+         std::ifstream in( _file.generic_string().c_str(), std::ios::binary );
+         FC_ASSERT( in, "Unable to read ", ("f", _file) );
+         uint32_t block_num = 0;
+         while( skip_entry( in, file_size, block_num ) )
+         {
+            if( _first_block_num == 0 )
+               _first_block_num = block_num;
+            FC_ASSERT( _last_block_num == 0 || block_num == _last_block_num + 1,
+                       "Block ${n} follows block ${l} in ${f}", ("n", block_num)("l", _last_block_num)("f", _file) );
+            if( ( block_num - _first_block_num ) % offset_interval == 0 )
+               _offsets.push_back( _file_size );
+            _last_block_num = block_num;
+            _file_size = in.tellg();
+         }
+      }
+      if( _file_size < file_size )
+      {
+         wlog( "Dropping an incomplete entry at the end of ", ("f", _file) );
+         fc::resize_file( _file, _file_size );
+      }
+   }
+   else
+   {
+      fc::create_directories( _file.parent_path() );
+      std::ofstream out( _file.generic_string().c_str(), std::ios::binary | std::ios::trunc );
+      FC_ASSERT( out, "Unable to write ", ("f", _file) );
+   }
+   _open = true;
+} FC_CAPTURE_AND_RETHROW( (file) ) }
+
+void state_delta_log::close()
+{
+   _pending.clear();
+   _open = false;
+}
+
+void state_delta_log::add_block( state_delta&& delta )
+{
+   if( !_open )
+      return;
+   const uint32_t block_num = delta.block.block_num();
+   // the log must not have gaps, blocks are taken if they follow the log or replace blocks kept in memory,
+   // an empty log starts with any block
+   if( _last_block_num > 0 || !_pending.empty() )
+   {
+      const uint32_t last_block_num = _last_block_num > 0 ? _last_block_num : _pending.begin()->first - 1;
+      if( block_num <= last_block_num || block_num > last_block_num + _pending.size() + 1 )
+      {
+         // deltas are only made while undo sessions are active, so replays and unclean restarts leave gaps
+         wlog( "Block ${n} does not follow the state delta log ${f} which ends at block ${l}, restarting the log, "
+               "read replicas have to start again from the state at a block in it",
+               ("n", block_num)("f", _file)("l", last_block_num + _pending.size()) );
+         restart();
+      }
+   }
+   _pending.erase( _pending.lower_bound( block_num ), _pending.end() );
+   _pending[ block_num ] = std::move( delta );
+}
+
+void state_delta_log::restart()
+{ try {
+   _pending.clear();
+   _first_block_num = 0;
+   _last_block_num = 0;
+   _file_size = 0;
+   _offsets.clear();
+   fc::resize_file( _file, 0 );
+} FC_CAPTURE_AND_RETHROW( (_file) ) }
+
+void state_delta_log::write_irreversible( uint32_t last_irreversible )
+{ try {
+   if( !_open || _pending.empty() || _pending.begin()->first > last_irreversible )
+      return;
+   std::ofstream out( _file.generic_string().c_str(), std::ios::binary | std::ios::app );
+   auto itr = _pending.begin();
+   for( ; itr != _pending.end() && itr->first <= last_irreversible; ++itr )
+   {
+      const std::vector<char> packed = fc::raw::pack( itr->second );
+      const uint32_t packed_size = static_cast<uint32_t>( packed.size() );
+      out.write( reinterpret_cast<const char*>( &packed_size ), sizeof(packed_size) );
+      out.write( packed.data(), packed.size() );
+      if( _first_block_num == 0 )
+         _first_block_num = itr->first;
+      if( ( itr->first - _first_block_num ) % offset_interval == 0 )
+         _offsets.push_back( _file_size );
+      _file_size += sizeof(packed_size) + packed.size();
+      _last_block_num = itr->first;
+   }
+   out.close();
+   FC_ASSERT( out, "Unable to write ", ("f", _file) );
+   _pending.erase( _pending.begin(), itr );
+} FC_CAPTURE_AND_RETHROW( (last_irreversible) ) }
+
+void state_delta_log::read_packed( uint32_t block_num, uint32_t limit,
+                                   const std::function<void(const vector<char>&)>& f )const
+{ try {
+   FC_ASSERT( _open, "The state delta log is not open" );
+   if( limit == 0 || _last_block_num == 0 || block_num < _first_block_num || block_num > _last_block_num )
+      return;
+   std::ifstream in( _file.generic_string().c_str(), std::ios::binary );
+   FC_ASSERT( in, "Unable to read ", ("f", _file) );
+   const uint32_t offset_index = ( block_num - _first_block_num ) / offset_interval;
+   in.seekg( _offsets[ offset_index ] );
+   uint32_t current = _first_block_num + offset_index * offset_interval;
+   uint32_t skipped = 0;
+   for( ; current < block_num; ++current )
+      FC_ASSERT( skip_entry( in, _file_size, skipped ), "Unable to read block ${n} from ${f}",
+                 ("n", current)("f", _file) );
+   vector<char> packed;
+   for( ; limit > 0 && current <= _last_block_num; --limit, ++current )
+   {
+      uint32_t packed_size = 0;
+      in.read( reinterpret_cast<char*>( &packed_size ), sizeof(packed_size) );
+      packed.resize( packed_size );
+      in.read( packed.data(), packed.size() );
+      FC_ASSERT( in, "Unable to read block ${n} from ${f}", ("n", current)("f", _file) );
+      f( packed );
+   }
+} FC_CAPTURE_AND_RETHROW( (block_num)(limit)(_file) ) }
+
+} } // graphene::chain
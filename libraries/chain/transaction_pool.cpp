@@ -0,0 +1,153 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <graphene/chain/transaction_pool.hpp>
+#include <graphene/chain/exceptions.hpp>
+
+namespace graphene { namespace chain {
+
+bool transaction_pool::is_full( size_t extra_bytes )const
+{
+   return ( _limits.max_transactions > 0 && _index.size() >= _limits.max_transactions )
+       || ( _limits.max_bytes > 0 && _total_bytes + extra_bytes > _limits.max_bytes );
+}
+
+bool transaction_pool::over_limits()const
+{
+   return ( _limits.max_transactions > 0 && _index.size() > _limits.max_transactions )
+       || ( _limits.max_bytes > 0 && _total_bytes > _limits.max_bytes );
+}
+
+void transaction_pool::check_admission( const pooled_transaction& entry )const
+{
+   GRAPHENE_ASSERT( !contains( entry.id ), duplicate_transaction,
+                    "Transaction '${txid}' is already pending", ("txid", entry.id) );
+
+   if( _limits.max_transactions_per_account > 0 )
+      FC_ASSERT( _index.get<by_account>().count( entry.account ) < _limits.max_transactions_per_account,
+                 "Account ${a} has too many pending transactions", ("a", entry.account) );
+
+   if( is_full( entry.size ) && !_index.empty() )
+   {
+      const auto& lowest = *_index.get<by_fee>().begin();
+      FC_ASSERT( entry.fee_per_kb > lowest.fee_per_kb,
+                 "Transaction pool is full, the fee is too low to replace pending transactions",
+                 ("fee_per_kb", entry.fee_per_kb)("lowest", lowest.fee_per_kb) );
+   }
+}
+
+void transaction_pool::check_network_admission( const pooled_transaction& entry,
+                                                fc::microseconds estimated_cost )const
+{
+   if( _limits.network_pressure_percent == 0 || _index.empty() || fill_percent() < _limits.network_pressure_percent )
+      return;
+
+   const auto& lowest = *_index.get<by_fee>().begin();
+   FC_ASSERT( entry.fee_per_kb > lowest.fee_per_kb,
+              "Transaction pool is under pressure, the fee is too low to accept the transaction from the network",
+              ("fee_per_kb", entry.fee_per_kb)("lowest", lowest.fee_per_kb) );
+   FC_ASSERT( _limits.network_max_cost_us == 0 || estimated_cost.count() <= _limits.network_max_cost_us,
+              "Transaction pool is under pressure, the transaction is too expensive to accept from the network",
+              ("estimated_cost_us", estimated_cost.count())("max_cost_us", _limits.network_max_cost_us) );
+}
+
+uint32_t transaction_pool::fill_percent()const
+{
+   uint64_t percent = 0;
+   if( _limits.max_transactions > 0 )
+      percent = uint64_t( _index.size() ) * 100 / _limits.max_transactions;
+   if( _limits.max_bytes > 0 )
+      percent = std::max( percent, _total_bytes * 100 / _limits.max_bytes );
+   return uint32_t( std::min<uint64_t>( percent, 100 ) );
+}
+
+void transaction_pool::insert( pooled_transaction entry )
+{
+   entry.sequence = _next_sequence++;
+   _total_bytes += entry.size;
+   _index.insert( std::move( entry ) );
+
+   // transactions which are not applied to the pending state can be dropped right away
+   auto& fee_idx = _index.get<by_fee>();
+   for( auto itr = fee_idx.begin(); itr != fee_idx.end() && over_limits(); )
+   {
+      if( itr->applied )
+         ++itr;
+      else
+      {
+         _total_bytes -= itr->size;
+         itr = fee_idx.erase( itr );
+      }
+   }
+}
+
+bool transaction_pool::contains( const transaction_id_type& id )const
+{
+   return _index.get<by_id>().find( id ) != _index.get<by_id>().end();
+}
+
+const pooled_transaction* transaction_pool::find( const transaction_id_type& id )const
+{
+   auto itr = _index.get<by_id>().find( id );
+   return itr != _index.get<by_id>().end() ? &*itr : nullptr;
+}
+
+void transaction_pool::trim()
+{
+   auto& fee_idx = _index.get<by_fee>();
+   size_t evicted = 0;
+   while( !fee_idx.empty() && over_limits() )
+   {
+      _total_bytes -= fee_idx.begin()->size;
+      fee_idx.erase( fee_idx.begin() );
+      ++evicted;
+   }
+   if( evicted > 0 )
+      wlog( "Evicted ${n} low fee transactions from the transaction pool", ("n", evicted) );
+}
+
+size_t transaction_pool::remove_expired( fc::time_point_sec now )
+{
+   auto& exp_idx = _index.get<by_expiration>();
+   size_t removed = 0;
+   while( !exp_idx.empty() && exp_idx.begin()->expiration < now )
+   {
+      _total_bytes -= exp_idx.begin()->size;
+      exp_idx.erase( exp_idx.begin() );
+      ++removed;
+   }
+   return removed;
+}
+
+vector<pooled_transaction> transaction_pool::extract()
+{
+   vector<pooled_transaction> result;
+   result.reserve( _index.size() );
+   for( const auto& entry : _index.get<by_sequence>() )
+      result.push_back( entry );
+   clear();
+   return result;
+}
+
+void transaction_pool::clear()
+{
+   _index.clear();
+   _total_bytes = 0;
+}
+
+} } // graphene::chain
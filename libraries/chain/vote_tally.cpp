@@ -0,0 +1,224 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <graphene/chain/vote_tally.hpp>
+
+namespace graphene { namespace chain {
+
+void vote_tally_cache::enable( bool enabled, bool verify )
+{
+   _enabled = enabled;
+   _verify = enabled && verify;
+   clear();
+}
+
+void vote_tally_cache::begin( const vote_tally_context& context )
+{
+   ++_generation;
+   _stats.recomputed = 0;
+   _stats.reused = 0;
+   if( _valid && _context == context )
+      return;
+
+   clear();
+   _context = context;
+   _vote_tally.assign( context.next_available_vote_id, 0 );
+   _witness_count_histogram.assign( context.maximum_witness_count / 2 + 1, 0 );
+   _committee_count_histogram.assign( context.maximum_committee_count / 2 + 1, 0 );
+   _valid = true;
+   ++_stats.rebuilds;
+}
+
+const vote_tally_contribution* vote_tally_cache::find( account_id_type account, time_point_sec now )const
+{
+   if( !_valid || _dirty.find( account.instance.value ) != _dirty.end() )
+      return nullptr;
+   auto itr = _entries.find( account.instance.value );
+   if( itr == _entries.end() )
+      return nullptr;
+   const vote_tally_contribution& c = itr->second.contribution;
+   if( now < c.computed_at || now >= c.valid_until )
+      return nullptr;
+   return &c;
+}
+
+void vote_tally_cache::keep( account_id_type account )
+{
+   auto itr = _entries.find( account.instance.value );
+   FC_ASSERT( itr != _entries.end() );
+   itr->second.generation = _generation;
+   ++_stats.reused;
+}
+
+void vote_tally_cache::update( account_id_type account, vote_tally_contribution&& contribution )
+{
+   const uint64_t key = account.instance.value;
+   _dirty.erase( key );
+   auto itr = _entries.find( key );
+   if( itr == _entries.end() )
+   {
+      set_opinion_account( key, account, contribution.opinion_account );
+      itr = _entries.emplace( key, entry() ).first;
+   }
+   else
+   {
+      add( itr->second.contribution, true );
+      set_opinion_account( key, itr->second.contribution.opinion_account, contribution.opinion_account );
+   }
+   add( contribution, false );
+   itr->second.contribution = std::move( contribution );
+   itr->second.generation = _generation;
+   ++_stats.recomputed;
+}
+
+void vote_tally_cache::finish( vector<uint64_t>& vote_tally, vector<uint64_t>& witness_count_histogram,
+                               vector<uint64_t>& committee_count_histogram, uint64_t total_voting_stake[2] )
+{
+   // accounts which did not take part in this maintenance have no stake voting any more
+   for( auto itr = _entries.begin(); itr != _entries.end(); )
+   {
+      if( itr->second.generation == _generation )
+      {
+         ++itr;
+         continue;
+      }
+      add( itr->second.contribution, true );
+      set_opinion_account( itr->first, itr->second.contribution.opinion_account, account_id_type( itr->first ) );
+      itr = _entries.erase( itr );
+   }
+   // marks only matter for accounts with a cached contribution
+   for( auto itr = _dirty.begin(); itr != _dirty.end(); )
+   {
+      if( _entries.find( *itr ) == _entries.end() )
+         itr = _dirty.erase( itr );
+      else
+         ++itr;
+   }
+
+   if( _verify )
+   {
+      vector<uint64_t> tally( _vote_tally.size(), 0 );
+      vector<uint64_t> witness_hist( _witness_count_histogram.size(), 0 );
+      vector<uint64_t> committee_hist( _committee_count_histogram.size(), 0 );
+      uint64_t totals[2] = { 0, 0 };
+      for( const auto& item : _entries )
+      {
+         const vote_tally_contribution& c = item.second.contribution;
+         c.add_votes( tally );
+         witness_hist[c.witness_count_offset] += c.witness_count_stake;
+         committee_hist[c.committee_count_offset] += c.committee_count_stake;
+         totals[0] += c.total_committee_stake;
+         totals[1] += c.total_witness_stake;
+      }
+      if( tally != _vote_tally || witness_hist != _witness_count_histogram
+            || committee_hist != _committee_count_histogram
+            || totals[0] != _total_voting_stake[0] || totals[1] != _total_voting_stake[1] )
+      {
+         elog( "Incremental vote tally totals differ from the sum of the cached contributions" );
+         report_mismatch();
+         _vote_tally = std::move( tally );
+         _witness_count_histogram = std::move( witness_hist );
+         _committee_count_histogram = std::move( committee_hist );
+         _total_voting_stake[0] = totals[0];
+         _total_voting_stake[1] = totals[1];
+      }
+   }
+
+   FC_ASSERT( vote_tally.size() >= _vote_tally.size()
+              && witness_count_histogram.size() >= _witness_count_histogram.size()
+              && committee_count_histogram.size() >= _committee_count_histogram.size() );
+   for( size_t i = 0; i < _vote_tally.size(); ++i )
+      vote_tally[i] += _vote_tally[i];
+   for( size_t i = 0; i < _witness_count_histogram.size(); ++i )
+      witness_count_histogram[i] += _witness_count_histogram[i];
+   for( size_t i = 0; i < _committee_count_histogram.size(); ++i )
+      committee_count_histogram[i] += _committee_count_histogram[i];
+   total_voting_stake[0] += _total_voting_stake[0];
+   total_voting_stake[1] += _total_voting_stake[1];
+}
+
+void vote_tally_cache::mark_dirty( account_id_type account )
+{
+   const uint64_t key = account.instance.value;
+   if( _tracking )
+      _touched.insert( key );
+   if( !_enabled )
+      return;
+   _dirty.insert( key );
+   auto itr = _delegators.find( key );
+   if( itr != _delegators.end() )
+      _dirty.insert( itr->second.begin(), itr->second.end() );
+}
+
+void vote_tally_cache::clear()
+{
+   _valid = false;
+   _entries.clear();
+   _dirty.clear();
+   _delegators.clear();
+   _vote_tally.clear();
+   _witness_count_histogram.clear();
+   _committee_count_histogram.clear();
+   _total_voting_stake[0] = 0;
+   _total_voting_stake[1] = 0;
+}
+
+vote_tally_stats vote_tally_cache::get_stats()const
+{
+   vote_tally_stats result = _stats;
+   result.enabled = _enabled;
+   result.accounts = _entries.size();
+   return result;
+}
+
+void vote_tally_cache::add( const vote_tally_contribution& c, bool subtract )
+{
+   // unsigned arithmetic wraps the same way in both directions, so the totals stay exact
+   auto apply = [subtract]( uint64_t& target, uint64_t amount ) {
+      if( subtract )
+         target -= amount;
+      else
+         target += amount;
+   };
+   c.add_votes( _vote_tally, subtract );
+   apply( _witness_count_histogram[c.witness_count_offset], c.witness_count_stake );
+   apply( _committee_count_histogram[c.committee_count_offset], c.committee_count_stake );
+   apply( _total_voting_stake[0], c.total_committee_stake );
+   apply( _total_voting_stake[1], c.total_witness_stake );
+}
+
+void vote_tally_cache::set_opinion_account( uint64_t account, account_id_type old_opinion,
+                                            account_id_type new_opinion )
+{
+   if( old_opinion == new_opinion )
+      return;
+   if( old_opinion.instance.value != account )
+   {
+      auto itr = _delegators.find( old_opinion.instance.value );
+      if( itr != _delegators.end() )
+      {
+         itr->second.erase( account );
+         if( itr->second.empty() )
+            _delegators.erase( itr );
+      }
+   }
+   if( new_opinion.instance.value != account )
+      _delegators[ new_opinion.instance.value ].insert( account );
+}
+
+} } // graphene::chain
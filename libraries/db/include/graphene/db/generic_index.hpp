@@ -27,6 +27,7 @@
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/mem_fun.hpp>
+#include <boost/mpl/size.hpp>
 
 namespace graphene { namespace db {
 
@@ -38,6 +39,9 @@ namespace graphene { namespace db {
     *  Almost all objects can be tracked and managed via a boost::multi_index container that uses
     *  an unordered_unique key on the object ID.  This template class adapts the generic index interface
     *  to work with arbitrary boost multi_index containers on the same type.
+    *
+    *  Containers declared with a @ref node_allocator can be switched to pooled node allocation at runtime,
+    *  see @ref enable_node_pool.
     */
    template<typename ObjectType, typename MultiIndexType>
    class generic_index : public index
@@ -110,6 +114,40 @@ namespace graphene { namespace db {
             } FC_CAPTURE_AND_RETHROW()
          }
 
+         /// Same as @ref inspect_all_objects, but calls @p visitor directly with the objects of their own type
+         template<typename Visitor>
+         void for_each_object( Visitor&& visitor )const
+         {
+            try {
+               for( const ObjectType& obj : _indices )
+                  visitor( obj );
+            } FC_CAPTURE_AND_RETHROW()
+         }
+
+         virtual bool enable_node_pool()override
+         {
+            typedef node_pool_traits< typename index_type::allocator_type > pool_traits;
+            if( !pool_traits::pooled )
+               return false;
+            pool_traits::enable();
+            return true;
+         }
+
+         virtual node_pool_stats get_node_pool_stats()const override
+         {
+            return node_pool_traits< typename index_type::allocator_type >::stats();
+         }
+
+         virtual uint64_t get_container_overhead( uint64_t object_count )const override
+         {
+            const node_pool_stats pool = get_node_pool_stats();
+            if( pool.enabled )
+               return pool.reserved_bytes - object_count * sizeof( ObjectType );
+            // about three pointers per node and sub-index, E.G. parent, left and right, plus the allocation header
+            constexpr uint64_t indices = boost::mpl::size< typename index_type::index_type_list >::value;
+            return object_count * ( indices * 3 + 2 ) * sizeof( void* );
+         }
+
          const index_type& indices()const { return _indices; }
 
       private:
@@ -23,12 +23,14 @@
  */
 #pragma once
 #include <graphene/db/object.hpp>
+#include <graphene/db/node_allocator.hpp>
 
 #include <fc/interprocess/file_mapping.hpp>
 #include <fc/io/raw.hpp>
 #include <fc/io/json.hpp>
 #include <fc/crypto/sha256.hpp>
 
+#include <algorithm>
 #include <fstream>
 #include <stack>
 
@@ -52,6 +54,24 @@ namespace graphene { namespace db {
          virtual void on_modify( const object& obj ){}
    };
 
+   /**
+    * @brief Estimated memory used by the objects of an index
+    *
+    * The packed size of the objects stands in for the strings and containers they own, it counts their fixed size
+    * fields a second time, so @ref estimated_bytes is rather an upper estimate.
+    */
+   struct index_memory_stats
+   {
+      uint8_t         space_id        = 0;
+      uint8_t         type_id         = 0;
+      uint64_t        object_count    = 0; ///< number of objects
+      uint64_t        object_size     = 0; ///< size of an object in bytes, without the memory it owns
+      uint64_t        packed_bytes    = 0; ///< serialized size of all objects
+      uint64_t        container_bytes = 0; ///< estimated memory used by the container itself, E.G. multi_index nodes
+      uint64_t        estimated_bytes = 0; ///< object_count * object_size + packed_bytes + container_bytes
+      node_pool_stats node_pool;
+   };
+
    /**
     *  @class index
     *  @brief abstract base class for accessing objects indexed in various ways.
@@ -99,6 +119,17 @@ namespace graphene { namespace db {
          virtual void open( const fc::path& db ) = 0;
          virtual void save( const fc::path& db ) = 0;
 
+         /**
+          *  @return true if the index may have been changed since it was last opened from or saved to disk,
+          *          i.e. if the file written by the last open() or save() call is outdated
+          */
+         virtual bool is_dirty()const = 0;
+
+         /**
+          *  @return the version of the serialization format of the objects, which is stored in the file written by
+          *          save() and checked by open()
+          */
+         virtual fc::sha256 get_object_version()const = 0;
 
 
          /** @return the object with id or nullptr if not found */
@@ -129,11 +160,40 @@ namespace graphene { namespace db {
             modify( static_cast<const object&>(obj), std::function<void(object&)>( [&]( object& o ){ l( static_cast<Object&>(o) ); } ) );
          }
 
+         /**
+          *   Applies @p m to each of @p objs, which must all belong to this index.  The result is the same as
+          *   calling modify() on each of them in turn.
+          */
+         virtual void               modify_batch( const vector<const object*>& objs,
+                                                  const std::function<void(object&)>& m )
+         {
+            for( const object* obj : objs )
+               modify( *obj, m );
+         }
+
+         template<typename Object, typename Lambda>
+         void modify_batch( const vector<const Object*>& objs, const Lambda& l ) {
+            modify_batch( vector<const object*>( objs.begin(), objs.end() ),
+                          std::function<void(object&)>( [&]( object& o ){ l( static_cast<Object&>(o) ); } ) );
+         }
+
          virtual void               inspect_all_objects(std::function<void(const object&)> inspector)const = 0;
          virtual void               add_observer( const shared_ptr<index_observer>& ) = 0;
 
          virtual void               object_from_variant( const fc::variant& var, object& obj, uint32_t max_depth )const = 0;
          virtual void               object_default( object& obj )const = 0;
+
+         /**
+          *  Switches the underlying container to pooled node allocation, if it supports it.
+          *  @return true if nodes of this index are allocated from a node_pool
+          */
+         virtual bool               enable_node_pool() { return false; }
+         virtual node_pool_stats    get_node_pool_stats()const { return node_pool_stats(); }
+
+         /// Estimated memory used by the container of this index for @p object_count objects, besides the objects
+         virtual uint64_t           get_container_overhead( uint64_t object_count )const { return 0; }
+         /// Walks all objects to estimate the memory used by this index, this is slow on large indexes
+         virtual index_memory_stats get_memory_stats()const { return index_memory_stats(); }
    };
 
    class secondary_index
@@ -185,6 +245,21 @@ namespace graphene { namespace db {
          }
 
       protected:
+         /// Size of the uncompressed records which are stored together in a chunk of an index file
+         static constexpr size_t file_chunk_size = 1 << 20;
+
+         /// Writes size-prefixed records as a chunk of an index file, compressed if supported, with a checksum
+         static void write_file_chunk( std::ostream& out, const vector<char>& records );
+
+         /**
+          *  Reads the next chunk of an index file and verifies its checksum
+          *  @param buffer holds the records if the chunk is compressed
+          *  @return the records of the chunk
+          *  @throws fc::exception naming the file and the chunk if the chunk is truncated or corrupt
+          */
+         static fc::datastream<const char*> read_file_chunk( fc::datastream<const char*>& in, vector<char>& buffer,
+                                                             const path& file, uint32_t chunk_num );
+
          vector< shared_ptr<index_observer> >   _observers;
          vector< unique_ptr<secondary_index> >  _sindex;
 
@@ -194,8 +269,13 @@ namespace graphene { namespace db {
 
    /** @class direct_index
     *  @brief A secondary index that tracks objects in vectors indexed by object
-    *  id. It is meant for fully (or almost fully) populated indexes only (will
-    *  fail when loading an object_database with large gaps).
+    *  id, so that looking up an object by id takes constant time.
+    *
+    *  The ids are split into chunks of 2^chunkbits instances. A chunk is
+    *  allocated when the first object of it is inserted and released when its
+    *  last object is removed, so gaps in the ids, e.g. of orders which were
+    *  filled long ago, cost one empty vector per chunk only. Indexes whose
+    *  objects are removed a lot should use small chunks.
     *
     *  WARNING! If any of the methods called on insertion, removal or
     *  modification throws, subsequent behaviour is undefined! Such exceptions
@@ -207,58 +287,53 @@ namespace graphene { namespace db {
       static_assert( chunkbits < 64, "Do you really want arrays with more than 2^63 elements???" );
 
       // private
-         static const size_t MAX_HOLE = 100;
-         static const size_t _mask = ((1 << chunkbits) - 1);
-         uint64_t next = 0;
+         static const size_t MIN_CHUNK_SIZE = 100;
+         static const uint64_t _mask = ((1ULL << chunkbits) - 1);
          vector< vector< const Object* > > content;
+         /// number of objects per chunk
+         vector< uint32_t > chunk_sizes;
          std::stack< object_id_type > ids_being_modified;
 
+         const Object* find_instance( uint64_t instance )const
+         {
+            const uint64_t chunk = instance >> chunkbits;
+            if( chunk >= content.size() || content[chunk].empty() ) return nullptr;
+            return content[chunk][instance & _mask];
+         }
+
       public:
          direct_index() {
-            FC_ASSERT( (1ULL << chunkbits) > MAX_HOLE, "Small chunkbits is inefficient." );
+            FC_ASSERT( (1ULL << chunkbits) > MIN_CHUNK_SIZE, "Small chunkbits is inefficient." );
          }
 
          virtual ~direct_index(){}
 
          virtual void object_inserted( const object& obj )
          {
-            uint64_t instance = obj.id.instance();
-            if( instance == next )
-            {
-               if( !(next & _mask) )
-               {
-                  content.resize((next >> chunkbits) + 1);
-                  content[next >> chunkbits].resize( 1 << chunkbits, nullptr );
-               }
-               next++;
-            }
-            else if( instance < next )
-               FC_ASSERT( !content[instance >> chunkbits][instance & _mask], "Overwriting insert at {id}!", ("id",obj.id) );
-            else // instance > next, allow small "holes"
+            FC_ASSERT( nullptr != dynamic_cast<const Object*>(&obj), "Wrong object type!" );
+            const uint64_t instance = obj.id.instance();
+            const uint64_t chunk = instance >> chunkbits;
+            if( chunk >= content.size() )
             {
-               FC_ASSERT( instance <= next + MAX_HOLE, "Out-of-order insert: {id} > {next}!", ("id",obj.id)("next",next) );
-               if( !(next & _mask) || (next & (~_mask)) != (instance & (~_mask)) )
-               {
-                  content.resize((instance >> chunkbits) + 1);
-                  content[instance >> chunkbits].resize( 1 << chunkbits, nullptr );
-               }
-               while( next <= instance )
-               {
-                  content[next >> chunkbits][next & _mask] = nullptr;
-                  next++;
-               }
+               content.resize( chunk + 1 );
+               chunk_sizes.resize( chunk + 1, 0 );
             }
-            FC_ASSERT( nullptr != dynamic_cast<const Object*>(&obj), "Wrong object type!" );
-            content[instance >> chunkbits][instance & _mask] = static_cast<const Object*>( &obj );
+            if( content[chunk].empty() )
+               content[chunk].resize( 1ULL << chunkbits, nullptr );
+            FC_ASSERT( !content[chunk][instance & _mask], "Overwriting insert at {id}!", ("id",obj.id) );
+            content[chunk][instance & _mask] = static_cast<const Object*>( &obj );
+            ++chunk_sizes[chunk];
          }
 
          virtual void object_removed( const object& obj )
          {
             FC_ASSERT( nullptr != dynamic_cast<const Object*>(&obj), "Wrong object type!" );
-            uint64_t instance = obj.id.instance();
-            FC_ASSERT( instance < next, "Removing out-of-range object: {id} > {next}!", ("id",obj.id)("next",next) );
-            FC_ASSERT( content[instance >> chunkbits][instance & _mask], "Removing non-existent object {id}!", ("id",obj.id) );
-            content[instance >> chunkbits][instance & _mask] = nullptr;
+            const uint64_t instance = obj.id.instance();
+            FC_ASSERT( find_instance( instance ), "Removing non-existent object {id}!", ("id",obj.id) );
+            const uint64_t chunk = instance >> chunkbits;
+            content[chunk][instance & _mask] = nullptr;
+            if( --chunk_sizes[chunk] == 0 )
+               vector< const Object* >().swap( content[chunk] );
          }
 
          virtual void about_to_modify( const object& before )
@@ -277,8 +352,7 @@ namespace graphene { namespace db {
          {
             static_assert( object_id::space_id == Object::space_id, "Space ID mismatch!" );
             static_assert( object_id::type_id == Object::type_id, "Type_ID mismatch!" );
-            if( id.instance >= next ) return nullptr;
-            return content[id.instance.value >> chunkbits][id.instance.value & _mask];
+            return find_instance( id.instance.value );
          };
 
          template< typename object_id >
@@ -293,9 +367,15 @@ namespace graphene { namespace db {
          {
             FC_ASSERT( id.space() == Object::space_id, "Space ID mismatch!" );
             FC_ASSERT( id.type() == Object::type_id, "Type_ID mismatch!" );
-            if( id.instance() >= next ) return nullptr;
-            return content[id.instance() >> chunkbits][id.instance() & ((1 << chunkbits) - 1)];
+            return find_instance( id.instance() );
          };
+
+         /// @return the number of allocated chunks
+         size_t allocated_chunks()const
+         {
+            return std::count_if( content.begin(), content.end(),
+                                  []( const vector< const Object* >& chunk ) { return !chunk.empty(); } );
+         }
    };
 
    /**
@@ -325,8 +405,10 @@ namespace graphene { namespace db {
          { return object_type::type_id; }
 
          virtual object_id_type get_next_id()const override              { return _next_id;    }
-         virtual void           use_next_id()override                    { ++_next_id.number;  }
-         virtual void           set_next_id( object_id_type id )override { _next_id = id;      }
+         virtual void           use_next_id()override                    { ++_next_id.number; _dirty = true; }
+         virtual void           set_next_id( object_id_type id )override { _next_id = id; _dirty = true; }
+
+         virtual bool           is_dirty()const override                 { return _dirty; }
 
          /** @return the object with id or nullptr if not found */
          virtual const object*  find( object_id_type id )const override
@@ -336,7 +418,7 @@ namespace graphene { namespace db {
             return DerivedIndex::find( id );
          }
 
-         fc::sha256 get_object_version()const
+         virtual fc::sha256 get_object_version()const override
          {
             std::string desc = "1.0";//get_type_description<object_type>();
             return fc::sha256::hash(desc);
@@ -353,12 +435,27 @@ namespace graphene { namespace db {
             fc::raw::unpack(ds, _next_id);
             fc::raw::unpack(ds, open_ver);
             FC_ASSERT( open_ver == get_object_version(), "Incompatible Version, the serialization of objects in this index has changed" );
-            vector<char> tmp;
+            // The records are stored in checksummed chunks, each record is a size-prefixed packed object.
+            // Uncompressed chunks are unpacked straight from the mapped file.
+            vector<char> buffer;
+            uint32_t chunk_num = 0;
             while( ds.remaining() > 0 )
             {
-               fc::raw::unpack( ds, tmp );
-               load( tmp );
+               fc::datastream<const char*> records = read_file_chunk( ds, buffer, db, chunk_num++ );
+               while( records.remaining() > 0 )
+               {
+                  fc::unsigned_int record_size;
+                  fc::raw::unpack( records, record_size );
+                  FC_ASSERT( record_size.value <= records.remaining(), "Truncated record in ${f}",
+                             ("f",db.generic_string()) );
+                  fc::datastream<const char*> record( records.pos(), record_size.value );
+                  object_type obj;
+                  fc::raw::unpack( record, obj );
+                  records.skip( record_size.value );
+                  load_object( std::move(obj) );
+               }
             }
+            _dirty = false;
          }
 
          virtual void save( const path& db ) override 
@@ -369,24 +466,55 @@ namespace graphene { namespace db {
             auto ver  = get_object_version();
             fc::raw::pack( out, _next_id );
             fc::raw::pack( out, ver );
+            vector<char> records;
+            records.reserve( file_chunk_size );
             this->inspect_all_objects( [&]( const object& o ) {
                 auto vec = fc::raw::pack( static_cast<const object_type&>(o) );
                 auto packed_vec = fc::raw::pack( vec );
-                out.write( packed_vec.data(), packed_vec.size() );
+                records.insert( records.end(), packed_vec.begin(), packed_vec.end() );
+                if( records.size() >= file_chunk_size )
+                {
+                   write_file_chunk( out, records );
+                   records.clear();
+                }
             });
+            if( !records.empty() )
+               write_file_chunk( out, records );
+            out.close();
+            FC_ASSERT( out, "Failed to write ${f}", ("f",db.generic_string()) );
+            _dirty = false;
          }
 
-         virtual const object&  load( const std::vector<char>& data )override
+         virtual index_memory_stats get_memory_stats()const override
          {
-            const auto& result = DerivedIndex::insert( fc::raw::unpack<object_type>( data ) );
-            for( const auto& item : _sindex )
-               item->object_inserted( result );
+            index_memory_stats result;
+            result.space_id = object_type::space_id;
+            result.type_id = object_type::type_id;
+            result.object_size = sizeof( object_type );
+            this->inspect_all_objects( [&result]( const object& o ) {
+               ++result.object_count;
+               result.packed_bytes += fc::raw::pack_size( static_cast<const object_type&>(o) );
+            });
+            result.container_bytes = this->get_container_overhead( result.object_count );
+            if( DirectBits > 0 )
+               result.container_bytes += _direct_by_id->allocated_chunks() * ( 1ULL << DirectBits )
+                                         * sizeof( const object_type* );
+            result.node_pool = this->get_node_pool_stats();
+            result.estimated_bytes = result.object_count * result.object_size + result.packed_bytes
+                                     + result.container_bytes;
             return result;
          }
 
+         virtual const object&  load( const std::vector<char>& data )override
+         {
+            _dirty = true;
+            return load_object( fc::raw::unpack<object_type>( data ) );
+         }
+
 
          virtual const object&  create(const std::function<void(object&)>& constructor )override
          {
+            _dirty = true;
             const auto& result = DerivedIndex::create( constructor );
             for( const auto& item : _sindex )
                item->object_inserted( result );
@@ -396,6 +524,7 @@ namespace graphene { namespace db {
 
          virtual const object& insert( object&& obj ) override
          {
+            _dirty = true;
             const auto& result = DerivedIndex::insert( std::move( obj ) );
             for( const auto& item : _sindex )
                item->object_inserted( result );
@@ -405,6 +534,7 @@ namespace graphene { namespace db {
 
          virtual void  remove( const object& obj ) override
          {
+            _dirty = true;
             for( const auto& item : _sindex )
                item->object_removed( obj );
             on_remove(obj);
@@ -413,6 +543,7 @@ namespace graphene { namespace db {
 
          virtual void modify( const object& obj, const std::function<void(object&)>& m )override
          {
+            _dirty = true;
             save_undo( obj );
             for( const auto& item : _sindex )
                item->about_to_modify( obj );
@@ -422,6 +553,27 @@ namespace graphene { namespace db {
             on_modify( obj );
          }
 
+         /**
+          *  Secondary indexes keep the state seen in about_to_modify() until object_modified(), so they are still
+          *  notified object by object, observers are notified once all objects are modified.
+          */
+         virtual void modify_batch( const vector<const object*>& objs,
+                                    const std::function<void(object&)>& m )override
+         {
+            _dirty = true;
+            for( const object* obj : objs )
+            {
+               save_undo( *obj );
+               for( const auto& item : _sindex )
+                  item->about_to_modify( *obj );
+               DerivedIndex::modify( *obj, m );
+               for( const auto& item : _sindex )
+                  item->object_modified( *obj );
+            }
+            for( const object* obj : objs )
+               on_modify( *obj );
+         }
+
          virtual void add_observer( const shared_ptr<index_observer>& o ) override
          {
             _observers.emplace_back( o );
@@ -430,24 +582,42 @@ namespace graphene { namespace db {
          virtual void object_from_variant( const fc::variant& var, object& obj, uint32_t max_depth )const override
          {
             object_id_type id = obj.id;
+            const uint64_t undo_seq = obj.undo_seq;
             object_type* result = dynamic_cast<object_type*>( &obj );
             FC_ASSERT( result != nullptr );
             fc::from_variant( var, *result, max_depth );
             obj.id = id;
+            obj.undo_seq = undo_seq;
          }
 
          virtual void object_default( object& obj )const override
          {
             object_id_type id = obj.id;
+            const uint64_t undo_seq = obj.undo_seq;
             object_type* result = dynamic_cast<object_type*>( &obj );
             FC_ASSERT( result != nullptr );
             (*result) = object_type();
             obj.id = id;
+            obj.undo_seq = undo_seq;
          }
 
       private:
+         /** Inserts an object read from disk, without notifying observers or saving undo state */
+         const object& load_object( object_type&& obj )
+         {
+            const auto& result = DerivedIndex::insert( std::move(obj) );
+            for( const auto& item : _sindex )
+               item->object_inserted( result );
+            return result;
+         }
+
          object_id_type                                 _next_id;
+         /// Set on every change, cleared when the index is in sync with its file on disk
+         bool                                           _dirty = true;
          const direct_index< object_type, DirectBits >* _direct_by_id = nullptr;
    };
 
 } } // graphene::db
+
+FC_REFLECT( graphene::db::index_memory_stats,
+            (space_id)(type_id)(object_count)(object_size)(packed_bytes)(container_bytes)(estimated_bytes)(node_pool) )
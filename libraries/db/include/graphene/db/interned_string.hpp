@@ -0,0 +1,140 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <fc/variant.hpp>
+#include <fc/io/raw_fwd.hpp>
+#include <fc/reflect/typename.hpp>
+
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+
+namespace graphene { namespace db {
+
+   /**
+    * @class interned_string
+    * @brief A string value shared by all objects holding the same text
+    *
+    * Meant for low-cardinality fields, e.g. content types, which repeat across millions of objects. Each
+    * distinct value is stored once in a process-wide pool and objects only keep a pointer to it. Values are
+    * never released, so high-cardinality data such as URLs or hashes must stay plain strings.
+    *
+    * Interning is guarded by a mutex, reading an interned value is lock-free.
+    */
+   class interned_string
+   {
+      public:
+         interned_string() : _value( &empty() ) {}
+         interned_string( const std::string& s ) : _value( s.empty() ? &empty() : &intern( s ) ) {}
+         interned_string( const char* s ) : interned_string( std::string( s ) ) {}
+
+         interned_string& operator=( const std::string& s ) { return *this = interned_string( s ); }
+
+         const std::string& str()const { return *_value; }
+         operator const std::string&()const { return *_value; }
+
+         bool   empty()const { return _value->empty(); }
+         size_t size()const { return _value->size(); }
+
+         /**
+          * @brief Looks up a value without adding it to the pool
+          * @return false if no object holds @p s, i.e. it can not be equal to any interned_string in use
+          */
+         static bool find( const std::string& s, interned_string& result )
+         {
+            if( s.empty() )
+            {
+               result = interned_string();
+               return true;
+            }
+            std::lock_guard<std::mutex> guard( pool_mutex() );
+            auto itr = pool().find( s );
+            if( itr == pool().end() )
+               return false;
+            result._value = &(*itr);
+            return true;
+         }
+
+         /// Number of distinct values in the pool
+         static size_t pool_size()
+         {
+            std::lock_guard<std::mutex> guard( pool_mutex() );
+            return pool().size();
+         }
+
+         friend bool operator==( const interned_string& a, const interned_string& b ) { return a._value == b._value; }
+         friend bool operator!=( const interned_string& a, const interned_string& b ) { return a._value != b._value; }
+         friend bool operator<( const interned_string& a, const interned_string& b ) { return *a._value < *b._value; }
+         friend bool operator==( const interned_string& a, const std::string& b ) { return *a._value == b; }
+         friend bool operator==( const std::string& a, const interned_string& b ) { return a == *b._value; }
+         friend bool operator!=( const interned_string& a, const std::string& b ) { return *a._value != b; }
+         friend bool operator!=( const std::string& a, const interned_string& b ) { return a != *b._value; }
+
+         friend std::ostream& operator<<( std::ostream& o, const interned_string& s ) { return o << *s._value; }
+
+      private:
+         static const std::string& empty() { static const std::string e; return e; }
+
+         /// Elements of an unordered_set keep their address on rehash, so the pointers stay valid
+         static const std::string& intern( const std::string& s )
+         {
+            std::lock_guard<std::mutex> guard( pool_mutex() );
+            return *pool().insert( s ).first;
+         }
+
+         /// Intentionally leaked so that objects destroyed during static deinitialization stay valid
+         static std::unordered_set<std::string>& pool() { static auto* p = new std::unordered_set<std::string>(); return *p; }
+         static std::mutex& pool_mutex() { static std::mutex m; return m; }
+
+         const std::string* _value;
+   };
+
+} } // graphene::db
+
+namespace fc {
+
+   inline void to_variant( const graphene::db::interned_string& s, variant& v, uint32_t max_depth = 1 )
+   {
+      v = s.str();
+   }
+   inline void from_variant( const variant& v, graphene::db::interned_string& s, uint32_t max_depth = 1 )
+   {
+      s = v.as_string();
+   }
+
+   namespace raw {
+      template<typename Stream>
+      inline void pack( Stream& s, const graphene::db::interned_string& v, uint32_t _max_depth = FC_PACK_MAX_DEPTH )
+      {
+         fc::raw::pack( s, v.str(), _max_depth );
+      }
+      template<typename Stream>
+      inline void unpack( Stream& s, graphene::db::interned_string& v, uint32_t _max_depth = FC_PACK_MAX_DEPTH )
+      {
+         std::string tmp;
+         fc::raw::unpack( s, tmp, _max_depth );
+         v = tmp;
+      }
+   }
+
+   template<> struct get_typename<graphene::db::interned_string> { static const char* name() { return "string"; } };
+
+} // fc
@@ -0,0 +1,314 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <fc/reflect/reflect.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace graphene { namespace db {
+
+   /**
+    * @brief Usage statistics of the node pool(s) of an index
+    */
+   struct node_pool_stats
+   {
+      bool     enabled        = false; ///< whether nodes are allocated from the pool
+      uint64_t node_size      = 0;     ///< size of a single node in bytes
+      uint64_t live_nodes     = 0;     ///< nodes currently handed out
+      uint64_t free_nodes     = 0;     ///< nodes waiting for reuse
+      uint64_t chunks         = 0;     ///< number of slabs allocated
+      uint64_t reserved_bytes = 0;     ///< memory held by the slabs
+   };
+
+   /**
+    * @brief Memory the chunks of node pools are taken from
+    */
+   enum class node_pool_pages
+   {
+      heap,             ///< the global operator new
+      transparent_huge, ///< anonymous mappings advised to be backed by transparent huge pages
+      explicit_huge     ///< mappings of reserved huge pages, falls back to transparent_huge if none are available
+   };
+
+   /// Set where chunks of all node pools are allocated from, affects chunks allocated afterwards.
+   /// Huge pages are only supported on Linux, other platforms always use the heap.
+   void set_node_pool_pages( node_pool_pages pages );
+   node_pool_pages get_node_pool_pages();
+
+   namespace detail {
+      /// Memory of a node pool, can be larger than requested
+      struct node_pool_chunk
+      {
+         void*  data   = nullptr;
+         size_t size   = 0;
+         bool   mapped = false;
+      };
+      node_pool_chunk allocate_node_pool_chunk( size_t size );
+      void free_node_pool_chunk( const node_pool_chunk& chunk );
+   }
+
+   /**
+    * @class node_pool
+    * @brief A slab of fixed-size nodes
+    *
+    * Nodes are carved from large chunks and recycled through a free list. Memory is never returned to
+    * the system, which keeps nodes of one container close together and avoids heap fragmentation
+    * caused by millions of small allocations of different lifetime.
+    *
+    * A pool serves all containers of a node type in the process, which can be used by different threads, e.g. when
+    * indexes are loaded or saved in parallel, so all members take a lock.
+    */
+   class node_pool
+   {
+      public:
+         explicit node_pool( size_t node_size, size_t nodes_per_chunk = 4096 )
+         : _node_size( round_up( node_size < sizeof(free_node) ? sizeof(free_node) : node_size ) ),
+           _nodes_per_chunk( nodes_per_chunk ) {}
+
+         node_pool( const node_pool& ) = delete;
+         node_pool& operator=( const node_pool& ) = delete;
+
+         ~node_pool()
+         {
+            for( const auto& chunk : _chunks )
+               detail::free_node_pool_chunk( chunk );
+         }
+
+         void* allocate()
+         {
+            std::lock_guard<std::mutex> lock( _mutex );
+            if( _free == nullptr )
+               grow();
+            free_node* node = _free;
+            _free = node->next;
+            --_free_count;
+            ++_live_count;
+            return node;
+         }
+
+         /// Recycles a node of this pool
+         /// @return false if @p p was not allocated by this pool, e.g. before pooling was enabled, it is left alone
+         bool deallocate( void* p )
+         {
+            std::lock_guard<std::mutex> lock( _mutex );
+            if( !owns( p ) )
+               return false;
+            free_node* node = static_cast<free_node*>( p );
+            node->next = _free;
+            _free = node;
+            ++_free_count;
+            --_live_count;
+            return true;
+         }
+
+         size_t node_size()const { return _node_size; }
+
+         void add_stats( node_pool_stats& stats )const
+         {
+            std::lock_guard<std::mutex> lock( _mutex );
+            if( _node_size > stats.node_size )
+               stats.node_size = _node_size;
+            stats.live_nodes += _live_count;
+            stats.free_nodes += _free_count;
+            stats.chunks += _chunks.size();
+            for( const auto& chunk : _chunks )
+               stats.reserved_bytes += chunk.size;
+         }
+
+      private:
+         struct free_node { free_node* next; };
+
+         static size_t round_up( size_t size )
+         {
+            const size_t align = alignof(std::max_align_t);
+            return ( size + align - 1 ) / align * align;
+         }
+
+         bool owns( const void* p )const
+         {
+            const char* ptr = static_cast<const char*>( p );
+            auto itr = _chunk_ends.upper_bound( ptr );
+            return itr != _chunk_ends.end() && ptr >= itr->second;
+         }
+
+         void grow()
+         {
+            // chunks backed by huge pages are rounded up to whole pages, the nodes fill the whole chunk
+            const detail::node_pool_chunk chunk = detail::allocate_node_pool_chunk( _nodes_per_chunk * _node_size );
+            _chunks.push_back( chunk );
+            _chunk_ends[ static_cast<const char*>( chunk.data ) + chunk.size ] = static_cast<const char*>( chunk.data );
+            const size_t node_count = chunk.size / _node_size;
+            char* data = static_cast<char*>( chunk.data );
+            for( size_t i = node_count; i > 0; --i )
+            {
+               free_node* node = reinterpret_cast<free_node*>( data + ( i - 1 ) * _node_size );
+               node->next = _free;
+               _free = node;
+            }
+            _free_count += node_count;
+         }
+
+         const size_t        _node_size;
+         const size_t        _nodes_per_chunk;
+         mutable std::mutex  _mutex;
+         free_node*          _free = nullptr;
+         uint64_t            _free_count = 0;
+         uint64_t            _live_count = 0;
+         std::vector<detail::node_pool_chunk> _chunks;
+         /// the beginning of each chunk by its end, to find the chunk a node belongs to
+         std::map<const char*, const char*>  _chunk_ends;
+   };
+
+   /**
+    * @brief Process-wide switch and statistics of the pools used by node_allocators with the given tag
+    */
+   template<typename Tag>
+   struct node_pool_control
+   {
+      static bool enabled() { return enabled_flag(); }
+
+      /// Pooling can only be switched on, because nodes handed out by a pool must never be freed to the heap
+      static void enable() { enabled_flag() = true; }
+
+      static void register_pool( const node_pool* pool )
+      {
+         std::lock_guard<std::mutex> lock( pools_mutex() );
+         pools().push_back( pool );
+      }
+
+      static node_pool_stats stats()
+      {
+         node_pool_stats result;
+         result.enabled = enabled();
+         std::lock_guard<std::mutex> lock( pools_mutex() );
+         for( const node_pool* pool : pools() )
+            pool->add_stats( result );
+         return result;
+      }
+
+   private:
+      static std::atomic<bool>& enabled_flag() { static std::atomic<bool> flag{false}; return flag; }
+      static std::mutex& pools_mutex() { static std::mutex m; return m; }
+      static std::vector<const node_pool*>& pools() { static std::vector<const node_pool*> p; return p; }
+   };
+
+   /**
+    * @class node_allocator
+    * @brief An allocator for boost::multi_index containers that can take single nodes from a node_pool
+    *
+    * Until pooling is enabled for Tag, all requests are forwarded to the global operator new. Afterwards,
+    * single-node requests are served from a pool per node type, larger requests (e.g. hash buckets) still
+    * go to the heap.
+    *
+    * @tparam T the value type
+    * @tparam Tag identifies the pool group, preserved when the allocator is rebound to the container's node type
+    */
+   template<typename T, typename Tag = T>
+   class node_allocator
+   {
+      public:
+         typedef T                 value_type;
+         typedef T*                pointer;
+         typedef const T*          const_pointer;
+         typedef T&                reference;
+         typedef const T&          const_reference;
+         typedef std::size_t       size_type;
+         typedef std::ptrdiff_t    difference_type;
+
+         template<typename U>
+         struct rebind { typedef node_allocator<U, Tag> other; };
+
+         node_allocator() = default;
+         template<typename U>
+         node_allocator( const node_allocator<U, Tag>& ) {}
+
+         pointer allocate( size_type n, const void* = nullptr )
+         {
+            if( n == 1 && node_pool_control<Tag>::enabled() )
+               return static_cast<pointer>( pool().allocate() );
+            return static_cast<pointer>( ::operator new( n * sizeof(T) ) );
+         }
+
+         void deallocate( pointer p, size_type n )
+         {
+            // nodes allocated before pooling was enabled go back to the heap
+            if( n != 1 || !node_pool_control<Tag>::enabled() || !pool().deallocate( p ) )
+               ::operator delete( p );
+         }
+
+         size_type max_size()const { return std::numeric_limits<size_type>::max() / sizeof(T); }
+
+         pointer address( reference r )const { return &r; }
+         const_pointer address( const_reference r )const { return &r; }
+
+         template<typename U, typename... Args>
+         void construct( U* p, Args&&... args ) { ::new( static_cast<void*>(p) ) U( std::forward<Args>(args)... ); }
+
+         template<typename U>
+         void destroy( U* p ) { p->~U(); }
+
+      private:
+         /// Intentionally leaked so that containers destroyed during static deinitialization stay valid
+         static node_pool& pool()
+         {
+            static node_pool* p = []() {
+               node_pool* np = new node_pool( sizeof(T) );
+               node_pool_control<Tag>::register_pool( np );
+               return np;
+            }();
+            return *p;
+         }
+   };
+
+   template<typename T, typename U, typename Tag>
+   bool operator==( const node_allocator<T, Tag>&, const node_allocator<U, Tag>& ) { return true; }
+   template<typename T, typename U, typename Tag>
+   bool operator!=( const node_allocator<T, Tag>&, const node_allocator<U, Tag>& ) { return false; }
+
+   /**
+    * @brief Compile-time access to the pool of a container allocator, no-op for allocators other than node_allocator
+    */
+   template<typename Allocator>
+   struct node_pool_traits
+   {
+      static constexpr bool pooled = false;
+      static void enable() {}
+      static node_pool_stats stats() { return node_pool_stats(); }
+   };
+
+   template<typename T, typename Tag>
+   struct node_pool_traits< node_allocator<T, Tag> >
+   {
+      static constexpr bool pooled = true;
+      static void enable() { node_pool_control<Tag>::enable(); }
+      static node_pool_stats stats() { return node_pool_control<Tag>::stats(); }
+   };
+
+} } // graphene::db
+
+FC_REFLECT( graphene::db::node_pool_stats, (enabled)(node_size)(live_nodes)(free_nodes)(chunks)(reserved_bytes) )
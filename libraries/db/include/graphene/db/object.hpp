@@ -68,11 +68,19 @@ namespace graphene { namespace db {
          // serialized
          object_id_type          id;
 
+         /// Sequence number of the last change of this object recorded by the undo database, not serialized
+         mutable uint64_t        undo_seq = 0;
+
          /// these methods are implemented for derived classes by inheriting abstract_object<DerivedClass>
          virtual unique_ptr<object> clone()const = 0;
          virtual void               move_from( object& obj ) = 0;
          virtual variant            to_variant()const  = 0;
          virtual vector<char>       pack()const = 0;
+         /// replaces the content of this object with the object serialized in data, see @ref pack
+         virtual void               unpack_from( const vector<char>& data ) = 0;
+         /// whether @ref pack captures all of the state, objects with unreflected members must return false, so
+         /// that compact undo states keep copies of them instead
+         virtual bool               packs_whole_state()const { return true; }
    };
 
    /**
@@ -97,6 +105,10 @@ namespace graphene { namespace db {
          }
          virtual variant to_variant()const { return variant( static_cast<const DerivedClass&>(*this), MAX_NESTING ); }
          virtual vector<char> pack()const  { return fc::raw::pack( static_cast<const DerivedClass&>(*this) ); }
+         virtual void unpack_from( const vector<char>& data )
+         {
+            static_cast<DerivedClass&>(*this) = fc::raw::unpack<DerivedClass>( data );
+         }
    };
 
    typedef flat_map<uint8_t, object_id_type> annotation_map;
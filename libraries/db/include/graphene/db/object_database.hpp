@@ -25,6 +25,7 @@
 #include <graphene/db/object.hpp>
 #include <graphene/db/index.hpp>
 #include <graphene/db/undo_database.hpp>
+#include <graphene/db/state_hash_index.hpp>
 
 #include <fc/log/logger.hpp>
 
@@ -42,12 +43,14 @@ namespace graphene { namespace db {
          object_database();
          ~object_database();
 
-         void reset_indexes() { _index.clear(); _index.resize(255); }
+         void reset_indexes() { _index.clear(); _index.resize(255); _state_hash_indexes.clear(); }
 
          void open(const fc::path& data_dir );
 
          /**
-          * Saves the complete state of the object_database to disk, this could take a while
+          * Saves the complete state of the object_database to disk, this could take a while.
+          * Indexes that have not changed since they were last opened or saved are copied from the
+          * previous snapshot instead of being serialized again.
           */
          void flush();
          void wipe(const fc::path& data_dir); // remove from disk
@@ -90,6 +93,12 @@ namespace graphene { namespace db {
          void modify( const T& obj, const Lambda& m ) {
             get_mutable_index(obj.id).modify(obj,m);
          }
+         /// Applies @p m to all of @p objs, looking up their index and wrapping @p m only once
+         template<typename T, typename Lambda>
+         void modify_batch( const vector<const T*>& objs, const Lambda& m ) {
+            if( !objs.empty() )
+               get_mutable_index<T>().modify_batch( objs, m );
+         }
 
          ///@}
 
@@ -151,8 +160,47 @@ namespace graphene { namespace db {
 
          void pop_undo();
 
+         /**
+          * Switches an index to pooled node allocation. This affects all indexes of the object type in the process
+          * and should be done before the database is opened.
+          * @return true if nodes of the index are allocated from a pool
+          */
+         bool enable_node_pool( uint8_t space_id, uint8_t type_id )
+         { return get_mutable_index( space_id, type_id ).enable_node_pool(); }
+
+         /**
+          * Estimates the memory used by every index. This walks all objects of the database and takes long on a
+          * large database.
+          * @return The statistics of the indexes, largest first
+          */
+         vector<index_memory_stats> get_index_memory_stats()const;
+
+         /** @return the space and type IDs of all indexes */
+         vector< std::pair<uint8_t,uint8_t> > get_index_types()const;
+
+         /**
+          * Keeps a state hash of the objects of an index from now on, see @ref state_hash_index. The objects which
+          * exist already are hashed once, enabling it again does nothing.
+          */
+         void enable_state_hash( uint8_t space_id, uint8_t type_id );
+         /** @return the state hashes of the indexes with a state hash, in the order of their space and type IDs */
+         vector<index_state_hash> get_index_state_hashes()const;
+         /** @return the hash of the state hashes of all indexes with a state hash */
+         fc::sha256 get_state_hash()const;
+
          fc::path get_data_dir()const { return _data_dir; }
 
+         /**
+          * Creates a read-only view of the current state, which stays consistent while the database changes.
+          * @see object_view
+          */
+         std::shared_ptr<object_view> create_view()
+         {
+            auto view = std::make_shared<object_view>( *this );
+            _undo_db.add_view( view );
+            return view;
+         }
+
          /** public for testing purposes only... should be private in practice. */
          undo_database                          _undo_db;
      protected:
@@ -176,6 +224,8 @@ namespace graphene { namespace db {
 
          fc::path                                                  _data_dir;
          vector< vector< unique_ptr<index> > >                     _index;
+         /// the state hash indexes, by space and type ID
+         std::map< std::pair<uint8_t,uint8_t>, const state_hash_index* > _state_hash_indexes;
    };
 
 } } // graphene::db
@@ -0,0 +1,80 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <graphene/db/object.hpp>
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+namespace graphene { namespace db {
+
+   class object_database;
+
+   /**
+    * @class object_view
+    * @brief A read-only view of the object database as it was when the view was created
+    *
+    * While a view is alive, the undo database hands it the first pre-modification value of every object which is
+    * modified or removed afterwards, and the IDs of the objects created afterwards, whether the change is recorded
+    * for undo or not. So the view keeps serving the old state while blocks are applied, popped or replayed, and
+    * long-running readers like exports don't need to stop the chain.
+    *
+    * Only objects which change are copied, but all of them are copied once, so a view should not be kept longer
+    * than needed. Views must be read on the thread which modifies the database, E.G. from a task which yields
+    * between reads.
+    */
+   class object_view
+   {
+      public:
+         explicit object_view( const object_database& db ) : _db( db ) {}
+
+         /** @return the object with @p id as it was when the view was created, or nullptr if it did not exist */
+         const object* find_object( object_id_type id )const;
+
+         template<typename T>
+         const T* find( object_id_type id )const
+         {
+            const object* obj = find_object( id );
+            assert( !obj || nullptr != dynamic_cast<const T*>(obj) );
+            return static_cast<const T*>(obj);
+         }
+
+         /**
+          * Calls @p inspector for all objects of an index as they were when the view was created. Objects which have
+          * been changed since then are visited after the others.
+          */
+         void inspect_all_objects( uint8_t space_id, uint8_t type_id,
+                                   const std::function<void(const object&)>& inspector )const;
+
+         /** @return the number of saved old values and created objects */
+         size_t saved_count()const { return _saved.size(); }
+
+      private:
+         friend class undo_database;
+         void on_create( const object& obj );
+         void on_modify( const object& obj );
+
+         const object_database&                                 _db;
+         /// pre-modification values, null for objects created after the view
+         std::unordered_map<object_id_type, unique_ptr<object>> _saved;
+   };
+
+} } // graphene::db
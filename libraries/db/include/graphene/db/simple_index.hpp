@@ -24,15 +24,23 @@
 #pragma once
 #include <graphene/db/index.hpp>
 
+#include <algorithm>
+#include <bitset>
+#include <new>
+#include <type_traits>
+
 namespace graphene { namespace db {
 
    /**
     *  @class simple_index
-    *  @brief A simple index uses a vector<unique_ptr<T>> to store data
+    *  @brief A simple index stores data in pages of contiguous slots indexed by instance
     *
     *  This index is preferred in situations where the data will never be
     *  removed from main memory and when access by ID is the only kind
     *  of access that is necessary.
+    *
+    *  Objects never move once created, a removed object only leaves an empty slot behind, so iterating over all
+    *  objects walks memory in order instead of following one heap pointer per object.
     */
    template<typename T>
    class simple_index : public index
@@ -40,42 +48,56 @@ namespace graphene { namespace db {
       public:
          typedef T object_type;
 
+         /// Number of object slots in a page
+         static constexpr size_t page_size = 64;
+
+         simple_index() = default;
+         simple_index( const simple_index& ) = delete;
+         simple_index& operator=( const simple_index& ) = delete;
+         virtual ~simple_index() override
+         {
+            for( size_t instance = 0; instance < _size; ++instance )
+               if( is_live( instance ) )
+                  slot( instance )->~T();
+         }
+
          virtual const object&  create( const std::function<void(object&)>& constructor ) override
          {
              auto id = get_next_id();
              auto instance = id.instance();
-             if( instance >= _objects.size() ) _objects.resize( instance + 1 );
-             _objects[instance] = std::make_unique<T>();
-             _objects[instance]->id = id;
-             constructor( *_objects[instance] );
-             _objects[instance]->id = id; // just in case it changed
+             T* obj = emplace( instance );
+             obj->id = id;
+             constructor( *obj );
+             obj->id = id; // just in case it changed
              use_next_id();
-             return *_objects[instance];
+             return *obj;
          }
 
          virtual void modify( const object& obj, const std::function<void(object&)>& modify_callback ) override
          {
-            assert( obj.id.instance() < _objects.size() );
-            modify_callback( *_objects[obj.id.instance()] );
+            assert( is_live( obj.id.instance() ) );
+            modify_callback( *slot( obj.id.instance() ) );
          }
 
          virtual const object& insert( object&& obj )override
          {
             auto instance = obj.id.instance();
             assert( nullptr != dynamic_cast<T*>(&obj) );
-            if( _objects.size() <= instance ) _objects.resize( instance+1 );
-            assert( !_objects[instance] );
-            _objects[instance] = std::make_unique<T>( std::move( static_cast<T&>(obj) ) );
-            return *_objects[instance];
+            assert( !is_live( instance ) );
+            return *emplace( instance, std::move( static_cast<T&>(obj) ) );
          }
 
          virtual void remove( const object& obj ) override
          {
             assert( nullptr != dynamic_cast<const T*>(&obj) );
             const auto instance = obj.id.instance();
-            _objects[instance].reset();
-            while( (_objects.size() > 0) && (_objects.back() == nullptr) )
-               _objects.pop_back();
+            if( !is_live( instance ) )
+               return;
+            slot( instance )->~T();
+            _pages[ instance / page_size ]->live.reset( instance % page_size );
+            while( _size > 0 && !is_live( _size - 1 ) )
+               --_size;
+            _pages.resize( ( _size + page_size - 1 ) / page_size );
          }
 
          virtual const object* find( object_id_type id )const override
@@ -84,17 +106,43 @@ namespace graphene { namespace db {
             assert( id.type() == T::type_id );
 
             const auto instance = id.instance();
-            if( instance >= _objects.size() ) return nullptr;
-            return _objects[instance].get();
+            if( !is_live( instance ) ) return nullptr;
+            return slot( instance );
          }
 
          virtual void inspect_all_objects(std::function<void (const object&)> inspector)const override
          {
             try {
-               for( const auto& ptr : _objects )
+               for( size_t instance = 0; instance < _size; ++instance )
+               {
+                  if( is_live( instance ) )
+                     inspector( *slot( instance ) );
+               }
+            } FC_CAPTURE_AND_RETHROW()
+         }
+
+         /// Same as @ref inspect_all_objects, but calls @p visitor directly with the objects of their own type
+         template<typename Visitor>
+         void for_each_object( Visitor&& visitor )const
+         {
+            for_each_object( 0, _size, std::forward<Visitor>( visitor ) );
+         }
+
+         /**
+          * @brief Calls @p visitor with the objects whose instances are in [@p first, @p last)
+          *
+          * Ranges which do not overlap can be visited concurrently as long as nothing modifies the index, E.G. to split
+          * a read-only scan into chunks of @ref page_size objects.
+          */
+         template<typename Visitor>
+         void for_each_object( size_t first, size_t last, Visitor&& visitor )const
+         {
+            try {
+               last = std::min( last, _size );
+               for( size_t instance = first; instance < last; ++instance )
                {
-                  if( ptr.get() )
-                     inspector(*ptr);
+                  if( is_live( instance ) )
+                     visitor( static_cast<const T&>( *slot( instance ) ) );
                }
             } FC_CAPTURE_AND_RETHROW()
          }
@@ -102,13 +150,11 @@ namespace graphene { namespace db {
          class const_iterator
          {
             public:
-               const_iterator( const vector<unique_ptr<object>>& objects ):_objects(objects) {}
-               const_iterator(
-                  const vector<unique_ptr<object>>& objects,
-                  const vector<unique_ptr<object>>::const_iterator& a ):_itr(a),_objects(objects){}
-               friend bool operator==( const const_iterator& a, const const_iterator& b ) { return a._itr == b._itr; }
-               friend bool operator!=( const const_iterator& a, const const_iterator& b ) { return a._itr != b._itr; }
-               const T& operator*()const { return static_cast<const T&>(*_itr->get()); }
+               const_iterator( const simple_index& idx, size_t instance ):_instance(instance),_index(&idx) {}
+               friend bool operator==( const const_iterator& a, const const_iterator& b ) { return a._instance == b._instance; }
+               friend bool operator!=( const const_iterator& a, const const_iterator& b ) { return a._instance != b._instance; }
+               const T& operator*()const { return *_index->slot( _instance ); }
+               const T* operator->()const { return _index->slot( _instance ); }
                const_iterator operator++(int)     // postfix
                {
                   const_iterator result( *this );
@@ -117,26 +163,80 @@ namespace graphene { namespace db {
                }
                const_iterator& operator++()       // prefix
                {
-                  ++_itr;
-                  while( (_itr != _objects.end()) && ( (*_itr) == nullptr ) )
-                     ++_itr;
+                  ++_instance;
+                  while( (_instance < _index->_size) && !_index->is_live( _instance ) )
+                     ++_instance;
                   return *this;
                }
                typedef std::forward_iterator_tag iterator_category;
-               typedef vector<unique_ptr<object> >::value_type value_type;
-               typedef vector<unique_ptr<object> >::difference_type difference_type;
-               typedef vector<unique_ptr<object> >::pointer pointer;
-               typedef vector<unique_ptr<object> >::reference reference;
+               typedef T value_type;
+               typedef std::ptrdiff_t difference_type;
+               typedef const T* pointer;
+               typedef const T& reference;
             private:
-               vector<unique_ptr<object>>::const_iterator _itr;
-               const vector<unique_ptr<object>>& _objects;
+               size_t             _instance;
+               const simple_index* _index;
          };
-         const_iterator begin()const { return const_iterator(_objects, _objects.begin()); }
-         const_iterator end()const   { return const_iterator(_objects, _objects.end());   }
+         const_iterator begin()const
+         {
+            size_t instance = 0;
+            while( instance < _size && !is_live( instance ) )
+               ++instance;
+            return const_iterator( *this, instance );
+         }
+         const_iterator end()const   { return const_iterator( *this, _size ); }
 
-         size_t size()const { return _objects.size(); }
+         size_t size()const { return _size; }
+
+         virtual uint64_t get_container_overhead( uint64_t object_count )const override
+         {
+            // unused slots of the pages and the page table
+            return ( _pages.size() * page_size - object_count ) * sizeof( T )
+                   + _pages.size() * ( sizeof( std::bitset<page_size> ) + sizeof( unique_ptr<page> ) );
+         }
       private:
-         vector< unique_ptr<object> > _objects;
+         struct page
+         {
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type slots[page_size];
+            std::bitset<page_size>                                      live;
+         };
+
+         bool is_live( size_t instance )const
+         {
+            return instance < _size && _pages[ instance / page_size ]->live.test( instance % page_size );
+         }
+         T* slot( size_t instance )const
+         {
+            return reinterpret_cast<T*>( &_pages[ instance / page_size ]->slots[ instance % page_size ] );
+         }
+
+         /// Constructs an object in the slot of @p instance, replacing the one already there if any
+         template<typename... Args>
+         T* emplace( size_t instance, Args&&... args )
+         {
+            if( instance >= _pages.size() * page_size )
+            {
+               const size_t page_count = instance / page_size + 1;
+               while( _pages.size() < page_count )
+                  _pages.push_back( std::make_unique<page>() );
+            }
+            page& p = *_pages[ instance / page_size ];
+            T* obj = slot( instance );
+            if( instance < _size && p.live.test( instance % page_size ) )
+            {
+               obj->~T();
+               p.live.reset( instance % page_size );
+            }
+            new( obj ) T( std::forward<Args>( args )... );
+            p.live.set( instance % page_size );
+            if( instance >= _size )
+               _size = instance + 1;
+            return obj;
+         }
+
+         vector< unique_ptr<page> > _pages;
+         /// One past the highest instance in use
+         size_t                     _size = 0;
    };
 
 } } // graphene::db
@@ -0,0 +1,69 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <graphene/db/index.hpp>
+
+#include <fc/crypto/sha256.hpp>
+
+namespace graphene { namespace db {
+
+   /// The state hash of the objects of an index
+   struct index_state_hash
+   {
+      uint8_t     space_id = 0;
+      uint8_t     type_id = 0;
+      uint64_t    object_count = 0;
+      fc::sha256  hash;
+   };
+
+   /**
+    * @class state_hash_index
+    * @brief A secondary index which keeps an order-independent hash of all objects of its primary index
+    *
+    * The hash is the sum of the SHA256 hashes of the packed objects, taken as four 64 bit words each. Objects are
+    * added and subtracted as they are created, modified and removed, also when changes are undone, so the hash
+    * is always that of the current objects and never needs a scan of the index.
+    */
+   class state_hash_index : public secondary_index
+   {
+      public:
+         state_hash_index( uint8_t space_id, uint8_t type_id )
+         {
+            _state.space_id = space_id;
+            _state.type_id = type_id;
+         }
+
+         virtual void object_inserted( const object& obj )override;
+         virtual void object_removed( const object& obj )override;
+         virtual void about_to_modify( const object& before )override;
+         virtual void object_modified( const object& after )override;
+
+         const index_state_hash& get_state()const { return _state; }
+
+      private:
+         void add( const object& obj );
+         void subtract( const object& obj );
+
+         index_state_hash _state;
+   };
+
+} } // graphene::db
+
+FC_REFLECT( graphene::db::index_state_hash, (space_id)(type_id)(object_count)(hash) )
@@ -0,0 +1,188 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <fc/exception/exception.hpp>
+#include <fc/reflect/reflect.hpp>
+#include <fc/thread/future.hpp>
+#include <fc/time.hpp>
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace graphene { namespace db {
+
+   /// Queued tasks of a higher priority are started first, tasks of the same priority in the order they were queued
+   enum class task_priority
+   {
+      high = 0,   ///< latency critical work, e.g. precomputing incoming blocks and transactions
+      normal = 1,
+      low = 2     ///< background work, e.g. saving the object database
+   };
+
+   struct task_priority_stats
+   {
+      uint64_t queued        = 0; ///< tasks waiting for a worker
+      uint64_t completed     = 0;
+      uint64_t total_wait_us = 0; ///< time completed tasks waited for a worker
+      uint64_t max_wait_us   = 0;
+      uint64_t total_run_us  = 0;
+   };
+
+   struct task_pool_stats
+   {
+      uint32_t            threads = 0;
+      uint32_t            busy    = 0; ///< workers running a task
+      task_priority_stats high;
+      task_priority_stats normal;
+      task_priority_stats low;
+   };
+
+   /**
+    * @brief The worker threads which run the parallel work of the chain
+    *
+    * Like fc::do_parallel(), but the number of workers is configurable, queued tasks are ordered by priority and
+    * the queue is observable. Results are returned through fc futures, so that waiting for them does not block
+    * other tasks of an fc thread.
+    *
+    * The workers share a single queue. Tasks are coarse, i.e. whole chunks of a block or whole indexes, so a worker
+    * takes the lock once per task only.
+    */
+   class task_pool
+   {
+      public:
+         /// The pool of the process
+         static task_pool& instance();
+
+         task_pool() = default;
+         task_pool( const task_pool& ) = delete;
+         task_pool& operator=( const task_pool& ) = delete;
+         ~task_pool();
+
+         /// Set the number of workers, 0 for the number of fc IO threads, only possible before the workers started
+         void set_thread_count( uint32_t count );
+         uint32_t thread_count()const;
+
+         /// Start the workers if not running yet, they inherit the CPU affinity of the calling thread
+         void start();
+
+         template<typename Functor>
+         auto run( Functor&& f, task_priority priority = task_priority::normal ) -> fc::future<decltype(f())>
+         {
+            typedef decltype(f()) result_type;
+            auto promise = fc::promise<result_type>::create( "graphene::db::task_pool::run" );
+            enqueue( [promise, f = std::forward<Functor>(f)]() mutable {
+               try
+               {
+                  complete( *promise, f );
+               }
+               catch( const fc::exception& e )
+               {
+                  promise->set_exception( e.dynamic_copy_exception() );
+               }
+               catch( const std::exception& e )
+               {
+                  promise->set_exception( std::make_shared<fc::unhandled_exception>(
+                        FC_LOG_MESSAGE( warn, "${what}", ("what",e.what()) ), std::current_exception() ) );
+               }
+               catch( ... )
+               {
+                  promise->set_exception( std::make_shared<fc::unhandled_exception>(
+                        FC_LOG_MESSAGE( warn, "unhandled exception" ), std::current_exception() ) );
+               }
+            }, priority );
+            return fc::future<result_type>( promise );
+         }
+
+         /**
+          * Runs @p work( i ) for each i in [0, count) on the workers and blocks the calling thread until all of
+          * them are done, then rethrows the first exception thrown by any of them.
+          *
+          * This is for work which reads the database, which must not change meanwhile. Waiting on fc futures
+          * would yield to other tasks of the calling fc thread, so the tasks report through std::promise instead.
+          * The tasks use data of the caller, so the call only returns or throws after every task has finished.
+          */
+         template<typename Work>
+         void run_and_wait( size_t count, const Work& work, task_priority priority = task_priority::normal )
+         {
+            std::vector<std::promise<void>> done( count );
+            for( size_t i = 0; i < count; ++i )
+               run( [&work,&done,i] () {
+                  try
+                  {
+                     work( i );
+                     done[i].set_value();
+                  }
+                  catch( ... )
+                  {
+                     done[i].set_exception( std::current_exception() );
+                  }
+               }, priority );
+            std::vector<std::future<void>> results;
+            results.reserve( count );
+            for( auto& d : done )
+            {
+               results.push_back( d.get_future() );
+               results.back().wait();
+            }
+            for( auto& r : results )
+               r.get();
+         }
+
+         task_pool_stats get_stats()const;
+         /// Clear the counters of completed tasks
+         void reset_stats();
+
+      private:
+         struct queued_task
+         {
+            std::function<void()> work;
+            fc::time_point        queued;
+         };
+         static constexpr size_t priority_count = 3;
+
+         template<typename Result, typename Functor>
+         static void complete( fc::promise<Result>& promise, Functor& f ) { promise.set_value( f() ); }
+         template<typename Functor>
+         static void complete( fc::promise<void>& promise, Functor& f ) { f(); promise.set_value(); }
+
+         void enqueue( std::function<void()> work, task_priority priority );
+         void start_locked();
+         void worker_loop();
+
+         mutable std::mutex                                    _mutex;
+         std::condition_variable                               _wakeup;
+         std::array<std::deque<queued_task>, priority_count>   _queues;
+         std::array<task_priority_stats, priority_count>       _stats;
+         std::vector<std::thread>                              _threads;
+         uint32_t                                              _thread_count = 0;
+         uint32_t                                              _busy = 0;
+         bool                                                  _stopping = false;
+   };
+
+} } // graphene::db
+
+FC_REFLECT( graphene::db::task_priority_stats, (queued)(completed)(total_wait_us)(max_wait_us)(total_run_us) )
+FC_REFLECT( graphene::db::task_pool_stats, (threads)(busy)(high)(normal)(low) )
@@ -23,21 +23,60 @@
  */
 #pragma once
 #include <graphene/db/object.hpp>
+#include <graphene/db/object_view.hpp>
 #include <deque>
 #include <fc/exception/exception.hpp>
 
 namespace graphene { namespace db {
 
    using std::unordered_map;
+   using fc::flat_map;
    using fc::flat_set;
    class object_database;
 
+   /// The change of an object within an undo state, an object has at most one change per state
+   struct undo_entry
+   {
+      enum kind_type : uint8_t
+      {
+         created,  ///< the object did not exist before the state
+         modified, ///< old_value or packed_old_value holds the value from before the state
+         removed,  ///< old_value holds the value from before the state
+         merged,   ///< the change is recorded by the entry prior_seq refers to, left by undo_database::merge
+         dropped   ///< the object was created and removed again within the state
+      };
+
+      object_id_type      id;
+      /// sequence number of the entry, the object's undo_seq refers to its entry in the head state
+      uint64_t            seq = 0;
+      /// undo_seq of the object before this entry was recorded, for merged entries the entry holding the change
+      uint64_t            prior_seq = 0;
+      kind_type           kind = created;
+      unique_ptr<object>  old_value;
+      /// pre-modification value in serialized form, used instead of old_value in compact mode
+      vector<char>        packed_old_value;
+   };
+
    struct undo_state
    {
-      unordered_map<object_id_type, unique_ptr<object> > old_values;
-      unordered_map<object_id_type, object_id_type>      old_index_next_ids;
-      std::unordered_set<object_id_type>                 new_ids;
-      unordered_map<object_id_type, unique_ptr<object> > removed;
+      /// The changes in the order they were recorded, i. e. sorted by seq
+      vector<undo_entry>                         changes;
+      /// Entries of this state have sequence numbers from here on
+      uint64_t                                   first_seq = 0;
+      flat_map<object_id_type, object_id_type>   old_index_next_ids;
+      /// whether old values have been converted to serialized form, see undo_database::set_compact_depth
+      bool                                       compacted = false;
+
+      /**
+       * @return the entry of the object @p id which sequence number @p seq refers to, following merged entries,
+       *         or null if the object has no entry in this state
+       */
+      undo_entry* find( uint64_t seq, const object_id_type& id );
+
+      /// @return the number of entries of the given kind
+      size_t count( undo_entry::kind_type kind )const;
+      /// @return the number of old values in serialized form
+      size_t packed_count()const;
    };
 
 
@@ -85,6 +124,26 @@ namespace graphene { namespace db {
          void    enable();
          bool    enabled()const { return !_disabled; }
 
+         /**
+          * In compact mode the pre-modification value of an object is saved in serialized form instead of as a
+          * copy of the object. This needs less memory and fewer allocations for large objects, at the cost of
+          * unpacking the value if it is undone. Can be switched at any time, states may contain both forms.
+          * Objects which don't serialize all of their state, see object::packs_whole_state, are always copied.
+          */
+         void    set_compact( bool compact ) { _compact = compact; }
+         bool    compact()const { return _compact; }
+
+         /**
+          * States deeper than @p depth in the stack are converted to compact form when a new session is started.
+          * Deep states are only needed when switching to a long fork, so keeping them as serialized values bounds
+          * the memory used by long undo histories, e.g. while irreversibility is stalled. 0 disables conversion.
+          */
+         void    set_compact_depth( size_t depth ) { _compact_depth = depth; }
+         size_t  compact_depth()const { return _compact_depth; }
+
+         /** @return the total size of all serialized old values in the stack */
+         size_t  packed_size()const;
+
          session start_undo_session( bool force_enable = false );
          /**
           * This should be called just after an object is created
@@ -123,16 +182,39 @@ namespace graphene { namespace db {
 
          const undo_state& head()const;
 
+         /**
+          * Makes @p view receive the changes of the database from now on, until it is destroyed. Changes are handed
+          * to views even while undo is disabled.
+          */
+         void add_view( const std::shared_ptr<object_view>& view );
+
       private:
+         template<typename Callback>
+         void notify_views( const Callback& callback );
+
          void undo();
          void merge();
          void commit();
+         /// the state changes are recorded in, started if there is none
+         undo_state& head_state();
+         /// appends an entry for @p obj to @p state, the caller tags the object with the entry afterwards
+         undo_entry& record( undo_state& state, const object& obj, undo_entry::kind_type kind );
+         /// restores the objects to their values before @p state
+         void apply_undo( undo_state& state );
+         /// replaces all copies of old values in the state by their serialized form
+         static void compact_state( undo_state& state );
 
          uint32_t                _active_sessions = 0;
          bool                    _disabled = true;
+         bool                    _compact = false;
+         size_t                  _compact_depth = 0;
          std::deque<undo_state>  _stack;
+         std::vector< std::weak_ptr<object_view> > _views;
          object_database&        _db;
          size_t                  _max_size = 256;
+         /// sequence number of the next entry, never reused, so that undo_seq of objects can not refer to
+         /// entries of states which were undone or discarded
+         uint64_t                _next_seq = 1;
    };
 
 } } // graphene::db
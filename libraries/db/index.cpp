@@ -25,7 +25,101 @@
 #include <graphene/db/index.hpp>
 #include <graphene/db/object_database.hpp>
 
+#include <boost/crc.hpp>
+#include <boost/endian/buffers.hpp>
+
+#include <cstring>
+
+#ifdef GRAPHENE_DB_FILE_COMPRESSION
+#include <zlib.h>
+#endif
+
 namespace graphene { namespace db {
+   namespace {
+
+   /// Precedes the stored records of a chunk of an index file
+   struct file_chunk_header
+   {
+      boost::endian::little_uint32_buf_t stored_size;
+      boost::endian::little_uint32_buf_t raw_size;
+      boost::endian::little_uint32_buf_t checksum;    ///< CRC-32 of the uncompressed records
+      uint8_t                            compression; ///< one of file_chunk_compression
+   };
+
+   enum file_chunk_compression : uint8_t
+   {
+      chunk_uncompressed = 0,
+      chunk_zlib = 1
+   };
+
+   uint32_t file_chunk_checksum( const char* data, size_t size )
+   {
+      boost::crc_32_type crc;
+      crc.process_bytes( data, size );
+      return crc.checksum();
+   }
+
+   } // anonymous namespace
+
+   void base_primary_index::write_file_chunk( std::ostream& out, const vector<char>& records )
+   {
+      file_chunk_header header;
+      header.raw_size = records.size();
+      header.checksum = file_chunk_checksum( records.data(), records.size() );
+      header.compression = chunk_uncompressed;
+      const char* stored = records.data();
+      header.stored_size = records.size();
+#ifdef GRAPHENE_DB_FILE_COMPRESSION
+      // favour speed, the files are written when the node shuts down and at replay checkpoints
+      vector<char> compressed( compressBound( records.size() ) );
+      uLongf size = compressed.size();
+      if( compress2( (Bytef*)compressed.data(), &size, (const Bytef*)records.data(), records.size(),
+                     Z_BEST_SPEED ) == Z_OK && size < records.size() )
+      {
+         header.compression = chunk_zlib;
+         header.stored_size = size;
+         stored = compressed.data();
+      }
+#endif
+      out.write( (const char*)&header, sizeof(header) );
+      out.write( stored, header.stored_size.value() );
+   }
+
+   fc::datastream<const char*> base_primary_index::read_file_chunk( fc::datastream<const char*>& in,
+                                                                    vector<char>& buffer, const path& file,
+                                                                    uint32_t chunk_num )
+   {
+      file_chunk_header header;
+      FC_ASSERT( in.remaining() >= sizeof(header), "Truncated chunk ${n} in ${f}",
+                 ("n",chunk_num)("f",file.generic_string()) );
+      memcpy( (char*)&header, in.pos(), sizeof(header) );
+      in.skip( sizeof(header) );
+      FC_ASSERT( header.stored_size.value() <= in.remaining(), "Truncated chunk ${n} in ${f}",
+                 ("n",chunk_num)("f",file.generic_string()) );
+      const char* records = in.pos();
+      in.skip( header.stored_size.value() );
+      if( header.compression == chunk_zlib )
+      {
+#ifdef GRAPHENE_DB_FILE_COMPRESSION
+         buffer.resize( header.raw_size.value() );
+         uLongf size = buffer.size();
+         FC_ASSERT( uncompress( (Bytef*)buffer.data(), &size, (const Bytef*)records,
+                                header.stored_size.value() ) == Z_OK && size == buffer.size(),
+                    "Corrupt chunk ${n} in ${f}", ("n",chunk_num)("f",file.generic_string()) );
+         records = buffer.data();
+#else
+         FC_THROW( "Chunk ${n} in ${f} is compressed, but compression is not supported by this build",
+                   ("n",chunk_num)("f",file.generic_string()) );
+#endif
+      }
+      else
+         FC_ASSERT( header.compression == chunk_uncompressed && header.stored_size.value() == header.raw_size.value(),
+                    "Corrupt chunk ${n} in ${f}", ("n",chunk_num)("f",file.generic_string()) );
+      FC_ASSERT( file_chunk_checksum( records, header.raw_size.value() ) == header.checksum.value(),
+                 "Checksum mismatch in chunk ${n} of ${f}", ("n",chunk_num)("f",file.generic_string()) );
+      return fc::datastream<const char*>( records, header.raw_size.value() );
+   }
+
    void base_primary_index::save_undo( const object& obj )
    { _db.save_undo( obj ); }
 
@@ -0,0 +1,105 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <graphene/db/node_allocator.hpp>
+
+#include <fc/log/logger.hpp>
+
+#include <atomic>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace graphene { namespace db {
+
+namespace {
+   std::atomic<node_pool_pages> current_pages { node_pool_pages::heap };
+
+   const size_t huge_page_size = 2 * 1024 * 1024;
+}
+
+void set_node_pool_pages( node_pool_pages pages )
+{
+#ifndef __linux__
+   if( pages != node_pool_pages::heap )
+   {
+      wlog( "Huge pages for node pools are not supported on this platform" );
+      return;
+   }
+#endif
+   current_pages = pages;
+}
+
+node_pool_pages get_node_pool_pages()
+{
+   return current_pages;
+}
+
+namespace detail {
+
+node_pool_chunk allocate_node_pool_chunk( size_t size )
+{
+   node_pool_chunk chunk;
+   const node_pool_pages pages = current_pages;
+#ifdef __linux__
+   if( pages != node_pool_pages::heap )
+   {
+      const size_t mapped_size = ( size + huge_page_size - 1 ) / huge_page_size * huge_page_size;
+      void* data = MAP_FAILED;
+#ifdef MAP_HUGETLB
+      if( pages == node_pool_pages::explicit_huge )
+         data = mmap( nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                      -1, 0 );
+#endif
+      if( data == MAP_FAILED )
+      {
+         data = mmap( nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+#ifdef MADV_HUGEPAGE
+         if( data != MAP_FAILED )
+            madvise( data, mapped_size, MADV_HUGEPAGE );
+#endif
+      }
+      if( data == MAP_FAILED )
+         throw std::bad_alloc();
+      chunk.data = data;
+      chunk.size = mapped_size;
+      chunk.mapped = true;
+      return chunk;
+   }
+#endif
+   chunk.data = ::operator new( size );
+   chunk.size = size;
+   return chunk;
+}
+
+void free_node_pool_chunk( const node_pool_chunk& chunk )
+{
+#ifdef __linux__
+   if( chunk.mapped )
+   {
+      munmap( chunk.data, chunk.size );
+      return;
+   }
+#endif
+   ::operator delete( chunk.data );
+}
+
+} // detail
+
+} } // graphene::db
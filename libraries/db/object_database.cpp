@@ -25,7 +25,10 @@
 
 #include <fc/io/raw.hpp>
 #include <fc/container/flat.hpp>
-#include <fc/thread/parallel.hpp>
+#include <graphene/db/task_pool.hpp>
+
+#include <algorithm>
+#include <atomic>
 
 namespace graphene { namespace db {
 
@@ -59,6 +62,55 @@ const index& object_database::get_index(uint8_t space_id, uint8_t type_id)const
    FC_ASSERT( tmp );
    return *tmp;
 }
+vector<index_memory_stats> object_database::get_index_memory_stats()const
+{
+   vector<index_memory_stats> result;
+   for( const auto& space : _index )
+      for( const auto& idx : space )
+         if( idx )
+            result.push_back( idx->get_memory_stats() );
+   std::sort( result.begin(), result.end(), []( const index_memory_stats& a, const index_memory_stats& b ) {
+      return a.estimated_bytes > b.estimated_bytes;
+   });
+   return result;
+}
+
+vector< std::pair<uint8_t,uint8_t> > object_database::get_index_types()const
+{
+   vector< std::pair<uint8_t,uint8_t> > result;
+   for( const auto& space : _index )
+      for( const auto& idx : space )
+         if( idx )
+            result.emplace_back( idx->object_space_id(), idx->object_type_id() );
+   return result;
+}
+
+void object_database::enable_state_hash( uint8_t space_id, uint8_t type_id )
+{
+   if( _state_hash_indexes.find( std::make_pair( space_id, type_id ) ) != _state_hash_indexes.end() )
+      return;
+   index& idx = get_mutable_index( space_id, type_id );
+   auto* primary = dynamic_cast<base_primary_index*>( &idx );
+   FC_ASSERT( primary != nullptr, "Not a primary index", ("space_id",space_id)("type_id",type_id) );
+   auto* hash_index = primary->add_secondary_index<state_hash_index>( space_id, type_id );
+   idx.inspect_all_objects( [hash_index]( const object& obj ) { hash_index->object_inserted( obj ); } );
+   _state_hash_indexes[ std::make_pair( space_id, type_id ) ] = hash_index;
+}
+
+vector<index_state_hash> object_database::get_index_state_hashes()const
+{
+   vector<index_state_hash> result;
+   result.reserve( _state_hash_indexes.size() );
+   for( const auto& item : _state_hash_indexes )
+      result.push_back( item.second->get_state() );
+   return result;
+}
+
+fc::sha256 object_database::get_state_hash()const
+{
+   return fc::sha256::hash( get_index_state_hashes() );
+}
+
 index& object_database::get_mutable_index(uint8_t space_id, uint8_t type_id)
 {
    FC_ASSERT( _index.size() > space_id, "", ("space_id",space_id)("type_id",type_id)("index.size",_index.size()) );
@@ -71,26 +123,46 @@ index& object_database::get_mutable_index(uint8_t space_id, uint8_t type_id)
 void object_database::flush()
 {
 //   ilog("Save object_database in ${d}", ("d", _data_dir));
-   fc::create_directories( _data_dir / "object_database.tmp" / "lock" );
+   const fc::path old_dir = _data_dir / "object_database";
+   const fc::path tmp_dir = _data_dir / "object_database.tmp";
+   // Indexes which are unchanged since they were last opened or saved are not serialized again,
+   // their files in the current snapshot are reused instead. If the current snapshot is locked, it is incomplete.
+   const bool can_reuse = fc::exists( old_dir ) && !fc::exists( old_dir / "lock" );
+   fc::remove_all( tmp_dir );
+   fc::create_directories( tmp_dir / "lock" );
    std::vector<fc::future<void>> tasks;
    tasks.reserve(200);
+   std::atomic<uint32_t> saved(0);
+   std::atomic<uint32_t> reused(0);
    for( uint32_t space = 0; space < _index.size(); ++space )
    {
-      fc::create_directories( _data_dir / "object_database.tmp" / fc::to_string(space) );
+      fc::create_directories( tmp_dir / fc::to_string(space) );
       const auto types = _index[space].size();
       for( uint32_t type = 0; type  <  types; ++type )
          if( _index[space][type] )
-            tasks.push_back( fc::do_parallel( [this,space,type] () {
-               _index[space][type]->save( _data_dir / "object_database.tmp" / fc::to_string(space)/fc::to_string(type) );
-            } ) );
+            tasks.push_back( task_pool::instance().run( [this,space,type,can_reuse,&old_dir,&tmp_dir,&saved,&reused] () {
+               const fc::path old_file = old_dir / fc::to_string(space) / fc::to_string(type);
+               const fc::path new_file = tmp_dir / fc::to_string(space) / fc::to_string(type);
+               if( can_reuse && !_index[space][type]->is_dirty() && fc::exists( old_file ) )
+               {
+                  fc::copy( old_file, new_file );
+                  ++reused;
+               }
+               else
+               {
+                  _index[space][type]->save( new_file );
+                  ++saved;
+               }
+            }, task_priority::low ) );
    }
    for( auto& task : tasks )
       task.wait();
-   fc::remove_all( _data_dir / "object_database.tmp" / "lock" );
-   if( fc::exists( _data_dir / "object_database" ) )
-      fc::rename( _data_dir / "object_database", _data_dir / "object_database.old" );
-   fc::rename( _data_dir / "object_database.tmp", _data_dir / "object_database" );
+   fc::remove_all( tmp_dir / "lock" );
+   if( fc::exists( old_dir ) )
+      fc::rename( old_dir, _data_dir / "object_database.old" );
+   fc::rename( tmp_dir, old_dir );
    fc::remove_all( _data_dir / "object_database.old" );
+   dlog( "Saved ${s} indexes, reused ${r} unchanged indexes", ("s",saved.load())("r",reused.load()) );
 }
 
 void object_database::wipe(const fc::path& data_dir)
@@ -109,17 +181,45 @@ void object_database::open(const fc::path& data_dir)
        wlog("Ignoring locked object_database");
        return;
    }
-   std::vector<fc::future<void>> tasks;
-   tasks.reserve(200);
    ilog("Opening object database from ${d} ...", ("d", data_dir));
+   // Start with the largest files, so that a few huge indexes don't end up being loaded last while the other
+   // threads are idle
+   std::vector<std::pair<uint64_t, std::pair<uint32_t, uint32_t>>> files;
    for( uint32_t space = 0; space < _index.size(); ++space )
       for( uint32_t type = 0; type  < _index[space].size(); ++type )
          if( _index[space][type] )
-            tasks.push_back( fc::do_parallel( [this,space,type] () {
-               _index[space][type]->open( _data_dir / "object_database" / fc::to_string(space)/fc::to_string(type) );
-            } ) );
+         {
+            const fc::path file = _data_dir / "object_database" / fc::to_string(space) / fc::to_string(type);
+            files.emplace_back( fc::exists( file ) ? fc::file_size( file ) : 0, std::make_pair( space, type ) );
+         }
+   std::sort( files.begin(), files.end(), []( const auto& a, const auto& b ) { return a.first > b.first; } );
+
+   std::vector<fc::future<void>> tasks;
+   tasks.reserve( files.size() );
+   for( const auto& file : files )
+   {
+      const uint32_t space = file.second.first;
+      const uint32_t type = file.second.second;
+      tasks.push_back( task_pool::instance().run( [this,space,type] () {
+         _index[space][type]->open( _data_dir / "object_database" / fc::to_string(space)/fc::to_string(type) );
+      } ) );
+   }
+   // let every task finish before reporting a damaged file, they use the indexes
+   fc::exception_ptr failure;
    for( auto& task : tasks )
-      task.wait();
+   {
+      try
+      {
+         task.wait();
+      }
+      catch( const fc::exception& e )
+      {
+         if( !failure )
+            failure = e.dynamic_copy_exception();
+      }
+   }
+   if( failure )
+      failure->dynamic_rethrow_exception();
    ilog( "Done opening object database." );
 
 } FC_CAPTURE_AND_RETHROW( (data_dir) ) }
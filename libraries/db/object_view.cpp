@@ -0,0 +1,58 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <graphene/db/object_view.hpp>
+#include <graphene/db/object_database.hpp>
+
+namespace graphene { namespace db {
+
+const object* object_view::find_object( object_id_type id )const
+{
+   auto itr = _saved.find( id );
+   if( itr != _saved.end() )
+      return itr->second.get();
+   return _db.find_object( id );
+}
+
+void object_view::inspect_all_objects( uint8_t space_id, uint8_t type_id,
+                                       const std::function<void(const object&)>& inspector )const
+{ try {
+   _db.get_index( space_id, type_id ).inspect_all_objects( [this,&inspector]( const object& obj ) {
+      if( _saved.find( obj.id ) == _saved.end() )
+         inspector( obj );
+   });
+   for( const auto& item : _saved )
+   {
+      if( item.first.space() == space_id && item.first.type() == type_id && item.second )
+         inspector( *item.second );
+   }
+} FC_CAPTURE_AND_RETHROW( (space_id)(type_id) ) }
+
+void object_view::on_create( const object& obj )
+{
+   // an object which existed, was removed and is put back, E.G. by undo, keeps its saved value
+   _saved.emplace( obj.id, unique_ptr<object>() );
+}
+
+void object_view::on_modify( const object& obj )
+{
+   if( _saved.find( obj.id ) == _saved.end() )
+      _saved.emplace( obj.id, obj.clone() );
+}
+
+} } // graphene::db
@@ -0,0 +1,58 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <graphene/db/state_hash_index.hpp>
+
+namespace graphene { namespace db {
+
+void state_hash_index::add( const object& obj )
+{
+   const fc::sha256 h = fc::sha256::hash( obj.pack() );
+   for( size_t i = 0; i < 4; ++i )
+      _state.hash._hash[i] += h._hash[i];
+}
+
+void state_hash_index::subtract( const object& obj )
+{
+   const fc::sha256 h = fc::sha256::hash( obj.pack() );
+   for( size_t i = 0; i < 4; ++i )
+      _state.hash._hash[i] -= h._hash[i];
+}
+
+void state_hash_index::object_inserted( const object& obj )
+{
+   add( obj );
+   ++_state.object_count;
+}
+
+void state_hash_index::object_removed( const object& obj )
+{
+   subtract( obj );
+   --_state.object_count;
+}
+
+void state_hash_index::about_to_modify( const object& before )
+{
+   subtract( before );
+}
+
+void state_hash_index::object_modified( const object& after )
+{
+   add( after );
+}
+
+} } // graphene::db
@@ -0,0 +1,149 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <graphene/db/task_pool.hpp>
+
+#include <fc/asio.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace db {
+
+task_pool& task_pool::instance()
+{
+   // intentionally leaked, workers may still be running during static deinitialization
+   static task_pool* pool = new task_pool();
+   return *pool;
+}
+
+task_pool::~task_pool()
+{
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      _stopping = true;
+   }
+   _wakeup.notify_all();
+   for( auto& thread : _threads )
+      thread.join();
+}
+
+void task_pool::set_thread_count( uint32_t count )
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   FC_ASSERT( _threads.empty(), "The number of workers can not be changed after they started" );
+   _thread_count = count;
+}
+
+uint32_t task_pool::thread_count()const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   if( !_threads.empty() )
+      return _threads.size();
+   return _thread_count > 0 ? _thread_count : std::max<uint32_t>( 1, fc::asio::default_io_service_scope::get_num_threads() );
+}
+
+void task_pool::start()
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   start_locked();
+}
+
+void task_pool::start_locked()
+{
+   if( !_threads.empty() )
+      return;
+   const uint32_t count = _thread_count > 0 ? _thread_count
+                          : std::max<uint32_t>( 1, fc::asio::default_io_service_scope::get_num_threads() );
+   _threads.reserve( count );
+   for( uint32_t i = 0; i < count; ++i )
+      _threads.emplace_back( [this]() { worker_loop(); } );
+}
+
+void task_pool::enqueue( std::function<void()> work, task_priority priority )
+{
+   const size_t p = static_cast<size_t>( priority );
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      start_locked();
+      _queues[p].push_back( queued_task{ std::move( work ), fc::time_point::now() } );
+      ++_stats[p].queued;
+   }
+   _wakeup.notify_one();
+}
+
+void task_pool::worker_loop()
+{
+   std::unique_lock<std::mutex> lock( _mutex );
+   while( true )
+   {
+      size_t p = 0;
+      while( p < priority_count && _queues[p].empty() )
+         ++p;
+      if( p == priority_count )
+      {
+         if( _stopping )
+            return;
+         _wakeup.wait( lock );
+         continue;
+      }
+
+      queued_task task = std::move( _queues[p].front() );
+      _queues[p].pop_front();
+      --_stats[p].queued;
+      ++_busy;
+      lock.unlock();
+
+      const fc::time_point started = fc::time_point::now();
+      task.work(); // reports its result and exceptions through its promise
+      const fc::time_point finished = fc::time_point::now();
+
+      lock.lock();
+      --_busy;
+      auto& stats = _stats[p];
+      const uint64_t wait_us = ( started - task.queued ).count();
+      ++stats.completed;
+      stats.total_wait_us += wait_us;
+      stats.max_wait_us = std::max( stats.max_wait_us, wait_us );
+      stats.total_run_us += ( finished - started ).count();
+   }
+}
+
+task_pool_stats task_pool::get_stats()const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   task_pool_stats result;
+   result.threads = _threads.size();
+   result.busy = _busy;
+   result.high = _stats[ static_cast<size_t>( task_priority::high ) ];
+   result.normal = _stats[ static_cast<size_t>( task_priority::normal ) ];
+   result.low = _stats[ static_cast<size_t>( task_priority::low ) ];
+   return result;
+}
+
+void task_pool::reset_stats()
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   for( auto& stats : _stats )
+   {
+      const uint64_t queued = stats.queued;
+      stats = task_priority_stats();
+      stats.queued = queued;
+   }
+}
+
+} } // graphene::db
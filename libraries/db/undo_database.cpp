@@ -25,6 +25,8 @@
 #include <graphene/db/undo_database.hpp>
 #include <fc/reflect/variant.hpp>
 
+#include <algorithm>
+
 namespace graphene { namespace db {
 
 void undo_database::enable()  { _disabled = false; }
@@ -54,81 +56,210 @@ undo_database::session undo_database::start_undo_session( bool force_enable )
       _stack.pop_front();
 
    _stack.emplace_back();
+   _stack.back().first_seq = _next_seq;
    ++_active_sessions;
+   if( _compact_depth > 0 && _stack.size() > _compact_depth )
+   {
+      // deeper states have been compacted before, unless the depth was changed
+      undo_state& deep = _stack[ _stack.size() - _compact_depth - 1 ];
+      if( !deep.compacted )
+         compact_state( deep );
+   }
    return session(*this, disable_on_exit );
 }
-void undo_database::on_create( const object& obj )
+
+undo_entry* undo_state::find( uint64_t seq, const object_id_type& id )
 {
-   if( _disabled ) return;
+   if( seq < first_seq )
+      return nullptr;
+   auto itr = std::lower_bound( changes.begin(), changes.end(), seq,
+                                []( const undo_entry& entry, uint64_t s ) { return entry.seq < s; } );
+   if( itr == changes.end() || itr->seq != seq || itr->id != id )
+      return nullptr;
+   if( itr->kind == undo_entry::merged )
+      return find( itr->prior_seq, id );
+   if( itr->kind == undo_entry::dropped )
+      return nullptr;
+   return &(*itr);
+}
+
+size_t undo_state::count( undo_entry::kind_type kind )const
+{
+   return std::count_if( changes.begin(), changes.end(), [kind]( const undo_entry& entry ) {
+      return entry.kind == kind;
+   });
+}
+
+size_t undo_state::packed_count()const
+{
+   return std::count_if( changes.begin(), changes.end(), []( const undo_entry& entry ) {
+      return !entry.packed_old_value.empty();
+   });
+}
+
+void undo_database::compact_state( undo_state& state )
+{
+   for( auto& entry : state.changes )
+      if( entry.kind == undo_entry::modified && entry.old_value && entry.old_value->packs_whole_state() )
+      {
+         entry.packed_old_value = entry.old_value->pack();
+         entry.old_value.reset();
+      }
+   state.compacted = true;
+}
+
+size_t undo_database::packed_size()const
+{
+   size_t result = 0;
+   for( const auto& state : _stack )
+      for( const auto& entry : state.changes )
+         result += entry.packed_old_value.size();
+   return result;
+}
+void undo_database::add_view( const std::shared_ptr<object_view>& view )
+{
+   _views.push_back( view );
+}
+
+template<typename Callback>
+void undo_database::notify_views( const Callback& callback )
+{
+   for( auto itr = _views.begin(); itr != _views.end(); )
+   {
+      if( auto view = itr->lock() )
+      {
+         callback( *view );
+         ++itr;
+      }
+      else
+         itr = _views.erase( itr );
+   }
+}
 
+undo_state& undo_database::head_state()
+{
    if( _stack.empty() )
+   {
       _stack.emplace_back();
-   auto& state = _stack.back();
+      _stack.back().first_seq = _next_seq;
+   }
+   return _stack.back();
+}
+
+undo_entry& undo_database::record( undo_state& state, const object& obj, undo_entry::kind_type kind )
+{
+   state.changes.emplace_back();
+   undo_entry& entry = state.changes.back();
+   entry.id = obj.id;
+   entry.seq = _next_seq++;
+   entry.prior_seq = obj.undo_seq;
+   entry.kind = kind;
+   return entry;
+}
+
+void undo_database::on_create( const object& obj )
+{
+   if( !_views.empty() )
+      notify_views( [&obj]( object_view& view ) { view.on_create( obj ); } );
+   if( _disabled ) return;
+
+   auto& state = head_state();
    auto index_id = object_id_type( obj.id.space(), obj.id.type(), 0 );
-   auto itr = state.old_index_next_ids.find( index_id );
-   if( itr == state.old_index_next_ids.end() )
-      state.old_index_next_ids[index_id] = obj.id;
-   state.new_ids.insert(obj.id);
+   state.old_index_next_ids.emplace( index_id, obj.id );
+   obj.undo_seq = record( state, obj, undo_entry::created ).seq;
 }
 void undo_database::on_modify( const object& obj )
 {
+   if( !_views.empty() )
+      notify_views( [&obj]( object_view& view ) { view.on_modify( obj ); } );
    if( _disabled ) return;
 
-   if( _stack.empty() )
-      _stack.emplace_back();
-   auto& state = _stack.back();
-   if( state.new_ids.find(obj.id) != state.new_ids.end() )
+   auto& state = head_state();
+   // new objects and objects modified before in this state keep their entry
+   if( state.find( obj.undo_seq, obj.id ) != nullptr )
       return;
-   auto itr =  state.old_values.find(obj.id);
-   if( itr != state.old_values.end() ) return;
-   state.old_values[obj.id] = obj.clone();
+   undo_entry& entry = record( state, obj, undo_entry::modified );
+   if( _compact && obj.packs_whole_state() )
+      entry.packed_old_value = obj.pack();
+   else
+      entry.old_value = obj.clone();
+   obj.undo_seq = entry.seq;
 }
 void undo_database::on_remove( const object& obj )
 {
+   if( !_views.empty() )
+      notify_views( [&obj]( object_view& view ) { view.on_modify( obj ); } );
    if( _disabled ) return;
 
-   if( _stack.empty() )
-      _stack.emplace_back();
-   undo_state& state = _stack.back();
-   if( state.new_ids.count(obj.id) > 0 )
+   undo_state& state = head_state();
+   undo_entry* entry = state.find( obj.undo_seq, obj.id );
+   if( entry == nullptr )
    {
-      state.new_ids.erase(obj.id);
+      record( state, obj, undo_entry::removed ).old_value = obj.clone();
       return;
    }
-   if( state.old_values.count(obj.id) > 0 )
+   if( entry->kind == undo_entry::created )
    {
-      state.removed[obj.id] = std::move(state.old_values[obj.id]);
-      state.old_values.erase(obj.id);
+      // it did not exist before this state, so nothing has happened
+      entry->kind = undo_entry::dropped;
       return;
    }
-   if( state.removed.count(obj.id) > 0 ) return;
-   state.removed[obj.id] = obj.clone();
-}
-
-void undo_database::undo()
-{ try {
-   FC_ASSERT( !_disabled );
-   FC_ASSERT( _active_sessions > 0 );
-   disable();
-
-   auto& state = _stack.back();
-   for( auto& item : state.old_values )
+   if( entry->kind == undo_entry::modified )
    {
-      _db.modify( _db.get_object( item.second->id ), [&]( object& obj ){ obj.move_from( *item.second ); } );
+      if( !entry->old_value )
+      {
+         entry->old_value = obj.clone();
+         entry->old_value->unpack_from( entry->packed_old_value );
+         entry->old_value->undo_seq = entry->prior_seq;
+         entry->packed_old_value = vector<char>();
+      }
+      entry->kind = undo_entry::removed;
    }
+}
 
-   for( auto ritr = state.new_ids.begin(); ritr != state.new_ids.end(); ++ritr  )
+void undo_database::apply_undo( undo_state& state )
+{
+   // Modified objects are restored first, then new objects are removed and removed objects are inserted again,
+   // so that unique keys which moved between objects don't collide. Within each pass, later changes are undone
+   // first.
+   for( auto itr = state.changes.rbegin(); itr != state.changes.rend(); ++itr )
    {
-      _db.remove( _db.get_object(*ritr) );
+      if( itr->kind != undo_entry::modified )
+         continue;
+      undo_entry& entry = *itr;
+      _db.modify( _db.get_object( entry.id ), [&entry]( object& obj ){
+         if( entry.old_value )
+            obj.move_from( *entry.old_value );
+         else
+            obj.unpack_from( entry.packed_old_value );
+         obj.undo_seq = entry.prior_seq;
+      });
    }
 
+   for( auto itr = state.changes.rbegin(); itr != state.changes.rend(); ++itr )
+      if( itr->kind == undo_entry::created )
+         _db.remove( _db.get_object( itr->id ) );
+
    for( auto& item : state.old_index_next_ids )
    {
       _db.get_mutable_index( item.first.space(), item.first.type() ).set_next_id( item.second );
    }
 
-   for( auto& item : state.removed )
-      _db.insert( std::move(*item.second) );
+   for( auto itr = state.changes.rbegin(); itr != state.changes.rend(); ++itr )
+      if( itr->kind == undo_entry::removed )
+      {
+         itr->old_value->undo_seq = itr->prior_seq;
+         _db.insert( std::move(*itr->old_value) );
+      }
+}
+
+void undo_database::undo()
+{ try {
+   FC_ASSERT( !_disabled );
+   FC_ASSERT( _active_sessions > 0 );
+   disable();
+
+   apply_undo( _stack.back() );
 
    _stack.pop_back();
    enable();
@@ -149,10 +280,10 @@ void undo_database::merge()
    auto& prev_state = _stack[_stack.size()-2];
 
    // An object's relationship to a state can be:
-   // in new_ids            : new
-   // in old_values (was=X) : upd(was=X)
-   // in removed (was=X)    : del(was=X)
-   // not in any of above   : nop
+   // created entry             : new
+   // modified entry (was=X)    : upd(was=X)
+   // removed entry (was=X)     : del(was=X)
+   // no entry or dropped entry : nop
    //
    // When merging A=prev_state and B=state we have a 4x4 matrix of all possibilities:
    //
@@ -188,70 +319,79 @@ void undo_database::merge()
    // (a serious logic error which should never happen).
    //
 
-   // We can only be outside type A/AB (the nop path) if B is not nop, so it suffices to iterate through B's three containers.
-
-   // *+upd
-   for( auto& obj : state.old_values )
+   // We can only be outside type A/AB (the nop path) if B is not nop, so it suffices to iterate through B's entries.
+   // An entry of B refers to the entry of the object in A, if there is one, by prior_seq. The entries of B keep
+   // their sequence numbers, so that objects still refer to their entries after the merge. B's entries which are
+   // of type A are left as merged entries referring to A's entry.
+   prev_state.changes.reserve( prev_state.changes.size() + state.changes.size() );
+   for( auto& entry : state.changes )
    {
-      if( prev_state.new_ids.find(obj.second->id) != prev_state.new_ids.end() )
-      {
-         // new+upd -> new, type A
-         continue;
-      }
-      if( prev_state.old_values.find(obj.second->id) != prev_state.old_values.end() )
+      switch( entry.kind )
       {
-         // upd(was=X) + upd(was=Y) -> upd(was=X), type A
+      case undo_entry::created:
+         // *+new, but we assume the N/A cases don't happen, leaving type B nop+new -> new
+         break;
+      case undo_entry::modified:
+         if( undo_entry* prior = prev_state.find( entry.prior_seq, entry.id ) )
+         {
+            // new+upd -> new, upd(was=X) + upd(was=Y) -> upd(was=X), type A
+            // del+upd -> N/A
+            assert( prior->kind != undo_entry::removed );
+            entry.kind = undo_entry::merged;
+            entry.prior_seq = prior->seq;
+            entry.old_value.reset();
+            entry.packed_old_value = vector<char>();
+         }
+         else if( prev_state.compacted && entry.old_value && entry.old_value->packs_whole_state() )
+         {
+            // nop+upd(was=Y) -> upd(was=Y), type B, in the form of the merged state
+            entry.packed_old_value = entry.old_value->pack();
+            entry.old_value.reset();
+         }
+         break;
+      case undo_entry::removed:
+         if( undo_entry* prior = prev_state.find( entry.prior_seq, entry.id ) )
+         {
+            // del + del -> N/A
+            assert( prior->kind != undo_entry::removed );
+            if( prior->kind == undo_entry::created )
+            {
+               // new + del -> nop (type C)
+               prior->kind = undo_entry::dropped;
+               continue;
+            }
+            // upd(was=X) + del(was=Y) -> del(was=X)
+            if( !prior->old_value )
+            {
+               // X in serialized form
+               entry.old_value->unpack_from( prior->packed_old_value );
+               entry.old_value->undo_seq = prior->prior_seq;
+               prior->old_value = std::move( entry.old_value );
+               prior->packed_old_value = vector<char>();
+            }
+            prior->kind = undo_entry::removed;
+            continue;
+         }
+         // nop + del(was=Y) -> del(was=Y)
+         break;
+      case undo_entry::merged:
+         // refer to where the change ended up
+         if( undo_entry* target = prev_state.find( entry.prior_seq, entry.id ) )
+            entry.prior_seq = target->seq;
+         else
+            continue;
+         break;
+      case undo_entry::dropped:
          continue;
       }
-      // del+upd -> N/A
-      assert( prev_state.removed.find(obj.second->id) == prev_state.removed.end() );
-      // nop+upd(was=Y) -> upd(was=Y), type B
-      prev_state.old_values[obj.second->id] = std::move(obj.second);
+      prev_state.changes.push_back( std::move( entry ) );
    }
 
-   // *+new, but we assume the N/A cases don't happen, leaving type B nop+new -> new
-   for( auto id : state.new_ids )
-      prev_state.new_ids.insert(id);
-
-   // old_index_next_ids can only be updated, iterate over *+upd cases
+   // old_index_next_ids can only be updated, upd(was=X)+upd(was=Y) -> upd(was=X) is type A,
+   // nop+upd(was=Y) -> upd(was=Y) is type B
    for( auto& item : state.old_index_next_ids )
-   {
-      if( prev_state.old_index_next_ids.find( item.first ) == prev_state.old_index_next_ids.end() )
-      {
-         // nop+upd(was=Y) -> upd(was=Y), type B
-         prev_state.old_index_next_ids[item.first] = item.second;
-         continue;
-      }
-      else
-      {
-         // upd(was=X)+upd(was=Y) -> upd(was=X), type A
-         // type A implementation is a no-op, as discussed above, so there is no code here
-         continue;
-      }
-   }
+      prev_state.old_index_next_ids.emplace( item );
 
-   // *+del
-   for( auto& obj : state.removed )
-   {
-      if( prev_state.new_ids.find(obj.second->id) != prev_state.new_ids.end() )
-      {
-         // new + del -> nop (type C)
-         prev_state.new_ids.erase(obj.second->id);
-         continue;
-      }
-      auto it = prev_state.old_values.find(obj.second->id);
-      if( it != prev_state.old_values.end() )
-      {
-         // upd(was=X) + del(was=Y) -> del(was=X)
-         prev_state.removed[obj.second->id] = std::move(it->second);
-         prev_state.old_values.erase(obj.second->id);
-         continue;
-      }
-      // del + del -> N/A
-      assert( prev_state.removed.find( obj.second->id ) == prev_state.removed.end() );
-      // nop + del(was=Y) -> del(was=Y)
-      prev_state.removed[obj.second->id] = std::move(obj.second);
-   }
    _stack.pop_back();
    --_active_sessions;
 }
@@ -268,25 +408,7 @@ void undo_database::pop_commit()
 
    disable();
    try {
-      auto& state = _stack.back();
-
-      for( auto& item : state.old_values )
-      {
-         _db.modify( _db.get_object( item.second->id ), [&]( object& obj ){ obj.move_from( *item.second ); } );
-      }
-
-      for( auto ritr = state.new_ids.begin(); ritr != state.new_ids.end(); ++ritr  )
-      {
-         _db.remove( _db.get_object(*ritr) );
-      }
-
-      for( auto& item : state.old_index_next_ids )
-      {
-         _db.get_mutable_index( item.first.space(), item.first.type() ).set_next_id( item.second );
-      }
-
-      for( auto& item : state.removed )
-         _db.insert( std::move(*item.second) );
+      apply_undo( _stack.back() );
 
       _stack.pop_back();
    }
@@ -45,4 +45,14 @@ fc::sha256 get_egenesis_json_hash()
    return fc::sha256::hash( "" );
 }
 
+bool compute_egenesis_state( genesis_state_type& )
+{
+   return false;
+}
+
+void compute_egenesis_checkpoints( flat_map<uint32_t, block_id_type>& result )
+{
+   result.clear();
+}
+
 } }
@@ -8,6 +8,16 @@ message( STATUS "Chain-id: ${chain_id}" )
 
 set( generated_file_banner "/*** GENERATED FILE - DO NOT EDIT! ***/" )
 set( genesis_json_hash "${chain_id}" )
+
+if( embed_checkpoints_args )
+  file( READ "${embed_checkpoints_args}" checkpoints_json )
+else( embed_checkpoints_args )
+  set( checkpoints_json "[]" )
+endif( embed_checkpoints_args )
+string( REGEX REPLACE "(\"|\\\\)" "\\\\\\1" checkpoints_json_escaped "${checkpoints_json}" )
+string( REPLACE "\n" " " checkpoints_json_escaped "${checkpoints_json_escaped}" )
+string( REPLACE "\t" " " checkpoints_json_escaped "${checkpoints_json_escaped}" )
+
 configure_file( "${CMAKE_CURRENT_SOURCE_DIR}/egenesis_brief.cpp.tmpl"
                 "${CMAKE_CURRENT_BINARY_DIR}/egenesis_brief.cpp" )
 
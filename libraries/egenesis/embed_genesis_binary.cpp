@@ -0,0 +1,89 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Build-time helper: packs a genesis JSON file with fc::raw and writes a source file which defines
+ * compute_egenesis_state() with the packed bytes, so that nodes don't need to parse the JSON at startup.
+ *
+ * Usage: embed_genesis_binary <genesis.json> <output.cpp>
+ */
+
+#include <graphene/chain/genesis_state.hpp>
+
+#include <fc/io/fstream.hpp>
+#include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+int main( int argc, char** argv )
+{
+   if( argc != 3 )
+   {
+      std::cerr << "Usage: " << argv[0] << " <genesis.json> <output.cpp>\n";
+      return 1;
+   }
+
+   try
+   {
+      std::string genesis_json;
+      fc::read_file_contents( fc::path( argv[1] ), genesis_json );
+      // Same depth limit as used by the node when it parses the embedded JSON
+      const auto genesis = fc::json::from_string( genesis_json ).as<graphene::chain::genesis_state_type>( 20 );
+      const std::vector<char> packed = fc::raw::pack( genesis );
+      const fc::sha256 json_hash = fc::sha256::hash( genesis_json );
+
+      std::ofstream out( argv[2], std::ios::trunc );
+      out << "/*** GENERATED FILE - DO NOT EDIT! ***/\n"
+          << "#include <graphene/egenesis/egenesis.hpp>\n\n"
+          << "#include <fc/io/raw.hpp>\n\n"
+          << "namespace graphene { namespace egenesis {\n\n"
+          << "static const unsigned char genesis_packed[" << std::max<size_t>( packed.size(), 1 ) << "] =\n{";
+      char buf[8];
+      for( size_t i = 0; i < packed.size(); ++i )
+      {
+         if( i % 16 == 0 )
+            out << "\n  ";
+         std::snprintf( buf, sizeof(buf), "0x%02x,", static_cast<unsigned char>( packed[i] ) );
+         out << buf;
+      }
+      out << "\n};\n\n"
+          << "bool compute_egenesis_state( graphene::chain::genesis_state_type& result )\n"
+          << "{\n"
+          << "   fc::raw::unpack( reinterpret_cast<const char*>( genesis_packed ), " << packed.size() << ", result );\n"
+          << "   result.initial_chain_id = graphene::chain::chain_id_type( \"" << json_hash.str() << "\" );\n"
+          << "   return true;\n"
+          << "}\n\n"
+          << "} }\n";
+      out.close();
+      if( !out )
+      {
+         std::cerr << "Unable to write " << argv[2] << "\n";
+         return 1;
+      }
+      std::cout << "Packed genesis: " << packed.size() << " bytes, chain-id " << json_hash.str() << "\n";
+   }
+   catch( const fc::exception& e )
+   {
+      std::cerr << e.to_detail_string() << "\n";
+      return 1;
+   }
+   return 0;
+}
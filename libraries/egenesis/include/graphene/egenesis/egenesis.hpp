@@ -48,4 +48,16 @@ void compute_egenesis_json( std::string& result );
  */
 fc::sha256 get_egenesis_json_hash();
 
+/**
+ * Get the egenesis as a genesis state with initial_chain_id set, if it was embedded pre-packed
+ * (GRAPHENE_EGENESIS_BINARY). Returns false if not, the state must be parsed from compute_egenesis_json() then.
+ */
+bool compute_egenesis_state( graphene::chain::genesis_state_type& result );
+
+/**
+ * Get the checkpoints of the egenesis chain which were compiled in, as pairs of block number and block ID.
+ * They come with the binary, so they are as trusted as the egenesis itself.
+ */
+void compute_egenesis_checkpoints( flat_map<uint32_t, graphene::chain::block_id_type>& result );
+
 } } // graphene::egenesis
@@ -46,11 +46,68 @@ namespace graphene { namespace net {
   const core_message_type_enum check_firewall_reply_message::type            = core_message_type_enum::check_firewall_reply_message_type;
   const core_message_type_enum get_current_connections_request_message::type = core_message_type_enum::get_current_connections_request_message_type;
   const core_message_type_enum get_current_connections_reply_message::type   = core_message_type_enum::get_current_connections_reply_message_type;
+  const core_message_type_enum compact_block_message::type                   = core_message_type_enum::compact_block_message_type;
+  const core_message_type_enum fetch_compact_block_transactions_message::type = core_message_type_enum::fetch_compact_block_transactions_message_type;
+  const core_message_type_enum compact_block_transactions_message::type      = core_message_type_enum::compact_block_transactions_message_type;
+
+  compact_block_message::compact_block_message(const signed_block& blk, const item_hash_t& block_message_hash) :
+    header(blk),
+    block_id(blk.id()),
+    block_message_hash(block_message_hash)
+  {
+    transaction_ids.reserve(blk.transactions.size());
+    operation_results.reserve(blk.transactions.size());
+    for (const auto& trx : blk.transactions)
+    {
+      transaction_ids.push_back(trx.id());
+      operation_results.push_back(trx.operation_results);
+    }
+  }
+
+  std::vector<uint32_t> compact_block_message::rebuild(signed_block& block,
+                              const std::vector<fc::optional<signed_transaction>>& pending_transactions) const
+  {
+    std::vector<uint32_t> missing_transaction_indexes;
+    static_cast<graphene::protocol::signed_block_header&>(block) = header;
+    block.transactions.clear();
+    block.transactions.resize(transaction_ids.size());
+    for (uint32_t i = 0; i < transaction_ids.size(); ++i)
+    {
+      if (i < pending_transactions.size() && pending_transactions[i])
+        block.transactions[i] = graphene::protocol::processed_transaction(*pending_transactions[i]);
+      else
+        missing_transaction_indexes.push_back(i);
+      // results of the missing transactions are kept when they are filled in
+      block.transactions[i].operation_results = operation_results[i];
+    }
+    return missing_transaction_indexes;
+  }
+
+  void compact_block_transactions_message::add_to(signed_block& block) const
+  {
+    // operation results came with the compact block, keep them
+    for (uint32_t i = 0; i < transaction_indexes.size() && i < transactions.size(); ++i)
+    {
+      uint32_t index = transaction_indexes[i];
+      if (index >= block.transactions.size())
+        continue;
+      auto& trx = block.transactions[index];
+      auto results = std::move(trx.operation_results);
+      trx = graphene::protocol::processed_transaction(transactions[i]);
+      trx.operation_results = std::move(results);
+    }
+  }
 
 } } // graphene::net
 
 FC_REFLECT_DERIVED_NO_TYPENAME( graphene::net::trx_message, BOOST_PP_SEQ_NIL, (trx) )
 FC_REFLECT_DERIVED_NO_TYPENAME( graphene::net::block_message, BOOST_PP_SEQ_NIL, (block)(block_id) )
+FC_REFLECT_DERIVED_NO_TYPENAME( graphene::net::compact_block_message, BOOST_PP_SEQ_NIL,
+                                (header)(block_id)(block_message_hash)(transaction_ids)(operation_results) )
+FC_REFLECT_DERIVED_NO_TYPENAME( graphene::net::fetch_compact_block_transactions_message, BOOST_PP_SEQ_NIL,
+                                (block_id)(transaction_indexes) )
+FC_REFLECT_DERIVED_NO_TYPENAME( graphene::net::compact_block_transactions_message, BOOST_PP_SEQ_NIL,
+                                (block_id)(transaction_indexes)(transactions) )
 
 FC_REFLECT_DERIVED_NO_TYPENAME( graphene::net::item_id, BOOST_PP_SEQ_NIL,
                                (item_type)
@@ -131,6 +188,9 @@ FC_REFLECT_DERIVED_NO_TYPENAME(graphene::net::get_current_connections_reply_mess
 
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::net::trx_message )
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::net::block_message )
+GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::net::compact_block_message )
+GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::net::fetch_compact_block_transactions_message )
+GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::net::compact_block_transactions_message )
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::net::item_id )
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::net::item_ids_inventory_message )
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::net::blockchain_item_ids_inventory_message )
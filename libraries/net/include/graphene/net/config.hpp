@@ -25,7 +25,12 @@
 
 #include <stddef.h>
 
-#define GRAPHENE_NET_PROTOCOL_VERSION                        106
+#define GRAPHENE_NET_PROTOCOL_VERSION                        107
+
+/**
+ * Peers of this protocol version or later receive recently broadcast blocks as compact_block_message
+ */
+#define GRAPHENE_NET_COMPACT_BLOCK_PROTOCOL_VERSION          107
 
 /**
  * Define this to enable debugging code in the p2p network interface.
@@ -39,6 +44,28 @@
  * 2MiB
  */
 #define MAX_MESSAGE_SIZE                                     1024*1024*2
+
+/**
+ * Messages of at least this many bytes are compressed when sent to a peer which supports it
+ */
+#define GRAPHENE_NET_MESSAGE_COMPRESSION_THRESHOLD           512
+
+/**
+ * Incoming messages of at least this many bytes are hashed and unpacked on a worker thread
+ */
+#define GRAPHENE_NET_WORKER_THREAD_MESSAGE_SIZE              (64 * 1024)
+
+#define GRAPHENE_NET_MAX_MESSAGE_WORKER_THREADS              4
+
+/**
+ * Size of the buffers stcp_socket encrypts into and decrypts from, a multiple of the 16 byte AES block size
+ */
+#define GRAPHENE_NET_STCP_BUFFER_SIZE                        (64 * 1024)
+
+/**
+ * Set in the msg_type of the message header of a compressed message
+ */
+#define GRAPHENE_NET_COMPRESSED_MESSAGE_FLAG                 0x80000000u
 #define GRAPHENE_NET_DEFAULT_PEER_CONNECTION_RETRY_TIME      30 // seconds
 
 /**
@@ -86,6 +113,18 @@
 
 #define GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING      200
 
+/**
+ * During sync, each peer gets a share of GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING according to its
+ * measured throughput relative to the fastest peer, but at least this many blocks per request
+ */
+#define GRAPHENE_NET_MIN_BLOCKS_PER_PEER_DURING_SYNCING      10
+
+/**
+ * A sync block requested longer ago than this is requested again from an idle peer, so that a slow
+ * peer does not hold up processing of the blocks that follow it
+ */
+#define GRAPHENE_NET_SYNC_STRAGGLER_TIMEOUT_SEC              10
+
 /**
  * During normal operation, how many items will be fetched from each
  * peer at a time.  This will only come into play when the network
@@ -99,6 +138,18 @@
  */
 #define GRAPHENE_NET_MAX_ITEMS_PER_PEER_DURING_NORMAL_OPERATION  1 
 
+/**
+ * Transactions are fetched in batches of up to this many per peer, blocks are still fetched
+ * GRAPHENE_NET_MAX_ITEMS_PER_PEER_DURING_NORMAL_OPERATION at a time
+ */
+#define GRAPHENE_NET_MAX_TRANSACTIONS_PER_FETCH              100
+
+/**
+ * New transactions are collected for this long and then advertised to each peer in one inventory
+ * message.  New blocks are advertised right away
+ */
+#define GRAPHENE_NET_INVENTORY_FLUSH_INTERVAL_MS             50
+
 /**
  * Instead of fetching all item IDs from a peer, then fetching all blocks
  * from a peer, we will interleave them.  Fetch at least this many block IDs,
@@ -113,5 +164,10 @@
 
 #define MAXIMUM_PEERDB_SIZE 1000
 
+/**
+ * Delay assumed for a peer whose round trip delay or block delivery latency has not been measured yet
+ */
+#define GRAPHENE_NET_UNMEASURED_PEER_DELAY_MS                500
+
 constexpr size_t MAX_BLOCKS_TO_HANDLE_AT_ONCE = 200;
 constexpr size_t MAX_SYNC_BLOCKS_TO_PREFETCH = 10 * MAX_BLOCKS_TO_HANDLE_AT_ONCE;
@@ -85,6 +85,9 @@ namespace graphene { namespace net {
     check_firewall_reply_message_type            = 5015,
     get_current_connections_request_message_type = 5016,
     get_current_connections_reply_message_type   = 5017,
+    compact_block_message_type                   = 5018,
+    fetch_compact_block_transactions_message_type = 5019,
+    compact_block_transactions_message_type      = 5020,
     core_message_type_last                       = 5099
   };
 
@@ -114,6 +117,65 @@ namespace graphene { namespace net {
 
    };
 
+   /**
+    * A block whose transactions are replaced by their ids.  It is sent instead of the block_message in reply
+    * to a fetch of a recently broadcast block if the peer speaks protocol version 107 or later, the receiver
+    * rebuilds the block from its transaction pool.
+    */
+   struct compact_block_message
+   {
+      static const core_message_type_enum type;
+
+      compact_block_message() {}
+      compact_block_message(const signed_block& blk, const item_hash_t& block_message_hash);
+
+      graphene::protocol::signed_block_header header;
+      block_id_type                           block_id;
+      /// hash of the block_message which was requested, the rebuilt block must serialize to the same message
+      item_hash_t                             block_message_hash;
+      std::vector<transaction_id_type>        transaction_ids;
+      /// results of each transaction, they depend on the state the block was applied to and can not be
+      /// taken from the transaction pool
+      std::vector<std::vector<graphene::protocol::operation_result>> operation_results;
+
+      /**
+       * Rebuilds the block from the transactions of the pool, which must have the size of transaction_ids and
+       * operation_results.
+       * @param pending_transactions the transactions found in the pool by index, as many as transaction_ids or less
+       * @return the indexes of the missing transactions, their slots in @p block only hold the operation results
+       */
+      std::vector<uint32_t> rebuild(signed_block& block,
+                                    const std::vector<fc::optional<signed_transaction>>& pending_transactions) const;
+   };
+
+   /// Requests the transactions of a compact block which the receiver does not have
+   struct fetch_compact_block_transactions_message
+   {
+      static const core_message_type_enum type;
+
+      block_id_type         block_id;
+      std::vector<uint32_t> transaction_indexes;
+
+      fetch_compact_block_transactions_message() {}
+      fetch_compact_block_transactions_message(const block_id_type& block_id,
+                                               const std::vector<uint32_t>& transaction_indexes) :
+        block_id(block_id),
+        transaction_indexes(transaction_indexes)
+      {}
+   };
+
+   struct compact_block_transactions_message
+   {
+      static const core_message_type_enum type;
+
+      block_id_type                   block_id;
+      std::vector<uint32_t>           transaction_indexes;
+      std::vector<signed_transaction> transactions;
+
+      /// Fills the missing transactions of a block rebuilt by compact_block_message::rebuild()
+      void add_to(signed_block& block) const;
+   };
+
   struct item_ids_inventory_message
   {
     static const core_message_type_enum type;
@@ -422,6 +484,9 @@ FC_REFLECT_ENUM( graphene::net::core_message_type_enum,
                  (check_firewall_reply_message_type)
                  (get_current_connections_request_message_type)
                  (get_current_connections_reply_message_type)
+                 (compact_block_message_type)
+                 (fetch_compact_block_transactions_message_type)
+                 (compact_block_transactions_message_type)
                  (core_message_type_last) )
 FC_REFLECT_ENUM(graphene::net::rejection_reason_code, (unspecified)
                                                  (different_chain)
@@ -443,6 +508,9 @@ FC_REFLECT_ENUM(graphene::net::firewall_check_result, (unable_to_check)
 
 FC_REFLECT_TYPENAME( graphene::net::trx_message )
 FC_REFLECT_TYPENAME( graphene::net::block_message )
+FC_REFLECT_TYPENAME( graphene::net::compact_block_message )
+FC_REFLECT_TYPENAME( graphene::net::fetch_compact_block_transactions_message )
+FC_REFLECT_TYPENAME( graphene::net::compact_block_transactions_message )
 FC_REFLECT_TYPENAME( graphene::net::item_id )
 FC_REFLECT_TYPENAME( graphene::net::item_ids_inventory_message )
 FC_REFLECT_TYPENAME( graphene::net::blockchain_item_ids_inventory_message )
@@ -466,6 +534,9 @@ FC_REFLECT_TYPENAME( graphene::net::get_current_connections_reply_message )
 
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::trx_message )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::block_message )
+GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::compact_block_message )
+GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::fetch_compact_block_transactions_message )
+GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::compact_block_transactions_message )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::item_id )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::item_ids_inventory_message )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::blockchain_item_ids_inventory_message )
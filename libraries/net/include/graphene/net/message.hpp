@@ -32,6 +32,8 @@
 #include <fc/crypto/ripemd160.hpp>
 #include <fc/reflect/typename.hpp>
 
+#include <memory>
+
 namespace graphene { namespace net {
 
   /**
@@ -116,6 +118,9 @@ namespace graphene { namespace net {
      }
   };
 
+  /// A message shared by the queues of several peers and the message cache, it must not be modified
+  using message_ptr = std::shared_ptr<const message>;
+
 } } // graphene::net
 
 FC_REFLECT_TYPENAME( graphene::net::message_header )
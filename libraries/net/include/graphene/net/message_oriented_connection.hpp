@@ -52,6 +52,15 @@ namespace graphene { namespace net {
        void connect_to(const fc::ip::endpoint& remote_endpoint);
 
        void send_message(const message& message_to_send);
+
+       /// true if this build can compress and decompress messages
+       static bool compression_supported();
+       /**
+        * Compress messages of at least @p threshold bytes from now on.  Only call this when the peer
+        * supports compression, compressed messages are always accepted from the peer if it is supported.
+        */
+       void enable_compression(uint32_t threshold);
+
        void close_connection();
        void destroy_connection();
 
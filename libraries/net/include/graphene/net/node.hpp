@@ -111,6 +111,13 @@ namespace graphene { namespace net {
           */
          virtual message get_item( const item_id& id ) = 0;
 
+         /**
+          *  Looks up transactions in the pool of pending transactions, used to rebuild compact blocks.
+          *  The result has one entry per id, invalid if the transaction is not pending.
+          */
+         virtual std::vector<fc::optional<signed_transaction>> get_pending_transactions(
+                                                        const std::vector<transaction_id_type>& ids ) = 0;
+
          virtual chain_id_type get_chain_id()const = 0;
 
          /**
@@ -220,6 +227,13 @@ namespace graphene { namespace net {
          */
         void add_seed_node( const std::string& in);
 
+        /**
+         * @brief Add a trusted peer, e.g. another witness, which is kept connected and to which new blocks and
+         *        transactions are pushed without announcing them first
+         * @note Both sides have to list each other, a node disconnects peers which send items it did not request
+         */
+        void add_priority_peer( const fc::ip::endpoint& ep );
+
         /**
          *  Attempt to connect to the specified endpoint immediately.
          */
@@ -37,7 +37,10 @@
 #include <boost/multi_index/tag.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 
+#include <deque>
+#include <map>
 #include <queue>
+#include <unordered_map>
 #include <boost/container/deque.hpp>
 #include <fc/thread/future.hpp>
 
@@ -58,6 +61,63 @@ namespace graphene { namespace net
       node_id_t        requesting_peer;
     };
 
+    /**
+     * A set of item ids with the time they were added, used for the inventories exchanged with peers.  Items are
+     * looked up in a hash table and expired by the minute in which they were added, so adding, finding and
+     * expiring an item take constant time however large the set is.
+     */
+    class timestamped_item_set
+    {
+    public:
+      typedef std::unordered_map<item_id, fc::time_point_sec> map_type;
+      typedef map_type::const_iterator const_iterator;
+
+      const_iterator find(const item_id& item) const { return _items.find(item); }
+      const_iterator end() const { return _items.end(); }
+      size_t size() const { return _items.size(); }
+
+      /// adds an item, an item which is in the set already keeps its time
+      void insert(const item_id& item, fc::time_point_sec timestamp)
+      {
+        if (!_items.emplace(item, timestamp).second)
+          return;
+        const uint32_t minute = timestamp.sec_since_epoch() / 60;
+        if (_minutes.empty() || _minutes.back().first < minute)
+          _minutes.emplace_back(minute, std::vector<item_id>());
+        _minutes.back().second.push_back(item);
+      }
+
+      void erase(const item_id& item) { _items.erase(item); }
+
+      /**
+       * Removes the items added before @p oldest_to_keep.  Items are expired a whole minute at a time, so items of
+       * the minute of @p oldest_to_keep stay until the next call.
+       * @return the number of items removed
+       */
+      size_t expire(fc::time_point_sec oldest_to_keep)
+      {
+        const size_t old_size = _items.size();
+        const uint32_t first_minute_to_keep = oldest_to_keep.sec_since_epoch() / 60;
+        while (!_minutes.empty() && _minutes.front().first < first_minute_to_keep)
+        {
+          for (const item_id& item : _minutes.front().second)
+          {
+            // the item may have been erased, and added again since
+            auto iter = _items.find(item);
+            if (iter != _items.end() && iter->second < oldest_to_keep)
+              _items.erase(iter);
+          }
+          _minutes.pop_front();
+        }
+        return old_size - _items.size();
+      }
+
+    private:
+      map_type                                                  _items;
+      /// the items added in each minute, in the order of the minutes
+      std::deque<std::pair<uint32_t, std::vector<item_id>>>    _minutes;
+    };
+
     class peer_connection;
     class peer_connection_delegate
     {
@@ -120,7 +180,8 @@ namespace graphene { namespace net
           enqueue_time(enqueue_time)
         {}
 
-        virtual message get_message(peer_connection_delegate* node) = 0;
+        /// the returned message stays valid until the queued message is destroyed
+        virtual const message& get_message(peer_connection_delegate* node) = 0;
         /** returns roughly the number of bytes of memory the message is consuming while
          * it is sitting on the queue
          */
@@ -142,7 +203,7 @@ namespace graphene { namespace net
           message_send_time_field_offset(message_send_time_field_offset)
         {}
 
-        message get_message(peer_connection_delegate* node) override;
+        const message& get_message(peer_connection_delegate* node) override;
         size_t get_size_in_queue() override;
       };
 
@@ -153,12 +214,28 @@ namespace graphene { namespace net
       struct virtual_queued_message : queued_message
       {
         item_id item_to_send;
+        message generated_message;
 
         explicit virtual_queued_message(item_id the_item_to_send) :
           item_to_send(std::move(the_item_to_send))
         {}
 
-        message get_message(peer_connection_delegate* node) override;
+        const message& get_message(peer_connection_delegate* node) override;
+        size_t get_size_in_queue() override;
+      };
+
+      /* when you queue up a 'shared_queued_message', the message is shared with the
+       * queues of other peers and the message cache instead of being copied
+       */
+      struct shared_queued_message : queued_message
+      {
+        message_ptr message_to_send;
+
+        explicit shared_queued_message(message_ptr message_to_send) :
+          message_to_send(std::move(message_to_send))
+        {}
+
+        const message& get_message(peer_connection_delegate* node) override;
         size_t get_size_in_queue() override;
       };
 
@@ -175,6 +252,22 @@ namespace graphene { namespace net
       firewalled_state is_firewalled = firewalled_state::unknown;
       fc::microseconds clock_offset;
       fc::microseconds round_trip_delay;
+      /// moving average of the time from a block's timestamp until this peer delivered it during normal operation
+      fc::microseconds block_delivery_latency;
+      uint64_t number_of_items_received = 0;
+      uint64_t number_of_invalid_items = 0;
+      /// moving average of the time from requesting an item from this peer until it arrived
+      fc::microseconds fetch_latency;
+
+      /// traffic of one message type on this connection, sizes are before compression
+      struct message_type_statistics
+      {
+        uint64_t messages_received = 0;
+        uint64_t bytes_received = 0;
+        uint64_t messages_sent = 0;
+        uint64_t bytes_sent = 0;
+      };
+      std::map<uint32_t, message_type_statistics> message_statistics; /// keyed by message type
 
       our_connection_state our_state = our_connection_state::disconnected;
       bool they_have_requested_close = false;
@@ -225,6 +318,9 @@ namespace graphene { namespace net
       fc::optional<boost::tuple<std::vector<item_hash_t>, fc::time_point> > item_ids_requested_from_peer; /// we check this to detect a timed-out request and in busy()
       fc::time_point last_sync_item_received_time; /// the time we received the last sync item or the time we sent the last batch of sync item requests to this peer
       std::set<item_hash_t> sync_items_requested_from_peer; /// ids of blocks we've requested from this peer during sync.  fetch from another peer if this peer disconnects
+      fc::time_point sync_batch_requested_time; /// the time we sent the batch of sync item requests this peer is working on
+      uint32_t sync_batch_size = 0; /// number of items in that batch
+      double sync_blocks_per_second = 0; /// moving average of the rate at which this peer delivered sync batches, 0 if not measured yet
       item_hash_t last_block_delegate_has_seen; /// the hash of the last block  this peer has told us about that the peer knows
       fc::time_point_sec last_block_time_delegate_has_seen;
       bool inhibit_fetching_sync_blocks = false;
@@ -232,25 +328,20 @@ namespace graphene { namespace net
 
       /// non-synchronization state data
       /// @{
-      struct timestamped_item_id
-      {
-        item_id            item;
-        fc::time_point_sec timestamp;
-        timestamped_item_id(const item_id& item, const fc::time_point_sec timestamp) :
-          item(item),
-          timestamp(timestamp)
-        {}
-      };
-      struct timestamp_index{};
-      typedef boost::multi_index_container<timestamped_item_id,
-                                           boost::multi_index::indexed_by<boost::multi_index::hashed_unique<boost::multi_index::member<timestamped_item_id, item_id, &timestamped_item_id::item>,
-                                                                                                            std::hash<item_id> >,
-                                                                          boost::multi_index::ordered_non_unique<boost::multi_index::tag<timestamp_index>,
-                                                                                                                 boost::multi_index::member<timestamped_item_id, fc::time_point_sec, &timestamped_item_id::timestamp> > > > timestamped_items_set_type;
+      typedef timestamped_item_set timestamped_items_set_type;
       timestamped_items_set_type inventory_peer_advertised_to_us;
       timestamped_items_set_type inventory_advertised_to_peer;
 
       item_to_time_map_type items_requested_from_peer;  /// items we've requested from this peer during normal operation.  fetch from another peer if this peer disconnects
+
+      /// a block received as compact_block_message which is waiting for the transactions we did not have
+      struct partial_compact_block
+      {
+        item_hash_t  block_message_hash;
+        signed_block block;
+        std::vector<uint32_t> missing_transaction_indexes;
+      };
+      std::map<block_id_type, partial_compact_block> compact_blocks_waiting_for_transactions;
       /// @}
 
       // if they're flooding us with transactions, we set this to avoid fetching for a few seconds to let the
@@ -283,12 +374,19 @@ namespace graphene { namespace net
 
       void send_queueable_message(std::unique_ptr<queued_message>&& message_to_send);
       void send_message(const message& message_to_send, size_t message_send_time_field_offset = (size_t)-1);
+      void send_message(const message_ptr& message_to_send);
       void send_item(const item_id& item_to_send);
+      /// compress large messages sent to this peer, call it once we know the peer can decompress them
+      void enable_message_compression(uint32_t threshold);
       void close_connection();
       void destroy_connection();
 
       uint64_t get_total_bytes_sent() const;
       uint64_t get_total_bytes_received() const;
+      size_t get_number_of_queued_messages() const { return _queued_messages.size(); }
+      size_t get_total_queued_messages_size() const { return _total_queued_messages_size; }
+      /// folds the time an item took to arrive into fetch_latency
+      void update_fetch_latency(const fc::time_point& request_time);
 
       fc::time_point get_last_message_sent_time() const;
       fc::time_point get_last_message_received_time() const;
@@ -338,4 +436,3 @@ FC_REFLECT_ENUM(graphene::net::peer_connection::connection_negotiation_status, (
                                                                           (closing)
                                                                           (closed) )
 
-FC_REFLECT( graphene::net::peer_connection::timestamped_item_id, (item)(timestamp) )
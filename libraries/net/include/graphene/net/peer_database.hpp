@@ -54,6 +54,20 @@ namespace graphene { namespace net {
     uint32_t                          number_of_failed_connection_attempts;
     fc::optional<fc::exception>       last_error;
 
+    /// Measured while we were connected to the peer, moving averages over past connections, 0 if unknown
+    /// @{
+    int64_t                           round_trip_delay_us = 0;
+    /// time from a block's timestamp until the peer delivered it to us during normal operation
+    int64_t                           block_delivery_latency_us = 0;
+    uint64_t                          bytes_per_second = 0;
+    /// @}
+    uint64_t                          number_of_items_received = 0;
+    /// blocks and transactions from the peer which were rejected
+    uint64_t                          number_of_invalid_items = 0;
+
+    /// Cost of connecting to the peer in milliseconds of expected delay, lower is better
+    int64_t score() const;
+
     potential_peer_record() :
       number_of_successful_connection_attempts(0),
     number_of_failed_connection_attempts(0){}
@@ -32,8 +32,15 @@
 #include <graphene/net/stcp_socket.hpp>
 #include <graphene/net/config.hpp>
 
+#include <boost/endian/buffers.hpp>
+
+#include <algorithm>
 #include <atomic>
 
+#ifdef GRAPHENE_NET_MESSAGE_COMPRESSION
+#include <zlib.h>
+#endif
+
 #ifdef DEFAULT_LOGGER
 # undef DEFAULT_LOGGER
 #endif
@@ -65,12 +72,20 @@ namespace graphene { namespace net {
 
       std::atomic_bool _send_message_in_progress;
       std::atomic_bool _read_loop_in_progress;
+
+      /// 0 while compression is not enabled
+      uint32_t _compression_threshold = 0;
 #ifndef NDEBUG
       fc::thread* _thread;
 #endif
 
       void read_loop();
       void start_read_loop();
+
+      void send_framed_message(const message& message_to_send);
+      /// @return false if compression doesn't make @p m smaller
+      bool compress(const message& m, message& compressed) const;
+      void decompress(message& m) const;
     public:
       fc::tcp_socket& get_socket();
       void accept();
@@ -82,6 +97,7 @@ namespace graphene { namespace net {
       ~message_oriented_connection_impl();
 
       void send_message(const message& message_to_send);
+      void enable_compression(uint32_t threshold);
       void close_connection();
       void destroy_connection();
 
@@ -193,6 +209,8 @@ namespace graphene { namespace net {
             _bytes_received += remaining_bytes_with_padding;
           }
           m.data.resize(m.size.value()); // truncate off the padding bytes
+          if (m.msg_type.value() & GRAPHENE_NET_COMPRESSED_MESSAGE_FLAG)
+            decompress(m);
 
           _last_message_received_time = fc::time_point::now();
 
@@ -266,6 +284,19 @@ namespace graphene { namespace net {
       no_parallel_execution_guard guard( &_send_message_in_progress );
       _ready_for_sending->wait();
 
+      message compressed_message;
+      if (_compression_threshold > 0 && message_to_send.size.value() >= _compression_threshold &&
+          compress(message_to_send, compressed_message))
+      {
+        send_framed_message(compressed_message);
+        return;
+      }
+      send_framed_message(message_to_send);
+    }
+
+    void message_oriented_connection_impl::send_framed_message(const message& message_to_send)
+    {
+      VERIFY_CORRECT_THREAD();
       try
       {
         size_t size_of_message_and_header = sizeof(message_header) + message_to_send.size.value();
@@ -287,6 +318,58 @@ namespace graphene { namespace net {
       } FC_RETHROW_EXCEPTIONS( warn, "unable to send message" )
     }
 
+    // a compressed message carries the uncompressed size followed by the zlib stream, the msg_type is the
+    // original one with GRAPHENE_NET_COMPRESSED_MESSAGE_FLAG set
+    bool message_oriented_connection_impl::compress(const message& m, message& compressed) const
+    {
+#ifdef GRAPHENE_NET_MESSAGE_COMPRESSION
+      const size_t prefix_size = sizeof(boost::endian::little_uint32_buf_t);
+      uLongf compressed_size = compressBound(m.size.value());
+      compressed.data.resize(prefix_size + compressed_size);
+      if (compress2(reinterpret_cast<Bytef*>(compressed.data.data() + prefix_size), &compressed_size,
+                    reinterpret_cast<const Bytef*>(m.data.data()), m.size.value(), Z_BEST_SPEED) != Z_OK ||
+          prefix_size + compressed_size >= m.size.value())
+        return false;
+      boost::endian::little_uint32_buf_t uncompressed_size(m.size.value());
+      memcpy(compressed.data.data(), &uncompressed_size, prefix_size);
+      compressed.data.resize(prefix_size + compressed_size);
+      compressed.size = (uint32_t)compressed.data.size();
+      compressed.msg_type = m.msg_type.value() | GRAPHENE_NET_COMPRESSED_MESSAGE_FLAG;
+      return true;
+#else
+      return false;
+#endif
+    }
+
+    void message_oriented_connection_impl::decompress(message& m) const
+    {
+#ifdef GRAPHENE_NET_MESSAGE_COMPRESSION
+      const size_t prefix_size = sizeof(boost::endian::little_uint32_buf_t);
+      FC_ASSERT( m.data.size() >= prefix_size, "Compressed message is too short" );
+      boost::endian::little_uint32_buf_t uncompressed_size;
+      memcpy(&uncompressed_size, m.data.data(), prefix_size);
+      FC_ASSERT( uncompressed_size.value() <= MAX_MESSAGE_SIZE, "",
+                 ("uncompressed_size", uncompressed_size.value())("MAX_MESSAGE_SIZE", MAX_MESSAGE_SIZE) );
+      std::vector<char> data(uncompressed_size.value());
+      uLongf data_size = data.size();
+      FC_ASSERT( uncompress(reinterpret_cast<Bytef*>(data.data()), &data_size,
+                            reinterpret_cast<const Bytef*>(m.data.data() + prefix_size),
+                            m.data.size() - prefix_size) == Z_OK && data_size == data.size(),
+                 "Unable to decompress message" );
+      m.data = std::move(data);
+      m.size = (uint32_t)m.data.size();
+      m.msg_type = m.msg_type.value() & ~GRAPHENE_NET_COMPRESSED_MESSAGE_FLAG;
+#else
+      FC_THROW( "Received a compressed message, but this build does not support compression" );
+#endif
+    }
+
+    void message_oriented_connection_impl::enable_compression(uint32_t threshold)
+    {
+      VERIFY_CORRECT_THREAD();
+      _compression_threshold = std::max<uint32_t>(threshold, 1);
+    }
+
     void message_oriented_connection_impl::close_connection()
     {
       VERIFY_CORRECT_THREAD();
@@ -389,6 +472,20 @@ namespace graphene { namespace net {
     my->send_message(message_to_send);
   }
 
+  bool message_oriented_connection::compression_supported()
+  {
+#ifdef GRAPHENE_NET_MESSAGE_COMPRESSION
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  void message_oriented_connection::enable_compression(uint32_t threshold)
+  {
+    my->enable_compression(threshold);
+  }
+
   void message_oriented_connection::close_connection()
   {
     my->close_connection();
@@ -31,6 +31,7 @@
 #include <algorithm>
 #include <tuple>
 #include <string>
+#include <thread>
 #include <boost/tuple/tuple.hpp>
 #include <boost/circular_buffer.hpp>
 
@@ -101,19 +102,29 @@ namespace graphene { namespace net { namespace detail {
                _message_cache.get<block_clock_index>().lower_bound(block_clock - cache_duration_in_blocks ) );
    }
 
-   void blockchain_tied_message_cache::cache_message( const message& message_to_cache,
+   void blockchain_tied_message_cache::cache_message( message_ptr message_to_cache,
                                                       const message_hash_type& hash_of_message_to_cache,
                                                       const message_propagation_data& propagation_data,
                                                       const message_hash_type& message_content_hash )
    {
       _message_cache.insert( message_info(hash_of_message_to_cache,
-                                         message_to_cache,
+                                         std::move(message_to_cache),
                                          block_clock,
                                          propagation_data,
                                          message_content_hash ) );
    }
 
    message blockchain_tied_message_cache::get_message( const message_hash_type& hash_of_message_to_lookup ) const
+   {
+      message_cache_container::index<message_hash_index>::type::const_iterator iter =
+         _message_cache.get<message_hash_index>().find(hash_of_message_to_lookup );
+      if( iter != _message_cache.get<message_hash_index>().end() )
+         return *iter->message_body;
+      FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
+   }
+
+   message_ptr blockchain_tied_message_cache::get_shared_message(
+         const message_hash_type& hash_of_message_to_lookup ) const
    {
       message_cache_container::index<message_hash_index>::type::const_iterator iter =
          _message_cache.get<message_hash_index>().find(hash_of_message_to_lookup );
@@ -122,6 +133,16 @@ namespace graphene { namespace net { namespace detail {
       FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
    }
 
+   message_hash_type blockchain_tied_message_cache::get_message_contents_hash(
+         const message_hash_type& hash_of_message_to_lookup ) const
+   {
+      message_cache_container::index<message_hash_index>::type::const_iterator iter =
+         _message_cache.get<message_hash_index>().find(hash_of_message_to_lookup );
+      if( iter != _message_cache.get<message_hash_index>().end() )
+         return iter->message_contents_hash;
+      FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
+   }
+
     message_propagation_data blockchain_tied_message_cache::get_message_propagation_data(
              const message_hash_type& hash_of_msg_contents_to_lookup ) const
     {
@@ -186,6 +207,7 @@ namespace graphene { namespace net { namespace detail {
                if (updated_peer_record)
                {
                   updated_peer_record->last_seen_time = fc::time_point::now();
+                  update_peer_record_metrics(*updated_peer_record, *active_peer);
                   _potential_peer_db.update_entry(*updated_peer_record);
                }
             }
@@ -204,6 +226,39 @@ namespace graphene { namespace net { namespace detail {
       ilog( "done" );
     }
 
+    void node_impl::update_peer_record_metrics(potential_peer_record& record, const peer_connection& peer) const
+    {
+      VERIFY_CORRECT_THREAD();
+      auto average = [](int64_t old_value, int64_t new_value) {
+        return old_value > 0 ? (3 * old_value + new_value) / 4 : new_value;
+      };
+      if (peer.round_trip_delay.count() > 0)
+        record.round_trip_delay_us = average(record.round_trip_delay_us, peer.round_trip_delay.count());
+      if (peer.block_delivery_latency.count() > 0)
+        record.block_delivery_latency_us = average(record.block_delivery_latency_us,
+                                                   peer.block_delivery_latency.count());
+      const int64_t connected_us = (fc::time_point::now() - peer.get_connection_time()).count();
+      if (connected_us > fc::seconds(GRAPHENE_NET_PEER_HANDSHAKE_INACTIVITY_TIMEOUT).count())
+        record.bytes_per_second = average(record.bytes_per_second,
+                                          peer.get_total_bytes_received() * 1000000 / connected_us);
+      record.number_of_items_received += peer.number_of_items_received;
+      record.number_of_invalid_items += peer.number_of_invalid_items;
+    }
+
+    fc::thread& node_impl::next_message_worker_thread()
+    {
+      VERIFY_CORRECT_THREAD();
+      if (_message_worker_threads.empty())
+      {
+        const uint32_t thread_count = std::max<uint32_t>(1, std::min<uint32_t>(GRAPHENE_NET_MAX_MESSAGE_WORKER_THREADS,
+                                                                             std::thread::hardware_concurrency() / 2));
+        for (uint32_t i = 0; i < thread_count; ++i)
+          _message_worker_threads.push_back(std::make_shared<fc::thread>("p2p_worker_" + std::to_string(i)));
+      }
+      _next_message_worker_thread = (_next_message_worker_thread + 1) % _message_worker_threads.size();
+      return *_message_worker_threads[_next_message_worker_thread];
+    }
+
     void node_impl::save_node_configuration()
     {
       VERIFY_CORRECT_THREAD();
@@ -259,14 +314,26 @@ namespace graphene { namespace net { namespace detail {
             dlog("Done processing \"add once\" node list");
           }
 
+          // priority peers bypass the connection limits too, reconnect them whenever the connection was lost
+          for (const fc::ip::endpoint& priority_peer : _priority_peers)
+          {
+            if (is_connected_to_priority_peer(priority_peer))
+              continue;
+            fc::optional<potential_peer_record> priority_peer_record
+                  = _potential_peer_db.lookup_entry_for_endpoint(priority_peer);
+            if (!priority_peer_record || fc::time_point::now() - priority_peer_record->last_connection_attempt_time
+                                         > fc::seconds(_peer_connection_retry_timeout))
+              connect_to_endpoint(priority_peer);
+          }
+
           while (is_wanting_new_connections())
           {
             bool initiated_connection_this_pass = false;
             _potential_peer_db_updated = false;
 
-            for (peer_database::iterator iter = _potential_peer_db.begin();
-                 iter != _potential_peer_db.end() && is_wanting_new_connections();
-                 ++iter)
+            // try the candidates with the lowest measured delays first
+            std::vector<potential_peer_record> candidates;
+            for (peer_database::iterator iter = _potential_peer_db.begin(); iter != _potential_peer_db.end(); ++iter)
             {
               fc::microseconds delay_until_retry = fc::seconds( (iter->number_of_failed_connection_attempts + 1)
                                                                 * _peer_connection_retry_timeout );
@@ -276,10 +343,20 @@ namespace graphene { namespace net { namespace detail {
                     iter->last_connection_disposition != last_connection_rejected &&
                     iter->last_connection_disposition != last_connection_handshaking_failed) ||
                    (fc::time_point::now() - iter->last_connection_attempt_time) > delay_until_retry))
-              {
-                connect_to_endpoint(iter->endpoint);
-                initiated_connection_this_pass = true;
-              }
+                candidates.push_back(*iter);
+            }
+            std::stable_sort(candidates.begin(), candidates.end(),
+                             [](const potential_peer_record& a, const potential_peer_record& b) {
+                               const int64_t a_score = a.score();
+                               const int64_t b_score = b.score();
+                               return a_score < b_score || (a_score == b_score && a.bytes_per_second > b.bytes_per_second);
+                             });
+            for (const potential_peer_record& candidate : candidates)
+            {
+              if (!is_wanting_new_connections())
+                break;
+              connect_to_endpoint(candidate.endpoint);
+              initiated_connection_this_pass = true;
             }
 
             if (!initiated_connection_this_pass && !_potential_peer_db_updated)
@@ -391,6 +468,30 @@ namespace graphene { namespace net { namespace detail {
       peer->send_message( fetch_items_message(item_id_to_request.item_type, std::vector<item_hash_t>{item_id_to_request.item_hash} ) );
     }
 
+    bool node_impl::is_duplicate_of_rerequested_sync_item( const item_hash_t& item_hash )
+    {
+      VERIFY_CORRECT_THREAD();
+      if (_rerequested_sync_items.find(item_hash) == _rerequested_sync_items.end())
+        return false;
+      bool duplicate = have_already_received_sync_item(item_hash);
+      if (!duplicate)
+      {
+        // blocks which were already pushed to the client are no longer in any peer's list
+        duplicate = true;
+        fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
+        for (const peer_connection_ptr& peer : _active_connections)
+          if (std::find(peer->ids_of_items_to_get.begin(), peer->ids_of_items_to_get.end(), item_hash)
+              != peer->ids_of_items_to_get.end())
+          {
+            duplicate = false;
+            break;
+          }
+      }
+      if (duplicate)
+        _rerequested_sync_items.erase(item_hash);
+      return duplicate;
+    }
+
     void node_impl::request_sync_items_from_peer( const peer_connection_ptr& peer, const std::vector<item_hash_t>& items_to_request )
     {
       VERIFY_CORRECT_THREAD();
@@ -402,9 +503,25 @@ namespace graphene { namespace net { namespace detail {
         peer->last_sync_item_received_time = fc::time_point::now();
         peer->sync_items_requested_from_peer.insert(item_to_request);
       }
+      peer->sync_batch_requested_time = fc::time_point::now();
+      peer->sync_batch_size = items_to_request.size();
       peer->send_message(fetch_items_message(graphene::net::block_message_type, items_to_request));
     }
 
+    void node_impl::update_sync_throughput(peer_connection* peer)
+    {
+      VERIFY_CORRECT_THREAD();
+      if (peer->sync_batch_size == 0)
+        return;
+      int64_t elapsed_us = std::max<int64_t>((fc::time_point::now() - peer->sync_batch_requested_time).count(), 1);
+      double blocks_per_second = peer->sync_batch_size * 1000000.0 / elapsed_us;
+      if (peer->sync_blocks_per_second > 0)
+        peer->sync_blocks_per_second = 0.75 * peer->sync_blocks_per_second + 0.25 * blocks_per_second;
+      else
+        peer->sync_blocks_per_second = blocks_per_second;
+      peer->sync_batch_size = 0;
+    }
+
     void node_impl::fetch_sync_items_loop()
     {
       VERIFY_CORRECT_THREAD();
@@ -413,6 +530,9 @@ namespace graphene { namespace net { namespace detail {
         _sync_items_to_fetch_updated = false;
         dlog( "beginning another iteration of the sync items loop" );
 
+        if (_active_sync_requests.empty())
+          _rerequested_sync_items.clear();
+
         if (!_suspend_fetching_sync_blocks)
         {
           std::map<peer_connection_ptr, std::vector<item_hash_t> > sync_item_requests_to_send;
@@ -420,8 +540,18 @@ namespace graphene { namespace net { namespace detail {
           {
             std::set<item_hash_t> sync_items_to_request;
 
-            // for each idle peer that we're syncing with
             fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
+
+            // peers get a share of the blocks according to their throughput, so that the slow ones
+            // don't hold large ranges the fast ones have to wait for
+            double fastest_sync_peer_rate = 0;
+            for( const peer_connection_ptr& peer : _active_connections )
+              if( peer->we_need_sync_items_from_peer )
+                fastest_sync_peer_rate = std::max(fastest_sync_peer_rate, peer->sync_blocks_per_second);
+            const size_t min_sync_blocks_per_peer = std::min<size_t>(_max_sync_blocks_per_peer,
+                                                                     GRAPHENE_NET_MIN_BLOCKS_PER_PEER_DURING_SYNCING);
+
+            // for each idle peer that we're syncing with
             for( const peer_connection_ptr& peer : _active_connections )
             {
               if( peer->we_need_sync_items_from_peer &&
@@ -431,6 +561,10 @@ namespace graphene { namespace net { namespace detail {
               {
                 if (!peer->inhibit_fetching_sync_blocks)
                 {
+                  size_t max_blocks_for_peer = _max_sync_blocks_per_peer;
+                  if (peer->sync_blocks_per_second > 0 && fastest_sync_peer_rate > 0)
+                    max_blocks_for_peer = std::max(min_sync_blocks_per_peer,
+                          static_cast<size_t>(_max_sync_blocks_per_peer * peer->sync_blocks_per_second / fastest_sync_peer_rate));
                   // loop through the items it has that we don't yet have on our blockchain
                   for( const auto& item_to_potentially_request : peer->ids_of_items_to_get )
                   {
@@ -446,13 +580,50 @@ namespace graphene { namespace net { namespace detail {
                       // then schedule a request from this peer
                       sync_item_requests_to_send[peer].push_back(item_to_potentially_request);
                       sync_items_to_request.insert( item_to_potentially_request );
-                      if (sync_item_requests_to_send[peer].size() >= _max_sync_blocks_per_peer)
+                      if (sync_item_requests_to_send[peer].size() >= max_blocks_for_peer)
                         break;
                     }
                   }
                 }
               }
             }
+
+            // peers which are left idle take over the requests a slow peer has been sitting on, oldest
+            // blocks first because they hold up the processing of all blocks after them
+            const fc::time_point straggler_threshold = fc::time_point::now()
+                                                       - fc::seconds(GRAPHENE_NET_SYNC_STRAGGLER_TIMEOUT_SEC);
+            std::vector<std::pair<uint32_t, item_hash_t>> stragglers;
+            for( const auto& request : _active_sync_requests )
+              if( request.second < straggler_threshold &&
+                  _rerequested_sync_items.find(request.first) == _rerequested_sync_items.end() )
+                stragglers.emplace_back(graphene::protocol::block_header::num_from_id(request.first), request.first);
+            std::sort(stragglers.begin(), stragglers.end());
+
+            for( const peer_connection_ptr& peer : _active_connections )
+            {
+              if( stragglers.empty() )
+                break;
+              if( !peer->we_need_sync_items_from_peer || peer->inhibit_fetching_sync_blocks || !peer->idle() ||
+                  sync_item_requests_to_send.find(peer) != sync_item_requests_to_send.end() )
+                continue;
+              for( auto straggler_iter = stragglers.begin(); straggler_iter != stragglers.end(); )
+              {
+                const item_hash_t& item = straggler_iter->second;
+                if( std::find(peer->ids_of_items_to_get.begin(), peer->ids_of_items_to_get.end(), item)
+                    == peer->ids_of_items_to_get.end() )
+                {
+                  ++straggler_iter;
+                  continue;
+                }
+                dlog("requesting sync item ${id} again from peer ${endpoint}, the first request is too slow",
+                     ("id", item)("endpoint", peer->get_remote_endpoint()));
+                _rerequested_sync_items.insert(item);
+                sync_item_requests_to_send[peer].push_back(item);
+                straggler_iter = stragglers.erase(straggler_iter);
+                if (sync_item_requests_to_send[peer].size() >= min_sync_blocks_per_peer)
+                  break;
+              }
+            }
           } // end non-preemptable section
 
           // make all the requests we scheduled in the loop above
@@ -468,7 +639,17 @@ namespace graphene { namespace net { namespace detail {
           dlog( "no sync items to fetch right now, going to sleep" );
           _retrigger_fetch_sync_items_loop_promise
                 = fc::promise<void>::create("graphene::net::retrigger_fetch_sync_items_loop");
-          _retrigger_fetch_sync_items_loop_promise->wait();
+          // wake up while requests are outstanding, to look for stragglers
+          try
+          {
+            if( _active_sync_requests.empty() )
+              _retrigger_fetch_sync_items_loop_promise->wait();
+            else
+              _retrigger_fetch_sync_items_loop_promise->wait(fc::seconds(GRAPHENE_NET_SYNC_STRAGGLER_TIMEOUT_SEC));
+          }
+          catch (const fc::timeout_exception&)
+          {
+          }
           _retrigger_fetch_sync_items_loop_promise.reset();
         }
       } // while( !canceled )
@@ -556,7 +737,14 @@ namespace graphene { namespace net { namespace detail {
             {
               const peer_connection_ptr& peer = peer_iter->peer;
               // if they have the item and we haven't already decided to ask them for too many other items
-              if (peer_iter->item_ids.size() < GRAPHENE_NET_MAX_ITEMS_PER_PEER_DURING_NORMAL_OPERATION &&
+              // transactions are fetched in batches, other items (blocks) must not wait behind them
+              const bool is_transaction = item_iter->item.item_type == graphene::net::trx_message_type;
+              const size_t max_items_for_peer = is_transaction ? _max_transactions_per_fetch
+                                                               : GRAPHENE_NET_MAX_ITEMS_PER_PEER_DURING_NORMAL_OPERATION;
+              const size_t items_for_peer = is_transaction ? peer_iter->item_ids.size()
+                    : std::count_if(peer_iter->item_ids.begin(), peer_iter->item_ids.end(), [](const item_id& item) {
+                         return item.item_type != graphene::net::trx_message_type; });
+              if (items_for_peer < max_items_for_peer &&
                   peer->inventory_peer_advertised_to_us.find(item_iter->item) != peer->inventory_peer_advertised_to_us.end())
               {
                 if (item_iter->item.item_type == graphene::net::trx_message_type && peer->is_transaction_fetching_inhibited())
@@ -637,6 +825,22 @@ namespace graphene { namespace net { namespace detail {
       while (!_advertise_inventory_loop_done.canceled())
       {
         dlog("beginning an iteration of advertise inventory");
+        // let a burst of transactions accumulate, so that each peer gets one inventory message for all of them
+        if (_inventory_flush_interval_ms > 0 && !_block_inventory_pending)
+        {
+          fc::promise<void>::ptr flush_promise = fc::promise<void>::create("graphene::net::flush_inventory");
+          _flush_inventory_promise = flush_promise;
+          try
+          {
+            flush_promise->wait(fc::milliseconds(_inventory_flush_interval_ms));
+          }
+          catch (const fc::timeout_exception&)
+          {
+          }
+          _flush_inventory_promise.reset();
+        }
+        _block_inventory_pending = false;
+
         // swap inventory into local variable, clearing the node's copy
         std::unordered_set<item_id> inventory_to_advertise;
         _new_inventory.swap( inventory_to_advertise );
@@ -668,8 +872,7 @@ namespace graphene { namespace net { namespace detail {
                   adv_to_us == peer->inventory_peer_advertised_to_us.end())
               {
                 items_to_advertise_by_type[item_to_advertise.item_type].push_back(item_to_advertise.item_hash);
-                peer->inventory_advertised_to_peer.insert(
-                         peer_connection::timestamped_item_id(item_to_advertise, fc::time_point::now()));
+                peer->inventory_advertised_to_peer.insert(item_to_advertise, fc::time_point::now());
                 ++total_items_to_send;
                 if (item_to_advertise.item_type == trx_message_type)
                   testnetlog("advertising transaction ${id} to peer ${endpoint}",
@@ -680,9 +883,9 @@ namespace graphene { namespace net { namespace detail {
               else
               {
                  if (adv_to_peer != peer->inventory_advertised_to_peer.end() )
-                    idump( (*adv_to_peer) );
+                    idump( (item_to_advertise)(adv_to_peer->second) );
                  if (adv_to_us != peer->inventory_peer_advertised_to_us.end() )
-                    idump( (*adv_to_us) );
+                    idump( (item_to_advertise)(adv_to_us->second) );
               }
             }
               dlog("advertising ${count} new item(s) of ${types} type(s) to peer ${endpoint}",
@@ -986,11 +1189,7 @@ namespace graphene { namespace net { namespace detail {
       // this has nothing to do with updating the peer list, but we need to prune this list 
       // at regular intervals, this is a fine place to do it.
       fc::time_point_sec oldest_failed_ids_to_keep(fc::time_point::now() - fc::minutes(15));
-      auto oldest_failed_ids_to_keep_iter = _recently_failed_items.get<peer_connection::timestamp_index>()
-                                                                  .lower_bound(oldest_failed_ids_to_keep);
-      auto begin_iter = _recently_failed_items.get<peer_connection::timestamp_index>().begin();
-      _recently_failed_items.get<peer_connection::timestamp_index>()
-                            .erase(begin_iter, oldest_failed_ids_to_keep_iter);
+      _recently_failed_items.expire(oldest_failed_ids_to_keep);
 
       if (!_node_is_shutting_down && !_fetch_updated_peer_lists_loop_done.canceled() )
          _fetch_updated_peer_lists_loop_done = fc::schedule( [this](){ fetch_updated_peer_lists_loop(); },
@@ -1252,7 +1451,21 @@ namespace graphene { namespace net { namespace detail {
     void node_impl::on_message( peer_connection* originating_peer, const message& received_message )
     {
       VERIFY_CORRECT_THREAD();
-      message_hash_type message_hash = received_message.id();
+      message_hash_type message_hash;
+      fc::optional<graphene::net::block_message> unpacked_block;
+      if (received_message.size.value() >= GRAPHENE_NET_WORKER_THREAD_MESSAGE_SIZE)
+      {
+        // hashing and unpacking are pure functions of the message, do them on a worker thread so that
+        // this thread can serve other peers meanwhile.  Messages from this peer are still handled in order
+        const bool is_block = received_message.msg_type.value() == core_message_type_enum::block_message_type;
+        next_message_worker_thread().async([&received_message, &message_hash, &unpacked_block, is_block]() {
+          message_hash = received_message.id();
+          if (is_block)
+            unpacked_block = received_message.as<graphene::net::block_message>();
+        }, "unpack large message").wait();
+      }
+      else
+        message_hash = received_message.id();
       dlog("handling message ${type} ${hash} size ${size} from peer ${endpoint}",
            ("type", graphene::net::core_message_type_enum(received_message.msg_type.value()))("hash", message_hash)
            ("size", received_message.size)
@@ -1295,7 +1508,22 @@ namespace graphene { namespace net { namespace detail {
         on_closing_connection_message(originating_peer, received_message.as<closing_connection_message>());
         break;
       case core_message_type_enum::block_message_type:
-        process_block_message(originating_peer, received_message, message_hash);
+        if (unpacked_block)
+          process_block_message(originating_peer, *unpacked_block, message_hash, &received_message);
+        else
+          process_block_message(originating_peer, received_message.as<graphene::net::block_message>(), message_hash,
+                                &received_message);
+        break;
+      case core_message_type_enum::compact_block_message_type:
+        on_compact_block_message(originating_peer, received_message.as<compact_block_message>());
+        break;
+      case core_message_type_enum::fetch_compact_block_transactions_message_type:
+        on_fetch_compact_block_transactions_message(originating_peer,
+                                                    received_message.as<fetch_compact_block_transactions_message>());
+        break;
+      case core_message_type_enum::compact_block_transactions_message_type:
+        on_compact_block_transactions_message(originating_peer,
+                                              received_message.as<compact_block_transactions_message>());
         break;
       case core_message_type_enum::current_time_request_message_type:
         on_current_time_request_message(originating_peer, received_message.as<current_time_request_message>());
@@ -1358,6 +1586,9 @@ namespace graphene { namespace net { namespace detail {
       if (!_hard_fork_block_numbers.empty())
         user_data["last_known_fork_block_number"] = _hard_fork_block_numbers.back();
 
+      if (message_oriented_connection::compression_supported())
+        user_data["message_compression"] = "zlib";
+
       return user_data;
     }
     void node_impl::parse_hello_user_data_for_peer(peer_connection* originating_peer, const fc::variant_object& user_data)
@@ -1382,6 +1613,10 @@ namespace graphene { namespace net { namespace detail {
         originating_peer->node_id = user_data["node_id"].as<node_id_t>(1);
       if (user_data.contains("last_known_fork_block_number"))
         originating_peer->last_known_fork_block_number = user_data["last_known_fork_block_number"].as<uint32_t>(1);
+      if (user_data.contains("message_compression") &&
+          user_data["message_compression"].as_string() == "zlib" &&
+          message_oriented_connection::compression_supported())
+        originating_peer->enable_message_compression(GRAPHENE_NET_MESSAGE_COMPRESSION_THRESHOLD);
     }
 
     void node_impl::on_hello_message( peer_connection* originating_peer, const hello_message& hello_message_received )
@@ -2281,20 +2516,38 @@ namespace graphene { namespace net { namespace detail {
            ("type", fetch_items_message_received.item_type)
            ("endpoint", originating_peer->get_remote_endpoint()));
 
-      fc::optional<message> last_block_message_sent;
+      fc::optional<item_hash_t> last_block_id_sent;
 
-      std::list<message> reply_messages;
+      // cached messages are shared with the queues of all peers which fetch them, blocks provided by the
+      // delegate are only generated again when they reach the head of the send queue
+      struct reply
+      {
+        message_ptr message_to_send;
+        item_id     item_to_send;
+      };
+      std::list<reply> reply_messages;
       for (const item_hash_t& item_hash : fetch_items_message_received.items_to_fetch)
       {
         try
         {
-          message requested_message = _message_cache.get_message(item_hash);
+          message_ptr requested_message = _message_cache.get_shared_message(item_hash);
           dlog("received item request for item ${id} from peer ${endpoint}, returning the item from my message cache",
                ("endpoint", originating_peer->get_remote_endpoint())
-               ("id", requested_message.id()));
-          reply_messages.push_back(requested_message);
+               ("id", item_hash));
           if (fetch_items_message_received.item_type == block_message_type)
-            last_block_message_sent = requested_message;
+          {
+            last_block_id_sent = _message_cache.get_message_contents_hash(item_hash);
+            // the message cache only holds blocks we recently broadcast, the peer very likely has their
+            // transactions already.  Blocks fetched by id (syncing, or the fallback of a compact block
+            // which did not rebuild) are not found in the cache and are always sent in full
+            if (originating_peer->core_protocol_version >= GRAPHENE_NET_COMPACT_BLOCK_PROTOCOL_VERSION)
+            {
+              reply_messages.push_back({std::make_shared<const message>(
+                    compact_block_message(requested_message->as<block_message>().block, item_hash)), item_id()});
+              continue;
+            }
+          }
+          reply_messages.push_back({requested_message, item_id()});
           continue;
         }
         catch (fc::key_not_found_exception&)
@@ -2310,36 +2563,146 @@ namespace graphene { namespace net { namespace detail {
                ("id", requested_message.id())
                ("size", requested_message.size)
                ("endpoint", originating_peer->get_remote_endpoint()));
-          reply_messages.push_back(requested_message);
           if (fetch_items_message_received.item_type == block_message_type)
-            last_block_message_sent = requested_message;
+          {
+            // blocks which are not cached are fetched by block id
+            last_block_id_sent = item_hash;
+            reply_messages.push_back({message_ptr(), item_to_fetch});
+          }
+          else
+            reply_messages.push_back({std::make_shared<const message>(std::move(requested_message)), item_id()});
           continue;
         }
         catch (fc::key_not_found_exception&)
         {
-          reply_messages.push_back(item_not_available_message(item_to_fetch));
+          reply_messages.push_back({std::make_shared<const message>(item_not_available_message(item_to_fetch)),
+                                    item_id()});
           dlog("received item request from peer ${endpoint} but we don't have it",
                ("endpoint", originating_peer->get_remote_endpoint()));
         }
       }
 
       // if we sent them a block, update our record of the last block they've seen accordingly
-      if (last_block_message_sent)
+      if (last_block_id_sent)
       {
-        graphene::net::block_message block = last_block_message_sent->as<graphene::net::block_message>();
-        originating_peer->last_block_delegate_has_seen = block.block_id;
-        originating_peer->last_block_time_delegate_has_seen = _delegate->get_block_time(block.block_id);
+        originating_peer->last_block_delegate_has_seen = *last_block_id_sent;
+        originating_peer->last_block_time_delegate_has_seen = _delegate->get_block_time(*last_block_id_sent);
       }
 
-      for (const message& reply : reply_messages)
+      for (const reply& reply_to_send : reply_messages)
       {
-        if (reply.msg_type.value() == block_message_type)
-          originating_peer->send_item(item_id(block_message_type, reply.as<graphene::net::block_message>().block_id));
+        if (reply_to_send.message_to_send)
+          originating_peer->send_message(reply_to_send.message_to_send);
         else
-          originating_peer->send_message(reply);
+          originating_peer->send_item(reply_to_send.item_to_send);
       }
     }
 
+    void node_impl::on_compact_block_message(peer_connection* originating_peer,
+                                             const compact_block_message& compact_block_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      const compact_block_message& compact = compact_block_message_received;
+      if (originating_peer->items_requested_from_peer.find(item_id(block_message_type, compact.block_message_hash))
+          == originating_peer->items_requested_from_peer.end())
+      {
+        wlog("received a compact block ${id} we did not request from peer ${endpoint}, ignoring it",
+             ("id", compact.block_id)("endpoint", originating_peer->get_remote_endpoint()));
+        return;
+      }
+
+      peer_connection::partial_compact_block partial;
+      partial.block_message_hash = compact.block_message_hash;
+      static_cast<graphene::protocol::signed_block_header&>(partial.block) = compact.header;
+      if (compact.transaction_ids.size() != compact.operation_results.size())
+      {
+        // leave the block empty, it fails verification and the full block is fetched
+        process_rebuilt_compact_block(originating_peer, partial.block_message_hash, partial.block);
+        return;
+      }
+
+      std::vector<fc::optional<signed_transaction>> pending_transactions;
+      if (!compact.transaction_ids.empty())
+        pending_transactions = _delegate->get_pending_transactions(compact.transaction_ids);
+      partial.missing_transaction_indexes = compact.rebuild(partial.block, pending_transactions);
+
+      dlog("received compact block ${id} with ${n} transactions from peer ${endpoint}, ${missing} of them are missing",
+           ("id", compact.block_id)("n", compact.transaction_ids.size())
+           ("endpoint", originating_peer->get_remote_endpoint())
+           ("missing", partial.missing_transaction_indexes.size()));
+      if (partial.missing_transaction_indexes.empty())
+      {
+        process_rebuilt_compact_block(originating_peer, partial.block_message_hash, partial.block);
+        return;
+      }
+      originating_peer->send_message(fetch_compact_block_transactions_message(compact.block_id,
+                                                                              partial.missing_transaction_indexes));
+      originating_peer->compact_blocks_waiting_for_transactions[compact.block_id] = std::move(partial);
+    }
+
+    void node_impl::on_fetch_compact_block_transactions_message(peer_connection* originating_peer,
+                                                                const fetch_compact_block_transactions_message& request) const
+    {
+      VERIFY_CORRECT_THREAD();
+      compact_block_transactions_message reply;
+      reply.block_id = request.block_id;
+      try
+      {
+        const signed_block block = _delegate->get_item(item_id(block_message_type, request.block_id))
+                                            .as<block_message>().block;
+        for (uint32_t index : request.transaction_indexes)
+        {
+          if (index >= block.transactions.size())
+            continue;
+          reply.transaction_indexes.push_back(index);
+          reply.transactions.push_back(block.transactions[index]);
+        }
+      }
+      catch (const fc::exception& e)
+      {
+        // an empty reply makes the peer fall back to fetching the full block
+        dlog("peer ${endpoint} requested transactions of block ${id} which is not available: ${e}",
+             ("endpoint", originating_peer->get_remote_endpoint())("id", request.block_id)("e", e));
+      }
+      originating_peer->send_message(reply);
+    }
+
+    void node_impl::on_compact_block_transactions_message(peer_connection* originating_peer,
+                                                          const compact_block_transactions_message& reply)
+    {
+      VERIFY_CORRECT_THREAD();
+      auto partial_iter = originating_peer->compact_blocks_waiting_for_transactions.find(reply.block_id);
+      if (partial_iter == originating_peer->compact_blocks_waiting_for_transactions.end())
+        return;
+      peer_connection::partial_compact_block partial = std::move(partial_iter->second);
+      originating_peer->compact_blocks_waiting_for_transactions.erase(partial_iter);
+
+      reply.add_to(partial.block);
+      process_rebuilt_compact_block(originating_peer, partial.block_message_hash, partial.block);
+    }
+
+    void node_impl::process_rebuilt_compact_block(peer_connection* originating_peer,
+                                                  const item_hash_t& block_message_hash,
+                                                  const signed_block& block)
+    {
+      VERIFY_CORRECT_THREAD();
+      // the merkle root covers signatures and operation results, a block which matches it is the
+      // block the peer has and serializes to the message it advertised
+      if (block.calculate_merkle_root() == block.transaction_merkle_root)
+      {
+        block_message rebuilt_block_message(block);
+        const message packed_block_message(rebuilt_block_message);
+        if (packed_block_message.id() == block_message_hash)
+        {
+          process_block_message(originating_peer, rebuilt_block_message, block_message_hash, &packed_block_message);
+          return;
+        }
+      }
+      wlog("unable to rebuild compact block ${id} from peer ${endpoint}, fetching the full block",
+           ("id", block.id())("endpoint", originating_peer->get_remote_endpoint()));
+      originating_peer->send_message(fetch_items_message(block_message_type, { block.id() }));
+    }
+
     void node_impl::on_item_not_available_message( peer_connection* originating_peer, const item_not_available_message& item_not_available_message_received )
     {
       VERIFY_CORRECT_THREAD();
@@ -2419,7 +2782,7 @@ namespace graphene { namespace net { namespace detail {
                originating_peer->is_inventory_advertised_to_us_list_full_for_transactions()) ||
               originating_peer->is_inventory_advertised_to_us_list_full())
             break;
-          originating_peer->inventory_peer_advertised_to_us.insert(peer_connection::timestamped_item_id(advertised_item_id, fc::time_point::now()));
+          originating_peer->inventory_peer_advertised_to_us.insert(advertised_item_id, fc::time_point::now());
           if (!we_requested_this_item_from_a_peer)
           {
             if (_recently_failed_items.find(item_id(item_ids_inventory_message_received.item_type, item_hash)) != _recently_failed_items.end())
@@ -2520,6 +2883,7 @@ namespace graphene { namespace net { namespace detail {
           if (updated_peer_record)
           {
             updated_peer_record->last_seen_time = fc::time_point::now();
+            update_peer_record_metrics(*updated_peer_record, *originating_peer);
             _potential_peer_db.update_entry(*updated_peer_record);
           }
         }
@@ -2591,7 +2955,10 @@ namespace graphene { namespace net { namespace detail {
       try
       {
         std::vector<message_hash_type> contained_transaction_msg_ids;
+        const fc::time_point processing_start_time = fc::time_point::now();
         _delegate->handle_block(block_message_to_send, true, contained_transaction_msg_ids);
+        _sync_block_processing_time += fc::time_point::now() - processing_start_time;
+        ++_sync_blocks_processed;
         ilog("Successfully pushed sync block ${num} (id:${id})",
              ("num", block_message_to_send.block.block_num())
              ("id", block_message_to_send.block_id));
@@ -2933,7 +3300,8 @@ namespace graphene { namespace net { namespace detail {
 
     void node_impl::process_block_when_in_sync( peer_connection* originating_peer,
                                                const graphene::net::block_message& block_message_to_process,
-                                               const message_hash_type& message_hash )
+                                               const message_hash_type& message_hash,
+                                               const message* packed_block_message )
     {
       fc::time_point message_receive_time = fc::time_point::now();
 
@@ -2963,6 +3331,13 @@ namespace graphene { namespace net { namespace detail {
                 ("id", block_message_to_process.block_id));
           _most_recent_blocks_accepted.push_back(block_message_to_process.block_id);
 
+          const fc::microseconds delivery_latency = message_receive_time
+                                                    - fc::time_point(block_message_to_process.block.timestamp);
+          if (delivery_latency.count() > 0)
+            originating_peer->block_delivery_latency = originating_peer->block_delivery_latency.count() > 0 ?
+                  fc::microseconds((3 * originating_peer->block_delivery_latency.count() + delivery_latency.count()) / 4) :
+                  delivery_latency;
+
           bool new_transaction_discovered = false;
           for (const item_hash_t& transaction_message_hash : contained_transaction_msg_ids)
           {
@@ -3009,7 +3384,10 @@ namespace graphene { namespace net { namespace detail {
         }
         message_propagation_data propagation_data { message_receive_time, message_validated_time,
                                                     originating_peer->node_id };
-        broadcast( block_message_to_process, propagation_data );
+        // relay the block in the message it arrived in instead of packing it again
+        broadcast( packed_block_message ? std::make_shared<const message>( *packed_block_message )
+                                        : std::make_shared<const message>( block_message_to_process ),
+                   message_hash, block_message_to_process.block_id, propagation_data );
         _message_cache.block_accepted();
 
         if (is_hard_fork_block(block_number))
@@ -3070,6 +3448,7 @@ namespace graphene { namespace net { namespace detail {
            disconnect_exception = e;
         disconnect_reason = "You offered me a block that I have deemed to be invalid";
 
+        ++originating_peer->number_of_invalid_items;
         peers_to_disconnect.insert( originating_peer->shared_from_this() );
         fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
         for (const peer_connection_ptr& peer : _active_connections)
@@ -3094,21 +3473,23 @@ namespace graphene { namespace net { namespace detail {
       }
     }
     void node_impl::process_block_message(peer_connection* originating_peer,
-                                          const message& message_to_process,
-                                          const message_hash_type& message_hash)
+                                          const graphene::net::block_message& block_message_to_process,
+                                          const message_hash_type& message_hash,
+                                          const message* packed_block_message)
     {
       VERIFY_CORRECT_THREAD();
       // find out whether we requested this item while we were synchronizing or during normal operation
       // (it's possible that we request an item during normal operation and then get kicked into sync
       // mode before we receive and process the item.  In that case, we should process the item as a normal
       // item to avoid confusing the sync code)
-      graphene::net::block_message block_message_to_process(message_to_process.as<graphene::net::block_message>());
       auto item_iter = originating_peer->items_requested_from_peer.find(
                              item_id(graphene::net::block_message_type, message_hash));
       if (item_iter != originating_peer->items_requested_from_peer.end())
       {
+        originating_peer->update_fetch_latency(item_iter->second);
         originating_peer->items_requested_from_peer.erase(item_iter);
-        process_block_when_in_sync(originating_peer, block_message_to_process, message_hash);
+        ++originating_peer->number_of_items_received;
+        process_block_when_in_sync(originating_peer, block_message_to_process, message_hash, packed_block_message);
         if (originating_peer->idle())
           trigger_fetch_items_loop();
         return;
@@ -3127,9 +3508,14 @@ namespace graphene { namespace net { namespace detail {
           {
             originating_peer->last_sync_item_received_time = fc::time_point::now();
             _active_sync_requests.erase(block_message_to_process.block_id);
-            process_block_during_syncing(originating_peer, block_message_to_process, message_hash);
+            if (is_duplicate_of_rerequested_sync_item(block_message_to_process.block_id))
+              dlog("dropping sync block ${id} from peer ${endpoint}, it was requested twice and is already here",
+                   ("id", block_message_to_process.block_id)("endpoint", originating_peer->get_remote_endpoint()));
+            else
+              process_block_during_syncing(originating_peer, block_message_to_process, message_hash);
             if (originating_peer->idle())
             {
+              update_sync_throughput(originating_peer);
               // we have finished fetching a batch of items, so we either need to grab another batch of items
               // or we need to get another list of item ids.
               if (originating_peer->number_of_unfetched_item_ids > 0 &&
@@ -3161,6 +3547,17 @@ namespace graphene { namespace net { namespace detail {
         }
       }
 
+      if (is_priority_peer(*originating_peer))
+      {
+        // priority peers push new blocks without announcing them.  Record it as offered so that we don't
+        // send the block back when we relay it
+        originating_peer->inventory_peer_advertised_to_us.insert(
+              item_id(graphene::net::block_message_type, message_hash), fc::time_point::now());
+        ++originating_peer->number_of_items_received;
+        process_block_when_in_sync(originating_peer, block_message_to_process, message_hash, packed_block_message);
+        return;
+      }
+
       // if we get here, we didn't request the message, we must have a misbehaving peer
       wlog("received a block ${block_id} I didn't ask for from peer ${endpoint}, disconnecting from peer",
            ("endpoint", originating_peer->get_remote_endpoint())
@@ -3387,7 +3784,10 @@ namespace graphene { namespace net { namespace detail {
       // only process it if we asked for it
       auto iter = originating_peer->items_requested_from_peer.find(
                         item_id(message_to_process.msg_type.value(), message_hash) );
-      if( iter == originating_peer->items_requested_from_peer.end() )
+      // priority peers push new transactions without announcing them
+      const bool pushed_by_priority_peer = iter == originating_peer->items_requested_from_peer.end()
+                                           && is_priority_peer( *originating_peer );
+      if( iter == originating_peer->items_requested_from_peer.end() && !pushed_by_priority_peer )
       {
         wlog( "received a message I didn't ask for from peer ${endpoint}, disconnecting from peer",
              ( "endpoint", originating_peer->get_remote_endpoint() ) );
@@ -3399,9 +3799,17 @@ namespace graphene { namespace net { namespace detail {
       }
       else
       {
-        originating_peer->items_requested_from_peer.erase( iter );
-        if (originating_peer->idle())
-          trigger_fetch_items_loop();
+        if( pushed_by_priority_peer )
+          originating_peer->inventory_peer_advertised_to_us.insert(
+                item_id( message_to_process.msg_type.value(), message_hash ), fc::time_point::now());
+        else
+        {
+          originating_peer->update_fetch_latency(iter->second);
+          originating_peer->items_requested_from_peer.erase( iter );
+          if (originating_peer->idle())
+            trigger_fetch_items_loop();
+        }
+        ++originating_peer->number_of_items_received;
 
         // Next: have the delegate process the message
         fc::time_point message_validated_time;
@@ -3443,11 +3851,12 @@ namespace graphene { namespace net { namespace detail {
           default:
              wlog( "client rejected message sent by peer ${peer}, ${e}",
                    ("peer", originating_peer->get_remote_endpoint() )("e", e) );
+             ++originating_peer->number_of_invalid_items;
              break;
           }
           // record it so we don't try to fetch this item again
-          _recently_failed_items.insert( peer_connection::timestamped_item_id(
-                item_id( message_to_process.msg_type.value(), message_hash ), fc::time_point::now() ) );
+          _recently_failed_items.insert(
+                item_id( message_to_process.msg_type.value(), message_hash ), fc::time_point::now());
           return;
         }
 
@@ -4258,6 +4667,59 @@ namespace graphene { namespace net { namespace detail {
       }
    }
 
+    void node_impl::add_priority_peer(const fc::ip::endpoint& ep)
+    {
+      VERIFY_CORRECT_THREAD();
+      ilog("Adding priority peer ${endpoint}", ("endpoint", ep));
+      _priority_peers.insert(ep);
+      add_node(ep);
+    }
+
+    bool node_impl::is_priority_peer(peer_connection& peer) const
+    {
+      VERIFY_CORRECT_THREAD();
+      if (_priority_peers.empty())
+        return false;
+      // inbound connections come from an ephemeral port, the peer told us where it listens in its hello
+      fc::optional<fc::ip::endpoint> remote_endpoint = peer.get_remote_endpoint();
+      fc::optional<fc::ip::endpoint> endpoint_for_connecting = peer.get_endpoint_for_connecting();
+      return (remote_endpoint && _priority_peers.find(*remote_endpoint) != _priority_peers.end())
+          || (endpoint_for_connecting && _priority_peers.find(*endpoint_for_connecting) != _priority_peers.end());
+    }
+
+    bool node_impl::is_connected_to_priority_peer(const fc::ip::endpoint& ep)
+    {
+      VERIFY_CORRECT_THREAD();
+      if (is_connection_to_endpoint_in_progress(ep))
+        return true;
+      fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
+      for (const peer_connection_ptr& active_peer : _active_connections)
+      {
+        fc::optional<fc::ip::endpoint> endpoint_for_connecting = active_peer->get_endpoint_for_connecting();
+        if (endpoint_for_connecting && *endpoint_for_connecting == ep)
+          return true;
+      }
+      return false;
+    }
+
+    void node_impl::push_to_priority_peers(const item_id& item, const message_ptr& item_message)
+    {
+      VERIFY_CORRECT_THREAD();
+      if (_priority_peers.empty())
+        return;
+      fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
+      for (const peer_connection_ptr& peer : _active_connections)
+      {
+        if (!is_priority_peer(*peer) || peer->peer_needs_sync_items_from_us
+            || peer->inventory_peer_advertised_to_us.find(item) != peer->inventory_peer_advertised_to_us.end()
+            || peer->inventory_advertised_to_peer.find(item) != peer->inventory_advertised_to_peer.end())
+          continue;
+        // recording it as advertised keeps the inventory loop from announcing it as well
+        peer->inventory_advertised_to_peer.insert(item, fc::time_point::now());
+        peer->send_message(item_message);
+      }
+    }
+
     void node_impl::initiate_connect_to(const peer_connection_ptr& new_peer)
     {
       new_peer->get_socket().open();
@@ -4394,7 +4856,14 @@ namespace graphene { namespace net { namespace detail {
         ilog( "    peer.inventory_advertised_to_peer size: ${size}", ("size", peer->inventory_advertised_to_peer.size() ) );
         ilog( "    peer.items_requested_from_peer size: ${size}", ("size", peer->items_requested_from_peer.size() ) );
         ilog( "    peer.sync_items_requested_from_peer size: ${size}", ("size", peer->sync_items_requested_from_peer.size() ) );
-      }
+        ilog( "    peer send queue: ${count} messages, ${size} bytes, fetch latency ${latency}us",
+              ("count", peer->get_number_of_queued_messages())("size", peer->get_total_queued_messages_size())
+              ("latency", peer->fetch_latency.count()) );
+        ilog( "    peer message statistics: ${stats}",
+              ("stats", get_message_statistics_variant(peer->message_statistics)) );
+      }
+      ilog( "node sync blocks processed: ${count} in ${time}us",
+            ("count", _sync_blocks_processed)("time", _sync_block_processing_time.count()) );
       ilog( "--------- END MEMORY USAGE ------------" );
     }
 
@@ -4546,6 +5015,15 @@ namespace graphene { namespace net { namespace detail {
         peer_details["peer_needs_sync_items_from_us"] = peer->peer_needs_sync_items_from_us;
         peer_details["we_need_sync_items_from_peer"] = peer->we_need_sync_items_from_peer;
 
+        peer_details["round_trip_delay_us"] = peer->round_trip_delay.count();
+        peer_details["block_delivery_latency_us"] = peer->block_delivery_latency.count();
+        peer_details["fetch_latency_us"] = peer->fetch_latency.count();
+        peer_details["items_requested"] = peer->items_requested_from_peer.size();
+        peer_details["sync_items_requested"] = peer->sync_items_requested_from_peer.size();
+        peer_details["queued_messages"] = peer->get_number_of_queued_messages();
+        peer_details["queued_bytes"] = peer->get_total_queued_messages_size();
+        peer_details["message_statistics"] = get_message_statistics_variant(peer->message_statistics);
+
         this_peer_status.info = peer_details;
         statuses.push_back(this_peer_status);
       }
@@ -4566,7 +5044,6 @@ namespace graphene { namespace net { namespace detail {
       {
         graphene::net::block_message block_message_to_broadcast = item_to_broadcast.as<graphene::net::block_message>();
         hash_of_message_contents = block_message_to_broadcast.block_id; // for debugging
-        _most_recent_blocks_accepted.push_back( block_message_to_broadcast.block_id );
       }
       else if( item_to_broadcast.msg_type.value() == graphene::net::trx_message_type )
       {
@@ -4574,10 +5051,32 @@ namespace graphene { namespace net { namespace detail {
         hash_of_message_contents = transaction_message_to_broadcast.trx.id(); // for debugging
         dlog( "broadcasting trx: ${trx}", ("trx", transaction_message_to_broadcast) );
       }
-      message_hash_type hash_of_item_to_broadcast = item_to_broadcast.id();
+      broadcast( std::make_shared<const message>( item_to_broadcast ), item_to_broadcast.id(),
+                 hash_of_message_contents, propagation_data );
+    }
 
-      _message_cache.cache_message( item_to_broadcast, hash_of_item_to_broadcast, propagation_data, hash_of_message_contents );
-      _new_inventory.insert( item_id(item_to_broadcast.msg_type.value(), hash_of_item_to_broadcast ) );
+    void node_impl::broadcast( const message_ptr& item_to_broadcast, const message_hash_type& hash_of_item_to_broadcast,
+                               const message_hash_type& hash_of_message_contents,
+                               const message_propagation_data& propagation_data )
+    {
+      VERIFY_CORRECT_THREAD();
+      const uint32_t item_type = item_to_broadcast->msg_type.value();
+      if( item_type == graphene::net::block_message_type )
+        _most_recent_blocks_accepted.push_back( hash_of_message_contents );
+
+      _message_cache.cache_message( item_to_broadcast, hash_of_item_to_broadcast, propagation_data,
+                                    hash_of_message_contents );
+      push_to_priority_peers( item_id( item_type, hash_of_item_to_broadcast ), item_to_broadcast );
+      _new_inventory.insert( item_id( item_type, hash_of_item_to_broadcast ) );
+      if( item_type == graphene::net::block_message_type )
+      {
+        _block_inventory_pending = true;
+        if( _flush_inventory_promise )
+        {
+          _flush_inventory_promise->set_value();
+          _flush_inventory_promise.reset();
+        }
+      }
       trigger_advertise_inventory_loop();
     }
 
@@ -4629,12 +5128,26 @@ namespace graphene { namespace net { namespace detail {
         _max_sync_blocks_to_prefetch = params["max_sync_blocks_to_prefetch"].as<uint32_t>(1);
       if (params.contains("max_sync_blocks_per_peer"))
         _max_sync_blocks_per_peer = params["max_sync_blocks_per_peer"].as<uint32_t>(1);
+      if (params.contains("inventory_flush_interval_ms"))
+        _inventory_flush_interval_ms = params["inventory_flush_interval_ms"].as<uint32_t>(1);
+      if (params.contains("max_transactions_per_fetch"))
+        _max_transactions_per_fetch = std::max<uint32_t>(1, params["max_transactions_per_fetch"].as<uint32_t>(1));
 
       _desired_number_of_connections = std::min(_desired_number_of_connections, _maximum_number_of_connections);
 
+      // evict the peers which deliver blocks the slowest, priority peers last
       while (_active_connections.size() > _maximum_number_of_connections)
-        disconnect_from_peer(_active_connections.begin()->get(),
-                             "I have too many connections open");
+      {
+        peer_connection_ptr slowest_peer = *std::max_element(_active_connections.begin(), _active_connections.end(),
+              [this](const peer_connection_ptr& a, const peer_connection_ptr& b) {
+                const bool a_is_priority = is_priority_peer(*a);
+                const bool b_is_priority = is_priority_peer(*b);
+                if (a_is_priority != b_is_priority)
+                  return a_is_priority;
+                return a->block_delivery_latency + a->round_trip_delay < b->block_delivery_latency + b->round_trip_delay;
+              });
+        disconnect_from_peer(slowest_peer.get(), "I have too many connections open");
+      }
       trigger_p2p_network_connect_loop();
     }
 
@@ -4648,6 +5161,8 @@ namespace graphene { namespace net { namespace detail {
       result["max_blocks_to_handle_at_once"] = _max_blocks_to_handle_at_once;
       result["max_sync_blocks_to_prefetch"] = _max_sync_blocks_to_prefetch;
       result["max_sync_blocks_per_peer"] = _max_sync_blocks_per_peer;
+      result["inventory_flush_interval_ms"] = _inventory_flush_interval_ms;
+      result["max_transactions_per_fetch"] = _max_transactions_per_fetch;
       return result;
     }
 
@@ -4745,10 +5260,43 @@ namespace graphene { namespace net { namespace detail {
                      std::back_inserter(network_usage_by_hour),
                      std::plus<uint32_t>());
 
+      std::map<uint32_t, peer_connection::message_type_statistics> message_statistics;
+      {
+        fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
+        for (const peer_connection_ptr& peer : _active_connections)
+          for (const auto& type_and_statistics : peer->message_statistics)
+          {
+            peer_connection::message_type_statistics& total = message_statistics[type_and_statistics.first];
+            total.messages_received += type_and_statistics.second.messages_received;
+            total.bytes_received += type_and_statistics.second.bytes_received;
+            total.messages_sent += type_and_statistics.second.messages_sent;
+            total.bytes_sent += type_and_statistics.second.bytes_sent;
+          }
+      }
+
       fc::mutable_variant_object result;
       result["usage_by_second"] = fc::variant( network_usage_by_second, 2 );
       result["usage_by_minute"] = fc::variant( network_usage_by_minute, 2 );
       result["usage_by_hour"]   = fc::variant( network_usage_by_hour, 2 );
+      result["message_statistics"] = get_message_statistics_variant( message_statistics );
+      result["sync_blocks_processed"] = _sync_blocks_processed;
+      result["sync_block_processing_time_us"] = _sync_block_processing_time.count();
+      return result;
+    }
+
+    fc::variant node_impl::get_message_statistics_variant(
+          const std::map<uint32_t, peer_connection::message_type_statistics>& message_statistics )
+    {
+      fc::mutable_variant_object result;
+      for( const auto& type_and_statistics : message_statistics )
+      {
+        fc::mutable_variant_object statistics;
+        statistics["messages_received"] = type_and_statistics.second.messages_received;
+        statistics["bytes_received"] = type_and_statistics.second.bytes_received;
+        statistics["messages_sent"] = type_and_statistics.second.messages_sent;
+        statistics["bytes_sent"] = type_and_statistics.second.bytes_sent;
+        result[std::to_string( type_and_statistics.first )] = statistics;
+      }
       return result;
     }
 
@@ -5072,6 +5620,12 @@ namespace graphene { namespace net { namespace detail {
       INVOKE_AND_COLLECT_STATISTICS(get_item, id);
     }
 
+    std::vector<fc::optional<signed_transaction>> statistics_gathering_node_delegate_wrapper::get_pending_transactions(
+                                                          const std::vector<transaction_id_type>& ids )
+    {
+      INVOKE_AND_COLLECT_STATISTICS(get_pending_transactions, ids);
+    }
+
     chain_id_type statistics_gathering_node_delegate_wrapper::get_chain_id() const
     {
       INVOKE_AND_COLLECT_STATISTICS(get_chain_id);
@@ -5176,4 +5730,9 @@ namespace graphene { namespace net { namespace detail {
       INVOKE_IN_IMPL(add_seed_node, in);
    }
 
+   void node::add_priority_peer(const fc::ip::endpoint& ep)
+   {
+      INVOKE_IN_IMPL(add_priority_peer, ep);
+   }
+
 } } // end namespace graphene::net
@@ -18,6 +18,7 @@
 
 #include <memory>
 #include <mutex>
+#include <unordered_set>
 #include <fc/thread/thread.hpp>
 #include <fc/log/logger.hpp>
 #include <fc/network/tcp_socket.hpp>
@@ -159,7 +160,7 @@ private:
    struct message_info
    {
       message_hash_type message_hash;
-      message           message_body;
+      message_ptr       message_body;
       uint32_t          block_clock_when_received;
 
       /// for network performance stats
@@ -169,12 +170,12 @@ private:
       message_hash_type message_contents_hash;
 
       message_info( const message_hash_type& message_hash,
-                    const message&           message_body,
+                    message_ptr              message_body,
                     uint32_t                 block_clock_when_received,
                     const message_propagation_data& propagation_data,
                     message_hash_type        message_contents_hash ) :
             message_hash( message_hash ),
-            message_body( message_body ),
+            message_body( std::move(message_body) ),
             block_clock_when_received( block_clock_when_received ),
             propagation_data( propagation_data ),
             message_contents_hash( message_contents_hash )
@@ -196,11 +197,15 @@ private:
 
 public:
    void block_accepted();
-   void cache_message( const message& message_to_cache,
+   void cache_message( message_ptr message_to_cache,
                        const message_hash_type& hash_of_message_to_cache,
                        const message_propagation_data& propagation_data,
                        const message_hash_type& message_content_hash );
    message get_message( const message_hash_type& hash_of_message_to_lookup ) const;
+   /// Like get_message(), but shares the cached message instead of copying it
+   message_ptr get_shared_message( const message_hash_type& hash_of_message_to_lookup ) const;
+   /// The block id or transaction id of a cached message
+   message_hash_type get_message_contents_hash( const message_hash_type& hash_of_message_to_lookup ) const;
    message_propagation_data get_message_propagation_data(
          const message_hash_type& hash_of_msg_contents_to_lookup ) const;
    size_t size() const { return _message_cache.size(); }
@@ -247,6 +252,7 @@ class statistics_gathering_node_delegate_wrapper : public node_delegate
                                (handle_transaction) \
                                (get_block_ids) \
                                (get_item) \
+                               (get_pending_transactions) \
                                (get_chain_id) \
                                (get_blockchain_synopsis) \
                                (sync_status) \
@@ -348,6 +354,8 @@ class statistics_gathering_node_delegate_wrapper : public node_delegate
                                              uint32_t& remaining_item_count,
                                              uint32_t limit = 2000) override;
       message get_item( const item_id& id ) override;
+      std::vector<fc::optional<signed_transaction>> get_pending_transactions(
+                                                          const std::vector<transaction_id_type>& ids ) override;
       graphene::protocol::chain_id_type get_chain_id() const override;
       std::vector<item_hash_t> get_blockchain_synopsis(const item_hash_t& reference_point,
                                                        uint32_t number_of_blocks_after_reference_point) override;
@@ -384,6 +392,9 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
       std::shared_ptr<fc::thread> _thread = std::make_shared<fc::thread>("p2p");
 #endif // P2P_IN_DEDICATED_THREAD
       std::unique_ptr<statistics_gathering_node_delegate_wrapper> _delegate;
+      /// Threads which hash and unpack large incoming messages, created on first use
+      std::vector<std::shared_ptr<fc::thread>> _message_worker_threads;
+      size_t _next_message_worker_thread = 0;
       fc::sha256           _chain_id;
 
 #define NODE_CONFIGURATION_FILENAME      "node_config.json"
@@ -424,6 +435,9 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
 
       /// List of sync blocks we've asked for from peers but have not yet received
       active_sync_requests_map              _active_sync_requests;
+      /// Sync blocks we've asked for from a second peer because the first one was too slow.  The copy which
+      /// arrives last is dropped
+      std::unordered_set<graphene::net::block_id_type> _rerequested_sync_items;
       /// List of sync blocks we've just received but haven't yet tried to process
       std::list<graphene::net::block_message> _new_received_sync_items;
       /// List of sync blocks we've received, but can't yet process because we are still missing blocks
@@ -463,6 +477,9 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
       /// @{
       fc::promise<void>::ptr        _retrigger_advertise_inventory_loop_promise;
       fc::future<void>              _advertise_inventory_loop_done;
+      /// Wakes up the advertise inventory loop while it collects transactions, because a block must not wait
+      fc::promise<void>::ptr        _flush_inventory_promise;
+      bool                          _block_inventory_pending = false;
       /// List of items we have received but not yet advertised to our peers
       concurrent_unordered_set<item_id>   _new_inventory;
       /// @}
@@ -551,6 +568,9 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
       size_t _avg_net_usage_minute_counter = 0;
 
       fc::time_point_sec _bandwidth_monitor_last_update_time;
+      /// number of blocks pushed to the delegate while syncing, and the time the delegate took for them
+      uint64_t _sync_blocks_processed = 0;
+      fc::microseconds _sync_block_processing_time;
       fc::future<void> _bandwidth_monitor_loop_done;
 
       fc::future<void> _dump_node_status_task_done;
@@ -587,12 +607,18 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
       size_t _max_sync_blocks_to_prefetch = MAX_SYNC_BLOCKS_TO_PREFETCH;
       /// Maximum number of blocks per peer during syncing
       size_t _max_sync_blocks_per_peer = GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING;
+      /// Time to collect transactions before they are advertised, 0 to advertise them right away
+      uint32_t _inventory_flush_interval_ms = GRAPHENE_NET_INVENTORY_FLUSH_INTERVAL_MS;
+      /// Maximum number of transactions per peer during normal operation
+      size_t _max_transactions_per_fetch = GRAPHENE_NET_MAX_TRANSACTIONS_PER_FETCH;
 
       std::list<fc::future<void> > _handle_message_calls_in_progress;
 
       /// Used by the task that checks whether addresses of seed nodes have been updated
       /// @{
       boost::container::flat_set<std::string> _seed_nodes;
+      /// trusted peers which we stay connected to and push new items to, see node::add_priority_peer()
+      boost::container::flat_set<fc::ip::endpoint> _priority_peers;
       fc::future<void> _update_seed_nodes_loop_done;
       void update_seed_nodes_task();
       void schedule_next_update_seed_nodes_task();
@@ -608,6 +634,9 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
 
       bool have_already_received_sync_item( const item_hash_t& item_hash );
       void request_sync_item_from_peer( const peer_connection_ptr& peer, const item_hash_t& item_to_request );
+      /// true if @p item_hash was requested from two peers and this is the second copy to arrive
+      bool is_duplicate_of_rerequested_sync_item( const item_hash_t& item_hash );
+      void update_sync_throughput( peer_connection* peer );
       void request_sync_items_from_peer( const peer_connection_ptr& peer, const std::vector<item_hash_t>& items_to_request );
       void fetch_sync_items_loop();
       void trigger_fetch_sync_items_loop();
@@ -641,6 +670,12 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
       fc::variant_object generate_hello_user_data();
       void parse_hello_user_data_for_peer( peer_connection* originating_peer, const fc::variant_object& user_data );
 
+      /// Folds the measurements of a connection which is about to end into the peer's database record
+      void update_peer_record_metrics( potential_peer_record& record, const peer_connection& peer ) const;
+
+      /// Picks the worker threads in turn
+      fc::thread& next_message_worker_thread();
+
       void on_message( peer_connection* originating_peer,
                        const message& received_message ) override;
 
@@ -666,6 +701,20 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
       void on_fetch_items_message( peer_connection* originating_peer,
                                    const fetch_items_message& fetch_items_message_received ) const;
 
+      void on_compact_block_message( peer_connection* originating_peer,
+                                     const compact_block_message& compact_block_message_received );
+
+      void on_fetch_compact_block_transactions_message( peer_connection* originating_peer,
+                                                        const fetch_compact_block_transactions_message& request ) const;
+
+      void on_compact_block_transactions_message( peer_connection* originating_peer,
+                                                  const compact_block_transactions_message& reply );
+
+      /// Processes a block rebuilt from a compact block, or fetches the full block if it does not verify
+      void process_rebuilt_compact_block( peer_connection* originating_peer,
+                                          const item_hash_t& block_message_hash,
+                                          const signed_block& block );
+
       void on_item_not_available_message( peer_connection* originating_peer,
                                           const item_not_available_message& item_not_available_message_received );
 
@@ -698,14 +747,17 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
                   peer_connection* originating_peer,
                   const graphene::net::block_message& block_message,
                   const message_hash_type& message_hash);
+      /// @param packed_block_message if not null, the message @p block_message arrived in, it is relayed verbatim
       void process_block_when_in_sync(
                   peer_connection* originating_peer,
                   const graphene::net::block_message& block_message,
-                  const message_hash_type& message_hash);
+                  const message_hash_type& message_hash,
+                  const message* packed_block_message = nullptr);
       void process_block_message(
                   peer_connection* originating_peer,
-                  const message& message_to_process,
-                  const message_hash_type& message_hash);
+                  const graphene::net::block_message& block_message_to_process,
+                  const message_hash_type& message_hash,
+                  const message* packed_block_message = nullptr);
 
       void process_ordinary_message(
                   peer_connection* originating_peer,
@@ -750,6 +802,12 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
       void add_node( const fc::ip::endpoint& ep );
       void add_seed_node( const std::string& seed_string );
       void resolve_seed_node_and_add( const std::string& seed_string );
+      void add_priority_peer( const fc::ip::endpoint& ep );
+      bool is_priority_peer( peer_connection& peer ) const;
+      /// true if an active or handshaking connection goes to @p ep, no matter who initiated it
+      bool is_connected_to_priority_peer( const fc::ip::endpoint& ep );
+      /// sends a new block or transaction to the priority peers which don't know it yet
+      void push_to_priority_peers( const item_id& item, const message_ptr& item_message );
       void initiate_connect_to(const peer_connection_ptr& peer);
       void connect_to_endpoint(const fc::ip::endpoint& ep);
       void listen_on_endpoint(const fc::ip::endpoint& ep , bool wait_if_not_available);
@@ -761,6 +819,10 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
       uint32_t                 get_connection_count() const;
 
       void broadcast(const message& item_to_broadcast, const message_propagation_data& propagation_data);
+      /// Broadcasts a message whose hashes are already known without copying or unpacking it
+      void broadcast(const message_ptr& item_to_broadcast, const message_hash_type& hash_of_item_to_broadcast,
+                     const message_hash_type& hash_of_message_contents,
+                     const message_propagation_data& propagation_data);
       void broadcast(const message& item_to_broadcast);
       void sync_from(const item_id& current_head_block, const std::vector<uint32_t>& hard_fork_block_numbers);
       bool is_connected() const;
@@ -781,6 +843,8 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
 
       fc::variant_object         network_get_info() const;
       fc::variant_object         network_get_usage_stats() const;
+      static fc::variant         get_message_statistics_variant(
+            const std::map<uint32_t, peer_connection::message_type_statistics>& message_statistics );
 
       bool is_hard_fork_block(uint32_t block_number) const;
       uint32_t get_next_known_hard_fork_block_number(uint32_t block_number) const;
@@ -44,7 +44,7 @@
 
 namespace graphene { namespace net
   {
-    message peer_connection::real_queued_message::get_message(peer_connection_delegate*)
+    const message& peer_connection::real_queued_message::get_message(peer_connection_delegate*)
     {
       if (message_send_time_field_offset != (size_t)-1)
       {
@@ -61,9 +61,10 @@ namespace graphene { namespace net
     {
       return message_to_send.data.size();
     }
-    message peer_connection::virtual_queued_message::get_message(peer_connection_delegate* node)
+    const message& peer_connection::virtual_queued_message::get_message(peer_connection_delegate* node)
     {
-      return node->get_message_for_item(item_to_send);
+      generated_message = node->get_message_for_item(item_to_send);
+      return generated_message;
     }
 
     size_t peer_connection::virtual_queued_message::get_size_in_queue()
@@ -71,6 +72,16 @@ namespace graphene { namespace net
       return sizeof(item_id);
     }
 
+    const message& peer_connection::shared_queued_message::get_message(peer_connection_delegate*)
+    {
+      return *message_to_send;
+    }
+
+    size_t peer_connection::shared_queued_message::get_size_in_queue()
+    {
+      return message_to_send->data.size();
+    }
+
     peer_connection::peer_connection(peer_connection_delegate* delegate) :
       _node(delegate),
       _message_connection(this),
@@ -278,6 +289,9 @@ namespace graphene { namespace net
       BOOST_SCOPE_EXIT(this_) {
         this_->_currently_handling_message = false;
       } BOOST_SCOPE_EXIT_END
+      message_type_statistics& statistics = message_statistics[received_message.msg_type.value()];
+      ++statistics.messages_received;
+      statistics.bytes_received += received_message.size.value();
       _node->on_message( this, received_message );
     }
 
@@ -301,13 +315,16 @@ namespace graphene { namespace net
       while (!_queued_messages.empty())
       {
         _queued_messages.front()->transmission_start_time = fc::time_point::now();
-        message message_to_send = _queued_messages.front()->get_message(_node);
+        const message& message_to_send = _queued_messages.front()->get_message(_node);
         try
         {
           //dlog("peer_connection::send_queued_messages_task() calling message_oriented_connection::send_message() "
           //     "to send message of type ${type} for peer ${endpoint}",
           //     ("type", message_to_send.msg_type)("endpoint", get_remote_endpoint()));
           _message_connection.send_message(message_to_send);
+          message_type_statistics& statistics = message_statistics[message_to_send.msg_type.value()];
+          ++statistics.messages_sent;
+          statistics.bytes_sent += message_to_send.size.value();
           //dlog("peer_connection::send_queued_messages_task()'s call to message_oriented_connection::send_message() completed normally for peer ${endpoint}",
           //     ("endpoint", get_remote_endpoint()));
         }
@@ -386,6 +403,12 @@ namespace graphene { namespace net
       send_queueable_message(std::move(message_to_enqueue));
     }
 
+    void peer_connection::send_message(const message_ptr& message_to_send)
+    {
+      VERIFY_CORRECT_THREAD();
+      send_queueable_message(std::make_unique<shared_queued_message>(message_to_send));
+    }
+
     void peer_connection::send_item(const item_id& item_to_send)
     {
       VERIFY_CORRECT_THREAD();
@@ -395,6 +418,20 @@ namespace graphene { namespace net
       send_queueable_message(std::move(message_to_enqueue));
     }
 
+    void peer_connection::update_fetch_latency(const fc::time_point& request_time)
+    {
+      VERIFY_CORRECT_THREAD();
+      const fc::microseconds latency = fc::time_point::now() - request_time;
+      fetch_latency = fetch_latency.count() > 0 ? fc::microseconds((3 * fetch_latency.count() + latency.count()) / 4)
+                                                : latency;
+    }
+
+    void peer_connection::enable_message_compression(uint32_t threshold)
+    {
+      VERIFY_CORRECT_THREAD();
+      _message_connection.enable_compression(threshold);
+    }
+
     void peer_connection::close_connection()
     {
       VERIFY_CORRECT_THREAD();
@@ -488,16 +525,10 @@ namespace graphene { namespace net
       fc::time_point_sec oldest_inventory_to_keep(fc::time_point::now() - fc::minutes(GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES));
 
       // expire old items from inventory_advertised_to_peer
-      auto oldest_inventory_to_keep_iter = inventory_advertised_to_peer.get<timestamp_index>().lower_bound(oldest_inventory_to_keep);
-      auto begin_iter = inventory_advertised_to_peer.get<timestamp_index>().begin();
-      unsigned number_of_elements_advertised_to_peer_to_discard = std::distance(begin_iter, oldest_inventory_to_keep_iter);
-      inventory_advertised_to_peer.get<timestamp_index>().erase(begin_iter, oldest_inventory_to_keep_iter);
+      size_t number_of_elements_advertised_to_peer_to_discard = inventory_advertised_to_peer.expire(oldest_inventory_to_keep);
 
       // also expire items from inventory_peer_advertised_to_us
-      oldest_inventory_to_keep_iter = inventory_peer_advertised_to_us.get<timestamp_index>().lower_bound(oldest_inventory_to_keep);
-      begin_iter = inventory_peer_advertised_to_us.get<timestamp_index>().begin();
-      unsigned number_of_elements_peer_advertised_to_discard = std::distance(begin_iter, oldest_inventory_to_keep_iter);
-      inventory_peer_advertised_to_us.get<timestamp_index>().erase(begin_iter, oldest_inventory_to_keep_iter);
+      size_t number_of_elements_peer_advertised_to_discard = inventory_peer_advertised_to_us.expire(oldest_inventory_to_keep);
       dlog("Expiring old inventory for peer ${peer}: removing ${to_peer} items advertised to peer (${remain_to_peer} left), and ${to_us} advertised to us (${remain_to_us} left)",
            ("peer", get_remote_endpoint())
            ("to_peer", number_of_elements_advertised_to_peer_to_discard)("remain_to_peer", inventory_advertised_to_peer.size())
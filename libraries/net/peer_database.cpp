@@ -37,6 +37,18 @@
 #include <graphene/net/config.hpp>
 
 namespace graphene { namespace net {
+  int64_t potential_peer_record::score() const
+  {
+    // peers we have not measured yet are ranked as mediocre, so that new peers still get a chance
+    const int64_t unknown_delay_ms = GRAPHENE_NET_UNMEASURED_PEER_DELAY_MS;
+    int64_t result = round_trip_delay_us > 0 ? round_trip_delay_us / 1000 : unknown_delay_ms;
+    result += block_delivery_latency_us > 0 ? block_delivery_latency_us / 1000 : unknown_delay_ms;
+    // every percent of invalid items costs as much as a second of delay
+    if (number_of_items_received > 0)
+      result += static_cast<int64_t>(100000 * number_of_invalid_items / number_of_items_received);
+    return result;
+  }
+
   namespace detail
   {
     using namespace boost::multi_index;
@@ -285,6 +297,8 @@ FC_REFLECT_ENUM( graphene::net::potential_peer_last_connection_disposition,
 FC_REFLECT_DERIVED_NO_TYPENAME( graphene::net::potential_peer_record, BOOST_PP_SEQ_NIL,
                                 (endpoint)(last_seen_time)(last_connection_disposition)
                                 (last_connection_attempt_time)(number_of_successful_connection_attempts)
-                                (number_of_failed_connection_attempts)(last_error) )
+                                (number_of_failed_connection_attempts)(last_error)
+                                (round_trip_delay_us)(block_delivery_latency_us)(bytes_per_second)
+                                (number_of_items_received)(number_of_invalid_items) )
 
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::net::potential_peer_record)
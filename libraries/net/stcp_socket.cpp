@@ -33,6 +33,7 @@
 #include <fc/exception/exception.hpp>
 
 #include <graphene/net/stcp_socket.hpp>
+#include <graphene/net/config.hpp>
 
 namespace graphene { namespace net {
 
@@ -100,7 +101,9 @@ size_t stcp_socket::readsome( char* buffer, size_t len )
     } buffer_in_use_checker(_read_buffer_in_use);
 #endif
 
-    const size_t read_buffer_length = 4096;
+    // large reads let a whole block be decrypted in a few calls instead of one call per 4KiB
+    const size_t read_buffer_length = GRAPHENE_NET_STCP_BUFFER_SIZE;
+    static_assert(GRAPHENE_NET_STCP_BUFFER_SIZE % 16 == 0, "buffer must hold whole AES blocks");
     if (!_read_buffer)
       _read_buffer.reset(new char[read_buffer_length], [](char* p){ delete[] p; });
 
@@ -141,11 +144,10 @@ size_t stcp_socket::writesome( const char* buffer, size_t len )
     } buffer_in_use_checker(_write_buffer_in_use);
 #endif
 
-    const std::size_t write_buffer_length = 4096;
+    const std::size_t write_buffer_length = GRAPHENE_NET_STCP_BUFFER_SIZE;
     if (!_write_buffer)
       _write_buffer.reset(new char[write_buffer_length], [](char* p){ delete[] p; });
     len = std::min<size_t>(write_buffer_length, len);
-    memset(_write_buffer.get(), 0, len); // just in case aes.encode screws up
     /**
      * every sizeof(crypt_buf) bytes the aes channel
      * has an error and doesn't decrypt properly...  disable
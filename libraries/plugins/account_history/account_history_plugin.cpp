@@ -34,14 +34,30 @@
 #include <graphene/chain/operation_history_object.hpp>
 #include <graphene/chain/transaction_evaluation_state.hpp>
 #include <graphene/chain/hardfork.hpp>
+#include <graphene/db/task_pool.hpp>
 
 #include <fc/thread/thread.hpp>
 
+
 namespace graphene { namespace account_history {
 
 namespace detail
 {
 
+/** passes inserted operations on to account_history_by_type_index */
+class operation_history_observer : public secondary_index
+{
+   public:
+      explicit operation_history_observer( account_history_by_type_index& by_type ) : _by_type( by_type ) {}
+
+      void object_inserted( const object& obj ) override
+      {
+         _by_type.operation_inserted( static_cast<const operation_history_object&>( obj ) );
+      }
+
+   private:
+      account_history_by_type_index& _by_type;
+};
 
 class account_history_plugin_impl
 {
@@ -71,10 +87,22 @@ class account_history_plugin_impl
       primary_index< operation_history_index >* _oho_index;
       uint64_t _max_ops_per_account = -1;
       uint64_t _extended_max_ops_per_account = -1;
+      std::unique_ptr<account_history_archive> _archive;
+      bool _index_by_operation_type = false;
+      const account_history_by_type_index* _by_type_index = nullptr;
 
       /** add one history record, then check and remove the earliest history record */
       void add_account_history( const account_id_type account_id, const operation_history_id_type op_id );
 
+      /** get the set of accounts an operation applies to */
+      static flat_set<account_id_type> get_impacted_accounts( const operation_history_object& op );
+
+      /** get the impacted accounts of all applied operations, empty sets for the invalid ones. These are
+       *  pure functions of the operations, so blocks with many operations (e.g. during replay) are split
+       *  among the worker threads; the indexes are still updated serially in the original order */
+      static vector< flat_set<account_id_type> > get_impacted_accounts(
+            const vector< optional< operation_history_object > >& hist );
+
 };
 
 void account_history_plugin_impl::update_account_histories( const signed_block& b )
@@ -92,13 +120,16 @@ void account_history_plugin_impl::update_account_histories( const signed_block&
          _oho_index->use_next_id();
    };
 
-   for( const optional< operation_history_object >& o_op : hist )
+   const vector< flat_set<account_id_type> > impacted_accounts = get_impacted_accounts( hist );
+   for( size_t op_index = 0; op_index < hist.size(); ++op_index )
    {
-      optional<operation_history_object> oho;
+      const optional< operation_history_object >& o_op = hist[op_index];
+      // points to the object in the index rather than copying the operation again
+      const operation_history_object* oho = nullptr;
 
       auto create_oho = [&]() {
          is_first = false;
-         return optional<operation_history_object>( db.create<operation_history_object>( [&]( operation_history_object& h )
+         return &db.create<operation_history_object>( [&]( operation_history_object& h )
          {
             if( o_op.valid() )
             {
@@ -109,7 +140,7 @@ void account_history_plugin_impl::update_account_histories( const signed_block&
                h.op_in_trx    = o_op->op_in_trx;
                h.virtual_op   = o_op->virtual_op;
             }
-         } ) );
+         } );
       };
 
       if( !o_op.valid() || ( _max_ops_per_account == 0 && _partial_operations ) )
@@ -123,32 +154,7 @@ void account_history_plugin_impl::update_account_histories( const signed_block&
          // add to the operation history index
          oho = create_oho();
 
-      const operation_history_object& op = *o_op;
-
-      // get the set of accounts this operation applies to
-      flat_set<account_id_type> impacted;
-      vector<authority> other;
-      // fee payer is added here
-      operation_get_required_authorities( op.op, impacted, impacted, other, false );
-
-      if( op.op.is_type< account_create_operation >() )
-         impacted.insert( op.result.get<object_id_type>() );
-      else
-         operation_get_impacted_accounts( op.op, impacted, false );
-
-      if( op.result.is_type<extendable_operation_result>() )
-      {
-         const auto& op_result = op.result.get<extendable_operation_result>();
-         if( op_result.value.impacted_accounts.valid() )
-         {
-            for( const auto& a : *op_result.value.impacted_accounts )
-               impacted.insert( a );
-         }
-      }
-
-      for( auto& a : other )
-         for( auto& item : a.account_auths )
-            impacted.insert( item.first );
+      const flat_set<account_id_type>& impacted = impacted_accounts[op_index];
 
       // be here, either _max_ops_per_account > 0, or _partial_operations == false, or both
       // if _partial_operations == false, oho should have been created above
@@ -161,7 +167,7 @@ void account_history_plugin_impl::update_account_histories( const signed_block&
          // if tracking all accounts, when impacted is not empty (although it will always be),
          //    still need to create oho if _max_ops_per_account > 0 and _partial_operations == true
          //    so always need to create oho if not done
-         if (!impacted.empty() && !oho.valid()) { oho = create_oho(); }
+         if (!impacted.empty() && oho == nullptr) { oho = create_oho(); }
 
          if( _max_ops_per_account > 0 )
          {
@@ -192,18 +198,74 @@ void account_history_plugin_impl::update_account_histories( const signed_block&
             {
                if( impacted.find( account_id ) != impacted.end() )
                {
-                  if (!oho.valid()) { oho = create_oho(); }
+                  if (oho == nullptr) { oho = create_oho(); }
                   // add history
                   add_account_history( account_id, oho->id );
                }
             }
          }
       }
-      if (_partial_operations && ! oho.valid())
+      if (_partial_operations && oho == nullptr)
          skip_oho_id();
    }
 }
 
+flat_set<account_id_type> account_history_plugin_impl::get_impacted_accounts( const operation_history_object& op )
+{
+   // get the set of accounts this operation applies to
+   flat_set<account_id_type> impacted;
+   vector<authority> other;
+   // fee payer is added here
+   operation_get_required_authorities( op.op, impacted, impacted, other, false );
+
+   if( op.op.is_type< account_create_operation >() )
+      impacted.insert( op.result.get<object_id_type>() );
+   else
+      operation_get_impacted_accounts( op.op, impacted, false );
+
+   if( op.result.is_type<extendable_operation_result>() )
+   {
+      const auto& op_result = op.result.get<extendable_operation_result>();
+      if( op_result.value.impacted_accounts.valid() )
+      {
+         for( const auto& a : *op_result.value.impacted_accounts )
+            impacted.insert( a );
+      }
+   }
+
+   for( auto& a : other )
+      for( auto& item : a.account_auths )
+         impacted.insert( item.first );
+   return impacted;
+}
+
+vector< flat_set<account_id_type> > account_history_plugin_impl::get_impacted_accounts(
+      const vector< optional< operation_history_object > >& hist )
+{
+   vector< flat_set<account_id_type> > result( hist.size() );
+   const size_t min_operations_per_thread = 64;
+   const size_t count = hist.size();
+   const size_t threads = std::min<size_t>( graphene::db::task_pool::instance().thread_count(),
+                                            count / min_operations_per_thread );
+   if( threads < 2 )
+   {
+      for( size_t i = 0; i < count; ++i )
+         if( hist[i].valid() )
+            result[i] = get_impacted_accounts( *hist[i] );
+      return result;
+   }
+
+   const size_t chunk_size = ( count + threads - 1 ) / threads;
+   graphene::db::task_pool::instance().run_and_wait( ( count + chunk_size - 1 ) / chunk_size,
+         [&hist,&result,chunk_size,count] ( size_t chunk ) {
+      const size_t end = std::min( ( chunk + 1 ) * chunk_size, count );
+      for( size_t i = chunk * chunk_size; i < end; ++i )
+         if( hist[i].valid() )
+            result[i] = get_impacted_accounts( *hist[i] );
+   });
+   return result;
+}
+
 void account_history_plugin_impl::add_account_history( const account_id_type account_id,
                                                        const operation_history_id_type op_id )
 {
@@ -244,6 +306,8 @@ void account_history_plugin_impl::add_account_history( const account_id_type acc
       {
          // if found, remove the entry, and adjust account stats object
          const auto remove_op_id = itr->operation_id;
+         if( _archive )
+            _archive->append( account_id, itr->sequence, remove_op_id(db) );
          const auto itr_remove = itr;
          ++itr;
          db.remove( *itr_remove );
@@ -260,8 +324,9 @@ void account_history_plugin_impl::add_account_history( const account_id_type acc
          }
          // else need to modify the head pointer, but it shouldn't be true
 
-         // remove the operation history entry (1.11.x) if configured and no reference left
-         if( _partial_operations )
+         // remove the operation history entry (1.11.x) if configured and no reference left,
+         // archived entries keep their own copy of it
+         if( _partial_operations || _archive )
          {
             // check for references
             const auto& by_opid_idx = his_idx.indices().get<by_opid>();
@@ -277,6 +342,54 @@ void account_history_plugin_impl::add_account_history( const account_id_type acc
 
 } // end namespace detail
 
+void account_history_by_type_index::insert( const account_transaction_history_object& ath, uint16_t operation_type )
+{
+   if( _types.emplace( ath.id.instance(), operation_type ).second )
+      _by_type.insert( type_key( ath.account, operation_type, ath.sequence ) );
+}
+
+void account_history_by_type_index::object_inserted( const object& obj )
+{
+   const auto& ath = static_cast<const account_transaction_history_object&>( obj );
+   const operation_history_object* oho = _db.find( ath.operation_id );
+   if( oho != nullptr )
+      insert( ath, static_cast<uint16_t>( oho->op.which() ) );
+}
+
+void account_history_by_type_index::operation_inserted( const operation_history_object& oho )
+{
+   const auto& by_opid_idx = _db.get_index_type<account_transaction_history_index>().indices().get<by_opid>();
+   for( auto itr = by_opid_idx.lower_bound( oho.id ); itr != by_opid_idx.end() && itr->operation_id == oho.id; ++itr )
+      insert( *itr, static_cast<uint16_t>( oho.op.which() ) );
+}
+
+void account_history_by_type_index::object_removed( const object& obj )
+{
+   const auto& ath = static_cast<const account_transaction_history_object&>( obj );
+   auto itr = _types.find( ath.id.instance() );
+   if( itr == _types.end() )
+      return;
+   _by_type.erase( type_key( ath.account, itr->second, ath.sequence ) );
+   _types.erase( itr );
+}
+
+vector<uint64_t> account_history_by_type_index::get_sequences( account_id_type account, uint16_t operation_type,
+                                                               uint64_t first_sequence, uint64_t last_sequence,
+                                                               uint32_t limit )const
+{
+   vector<uint64_t> result;
+   if( first_sequence > last_sequence )
+      return result;
+   auto itr = _by_type.upper_bound( type_key( account, operation_type, last_sequence ) );
+   const auto begin = _by_type.lower_bound( type_key( account, operation_type, first_sequence ) );
+   while( itr != begin && result.size() < limit )
+   {
+      --itr;
+      result.push_back( std::get<2>( *itr ) );
+   }
+   return result;
+}
+
 
 
 
@@ -316,13 +429,21 @@ void account_history_plugin::plugin_set_program_options(
          ("extended-history-by-registrar",
           boost::program_options::value<std::vector<std::string>>()->composing()->multitoken(),
           "Track longer history for accounts with this registrar (may specify multiple times)")
+         ("archive-account-history", boost::program_options::value<bool>()->default_value(false),
+          "Move history entries beyond max-ops-per-account to disk instead of dropping them, "
+          "the history API still returns them")
+         ("account-history-archive-dir", boost::program_options::value<std::string>(),
+          "Directory of the account history archive, relative to the data directory if not absolute "
+          "(default: account_history)")
+         ("index-history-by-operation-type", boost::program_options::value<bool>()->default_value(false),
+          "Index account history by operation type to speed up the history API queries filtered by type")
          ;
    cfg.add(cli);
 }
 
 void account_history_plugin::plugin_initialize(const boost::program_options::variables_map& options)
 {
-   database().applied_block.connect( [&]( const signed_block& b){ my->update_account_histories(b); } );
+   database().connect_applied_block( "account_history", [&]( const signed_block& b){ my->update_account_histories(b); } );
    my->_oho_index = database().add_index< primary_index< operation_history_index > >();
    database().add_index< primary_index< account_transaction_history_index > >();
 
@@ -341,10 +462,29 @@ void account_history_plugin::plugin_initialize(const boost::program_options::var
                   graphene::chain::account_id_type);
    LOAD_VALUE_SET(options, "extended-history-by-registrar", my->_extended_history_registrars,
                   graphene::chain::account_id_type);
+   if( options.count("archive-account-history") > 0 && options["archive-account-history"].as<bool>() )
+   {
+      fc::path archive_dir = options.count("account-history-archive-dir") > 0 ?
+            fc::path( options["account-history-archive-dir"].as<std::string>() ) : fc::path( "account_history" );
+      if( archive_dir.is_relative() )
+         archive_dir = app().data_dir() / archive_dir;
+      my->_archive = std::make_unique<account_history_archive>( archive_dir );
+   }
+   if( options.count("index-history-by-operation-type") > 0 )
+      my->_index_by_operation_type = options["index-history-by-operation-type"].as<bool>();
 }
 
 void account_history_plugin::plugin_startup()
 {
+   if( !my->_index_by_operation_type )
+      return;
+   auto& by_type = *database().add_secondary_index< primary_index<account_transaction_history_index>,
+                                                    account_history_by_type_index >( std::cref( database() ) );
+   database().add_secondary_index< primary_index<operation_history_index>, detail::operation_history_observer >(
+                                   std::ref( by_type ) );
+   for( const auto& ath : database().get_index_type< account_transaction_history_index >().indices() )
+      by_type.object_inserted( ath );
+   my->_by_type_index = &by_type;
 }
 
 flat_set<account_id_type> account_history_plugin::tracked_accounts() const
@@ -352,4 +492,14 @@ flat_set<account_id_type> account_history_plugin::tracked_accounts() const
    return my->_tracked_accounts;
 }
 
+const account_history_archive* account_history_plugin::history_archive() const
+{
+   return my->_archive.get();
+}
+
+const account_history_by_type_index* account_history_plugin::history_by_type_index() const
+{
+   return my->_by_type_index;
+}
+
 } }
@@ -0,0 +1,156 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <graphene/account_history/history_archive.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/io/raw.hpp>
+
+#include <algorithm>
+#include <fstream>
+
+namespace graphene { namespace account_history {
+
+// The index file starts with the sequence number of the first archived entry, followed by one log offset per entry
+namespace {
+   const uint64_t index_header_size = sizeof(uint64_t);
+   const uint32_t accounts_per_directory = 10000;
+
+   uint64_t read_uint64( std::istream& in, uint64_t position )
+   {
+      uint64_t value = 0;
+      in.seekg( position );
+      in.read( reinterpret_cast<char*>( &value ), sizeof(value) );
+      FC_ASSERT( in, "Unable to read account history archive" );
+      return value;
+   }
+}
+
+account_history_archive::account_history_archive( const fc::path& dir )
+: _dir( dir )
+{
+   if( !fc::exists( _dir ) )
+      fc::create_directories( _dir );
+}
+
+fc::path account_history_archive::log_path( account_id_type account )const
+{
+   const uint64_t instance = account.instance.value;
+   return _dir / std::to_string( instance / accounts_per_directory ) / ( std::to_string( instance ) + ".log" );
+}
+
+fc::path account_history_archive::index_path( account_id_type account )const
+{
+   const uint64_t instance = account.instance.value;
+   return _dir / std::to_string( instance / accounts_per_directory ) / ( std::to_string( instance ) + ".idx" );
+}
+
+void account_history_archive::append( account_id_type account, uint64_t sequence,
+                                      const operation_history_object& op )
+{ try {
+   std::lock_guard<std::mutex> guard( _mutex );
+   const fc::path log_file = log_path( account );
+   const fc::path index_file = index_path( account );
+
+   uint64_t first_sequence = sequence;
+   uint64_t count = 0;
+   if( fc::exists( index_file ) )
+   {
+      std::ifstream index( index_file.generic_string().c_str(), std::ios::binary );
+      first_sequence = read_uint64( index, 0 );
+      count = ( fc::file_size( index_file ) - index_header_size ) / sizeof(uint64_t);
+   }
+
+   if( sequence < first_sequence || sequence > first_sequence + count )
+   {
+      // the archive does not end right before this entry, start it over
+      first_sequence = sequence;
+      count = 0;
+   }
+   else if( sequence < first_sequence + count )
+   {
+      // replaces entries of a fork we switched away from
+      std::ifstream index( index_file.generic_string().c_str(), std::ios::binary );
+      const uint64_t log_size = read_uint64( index, index_header_size + ( sequence - first_sequence ) * sizeof(uint64_t) );
+      index.close();
+      count = sequence - first_sequence;
+      fc::resize_file( index_file, index_header_size + count * sizeof(uint64_t) );
+      fc::resize_file( log_file, log_size );
+   }
+
+   if( count == 0 )
+   {
+      fc::create_directories( index_file.parent_path() );
+      std::ofstream index( index_file.generic_string().c_str(), std::ios::binary | std::ios::trunc );
+      index.write( reinterpret_cast<const char*>( &first_sequence ), sizeof(first_sequence) );
+      FC_ASSERT( index, "Unable to write ${p}", ("p", index_file) );
+      std::ofstream log( log_file.generic_string().c_str(), std::ios::binary | std::ios::trunc );
+      FC_ASSERT( log, "Unable to write ${p}", ("p", log_file) );
+   }
+
+   const std::vector<char> packed = fc::raw::pack( op );
+   const uint32_t packed_size = static_cast<uint32_t>( packed.size() );
+   const uint64_t offset = fc::file_size( log_file );
+   {
+      std::ofstream log( log_file.generic_string().c_str(), std::ios::binary | std::ios::app );
+      log.write( reinterpret_cast<const char*>( &packed_size ), sizeof(packed_size) );
+      log.write( packed.data(), packed.size() );
+      FC_ASSERT( log, "Unable to write ${p}", ("p", log_file) );
+   }
+   std::ofstream index( index_file.generic_string().c_str(), std::ios::binary | std::ios::app );
+   index.write( reinterpret_cast<const char*>( &offset ), sizeof(offset) );
+   FC_ASSERT( index, "Unable to write ${p}", ("p", index_file) );
+} FC_CAPTURE_AND_RETHROW( (account)(sequence) ) }
+
+std::vector<operation_history_object> account_history_archive::read( account_id_type account, uint64_t last_sequence,
+                                                                     uint32_t limit )const
+{ try {
+   std::vector<operation_history_object> result;
+   std::lock_guard<std::mutex> guard( _mutex );
+   const fc::path index_file = index_path( account );
+   if( limit == 0 || !fc::exists( index_file ) )
+      return result;
+
+   std::ifstream index( index_file.generic_string().c_str(), std::ios::binary );
+   std::ifstream log( log_path( account ).generic_string().c_str(), std::ios::binary );
+   FC_ASSERT( index && log, "Unable to read the account history archive of ${a}", ("a", account) );
+   const uint64_t first_sequence = read_uint64( index, 0 );
+   const uint64_t count = ( fc::file_size( index_file ) - index_header_size ) / sizeof(uint64_t);
+   if( count == 0 || last_sequence < first_sequence )
+      return result;
+   last_sequence = std::min( last_sequence, first_sequence + count - 1 );
+
+   result.reserve( std::min<uint64_t>( limit, last_sequence - first_sequence + 1 ) );
+   std::vector<char> packed;
+   for( uint64_t sequence = last_sequence; sequence >= first_sequence && result.size() < limit; --sequence )
+   {
+      const uint64_t offset = read_uint64( index, index_header_size + ( sequence - first_sequence ) * sizeof(uint64_t) );
+      uint32_t packed_size = 0;
+      log.seekg( offset );
+      log.read( reinterpret_cast<char*>( &packed_size ), sizeof(packed_size) );
+      packed.resize( packed_size );
+      log.read( packed.data(), packed.size() );
+      FC_ASSERT( log, "Unable to read the account history archive of ${a}", ("a", account) );
+      result.push_back( fc::raw::unpack<operation_history_object>( packed ) );
+      if( sequence == 0 )
+         break;
+   }
+   return result;
+} FC_CAPTURE_AND_RETHROW( (account)(last_sequence)(limit) ) }
+
+} } // graphene::account_history
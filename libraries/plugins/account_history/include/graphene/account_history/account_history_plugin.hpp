@@ -23,6 +23,8 @@
  */
 #pragma once
 
+#include <graphene/account_history/history_archive.hpp>
+
 #include <graphene/app/plugin.hpp>
 #include <graphene/chain/database.hpp>
 
@@ -30,6 +32,10 @@
 
 #include <fc/thread/future.hpp>
 
+#include <set>
+#include <tuple>
+#include <unordered_map>
+
 namespace graphene { namespace account_history {
    using namespace chain;
    //using namespace graphene::db;
@@ -56,6 +62,39 @@ enum account_history_object_type
 };
 
 
+/**
+ *  @brief This secondary index orders the account history entries of each account by operation type.
+ *
+ *  The type is taken from the operation, which undo may restore after the entry, so the index is also told
+ *  about inserted operations.
+ */
+class account_history_by_type_index : public secondary_index
+{
+   public:
+      explicit account_history_by_type_index( const database& db ) : _db( db ) {}
+
+      void object_inserted( const object& obj ) override;
+      void object_removed( const object& obj ) override;
+
+      /// Indexes the entries which were inserted before @p oho
+      void operation_inserted( const operation_history_object& oho );
+
+      /// Sequence numbers of the entries of @p account with operations of @p operation_type and
+      /// @p first_sequence <= sequence <= @p last_sequence, newest first, at most @p limit
+      vector<uint64_t> get_sequences( account_id_type account, uint16_t operation_type, uint64_t first_sequence,
+                                      uint64_t last_sequence, uint32_t limit )const;
+
+   private:
+      typedef std::tuple<account_id_type, uint16_t, uint64_t> type_key;
+
+      void insert( const account_transaction_history_object& ath, uint16_t operation_type );
+
+      const database&                          _db;
+      std::set<type_key>                       _by_type;
+      /// Operation type of each indexed entry by instance of its account_transaction_history_object
+      std::unordered_map<uint64_t, uint16_t>   _types;
+};
+
 namespace detail
 {
     class account_history_plugin_impl;
@@ -76,6 +115,12 @@ class account_history_plugin : public graphene::app::plugin
 
       flat_set<account_id_type> tracked_accounts()const;
 
+      /// The store of the entries dropped from memory, null unless archive-account-history is enabled
+      const account_history_archive* history_archive()const;
+
+      /// The history entries by operation type, null unless index-history-by-operation-type is enabled
+      const account_history_by_type_index* history_by_type_index()const;
+
    private:
       std::unique_ptr<detail::account_history_plugin_impl> my;
 };
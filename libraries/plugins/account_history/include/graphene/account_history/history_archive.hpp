@@ -0,0 +1,70 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <graphene/chain/operation_history_object.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace graphene { namespace account_history {
+
+   using graphene::chain::account_id_type;
+   using graphene::chain::operation_history_object;
+
+   /**
+    * @class account_history_archive
+    * @brief An on-disk store for account history entries which were dropped from memory
+    *
+    * Each account has an append-only log of its operations and an index which maps the account history sequence
+    * numbers to log offsets, so that the entries older than the ones kept in memory can still be served.
+    *
+    * Entries are appended in sequence order. Appending a sequence which is already stored, e.g. after a chain
+    * reorganization, drops it and all later entries of the account first. Because of this, readers must not
+    * ask for sequences above the account's current account_statistics_object::removed_ops.
+    *
+    * All methods are thread-safe.
+    */
+   class account_history_archive
+   {
+      public:
+         explicit account_history_archive( const fc::path& dir );
+
+         void append( account_id_type account, uint64_t sequence, const operation_history_object& op );
+
+         /**
+          * @brief Reads archived entries of an account, newest first
+          * @return The entries with the sequence numbers @p last_sequence, @p last_sequence - 1 and so on, until
+          *         @p limit entries are read or the oldest archived entry is reached
+          */
+         std::vector<operation_history_object> read( account_id_type account, uint64_t last_sequence,
+                                                     uint32_t limit )const;
+
+      private:
+         fc::path log_path( account_id_type account )const;
+         fc::path index_path( account_id_type account )const;
+
+         const fc::path     _dir;
+         mutable std::mutex _mutex;
+   };
+
+} } // graphene::account_history
@@ -24,8 +24,11 @@
 
 #include <graphene/api_helper_indexes/api_helper_indexes.hpp>
 #include <graphene/chain/market_object.hpp>
+#include <graphene/chain/personal_data_v2_object.hpp>
 #include <graphene/chain/proposal_object.hpp>
 
+#include <algorithm>
+
 namespace graphene { namespace api_helper_indexes {
 
 void amount_in_collateral_index::object_inserted( const object& objct )
@@ -92,6 +95,204 @@ share_type amount_in_collateral_index::get_backing_collateral( const asset_id_ty
    return itr->second;
 } FC_CAPTURE_AND_RETHROW( (asst) ) }
 
+void personal_data_merkle_index::object_inserted( const object& objct )
+{ try {
+   const personal_data_v2_object& o = static_cast<const personal_data_v2_object&>( objct );
+   auto& tree = trees[ std::make_pair( o.subject_account, o.operator_account ) ];
+   tree.hashes.insert( o.hash );
+   tree.dirty = true;
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void personal_data_merkle_index::object_removed( const object& objct )
+{ try {
+   const personal_data_v2_object& o = static_cast<const personal_data_v2_object&>( objct );
+   auto itr = trees.find( std::make_pair( o.subject_account, o.operator_account ) );
+   if( itr == trees.end() ) // should never happen
+      return;
+   itr->second.hashes.erase( o.hash );
+   itr->second.dirty = true;
+   if( itr->second.hashes.empty() )
+      trees.erase( itr );
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void personal_data_merkle_index::about_to_modify( const object& objct )
+{ try {
+   object_removed( objct );
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void personal_data_merkle_index::object_modified( const object& objct )
+{ try {
+   object_inserted( objct );
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+fc::sha256 personal_data_merkle_index::leaf_hash( const string& hash )
+{
+   fc::sha256::encoder enc;
+   enc.put( char(0) );
+   enc.write( hash.data(), hash.size() );
+   return enc.result();
+}
+
+void asset_holders_count_index::object_inserted( const object& objct )
+{ try {
+   const account_balance_object& o = static_cast<const account_balance_object&>( objct );
+   if( o.balance != 0 )
+      ++holders[o.asset_type];
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void asset_holders_count_index::object_removed( const object& objct )
+{ try {
+   const account_balance_object& o = static_cast<const account_balance_object&>( objct );
+   if( o.balance == 0 )
+      return;
+   auto itr = holders.find( o.asset_type );
+   if( itr != holders.end() && itr->second > 0 ) // should always be true
+      --itr->second;
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void asset_holders_count_index::about_to_modify( const object& objct )
+{ try {
+   object_removed( objct );
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void asset_holders_count_index::object_modified( const object& objct )
+{ try {
+   object_inserted( objct );
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+uint64_t asset_holders_count_index::get_holders_count( const asset_id_type& asset )const
+{
+   auto itr = holders.find( asset );
+   return itr == holders.end() ? 0 : itr->second;
+}
+
+void order_book_level_index::object_inserted( const object& objct )
+{ try {
+   const limit_order_object& o = static_cast<const limit_order_object&>( objct );
+   auto& lvl = sides[ std::make_pair( o.sell_price.base.asset_id, o.sell_price.quote.asset_id ) ][ o.sell_price ];
+   lvl.for_sale += o.for_sale;
+   ++lvl.order_count;
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void order_book_level_index::object_removed( const object& objct )
+{ try {
+   const limit_order_object& o = static_cast<const limit_order_object&>( objct );
+   auto side = sides.find( std::make_pair( o.sell_price.base.asset_id, o.sell_price.quote.asset_id ) );
+   if( side == sides.end() ) // should never happen
+      return;
+   auto itr = side->second.find( o.sell_price );
+   if( itr == side->second.end() ) // should never happen
+      return;
+   if( itr->second.order_count <= 1 )
+   {
+      side->second.erase( itr );
+      if( side->second.empty() )
+         sides.erase( side );
+   }
+   else
+   {
+      itr->second.for_sale -= o.for_sale;
+      --itr->second.order_count;
+   }
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void order_book_level_index::about_to_modify( const object& objct )
+{ try {
+   object_removed( objct );
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void order_book_level_index::object_modified( const object& objct )
+{ try {
+   object_inserted( objct );
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+const order_book_level_index::levels_type& order_book_level_index::get_levels( asset_id_type sell,
+                                                                               asset_id_type receive )const
+{
+   static const levels_type empty;
+   auto itr = sides.find( std::make_pair( sell, receive ) );
+   return itr == sides.end() ? empty : itr->second;
+}
+
+fc::sha256 personal_data_merkle_index::node_hash( const fc::sha256& left, const fc::sha256& right )
+{
+   fc::sha256::encoder enc;
+   enc.put( char(1) );
+   enc.write( left.data(), left.data_size() );
+   enc.write( right.data(), right.data_size() );
+   return enc.result();
+}
+
+void personal_data_merkle_index::merkle_tree::build()const
+{
+   sorted.assign( hashes.begin(), hashes.end() );
+   levels.clear();
+   levels.emplace_back();
+   levels.back().reserve( sorted.size() );
+   for( const auto& hash : sorted )
+      levels.back().push_back( leaf_hash( hash ) );
+   while( levels.back().size() > 1 )
+   {
+      const auto& below = levels.back();
+      vector<fc::sha256> level;
+      level.reserve( ( below.size() + 1 ) / 2 );
+      for( size_t i = 0; i < below.size(); i += 2 )
+         level.push_back( i + 1 < below.size() ? node_hash( below[i], below[i + 1] ) : below[i] );
+      levels.push_back( std::move( level ) );
+   }
+   dirty = false;
+}
+
+optional<personal_data_proof> personal_data_merkle_index::get_proof( account_id_type subject_account,
+                                                                     account_id_type operator_account,
+                                                                     const string& hash )const
+{ try {
+   auto itr = trees.find( std::make_pair( subject_account, operator_account ) );
+   if( itr == trees.end() )
+      return {};
+   const merkle_tree& tree = itr->second;
+   if( tree.dirty )
+      tree.build();
+
+   auto pos = std::lower_bound( tree.sorted.begin(), tree.sorted.end(), hash );
+   if( pos == tree.sorted.end() || *pos != hash )
+      return {};
+
+   personal_data_proof proof;
+   proof.root = tree.levels.back().front();
+   proof.leaf_index = pos - tree.sorted.begin();
+   proof.leaf_count = tree.sorted.size();
+   size_t index = proof.leaf_index;
+   for( size_t level = 0; level + 1 < tree.levels.size(); ++level, index /= 2 )
+   {
+      const size_t sibling = index ^ 1;
+      if( sibling < tree.levels[level].size() )
+         proof.siblings.push_back( tree.levels[level][sibling] );
+   }
+   return proof;
+} FC_CAPTURE_AND_RETHROW( (subject_account)(operator_account)(hash) ) }
+
+bool personal_data_merkle_index::verify( const personal_data_proof& proof, const string& hash )
+{
+   if( proof.leaf_index >= proof.leaf_count )
+      return false;
+   fc::sha256 node = leaf_hash( hash );
+   uint64_t index = proof.leaf_index;
+   uint64_t count = proof.leaf_count;
+   size_t used = 0;
+   for( ; count > 1; index /= 2, count = ( count + 1 ) / 2 )
+   {
+      const uint64_t sibling = index ^ 1;
+      if( sibling >= count )
+         continue;
+      if( used >= proof.siblings.size() )
+         return false;
+      const fc::sha256& other = proof.siblings[used++];
+      node = ( index % 2 == 0 ) ? node_hash( node, other ) : node_hash( other, node );
+   }
+   return used == proof.siblings.size() && node == proof.root;
+}
+
 namespace detail
 {
 
@@ -147,16 +348,42 @@ void api_helper_indexes::plugin_startup()
    ilog("api_helper_indexes: plugin_startup() begin");
    amount_in_collateral_idx = database().add_secondary_index< primary_index<call_order_index>,
                                                               amount_in_collateral_index >();
+   account_members_idx = database().add_secondary_index< primary_index<account_index>, account_member_index >();
+   account_names_idx = database().add_secondary_index< primary_index<account_index>, account_name_lookup_index >();
+   holders_count_idx = database().add_secondary_index< primary_index<account_balance_index>,
+                                                       asset_holders_count_index >();
+   asset_symbols_idx = database().add_secondary_index< primary_index<asset_index>, asset_symbol_lookup_index >();
+   approvals_idx = database().add_secondary_index< primary_index<proposal_index>, required_approval_index >();
+   personal_data_idx = database().add_secondary_index< primary_index<personal_data_v2_index>,
+                                                       personal_data_merkle_index >();
+   order_book_levels_idx = database().add_secondary_index< primary_index<limit_order_index>,
+                                                           order_book_level_index >();
+}
+
+void api_helper_indexes::plugin_load_state()
+{
    for( const auto& call : database().get_index_type<call_order_index>().indices() )
       amount_in_collateral_idx->object_inserted( call );
 
-   auto& account_members = *database().add_secondary_index< primary_index<account_index>, account_member_index >();
+   account_members_idx->load( database().get_index_type< account_index >() );
+
    for( const auto& account : database().get_index_type< account_index >().indices() )
-      account_members.object_inserted( account );
+      account_names_idx->object_inserted( account );
+
+   for( const auto& balance : database().get_index_type< account_balance_index >().indices() )
+      holders_count_idx->object_inserted( balance );
+
+   for( const auto& asset : database().get_index_type< asset_index >().indices() )
+      asset_symbols_idx->object_inserted( asset );
 
-   auto& approvals = *database().add_secondary_index< primary_index<proposal_index>, required_approval_index >();
    for( const auto& proposal : database().get_index_type< proposal_index >().indices() )
-      approvals.object_inserted( proposal );
+      approvals_idx->object_inserted( proposal );
+
+   for( const auto& pd : database().get_index_type< personal_data_v2_index >().indices() )
+      personal_data_idx->object_inserted( pd );
+
+   for( const auto& order : database().get_index_type< limit_order_index >().indices() )
+      order_book_levels_idx->object_inserted( order );
 }
 
 } }
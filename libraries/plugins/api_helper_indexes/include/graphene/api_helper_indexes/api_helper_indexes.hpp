@@ -24,8 +24,17 @@
 #pragma once
 
 #include <graphene/app/plugin.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/proposal_object.hpp>
 #include <graphene/protocol/types.hpp>
 
+#include <fc/crypto/sha256.hpp>
+
+#include <map>
+#include <set>
+#include <unordered_map>
+
 namespace graphene { namespace api_helper_indexes {
 using namespace chain;
 
@@ -51,6 +60,143 @@ class amount_in_collateral_index : public secondary_index
       flat_map<asset_id_type, share_type> backing_collateral;
 };
 
+/**
+ *  @brief This secondary index counts the accounts holding a non-zero balance of each asset, so that the number
+ *         of holders of an asset does not need a scan over its balances.
+ */
+class asset_holders_count_index : public secondary_index
+{
+   public:
+      void object_inserted( const object& obj ) override;
+      void object_removed( const object& obj ) override;
+      void about_to_modify( const object& before ) override;
+      void object_modified( const object& after ) override;
+
+      uint64_t get_holders_count( const asset_id_type& asset )const;
+
+   private:
+      flat_map<asset_id_type, uint64_t> holders;
+};
+
+/**
+ *  @brief This secondary index sums up the limit orders of each market side by price, so that order books are read
+ *         as price levels instead of iterating over the orders.
+ *
+ *  Prices are compared as ratios, so orders with equal prices expressed by different amounts share a level.
+ */
+class order_book_level_index : public secondary_index
+{
+   public:
+      struct level
+      {
+         share_type for_sale;
+         uint32_t   order_count = 0;
+      };
+      /// The levels of one side of a market by their price, best price first
+      typedef std::map<price, level, std::greater<price>> levels_type;
+
+      void object_inserted( const object& obj ) override;
+      void object_removed( const object& obj ) override;
+      void about_to_modify( const object& before ) override;
+      void object_modified( const object& after ) override;
+
+      /// The levels of the orders selling @p sell for @p receive
+      const levels_type& get_levels( asset_id_type sell, asset_id_type receive )const;
+
+   private:
+      std::map<std::pair<asset_id_type, asset_id_type>, levels_type> sides;
+};
+
+/// Proves that a personal data hash belongs to the Merkle tree of a subject and operator account
+struct personal_data_proof
+{
+   fc::sha256         root;
+   uint32_t           leaf_index = 0;  ///< position of the hash among the hashes sorted as strings
+   uint32_t           leaf_count = 0;
+   vector<fc::sha256> siblings;        ///< from the leaf level up, levels where the node has no sibling are skipped
+};
+
+/**
+ *  @brief This secondary index keeps a Merkle tree over the personal data hashes of each pair of subject and
+ *         operator account.
+ *
+ *  Leaves are the SHA-256 of the hashes prefixed by 0x00, in order of the hashes. Inner nodes are the SHA-256 of
+ *  0x01 followed by their children, a node without a sibling moves up a level unchanged. Trees are rebuilt on
+ *  the first query after a change.
+ *
+ *  @note The roots are computed by this node, they are not part of the consensus state.
+ */
+class personal_data_merkle_index : public secondary_index
+{
+   public:
+      void object_inserted( const object& obj ) override;
+      void object_removed( const object& obj ) override;
+      void about_to_modify( const object& before ) override;
+      void object_modified( const object& after ) override;
+
+      /// Invalid if @p hash is not a personal data hash of the accounts
+      optional<personal_data_proof> get_proof( account_id_type subject_account, account_id_type operator_account,
+                                               const string& hash )const;
+
+      static fc::sha256 leaf_hash( const string& hash );
+      static fc::sha256 node_hash( const fc::sha256& left, const fc::sha256& right );
+      /// Checks that @p proof leads from @p hash to its root
+      static bool verify( const personal_data_proof& proof, const string& hash );
+
+   private:
+      struct merkle_tree
+      {
+         std::set<string>                        hashes;
+         mutable vector<string>                  sorted;
+         /// levels[0] are the leaves, the last level is the root
+         mutable vector<vector<fc::sha256>>      levels;
+         mutable bool                            dirty = true;
+
+         void build()const;
+      };
+
+      std::map<std::pair<account_id_type, account_id_type>, merkle_tree> trees;
+};
+
+/**
+ *  @brief This secondary index maps the names of objects to the objects in a hash table, for API calls which look
+ *         up many accounts or assets by name.
+ *  @tparam ObjectType the type of the objects in the primary index
+ *  @tparam Name the unique name field of ObjectType
+ */
+template<typename ObjectType, string ObjectType::*Name>
+class name_lookup_index : public secondary_index
+{
+   public:
+      void object_inserted( const object& obj ) override
+      {
+         const ObjectType& o = static_cast<const ObjectType&>( obj );
+         by_name[o.*Name] = &o;
+      }
+      void object_removed( const object& obj ) override
+      {
+         const ObjectType& o = static_cast<const ObjectType&>( obj );
+         auto itr = by_name.find( o.*Name );
+         if( itr != by_name.end() && itr->second == &o )
+            by_name.erase( itr );
+      }
+      void about_to_modify( const object& before ) override { object_removed( before ); }
+      void object_modified( const object& after ) override { object_inserted( after ); }
+
+      /// nullptr if there is no object named @p name
+      const ObjectType* find( const string& name )const
+      {
+         auto itr = by_name.find( name );
+         return itr == by_name.end() ? nullptr : itr->second;
+      }
+
+   private:
+      std::unordered_map<string, const ObjectType*> by_name;
+};
+
+typedef name_lookup_index<account_object, &account_object::name> account_name_lookup_index;
+typedef name_lookup_index<asset_object, &asset_object::symbol>   asset_symbol_lookup_index;
+
 namespace detail
 {
     class api_helper_indexes_impl;
@@ -69,12 +215,22 @@ class api_helper_indexes : public graphene::app::plugin
          boost::program_options::options_description& cfg) override;
       void plugin_initialize(const boost::program_options::variables_map& options) override;
       void plugin_startup() override;
+      void plugin_load_state() override;
 
       friend class detail::api_helper_indexes_impl;
 
    private:
       std::unique_ptr<detail::api_helper_indexes_impl> my;
       amount_in_collateral_index* amount_in_collateral_idx = nullptr;
+      account_member_index*       account_members_idx = nullptr;
+      account_name_lookup_index*  account_names_idx = nullptr;
+      asset_holders_count_index*  holders_count_idx = nullptr;
+      asset_symbol_lookup_index*  asset_symbols_idx = nullptr;
+      required_approval_index*    approvals_idx = nullptr;
+      personal_data_merkle_index* personal_data_idx = nullptr;
+      order_book_level_index*     order_book_levels_idx = nullptr;
 };
 
 } } //graphene::template
+
+FC_REFLECT( graphene::api_helper_indexes::personal_data_proof, (root)(leaf_index)(leaf_count)(siblings) )
@@ -24,16 +24,526 @@
 
 #include <graphene/content_cards/content_cards.hpp>
 
+#include <fc/thread/thread.hpp>
+
+#include <curl/curl.h>
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <sstream>
+
 namespace graphene { namespace content_cards {
 
+namespace {
+
+/// Walks a (key, timestamp, id) set backwards from the newest entry before @p to
+template<typename Set, typename Key>
+vector<content_card_v2_id_type> newest_cards( const Set& cards, const Key& key, time_point_sec from,
+                                              time_point_sec to, uint32_t limit )
+{
+   vector<content_card_v2_id_type> result;
+   if( to <= from )
+      return result;
+   auto itr = cards.lower_bound( std::make_tuple( key, uint64_t( to.sec_since_epoch() ), content_card_v2_id_type() ) );
+   while( result.size() < limit && itr != cards.begin() )
+   {
+      --itr;
+      if( std::get<0>( *itr ) != key || std::get<1>( *itr ) < from.sec_since_epoch() )
+         break;
+      result.push_back( std::get<2>( *itr ) );
+   }
+   return result;
+}
+
+}
+
+void content_card_feed_index::object_inserted( const object& objct )
+{ try {
+   const content_card_v2_object& o = static_cast<const content_card_v2_object&>( objct );
+   by_type.emplace( o.type, o.timestamp, content_card_v2_id_type( o.id ) );
+   by_subject.emplace( o.subject_account, o.timestamp, content_card_v2_id_type( o.id ) );
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void content_card_feed_index::object_removed( const object& objct )
+{ try {
+   const content_card_v2_object& o = static_cast<const content_card_v2_object&>( objct );
+   by_type.erase( std::make_tuple( o.type, o.timestamp, content_card_v2_id_type( o.id ) ) );
+   by_subject.erase( std::make_tuple( o.subject_account, o.timestamp, content_card_v2_id_type( o.id ) ) );
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void content_card_feed_index::about_to_modify( const object& objct )
+{ try {
+   object_removed( objct );
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void content_card_feed_index::object_modified( const object& objct )
+{ try {
+   object_inserted( objct );
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+vector<content_card_v2_id_type> content_card_feed_index::get_cards_by_type( const string& type, time_point_sec from,
+                                                                            time_point_sec to, uint32_t limit )const
+{ try {
+   // unknown types are not added to the pool by a query
+   graphene::db::interned_string key;
+   if( !graphene::db::interned_string::find( type, key ) )
+      return {};
+   return newest_cards( by_type, key, from, to, limit );
+} FC_CAPTURE_AND_RETHROW( (type)(from)(to)(limit) ) }
+
+vector<content_card_v2_id_type> content_card_feed_index::get_cards_by_subject( account_id_type subject_account,
+                                                                               time_point_sec from,
+                                                                               time_point_sec to, uint32_t limit )const
+{ try {
+   return newest_cards( by_subject, subject_account, from, to, limit );
+} FC_CAPTURE_AND_RETHROW( (subject_account)(from)(to)(limit) ) }
+
+content_card_version::content_card_version( const content_card_v2_object& card )
+: url( card.url ),
+  type( card.type.str() ),
+  description( card.description ),
+  content_key( card.content_key ),
+  storage_data( card.storage_data ),
+  timestamp( card.timestamp )
+{
+}
+
+void content_card_version::revert( const content_card_version_object& delta )
+{
+   version = delta.version;
+   replaced_in_block = delta.replaced_in_block;
+   if( delta.url.valid() )
+      url = *delta.url;
+   if( delta.type.valid() )
+      type = *delta.type;
+   if( delta.description.valid() )
+      description = *delta.description;
+   if( delta.content_key.valid() )
+      content_key = *delta.content_key;
+   if( delta.storage_data.valid() )
+      storage_data = *delta.storage_data;
+   if( delta.timestamp.valid() )
+      timestamp = *delta.timestamp;
+}
+
+namespace detail
+{
+
+/**
+ *  Keeps copies of the cards as they were before each modification, until the block is handled. Undo and pending
+ *  transactions modify cards as well, but the modifications of the block come last.
+ */
+class content_card_prior_version_index : public secondary_index
+{
+   public:
+      void about_to_modify( const object& before ) override
+      {
+         const content_card_v2_object& o = static_cast<const content_card_v2_object&>( before );
+         prior_versions[ o.id.instance() ].push_back( o );
+      }
+
+      std::unordered_map<uint64_t, vector<content_card_v2_object>> prior_versions;
+};
+
+class content_cards_impl
+{
+   public:
+      explicit content_cards_impl( content_cards_plugin& _plugin ) : _self( _plugin ) {}
+      ~content_cards_impl();
+
+      void on_block( const graphene::chain::applied_block_event& e );
+      /// Stores the prior versions of the cards updated by the block
+      void record_versions( const signed_block& b );
+
+      graphene::chain::database& database()
+      {
+         return _self.database();
+      }
+
+      friend class graphene::content_cards::content_cards_plugin;
+
+   private:
+      void queue_fetch( const string& url, const string& hash );
+      void fetch( const string& url, const string& hash );
+
+      content_cards_plugin& _self;
+
+      fc::path _store_dir;
+      uint64_t _memory_cache_size = 64 * 1024 * 1024;
+      uint64_t _max_content_size = 16 * 1024 * 1024;
+      bool     _fetch_content = false;
+      bool     _keep_history = false;
+
+      std::unique_ptr<content_store> _store;
+
+      content_card_feed_index*   _feeds = nullptr;
+      content_card_search_index* _search = nullptr;
+      content_vote_count_index*  _votes = nullptr;
+      permission_lookup_index*   _perms = nullptr;
+      content_card_prior_version_index* _prior_versions = nullptr;
+
+      /// Blocks are scanned off the main thread, the content is no input of the chain
+      std::shared_ptr<graphene::chain::async_block_handler> _block_handler;
+      /// Fetches run one after another, off the main thread
+      std::shared_ptr<fc::thread> _fetch_thread;
+      CURL*                       _curl = nullptr;
+      std::atomic<uint32_t>       _pending_fetches { 0 };
+      static constexpr uint32_t   max_pending_fetches = 1000;
+};
+
+content_cards_impl::~content_cards_impl()
+{
+   _block_handler.reset();
+   _fetch_thread.reset();
+   if( _curl != nullptr )
+      curl_easy_cleanup( _curl );
+}
+
+void content_cards_impl::on_block( const graphene::chain::applied_block_event& e )
+{
+   for( const auto& oho : *e.applied_operations )
+   {
+      if( !oho.valid() )
+         continue;
+      if( oho->op.is_type<content_card_v2_create_operation>() )
+      {
+         const auto& op = oho->op.get<content_card_v2_create_operation>();
+         queue_fetch( op.url, op.hash );
+      }
+      else if( oho->op.is_type<content_card_v2_update_operation>() )
+      {
+         const auto& op = oho->op.get<content_card_v2_update_operation>();
+         queue_fetch( op.url, op.hash );
+      }
+   }
+}
+
+void content_cards_impl::record_versions( const signed_block& b )
+{
+   graphene::chain::database& db = database();
+   // the update operations of each card, in the order they were applied
+   std::map<content_card_v2_id_type, vector<const content_card_v2_update_operation*>> updates;
+   std::set<content_card_v2_id_type> removed;
+   for( const optional<operation_history_object>& oho : db.get_applied_operations() )
+   {
+      if( !oho.valid() )
+         continue;
+      if( oho->op.is_type<content_card_v2_update_operation>() )
+         updates[ content_card_v2_id_type( oho->result.get<object_id_type>() ) ].push_back(
+               &oho->op.get<content_card_v2_update_operation>() );
+      else if( oho->op.is_type<content_card_v2_remove_operation>() )
+         removed.insert( oho->op.get<content_card_v2_remove_operation>().content_id );
+   }
+
+   const auto& by_card_idx = db.get_index_type<content_card_version_index>().indices().get<by_card>();
+   for( const auto& id : removed )
+   {
+      updates.erase( id );
+      auto itr = by_card_idx.lower_bound( boost::make_tuple( id ) );
+      while( itr != by_card_idx.end() && itr->card == id )
+         db.remove( *itr++ );
+   }
+
+   for( const auto& item : updates )
+   {
+      const content_card_v2_id_type id = item.first;
+      const size_t count = item.second.size();
+      const auto& priors = _prior_versions->prior_versions[ id.instance.value ];
+      const content_card_v2_object* card = db.find( id );
+      if( card == nullptr || priors.size() < count ) // should never happen
+         continue;
+
+      auto last = by_card_idx.upper_bound( boost::make_tuple( id ) );
+      uint32_t version = 1;
+      if( last != by_card_idx.begin() && std::prev( last )->card == id )
+         version = std::prev( last )->version + 1;
+
+      // the modifications of the block are the last ones seen, each followed by the next one or the card itself
+      for( size_t i = priors.size() - count; i < priors.size(); ++i, ++version )
+      {
+         const content_card_v2_object& before = priors[i];
+         const content_card_v2_object& after = i + 1 < priors.size() ? priors[i + 1] : *card;
+         db.create<content_card_version_object>( [&]( content_card_version_object& v ) {
+            v.card = id;
+            v.version = version;
+            v.replaced_in_block = b.block_num();
+            if( before.url != after.url )
+               v.url = before.url;
+            if( before.type != after.type )
+               v.type = before.type.str();
+            if( before.description != after.description )
+               v.description = before.description;
+            if( before.content_key != after.content_key )
+               v.content_key = before.content_key;
+            if( before.storage_data != after.storage_data )
+               v.storage_data = before.storage_data;
+            if( before.timestamp != after.timestamp )
+               v.timestamp = before.timestamp;
+         });
+      }
+   }
+   _prior_versions->prior_versions.clear();
+}
+
+void content_cards_impl::queue_fetch( const string& url, const string& hash )
+{
+   if( url.empty() || !content_store::is_valid_hash( hash ) || _store->contains( hash ) )
+      return;
+   // skipped content is fetched again when a card refers to it later
+   if( _pending_fetches >= max_pending_fetches )
+      return;
+   ++_pending_fetches;
+   _fetch_thread->async( [this, url, hash]() {
+      fetch( url, hash );
+      --_pending_fetches;
+   }, "content_cards fetch" );
+}
+
+namespace {
+   struct fetch_buffer
+   {
+      std::vector<char> data;
+      uint64_t          max_size;
+   };
+
+   size_t write_fetched_data( char* ptr, size_t size, size_t nmemb, void* userdata )
+   {
+      fetch_buffer& buffer = *static_cast<fetch_buffer*>( userdata );
+      const size_t bytes = size * nmemb;
+      if( buffer.data.size() + bytes > buffer.max_size )
+         return 0; // aborts the transfer
+      buffer.data.insert( buffer.data.end(), ptr, ptr + bytes );
+      return bytes;
+   }
+}
+
+void content_cards_impl::fetch( const string& url, const string& hash )
+{
+   try
+   {
+      if( _store->contains( hash ) )
+         return;
+
+      fetch_buffer buffer{ {}, _max_content_size };
+      curl_easy_reset( _curl );
+      curl_easy_setopt( _curl, CURLOPT_URL, url.c_str() );
+      curl_easy_setopt( _curl, CURLOPT_PROTOCOLS, CURLPROTO_HTTP | CURLPROTO_HTTPS );
+      curl_easy_setopt( _curl, CURLOPT_REDIR_PROTOCOLS, CURLPROTO_HTTP | CURLPROTO_HTTPS );
+      curl_easy_setopt( _curl, CURLOPT_FOLLOWLOCATION, 1L );
+      curl_easy_setopt( _curl, CURLOPT_MAXREDIRS, 3L );
+      curl_easy_setopt( _curl, CURLOPT_TIMEOUT, 60L );
+      curl_easy_setopt( _curl, CURLOPT_FAILONERROR, 1L );
+      curl_easy_setopt( _curl, CURLOPT_WRITEFUNCTION, write_fetched_data );
+      curl_easy_setopt( _curl, CURLOPT_WRITEDATA, &buffer );
+      const CURLcode res = curl_easy_perform( _curl );
+      if( res != CURLE_OK )
+      {
+         wlog( "content_cards: unable to fetch ${u}: ${e}", ("u", url)("e", curl_easy_strerror( res )) );
+         return;
+      }
+      _store->store( hash, buffer.data );
+   }
+   catch( const fc::exception& e )
+   {
+      wlog( "content_cards: unable to store content of ${u}: ${e}", ("u", url)("e", e.to_detail_string()) );
+   }
+}
+
+} // end namespace detail
+
+void content_card_search_index::object_inserted( const object& objct )
+{ try {
+   const content_card_v2_object& o = static_cast<const content_card_v2_object&>( objct );
+   for( const auto& word : tokenize( o.description ) )
+      postings[ word ].insert( content_card_v2_id_type( o.id ) );
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void content_card_search_index::object_removed( const object& objct )
+{ try {
+   const content_card_v2_object& o = static_cast<const content_card_v2_object&>( objct );
+   for( const auto& word : tokenize( o.description ) )
+   {
+      auto itr = postings.find( word );
+      if( itr == postings.end() ) // should never happen
+         continue;
+      itr->second.erase( content_card_v2_id_type( o.id ) );
+      if( itr->second.empty() )
+         postings.erase( itr );
+   }
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void content_card_search_index::about_to_modify( const object& objct )
+{ try {
+   object_removed( objct );
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void content_card_search_index::object_modified( const object& objct )
+{ try {
+   object_inserted( objct );
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+std::set<string> content_card_search_index::tokenize( const string& text )
+{
+   std::set<string> words;
+   string word;
+   auto flush = [&words, &word]() {
+      if( !word.empty() )
+         words.insert( word.substr( 0, max_word_length ) );
+      word.clear();
+   };
+   for( char c : text )
+   {
+      const unsigned char u = static_cast<unsigned char>( c );
+      if( ( u >= 'a' && u <= 'z' ) || ( u >= '0' && u <= '9' ) || u >= 0x80 )
+         word.push_back( c );
+      else if( u >= 'A' && u <= 'Z' )
+         word.push_back( char( u - 'A' + 'a' ) );
+      else
+         flush();
+   }
+   flush();
+   return words;
+}
+
+vector<content_card_v2_id_type> content_card_search_index::search( const string& query, uint32_t limit )const
+{ try {
+   // the words of the query, with a flag telling whether it is a prefix
+   vector<std::pair<string, bool>> terms;
+   string term;
+   std::istringstream in( query );
+   while( terms.size() < max_query_words && in >> term )
+   {
+      // a prefix must be a single word, e.g. "photo*" but not "new-photo*"
+      const auto words = tokenize( term );
+      const bool prefix = term.back() == '*' && words.size() == 1;
+      for( const auto& word : words )
+         terms.emplace_back( word, prefix );
+   }
+
+   std::unordered_map<uint64_t, uint32_t> scores;
+   for( const auto& t : terms )
+   {
+      std::set<content_card_v2_id_type> matches;
+      if( t.second )
+      {
+         for( auto itr = postings.lower_bound( t.first );
+              itr != postings.end() && itr->first.compare( 0, t.first.size(), t.first ) == 0; ++itr )
+            matches.insert( itr->second.begin(), itr->second.end() );
+      }
+      else
+      {
+         auto itr = postings.find( t.first );
+         if( itr != postings.end() )
+            matches = itr->second;
+      }
+      for( const auto& id : matches )
+         ++scores[ id.instance.value ];
+   }
+
+   vector<std::pair<uint32_t, uint64_t>> ranked;
+   ranked.reserve( scores.size() );
+   for( const auto& s : scores )
+      ranked.emplace_back( s.second, s.first );
+   const size_t count = std::min<size_t>( limit, ranked.size() );
+   std::partial_sort( ranked.begin(), ranked.begin() + count, ranked.end(),
+                      []( const std::pair<uint32_t, uint64_t>& a, const std::pair<uint32_t, uint64_t>& b ) {
+                         return a.first != b.first ? a.first > b.first : a.second > b.second;
+                      } );
+
+   vector<content_card_v2_id_type> result;
+   result.reserve( count );
+   for( size_t i = 0; i < count; ++i )
+      result.push_back( content_card_v2_id_type( ranked[i].second ) );
+   return result;
+} FC_CAPTURE_AND_RETHROW( (query)(limit) ) }
+
 content_cards_plugin::content_cards_plugin(graphene::app::application& app) :
-   plugin(app)
+   plugin(app),
+   my( std::make_unique<detail::content_cards_impl>(*this) )
 {
    // Nothing else to do
 }
 
 content_cards_plugin::~content_cards_plugin() = default;
 
+void content_vote_count_index::object_inserted( const object& objct )
+{ try {
+   const content_vote_object& o = static_cast<const content_vote_object&>( objct );
+   auto& count = counts[o.content_id.str()];
+   ++count.total_votes;
+   count.last_update_block = _db.head_block_num() + 1;
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void content_vote_count_index::object_removed( const object& objct )
+{ try {
+   const content_vote_object& o = static_cast<const content_vote_object&>( objct );
+   auto itr = counts.find( o.content_id.str() );
+   if( itr == counts.end() ) // should never happen
+      return;
+   if( itr->second.total_votes <= 1 )
+      counts.erase( itr );
+   else
+   {
+      --itr->second.total_votes;
+      itr->second.last_update_block = _db.head_block_num() + 1;
+   }
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+content_vote_count content_vote_count_index::get_vote_count( const string& content_id )const
+{
+   auto itr = counts.find( content_id );
+   if( itr == counts.end() )
+      return content_vote_count();
+   return itr->second;
+}
+
+void permission_lookup_index::object_inserted( const object& objct )
+{ try {
+   const permission_object& o = static_cast<const permission_object&>( objct );
+   if( !o.object_id.valid() )
+      return;
+   auto& perms = permissions[ key_type( o.operator_account, *o.object_id ) ];
+   // new objects get higher ids, but undo may re-insert an older one
+   auto pos = std::find_if( perms.begin(), perms.end(),
+                            [&o]( const permission_object* p ) { return o.id < p->id; } );
+   perms.insert( pos, &o );
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void permission_lookup_index::object_removed( const object& objct )
+{ try {
+   const permission_object& o = static_cast<const permission_object&>( objct );
+   if( !o.object_id.valid() )
+      return;
+   auto itr = permissions.find( key_type( o.operator_account, *o.object_id ) );
+   if( itr == permissions.end() ) // should never happen
+      return;
+   auto& perms = itr->second;
+   perms.erase( std::remove( perms.begin(), perms.end(), &o ), perms.end() );
+   if( perms.empty() )
+      permissions.erase( itr );
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void permission_lookup_index::about_to_modify( const object& objct )
+{ try {
+   object_removed( objct );
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+void permission_lookup_index::object_modified( const object& objct )
+{ try {
+   object_inserted( objct );
+} FC_CAPTURE_AND_RETHROW( (objct) ) }
+
+const vector<const permission_object*>& permission_lookup_index::get_permissions( account_id_type operator_account,
+                                                                                  object_id_type object_id )const
+{
+   static const vector<const permission_object*> empty;
+   auto itr = permissions.find( key_type( operator_account, object_id ) );
+   if( itr == permissions.end() )
+      return empty;
+   return itr->second;
+}
+
 std::string content_cards_plugin::plugin_name()const
 {
    return "content_cards";
@@ -48,15 +558,94 @@ void content_cards_plugin::plugin_set_program_options(
    boost::program_options::options_description& cfg
    )
 {
+   cli.add_options()
+         ("content-cards-store-dir", boost::program_options::value<std::string>()->default_value("content_cards"),
+          "Directory of the content store, relative to the data directory unless absolute")
+         ("content-cards-fetch", boost::program_options::value<bool>()->default_value(false),
+          "Fetch the content of new content cards from their URL into the content store")
+         ("content-cards-memory-cache-size", boost::program_options::value<uint64_t>()->default_value(64),
+          "Megabytes of recently read content kept in memory")
+         ("content-cards-max-content-size", boost::program_options::value<uint64_t>()->default_value(16),
+          "Maximum size in megabytes of content to fetch")
+         ("content-cards-history", boost::program_options::value<bool>()->default_value(false),
+          "Keep the prior versions of updated content cards, as the fields changed by each update")
+         ;
+   cfg.add(cli);
 }
 
 void content_cards_plugin::plugin_initialize(const boost::program_options::variables_map& options)
-{
-}
+{ try {
+   fc::path store_dir = options.count("content-cards-store-dir") > 0 ?
+                        fc::path( options["content-cards-store-dir"].as<std::string>() ) : fc::path( "content_cards" );
+   if( store_dir.is_relative() )
+      store_dir = app().data_dir() / store_dir;
+   my->_store_dir = store_dir;
+   if( options.count("content-cards-fetch") > 0 )
+      my->_fetch_content = options["content-cards-fetch"].as<bool>();
+   if( options.count("content-cards-memory-cache-size") > 0 )
+      my->_memory_cache_size = options["content-cards-memory-cache-size"].as<uint64_t>() * 1024 * 1024;
+   if( options.count("content-cards-max-content-size") > 0 )
+      my->_max_content_size = options["content-cards-max-content-size"].as<uint64_t>() * 1024 * 1024;
+   if( options.count("content-cards-history") > 0 )
+      my->_keep_history = options["content-cards-history"].as<bool>();
+
+   if( my->_keep_history )
+   {
+      database().add_index< primary_index< content_card_version_index > >();
+      // blocks are replayed before the plugin is started
+      my->_prior_versions = database().add_secondary_index< primary_index<content_card_v2_index>,
+                                                            detail::content_card_prior_version_index >();
+      database().connect_applied_block( "content_cards", [this]( const signed_block& b ) {
+         my->record_versions( b );
+      } );
+   }
+
+   my->_store = std::make_unique<content_store>( my->_store_dir, my->_memory_cache_size );
+   if( my->_fetch_content )
+   {
+      my->_curl = curl_easy_init();
+      FC_ASSERT( my->_curl != nullptr, "Unable to initialize curl" );
+      my->_fetch_thread = std::make_shared<fc::thread>( "content_cards" );
+      my->_block_handler = database().connect_applied_block_async( "content_cards", 100,
+            [this]( const graphene::chain::applied_block_event& e ) {
+         my->on_block( e );
+      } );
+   }
+} FC_LOG_AND_RETHROW() }
 
 void content_cards_plugin::plugin_startup()
 {
    ilog("content_cards: plugin_startup() begin");
+   my->_feeds = database().add_secondary_index< primary_index<content_card_v2_index>, content_card_feed_index >();
+   my->_search = database().add_secondary_index< primary_index<content_card_v2_index>, content_card_search_index >();
+   my->_votes = database().add_secondary_index< primary_index<content_vote_index>, content_vote_count_index >(
+                                                std::cref( database() ) );
+   my->_perms = database().add_secondary_index< primary_index<permission_index>, permission_lookup_index >();
+}
+
+void content_cards_plugin::plugin_load_state()
+{
+   for( const auto& card : database().get_index_type< content_card_v2_index >().indices() )
+   {
+      my->_feeds->object_inserted( card );
+      my->_search->object_inserted( card );
+   }
+   for( const auto& vote : database().get_index_type< content_vote_index >().indices() )
+      my->_votes->object_inserted( vote );
+   for( const auto& perm : database().get_index_type< permission_index >().indices() )
+      my->_perms->object_inserted( perm );
+}
+
+void content_cards_plugin::plugin_shutdown()
+{
+   // pending fetches are dropped, they are retried when a card refers to the content again
+   my->_block_handler.reset();
+   my->_fetch_thread.reset();
+}
+
+const content_store* content_cards_plugin::get_content_store()const
+{
+   return my->_store.get();
 }
 
 } }
@@ -0,0 +1,163 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <graphene/content_cards/content_store.hpp>
+
+#include <fc/crypto/sha256.hpp>
+#include <fc/exception/exception.hpp>
+
+#include <algorithm>
+#include <fstream>
+
+namespace graphene { namespace content_cards {
+
+content_store::content_store( const fc::path& dir, uint64_t memory_limit )
+: _dir( dir ), _memory_limit( memory_limit )
+{
+   if( !fc::exists( _dir ) )
+      fc::create_directories( _dir );
+}
+
+bool content_store::is_valid_hash( const std::string& hash )
+{
+   return hash.size() == 64 && std::all_of( hash.begin(), hash.end(), []( char c ) {
+      return ( c >= '0' && c <= '9' ) || ( c >= 'a' && c <= 'f' );
+   });
+}
+
+fc::path content_store::blob_path( const std::string& hash )const
+{
+   FC_ASSERT( is_valid_hash( hash ), "Invalid content hash ${h}", ("h", hash) );
+   return _dir / hash.substr( 0, 2 ) / hash;
+}
+
+bool content_store::contains( const std::string& hash )const
+{
+   if( !is_valid_hash( hash ) )
+      return false;
+   if( find_cached( hash ) )
+      return true;
+   return fc::exists( blob_path( hash ) );
+}
+
+fc::optional<uint64_t> content_store::get_size( const std::string& hash )const
+{
+   if( !is_valid_hash( hash ) )
+      return {};
+   if( auto data = find_cached( hash ) )
+      return data->size();
+   const fc::path path = blob_path( hash );
+   if( !fc::exists( path ) )
+      return {};
+   return fc::file_size( path );
+}
+
+void content_store::store( const std::string& hash, const std::vector<char>& data )
+{ try {
+   FC_ASSERT( is_valid_hash( hash ), "Invalid content hash ${h}", ("h", hash) );
+   const auto actual = fc::sha256::hash( data.data(), data.size() ).str();
+   FC_ASSERT( actual == hash, "Content does not match its hash, actual hash is ${a}", ("a", actual) );
+
+   const fc::path path = blob_path( hash );
+   if( fc::exists( path ) )
+      return;
+   fc::create_directories( path.parent_path() );
+
+   // readers never see a partially written blob
+   const fc::path tmp_path = path.parent_path() / ( hash + ".tmp" );
+   {
+      std::ofstream out( tmp_path.generic_string().c_str(), std::ios::binary | std::ios::trunc );
+      FC_ASSERT( out, "Unable to write ${p}", ("p", tmp_path) );
+      out.write( data.data(), data.size() );
+      out.close();
+      FC_ASSERT( out, "Unable to write ${p}", ("p", tmp_path) );
+   }
+   fc::rename( tmp_path, path );
+} FC_CAPTURE_AND_RETHROW( (hash) ) }
+
+std::vector<char> content_store::read( const std::string& hash, uint64_t offset, uint32_t size )const
+{ try {
+   auto data = find_cached( hash );
+   if( !data )
+   {
+      const fc::path path = blob_path( hash );
+      FC_ASSERT( fc::exists( path ), "Content ${h} is not stored", ("h", hash) );
+      const uint64_t file_size = fc::file_size( path );
+      std::ifstream in( path.generic_string().c_str(), std::ios::binary );
+      FC_ASSERT( in, "Unable to read ${p}", ("p", path) );
+
+      // blobs which do not fit into the memory tier are read range by range
+      if( file_size > _memory_limit )
+      {
+         std::vector<char> result;
+         if( offset >= file_size )
+            return result;
+         result.resize( std::min<uint64_t>( size, file_size - offset ) );
+         in.seekg( offset );
+         in.read( result.data(), result.size() );
+         FC_ASSERT( in, "Unable to read ${p}", ("p", path) );
+         return result;
+      }
+
+      auto blob = std::make_shared<std::vector<char>>( file_size );
+      in.read( blob->data(), blob->size() );
+      FC_ASSERT( in, "Unable to read ${p}", ("p", path) );
+      data = blob;
+      cache( hash, data );
+   }
+
+   if( offset >= data->size() )
+      return std::vector<char>();
+   const auto begin = data->begin() + offset;
+   return std::vector<char>( begin, begin + std::min<uint64_t>( size, data->size() - offset ) );
+} FC_CAPTURE_AND_RETHROW( (hash)(offset)(size) ) }
+
+uint64_t content_store::memory_used()const
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   return _memory_used;
+}
+
+content_store::blob_ptr content_store::find_cached( const std::string& hash )const
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _cache.find( hash );
+   if( itr == _cache.end() )
+      return blob_ptr();
+   _lru.splice( _lru.begin(), _lru, itr->second.lru_pos );
+   return itr->second.data;
+}
+
+void content_store::cache( const std::string& hash, blob_ptr data )const
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   if( _cache.find( hash ) != _cache.end() )
+      return;
+   while( !_lru.empty() && _memory_used + data->size() > _memory_limit )
+   {
+      auto itr = _cache.find( _lru.back() );
+      _memory_used -= itr->second.data->size();
+      _cache.erase( itr );
+      _lru.pop_back();
+   }
+   _lru.push_front( hash );
+   _memory_used += data->size();
+   _cache[ hash ] = cache_entry{ std::move( data ), _lru.begin() };
+}
+
+} } // graphene::content_cards
@@ -25,6 +25,16 @@
 
 #include <graphene/app/plugin.hpp>
 #include <graphene/chain/database.hpp>
+#include <graphene/chain/content_card_v2_object.hpp>
+#include <graphene/chain/content_vote_object.hpp>
+#include <graphene/chain/permission_object.hpp>
+#include <graphene/content_cards/content_store.hpp>
+#include <graphene/db/interned_string.hpp>
+
+#include <map>
+#include <set>
+#include <tuple>
+#include <unordered_map>
 
 namespace graphene { namespace content_cards {
 using namespace chain;
@@ -43,6 +53,192 @@ using namespace chain;
 #define CONTENT_CARDS_SPACE_ID 8
 #endif
 
+enum content_cards_object_type
+{
+   content_card_version_object_type = 0
+};
+
+/**
+ *  @brief A prior version of a content card, stored as the fields which differ from the version following it
+ *
+ *  Versions are numbered from 1, the version created with the card. The newest version is the card itself, older
+ *  versions are rebuilt from it by applying the deltas newest first.
+ */
+struct content_card_version_object : public abstract_object<content_card_version_object>
+{
+   static constexpr uint8_t space_id = CONTENT_CARDS_SPACE_ID;
+   static constexpr uint8_t type_id  = content_card_version_object_type;
+
+   content_card_v2_id_type card;
+   uint32_t                version = 0;
+   /// Number of the block in which the version was replaced
+   uint32_t                replaced_in_block = 0;
+
+   optional<string>        url;
+   optional<string>        type;
+   optional<string>        description;
+   optional<string>        content_key;
+   optional<string>        storage_data;
+   optional<uint64_t>      timestamp;
+};
+
+struct by_card;
+typedef multi_index_container<
+   content_card_version_object,
+   indexed_by<
+      ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
+      ordered_unique< tag<by_card>,
+         composite_key< content_card_version_object,
+            member< content_card_version_object, content_card_v2_id_type, &content_card_version_object::card >,
+            member< content_card_version_object, uint32_t, &content_card_version_object::version >
+         >
+      >
+   >
+> content_card_version_multi_index_type;
+
+typedef generic_index<content_card_version_object, content_card_version_multi_index_type> content_card_version_index;
+
+/// A full version of a content card, as returned by @ref graphene::app::database_api::get_content_card_history
+struct content_card_version
+{
+   uint32_t version = 0;
+   string   url;
+   string   type;
+   string   description;
+   string   content_key;
+   string   storage_data;
+   uint64_t timestamp = 0;
+   /// Number of the block in which the version was replaced, 0 for the current version
+   uint32_t replaced_in_block = 0;
+
+   content_card_version() = default;
+   explicit content_card_version( const content_card_v2_object& card );
+
+   /// Turns this version into the one before it
+   void revert( const content_card_version_object& delta );
+};
+
+
+/**
+ *  @brief This secondary index orders content cards by type and by subject account, each by timestamp,
+ *         so that the newest cards of a feed are found without scanning all cards.
+ *  @note Cards only carry a type and a timestamp on nodes running the content_cards plugin.
+ */
+class content_card_feed_index : public secondary_index
+{
+   public:
+      void object_inserted( const object& obj ) override;
+      void object_removed( const object& obj ) override;
+      void about_to_modify( const object& before ) override;
+      void object_modified( const object& after ) override;
+
+      /// Cards of @p type with @p from <= timestamp < @p to, newest first, at most @p limit
+      vector<content_card_v2_id_type> get_cards_by_type( const string& type, time_point_sec from,
+                                                         time_point_sec to, uint32_t limit )const;
+      /// Cards of @p subject_account with @p from <= timestamp < @p to, newest first, at most @p limit
+      vector<content_card_v2_id_type> get_cards_by_subject( account_id_type subject_account, time_point_sec from,
+                                                            time_point_sec to, uint32_t limit )const;
+
+   private:
+      typedef std::tuple<graphene::db::interned_string, uint64_t, content_card_v2_id_type> type_key;
+      typedef std::tuple<account_id_type, uint64_t, content_card_v2_id_type>               subject_key;
+
+      std::set<type_key>    by_type;
+      std::set<subject_key> by_subject;
+};
+
+/**
+ *  @brief This secondary index is an inverted index of the words in the descriptions of content cards.
+ *
+ *  Words are runs of letters and digits, compared case-insensitively for ASCII letters. Bytes of multi-byte
+ *  UTF-8 characters are treated as letters, so that non-Latin words are found as well.
+ */
+class content_card_search_index : public secondary_index
+{
+   public:
+      /// Words longer than this are cut
+      static constexpr size_t max_word_length = 64;
+      /// Words beyond this number in a query are ignored
+      static constexpr size_t max_query_words = 16;
+
+      void object_inserted( const object& obj ) override;
+      void object_removed( const object& obj ) override;
+      void about_to_modify( const object& before ) override;
+      void object_modified( const object& after ) override;
+
+      /**
+       *  @brief Finds the cards containing words of @p query
+       *
+       *  A query word ending with '*' matches all words starting with it. Cards are ranked by the number of
+       *  query words they contain, then newest first, i.e. by descending id.
+       */
+      vector<content_card_v2_id_type> search( const string& query, uint32_t limit )const;
+
+      /// Splits @p text into distinct lower case words
+      static std::set<string> tokenize( const string& text );
+
+   private:
+      std::map<string, std::set<content_card_v2_id_type>> postings;
+};
+
+/// Number of votes for one content id
+struct content_vote_count
+{
+   uint64_t total_votes       = 0;
+   /// Number of the block in which the count last changed, or the head block at startup for counts loaded then
+   uint32_t last_update_block = 0;
+};
+
+/**
+ *  @brief This secondary index counts the content votes per content id, so that vote counts are looked up
+ *         instead of iterating over all voters.
+ */
+class content_vote_count_index : public secondary_index
+{
+   public:
+      explicit content_vote_count_index( const database& db ) : _db( db ) {}
+
+      void object_inserted( const object& obj ) override;
+      void object_removed( const object& obj ) override;
+
+      /// Returns an empty count for ids without votes
+      content_vote_count get_vote_count( const string& content_id )const;
+
+   private:
+      const database& _db;
+      std::unordered_map<string, content_vote_count> counts;
+};
+
+/**
+ *  @brief This secondary index maps an operator account and an object id to the permissions granted on it,
+ *         so that access checks are hash lookups instead of walking the ordered permission indexes.
+ *  @note Permissions without an object id are not included.
+ */
+class permission_lookup_index : public secondary_index
+{
+   public:
+      void object_inserted( const object& obj ) override;
+      void object_removed( const object& obj ) override;
+      void about_to_modify( const object& before ) override;
+      void object_modified( const object& after ) override;
+
+      /// Permissions of @p operator_account on @p object_id, oldest first
+      const vector<const permission_object*>& get_permissions( account_id_type operator_account,
+                                                               object_id_type object_id )const;
+
+   private:
+      typedef std::pair<account_id_type, object_id_type> key_type;
+      struct key_hash
+      {
+         size_t operator()( const key_type& k )const
+         {
+            return std::hash<uint64_t>()( uint64_t( k.first.instance.value ) * 0x9e3779b97f4a7c15ULL ^ k.second.number );
+         }
+      };
+
+      /// Objects keep their address while they are in the primary index
+      std::unordered_map<key_type, vector<const permission_object*>, key_hash> permissions;
+};
 
 namespace detail
 {
@@ -62,6 +258,21 @@ class content_cards_plugin : public graphene::app::plugin
          boost::program_options::options_description& cfg) override;
       virtual void plugin_initialize(const boost::program_options::variables_map& options) override;
       virtual void plugin_startup() override;
+      void plugin_load_state() override;
+      void plugin_shutdown() override;
+
+      /// The store of fetched content, null until the plugin is initialized
+      const content_store* get_content_store()const;
+
+   private:
+      std::unique_ptr<detail::content_cards_impl> my;
 };
 
 } } //graphene::template
+
+FC_REFLECT( graphene::content_cards::content_vote_count, (total_votes)(last_update_block) )
+FC_REFLECT_DERIVED( graphene::content_cards::content_card_version_object, (graphene::db::object),
+                    (card)(version)(replaced_in_block)
+                    (url)(type)(description)(content_key)(storage_data)(timestamp) )
+FC_REFLECT( graphene::content_cards::content_card_version,
+            (version)(url)(type)(description)(content_key)(storage_data)(timestamp)(replaced_in_block) )
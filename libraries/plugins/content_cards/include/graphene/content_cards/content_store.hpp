@@ -0,0 +1,95 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <fc/filesystem.hpp>
+#include <fc/optional.hpp>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace graphene { namespace content_cards {
+
+   /**
+    * @class content_store
+    * @brief A content-addressed blob store for the content of content cards
+    *
+    * Blobs are keyed by the hex encoded SHA-256 of their data, which is the hash content cards refer to, and
+    * written to one file per blob below the store directory. Recently read blobs are kept in memory up to a
+    * configured number of bytes, the least recently used ones are dropped first.
+    *
+    * All methods are thread-safe.
+    */
+   class content_store
+   {
+      public:
+         content_store( const fc::path& dir, uint64_t memory_limit );
+
+         /// true if @p hash has the form of a key, i.e. 64 lower case hex digits
+         static bool is_valid_hash( const std::string& hash );
+
+         bool contains( const std::string& hash )const;
+
+         /// Size of the blob in bytes, invalid if it is not stored
+         fc::optional<uint64_t> get_size( const std::string& hash )const;
+
+         /**
+          * @brief Stores a blob
+          * @throws fc::assert_exception if @p data does not match @p hash
+          */
+         void store( const std::string& hash, const std::vector<char>& data );
+
+         /**
+          * @brief Reads a range of a blob
+          * @return At most @p size bytes from @p offset, less at the end of the blob
+          * @throws fc::assert_exception if the blob is not stored
+          */
+         std::vector<char> read( const std::string& hash, uint64_t offset, uint32_t size )const;
+
+         /// Bytes held by the memory tier
+         uint64_t memory_used()const;
+
+      private:
+         typedef std::shared_ptr<const std::vector<char>> blob_ptr;
+         struct cache_entry
+         {
+            blob_ptr                         data;
+            std::list<std::string>::iterator lru_pos;
+         };
+
+         fc::path blob_path( const std::string& hash )const;
+         blob_ptr find_cached( const std::string& hash )const;
+         void     cache( const std::string& hash, blob_ptr data )const;
+
+         const fc::path   _dir;
+         const uint64_t   _memory_limit;
+
+         mutable std::mutex                                   _mutex;
+         /// Most recently used first
+         mutable std::list<std::string>                       _lru;
+         mutable std::unordered_map<std::string, cache_entry> _cache;
+         mutable uint64_t                                     _memory_used = 0;
+   };
+
+} } // graphene::content_cards
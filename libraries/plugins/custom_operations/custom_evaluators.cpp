@@ -41,52 +41,59 @@ vector<object_id_type> custom_generic_evaluator::do_apply(const account_storage_
    vector<object_id_type> results;
    results.reserve( op.key_values.size() );
 
-   if (op.remove)
+   // key_values is sorted like the keys within a catalog, so one pass over the catalog finds all rows
+   auto itr = index.lower_bound(make_tuple(_account, op.catalog));
+   auto in_catalog = [&]() {
+      return itr != index.end() && itr->account == _account && itr->catalog == op.catalog;
+   };
+
+   for(auto const& row: op.key_values)
    {
-      for(auto const& row: op.key_values) {
-         auto itr = index.find(make_tuple(_account, op.catalog, row.first));
-         if(itr != index.end()) {
+      while(in_catalog() && itr->key < row.first)
+         ++itr;
+      const bool found = in_catalog() && itr->key == row.first;
+
+      if (op.remove)
+      {
+         if(found) {
             results.push_back(itr->id);
-            _db->remove(*itr);
+            const auto& removed = *itr;
+            ++itr;
+            _db->remove(removed);
          }
+         continue;
       }
-   }
-   else {
-      for(auto const& row: op.key_values) {
-         if(row.first.length() > CUSTOM_OPERATIONS_MAX_KEY_SIZE)
-         {
-            wlog("Key can't be bigger than ${max} characters", ("max", CUSTOM_OPERATIONS_MAX_KEY_SIZE));
-            continue;
-         }
-         auto itr = index.find(make_tuple(_account, op.catalog, row.first));
-         if(itr == index.end())
-         {
-            try {
-               const auto& created = _db->create<account_storage_object>(
-                                        [&op, this, &row]( account_storage_object& aso ) {
-                  aso.account = _account;
-                  aso.catalog = op.catalog;
-                  aso.key = row.first;
-                  if(row.second.valid())
-                     aso.value = fc::json::from_string(*row.second);
-               });
-               results.push_back(created.id);
-            }
-            catch(const fc::parse_error_exception& e) { wlog(e.to_detail_string()); }
-         }
-         else
-         {
-            try {
-               _db->modify(*itr, [&row](account_storage_object &aso) {
-                  if(row.second.valid())
-                     aso.value = fc::json::from_string(*row.second);
-                  else
-                     aso.value.reset();
-               });
-               results.push_back(itr->id);
-            }
-            catch(const fc::parse_error_exception& e) { wlog((e.to_detail_string())); }
-         }
+
+      if(row.first.length() > CUSTOM_OPERATIONS_MAX_KEY_SIZE)
+      {
+         wlog("Key can't be bigger than ${max} characters", ("max", CUSTOM_OPERATIONS_MAX_KEY_SIZE));
+         continue;
+      }
+      optional<variant> value;
+      try {
+         if(row.second.valid())
+            value = fc::json::from_string(*row.second);
+      }
+      catch(const fc::parse_error_exception& e) { wlog((e.to_detail_string())); continue; }
+
+      if(!found)
+      {
+         // the new object is inserted before itr, which stays valid
+         const auto& created = _db->create<account_storage_object>(
+                                  [&op, this, &row, &value]( account_storage_object& aso ) {
+            aso.account = _account;
+            aso.catalog = op.catalog;
+            aso.key = row.first;
+            aso.value = std::move(value);
+         });
+         results.push_back(created.id);
+      }
+      else
+      {
+         _db->modify(*itr, [&value](account_storage_object &aso) {
+            aso.value = std::move(value);
+         });
+         results.push_back(itr->id);
       }
    }
    return results;
@@ -138,7 +138,7 @@ void custom_operations_plugin::plugin_initialize(const boost::program_options::v
       my->_start_block = options["custom-operations-start-block"].as<uint32_t>();
    }
 
-   database().applied_block.connect( [this]( const signed_block& b) {
+   database().connect_applied_block( "custom_operations", [this]( const signed_block& b) {
       if( b.block_num() >= my->_start_block )
          my->onBlock();
    } );
@@ -27,10 +27,13 @@
 #include <graphene/chain/database.hpp>
 #include <graphene/app/api.hpp>
 
+#include <fc/crypto/hex.hpp>
 #include <fc/network/http/websocket.hpp>
 #include <fc/rpc/websocket_api.hpp>
 #include <fc/api.hpp>
 
+#include <deque>
+
 namespace graphene { namespace delayed_node {
 namespace bpo = boost::program_options;
 
@@ -43,6 +46,18 @@ struct delayed_node_plugin_impl {
    boost::signals2::scoped_connection client_connection_closed;
    graphene::chain::block_id_type last_received_remote_head;
    graphene::chain::block_id_type last_processed_remote_head;
+   /// Set while the main loop waits for a new block of the trusted node
+   fc::promise<void>::ptr new_remote_head_promise;
+   /// Maximum number of blocks requested from the trusted node ahead of the one being pushed
+   uint32_t max_pending_block_requests = 16;
+   /// Whether to apply the state deltas of the trusted node instead of validating its blocks
+   bool apply_state_deltas = false;
+
+   void trigger_mainloop()
+   {
+      if( new_remote_head_promise )
+         new_remote_head_promise->set_value();
+   }
 };
 }
 
@@ -59,6 +74,12 @@ void delayed_node_plugin::plugin_set_program_options(bpo::options_description& c
    cli.add_options()
          ("trusted-node", boost::program_options::value<std::string>(),
           "RPC endpoint of a trusted validating node (required for delayed_node)")
+         ("trusted-node-max-pending-requests", boost::program_options::value<uint32_t>()->default_value(16),
+          "Maximum number of blocks to request from the trusted node at once while syncing")
+         ("trusted-node-state-deltas", boost::program_options::value<bool>()->default_value(false),
+          "Whether to apply the changes of the chain objects made by the blocks, as written by the trusted node "
+          "with state-delta-log enabled, instead of validating the blocks. The node must start with a copy of "
+          "the chain state of the trusted node at an irreversible block")
          ;
    cfg.add(cli);
 }
@@ -82,6 +103,7 @@ void delayed_node_plugin::connect()
    my->database_api->set_block_applied_callback([this]( const fc::variant& block_id )
    {
       fc::from_variant( block_id, my->last_received_remote_head, GRAPHENE_MAX_NESTED_OBJECTS );
+      my->trigger_mainloop();
    } );
    my->client_connection_closed = my->client_connection->closed.connect([this] {
       connection_failed();
@@ -93,6 +115,10 @@ void delayed_node_plugin::plugin_initialize(const boost::program_options::variab
    FC_ASSERT(options.count("trusted-node") > 0);
    my = std::make_unique<detail::delayed_node_plugin_impl>();
    my->remote_endpoint = "ws://" + options.at("trusted-node").as<std::string>();
+   if( options.count("trusted-node-max-pending-requests") > 0 )
+      my->max_pending_block_requests = std::max<uint32_t>( options.at("trusted-node-max-pending-requests").as<uint32_t>(), 1 );
+   if( options.count("trusted-node-state-deltas") > 0 )
+      my->apply_state_deltas = options.at("trusted-node-state-deltas").as<bool>();
 }
 
 void delayed_node_plugin::sync_with_trusted_node()
@@ -116,10 +142,29 @@ void delayed_node_plugin::sync_with_trusted_node()
          break;
       }
       pass_count++;
+      if( my->apply_state_deltas )
+      {
+         const uint32_t synced = sync_state_deltas( remote_dpo.last_irreversible_block_num );
+         if( synced == 0 )
+            break;
+         synced_blocks += synced;
+         continue;
+      }
+      // keep requests for the next blocks outstanding while pushing one, so that the round trips overlap
+      std::deque< fc::future< fc::optional<graphene::chain::signed_block> > > pending_blocks;
+      uint32_t next_block_num = db.head_block_num() + 1;
       while( remote_dpo.last_irreversible_block_num > db.head_block_num() )
       {
-         fc::optional<graphene::chain::signed_block> block = my->database_api->get_block( db.head_block_num()+1 );
-         // TODO: during sync, decouple requesting blocks from preprocessing + applying them
+         while( pending_blocks.size() < my->max_pending_block_requests
+                && next_block_num <= remote_dpo.last_irreversible_block_num )
+         {
+            const uint32_t block_num = next_block_num++;
+            pending_blocks.push_back( fc::async( [this,block_num]() {
+               return my->database_api->get_block( block_num );
+            }, "delayed_node get_block" ) );
+         }
+         fc::optional<graphene::chain::signed_block> block = pending_blocks.front().wait();
+         pending_blocks.pop_front();
          FC_ASSERT(block, "Trusted node claims it has blocks it doesn't actually have.");
          ilog("Pushing block #${n}", ("n", block->block_num()));
          db.precompute_parallel( *block, graphene::chain::database::skip_nothing ).wait();
@@ -129,19 +174,58 @@ void delayed_node_plugin::sync_with_trusted_node()
    }
 }
 
+uint32_t delayed_node_plugin::sync_state_deltas( uint32_t last_irreversible )
+{
+   auto& db = database();
+   uint32_t synced_blocks = 0;
+   while( last_irreversible > db.head_block_num() )
+   {
+      const uint32_t limit = std::min<uint32_t>( last_irreversible - db.head_block_num(), 100 );
+      const std::vector<std::string> deltas = my->database_api->get_packed_state_deltas( db.head_block_num() + 1, limit );
+      if( deltas.empty() )
+      {
+         wlog( "Trusted node has no state delta of block ${n}", ("n", db.head_block_num() + 1) );
+         break;
+      }
+      for( const std::string& hex : deltas )
+      {
+         std::vector<char> packed( hex.size() / 2 );
+         fc::from_hex( hex, packed.data(), packed.size() );
+         const auto delta = fc::raw::unpack<graphene::chain::state_delta>( packed );
+         ilog( "Applying the state delta of block #${n}", ("n", delta.block.block_num()) );
+         db.apply_state_delta( delta );
+         synced_blocks++;
+      }
+   }
+   return synced_blocks;
+}
+
 void delayed_node_plugin::mainloop()
 {
    while( true )
    {
       try
       {
-         fc::usleep( fc::microseconds( 296645 ) );  // wake up a little over 3Hz
-
          if( my->last_received_remote_head == my->last_processed_remote_head )
-            continue;
+         {
+            // sleep until the trusted node notifies a new block, wake up now and then in case a notification is lost
+            my->new_remote_head_promise = fc::promise<void>::create( "graphene::delayed_node::new_remote_head" );
+            try
+            {
+               my->new_remote_head_promise->wait( fc::seconds(5) );
+            }
+            catch( const fc::timeout_exception& )
+            {
+            }
+            my->new_remote_head_promise.reset();
+            if( my->last_received_remote_head == my->last_processed_remote_head )
+               continue;
+         }
 
+         // blocks notified while syncing are handled in the next round
+         const graphene::chain::block_id_type remote_head = my->last_received_remote_head;
          sync_with_trusted_node();
-         my->last_processed_remote_head = my->last_received_remote_head;
+         my->last_processed_remote_head = remote_head;
       }
       catch( const fc::exception& e )
       {
@@ -46,6 +46,8 @@ protected:
    void connection_failed();
    void connect();
    void sync_with_trusted_node();
+   /// Applies the state deltas of the trusted node up to @p last_irreversible, @return the number of blocks synced
+   uint32_t sync_state_deltas( uint32_t last_irreversible );
 };
 
 } } //graphene::account_history
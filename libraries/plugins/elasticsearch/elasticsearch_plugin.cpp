@@ -28,6 +28,16 @@
 #include <graphene/chain/hardfork.hpp>
 #include <curl/curl.h>
 
+#include <fc/io/json.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <map>
+#include <mutex>
+
 namespace graphene { namespace elasticsearch {
 
 namespace detail
@@ -66,48 +76,283 @@ class elasticsearch_plugin_impl
       mode _elasticsearch_mode = mode::only_save;
       CURL *curl; // curl handler
       vector <string> bulk_lines; //  vector of op lines
-      vector<std::string> prepare;
 
-      graphene::utilities::ES es;
       uint32_t limit_documents;
       int16_t op_type;
       operation_history_struct os;
       block_struct bs;
       visitor_struct vs;
-      bulk_struct bulk_line_struct;
       std::string bulk_line;
       std::string index_name;
+      /// Start of the bulk headers of the current block, up to the document id
+      std::string bulk_header_start;
+      /// The parts of the current operation's documents which are the same for all impacted accounts,
+      /// written once per operation, see bulk_struct for the layout
+      std::string operation_json;
+      std::string block_json;
       bool is_sync = false;
+
+      /// Bulks are sent off the main thread, each sender has its own connection
+      struct bulk_sender
+      {
+         std::shared_ptr<fc::thread> thread;
+         CURL*                       curl = nullptr;
+      };
+      struct pending_bulk
+      {
+         uint32_t          last_complete_block; ///< all documents of this and the earlier blocks are sent
+         std::future<void> done;
+      };
+      uint16_t _elasticsearch_connections = 4;
+      uint16_t _elasticsearch_max_pending_bulks = 8;
+      bool _elasticsearch_compress_bulks = false;
+      vector<bulk_sender> _senders;
+      size_t _next_sender = 0;
+      std::deque<pending_bulk> _pending_bulks;
+      std::atomic<bool> _stopping { false };
+      /// A bulk failed at shutdown, the checkpoint must not move past it
+      bool _bulk_lost = false;
+
+      fc::path _checkpoint_file;
+      /// The newest block of which all documents are indexed
+      uint32_t _checkpoint = 0;
+      /// Blocks up to this one were indexed before the node was restarted and are skipped until in sync
+      uint32_t _resume_after_block = 0;
+      uint32_t _current_block = 0;
+
+      void start_senders();
+      /// Hands bulk_lines over to a sender, waits if too many bulks are pending
+      void send_bulk( uint32_t last_complete_block );
+      /// Waits until at most @p max_pending bulks are pending and moves the checkpoint ahead
+      void wait_for_bulks( size_t max_pending );
+      void stop_senders();
+
+      /// Queries are run on their own threads, each with its own connection which is kept alive between queries
+      struct query_runner
+      {
+         std::shared_ptr<fc::thread> thread;
+         CURL*                       curl = nullptr;
+      };
+      struct cached_response
+      {
+         std::string    response;
+         fc::time_point expiration;
+      };
+      static constexpr size_t max_cached_responses = 1000;
+      uint16_t _elasticsearch_query_connections = 4;
+      uint32_t _elasticsearch_query_cache_seconds = 0;
+      vector<query_runner> _query_runners;
+      std::atomic<size_t> _next_query_runner { 0 };
+      std::mutex _query_cache_mutex;
+      /// Responses by query
+      std::map<std::string, cached_response> _query_cache;
+
+      void start_query_runners();
+      void stop_query_runners();
+      /// Sends a search query to the history indexes, @return the response or an empty string on failure
+      std::string run_query( const std::string& query );
    private:
-      bool add_elasticsearch( const account_id_type account_id, const optional<operation_history_object>& oho, const uint32_t block_number );
+      bool add_elasticsearch( const account_id_type account_id, const operation_history_object& oho, const uint32_t block_number );
       const account_transaction_history_object& addNewEntry(const account_statistics_object& stats_obj,
                                                             const account_id_type& account_id,
-                                                            const optional <operation_history_object>& oho);
+                                                            const operation_history_object& oho);
       const account_statistics_object& getStatsObject(const account_id_type& account_id);
       void growStats(const account_statistics_object& stats_obj, const account_transaction_history_object& ath);
-      void getOperationType(const optional <operation_history_object>& oho);
-      void doOperationHistory(const optional <operation_history_object>& oho);
+      void getOperationType(const operation_history_object& oho);
+      void doOperationHistory(const operation_history_object& oho);
       void doBlock(uint32_t trx_in_block, const signed_block& b);
-      void doVisitor(const optional <operation_history_object>& oho);
+      void doVisitor(const operation_history_object& oho);
       void checkState(const fc::time_point_sec& block_time);
       void cleanObjects(const account_transaction_history_id_type& ath, const account_id_type& account_id);
       void createBulkLine(const account_transaction_history_object& ath);
       void prepareBulk(const account_transaction_history_id_type& ath_id);
-      void populateESstruct();
 };
 
 elasticsearch_plugin_impl::~elasticsearch_plugin_impl()
 {
+   stop_senders();
+   stop_query_runners();
    if (curl) {
       curl_easy_cleanup(curl);
       curl = nullptr;
    }
 }
 
+void elasticsearch_plugin_impl::start_senders()
+{
+   for( uint16_t i = 0; i < _elasticsearch_connections; ++i )
+   {
+      bulk_sender sender;
+      sender.thread = std::make_shared<fc::thread>( "elasticsearch " + std::to_string( i ) );
+      sender.curl = curl_easy_init();
+      FC_ASSERT( sender.curl != nullptr, "Unable to initialize curl" );
+      curl_easy_setopt( sender.curl, CURLOPT_SSLVERSION, CURL_SSLVERSION_TLSv1_2 );
+      _senders.push_back( sender );
+   }
+}
+
+void elasticsearch_plugin_impl::send_bulk( uint32_t last_complete_block )
+{
+   wait_for_bulks( _elasticsearch_max_pending_bulks - 1 );
+
+   // documents are rewritten after a chain reorganization, which happens when in sync,
+   // so the order of those bulks is kept by sending them one after another
+   size_t sender_index = 0;
+   if( is_sync )
+      wait_for_bulks( 0 );
+   else
+   {
+      sender_index = _next_sender;
+      _next_sender = ( _next_sender + 1 ) % _senders.size();
+   }
+
+   auto done = std::make_shared<std::promise<void>>();
+   _pending_bulks.push_back( pending_bulk{ last_complete_block, done->get_future() } );
+
+   auto es = std::make_shared<graphene::utilities::ES>();
+   es->curl = _senders[sender_index].curl;
+   es->bulk_lines = std::move(bulk_lines);
+   es->elasticsearch_url = _elasticsearch_node_url;
+   es->auth = _elasticsearch_basic_auth;
+   es->index_prefix = _elasticsearch_index_prefix;
+   es->compress = _elasticsearch_compress_bulks;
+   bulk_lines.clear();
+
+   _senders[sender_index].thread->async( [this, es, done]() {
+      const fc::microseconds max_retry_delay = fc::seconds(60);
+      fc::microseconds retry_delay = fc::seconds(1);
+      // Note: although called with `std::move()`, `es` is not updated in `SendBulk()`
+      while( !graphene::utilities::SendBulk(std::move(*es)) )
+      {
+         elog( "Error sending ${n} lines of bulk data to Elastic Search, the first lines are:",
+               ("n",es->bulk_lines.size()) );
+         for( size_t i = 0; i < es->bulk_lines.size() && i < 10; ++i )
+         {
+            edump( (es->bulk_lines[i]) );
+         }
+         if( _stopping )
+         {
+            done->set_exception( std::make_exception_ptr( fc::exception() ) );
+            return;
+         }
+         wlog( "Retrying in ${s} seconds", ("s",retry_delay.to_seconds()) );
+         fc::usleep( retry_delay );
+         retry_delay = std::min( retry_delay + retry_delay, max_retry_delay );
+      }
+      done->set_value();
+   }, "elasticsearch bulk" );
+}
+
+void elasticsearch_plugin_impl::wait_for_bulks( size_t max_pending )
+{
+   const uint32_t old_checkpoint = _checkpoint;
+   while( _pending_bulks.size() > max_pending || ( !_pending_bulks.empty()
+            && _pending_bulks.front().done.wait_for( std::chrono::seconds(0) ) == std::future_status::ready ) )
+   {
+      // blocks this thread instead of yielding to other tasks, which could change the database
+      pending_bulk bulk = std::move( _pending_bulks.front() );
+      _pending_bulks.pop_front();
+      try {
+         bulk.done.get();
+         if( !_bulk_lost )
+            _checkpoint = std::max( _checkpoint, bulk.last_complete_block );
+      } catch( ... ) {
+         _bulk_lost = true;
+      }
+   }
+   if( _checkpoint != old_checkpoint && !_checkpoint_file.string().empty() )
+      fc::json::save_to_file( _checkpoint, _checkpoint_file );
+}
+
+void elasticsearch_plugin_impl::stop_senders()
+{
+   if( _senders.empty() )
+      return;
+   if( !bulk_lines.empty() )
+      send_bulk( _current_block );
+   // every pending bulk gets one more try
+   _stopping = true;
+   wait_for_bulks( 0 );
+   for( auto& sender : _senders )
+   {
+      sender.thread.reset();
+      curl_easy_cleanup( sender.curl );
+   }
+   _senders.clear();
+}
+
+void elasticsearch_plugin_impl::start_query_runners()
+{
+   for( uint16_t i = 0; i < _elasticsearch_query_connections; ++i )
+   {
+      query_runner runner;
+      runner.thread = std::make_shared<fc::thread>( "elasticsearch query " + std::to_string( i ) );
+      runner.curl = curl_easy_init();
+      FC_ASSERT( runner.curl != nullptr, "Unable to initialize curl" );
+      curl_easy_setopt( runner.curl, CURLOPT_SSLVERSION, CURL_SSLVERSION_TLSv1_2 );
+      _query_runners.push_back( runner );
+   }
+}
+
+void elasticsearch_plugin_impl::stop_query_runners()
+{
+   for( auto& runner : _query_runners )
+   {
+      runner.thread.reset();
+      curl_easy_cleanup( runner.curl );
+   }
+   _query_runners.clear();
+}
+
+std::string elasticsearch_plugin_impl::run_query( const std::string& query )
+{
+   FC_ASSERT( !_query_runners.empty(), "Elasticsearch queries are not enabled" );
+   if( _elasticsearch_query_cache_seconds > 0 )
+   {
+      std::lock_guard<std::mutex> lock( _query_cache_mutex );
+      auto itr = _query_cache.find( query );
+      if( itr != _query_cache.end() && itr->second.expiration > fc::time_point::now() )
+         return itr->second.response;
+   }
+
+   const query_runner& runner = _query_runners[ _next_query_runner++ % _query_runners.size() ];
+   std::string response = runner.thread->async( [this, &runner, &query]() {
+      graphene::utilities::ES es;
+      es.curl = runner.curl;
+      es.elasticsearch_url = _elasticsearch_node_url;
+      es.auth = _elasticsearch_basic_auth;
+      es.index_prefix = _elasticsearch_index_prefix;
+      es.endpoint = es.index_prefix + "*/data/_search";
+      es.query = query;
+      return graphene::utilities::simpleQuery( es );
+   }, "elasticsearch query" ).wait();
+
+   if( _elasticsearch_query_cache_seconds > 0 && !response.empty() )
+   {
+      const fc::time_point now = fc::time_point::now();
+      std::lock_guard<std::mutex> lock( _query_cache_mutex );
+      if( _query_cache.size() >= max_cached_responses )
+      {
+         for( auto itr = _query_cache.begin(); itr != _query_cache.end(); )
+         {
+            if( itr->second.expiration <= now )
+               itr = _query_cache.erase( itr );
+            else
+               ++itr;
+         }
+      }
+      if( _query_cache.size() < max_cached_responses )
+         _query_cache[query] = cached_response{ response, now + fc::seconds( _elasticsearch_query_cache_seconds ) };
+   }
+   return response;
+}
+
 bool elasticsearch_plugin_impl::update_account_histories( const signed_block& b )
 {
    checkState(b.timestamp);
+   _current_block = b.block_num();
    index_name = graphene::utilities::generateIndexName(b.timestamp, _elasticsearch_index_prefix);
+   bulk_header_start = "{\"index\":{\"_index\":" + fc::json::to_string(index_name) + ",\"_type\":\"data\",\"_id\":\"";
 
    graphene::chain::database& db = database();
    const vector<optional< operation_history_object > >& hist = db.get_applied_operations();
@@ -122,12 +367,9 @@ bool elasticsearch_plugin_impl::update_account_histories( const signed_block& b
          _oho_index->use_next_id();
    };
    for( const optional< operation_history_object >& o_op : hist ) {
-      optional <operation_history_object> oho;
-
-      auto create_oho = [&]() {
+      auto create_oho = [&]() -> const operation_history_object& {
          is_first = false;
-         return optional<operation_history_object>(
-               db.create<operation_history_object>([&](operation_history_object &h) {
+         return db.create<operation_history_object>([&](operation_history_object &h) {
                   if (o_op.valid())
                   {
                      h.op           = o_op->op;
@@ -137,21 +379,23 @@ bool elasticsearch_plugin_impl::update_account_histories( const signed_block& b
                      h.op_in_trx    = o_op->op_in_trx;
                      h.virtual_op   = o_op->virtual_op;
                   }
-               }));
+               });
       };
 
       if( !o_op.valid() ) {
          skip_oho_id();
          continue;
       }
-      oho = create_oho();
+      // refers to the object in the index rather than copying the operation again
+      const operation_history_object& oho = create_oho();
 
       // populate what we can before impacted loop
       getOperationType(oho);
       doOperationHistory(oho);
-      doBlock(oho->trx_in_block, b);
+      doBlock(oho.trx_in_block, b);
       if(_elasticsearch_visitor)
          doVisitor(oho);
+      operation_json.clear();
 
       const operation_history_object& op = *o_op;
 
@@ -193,24 +437,10 @@ bool elasticsearch_plugin_impl::update_account_histories( const signed_block& b
    // we send bulk at end of block when we are in sync for better real time client experience
    if(is_sync)
    {
-      populateESstruct();
-      if(es.bulk_lines.size() > 0)
-      {
-         prepare.clear();
-         if(!graphene::utilities::SendBulk(std::move(es)))
-         {
-            // Note: although called with `std::move()`, `es` is not updated in `SendBulk()`
-            elog( "Error sending ${n} lines of bulk data to Elastic Search, the first lines are:",
-                  ("n",es.bulk_lines.size()) );
-            for( size_t i = 0; i < es.bulk_lines.size() && i < 10; ++i )
-            {
-               edump( (es.bulk_lines[i]) );
-            }
-            return false;
-         }
-         else
-            bulk_lines.clear();
-      }
+      if(bulk_lines.size() > 0)
+         send_bulk( b.block_num() );
+      else
+         wait_for_bulks( _elasticsearch_max_pending_bulks );
    }
 
    if(bulk_lines.size() != limit_documents)
@@ -233,26 +463,26 @@ void elasticsearch_plugin_impl::checkState(const fc::time_point_sec& block_time)
    }
 }
 
-void elasticsearch_plugin_impl::getOperationType(const optional <operation_history_object>& oho)
+void elasticsearch_plugin_impl::getOperationType(const operation_history_object& oho)
 {
-   if (!oho->id.is_null())
-      op_type = oho->op.which();
+   if (!oho.id.is_null())
+      op_type = oho.op.which();
 }
 
-void elasticsearch_plugin_impl::doOperationHistory(const optional <operation_history_object>& oho)
+void elasticsearch_plugin_impl::doOperationHistory(const operation_history_object& oho)
 {
-   os.trx_in_block = oho->trx_in_block;
-   os.op_in_trx = oho->op_in_trx;
-   os.operation_result = fc::json::to_string(oho->result);
-   os.virtual_op = oho->virtual_op;
+   os.trx_in_block = oho.trx_in_block;
+   os.op_in_trx = oho.op_in_trx;
+   os.operation_result = fc::json::to_string(oho.result);
+   os.virtual_op = oho.virtual_op;
 
    if(_elasticsearch_operation_object) {
-      oho->op.visit(fc::from_static_variant(os.op_object, FC_PACK_MAX_DEPTH));
+      oho.op.visit(fc::from_static_variant(os.op_object, FC_PACK_MAX_DEPTH));
       adaptor_struct adaptor;
       os.op_object = adaptor.adapt(os.op_object.get_object());
    }
    if(_elasticsearch_operation_string)
-      os.op = fc::json::to_string(oho->op);
+      os.op = fc::json::to_string(oho.op);
 }
 
 void elasticsearch_plugin_impl::doBlock(uint32_t trx_in_block, const signed_block& b)
@@ -265,12 +495,12 @@ void elasticsearch_plugin_impl::doBlock(uint32_t trx_in_block, const signed_bloc
    bs.trx_id = trx_id;
 }
 
-void elasticsearch_plugin_impl::doVisitor(const optional <operation_history_object>& oho)
+void elasticsearch_plugin_impl::doVisitor(const operation_history_object& oho)
 {
    graphene::chain::database& db = database();
 
    operation_visitor o_v;
-   oho->op.visit(o_v);
+   oho.op.visit(o_v);
 
    auto fee_asset = o_v.fee_asset(db);
    vs.fee_data.asset = o_v.fee_asset;
@@ -307,34 +537,21 @@ void elasticsearch_plugin_impl::doVisitor(const optional <operation_history_obje
 }
 
 bool elasticsearch_plugin_impl::add_elasticsearch( const account_id_type account_id,
-                                                   const optional <operation_history_object>& oho,
+                                                   const operation_history_object& oho,
                                                    const uint32_t block_number)
 {
    const auto &stats_obj = getStatsObject(account_id);
    const auto &ath = addNewEntry(stats_obj, account_id, oho);
    growStats(stats_obj, ath);
-   if(block_number > _elasticsearch_start_es_after_block)  {
+   if(block_number > _elasticsearch_start_es_after_block && (is_sync || block_number > _resume_after_block))  {
       createBulkLine(ath);
       prepareBulk(ath.id);
    }
    cleanObjects(ath.id, account_id);
 
    if (curl && bulk_lines.size() >= limit_documents) { // we are in bulk time, ready to add data to elasticsearech
-      prepare.clear();
-      populateESstruct();
-      if(!graphene::utilities::SendBulk(std::move(es)))
-      {
-         // Note: although called with `std::move()`, `es` is not updated in `SendBulk()`
-         elog( "Error sending ${n} lines of bulk data to Elastic Search, the first lines are:",
-               ("n",es.bulk_lines.size()) );
-         for( size_t i = 0; i < es.bulk_lines.size() && i < 10; ++i )
-         {
-            edump( (es.bulk_lines[i]) );
-         }
-         return false;
-      }
-      else
-         bulk_lines.clear();
+      // the documents of the current block are not all in this bulk
+      send_bulk( block_number - 1 );
    }
 
    return true;
@@ -350,11 +567,11 @@ const account_statistics_object& elasticsearch_plugin_impl::getStatsObject(const
 
 const account_transaction_history_object& elasticsearch_plugin_impl::addNewEntry(const account_statistics_object& stats_obj,
                                                                                  const account_id_type& account_id,
-                                                                                 const optional <operation_history_object>& oho)
+                                                                                 const operation_history_object& oho)
 {
    graphene::chain::database& db = database();
    const auto &ath = db.create<account_transaction_history_object>([&](account_transaction_history_object &obj) {
-      obj.operation_id = oho->id;
+      obj.operation_id = oho.id;
       obj.account = account_id;
       obj.sequence = stats_obj.total_ops + 1;
       obj.next = stats_obj.most_recent_op;
@@ -375,27 +592,34 @@ void elasticsearch_plugin_impl::growStats(const account_statistics_object& stats
 
 void elasticsearch_plugin_impl::createBulkLine(const account_transaction_history_object& ath)
 {
-   bulk_line_struct.account_history = ath;
-   bulk_line_struct.operation_history = os;
-   bulk_line_struct.operation_type = op_type;
-   bulk_line_struct.operation_id_num = ath.operation_id.instance.value;
-   bulk_line_struct.block_data = bs;
-   if(_elasticsearch_visitor)
-      bulk_line_struct.additional_data = vs;
-   bulk_line = fc::json::to_string(bulk_line_struct, fc::json::legacy_generator);
+   // the same as serializing a bulk_struct, but the operation is only converted once
+   if(operation_json.empty())
+   {
+      operation_json = ",\"operation_history\":" + fc::json::to_string(os, fc::json::legacy_generator)
+                     + ",\"operation_type\":" + std::to_string(op_type);
+      block_json = ",\"block_data\":" + fc::json::to_string(bs, fc::json::legacy_generator);
+      if(_elasticsearch_visitor)
+         block_json += ",\"additional_data\":" + fc::json::to_string(vs, fc::json::legacy_generator);
+      block_json += "}";
+   }
+   const std::string account_history = fc::json::to_string(ath, fc::json::legacy_generator);
+   const std::string operation_id_num = std::to_string(ath.operation_id.instance.value);
+   bulk_line.clear();
+   bulk_line.reserve(account_history.size() + operation_json.size() + operation_id_num.size()
+                     + block_json.size() + 40);
+   bulk_line += "{\"account_history\":";
+   bulk_line += account_history;
+   bulk_line += operation_json;
+   bulk_line += ",\"operation_id_num\":";
+   bulk_line += operation_id_num;
+   bulk_line += block_json;
 }
 
 void elasticsearch_plugin_impl::prepareBulk(const account_transaction_history_id_type& ath_id)
 {
-   const std::string _id = fc::json::to_string(ath_id);
-   fc::mutable_variant_object bulk_header;
-   bulk_header["_index"] = index_name;
-   bulk_header["_type"] = "data";
-   bulk_header["_id"] = fc::to_string(ath_id.space_id) + "." + fc::to_string(ath_id.type_id) + "."
-                      + fc::to_string(ath_id.instance.value);
-   prepare = graphene::utilities::createBulk(bulk_header, std::move(bulk_line));
-   std::move(prepare.begin(), prepare.end(), std::back_inserter(bulk_lines));
-   prepare.clear();
+   bulk_lines.push_back(bulk_header_start + fc::to_string(ath_id.space_id) + "." + fc::to_string(ath_id.type_id)
+                        + "." + fc::to_string(ath_id.instance.value) + "\"}}");
+   bulk_lines.push_back(std::move(bulk_line));
 }
 
 void elasticsearch_plugin_impl::cleanObjects(const account_transaction_history_id_type& ath_id, const account_id_type& account_id)
@@ -427,17 +651,6 @@ void elasticsearch_plugin_impl::cleanObjects(const account_transaction_history_i
    }
 }
 
-void elasticsearch_plugin_impl::populateESstruct()
-{
-   es.curl = curl;
-   es.bulk_lines = std::move(bulk_lines);
-   es.elasticsearch_url = _elasticsearch_node_url;
-   es.auth = _elasticsearch_basic_auth;
-   es.index_prefix = _elasticsearch_index_prefix;
-   es.endpoint = "";
-   es.query = "";
-}
-
 } // end namespace detail
 
 elasticsearch_plugin::elasticsearch_plugin(graphene::app::application& app) :
@@ -484,6 +697,17 @@ void elasticsearch_plugin::plugin_set_program_options(
                "Save operation as string. Needed to serve history api calls(false)")
          ("elasticsearch-mode", boost::program_options::value<uint16_t>(),
                "Mode of operation: only_save(0), only_query(1), all(2) - Default: 0")
+         ("elasticsearch-connections", boost::program_options::value<uint16_t>(),
+               "Number of connections bulks are sent through in parallel while not in sync(4)")
+         ("elasticsearch-max-pending-bulks", boost::program_options::value<uint16_t>(),
+               "Number of bulks which may wait to be indexed before block processing waits for them(8)")
+         ("elasticsearch-compress-bulks", boost::program_options::value<bool>(),
+               "Send bulks gzip compressed, needs a build with zlib(false)")
+         ("elasticsearch-query-connections", boost::program_options::value<uint16_t>(),
+               "Number of connections history api queries are sent through in parallel(4)")
+         ("elasticsearch-query-cache-seconds", boost::program_options::value<uint32_t>(),
+               "Number of seconds responses to history api queries are reused for identical queries, "
+               "0 to disable(0)")
          ;
    cfg.add(cli);
 }
@@ -526,13 +750,48 @@ void elasticsearch_plugin::plugin_initialize(const boost::program_options::varia
          FC_THROW_EXCEPTION(graphene::chain::plugin_exception, "Elasticsearch mode not valid");
       my->_elasticsearch_mode = static_cast<mode>(options["elasticsearch-mode"].as<uint16_t>());
    }
+   if (options.count("elasticsearch-connections") > 0) {
+      my->_elasticsearch_connections = options["elasticsearch-connections"].as<uint16_t>();
+      FC_ASSERT( my->_elasticsearch_connections > 0, "elasticsearch-connections must be positive" );
+   }
+   if (options.count("elasticsearch-max-pending-bulks") > 0) {
+      my->_elasticsearch_max_pending_bulks = options["elasticsearch-max-pending-bulks"].as<uint16_t>();
+      FC_ASSERT( my->_elasticsearch_max_pending_bulks > 0, "elasticsearch-max-pending-bulks must be positive" );
+   }
+   if (options.count("elasticsearch-compress-bulks") > 0) {
+      my->_elasticsearch_compress_bulks = options["elasticsearch-compress-bulks"].as<bool>();
+      if( my->_elasticsearch_compress_bulks && !graphene::utilities::isCompressionSupported() )
+         wlog( "elasticsearch-compress-bulks is not supported by this build, bulks are sent uncompressed" );
+   }
+   if (options.count("elasticsearch-query-connections") > 0) {
+      my->_elasticsearch_query_connections = options["elasticsearch-query-connections"].as<uint16_t>();
+      FC_ASSERT( my->_elasticsearch_query_connections > 0, "elasticsearch-query-connections must be positive" );
+   }
+   if (options.count("elasticsearch-query-cache-seconds") > 0) {
+      my->_elasticsearch_query_cache_seconds = options["elasticsearch-query-cache-seconds"].as<uint32_t>();
+   }
+   if(my->_elasticsearch_mode != mode::only_save)
+      my->start_query_runners();
 
    if(my->_elasticsearch_mode != mode::only_query) {
       if (my->_elasticsearch_mode == mode::all && !my->_elasticsearch_operation_string)
          FC_THROW_EXCEPTION(graphene::chain::plugin_exception,
                "If elasticsearch-mode is set to all then elasticsearch-operation-string need to be true");
 
-      database().applied_block.connect([this](const signed_block &b) {
+      // the documents of the blocks up to the checkpoint are not created again on replay
+      const fc::path checkpoint_dir = app().data_dir() / "elasticsearch";
+      fc::create_directories( checkpoint_dir );
+      my->_checkpoint_file = checkpoint_dir / ( my->_elasticsearch_index_prefix + "checkpoint.json" );
+      if( fc::exists( my->_checkpoint_file ) )
+      {
+         my->_checkpoint = fc::json::from_file( my->_checkpoint_file ).as<uint32_t>( 1 );
+         my->_resume_after_block = my->_checkpoint;
+         ilog( "Documents of the blocks up to ${b} are indexed already, delete ${f} to index them again",
+               ("b",my->_checkpoint)("f",my->_checkpoint_file) );
+      }
+      my->start_senders();
+
+      database().connect_applied_block( "elasticsearch", [this](const signed_block &b) {
          if (!my->update_account_histories(b))
             FC_THROW_EXCEPTION(graphene::chain::plugin_exception,
                   "Error populating ES database, we are going to keep trying.");
@@ -552,6 +811,12 @@ void elasticsearch_plugin::plugin_startup()
    ilog("elasticsearch ACCOUNT HISTORY: plugin_startup() begin");
 }
 
+void elasticsearch_plugin::plugin_shutdown()
+{
+   my->stop_senders();
+   my->stop_query_runners();
+}
+
 operation_history_object elasticsearch_plugin::get_operation_by_id(operation_history_id_type id)
 {
    const string operation_id_string = std::string(object_id_type(id));
@@ -567,8 +832,7 @@ operation_history_object elasticsearch_plugin::get_operation_by_id(operation_his
    }
    )";
 
-   auto es = prepareHistoryQuery(query);
-   const auto response = graphene::utilities::simpleQuery(es);
+   const auto response = my->run_query(query);
    variant variant_response = fc::json::from_string(response);
    const auto source = variant_response["hits"]["hits"][size_t(0)]["_source"];
    return fromEStoOperation(source);
@@ -609,14 +873,12 @@ vector<operation_history_object> elasticsearch_plugin::get_account_history(
    }
    )";
 
-   auto es = prepareHistoryQuery(query);
-
    vector<operation_history_object> result;
 
-   if(!graphene::utilities::checkES(es))
+   const auto response = my->run_query(query);
+   if(response.empty())
       return result;
 
-   const auto response = graphene::utilities::simpleQuery(es);
    variant variant_response = fc::json::from_string(response);
    
    const auto hits = variant_response["hits"]["total"];
@@ -656,22 +918,6 @@ operation_history_object elasticsearch_plugin::fromEStoOperation(variant source)
    return result;
 }
 
-graphene::utilities::ES elasticsearch_plugin::prepareHistoryQuery(string query)
-{
-   CURL *curl;
-   curl = curl_easy_init();
-   curl_easy_setopt(curl, CURLOPT_SSLVERSION, CURL_SSLVERSION_TLSv1_2);
-
-   graphene::utilities::ES es;
-   es.curl = curl;
-   es.elasticsearch_url = my->_elasticsearch_node_url;
-   es.index_prefix = my->_elasticsearch_index_prefix;
-   es.endpoint = es.index_prefix + "*/data/_search";
-   es.query = query;
-
-   return es;
-}
-
 mode elasticsearch_plugin::get_running_mode()
 {
    return my->_elasticsearch_mode;
@@ -65,6 +65,7 @@ class elasticsearch_plugin : public graphene::app::plugin
          boost::program_options::options_description& cfg) override;
       void plugin_initialize(const boost::program_options::variables_map& options) override;
       void plugin_startup() override;
+      void plugin_shutdown() override;
 
       operation_history_object get_operation_by_id(operation_history_id_type id);
       vector<operation_history_object> get_account_history(const account_id_type account_id,
@@ -76,7 +77,6 @@ class elasticsearch_plugin : public graphene::app::plugin
 
    private:
       operation_history_object fromEStoOperation(variant source);
-      graphene::utilities::ES prepareHistoryQuery(string query);
 };
 
 
@@ -188,6 +188,7 @@ struct visitor_struct {
    fill_struct fill_data;
 };
 
+/// The layout of the indexed documents
 struct bulk_struct {
    account_transaction_history_object account_history;
    operation_history_struct operation_history;
@@ -31,8 +31,12 @@
 #include <graphene/chain/asset_object.hpp>
 #include <graphene/chain/account_object.hpp>
 
+#include <graphene/db/task_pool.hpp>
 #include <graphene/utilities/elasticsearch.hpp>
 
+#include <atomic>
+#include <fstream>
+
 namespace graphene { namespace es_objects {
 
 namespace detail
@@ -51,6 +55,8 @@ class es_objects_plugin_impl
 
       bool index_database(const vector<object_id_type>& ids, std::string action);
       bool genesis();
+      /// Sends all tracked objects of the current state, see es-objects-backfill
+      void backfill();
       void remove_from_database(object_id_type id, std::string index);
 
       es_objects_plugin& _self;
@@ -71,13 +77,28 @@ class es_objects_plugin_impl
       vector<std::string> prepare;
 
       bool _es_objects_keep_only_current = true;
+      bool _es_objects_compress_bulks = false;
+      bool _es_objects_backfill = false;
+
+      /// Set if changes are appended to a file instead of being sent to Elasticsearch
+      fc::path _es_objects_cdc_file;
+      std::ofstream _cdc_stream;
 
       uint32_t block_number;
       fc::time_point_sec block_time;
 
    private:
       template<typename T>
-      void prepareTemplate(T blockchain_object, string index_name);
+      void prepareTemplate(const T& blockchain_object, const string& index_name, const string& action);
+      /// @return the bulk lines which store @p blockchain_object, only reads the plugin settings
+      template<typename T>
+      vector<string> makeBulkLines(const T& blockchain_object, const string& index_name)const;
+      /// Queues the sending of the objects of type T in bulks on the thread pool
+      template<typename T>
+      void backfillIndex(bool enabled, const string& index_name, vector<fc::future<bool>>& tasks,
+                         std::atomic<uint64_t>& count);
+      void writeChange(const string& action, const string& index_name, object_id_type id,
+                       const fc::variant* blockchain_object);
 };
 
 bool es_objects_plugin_impl::genesis()
@@ -94,7 +115,7 @@ bool es_objects_plugin_impl::genesis()
       index_accounts.inspect_all_objects([this, &db](const graphene::db::object &o) {
          auto obj = db.find_object(o.id);
          auto a = static_cast<const account_object *>(obj);
-         prepareTemplate<account_object>(*a, "account");
+         prepareTemplate<account_object>(*a, "account", "create");
       });
    }
    if (_es_objects_assets) {
@@ -102,7 +123,7 @@ bool es_objects_plugin_impl::genesis()
       index_assets.inspect_all_objects([this, &db](const graphene::db::object &o) {
          auto obj = db.find_object(o.id);
          auto a = static_cast<const asset_object *>(obj);
-         prepareTemplate<asset_object>(*a, "asset");
+         prepareTemplate<asset_object>(*a, "asset", "create");
       });
    }
    if (_es_objects_balances) {
@@ -110,15 +131,21 @@ bool es_objects_plugin_impl::genesis()
       index_balances.inspect_all_objects([this, &db](const graphene::db::object &o) {
          auto obj = db.find_object(o.id);
          auto b = static_cast<const account_balance_object *>(obj);
-         prepareTemplate<account_balance_object>(*b, "balance");
+         prepareTemplate<account_balance_object>(*b, "balance", "create");
       });
    }
 
+   if (_cdc_stream.is_open()) {
+      _cdc_stream.flush();
+      return true;
+   }
+
    graphene::utilities::ES es;
    es.curl = curl;
    es.bulk_lines = bulk;
    es.elasticsearch_url = _es_objects_elasticsearch_url;
    es.auth = _es_objects_auth;
+   es.compress = _es_objects_compress_bulks;
    if (!graphene::utilities::SendBulk(std::move(es)))
       FC_THROW_EXCEPTION(graphene::chain::plugin_exception, "Error inserting genesis data.");
    else
@@ -127,6 +154,92 @@ bool es_objects_plugin_impl::genesis()
    return true;
 }
 
+void es_objects_plugin_impl::backfill()
+{
+   graphene::chain::database &db = _self.database();
+
+   block_number = db.head_block_num();
+   block_time = db.head_block_time();
+   ilog("elasticsearch OBJECTS: backfilling the objects of block ${n}", ("n", block_number));
+   const fc::time_point start = fc::time_point::now();
+
+   // The chain does not change while the plugins are started, so the bulks are built from the indexes and sent
+   // concurrently. The changes of the following blocks are sent as usual.
+   vector<fc::future<bool>> tasks;
+   std::atomic<uint64_t> count(0);
+   backfillIndex<account_object>(_es_objects_accounts, "account", tasks, count);
+   backfillIndex<asset_object>(_es_objects_assets, "asset", tasks, count);
+   backfillIndex<account_balance_object>(_es_objects_balances, "balance", tasks, count);
+   backfillIndex<limit_order_object>(_es_objects_limit_orders, "limitorder", tasks, count);
+   backfillIndex<proposal_object>(_es_objects_proposals, "proposal", tasks, count);
+   backfillIndex<asset_bitasset_data_object>(_es_objects_asset_bitasset, "bitasset", tasks, count);
+
+   uint32_t failed = 0;
+   for (auto& task : tasks) {
+      if (!task.wait())
+         ++failed;
+   }
+   if (_cdc_stream.is_open()) {
+      _cdc_stream.flush();
+      FC_ASSERT( _cdc_stream, "Unable to write ${f}", ("f", _es_objects_cdc_file) );
+   }
+   if (failed > 0)
+      FC_THROW_EXCEPTION(graphene::chain::plugin_exception, "Error backfilling ${f} of ${t} bulks",
+                         ("f", failed)("t", tasks.size()));
+   ilog("elasticsearch OBJECTS: backfilled ${c} objects in ${t} ms",
+        ("c", count.load())("t", (fc::time_point::now() - start).count() / 1000));
+}
+
+template<typename T>
+void es_objects_plugin_impl::backfillIndex(bool enabled, const string& index_name, vector<fc::future<bool>>& tasks,
+                                           std::atomic<uint64_t>& count)
+{
+   if (!enabled)
+      return;
+   vector<const T*> batch;
+   auto flush_batch = [this, &batch, &index_name, &tasks, &count]() {
+      count += batch.size();
+      if (_cdc_stream.is_open()) {
+         // a single file, written in order
+         for (const T* obj : batch)
+            prepareTemplate<T>(*obj, index_name, "create");
+         batch.clear();
+         return;
+      }
+      tasks.push_back(graphene::db::task_pool::instance().run([this, objects = std::move(batch), index_name]() {
+         vector<string> lines;
+         for (const T* obj : objects) {
+            vector<string> object_lines = makeBulkLines<T>(*obj, index_name);
+            std::move(object_lines.begin(), object_lines.end(), std::back_inserter(lines));
+         }
+         // curl handles must not be shared between threads
+         CURL* handle = curl_easy_init();
+         if (!handle)
+            return false;
+         curl_easy_setopt(handle, CURLOPT_SSLVERSION, CURL_SSLVERSION_TLSv1_2);
+         graphene::utilities::ES es;
+         es.curl = handle;
+         es.bulk_lines = std::move(lines);
+         es.elasticsearch_url = _es_objects_elasticsearch_url;
+         es.auth = _es_objects_auth;
+         es.compress = _es_objects_compress_bulks;
+         const bool sent = graphene::utilities::SendBulk(std::move(es));
+         curl_easy_cleanup(handle);
+         return sent;
+      }, graphene::db::task_priority::low));
+      batch = vector<const T*>();
+   };
+   const uint32_t batch_size = std::max<uint32_t>(_es_objects_bulk_replay, 1);
+   _self.database().get_index(T::space_id, T::type_id).inspect_all_objects(
+         [&batch, &flush_batch, batch_size](const graphene::db::object &o) {
+      batch.push_back(static_cast<const T*>(&o));
+      if (batch.size() >= batch_size)
+         flush_batch();
+   });
+   if (!batch.empty())
+      flush_batch();
+}
+
 bool es_objects_plugin_impl::index_database(const vector<object_id_type>& ids, std::string action)
 {
    graphene::chain::database &db = _self.database();
@@ -152,7 +265,7 @@ bool es_objects_plugin_impl::index_database(const vector<object_id_type>& ids, s
                if (action == "delete")
                   remove_from_database(p->id, "proposal");
                else
-                  prepareTemplate<proposal_object>(*p, "proposal");
+                  prepareTemplate<proposal_object>(*p, "proposal", action);
             }
          } else if (value.is<account_object>() && _es_objects_accounts) {
             auto obj = db.find_object(value);
@@ -161,7 +274,7 @@ bool es_objects_plugin_impl::index_database(const vector<object_id_type>& ids, s
                if (action == "delete")
                   remove_from_database(a->id, "account");
                else
-                  prepareTemplate<account_object>(*a, "account");
+                  prepareTemplate<account_object>(*a, "account", action);
             }
          } else if (value.is<asset_object>() && _es_objects_assets) {
             auto obj = db.find_object(value);
@@ -170,7 +283,7 @@ bool es_objects_plugin_impl::index_database(const vector<object_id_type>& ids, s
                if (action == "delete")
                   remove_from_database(a->id, "asset");
                else
-                  prepareTemplate<asset_object>(*a, "asset");
+                  prepareTemplate<asset_object>(*a, "asset", action);
             }
          } else if (value.is<account_balance_object>() && _es_objects_balances) {
             auto obj = db.find_object(value);
@@ -179,7 +292,7 @@ bool es_objects_plugin_impl::index_database(const vector<object_id_type>& ids, s
                if (action == "delete")
                   remove_from_database(b->id, "balance");
                else
-                  prepareTemplate<account_balance_object>(*b, "balance");
+                  prepareTemplate<account_balance_object>(*b, "balance", action);
             }
          } else if (value.is<limit_order_object>() && _es_objects_limit_orders) {
             auto obj = db.find_object(value);
@@ -188,7 +301,7 @@ bool es_objects_plugin_impl::index_database(const vector<object_id_type>& ids, s
                if (action == "delete")
                   remove_from_database(l->id, "limitorder");
                else
-                  prepareTemplate<limit_order_object>(*l, "limitorder");
+                  prepareTemplate<limit_order_object>(*l, "limitorder", action);
             }
          } else if (value.is<asset_bitasset_data_object>() && _es_objects_asset_bitasset) {
             auto obj = db.find_object(value);
@@ -197,18 +310,23 @@ bool es_objects_plugin_impl::index_database(const vector<object_id_type>& ids, s
                if (action == "delete")
                   remove_from_database(ba->id, "bitasset");
                else
-                  prepareTemplate<asset_bitasset_data_object>(*ba, "bitasset");
+                  prepareTemplate<asset_bitasset_data_object>(*ba, "bitasset", action);
             }
          }
       }
 
-      if (curl && bulk.size() >= limit_documents) { // we are in bulk time, ready to add data to elasticsearech
+      if (_cdc_stream.is_open()) {
+         _cdc_stream.flush();
+         FC_ASSERT( _cdc_stream, "Unable to write ${f}", ("f", _es_objects_cdc_file) );
+      }
+      else if (curl && bulk.size() >= limit_documents) { // we are in bulk time, ready to add data to elasticsearech
 
          graphene::utilities::ES es;
          es.curl = curl;
          es.bulk_lines = bulk;
          es.elasticsearch_url = _es_objects_elasticsearch_url;
          es.auth = _es_objects_auth;
+         es.compress = _es_objects_compress_bulks;
 
          if (!graphene::utilities::SendBulk(std::move(es)))
             return false;
@@ -222,7 +340,9 @@ bool es_objects_plugin_impl::index_database(const vector<object_id_type>& ids, s
 
 void es_objects_plugin_impl::remove_from_database( object_id_type id, std::string index)
 {
-   if(_es_objects_keep_only_current)
+   if(_cdc_stream.is_open())
+      writeChange("delete", index, id, nullptr);
+   else if(_es_objects_keep_only_current)
    {
       fc::mutable_variant_object delete_line;
       delete_line["_id"] = string(id);
@@ -236,8 +356,40 @@ void es_objects_plugin_impl::remove_from_database( object_id_type id, std::strin
    }
 }
 
+void es_objects_plugin_impl::writeChange(const string& action, const string& index_name, object_id_type id,
+                                         const fc::variant* blockchain_object)
+{
+   // one line per change, without the renaming Elasticsearch needs
+   fc::mutable_variant_object change;
+   change["block_number"] = block_number;
+   change["block_time"] = block_time;
+   change["action"] = action;
+   change["index"] = index_name;
+   change["id"] = string(id);
+   if(blockchain_object != nullptr)
+      change["object"] = *blockchain_object;
+   _cdc_stream << fc::json::to_string(change, fc::json::legacy_generator) << '\n';
+}
+
+template<typename T>
+void es_objects_plugin_impl::prepareTemplate(const T& blockchain_object, const string& index_name,
+                                             const string& action)
+{
+   if(_cdc_stream.is_open())
+   {
+      fc::variant blockchain_object_variant;
+      fc::to_variant( blockchain_object, blockchain_object_variant, GRAPHENE_NET_MAX_NESTED_OBJECTS );
+      writeChange(action, index_name, blockchain_object.id, &blockchain_object_variant);
+      return;
+   }
+
+   prepare = makeBulkLines(blockchain_object, index_name);
+   std::move(prepare.begin(), prepare.end(), std::back_inserter(bulk));
+   prepare.clear();
+}
+
 template<typename T>
-void es_objects_plugin_impl::prepareTemplate(T blockchain_object, string index_name)
+vector<string> es_objects_plugin_impl::makeBulkLines(const T& blockchain_object, const string& index_name)const
 {
    fc::mutable_variant_object bulk_header;
    bulk_header["_index"] = _es_objects_index_prefix + index_name;
@@ -258,9 +410,7 @@ void es_objects_plugin_impl::prepareTemplate(T blockchain_object, string index_n
 
    string data = fc::json::to_string(o, fc::json::legacy_generator);
 
-   prepare = graphene::utilities::createBulk(bulk_header, std::move(data));
-   std::move(prepare.begin(), prepare.end(), std::back_inserter(bulk));
-   prepare.clear();
+   return graphene::utilities::createBulk(bulk_header, std::move(data));
 }
 
 es_objects_plugin_impl::~es_objects_plugin_impl()
@@ -316,6 +466,15 @@ void es_objects_plugin::plugin_set_program_options(
                "Keep only current state of the objects(true)")
          ("es-objects-start-es-after-block", boost::program_options::value<uint32_t>(),
                "Start doing ES job after block(0)")
+         ("es-objects-compress-bulks", boost::program_options::value<bool>(),
+               "Send bulks gzip compressed, needs a build with zlib(false)")
+         ("es-objects-cdc-file", boost::program_options::value<std::string>(),
+               "Append the changed objects to this file, one JSON line per change, instead of sending them "
+               "to Elasticsearch, relative to the data directory if not absolute('')")
+         ("es-objects-backfill", boost::program_options::value<bool>(),
+               "Send all tracked objects of the current state at startup, in bulks of es-objects-bulk-replay "
+               "objects sent in parallel, then continue with the changes of new blocks. Allows to enable the "
+               "plugin on a node without a replay(false)")
          ;
    cfg.add(cli);
 }
@@ -361,15 +520,32 @@ void es_objects_plugin::plugin_initialize(const boost::program_options::variable
    if (options.count("es-objects-start-es-after-block") > 0) {
       my->_es_objects_start_es_after_block = options["es-objects-start-es-after-block"].as<uint32_t>();
    }
+   if (options.count("es-objects-compress-bulks") > 0) {
+      my->_es_objects_compress_bulks = options["es-objects-compress-bulks"].as<bool>();
+      if( my->_es_objects_compress_bulks && !graphene::utilities::isCompressionSupported() )
+         wlog( "es-objects-compress-bulks is not supported by this build, bulks are sent uncompressed" );
+   }
+   if (options.count("es-objects-cdc-file") > 0) {
+      my->_es_objects_cdc_file = options["es-objects-cdc-file"].as<std::string>();
+      if (my->_es_objects_cdc_file.is_relative())
+         my->_es_objects_cdc_file = app().data_dir() / my->_es_objects_cdc_file;
+      fc::create_directories(my->_es_objects_cdc_file.parent_path());
+      my->_cdc_stream.open(my->_es_objects_cdc_file.generic_string().c_str(), std::ios::out | std::ios::app);
+      FC_ASSERT(my->_cdc_stream, "Unable to open ${f}", ("f", my->_es_objects_cdc_file));
+   }
+
+   if (options.count("es-objects-backfill") > 0) {
+      my->_es_objects_backfill = options["es-objects-backfill"].as<bool>();
+   }
 
-   database().applied_block.connect([this](const signed_block &b) {
+   database().connect_applied_block( "es_objects", [this](const signed_block &b) {
       if(b.block_num() == 1 && my->_es_objects_start_es_after_block == 0) {
          if (!my->genesis())
             FC_THROW_EXCEPTION(graphene::chain::plugin_exception, "Error populating genesis data.");
       }
    });
    database().new_objects.connect([this]( const vector<object_id_type>& ids,
-         const flat_set<account_id_type>& impacted_accounts ) {
+         const impacted_accounts_provider& ) {
       if(!my->index_database(ids, "create"))
       {
          FC_THROW_EXCEPTION(graphene::chain::plugin_exception,
@@ -377,7 +553,7 @@ void es_objects_plugin::plugin_initialize(const boost::program_options::variable
       }
    });
    database().changed_objects.connect([this]( const vector<object_id_type>& ids,
-         const flat_set<account_id_type>& impacted_accounts ) {
+         const impacted_accounts_provider& ) {
       if(!my->index_database(ids, "update"))
       {
          FC_THROW_EXCEPTION(graphene::chain::plugin_exception,
@@ -385,7 +561,7 @@ void es_objects_plugin::plugin_initialize(const boost::program_options::variable
       }
    });
    database().removed_objects.connect([this](const vector<object_id_type>& ids,
-         const vector<const object*>& objs, const flat_set<account_id_type>& impacted_accounts) {
+         const vector<const object*>& objs, const impacted_accounts_provider& ) {
       if(!my->index_database(ids, "delete"))
       {
          FC_THROW_EXCEPTION(graphene::chain::plugin_exception,
@@ -396,6 +572,13 @@ void es_objects_plugin::plugin_initialize(const boost::program_options::variable
 
 void es_objects_plugin::plugin_startup()
 {
+   if (my->_cdc_stream.is_open()) {
+      ilog("elasticsearch OBJECTS: writing changes to ${f}", ("f", my->_es_objects_cdc_file));
+      if (my->_es_objects_backfill)
+         my->backfill();
+      return;
+   }
+
    graphene::utilities::ES es;
    es.curl = my->curl;
    es.elasticsearch_url = my->_es_objects_elasticsearch_url;
@@ -405,6 +588,8 @@ void es_objects_plugin::plugin_startup()
    if(!graphene::utilities::checkES(es))
       FC_THROW_EXCEPTION(fc::exception, "ES database is not up in url ${url}", ("url", my->_es_objects_elasticsearch_url));
    ilog("elasticsearch OBJECTS: plugin_startup() begin");
+   if (my->_es_objects_backfill)
+      my->backfill();
 }
 
 } }
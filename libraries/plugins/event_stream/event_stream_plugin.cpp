@@ -0,0 +1,511 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <graphene/event_stream/event_stream_plugin.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/variant_object.hpp>
+#include <fc/io/raw.hpp>
+
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace graphene { namespace event_stream {
+
+namespace detail
+{
+
+/// A connection to a NATS server, see https://docs.nats.io/reference/reference-protocols/nats-protocol
+class nats_connection
+{
+   public:
+      nats_connection( const std::string& server, const std::string& auth_token, std::chrono::seconds timeout )
+         : _server( server ), _auth_token( auth_token ), _timeout( timeout ) {}
+
+      /// Sends the PUB frames in @p frames, connecting first if needed, and waits until the server has
+      /// processed them. The connection is closed if that fails.
+      void publish( const std::string& frames );
+      void close();
+
+   private:
+      void connect();
+      void write( const std::string& data );
+      /// @return the next line sent by the server, without the line end
+      std::string read_line();
+      /// Runs the started operation, fails if it does not complete within the timeout
+      void run();
+
+      std::string                                    _server;
+      std::string                                    _auth_token;
+      std::chrono::seconds                           _timeout;
+      boost::asio::io_context                        _io;
+      std::unique_ptr<boost::asio::ip::tcp::socket>  _socket;
+      boost::asio::streambuf                         _read_buffer;
+};
+
+void nats_connection::run()
+{
+   _io.restart();
+   _io.run_for( _timeout );
+   if( !_io.stopped() )
+   {
+      // the operation completes with an error when the socket is closed
+      _socket->close();
+      _io.run();
+      FC_THROW( "No response from ${s} within ${t} seconds", ("s", _server)("t", _timeout.count()) );
+   }
+}
+
+void nats_connection::write( const std::string& data )
+{
+   boost::system::error_code result;
+   boost::asio::async_write( *_socket, boost::asio::buffer( data ),
+                             [&result]( const boost::system::error_code& ec, size_t ) { result = ec; } );
+   run();
+   if( result )
+      throw boost::system::system_error( result );
+}
+
+std::string nats_connection::read_line()
+{
+   boost::system::error_code result;
+   size_t length = 0;
+   boost::asio::async_read_until( *_socket, _read_buffer, "\r\n",
+                                  [&result,&length]( const boost::system::error_code& ec, size_t n ) {
+      result = ec;
+      length = n;
+   });
+   run();
+   if( result )
+      throw boost::system::system_error( result );
+   const auto begin = boost::asio::buffers_begin( _read_buffer.data() );
+   std::string line( begin, begin + length - 2 );
+   _read_buffer.consume( length );
+   return line;
+}
+
+void nats_connection::connect()
+{
+   const auto colon = _server.rfind( ':' );
+   FC_ASSERT( colon != std::string::npos, "Missing port number in ${s}", ("s", _server) );
+   boost::asio::ip::tcp::resolver resolver( _io );
+   const auto endpoints = resolver.resolve( _server.substr( 0, colon ), _server.substr( colon + 1 ) );
+   _socket = std::make_unique<boost::asio::ip::tcp::socket>( _io );
+   boost::system::error_code result;
+   boost::asio::async_connect( *_socket, endpoints,
+                               [&result]( const boost::system::error_code& ec,
+                                          const boost::asio::ip::tcp::endpoint& ) { result = ec; } );
+   run();
+   if( result )
+      throw boost::system::system_error( result );
+   _read_buffer.consume( _read_buffer.size() );
+
+   const std::string info = read_line();
+   FC_ASSERT( info.compare( 0, 4, "INFO" ) == 0, "Unexpected greeting from ${s}: ${l}", ("s", _server)("l", info) );
+   fc::mutable_variant_object options;
+   options( "verbose", false )( "pedantic", false )( "name", "revpop-event-stream" )
+          ( "lang", "cpp" )( "version", "1.0.0" )( "protocol", 0 );
+   if( !_auth_token.empty() )
+      options( "auth_token", _auth_token );
+   write( "CONNECT " + fc::json::to_string( options ) + "\r\n" );
+   ilog( "Connected to NATS server ${s}", ("s", _server) );
+}
+
+void nats_connection::publish( const std::string& frames )
+{
+   try
+   {
+      if( !_socket )
+         connect();
+      write( frames );
+      // the server answers a PING after it has processed everything sent before it
+      write( "PING\r\n" );
+      while( true )
+      {
+         const std::string line = read_line();
+         if( line == "PONG" )
+            return;
+         if( line == "PING" )
+            write( "PONG\r\n" );
+         else if( line.compare( 0, 4, "-ERR" ) == 0 )
+            FC_THROW( "${s} reported ${e}", ("s", _server)("e", line) );
+         // INFO updates are not needed
+      }
+   }
+   catch( ... )
+   {
+      close();
+      throw;
+   }
+}
+
+void nats_connection::close()
+{
+   if( !_socket )
+      return;
+   boost::system::error_code ignored;
+   _socket->close( ignored );
+   _socket.reset();
+}
+
+class event_stream_plugin_impl
+{
+   public:
+      explicit event_stream_plugin_impl( event_stream_plugin& _plugin )
+         : _self( _plugin ) {}
+      ~event_stream_plugin_impl();
+
+      void on_block( const signed_block& b );
+
+      graphene::chain::database& database()
+      {
+         return _self.database();
+      }
+
+      event_stream_plugin& _self;
+
+      std::string _nats_server = "127.0.0.1:4222";
+      std::string _auth_token;
+      std::string _subject_prefix = "revpop";
+      bool _publish_blocks = true;
+      bool _publish_operations = true;
+      uint32_t _batch_replay = 1000;
+      uint16_t _max_pending_batches = 8;
+
+      /// The PUB frames of the blocks since the last batch was handed to the sender
+      std::string _batch;
+      uint32_t _batch_blocks = 0;
+      bool _is_sync = false;
+      uint32_t _current_block = 0;
+      uint32_t _last_irreversible = 0;
+
+      fc::path _checkpoint_file;
+      /// The newest block of which all messages are delivered
+      uint32_t _checkpoint = 0;
+      /// Blocks up to this one were published before the node was restarted and are skipped until in sync
+      uint32_t _resume_after_block = 0;
+
+      void start_sender();
+      void stop_sender();
+
+   private:
+      void add_message( const std::string& name, const std::vector<char>& payload );
+      void add_irreversible_block();
+      /// Hands the batch over to the sender, waits if too many batches are pending
+      void send_batch( uint32_t last_complete_block );
+      /// Waits until at most @p max_pending batches are pending and moves the checkpoint ahead
+      void wait_for_batches( size_t max_pending );
+      void sender_loop();
+
+      struct outgoing_batch
+      {
+         std::string         frames;
+         std::promise<void>  done;
+      };
+      struct pending_batch
+      {
+         uint32_t           last_complete_block; ///< all messages of this and the earlier blocks are sent
+         std::future<void>  done;
+      };
+      std::deque<pending_batch> _pending_batches;
+      /// A batch failed at shutdown, the checkpoint must not move past it
+      bool _batch_lost = false;
+
+      /// Messages are sent by one thread, so that they arrive in order
+      std::thread _sender;
+      std::mutex _queue_mutex;
+      std::condition_variable _queue_cv;
+      std::deque<std::shared_ptr<outgoing_batch>> _queue;
+      bool _stop_sender = false;
+      std::atomic<bool> _stopping { false };
+};
+
+event_stream_plugin_impl::~event_stream_plugin_impl()
+{
+   stop_sender();
+}
+
+void event_stream_plugin_impl::add_message( const std::string& name, const std::vector<char>& payload )
+{
+   _batch += "PUB " + _subject_prefix + "." + name + " " + std::to_string( payload.size() ) + "\r\n";
+   _batch.append( payload.data(), payload.size() );
+   _batch += "\r\n";
+}
+
+void event_stream_plugin_impl::add_irreversible_block()
+{
+   const uint32_t last_irreversible = database().get_dynamic_global_properties().last_irreversible_block_num;
+   if( last_irreversible <= _last_irreversible )
+      return;
+   _last_irreversible = last_irreversible;
+   irreversible_block_event event;
+   event.block_num = last_irreversible;
+   event.block_id = database().get_block_id_for_num( last_irreversible );
+   add_message( "irreversible", fc::raw::pack( event ) );
+}
+
+void event_stream_plugin_impl::on_block( const signed_block& b )
+{
+   const uint32_t block_num = b.block_num();
+   _current_block = block_num;
+   _is_sync = ( fc::time_point::now() - b.timestamp ) < fc::seconds( 30 );
+
+   if( _is_sync || block_num > _resume_after_block )
+   {
+      if( _publish_blocks )
+         add_message( "block", fc::raw::pack( b ) );
+      if( _publish_operations )
+      {
+         block_operations_event event;
+         event.block_num = block_num;
+         event.block_id = b.id();
+         for( const optional<operation_history_object>& op : database().get_applied_operations() )
+            if( op.valid() )
+               event.operations.push_back( *op );
+         add_message( "operations", fc::raw::pack( event ) );
+      }
+   }
+
+   ++_batch_blocks;
+   if( _is_sync || _batch_blocks >= _batch_replay )
+      send_batch( block_num );
+}
+
+void event_stream_plugin_impl::send_batch( uint32_t last_complete_block )
+{
+   // irreversibility is announced once per batch, i.e. with every block when in sync
+   add_irreversible_block();
+   _batch_blocks = 0;
+   if( _batch.empty() )
+      return;
+
+   wait_for_batches( _max_pending_batches - 1 );
+   auto batch = std::make_shared<outgoing_batch>();
+   batch->frames = std::move( _batch );
+   _batch.clear();
+   _pending_batches.push_back( pending_batch{ last_complete_block, batch->done.get_future() } );
+   {
+      std::lock_guard<std::mutex> lock( _queue_mutex );
+      _queue.push_back( std::move( batch ) );
+   }
+   _queue_cv.notify_all();
+}
+
+void event_stream_plugin_impl::wait_for_batches( size_t max_pending )
+{
+   const uint32_t old_checkpoint = _checkpoint;
+   while( _pending_batches.size() > max_pending || ( !_pending_batches.empty()
+            && _pending_batches.front().done.wait_for( std::chrono::seconds(0) ) == std::future_status::ready ) )
+   {
+      pending_batch batch = std::move( _pending_batches.front() );
+      _pending_batches.pop_front();
+      try {
+         batch.done.get();
+         if( !_batch_lost )
+            _checkpoint = std::max( _checkpoint, batch.last_complete_block );
+      } catch( ... ) {
+         _batch_lost = true;
+      }
+   }
+   if( _checkpoint != old_checkpoint && !_checkpoint_file.string().empty() )
+      fc::json::save_to_file( _checkpoint, _checkpoint_file );
+}
+
+void event_stream_plugin_impl::sender_loop()
+{
+   nats_connection connection( _nats_server, _auth_token, std::chrono::seconds( 30 ) );
+   while( true )
+   {
+      std::shared_ptr<outgoing_batch> batch;
+      {
+         std::unique_lock<std::mutex> lock( _queue_mutex );
+         _queue_cv.wait( lock, [this]() { return !_queue.empty() || _stop_sender; } );
+         if( _queue.empty() )
+            break;
+         batch = std::move( _queue.front() );
+         _queue.pop_front();
+      }
+      std::chrono::seconds retry_delay( 1 );
+      while( true )
+      {
+         try
+         {
+            connection.publish( batch->frames );
+            batch->done.set_value();
+            break;
+         }
+         catch( const fc::exception& e )
+         {
+            elog( "Error publishing ${n} bytes of events to ${s}: ${e}",
+                  ("n", batch->frames.size())("s", _nats_server)("e", e.to_detail_string()) );
+         }
+         catch( const std::exception& e )
+         {
+            elog( "Error publishing ${n} bytes of events to ${s}: ${e}",
+                  ("n", batch->frames.size())("s", _nats_server)("e", e.what()) );
+         }
+         // every pending batch gets one more try at shutdown
+         if( _stopping )
+         {
+            batch->done.set_exception( std::make_exception_ptr( fc::exception() ) );
+            break;
+         }
+         wlog( "Retrying in ${s} seconds", ("s", retry_delay.count()) );
+         {
+            std::unique_lock<std::mutex> lock( _queue_mutex );
+            _queue_cv.wait_for( lock, retry_delay, [this]() { return _stopping.load(); } );
+         }
+         retry_delay = std::min( retry_delay * 2, std::chrono::seconds( 60 ) );
+      }
+   }
+   connection.close();
+}
+
+void event_stream_plugin_impl::start_sender()
+{
+   _sender = std::thread( [this]() { sender_loop(); } );
+}
+
+void event_stream_plugin_impl::stop_sender()
+{
+   if( !_sender.joinable() )
+      return;
+   if( !_batch.empty() || _batch_blocks > 0 )
+      send_batch( _current_block );
+   {
+      std::lock_guard<std::mutex> lock( _queue_mutex );
+      _stopping = true;
+   }
+   _queue_cv.notify_all();
+   wait_for_batches( 0 );
+   {
+      std::lock_guard<std::mutex> lock( _queue_mutex );
+      _stop_sender = true;
+   }
+   _queue_cv.notify_all();
+   _sender.join();
+}
+
+} // end namespace detail
+
+event_stream_plugin::event_stream_plugin(graphene::app::application& app) :
+   plugin(app),
+   my( std::make_unique<detail::event_stream_plugin_impl>(*this) )
+{
+}
+
+event_stream_plugin::~event_stream_plugin() = default;
+
+std::string event_stream_plugin::plugin_name()const
+{
+   return "event_stream";
+}
+std::string event_stream_plugin::plugin_description()const
+{
+   return "Publishes the applied blocks, their operations and irreversibility notices to a NATS server";
+}
+
+void event_stream_plugin::plugin_set_program_options(
+   boost::program_options::options_description& cli,
+   boost::program_options::options_description& cfg
+   )
+{
+   cli.add_options()
+         ("event-stream-nats-server", boost::program_options::value<std::string>(),
+               "Host and port of the NATS server to publish to (127.0.0.1:4222)")
+         ("event-stream-auth-token", boost::program_options::value<std::string>(),
+               "Authentication token for the NATS server, if it needs one")
+         ("event-stream-subject-prefix", boost::program_options::value<std::string>(),
+               "Prefix of the subjects, messages are published to <prefix>.block, <prefix>.operations and "
+               "<prefix>.irreversible (revpop)")
+         ("event-stream-blocks", boost::program_options::value<bool>(),
+               "Whether to publish the applied blocks (true)")
+         ("event-stream-operations", boost::program_options::value<bool>(),
+               "Whether to publish the operations of the applied blocks, including virtual operations (true)")
+         ("event-stream-batch-replay", boost::program_options::value<uint32_t>(),
+               "Number of blocks of which the messages are sent together while not in sync (1000)")
+         ("event-stream-max-pending-batches", boost::program_options::value<uint16_t>(),
+               "Number of batches which may wait to be delivered before block processing waits for them (8)")
+         ;
+   cfg.add(cli);
+}
+
+void event_stream_plugin::plugin_initialize(const boost::program_options::variables_map& options)
+{
+   if (options.count("event-stream-nats-server") > 0) {
+      my->_nats_server = options["event-stream-nats-server"].as<std::string>();
+   }
+   if (options.count("event-stream-auth-token") > 0) {
+      my->_auth_token = options["event-stream-auth-token"].as<std::string>();
+   }
+   if (options.count("event-stream-subject-prefix") > 0) {
+      my->_subject_prefix = options["event-stream-subject-prefix"].as<std::string>();
+   }
+   if (options.count("event-stream-blocks") > 0) {
+      my->_publish_blocks = options["event-stream-blocks"].as<bool>();
+   }
+   if (options.count("event-stream-operations") > 0) {
+      my->_publish_operations = options["event-stream-operations"].as<bool>();
+   }
+   if (options.count("event-stream-batch-replay") > 0) {
+      my->_batch_replay = std::max<uint32_t>( options["event-stream-batch-replay"].as<uint32_t>(), 1 );
+   }
+   if (options.count("event-stream-max-pending-batches") > 0) {
+      my->_max_pending_batches = options["event-stream-max-pending-batches"].as<uint16_t>();
+      FC_ASSERT( my->_max_pending_batches > 0, "event-stream-max-pending-batches must be positive" );
+   }
+
+   // the messages of the blocks up to the checkpoint are not published again on replay
+   const fc::path checkpoint_dir = app().data_dir() / "event_stream";
+   fc::create_directories( checkpoint_dir );
+   my->_checkpoint_file = checkpoint_dir / ( my->_subject_prefix + "-checkpoint.json" );
+   if( fc::exists( my->_checkpoint_file ) )
+   {
+      my->_checkpoint = fc::json::from_file( my->_checkpoint_file ).as<uint32_t>( 1 );
+      my->_resume_after_block = my->_checkpoint;
+      ilog( "Events of the blocks up to ${b} are published already, delete ${f} to publish them again",
+            ("b",my->_checkpoint)("f",my->_checkpoint_file) );
+   }
+   my->start_sender();
+
+   database().connect_applied_block( "event_stream", [this]( const signed_block& b ) {
+      my->on_block( b );
+   });
+}
+
+void event_stream_plugin::plugin_startup()
+{
+   const uint32_t head = database().head_block_num();
+   const uint32_t published = std::max( my->_checkpoint, my->_current_block );
+   if( published > 0 && published < head )
+      wlog( "Events of the blocks ${f} to ${h} were not published, they are published on a replay",
+            ("f", published + 1)("h", head) );
+}
+
+void event_stream_plugin::plugin_shutdown()
+{
+   my->stop_sender();
+}
+
+} }
@@ -0,0 +1,80 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <graphene/app/plugin.hpp>
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/operation_history_object.hpp>
+
+namespace graphene { namespace event_stream {
+using namespace chain;
+
+/// Payload of the messages published to <prefix>.operations, the real and virtual operations applied with a block
+struct block_operations_event
+{
+   uint32_t                          block_num = 0;
+   block_id_type                     block_id;
+   vector<operation_history_object>  operations;
+};
+
+/// Payload of the messages published to <prefix>.irreversible, when the last irreversible block has changed
+struct irreversible_block_event
+{
+   uint32_t       block_num = 0;
+   block_id_type  block_id;
+};
+
+namespace detail
+{
+    class event_stream_plugin_impl;
+}
+
+/**
+ * Publishes the applied blocks, their operations and irreversibility notices to a NATS server. The payloads are
+ * packed with fc::raw: signed_block for <prefix>.block, block_operations_event for <prefix>.operations and
+ * irreversible_block_event for <prefix>.irreversible.
+ *
+ * Messages are sent in batches by a background thread. A batch counts as delivered once the server has answered
+ * a PING sent after it, the number of the newest block of which all messages were delivered is saved as the
+ * checkpoint. Blocks after the checkpoint are published again on a replay, so messages are delivered at least
+ * once. Blocks applied again after a chain reorganization are published again as well, consumers should take the
+ * last message of a block number as valid until the block is irreversible.
+ */
+class event_stream_plugin : public graphene::app::plugin
+{
+   public:
+      explicit event_stream_plugin(graphene::app::application& app);
+      ~event_stream_plugin() override;
+
+      std::string plugin_name()const override;
+      std::string plugin_description()const override;
+      void plugin_set_program_options(
+         boost::program_options::options_description& cli,
+         boost::program_options::options_description& cfg) override;
+      void plugin_initialize(const boost::program_options::variables_map& options) override;
+      void plugin_startup() override;
+      void plugin_shutdown() override;
+
+   private:
+      std::unique_ptr<detail::event_stream_plugin_impl> my;
+};
+
+} } //graphene::event_stream
+
+FC_REFLECT( graphene::event_stream::block_operations_event, (block_num)(block_id)(operations) )
+FC_REFLECT( graphene::event_stream::irreversible_block_event, (block_num)(block_id) )
@@ -133,10 +133,10 @@ void limit_order_group_index::object_inserted( const object& objct )
          {
             if( capped_min && o.sell_price < itr->first.min_price )
             {  // need to update itr->min_price here, if itr is below min, and new order is even lower
-               // TODO improve performance
+               // the new key sorts at the same position, so reuse it as the insertion hint
                limit_order_group_data data( itr->second.max_price, o.for_sale + itr->second.total_for_sale );
-               idx.erase( itr );
-               idx[ limit_order_group_key( group, o.sell_price ) ] = data;
+               auto hint = idx.erase( itr );
+               idx.emplace_hint( hint, limit_order_group_key( group, o.sell_price ), data );
             }
             else
             {
@@ -175,10 +175,10 @@ void limit_order_group_index::object_inserted( const object& objct )
                }
                else
                {  // new order is within the range
-                  // TODO improve performance
+                  // the new key sorts at the same position, so reuse it as the insertion hint
                   limit_order_group_data data( itr->second.max_price, o.for_sale + itr->second.total_for_sale );
-                  idx.erase( itr );
-                  idx[ limit_order_group_key( group, o.sell_price ) ] = data;
+                  auto hint = idx.erase( itr );
+                  idx.emplace_hint( hint, limit_order_group_key( group, o.sell_price ), data );
                }
             }
          }
@@ -0,0 +1,197 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <graphene/market_history/bucket_store.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/io/fstream.hpp>
+#include <fc/io/raw.hpp>
+
+#include <algorithm>
+#include <fstream>
+
+namespace graphene { namespace market_history {
+
+bucket_store::bucket_store( const flat_set<uint32_t>& bucket_sizes, uint32_t history_per_size )
+: _bucket_sizes( bucket_sizes ), _history_per_size( history_per_size )
+{
+}
+
+void bucket_store::open_bucket( bucket_object& b, const bucket_key& key, const price& trade_price,
+                                const price& fill_price )
+{
+   b.key = key;
+   b.base_volume = trade_price.base.amount;
+   b.quote_volume = trade_price.quote.amount;
+   b.open_base = fill_price.base.amount;
+   b.open_quote = fill_price.quote.amount;
+   b.close_base = fill_price.base.amount;
+   b.close_quote = fill_price.quote.amount;
+   b.high_base = b.close_base;
+   b.high_quote = b.close_quote;
+   b.low_base = b.close_base;
+   b.low_quote = b.close_quote;
+}
+
+void bucket_store::add_to_bucket( bucket_object& b, const price& trade_price, const price& fill_price )
+{
+   try {
+      b.base_volume += trade_price.base.amount;
+   } catch( fc::overflow_exception& ) {
+      b.base_volume = std::numeric_limits<int64_t>::max();
+   }
+   try {
+      b.quote_volume += trade_price.quote.amount;
+   } catch( fc::overflow_exception& ) {
+      b.quote_volume = std::numeric_limits<int64_t>::max();
+   }
+   b.close_base = fill_price.base.amount;
+   b.close_quote = fill_price.quote.amount;
+   if( b.high() < fill_price )
+   {
+      b.high_base = b.close_base;
+      b.high_quote = b.close_quote;
+   }
+   if( b.low() > fill_price )
+   {
+      b.low_base = b.close_base;
+      b.low_quote = b.close_quote;
+   }
+}
+
+void bucket_store::add_fill( const fill_order_operation& o, fc::time_point_sec now )
+{
+   bucket_key key;
+   key.base    = o.pays.asset_id;
+   key.quote   = o.receives.asset_id;
+
+   price trade_price = o.pays / o.receives;
+
+   if( key.base > key.quote )
+   {
+      std::swap( key.base, key.quote );
+      trade_price = ~trade_price;
+   }
+
+   price fill_price = o.fill_price;
+   if( fill_price.base.asset_id > fill_price.quote.asset_id )
+      fill_price = ~fill_price;
+
+   std::lock_guard<std::mutex> guard( _mutex );
+   for( uint32_t bucket : _bucket_sizes )
+   {
+      const uint64_t bucket_num = now.sec_since_epoch() / bucket;
+      key.seconds = bucket;
+      key.open    = fc::time_point_sec() + ( bucket_num * bucket );
+
+      ring& r = _rings[ ring_key( key.base, key.quote, bucket ) ];
+      if( r.slots.empty() )
+         r.slots.resize( uint64_t( _history_per_size ) + 1 );
+      bucket_object& b = r.slots[ bucket_num % r.slots.size() ];
+      if( b.key.seconds == 0 || b.key.open != key.open )
+         open_bucket( b, key, trade_price, fill_price );
+      else
+         add_to_bucket( b, trade_price, fill_price );
+      r.newest_bucket_num = std::max( r.newest_bucket_num, bucket_num );
+   }
+}
+
+vector<bucket_object> bucket_store::get_buckets( asset_id_type base, asset_id_type quote, uint32_t bucket_seconds,
+                                                 fc::time_point_sec start, fc::time_point_sec end,
+                                                 uint32_t limit )const
+{
+   vector<bucket_object> result;
+   if( bucket_seconds == 0 || start > end )
+      return result;
+
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _rings.find( ring_key( base, quote, bucket_seconds ) );
+   if( itr == _rings.end() )
+      return result;
+   const ring& r = itr->second;
+
+   // the same buckets as kept in the database: those not older than history-per-size buckets before the newest
+   const uint64_t oldest_kept = r.newest_bucket_num > _history_per_size ? r.newest_bucket_num - _history_per_size : 0;
+   const uint64_t first = std::max<uint64_t>( oldest_kept,
+                                              ( uint64_t( start.sec_since_epoch() ) + bucket_seconds - 1 ) / bucket_seconds );
+   const uint64_t last = std::min<uint64_t>( r.newest_bucket_num, end.sec_since_epoch() / bucket_seconds );
+   for( uint64_t bucket_num = first; bucket_num <= last && result.size() < limit; ++bucket_num )
+   {
+      const bucket_object& b = r.slots[ bucket_num % r.slots.size() ];
+      if( b.key.seconds != 0 && b.key.open.sec_since_epoch() == bucket_num * bucket_seconds )
+         result.push_back( b );
+   }
+   return result;
+}
+
+uint32_t bucket_store::last_block_num()const
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   return _last_block_num;
+}
+
+void bucket_store::set_last_block_num( uint32_t block_num )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   _last_block_num = block_num;
+}
+
+void bucket_store::save( const fc::path& file )const
+{ try {
+   std::pair< uint32_t, vector<bucket_object> > content;
+   {
+      std::lock_guard<std::mutex> guard( _mutex );
+      content.first = _last_block_num;
+      for( const auto& item : _rings )
+         for( const bucket_object& b : item.second.slots )
+            if( b.key.seconds != 0 )
+               content.second.push_back( b );
+   }
+   const std::vector<char> data = fc::raw::pack( content );
+   std::ofstream out( file.generic_string().c_str(), std::ios::binary | std::ios::trunc );
+   out.write( data.data(), data.size() );
+   out.close();
+   FC_ASSERT( out, "Unable to write ${f}", ("f", file) );
+} FC_CAPTURE_AND_RETHROW( (file) ) }
+
+void bucket_store::load( const fc::path& file )
+{ try {
+   std::string data;
+   fc::read_file_contents( file, data );
+   const auto content = fc::raw::unpack< std::pair< uint32_t, vector<bucket_object> > >(
+                              std::vector<char>( data.begin(), data.end() ) );
+
+   std::lock_guard<std::mutex> guard( _mutex );
+   _rings.clear();
+   _last_block_num = content.first;
+   for( const bucket_object& b : content.second )
+   {
+      if( _bucket_sizes.find( b.key.seconds ) == _bucket_sizes.end() )
+         continue;
+      const uint64_t bucket_num = b.key.open.sec_since_epoch() / b.key.seconds;
+      ring& r = _rings[ ring_key( b.key.base, b.key.quote, b.key.seconds ) ];
+      if( r.slots.empty() )
+         r.slots.resize( uint64_t( _history_per_size ) + 1 );
+      bucket_object& slot = r.slots[ bucket_num % r.slots.size() ];
+      if( slot.key.seconds == 0 || slot.key.open < b.key.open )
+         slot = b;
+      r.newest_bucket_num = std::max( r.newest_bucket_num, bucket_num );
+   }
+} FC_CAPTURE_AND_RETHROW( (file) ) }
+
+} } // graphene::market_history
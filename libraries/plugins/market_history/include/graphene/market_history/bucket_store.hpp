@@ -0,0 +1,87 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <graphene/market_history/market_history_plugin.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace graphene { namespace market_history {
+
+   /**
+    * @class bucket_store
+    * @brief Market history buckets in fixed-size ring buffers outside of the object database
+    *
+    * Each market and bucket size has a ring of history-per-size + 1 buckets, the bucket with number n (its open time
+    * divided by the bucket size) lives in slot n modulo the ring size. A fill updates its bucket in place, and a bucket
+    * which is too old to be kept is simply overwritten, so there is nothing to prune.
+    *
+    * The store is not covered by undo, so it must only be given fills of irreversible blocks.
+    *
+    * All methods are thread-safe.
+    */
+   class bucket_store
+   {
+      public:
+         bucket_store( const flat_set<uint32_t>& bucket_sizes, uint32_t history_per_size );
+
+         /// Adds a maker fill at @p now to the buckets of all sizes
+         void add_fill( const fill_order_operation& o, fc::time_point_sec now );
+
+         /// Buckets of a market with @p start <= open <= @p end, oldest first, at most @p limit
+         vector<bucket_object> get_buckets( asset_id_type base, asset_id_type quote, uint32_t bucket_seconds,
+                                            fc::time_point_sec start, fc::time_point_sec end, uint32_t limit )const;
+
+         /// The irreversible block the store is up to date with
+         uint32_t last_block_num()const;
+         void set_last_block_num( uint32_t block_num );
+
+         void save( const fc::path& file )const;
+         /// Replaces the content of the store by the one saved in @p file
+         void load( const fc::path& file );
+
+         /// Sets up a new bucket from its first fill
+         static void open_bucket( bucket_object& b, const bucket_key& key, const price& trade_price,
+                                  const price& fill_price );
+         /// Adds a later fill to a bucket
+         static void add_to_bucket( bucket_object& b, const price& trade_price, const price& fill_price );
+
+      private:
+         typedef std::tuple<asset_id_type, asset_id_type, uint32_t> ring_key;
+         struct ring
+         {
+            /// A slot is unused if its key has no bucket size
+            vector<bucket_object> slots;
+            uint64_t              newest_bucket_num = 0;
+         };
+
+         const flat_set<uint32_t>   _bucket_sizes;
+         const uint32_t             _history_per_size;
+
+         mutable std::mutex         _mutex;
+         std::map<ring_key, ring>   _rings;
+         uint32_t                   _last_block_num = 0;
+   };
+
+} } // graphene::market_history
@@ -217,6 +217,8 @@ typedef generic_index<bucket_object, bucket_object_multi_index_type> bucket_inde
 typedef generic_index<order_history_object, order_history_multi_index_type> history_index;
 typedef generic_index<market_ticker_object, market_ticker_object_multi_index_type> market_ticker_index;
 
+class bucket_store;
+
 namespace detail
 {
     class market_history_plugin_impl;
@@ -240,12 +242,18 @@ class market_history_plugin : public graphene::app::plugin
       void plugin_initialize(
          const boost::program_options::variables_map& options) override;
       void plugin_startup() override;
+      /// Rebuilds the buckets if they are kept in memory
+      bool plugin_rebuild( const graphene::chain::applied_ops_log& log ) override;
+      void plugin_shutdown() override;
 
       uint32_t                    max_history()const;
       const flat_set<uint32_t>&   tracked_buckets()const;
       uint32_t                    max_order_his_records_per_market()const;
       uint32_t                    max_order_his_seconds_per_market()const;
 
+      /// The buckets, if they are kept in memory instead of in the bucket_index
+      const bucket_store*         get_bucket_store()const;
+
    private:
       std::unique_ptr<detail::market_history_plugin_impl> my;
 };
@@ -23,6 +23,7 @@
  */
 
 #include <graphene/market_history/market_history_plugin.hpp>
+#include <graphene/market_history/bucket_store.hpp>
 
 #include <graphene/chain/account_evaluator.hpp>
 #include <graphene/chain/account_object.hpp>
@@ -33,8 +34,12 @@
 #include <graphene/chain/transaction_evaluation_state.hpp>
 #include <graphene/protocol/fee_schedule.hpp>
 
+#include <fc/io/fstream.hpp>
+#include <fc/io/raw.hpp>
 #include <fc/thread/thread.hpp>
 
+#include <fstream>
+
 namespace graphene { namespace market_history {
 
 namespace detail
@@ -46,10 +51,33 @@ class market_history_plugin_impl
       explicit market_history_plugin_impl(market_history_plugin& _plugin)
       :_self( _plugin ) {}
 
+      /// The time and fills of a block
+      typedef std::pair< fc::time_point_sec, vector< fill_order_operation > > block_fills;
+
       /** this method is called as a callback after a block is applied
-       * and will process/index all operations that were applied in the block.
+       * and will process/index all operations that were applied in the block,
+       * or those of the blocks which became irreversible in irreversible-only mode.
        */
-      void update_market_histories( const signed_block& b );
+      void on_applied_block( const signed_block& b );
+
+      /// Updates the history, tickers and buckets with the fills of a block
+      void update_market_histories( const block_fills& fills );
+
+      /// Removes the order history of a market which is beyond both the record and the time limits
+      void prune_order_history( const std::pair< asset_id_type, asset_id_type >& market, fc::time_point_sec now );
+
+      /// Queues the fills of @p b and processes those of the irreversible blocks
+      void update_irreversible_market_histories( const signed_block& b );
+      /// Loads the saved queue once, it is only used if it was saved at @p last_block_num
+      void load_pending_blocks( uint32_t last_block_num );
+      void save_pending_blocks()const;
+
+      /// Keeps the maker fills of @p b until the block is irreversible, then adds them to the bucket store
+      void update_bucket_store( const signed_block& b );
+      /// Loads the saved bucket store once, it is only used if it is up to date with @p last_block_num
+      void load_bucket_store( uint32_t last_block_num );
+      /// Replaces the bucket store by one with the maker fills of @p log
+      bool rebuild_bucket_store( const graphene::chain::applied_ops_log& log );
 
       graphene::chain::database& database()
       {
@@ -61,6 +89,20 @@ class market_history_plugin_impl
       uint32_t                   _maximum_history_per_bucket_size = 1000;
       uint32_t                   _max_order_his_records_per_market = 1000;
       uint32_t                   _max_order_his_seconds_per_market = 259200;
+
+      std::unique_ptr<bucket_store> _bucket_store;
+      fc::path                      _bucket_store_file;
+      bool                          _bucket_store_loaded = false;
+      /// Maker fills of the reversible blocks by block number
+      std::map< uint32_t, vector< std::pair< fc::time_point_sec, fill_order_operation > > > _pending_fills;
+
+      bool                          _irreversible_only = false;
+      fc::path                      _pending_blocks_file;
+      bool                          _pending_blocks_loaded = false;
+      /// Fills of the blocks which are not processed yet by block number
+      std::map< uint32_t, block_fills > _pending_blocks;
+      /// Blocks processed while applying a reversible block, they are queued again if that block is popped
+      std::map< uint32_t, std::map< uint32_t, block_fills > > _processed_blocks;
 };
 
 
@@ -69,9 +111,12 @@ struct operation_process_fill_order
    market_history_plugin&            _plugin;
    fc::time_point_sec                _now;
    const market_ticker_meta_object*& _meta;
+   /// The markets whose order history has grown, they are pruned once after all fills of the block
+   flat_set< std::pair< asset_id_type, asset_id_type > >& _filled_markets;
 
-   operation_process_fill_order( market_history_plugin& mhp, fc::time_point_sec n, const market_ticker_meta_object*& meta )
-   :_plugin(mhp),_now(n),_meta(meta) {}
+   operation_process_fill_order( market_history_plugin& mhp, fc::time_point_sec n, const market_ticker_meta_object*& meta,
+                                 flat_set< std::pair< asset_id_type, asset_id_type > >& filled_markets )
+   :_plugin(mhp),_now(n),_meta(meta),_filled_markets(filled_markets) {}
 
    typedef void result_type;
 
@@ -83,9 +128,7 @@ struct operation_process_fill_order
    {
       //ilog( "processing ${o}", ("o",o) );
       auto& db         = _plugin.database();
-      const auto& order_his_idx = db.get_index_type<history_index>().indices();
-      const auto& history_idx = order_his_idx.get<by_key>();
-      const auto& his_time_idx = order_his_idx.get<by_market_time>();
+      const auto& history_idx = db.get_index_type<history_index>().indices().get<by_key>();
 
       // To save new filled order data
       history_key hkey;
@@ -121,39 +164,8 @@ struct operation_process_fill_order
             _meta = &( *meta_idx.begin() );
       }
 
-      // To remove old filled order data
-      const auto max_records = _plugin.max_order_his_records_per_market();
-      hkey.sequence += max_records;
-      itr = history_idx.lower_bound( hkey );
-      if( itr != history_idx.end() && itr->key.base == hkey.base && itr->key.quote == hkey.quote )
-      {
-         const auto max_seconds = _plugin.max_order_his_seconds_per_market();
-         fc::time_point_sec min_time;
-         if( min_time + max_seconds < _now )
-            min_time = _now - max_seconds;
-         auto time_itr = his_time_idx.lower_bound( std::make_tuple( hkey.base, hkey.quote, min_time ) );
-         if( time_itr != his_time_idx.end() && time_itr->key.base == hkey.base && time_itr->key.quote == hkey.quote )
-         {
-            if( itr->key.sequence >= time_itr->key.sequence )
-            {
-               while( itr != history_idx.end() && itr->key.base == hkey.base && itr->key.quote == hkey.quote )
-               {
-                  auto old_itr = itr;
-                  ++itr;
-                  db.remove( *old_itr );
-               }
-            }
-            else
-            {
-               while( time_itr != his_time_idx.end() && time_itr->key.base == hkey.base && time_itr->key.quote == hkey.quote )
-               {
-                  auto old_itr = time_itr;
-                  ++time_itr;
-                  db.remove( *old_itr );
-               }
-            }
-         }
-      }
+      // Old filled order data are removed once per block
+      _filled_markets.emplace( hkey.base, hkey.quote );
 
       // To update ticker data and buckets data, only update for maker orders
       if( !o.is_maker )
@@ -201,9 +213,9 @@ struct operation_process_fill_order
          });
       }
 
-      // To update buckets data
+      // To update buckets data, unless they are kept in the bucket store
       const auto max_history = _plugin.max_history();
-      if( max_history == 0 ) return;
+      if( max_history == 0 || _plugin.get_bucket_store() != nullptr ) return;
 
       const auto& buckets = _plugin.tracked_buckets();
       if( buckets.size() == 0 ) return;
@@ -225,17 +237,7 @@ struct operation_process_fill_order
           { // create new bucket
             /* const auto& obj = */
             db.create<bucket_object>( [&]( bucket_object& b ){
-                 b.key = key;
-                 b.base_volume = trade_price.base.amount;
-                 b.quote_volume = trade_price.quote.amount;
-                 b.open_base = fill_price.base.amount;
-                 b.open_quote = fill_price.quote.amount;
-                 b.close_base = fill_price.base.amount;
-                 b.close_quote = fill_price.quote.amount;
-                 b.high_base = b.close_base;
-                 b.high_quote = b.close_quote;
-                 b.low_base = b.close_base;
-                 b.low_quote = b.close_quote;
+                 bucket_store::open_bucket( b, key, trade_price, fill_price );
             });
             //wlog( "    creating bucket ${b}", ("b",obj) );
           }
@@ -243,28 +245,7 @@ struct operation_process_fill_order
           { // update existing bucket
              //wlog( "    before updating bucket ${b}", ("b",*bucket_itr) );
              db.modify( *bucket_itr, [&]( bucket_object& b ){
-                  try {
-                     b.base_volume += trade_price.base.amount;
-                  } catch( fc::overflow_exception& ) {
-                     b.base_volume = std::numeric_limits<int64_t>::max();
-                  }
-                  try {
-                     b.quote_volume += trade_price.quote.amount;
-                  } catch( fc::overflow_exception& ) {
-                     b.quote_volume = std::numeric_limits<int64_t>::max();
-                  }
-                  b.close_base = fill_price.base.amount;
-                  b.close_quote = fill_price.quote.amount;
-                  if( b.high() < fill_price )
-                  {
-                      b.high_base = b.close_base;
-                      b.high_quote = b.close_quote;
-                  }
-                  if( b.low() > fill_price )
-                  {
-                      b.low_base = b.close_base;
-                      b.low_quote = b.close_quote;
-                  }
+                  bucket_store::add_to_bucket( b, trade_price, fill_price );
              });
              //wlog( "    after bucket bucket ${b}", ("b",*bucket_itr) );
           }
@@ -289,7 +270,28 @@ struct operation_process_fill_order
    }
 };
 
-void market_history_plugin_impl::update_market_histories( const signed_block& b )
+void market_history_plugin_impl::on_applied_block( const signed_block& b )
+{
+   if( _bucket_store )
+      update_bucket_store( b );
+
+   if( _irreversible_only )
+   {
+      update_irreversible_market_histories( b );
+      return;
+   }
+
+   block_fills fills;
+   fills.first = b.timestamp;
+   for( const optional< operation_history_object >& o_op : database().get_applied_operations() )
+   {
+      if( o_op.valid() && o_op->op.is_type<fill_order_operation>() )
+         fills.second.push_back( o_op->op.get<fill_order_operation>() );
+   }
+   update_market_histories( fills );
+}
+
+void market_history_plugin_impl::update_market_histories( const block_fills& fills )
 {
    graphene::chain::database& db = database();
 
@@ -298,22 +300,27 @@ void market_history_plugin_impl::update_market_histories( const signed_block& b
    if( meta_idx.size() > 0 )
       _meta = &( *meta_idx.begin() );
 
-   const vector<optional< operation_history_object > >& hist = db.get_applied_operations();
-   for( const optional< operation_history_object >& o_op : hist )
+   const fc::time_point_sec block_time = fills.first;
+   flat_set< std::pair< asset_id_type, asset_id_type > > filled_markets;
+   for( const fill_order_operation& o : fills.second )
    {
-      if( o_op.valid() )
+      // process market history
+      try
       {
-         // process market history
-         try
-         {
-            o_op->op.visit( operation_process_fill_order( _self, b.timestamp, _meta ) );
-         } FC_CAPTURE_AND_LOG( (o_op) )
-      }
+         operation_process_fill_order( _self, block_time, _meta, filled_markets )( o );
+      } FC_CAPTURE_AND_LOG( (o) )
+   }
+   for( const auto& market : filled_markets )
+   {
+      try
+      {
+         prune_order_history( market, block_time );
+      } FC_CAPTURE_AND_LOG( (market) )
    }
    // roll out expired data from ticker
    if( _meta != nullptr )
    {
-      time_point_sec last_day = b.timestamp - 86400;
+      time_point_sec last_day = block_time - 86400;
       object_id_type last_min_his_id = _meta->rolling_min_order_his_id;
       bool skip = _meta->skip_min_order_his_id;
 
@@ -382,6 +389,223 @@ void market_history_plugin_impl::update_market_histories( const signed_block& b
    }
 }
 
+void market_history_plugin_impl::prune_order_history( const std::pair< asset_id_type, asset_id_type >& market,
+                                                      fc::time_point_sec now )
+{
+   graphene::chain::database& db = database();
+   const auto& order_his_idx = db.get_index_type<history_index>().indices();
+   const auto& history_idx = order_his_idx.get<by_key>();
+   const auto& his_time_idx = order_his_idx.get<by_market_time>();
+
+   // The newest record of the market has the lowest sequence, so the records beyond the limit start from the
+   // sequence of the newest one plus the limit
+   history_key hkey;
+   hkey.base = market.first;
+   hkey.quote = market.second;
+   hkey.sequence = std::numeric_limits<int64_t>::min();
+   auto itr = history_idx.lower_bound( hkey );
+   if( itr == history_idx.end() || itr->key.base != hkey.base || itr->key.quote != hkey.quote )
+      return;
+   hkey.sequence = itr->key.sequence + _max_order_his_records_per_market;
+   itr = history_idx.lower_bound( hkey );
+   if( itr == history_idx.end() || itr->key.base != hkey.base || itr->key.quote != hkey.quote )
+      return;
+
+   fc::time_point_sec min_time;
+   if( min_time + _max_order_his_seconds_per_market < now )
+      min_time = now - _max_order_his_seconds_per_market;
+   auto time_itr = his_time_idx.lower_bound( std::make_tuple( hkey.base, hkey.quote, min_time ) );
+   if( time_itr == his_time_idx.end() || time_itr->key.base != hkey.base || time_itr->key.quote != hkey.quote )
+      return;
+
+   // Both ranges reach the end of the market, the shorter one is dropped as a whole
+   if( itr->key.sequence >= time_itr->key.sequence )
+   {
+      while( itr != history_idx.end() && itr->key.base == hkey.base && itr->key.quote == hkey.quote )
+      {
+         auto old_itr = itr;
+         ++itr;
+         db.remove( *old_itr );
+      }
+   }
+   else
+   {
+      while( time_itr != his_time_idx.end() && time_itr->key.base == hkey.base && time_itr->key.quote == hkey.quote )
+      {
+         auto old_itr = time_itr;
+         ++time_itr;
+         db.remove( *old_itr );
+      }
+   }
+}
+
+void market_history_plugin_impl::update_irreversible_market_histories( const signed_block& b )
+{
+   graphene::chain::database& db = database();
+   const uint32_t block_num = b.block_num();
+   load_pending_blocks( block_num - 1 );
+
+   // what was processed while applying the popped blocks has been undone with them
+   for( auto itr = _processed_blocks.lower_bound( block_num ); itr != _processed_blocks.end(); )
+   {
+      for( auto& processed : itr->second )
+         _pending_blocks[ processed.first ] = std::move( processed.second );
+      itr = _processed_blocks.erase( itr );
+   }
+   _pending_blocks.erase( _pending_blocks.lower_bound( block_num ), _pending_blocks.end() );
+
+   auto& fills = _pending_blocks[ block_num ];
+   fills.first = b.timestamp;
+   for( const optional< operation_history_object >& o_op : db.get_applied_operations() )
+   {
+      if( o_op.valid() && o_op->op.is_type<fill_order_operation>() )
+         fills.second.push_back( o_op->op.get<fill_order_operation>() );
+   }
+
+   const uint32_t last_irreversible = db.get_dynamic_global_properties().last_irreversible_block_num;
+   // what was processed while applying an irreversible block can no longer be undone
+   _processed_blocks.erase( _processed_blocks.begin(), _processed_blocks.upper_bound( last_irreversible ) );
+
+   auto itr = _pending_blocks.begin();
+   if( itr == _pending_blocks.end() || itr->first > last_irreversible )
+      return;
+   auto& processed = _processed_blocks[ block_num ];
+   for( ; itr != _pending_blocks.end() && itr->first <= last_irreversible; itr = _pending_blocks.erase( itr ) )
+   {
+      update_market_histories( itr->second );
+      if( block_num > last_irreversible )
+         processed[ itr->first ] = std::move( itr->second );
+   }
+   if( processed.empty() )
+      _processed_blocks.erase( block_num );
+}
+
+void market_history_plugin_impl::load_pending_blocks( uint32_t last_block_num )
+{
+   if( _pending_blocks_loaded )
+      return;
+   _pending_blocks_loaded = true;
+   if( !fc::exists( _pending_blocks_file ) )
+      return;
+   try
+   {
+      std::string data;
+      fc::read_file_contents( _pending_blocks_file, data );
+      auto content = fc::raw::unpack< std::pair< uint32_t, std::map< uint32_t, block_fills > > >(
+                           std::vector<char>( data.begin(), data.end() ) );
+      // the chain is rewound to the last irreversible block on shutdown, it is where the queue was saved
+      if( content.first == last_block_num )
+         _pending_blocks = std::move( content.second );
+      else
+         wlog( "Pending market history blocks in ${f} were saved at block ${s} but the chain is at block ${b}, "
+               "dropping them", ("f",_pending_blocks_file)("s",content.first)("b",last_block_num) );
+   }
+   FC_CAPTURE_AND_LOG( (_pending_blocks_file) )
+   fc::remove( _pending_blocks_file );
+}
+
+void market_history_plugin_impl::save_pending_blocks()const
+{ try {
+   // the processing done while applying reversible blocks is undone when the chain is rewound on shutdown
+   std::pair< uint32_t, std::map< uint32_t, block_fills > > content;
+   content.first = database().get_dynamic_global_properties().last_irreversible_block_num;
+   content.second = _pending_blocks;
+   for( const auto& item : _processed_blocks )
+      content.second.insert( item.second.begin(), item.second.end() );
+
+   const std::vector<char> data = fc::raw::pack( content );
+   std::ofstream out( _pending_blocks_file.generic_string().c_str(), std::ios::binary | std::ios::trunc );
+   out.write( data.data(), data.size() );
+   out.close();
+   FC_ASSERT( out, "Unable to write ${f}", ("f", _pending_blocks_file) );
+} FC_CAPTURE_AND_RETHROW( (_pending_blocks_file) ) }
+
+void market_history_plugin_impl::update_bucket_store( const signed_block& b )
+{
+   graphene::chain::database& db = database();
+   load_bucket_store( b.block_num() - 1 );
+
+   // a block with this number replaces the one we had before a chain reorganization
+   _pending_fills.erase( _pending_fills.lower_bound( b.block_num() ), _pending_fills.end() );
+   auto& fills = _pending_fills[ b.block_num() ];
+   for( const optional< operation_history_object >& o_op : db.get_applied_operations() )
+   {
+      if( o_op.valid() && o_op->op.is_type<fill_order_operation>() )
+      {
+         const auto& o = o_op->op.get<fill_order_operation>();
+         if( o.is_maker )
+            fills.emplace_back( b.timestamp, o );
+      }
+   }
+
+   const uint32_t last_irreversible = db.get_dynamic_global_properties().last_irreversible_block_num;
+   auto itr = _pending_fills.begin();
+   while( itr != _pending_fills.end() && itr->first <= last_irreversible )
+   {
+      for( const auto& fill : itr->second )
+         _bucket_store->add_fill( fill.second, fill.first );
+      itr = _pending_fills.erase( itr );
+   }
+   if( last_irreversible > _bucket_store->last_block_num() )
+      _bucket_store->set_last_block_num( last_irreversible );
+}
+
+void market_history_plugin_impl::load_bucket_store( uint32_t last_block_num )
+{
+   if( _bucket_store_loaded )
+      return;
+   _bucket_store_loaded = true;
+   if( !fc::exists( _bucket_store_file ) )
+      return;
+   try
+   {
+      _bucket_store->load( _bucket_store_file );
+      // the chain is rewound to the last irreversible block on shutdown, so the store matches the head block
+      // unless the database was replayed
+      if( _bucket_store->last_block_num() == last_block_num )
+         return;
+      wlog( "Market history buckets in ${f} are at block ${s} but the chain is at block ${b}, dropping them",
+            ("f",_bucket_store_file)("s",_bucket_store->last_block_num())("b",last_block_num) );
+   }
+   FC_CAPTURE_AND_LOG( (_bucket_store_file) )
+   _bucket_store = std::make_unique<bucket_store>( _tracked_buckets, _maximum_history_per_bucket_size );
+}
+
+bool market_history_plugin_impl::rebuild_bucket_store( const graphene::chain::applied_ops_log& log )
+{
+   if( !_bucket_store )
+   {
+      wlog( "Only the market history buckets kept in memory can be rebuilt" );
+      return false;
+   }
+   const uint32_t head_block_num = database().head_block_num();
+   if( log.last_block_num() != head_block_num )
+   {
+      wlog( "The applied operations log ends at block ${l} but the chain is at block ${h}",
+            ("l",log.last_block_num())("h",head_block_num) );
+      return false;
+   }
+
+   auto store = std::make_unique<bucket_store>( _tracked_buckets, _maximum_history_per_bucket_size );
+   log.for_each( [&store]( const graphene::chain::applied_ops_log_entry& entry ) {
+      for( const operation_history_object& o_op : entry.ops )
+      {
+         if( o_op.op.is_type<fill_order_operation>() )
+         {
+            const auto& o = o_op.op.get<fill_order_operation>();
+            if( o.is_maker )
+               store->add_fill( o, entry.timestamp );
+         }
+      }
+   });
+   store->set_last_block_num( head_block_num );
+
+   _bucket_store = std::move( store );
+   _bucket_store_loaded = true;
+   _pending_fills.clear();
+   return true;
+}
+
 } // end namespace detail
 
 market_history_plugin::market_history_plugin(graphene::app::application& app) :
@@ -419,13 +643,19 @@ void market_history_plugin::plugin_set_program_options(
            "or those meet the other option, which has more data (default: 259200 (3 days)). "
            "This parameter is reused for liquidity pools as operations in last X seconds per pool in history. "
            "Note: this parameter need to be greater than 24 hours to be able to serve market ticker data correctly.")
+         ("buckets-in-memory", boost::program_options::value<bool>()->default_value(false),
+           "Keep the buckets in fixed-size ring buffers outside of the database, saved to the data directory "
+           "on shutdown. Fills are added to them once their block is irreversible (default: false)")
+         ("irreversible-only", boost::program_options::value<bool>()->default_value(false),
+           "Only process the fills of irreversible blocks, so that data of reversible blocks are never "
+           "rolled back on chain reorganizations (default: false)")
          ;
    cfg.add(cli);
 }
 
 void market_history_plugin::plugin_initialize(const boost::program_options::variables_map& options)
 { try {
-   database().applied_block.connect( [this]( const signed_block& b){ my->update_market_histories(b); } );
+   database().connect_applied_block( "market_history", [this]( const signed_block& b){ my->on_applied_block(b); } );
 
    database().add_index< primary_index< bucket_index  > >();
    database().add_index< primary_index< history_index  > >();
@@ -444,10 +674,50 @@ void market_history_plugin::plugin_initialize(const boost::program_options::vari
       my->_max_order_his_records_per_market = options["max-order-his-records-per-market"].as<uint32_t>();
    if( options.count( "max-order-his-seconds-per-market" ) > 0 )
       my->_max_order_his_seconds_per_market = options["max-order-his-seconds-per-market"].as<uint32_t>();
+   if( options.count( "buckets-in-memory" ) > 0 && options["buckets-in-memory"].as<bool>()
+         && my->_maximum_history_per_bucket_size > 0 && !my->_tracked_buckets.empty() )
+   {
+      my->_bucket_store = std::make_unique<bucket_store>( my->_tracked_buckets, my->_maximum_history_per_bucket_size );
+      my->_bucket_store_file = app().data_dir() / "market_history_buckets";
+   }
+   if( options.count( "irreversible-only" ) > 0 && options["irreversible-only"].as<bool>() )
+   {
+      my->_irreversible_only = true;
+      my->_pending_blocks_file = app().data_dir() / "market_history_pending_blocks";
+   }
 } FC_CAPTURE_AND_RETHROW() }
 
 void market_history_plugin::plugin_startup()
 {
+   if( my->_bucket_store )
+      my->load_bucket_store( database().head_block_num() );
+   if( my->_irreversible_only )
+      my->load_pending_blocks( database().head_block_num() );
+}
+
+bool market_history_plugin::plugin_rebuild( const graphene::chain::applied_ops_log& log )
+{
+   return my->rebuild_bucket_store( log );
+}
+
+void market_history_plugin::plugin_shutdown()
+{
+   if( my->_bucket_store )
+   {
+      try
+      {
+         my->_bucket_store->save( my->_bucket_store_file );
+      }
+      FC_CAPTURE_AND_LOG( (my->_bucket_store_file) )
+   }
+   if( my->_irreversible_only )
+   {
+      try
+      {
+         my->save_pending_blocks();
+      }
+      FC_CAPTURE_AND_LOG( (my->_pending_blocks_file) )
+   }
 }
 
 const flat_set<uint32_t>& market_history_plugin::tracked_buckets() const
@@ -470,4 +740,9 @@ uint32_t market_history_plugin::max_order_his_seconds_per_market()const
    return my->_max_order_his_seconds_per_market;
 }
 
+const bucket_store* market_history_plugin::get_bucket_store()const
+{
+   return my->_bucket_store.get();
+}
+
 } }
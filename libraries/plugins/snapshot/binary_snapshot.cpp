@@ -0,0 +1,286 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <graphene/snapshot/binary_snapshot.hpp>
+
+#include <graphene/chain/block_database.hpp>
+#include <graphene/chain/config.hpp>
+#include <graphene/db/task_pool.hpp>
+
+#include <fc/asio.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/thread/parallel.hpp>
+
+#include <boost/endian/buffers.hpp>
+
+#include <deque>
+#include <fstream>
+
+namespace graphene { namespace snapshot_plugin {
+
+using graphene::chain::database;
+using graphene::chain::signed_block;
+
+namespace {
+
+/// Writes a size-prefixed section, @return the serialized value
+template<typename T>
+std::vector<char> write_section( std::ofstream& out, const T& value )
+{
+   std::vector<char> data = fc::raw::pack( value );
+   boost::endian::little_uint64_buf_t size( data.size() );
+   out.write( (const char*)&size, sizeof(size) );
+   out.write( data.data(), data.size() );
+   FC_ASSERT( out, "Failed to write snapshot" );
+   return data;
+}
+
+/// Reads a size-prefixed section, @return the serialized value
+std::vector<char> read_section_data( std::ifstream& in )
+{
+   boost::endian::little_uint64_buf_t size;
+   in.read( (char*)&size, sizeof(size) );
+   FC_ASSERT( in, "Unexpected end of snapshot" );
+   std::vector<char> data( size.value() );
+   in.read( data.data(), data.size() );
+   FC_ASSERT( in, "Unexpected end of snapshot" );
+   return data;
+}
+
+/// Collects all indexes of @p db in the order of their space and type ids
+std::vector<const graphene::db::index*> get_all_indexes( const database& db )
+{
+   std::vector<const graphene::db::index*> result;
+   for( uint32_t space_id = 0; space_id < 256; space_id++ )
+      for( uint32_t type_id = 0; type_id < 256; type_id++ )
+      {
+         try
+         {
+            result.push_back( &db.get_index( (uint8_t)space_id, (uint8_t)type_id ) );
+         }
+         catch (fc::assert_exception& e)
+         {
+            continue;
+         }
+      }
+   return result;
+}
+
+} // anonymous namespace
+
+snapshot_data capture_binary_snapshot( const database& db )
+{ try {
+   const auto indexes = get_all_indexes( db );
+
+   snapshot_data result;
+   snapshot_header& header = result.header;
+   header.db_version      = GRAPHENE_CURRENT_DB_VERSION;
+   header.chain_id        = db.get_chain_id();
+   header.head_block_num  = db.head_block_num();
+   header.head_block_id   = db.head_block_id();
+   header.head_block_time = db.head_block_time();
+   header.index_count     = indexes.size();
+
+   // the reversible blocks are needed to serve and switch forks, and to create a blockchain synopsis for p2p sync
+   const uint32_t first_block = std::max<uint32_t>( 1, db.get_dynamic_global_properties().last_irreversible_block_num );
+   for( uint32_t num = first_block; num <= header.head_block_num; ++num )
+   {
+      fc::optional<signed_block> block = db.fetch_block_by_number( num );
+      FC_ASSERT( block.valid(), "Block ${n} is not available", ("n",num) );
+      result.blocks.emplace_back( std::move(*block) );
+   }
+
+   // Indexes are serialized in parallel
+   result.indexes.resize( indexes.size() );
+   graphene::db::task_pool::instance().run_and_wait( indexes.size(), [&indexes,&result] ( size_t i ) {
+      const graphene::db::index& idx = *indexes[i];
+      snapshot_index_header& index_header = result.indexes[i].first;
+      std::vector<snapshot_chunk>& chunks = result.indexes[i].second;
+      index_header.space_id       = idx.object_space_id();
+      index_header.type_id        = idx.object_type_id();
+      index_header.next_id        = idx.get_next_id();
+      index_header.object_version = idx.get_object_version();
+      chunks.emplace_back();
+      idx.inspect_all_objects( [&chunks]( const graphene::db::object& o ) {
+         if( chunks.back().object_count == SNAPSHOT_CHUNK_SIZE )
+            chunks.emplace_back();
+         snapshot_chunk& chunk = chunks.back();
+         std::vector<char> record = fc::raw::pack( o.pack() );
+         chunk.data.insert( chunk.data.end(), record.begin(), record.end() );
+         ++chunk.object_count;
+      });
+      if( chunks.back().object_count == 0 )
+         chunks.pop_back();
+      for( snapshot_chunk& chunk : chunks )
+      {
+         chunk.hash = fc::sha256::hash( chunk.data.data(), chunk.data.size() );
+         index_header.object_count += chunk.object_count;
+      }
+      index_header.chunk_count = chunks.size();
+   });
+   return result;
+} FC_CAPTURE_AND_RETHROW() }
+
+void write_binary_snapshot( const snapshot_data& data, const fc::path& dest,
+                            const fc::optional<fc::ecc::private_key>& signing_key )
+{ try {
+   std::ofstream out( dest.generic_string(), std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
+   FC_ASSERT( out, "Failed to open ${f}", ("f",dest.generic_string()) );
+
+   fc::sha256::encoder digest;
+   fc::raw::pack( digest, write_section( out, data.header ) );
+   fc::raw::pack( digest, write_section( out, data.blocks ) );
+   for( const auto& index : data.indexes )
+   {
+      fc::raw::pack( digest, write_section( out, index.first ) );
+      for( const snapshot_chunk& chunk : index.second )
+      {
+         fc::raw::pack( digest, chunk.hash );
+         write_section( out, chunk );
+      }
+   }
+
+   snapshot_footer footer;
+   footer.digest = digest.result();
+   if( signing_key.valid() )
+      footer.signature = signing_key->sign_compact( footer.digest );
+   write_section( out, footer );
+   out.close();
+   FC_ASSERT( out, "Failed to write ${f}", ("f",dest.generic_string()) );
+} FC_CAPTURE_AND_RETHROW( (dest) ) }
+
+void write_binary_snapshot( const database& db, const fc::path& dest,
+                            const fc::optional<fc::ecc::private_key>& signing_key )
+{
+   write_binary_snapshot( capture_binary_snapshot( db ), dest, signing_key );
+}
+
+void import_binary_snapshot( const fc::path& src, const fc::path& data_dir,
+                             const fc::optional<graphene::chain::public_key_type>& trusted_key )
+{ try {
+   const fc::path object_dir = data_dir / "object_database";
+   const fc::path block_dir = data_dir / "database" / "block_num_to_block";
+   FC_ASSERT( !fc::exists( object_dir ) && !fc::exists( block_dir ),
+              "Refusing to import a snapshot into ${d} which already contains a blockchain", ("d",data_dir) );
+
+   std::ifstream in( src.generic_string(), std::ifstream::binary | std::ifstream::in );
+   FC_ASSERT( in, "Failed to open ${f}", ("f",src.generic_string()) );
+
+   fc::sha256::encoder digest;
+   std::vector<char> data = read_section_data( in );
+   fc::raw::pack( digest, data );
+   const auto header = fc::raw::unpack<snapshot_header>( data );
+   FC_ASSERT( header.magic == SNAPSHOT_MAGIC, "${f} is not a binary snapshot", ("f",src.generic_string()) );
+   FC_ASSERT( header.format_version == SNAPSHOT_FORMAT_VERSION, "Unsupported snapshot format version ${v}",
+              ("v",header.format_version) );
+   FC_ASSERT( header.db_version == GRAPHENE_CURRENT_DB_VERSION,
+              "Snapshot was created with database version ${s}, expected ${v}",
+              ("s",header.db_version)("v",GRAPHENE_CURRENT_DB_VERSION) );
+   ilog( "Importing snapshot of chain ${c} at block ${n} (${id}, ${t})",
+         ("c",header.chain_id)("n",header.head_block_num)("id",header.head_block_id)("t",header.head_block_time) );
+
+   data = read_section_data( in );
+   fc::raw::pack( digest, data );
+   const auto blocks = fc::raw::unpack<std::vector<signed_block>>( data );
+   FC_ASSERT( blocks.empty() ? header.head_block_num == 0 : blocks.back().id() == header.head_block_id,
+              "Snapshot does not contain its head block" );
+
+   const fc::path tmp_dir = data_dir / "object_database.tmp";
+   fc::remove_all( tmp_dir );
+   try
+   {
+      // chunk hashes are verified on the thread pool while the chunks are read and written in order
+      const size_t window = 2 * fc::asio::default_io_service_scope::get_num_threads();
+      for( uint32_t i = 0; i < header.index_count; ++i )
+      {
+         data = read_section_data( in );
+         fc::raw::pack( digest, data );
+         const auto index_header = fc::raw::unpack<snapshot_index_header>( data );
+         const fc::path space_dir = tmp_dir / fc::to_string( index_header.space_id );
+         fc::create_directories( space_dir );
+         const fc::path index_file = space_dir / fc::to_string( index_header.type_id );
+         std::ofstream out( index_file.generic_string(),
+                            std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
+         FC_ASSERT( out, "Failed to open ${f}", ("f",index_file.generic_string()) );
+         fc::raw::pack( out, index_header.next_id );
+         fc::raw::pack( out, index_header.object_version );
+
+         std::deque< std::pair< snapshot_chunk, fc::future<bool> > > pending;
+         uint64_t object_count = 0;
+         uint32_t read_chunks = 0;
+         while( read_chunks < index_header.chunk_count || !pending.empty() )
+         {
+            if( read_chunks < index_header.chunk_count && pending.size() < window )
+            {
+               pending.emplace_back( fc::raw::unpack<snapshot_chunk>( read_section_data( in ) ), fc::future<bool>() );
+               ++read_chunks;
+               const snapshot_chunk& chunk = pending.back().first;
+               pending.back().second = fc::do_parallel( [&chunk] () {
+                  return fc::sha256::hash( chunk.data.data(), chunk.data.size() ) == chunk.hash;
+               });
+               continue;
+            }
+            const snapshot_chunk& chunk = pending.front().first;
+            FC_ASSERT( pending.front().second.wait(), "Corrupt chunk in index ${s}.${t}",
+                       ("s",index_header.space_id)("t",index_header.type_id) );
+            fc::raw::pack( digest, chunk.hash );
+            out.write( chunk.data.data(), chunk.data.size() );
+            object_count += chunk.object_count;
+            pending.pop_front();
+         }
+         out.close();
+         FC_ASSERT( out, "Failed to write ${f}", ("f",index_file.generic_string()) );
+         FC_ASSERT( object_count == index_header.object_count, "Object count mismatch in index ${s}.${t}",
+                    ("s",index_header.space_id)("t",index_header.type_id) );
+      }
+
+      const auto footer = fc::raw::unpack<snapshot_footer>( read_section_data( in ) );
+      FC_ASSERT( footer.digest == digest.result(), "Snapshot digest mismatch" );
+      if( trusted_key.valid() )
+      {
+         FC_ASSERT( footer.signature.valid(), "Snapshot is not signed" );
+         FC_ASSERT( graphene::chain::public_key_type( fc::ecc::public_key( *footer.signature, footer.digest ) )
+                       == *trusted_key,
+                    "Snapshot is not signed by the trusted key" );
+      }
+      else
+         wlog( "Snapshot integrity is verified, but not its origin, because no trusted key is configured" );
+
+      fc::rename( tmp_dir, object_dir );
+   }
+   catch( ... )
+   {
+      fc::remove_all( tmp_dir );
+      throw;
+   }
+
+   graphene::chain::block_database block_db;
+   block_db.open( block_dir );
+   for( const signed_block& block : blocks )
+      block_db.store( block.id(), block );
+   block_db.close();
+
+   std::ofstream version_file( (data_dir / "db_version").generic_string().c_str(),
+                               std::ios::out | std::ios::binary | std::ios::trunc );
+   version_file.write( header.db_version.c_str(), header.db_version.size() );
+   version_file.close();
+
+   ilog( "Imported snapshot at block ${n}, the remaining blocks will be synchronized from the network",
+         ("n",header.head_block_num) );
+} FC_CAPTURE_AND_RETHROW( (src)(data_dir) ) }
+
+} } // graphene::snapshot_plugin
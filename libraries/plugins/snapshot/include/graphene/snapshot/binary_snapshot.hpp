@@ -0,0 +1,134 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <graphene/chain/database.hpp>
+
+#include <fc/crypto/elliptic.hpp>
+#include <fc/crypto/sha256.hpp>
+
+namespace graphene { namespace snapshot_plugin {
+
+/**
+ * @defgroup binary_snapshot Binary state snapshots
+ *
+ * A binary snapshot contains the complete object database of a node plus the reversible blocks, so that a new
+ * node can be bootstrapped from it and synchronize the remaining blocks over p2p.
+ *
+ * The file is a sequence of size-prefixed sections, each holding one of the structures below in fc::raw format:
+ * a @ref snapshot_header, the reversible blocks, then for each index a @ref snapshot_index_header followed by its
+ * @ref snapshot_chunk s, and finally a @ref snapshot_footer.
+ * @{
+ */
+
+/// Identifies a binary snapshot file
+const uint64_t SNAPSHOT_MAGIC = 0x3150414e53505652ULL; // "RVPSNAP1" in little endian
+const uint32_t SNAPSHOT_FORMAT_VERSION = 1;
+/// Number of objects in a chunk
+const uint32_t SNAPSHOT_CHUNK_SIZE = 10000;
+
+struct snapshot_header
+{
+   uint64_t                         magic = SNAPSHOT_MAGIC;
+   uint32_t                         format_version = SNAPSHOT_FORMAT_VERSION;
+   std::string                      db_version;      ///< object database version of the exporting node
+   graphene::chain::chain_id_type   chain_id;
+   uint32_t                         head_block_num = 0;
+   graphene::chain::block_id_type   head_block_id;
+   fc::time_point_sec               head_block_time;
+   uint32_t                         index_count = 0;
+};
+
+struct snapshot_index_header
+{
+   uint8_t                          space_id = 0;
+   uint8_t                          type_id = 0;
+   graphene::db::object_id_type     next_id;
+   fc::sha256                       object_version;
+   uint64_t                         object_count = 0;
+   uint32_t                         chunk_count = 0;
+};
+
+/// Objects of one index, serialized like the records of an object database file
+struct snapshot_chunk
+{
+   uint32_t                         object_count = 0;
+   std::vector<char>                data;
+   fc::sha256                       hash;            ///< hash of data
+};
+
+struct snapshot_footer
+{
+   /// Hash over the header, the blocks, all index headers and chunk hashes
+   fc::sha256                                    digest;
+   fc::optional<fc::ecc::compact_signature>      signature;
+};
+
+/// The contents of a binary snapshot, detached from the database it was taken from
+struct snapshot_data
+{
+   snapshot_header                                                            header;
+   std::vector<graphene::chain::signed_block>                                 blocks;
+   std::vector< std::pair< snapshot_index_header, std::vector<snapshot_chunk> > > indexes;
+};
+
+/**
+ * @brief Serialize the current state of @p db
+ *
+ * Indexes are serialized and their chunks hashed on the thread pool. The calling thread blocks until all are done
+ * and must ensure that @p db is not modified meanwhile, e.g. by calling this from a database signal handler.
+ */
+snapshot_data capture_binary_snapshot( const graphene::chain::database& db );
+
+/**
+ * @brief Write a captured snapshot to a file
+ * @param signing_key if set, the digest of the snapshot is signed with this key
+ *
+ * This does not access the database and can run in the background.
+ */
+void write_binary_snapshot( const snapshot_data& data, const fc::path& dest,
+                            const fc::optional<fc::ecc::private_key>& signing_key );
+
+/// Capture and write a binary snapshot of the current state of @p db
+void write_binary_snapshot( const graphene::chain::database& db, const fc::path& dest,
+                            const fc::optional<fc::ecc::private_key>& signing_key );
+
+/**
+ * @brief Verify a binary snapshot and unpack it into the blockchain directory of a new node
+ * @param src the snapshot file
+ * @param data_dir the blockchain directory, which must not contain an object database yet
+ * @param trusted_key if set, the snapshot must be signed with this key
+ *
+ * The object database and the reversible blocks are written in the on-disk formats of graphene::db and
+ * graphene::chain::block_database, so that the next database::open() loads them (in parallel, like any other
+ * object database) instead of starting from genesis.
+ */
+void import_binary_snapshot( const fc::path& src, const fc::path& data_dir,
+                             const fc::optional<graphene::chain::public_key_type>& trusted_key );
+
+/// @}
+
+} } // graphene::snapshot_plugin
+
+FC_REFLECT( graphene::snapshot_plugin::snapshot_header,
+            (magic)(format_version)(db_version)(chain_id)(head_block_num)(head_block_id)(head_block_time)
+            (index_count) )
+FC_REFLECT( graphene::snapshot_plugin::snapshot_index_header,
+            (space_id)(type_id)(next_id)(object_version)(object_count)(chunk_count) )
+FC_REFLECT( graphene::snapshot_plugin::snapshot_chunk, (object_count)(data)(hash) )
+FC_REFLECT( graphene::snapshot_plugin::snapshot_footer, (digest)(signature) )
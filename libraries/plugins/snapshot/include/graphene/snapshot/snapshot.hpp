@@ -26,6 +26,8 @@
 #include <graphene/app/plugin.hpp>
 #include <graphene/chain/database.hpp>
 
+#include <fc/crypto/elliptic.hpp>
+#include <fc/thread/future.hpp>
 #include <fc/time.hpp>
 
 namespace graphene { namespace snapshot_plugin {
@@ -43,6 +45,7 @@ class snapshot_plugin : public graphene::app::plugin {
       ) override;
 
       void plugin_initialize( const boost::program_options::variables_map& options ) override;
+      void plugin_shutdown() override;
 
    private:
        void check_snapshot( const graphene::chain::signed_block& b);
@@ -50,6 +53,9 @@ class snapshot_plugin : public graphene::app::plugin {
        uint32_t           snapshot_block = -1, last_block = 0;
        fc::time_point_sec snapshot_time = fc::time_point_sec::maximum(), last_time = fc::time_point_sec(1);
        fc::path           dest;
+       bool               binary = false;
+       fc::optional<fc::ecc::private_key> signing_key;
+       fc::future<void>   pending_write;
 };
 
 } } //graphene::snapshot_plugin
@@ -22,10 +22,13 @@
  * THE SOFTWARE.
  */
 #include <graphene/snapshot/snapshot.hpp>
+#include <graphene/snapshot/binary_snapshot.hpp>
 
 #include <graphene/chain/database.hpp>
+#include <graphene/utilities/key_conversion.hpp>
 
 #include <fc/io/fstream.hpp>
+#include <fc/thread/parallel.hpp>
 
 using namespace graphene::snapshot_plugin;
 using std::string;
@@ -36,6 +39,10 @@ namespace bpo = boost::program_options;
 static const char* OPT_BLOCK_NUM  = "snapshot-at-block";
 static const char* OPT_BLOCK_TIME = "snapshot-at-time";
 static const char* OPT_DEST       = "snapshot-to";
+static const char* OPT_FORMAT     = "snapshot-format";
+static const char* OPT_SIGN_KEY   = "snapshot-signing-key";
+static const char* OPT_IMPORT     = "import-snapshot";
+static const char* OPT_TRUST_KEY  = "snapshot-trusted-key";
 
 void snapshot_plugin::plugin_set_program_options(
    boost::program_options::options_description& command_line_options,
@@ -45,6 +52,13 @@ void snapshot_plugin::plugin_set_program_options(
          (OPT_BLOCK_NUM, bpo::value<uint32_t>(), "Block number after which to do a snapshot")
          (OPT_BLOCK_TIME, bpo::value<string>(), "Block time (ISO format) after which to do a snapshot")
          (OPT_DEST, bpo::value<string>(), "Pathname of JSON file where to store the snapshot")
+         (OPT_FORMAT, bpo::value<string>()->default_value("json"),
+          "Format of the snapshot, json for one object per line or binary for a full state snapshot "
+          "which can be imported by import-snapshot")
+         (OPT_SIGN_KEY, bpo::value<string>(), "WIF private key to sign binary snapshots with")
+         (OPT_IMPORT, bpo::value<string>(),
+          "Pathname of a binary snapshot to initialize an empty blockchain database from")
+         (OPT_TRUST_KEY, bpo::value<string>(), "Public key which imported snapshots must be signed with")
          ;
    config_file_options.add(command_line_options);
 }
@@ -56,13 +70,21 @@ std::string snapshot_plugin::plugin_name()const
 
 std::string snapshot_plugin::plugin_description()const
 {
-   return "Create snapshots at a specified time or block number.";
+   return "Create snapshots at a specified time or block number, and initialize a node from a binary snapshot.";
 }
 
 void snapshot_plugin::plugin_initialize(const boost::program_options::variables_map& options)
 { try {
    ilog("snapshot plugin: plugin_initialize() begin");
 
+   if( options.count(OPT_IMPORT) > 0 )
+   {
+      fc::optional<graphene::chain::public_key_type> trusted_key;
+      if( options.count(OPT_TRUST_KEY) > 0 )
+         trusted_key = graphene::chain::public_key_type( options[OPT_TRUST_KEY].as<std::string>() );
+      import_binary_snapshot( options[OPT_IMPORT].as<std::string>(), app().data_dir() / "blockchain", trusted_key );
+   }
+
    if( options.count(OPT_BLOCK_NUM) > 0 || options.count(OPT_BLOCK_TIME) > 0 )
    {
       FC_ASSERT( options.count(OPT_DEST) > 0,
@@ -72,7 +94,15 @@ void snapshot_plugin::plugin_initialize(const boost::program_options::variables_
          snapshot_block = options[OPT_BLOCK_NUM].as<uint32_t>();
       if( options.count(OPT_BLOCK_TIME) > 0 )
          snapshot_time = fc::time_point_sec::from_iso_string( options[OPT_BLOCK_TIME].as<std::string>() );
-      database().applied_block.connect( [&]( const graphene::chain::signed_block& b ) {
+      const std::string format = options[OPT_FORMAT].as<std::string>();
+      FC_ASSERT( format == "json" || format == "binary", "Unknown snapshot format ${f}", ("f",format) );
+      binary = ( format == "binary" );
+      if( options.count(OPT_SIGN_KEY) > 0 )
+      {
+         signing_key = graphene::utilities::wif_to_key( options[OPT_SIGN_KEY].as<std::string>() );
+         FC_ASSERT( signing_key.valid(), "Invalid snapshot signing key" );
+      }
+      database().connect_applied_block( "snapshot", [&]( const graphene::chain::signed_block& b ) {
          check_snapshot( b );
       });
    }
@@ -120,7 +150,47 @@ void snapshot_plugin::check_snapshot( const graphene::chain::signed_block& b )
     uint32_t current_block = b.block_num();
     if( (last_block < snapshot_block && snapshot_block <= current_block)
            || (last_time < snapshot_time && snapshot_time <= b.timestamp) )
-       create_snapshot( database(), dest );
+    {
+       if( !binary )
+          create_snapshot( database(), dest );
+       else
+       {
+          ilog("snapshot plugin: creating binary snapshot");
+          if( pending_write.valid() && !pending_write.ready() )
+          {
+             wlog( "Previous snapshot is still being written, waiting for it" );
+             pending_write.wait();
+          }
+          try
+          {
+             // only serializing blocks the chain, the file is written in the background
+             auto data = std::make_shared<snapshot_data>( capture_binary_snapshot( database() ) );
+             const fc::path path = dest;
+             const fc::optional<fc::ecc::private_key> key = signing_key;
+             pending_write = fc::do_parallel( [data,path,key] () {
+                try
+                {
+                   write_binary_snapshot( *data, path, key );
+                   ilog("snapshot plugin: created binary snapshot");
+                }
+                catch( const fc::exception& e )
+                {
+                   wlog( "Failed to write binary snapshot: ${ex}", ("ex",e) );
+                }
+             });
+          }
+          catch( const fc::exception& e )
+          {
+             wlog( "Failed to create binary snapshot: ${ex}", ("ex",e) );
+          }
+       }
+    }
     last_block = current_block;
     last_time = b.timestamp;
 } FC_LOG_AND_RETHROW() }
+
+void snapshot_plugin::plugin_shutdown()
+{
+   if( pending_write.valid() )
+      pending_write.wait();
+}
@@ -0,0 +1,87 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <graphene/witness/commit_reveal_schedule.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace graphene { namespace witness_plugin {
+
+namespace {
+
+   uint64_t hash_of( const fc::sha256& seed, const protocol::account_id_type& account )
+   {
+      fc::sha256::encoder enc;
+      fc::raw::pack( enc, seed );
+      fc::raw::pack( enc, account );
+      const fc::sha256 h = enc.result();
+      uint64_t result;
+      std::memcpy( &result, h.data(), sizeof(result) );
+      return result;
+   }
+
+} // anonymous
+
+void commit_reveal_schedule::reset( const std::vector<protocol::account_id_type>& participants,
+                                    const std::vector<protocol::account_id_type>& accounts,
+                                    uint32_t first_slot, uint32_t slot_count, const fc::sha256& seed )
+{
+   clear();
+   if( slot_count == 0 )
+      slot_count = 1;
+
+   std::vector< std::pair<uint64_t, protocol::account_id_type> > order;
+   order.reserve( participants.size() );
+   for( const auto& account : participants )
+      order.emplace_back( hash_of( seed, account ), account );
+   std::sort( order.begin(), order.end() );
+
+   uint64_t seed_value;
+   std::memcpy( &seed_value, seed.data(), sizeof(seed_value) );
+   const uint64_t jitter = seed_value % slot_count;
+
+   for( const auto& account : accounts )
+   {
+      auto itr = std::find_if( order.begin(), order.end(),
+                               [&account]( const std::pair<uint64_t, protocol::account_id_type>& o ) {
+         return o.second == account;
+      });
+      uint64_t offset;
+      if( itr != order.end() )
+      {
+         const uint64_t rank = itr - order.begin();
+         offset = ( rank * slot_count + jitter ) / order.size();
+      }
+      else
+         offset = hash_of( seed, account ) % slot_count;
+      _entries.emplace_back( first_slot + static_cast<uint32_t>( offset ), account );
+   }
+   std::sort( _entries.begin(), _entries.end() );
+}
+
+fc::optional<protocol::account_id_type> commit_reveal_schedule::next_due( uint32_t slot )const
+{
+   if( _next < _entries.size() && _entries[_next].first <= slot )
+      return _entries[_next].second;
+   return fc::optional<protocol::account_id_type>();
+}
+
+} } // graphene::witness_plugin
@@ -0,0 +1,62 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <graphene/protocol/types.hpp>
+
+#include <fc/crypto/sha256.hpp>
+#include <fc/optional.hpp>
+
+#include <utility>
+#include <vector>
+
+namespace graphene { namespace witness_plugin {
+
+   /**
+    * @class commit_reveal_schedule
+    * @brief The slots in which the witnesses of this node do their commit (or reveal) operations
+    *
+    * The participants (usually the active witnesses) are spread evenly over the slots, in an order and with a
+    * jitter derived from a seed. Every node computes the same order from the same seed, so the operations of all
+    * witnesses are spread over the interval instead of clustering in some blocks. An account which is not among
+    * the participants gets a slot derived from the seed alone.
+    */
+   class commit_reveal_schedule
+   {
+      public:
+         /// Schedule @p accounts in the slots [@p first_slot, @p first_slot + @p slot_count)
+         void reset( const std::vector<protocol::account_id_type>& participants,
+                     const std::vector<protocol::account_id_type>& accounts,
+                     uint32_t first_slot, uint32_t slot_count, const fc::sha256& seed );
+         void clear() { _entries.clear(); _next = 0; }
+
+         /// @return the next account which is due at @p slot, if any
+         fc::optional<protocol::account_id_type> next_due( uint32_t slot )const;
+         /// Mark the account returned by @ref next_due as done
+         void pop() { ++_next; }
+
+         /// Scheduled slots and accounts, in slot order
+         const std::vector< std::pair<uint32_t, protocol::account_id_type> >& entries()const { return _entries; }
+
+      private:
+         std::vector< std::pair<uint32_t, protocol::account_id_type> > _entries;
+         size_t                                                         _next = 0;
+   };
+
+} } // graphene::witness_plugin
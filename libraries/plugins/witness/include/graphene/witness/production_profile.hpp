@@ -0,0 +1,68 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <fc/reflect/reflect.hpp>
+#include <fc/time.hpp>
+
+#include <vector>
+
+namespace graphene { namespace witness_plugin {
+
+   /**
+    * @brief A histogram of durations with fixed buckets
+    */
+   struct latency_histogram
+   {
+      /// Upper bounds of the buckets in milliseconds, the last bucket holds all longer durations
+      static const std::vector<uint32_t>& bucket_bounds_ms();
+
+      latency_histogram() : counts( bucket_bounds_ms().size() + 1, 0 ) {}
+
+      void add( const fc::microseconds& duration );
+      /// @return the upper bound in milliseconds of the bucket containing the given percentile, 0 if empty
+      uint32_t percentile_ms( uint32_t percent )const;
+      uint64_t mean_us()const { return samples > 0 ? total_us / samples : 0; }
+
+      std::vector<uint64_t> counts;
+      uint64_t              samples  = 0;
+      uint64_t              total_us = 0;
+      uint64_t              max_us   = 0;
+   };
+
+   /**
+    * @brief Where the time goes when this node produces blocks
+    */
+   struct block_production_profile
+   {
+      uint64_t          blocks_produced = 0;
+      uint64_t          blocks_from_pending_state = 0; ///< packed without applying the transactions again
+      latency_histogram wake_up;    ///< delay between the slot time and the start of production
+      latency_histogram packing;    ///< applying pending transactions in generate_block()
+      latency_histogram signing;
+      latency_histogram pushing;    ///< applying the new block
+      latency_histogram broadcast;  ///< handing the block to the p2p node
+      latency_histogram total;      ///< from the start of production until the block is broadcast
+   };
+
+} } // graphene::witness_plugin
+
+FC_REFLECT( graphene::witness_plugin::latency_histogram, (counts)(samples)(total_us)(max_us) )
+FC_REFLECT( graphene::witness_plugin::block_production_profile,
+            (blocks_produced)(blocks_from_pending_state)(wake_up)(packing)(signing)(pushing)(broadcast)(total) )
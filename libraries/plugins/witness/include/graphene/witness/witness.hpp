@@ -25,6 +25,8 @@
 #pragma once
 
 #include <graphene/app/plugin.hpp>
+#include <graphene/witness/production_profile.hpp>
+#include <graphene/witness/commit_reveal_schedule.hpp>
 #include <graphene/app/api.hpp>
 #include <graphene/chain/database.hpp>
 #include <graphene/protocol/block.hpp>
@@ -34,6 +36,7 @@
 #include <graphene/protocol/transaction.hpp>
 
 #include <fc/thread/future.hpp>
+#include <fc/thread/thread.hpp>
 #include <fc/optional.hpp>
 #include <fc/crypto/aes.hpp>
 #include <fc/crypto/base64.hpp>
@@ -87,13 +90,17 @@ public:
    inline const fc::flat_map< chain::witness_id_type, fc::optional<chain::public_key_type> >& get_witness_key_cache()
    { return _witness_key_cache; }
 
+   const block_production_profile& get_block_production_profile()const { return _production_profile; }
+   void reset_block_production_profile() { _production_profile = block_production_profile(); }
+
 private:
-   void cleanup() { stop_block_production(); }
+   void cleanup();
 
    void schedule_production_loop();
    block_production_condition::block_production_condition_enum block_production_loop();
    block_production_condition::block_production_condition_enum maybe_produce_block( fc::limited_mutable_variant_object& capture );
    void add_private_key(const std::string& key_id_to_wif_pair_string);
+   void log_production_profile()const;
 
    /// Fetch signing keys of all witnesses in the cache from object database and update the cache accordingly
    void refresh_witness_key_cache();
@@ -108,6 +115,10 @@ private:
    std::set<chain::witness_id_type> _witnesses;
    fc::future<void> _block_production_task;
 
+   block_production_profile _production_profile;
+   /// Number of produced blocks between logging the production profile, 0 to disable
+   uint32_t _production_profile_log_interval = 100;
+
    /// For tracking signing keys of specified witnesses, only update when applied a block
    fc::flat_map< chain::witness_id_type, fc::optional<chain::public_key_type> > _witness_key_cache;
 
@@ -118,6 +129,9 @@ private:
    void schedule_commit_reveal();
    void broadcast_commit(const chain::account_id_type& acc_id);
    void broadcast_reveal(const chain::account_id_type& acc_id);
+   /// Signs @p tx on the signing thread and broadcasts it
+   void sign_and_broadcast( protocol::signed_transaction& tx, const fc::ecc::private_key& key,
+                            const chain_id_type& chain_id );
    fc::optional< fc::ecc::private_key > get_witness_private_key( const chain::account_object& acc ) const; // before HF 12
    fc::optional< fc::ecc::private_key > get_witness_private_key( const public_key_type& public_key ) const;
 
@@ -126,10 +140,13 @@ private:
    fc::flat_map< account_id_type, witness_id_type > _witness_account;
    fc::flat_map< account_id_type, uint64_t > _reveal_value;             // witness-> bid
    fc::flat_map< account_id_type, std::string > _reveal_hash;           // witness-> hash
-   // block, witness, requires processing
-   std::vector<std::tuple<uint64_t, account_id_type, bool>> _commit_schedule;
-   // block, witness, requires processing
-   std::vector<std::tuple<uint64_t, account_id_type, bool>> _reveal_schedule;
+   commit_reveal_schedule _commit_schedule;
+   /// The reveal slots count from the beginning of the reveal interval
+   commit_reveal_schedule _reveal_schedule;
+   /// The commit and reveal operations of the last applied block, done after the block has been handled
+   fc::future<void> _commit_reveal_task;
+   /// Signs the commit and reveal transactions, so that the main thread can go on meanwhile
+   std::shared_ptr<fc::thread> _signing_thread;
 };
 
 } } //graphene::witness_plugin
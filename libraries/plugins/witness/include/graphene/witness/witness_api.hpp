@@ -0,0 +1,59 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <graphene/witness/production_profile.hpp>
+
+#include <fc/api.hpp>
+
+namespace graphene { namespace app {
+class application;
+} }
+
+namespace graphene { namespace witness_plugin {
+
+/**
+ * @brief Access to the block production statistics of the witness plugin
+ */
+class witness_api
+{
+   public:
+      witness_api( graphene::app::application& app );
+
+      /**
+       * @brief Get the latency histograms of block production on this node
+       * @return Histograms of the production steps since the node was started or the profile was reset
+       */
+      block_production_profile get_block_production_profile()const;
+
+      /**
+       * @brief Clear the block production statistics
+       */
+      void reset_block_production_profile();
+
+   private:
+      graphene::app::application& _app;
+};
+
+} } // graphene::witness_plugin
+
+FC_API( graphene::witness_plugin::witness_api,
+        (get_block_production_profile)
+        (reset_block_production_profile)
+      )
@@ -0,0 +1,59 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <graphene/witness/production_profile.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace witness_plugin {
+
+const std::vector<uint32_t>& latency_histogram::bucket_bounds_ms()
+{
+   static const std::vector<uint32_t> bounds = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000 };
+   return bounds;
+}
+
+void latency_histogram::add( const fc::microseconds& duration )
+{
+   const uint64_t us = std::max<int64_t>( duration.count(), 0 );
+   const auto& bounds = bucket_bounds_ms();
+   const size_t bucket = std::lower_bound( bounds.begin(), bounds.end(), ( us + 999 ) / 1000 ) - bounds.begin();
+   ++counts[bucket];
+   ++samples;
+   total_us += us;
+   max_us = std::max( max_us, us );
+}
+
+uint32_t latency_histogram::percentile_ms( uint32_t percent )const
+{
+   if( samples == 0 )
+      return 0;
+   const uint64_t wanted = ( samples * percent + 99 ) / 100;
+   uint64_t seen = 0;
+   const auto& bounds = bucket_bounds_ms();
+   for( size_t i = 0; i < bounds.size(); ++i )
+   {
+      seen += counts[i];
+      if( seen >= wanted )
+         return bounds[i];
+   }
+   // the last bucket is open, report the maximum instead
+   return ( max_us + 999 ) / 1000;
+}
+
+} } // graphene::witness_plugin
@@ -90,6 +90,17 @@ void witness_plugin::plugin_set_program_options(
           " This option may be specified multiple times, thus multiple files can be provided.")
          ("user-provided-seed", bpo::value<uint64_t>(),
                "A random number that will be used by a pseudo-random number generator as a source of entropy")
+         ("production-profile-log-interval", bpo::value<uint32_t>()->default_value(100),
+               "Log the latency histograms of block production every this number of produced blocks, 0 to disable")
+         ("block-packing-time-budget", bpo::value<uint32_t>()->default_value(0),
+               "Maximum time in milliseconds spent on applying pending transactions when producing a block, "
+               "0 for no limit")
+         ("transaction-cost-budget", bpo::value<uint32_t>()->default_value(0),
+               "Defer transactions whose estimated application time in milliseconds exceeds this when producing "
+               "a block, except one per block, 0 for no limit")
+         ("speculative-block-assembly", bpo::bool_switch()->default_value(false),
+               "Keep the pending transactions as the candidate of the next block and pack them without applying "
+               "them again when it is time to produce, if they are all still valid")
          ;
    config_file_options.add(command_line_options);
 }
@@ -173,6 +184,20 @@ void witness_plugin::plugin_initialize(const boost::program_options::variables_m
        else if(required_participation > 90)
            wlog("witness plugin: Warning - High required participation of ${rp}% found", ("rp", required_participation));
    }
+   if(options.count("production-profile-log-interval") > 0)
+      _production_profile_log_interval = options["production-profile-log-interval"].as<uint32_t>();
+   {
+      uint32_t packing_budget_ms = 0;
+      uint32_t transaction_budget_ms = 0;
+      if(options.count("block-packing-time-budget") > 0)
+         packing_budget_ms = options["block-packing-time-budget"].as<uint32_t>();
+      if(options.count("transaction-cost-budget") > 0)
+         transaction_budget_ms = options["transaction-cost-budget"].as<uint32_t>();
+      database().set_block_packing_budget( fc::milliseconds( packing_budget_ms ),
+                                           fc::milliseconds( transaction_budget_ms ) );
+   }
+   if(options.count("speculative-block-assembly") > 0)
+      database().set_speculative_block_assembly( options["speculative-block-assembly"].as<bool>() );
    if(options.count("user-provided-seed") > 0)
    {
       uint64_t user_provided_seed = options["user-provided-seed"].as<uint64_t>();
@@ -220,8 +245,24 @@ void witness_plugin::plugin_startup()
 
    _network_broadcast_api = std::make_shared< app::network_broadcast_api >( std::ref( app() ) );
 
+   if( !_witnesses.empty() )
+      _signing_thread = std::make_shared<fc::thread>( "witness signing" );
+
    database().applied_block.connect([this](const signed_block &b) {
-      commit_reveal_operations();
+      // Not within the handling of the block, which includes broadcasting it if it was produced here.
+      // If the operations of an earlier block are still being done, the next block catches up.
+      if( _witness_accounts.empty() || !_production_enabled || _shutting_down
+            || ( _commit_reveal_task.valid() && !_commit_reveal_task.ready() ) )
+         return;
+      _commit_reveal_task = fc::async( [this]() {
+         try {
+            commit_reveal_operations();
+         } catch( const fc::canceled_exception& ) {
+            throw;
+         } catch( const fc::exception& e ) {
+            elog( "Failed to do commit/reveal operations: ${e}", ("e", e.to_detail_string()) );
+         }
+      }, "witness commit reveal" );
    });
 
    ilog("witness plugin:  plugin_startup() end");
@@ -244,6 +285,19 @@ void witness_plugin::check_resources() {
    _witness_accounts.swap(masters);
 }
 
+void witness_plugin::cleanup()
+{
+   stop_block_production();
+   try {
+      if( _commit_reveal_task.valid() )
+         _commit_reveal_task.cancel_and_wait( __FUNCTION__ );
+   } catch( fc::canceled_exception& ) {
+   } catch( fc::exception& e ) {
+      edump( (e.to_detail_string()) );
+   }
+   _signing_thread.reset();
+}
+
 void witness_plugin::stop_block_production()
 {
    _shutting_down = true;
@@ -318,12 +372,10 @@ void witness_plugin::commit_reveal_operations() {
       // --------------- //
 
       // Even if the required block was skipped, the operation will be executed.
-      for (auto& op: _commit_schedule) {
-         if (get<0>(op) > maintenance_block_id) return; // block
-         if (get<2>(op)) {                   // requires processing
-            broadcast_commit(get<1>(op));    // witness
-            get<2>(op) = false;
-         }
+      for( auto acc = _commit_schedule.next_due( maintenance_block_id ); acc.valid();
+           acc = _commit_schedule.next_due( maintenance_block_id ) ) {
+         broadcast_commit(*acc);
+         _commit_schedule.pop();
       }
       return;
    }
@@ -333,12 +385,11 @@ void witness_plugin::commit_reveal_operations() {
    // --------------- //
 
    // Even if the required block was skipped, the operation will be executed.
-   for (auto &op : _reveal_schedule) {
-      if (get<0>(op) > maintenance_block_id - total_blocks / 2) return; // block
-      if (get<2>(op)) {                   // requires processing
-         broadcast_reveal(get<1>(op));    // witness
-         get<2>(op) = false;
-      }
+   const uint32_t reveal_block_id = maintenance_block_id - total_blocks / 2;
+   for( auto acc = _reveal_schedule.next_due( reveal_block_id ); acc.valid();
+        acc = _reveal_schedule.next_due( reveal_block_id ) ) {
+      broadcast_reveal(*acc);
+      _reveal_schedule.pop();
    }
 
 }
@@ -354,44 +405,38 @@ void witness_plugin::schedule_commit_reveal() {
    // numer of blocks between 2 maintenances
    int32_t blocks = static_cast<int32_t>(gpo.parameters.maintenance_interval / gpo.parameters.block_interval);
 
-   // Use uniform distribution for the commit operations.
-   // For:
+   // The commit operations are spread over the commit interval, and the reveal operations over the reveal
+   // interval. For:
    // {
    //    "block_interval": 5,
    //    "maintenance_interval": 300,
    //    "maintenance_skip_slots": 3,
    // }
-   // commit interval shoud be from the 3-th to the 29-th blocks
-   int32_t skip_blocks = static_cast<int32_t>(gpo.parameters.maintenance_skip_slots);
-   std::uniform_int_distribution<int32_t> unidist {skip_blocks, blocks/2 - 1};
-
-   // Use binomial distribution for the reveal operations.
-   // For:
-   // {
-   //    "block_interval": 5,
-   //    "maintenance_interval": 300,
-   //    "maintenance_skip_slots": 3,
-   // }
-   // reveal interval shoud be from the 30-th to the 59-th blocks
-   std::binomial_distribution<> bindist{blocks/2 - 1, 0.8};
+   // commit interval shoud be from the 3-th to the 29-th blocks,
+   // reveal interval shoud be from the 30-th to the 59-th blocks.
+   // The active witnesses of all nodes are placed in the same order, derived from the maintenance time,
+   // so that no block gets more than its share of them.
+   const auto& dgpo = db.get_dynamic_global_properties();
+   std::vector< account_id_type > participants;
+   participants.reserve( gpo.active_witnesses.size() );
+   for( const auto& wit_id : gpo.active_witnesses )
+      participants.push_back( wit_id(db).witness_account );
 
-   _commit_schedule.clear();
-   _reveal_schedule.clear();
-   for (const auto& acc_id: _witness_accounts){
-      _commit_schedule.emplace_back(unidist(gen), acc_id, true);
-      _reveal_schedule.emplace_back(bindist(gen), acc_id, true);
-   }
-   sort(_commit_schedule.begin(), _commit_schedule.end());
-   sort(_reveal_schedule.begin(), _reveal_schedule.end());
+   int32_t skip_blocks = static_cast<int32_t>(gpo.parameters.maintenance_skip_slots);
+   const uint32_t maintenance_time = dgpo.next_maintenance_time.sec_since_epoch();
+   _commit_schedule.reset( participants, _witness_accounts, skip_blocks, std::max( blocks/2 - skip_blocks, 1 ),
+                           fc::sha256::hash( "commit" + std::to_string( maintenance_time ) ) );
+   _reveal_schedule.reset( participants, _witness_accounts, 0, std::max( blocks/2, 1 ),
+                           fc::sha256::hash( "reveal" + std::to_string( maintenance_time ) ) );
 
    /*
    // DEBUG
    ilog("Scheduled commits:");
-   for (const auto& it: _commit_schedule)
-      ilog("    ${blc} -> ${nme}(${acc})", ("blc", get<0>(it))("nme", get<1>(it)(db).name)("acc", get<1>(it)));
+   for (const auto& it: _commit_schedule.entries())
+      ilog("    ${blc} -> ${nme}(${acc})", ("blc", it.first)("nme", it.second(db).name)("acc", it.second));
    ilog("Scheduled reveals:");
-   for (const auto& it: _reveal_schedule)
-      ilog("    ${blc} -> ${nme}(${acc})", ("blc", get<0>(it) + blocks/2)("nme", get<1>(it)(db).name)("acc", get<1>(it)));
+   for (const auto& it: _reveal_schedule.entries())
+      ilog("    ${blc} -> ${nme}(${acc})", ("blc", it.first + blocks/2)("nme", it.second(db).name)("acc", it.second));
    */
 }
 
@@ -548,17 +593,8 @@ void witness_plugin::broadcast_commit(const chain::account_id_type& acc_id) {
          :
          get_witness_private_key(*acc_itr);
 
-      if (pkey.valid()) {
-         tx.sign(*pkey, chain_props.chain_id);
-         try {
-            _network_broadcast_api->broadcast_transaction(tx);
-         }
-         catch (const fc::exception &e) {
-            elog("Caught exception while broadcasting tx ${id}:  ${e}",
-                  ("id", tx.id().str())("e", e.to_detail_string()));
-            throw;
-         }
-      }
+      if (pkey.valid())
+         sign_and_broadcast(tx, *pkey, chain_props.chain_id);
    }
 }
 
@@ -741,17 +777,25 @@ void witness_plugin::broadcast_reveal(const chain::account_id_type& acc_id) {
          :
          get_witness_private_key(*acc_itr);
 
-      if (pkey.valid()) {
-         tx.sign(*pkey, chain_props.chain_id);
-         try {
-            _network_broadcast_api->broadcast_transaction(tx);
-         }
-         catch (const fc::exception &e) {
-            elog("Caught exception while broadcasting tx ${id}:  ${e}",
-                  ("id", tx.id().str())("e", e.to_detail_string()));
-            throw;
-         }
-      }
+      if (pkey.valid())
+         sign_and_broadcast(tx, *pkey, chain_props.chain_id);
+   }
+}
+
+void witness_plugin::sign_and_broadcast( protocol::signed_transaction& tx, const fc::ecc::private_key& key,
+                                         const chain_id_type& chain_id )
+{
+   if( _signing_thread )
+      _signing_thread->async( [&tx,&key,&chain_id]() { tx.sign( key, chain_id ); }, "sign commit reveal" ).wait();
+   else
+      tx.sign( key, chain_id );
+   try {
+      _network_broadcast_api->broadcast_transaction(tx);
+   }
+   catch (const fc::exception &e) {
+      elog("Caught exception while broadcasting tx ${id}:  ${e}",
+            ("id", tx.id().str())("e", e.to_detail_string()));
+      throw;
    }
 }
 
@@ -917,6 +961,7 @@ block_production_condition::block_production_condition_enum witness_plugin::mayb
    if( p2p_node() == nullptr )
       return block_production_condition::no_network;
 
+   const fc::time_point production_start = fc::time_point::now();
    auto block = db.generate_block(
       scheduled_time,
       scheduled_witness,
@@ -924,7 +969,39 @@ block_production_condition::block_production_condition_enum witness_plugin::mayb
       _production_skip_flags
       );
    capture("n", block.block_num())("t", block.timestamp)("c", now)("x", block.transactions.size());
-   fc::async( [this,block](){ p2p_node()->broadcast(net::block_message(block)); } );
+
+   const auto& timings = db.get_last_block_generation_timings();
+   ++_production_profile.blocks_produced;
+   if( timings.from_pending_state )
+      ++_production_profile.blocks_from_pending_state;
+   _production_profile.wake_up.add( production_start - fc::time_point( scheduled_time ) );
+   _production_profile.packing.add( timings.packing );
+   _production_profile.signing.add( timings.signing );
+   _production_profile.pushing.add( timings.pushing );
+   fc::async( [this,block,production_start](){
+      const fc::time_point broadcast_start = fc::time_point::now();
+      p2p_node()->broadcast(net::block_message(block));
+      const fc::time_point broadcast_end = fc::time_point::now();
+      _production_profile.broadcast.add( broadcast_end - broadcast_start );
+      _production_profile.total.add( broadcast_end - production_start );
+      if( _production_profile_log_interval > 0
+            && _production_profile.blocks_produced % _production_profile_log_interval == 0 )
+         log_production_profile();
+   } );
 
    return block_production_condition::produced;
 }
+
+void witness_plugin::log_production_profile()const
+{
+   const auto& p = _production_profile;
+   auto describe = []( const latency_histogram& h ) {
+      return fc::mutable_variant_object()( "mean_ms", h.mean_us() / 1000.0 )( "p50_ms", h.percentile_ms( 50 ) )
+                                         ( "p90_ms", h.percentile_ms( 90 ) )( "max_ms", h.max_us / 1000.0 );
+   };
+   ilog( "Block production profile after ${n} blocks (${sp} packed from the pending state): wake up ${w}, "
+         "packing ${pk}, signing ${s}, pushing ${pu}, broadcast ${b}, total ${t}",
+         ("n", p.blocks_produced)("sp", p.blocks_from_pending_state)("w", describe( p.wake_up ))("pk", describe( p.packing ))
+         ("s", describe( p.signing ))("pu", describe( p.pushing ))("b", describe( p.broadcast ))
+         ("t", describe( p.total )) );
+}
@@ -0,0 +1,42 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <graphene/witness/witness_api.hpp>
+#include <graphene/witness/witness.hpp>
+
+#include <graphene/app/application.hpp>
+
+namespace graphene { namespace witness_plugin {
+
+witness_api::witness_api( graphene::app::application& app ) : _app( app ) {}
+
+block_production_profile witness_api::get_block_production_profile()const
+{
+   auto plugin = _app.get_plugin<witness_plugin>( "witness" );
+   FC_ASSERT( plugin, "Witness plugin is not enabled" );
+   return plugin->get_block_production_profile();
+}
+
+void witness_api::reset_block_production_profile()
+{
+   auto plugin = _app.get_plugin<witness_plugin>( "witness" );
+   FC_ASSERT( plugin, "Witness plugin is not enabled" );
+   plugin->reset_block_production_profile();
+}
+
+} } // graphene::witness_plugin
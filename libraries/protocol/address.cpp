@@ -22,6 +22,7 @@
  * THE SOFTWARE.
  */
 #include <graphene/protocol/address.hpp>
+#include <graphene/protocol/base58.hpp>
 #include <graphene/protocol/pts_address.hpp>
 #include <fc/crypto/base58.hpp>
 #include <algorithm>
@@ -94,7 +95,7 @@ namespace graphene { namespace protocol {
         memcpy( bin_addr, addr.data(), sizeof(addr) );
         auto checksum = fc::ripemd160::hash( addr.data(), sizeof(addr) );
         memcpy( bin_addr + sizeof(addr), (char*)&checksum._hash[0], 4 );
-        return GRAPHENE_ADDRESS_PREFIX + fc::to_base58( bin_addr, sizeof(bin_addr) );
+        return GRAPHENE_ADDRESS_PREFIX + encode_base58( bin_addr, sizeof(bin_addr) );
    }
 
 } } // namespace graphene::protocol
@@ -0,0 +1,72 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <graphene/protocol/base58.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace graphene { namespace protocol {
+
+std::string encode_base58( const char* data, size_t size )
+{
+   static const char alphabet[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+   static const uint32_t limb_base = 58 * 58 * 58 * 58 * 58;
+
+   // every leading zero byte is encoded as a leading 1
+   size_t zeroes = 0;
+   while( zeroes < size && data[zeroes] == 0 )
+      ++zeroes;
+
+   // the number in base 58^5, least significant limb first, log(256) / log(58^5) is less than 0.28
+   std::vector<uint32_t> limbs;
+   limbs.reserve( ( size - zeroes ) * 28 / 100 + 1 );
+   for( size_t i = zeroes; i < size; ++i )
+   {
+      uint64_t carry = static_cast<uint8_t>( data[i] );
+      for( uint32_t& limb : limbs )
+      {
+         carry += uint64_t( limb ) << 8;
+         limb = static_cast<uint32_t>( carry % limb_base );
+         carry /= limb_base;
+      }
+      while( carry > 0 )
+      {
+         limbs.push_back( static_cast<uint32_t>( carry % limb_base ) );
+         carry /= limb_base;
+      }
+   }
+
+   // digits, least significant first
+   std::string digits;
+   digits.reserve( limbs.size() * 5 );
+   for( uint32_t limb : limbs )
+      for( int i = 0; i < 5; ++i )
+      {
+         digits.push_back( alphabet[ limb % 58 ] );
+         limb /= 58;
+      }
+   while( !digits.empty() && digits.back() == alphabet[0] )
+      digits.pop_back();
+
+   std::string result( zeroes, alphabet[0] );
+   result.append( digits.rbegin(), digits.rend() );
+   return result;
+}
+
+} } // graphene::protocol
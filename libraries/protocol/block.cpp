@@ -79,7 +79,20 @@ namespace graphene { namespace protocol {
          ids.resize( transactions.size() );
          for( uint32_t i = 0; i < transactions.size(); ++i )
             ids[i] = transactions[i].merkle_digest();
+         calculate_merkle_root( std::move( ids ) );
+      }
+      return _calculated_merkle_root;
+   }
 
+   const checksum_type& signed_block::calculate_merkle_root( vector<digest_type>&& ids )const
+   {
+      static const checksum_type empty_checksum;
+      if( transactions.size() == 0 ) 
+         return empty_checksum;
+
+      if( !_calculated_merkle_root._hash[0].value() )
+      {
+         FC_ASSERT( ids.size() == transactions.size(), "Need one merkle leaf per transaction" );
          vector<digest_type>::size_type current_number_of_hashes = ids.size();
          while( current_number_of_hashes > 1 )
          {
@@ -98,6 +111,55 @@ namespace graphene { namespace protocol {
       }
       return _calculated_merkle_root;
    }
+
+   vector<vector<digest_type>> merkle_proof::calculate_tree( vector<digest_type>&& leaves )
+   {
+      vector<vector<digest_type>> tree;
+      tree.push_back( std::move( leaves ) );
+      while( tree.back().size() > 1 )
+      {
+         const vector<digest_type>& level = tree.back();
+         vector<digest_type> next;
+         next.reserve( ( level.size() + 1 ) / 2 );
+         for( size_t i = 0; i + 1 < level.size(); i += 2 )
+            next.push_back( digest_type::hash( std::make_pair( level[i], level[i+1] ) ) );
+         if( level.size() & 1 )
+            next.push_back( level.back() );
+         tree.push_back( std::move( next ) );
+      }
+      return tree;
+   }
+
+   merkle_proof::merkle_proof( const vector<vector<digest_type>>& tree, uint32_t trx )
+   : trx_in_block( trx )
+   {
+      FC_ASSERT( !tree.empty() && trx < tree.front().size(), "No transaction ${t} in the block", ("t", trx) );
+      transaction_count = tree.front().size();
+      for( size_t l = 0; l + 1 < tree.size(); ++l, trx >>= 1 )
+      {
+         const uint32_t sibling = trx ^ 1;
+         if( sibling < tree[l].size() )
+            branch.push_back( tree[l][sibling] );
+      }
+   }
+
+   checksum_type merkle_proof::calculate_merkle_root( const digest_type& leaf )const
+   {
+      FC_ASSERT( trx_in_block < transaction_count, "Invalid transaction number" );
+      digest_type node = leaf;
+      auto sibling = branch.begin();
+      for( uint32_t i = trx_in_block, count = transaction_count; count > 1; i >>= 1, count = ( count + 1 ) / 2 )
+      {
+         if( ( i ^ 1 ) >= count ) // carried up
+            continue;
+         FC_ASSERT( sibling != branch.end(), "The branch of the proof is too short" );
+         node = ( i & 1 ) ? digest_type::hash( std::make_pair( *sibling, node ) )
+                          : digest_type::hash( std::make_pair( node, *sibling ) );
+         ++sibling;
+      }
+      FC_ASSERT( sibling == branch.end(), "The branch of the proof is too long" );
+      return checksum_type::hash( node );
+   }
 } }
 
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::protocol::block_header)
@@ -0,0 +1,34 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace graphene { namespace protocol {
+
+   /**
+    * @brief Encodes binary data in base58, same as fc::to_base58()
+    *
+    * Public keys and addresses are encoded whenever they are converted to variants, e.g. in API results, so the
+    * encoding works on base 58^5 limbs instead of single digits.
+    */
+   std::string encode_base58( const char* data, size_t size );
+
+} } // graphene::protocol
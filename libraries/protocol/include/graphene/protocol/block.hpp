@@ -60,16 +60,47 @@ namespace graphene { namespace protocol {
    {
    public:
       const checksum_type& calculate_merkle_root()const;
+      /**
+       * @brief Same as @ref calculate_merkle_root, with the leaves already computed, E.G. in parallel
+       * @param leaves The @ref processed_transaction::merkle_digest of every transaction, in order
+       */
+      const checksum_type& calculate_merkle_root( vector<digest_type>&& leaves )const;
       vector<processed_transaction> transactions;
    protected:
       mutable checksum_type   _calculated_merkle_root;
    };
 
+   /**
+    * @brief The hashes which link a transaction to the transaction merkle root of its block
+    *
+    * The merkle tree of a block hashes the merkle digests of its transactions in pairs, level by level, as
+    * @ref signed_block::calculate_merkle_root does. The last node of a level with an odd number of nodes is carried
+    * up unchanged.
+    */
+   struct merkle_proof
+   {
+      /// The levels of the merkle tree of @p leaves, the leaves first and the top node last
+      static vector<vector<digest_type>> calculate_tree( vector<digest_type>&& leaves );
+
+      merkle_proof() = default;
+      /// The proof of the leaf @p trx_in_block of @p tree, as returned by @ref calculate_tree
+      merkle_proof( const vector<vector<digest_type>>& tree, uint32_t trx_in_block );
+
+      /// The transaction merkle root of a block with a transaction of merkle digest @p leaf at @ref trx_in_block
+      checksum_type calculate_merkle_root( const digest_type& leaf )const;
+
+      uint32_t            trx_in_block = 0;
+      uint32_t            transaction_count = 0;
+      /// The sibling of the node on each level from the leaf up, levels where the node is carried up are skipped
+      vector<digest_type> branch;
+   };
+
 } } // graphene::protocol
 
 FC_REFLECT( graphene::protocol::block_header, (previous)(timestamp)(witness)(transaction_merkle_root)(extensions) )
 FC_REFLECT_DERIVED( graphene::protocol::signed_block_header, (graphene::protocol::block_header), (witness_signature) )
 FC_REFLECT_DERIVED( graphene::protocol::signed_block, (graphene::protocol::signed_block_header), (transactions) )
+FC_REFLECT( graphene::protocol::merkle_proof, (trx_in_block)(transaction_count)(branch) )
 
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::protocol::block_header)
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::protocol::signed_block_header)
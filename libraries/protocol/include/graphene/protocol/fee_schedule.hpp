@@ -34,12 +34,29 @@ namespace graphene { namespace protocol {
    };
    using fee_parameters = transform_to_fee_parameters<operation>::type;
 
+   /**
+    * Finds the fee parameters of type @p T. The set is sorted by type and usually contains all types, so the
+    * parameters are first looked for at the position of their type, which saves the binary search.
+    */
+   template<typename T>
+   fee_parameters::flat_set_type::const_iterator find_fee_parameters( const fee_parameters::flat_set_type& parameters )
+   {
+      const auto which = fee_parameters::tag<T>::value;
+      if( static_cast<size_t>( which ) < parameters.size() )
+      {
+         auto itr = parameters.begin() + which;
+         if( itr->which() == which )
+            return itr;
+      }
+      return parameters.find( T() );
+   }
+
    template<typename Operation>
    class fee_helper {
      public:
       const typename Operation::fee_parameters_type& cget(const fee_parameters::flat_set_type& parameters)const
       {
-         auto itr = parameters.find( typename Operation::fee_parameters_type() );
+         auto itr = find_fee_parameters< typename Operation::fee_parameters_type >( parameters );
          FC_ASSERT( itr != parameters.end() );
          return itr->template get<typename Operation::fee_parameters_type>();
       }
@@ -50,7 +67,7 @@ namespace graphene { namespace protocol {
      public:
       const account_create_operation::fee_parameters_type& cget(const fee_parameters::flat_set_type& parameters)const
       {
-         auto itr = parameters.find( account_create_operation::fee_parameters_type() );
+         auto itr = find_fee_parameters< account_create_operation::fee_parameters_type >( parameters );
          FC_ASSERT( itr != parameters.end() );
          return itr->get<account_create_operation::fee_parameters_type>();
       }
@@ -67,7 +84,7 @@ namespace graphene { namespace protocol {
      public:
       const asset_update_issuer_operation::fee_parameters_type& cget(const fee_parameters::flat_set_type& parameters)const
       {
-         auto itr = parameters.find( asset_update_issuer_operation::fee_parameters_type() );
+         auto itr = find_fee_parameters< asset_update_issuer_operation::fee_parameters_type >( parameters );
          if ( itr != parameters.end() )
             return itr->get<asset_update_issuer_operation::fee_parameters_type>();
 
@@ -82,7 +99,7 @@ namespace graphene { namespace protocol {
      public:
       const asset_claim_pool_operation::fee_parameters_type& cget(const fee_parameters::flat_set_type& parameters)const
       {
-         auto itr = parameters.find( asset_claim_pool_operation::fee_parameters_type() );
+         auto itr = find_fee_parameters< asset_claim_pool_operation::fee_parameters_type >( parameters );
          if ( itr != parameters.end() )
             return itr->get<asset_claim_pool_operation::fee_parameters_type>();
 
@@ -117,7 +134,7 @@ namespace graphene { namespace protocol {
      public:
       const htlc_create_operation::fee_parameters_type& cget(const fee_parameters::flat_set_type& parameters)const
       {
-         auto itr = parameters.find( htlc_create_operation::fee_parameters_type() );
+         auto itr = find_fee_parameters< htlc_create_operation::fee_parameters_type >( parameters );
          if ( itr != parameters.end() )
             return itr->get<htlc_create_operation::fee_parameters_type>();
 
@@ -131,7 +148,7 @@ namespace graphene { namespace protocol {
      public:
       const htlc_redeem_operation::fee_parameters_type& cget(const fee_parameters::flat_set_type& parameters)const
       {
-         auto itr = parameters.find( htlc_redeem_operation::fee_parameters_type() );
+         auto itr = find_fee_parameters< htlc_redeem_operation::fee_parameters_type >( parameters );
          if ( itr != parameters.end() )
             return itr->get<htlc_redeem_operation::fee_parameters_type>();
 
@@ -144,7 +161,7 @@ namespace graphene { namespace protocol {
      public:
       const htlc_extend_operation::fee_parameters_type& cget(const fee_parameters::flat_set_type& parameters)const
       {
-         auto itr = parameters.find( htlc_extend_operation::fee_parameters_type() );
+         auto itr = find_fee_parameters< htlc_extend_operation::fee_parameters_type >( parameters );
          if ( itr != parameters.end() )
             return itr->get<htlc_extend_operation::fee_parameters_type>();
 
@@ -195,7 +212,7 @@ namespace graphene { namespace protocol {
       template<typename Operation>
       bool exists()const
       {
-         auto itr = parameters.find(typename Operation::fee_parameters_type());
+         auto itr = find_fee_parameters< typename Operation::fee_parameters_type >( parameters );
          return itr != parameters.end();
       }
 
@@ -213,6 +213,28 @@ namespace graphene { namespace protocol {
        */
       virtual const flat_set<public_key_type>& get_signature_keys( const chain_id_type& chain_id )const;
 
+      /// Recovers the public key which created a signature for a digest
+      typedef std::function<public_key_type(const signature_type&, const digest_type&)> key_recoverer;
+
+      /**
+       * @brief Extract public keys from signatures with given chain ID, using a custom recovery function
+       * @param chain_id A chain ID
+       * @param recover The function to recover a key from a signature, E.G. a cached one
+       * @return Public keys
+       * @note @ref _signees is always recomputed, as in the single argument version
+       */
+      const flat_set<public_key_type>& get_signature_keys( const chain_id_type& chain_id,
+                                                           const key_recoverer& recover )const;
+
+      /**
+       * @brief Extract public keys from signatures of a precomputed digest, and store them into @ref _signees
+       * @param digest The result of @ref sig_digest with the chain ID
+       * @param recover The function to recover a key from a signature, it is called for the signatures in order
+       * @return Public keys
+       */
+      const flat_set<public_key_type>& extract_signature_keys( const digest_type& digest,
+                                                               const key_recoverer& recover )const;
+
       /** Signatures */
       vector<signature_type> signatures;
 
@@ -237,11 +259,25 @@ namespace graphene { namespace protocol {
       precomputable_transaction( signed_transaction&& tx ) : signed_transaction( std::move(tx) ) {};
       virtual ~precomputable_transaction() = default;
 
+      typedef std::function<bool(const transaction_id_type&)> validity_lookup;
+
       virtual const transaction_id_type&       id()const override;
       virtual void                             validate()const override;
+      /// Same as @ref validate, but takes the transaction as valid if @p is_known_valid returns true for its ID
+      void                                     validate( const validity_lookup& is_known_valid )const;
       virtual const flat_set<public_key_type>& get_signature_keys( const chain_id_type& chain_id )const override;
+      /// Same as the single argument version, but recovers the keys with @p recover if they are not cached yet
+      const flat_set<public_key_type>&         get_signature_keys( const chain_id_type& chain_id,
+                                                                   const key_recoverer& recover )const;
       virtual uint64_t                         get_packed_size()const override;
    protected:
+      /**
+       * @brief Packs the transaction once, and fills the cached ID and packed size from the packed bytes
+       * @param chain_id If not null, also hash the bytes with this chain ID
+       * @return The result of @ref sig_digest with @p chain_id if it is given, an empty digest otherwise
+       */
+      digest_type cache_digests( const chain_id_type* chain_id )const;
+
       mutable bool _validated = false;
       mutable uint64_t _packed_size = 0;
    };
@@ -276,6 +312,22 @@ namespace graphene { namespace protocol {
                           const flat_set<account_id_type>& active_approvals = flat_set<account_id_type>(),
                           const flat_set<account_id_type>& owner_approvals = flat_set<account_id_type>() );
 
+   /**
+    * Same as @ref verify_authority, but returns false instead of throwing when the operations are not authorized,
+    * which avoids building the exception and its captured context. Exceptions thrown by the callbacks still
+    * propagate.
+    */
+   bool is_authorized( const vector<operation>& ops, const flat_set<public_key_type>& sigs,
+                       const std::function<const authority*(account_id_type)>& get_active,
+                       const std::function<const authority*(account_id_type)>& get_owner,
+                       const custom_authority_lookup& get_custom,
+                       bool allow_non_immediate_owner,
+                       bool ignore_custom_operation_required_auths,
+                       uint32_t max_recursion = GRAPHENE_MAX_SIG_CHECK_DEPTH,
+                       bool allow_committee = false,
+                       const flat_set<account_id_type>& active_approvals = flat_set<account_id_type>(),
+                       const flat_set<account_id_type>& owner_approvals = flat_set<account_id_type>() );
+
    /**
     *  @brief captures the result of evaluating the operations contained in the transaction
     *
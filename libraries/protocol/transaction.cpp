@@ -266,7 +266,18 @@ struct sign_state
 };
 
 
-void verify_authority( const vector<operation>& ops, const flat_set<public_key_type>& sigs,
+/// Like GRAPHENE_ASSERT if @p throw_on_failure is set, otherwise returns false from the enclosing function
+#define GRAPHENE_AUTHORITY_ASSERT( expr, exc_type, FORMAT, ... )     \
+   FC_MULTILINE_MACRO_BEGIN                                           \
+   if( !(expr) )                                                      \
+   {                                                                  \
+      if( throw_on_failure )                                          \
+         FC_THROW_EXCEPTION( exc_type, FORMAT, __VA_ARGS__ );         \
+      return false;                                                   \
+   }                                                                  \
+   FC_MULTILINE_MACRO_END
+
+static bool check_authority_of_operations( const vector<operation>& ops, const flat_set<public_key_type>& sigs,
                        const std::function<const authority*(account_id_type)>& get_active,
                        const std::function<const authority*(account_id_type)>& get_owner,
                        const custom_authority_lookup& get_custom,
@@ -275,10 +286,10 @@ void verify_authority( const vector<operation>& ops, const flat_set<public_key_t
                        uint32_t max_recursion_depth,
                        bool  allow_committee,
                        const flat_set<account_id_type>& active_aprovals,
-                       const flat_set<account_id_type>& owner_approvals )
+                       const flat_set<account_id_type>& owner_approvals,
+                       rejected_predicate_map& rejected_custom_auths,
+                       bool throw_on_failure )
 {
-   rejected_predicate_map rejected_custom_auths;
-   try {
    flat_set<account_id_type> required_active;
    flat_set<account_id_type> required_owner;
    vector<authority> other;
@@ -289,9 +300,9 @@ void verify_authority( const vector<operation>& ops, const flat_set<public_key_t
    for( auto& id : owner_approvals )
       s.approved_by.insert( id );
 
-   auto approved_by_custom_authority = [&s, &rejected_custom_auths, get_custom = std::move(get_custom)](
+   auto approved_by_custom_authority = [&s, &rejected_custom_auths, &get_custom](
            account_id_type account,
-           operation op ) mutable {
+           const operation& op ) {
       auto viable_custom_auths = get_custom( account, op, &rejected_custom_auths );
       for( const auto& auth : viable_custom_auths )
          if( s.check_authority( &auth ) ) return true;
@@ -315,46 +326,97 @@ void verify_authority( const vector<operation>& ops, const flat_set<public_key_t
    }
 
    if( !allow_committee )
-      GRAPHENE_ASSERT( required_active.find(GRAPHENE_COMMITTEE_ACCOUNT) == required_active.end(),
+      GRAPHENE_AUTHORITY_ASSERT( required_active.find(GRAPHENE_COMMITTEE_ACCOUNT) == required_active.end(),
                        invalid_committee_approval, "Committee account may only propose transactions" );
 
    for( const auto& auth : other )
    {
-      GRAPHENE_ASSERT( s.check_authority(&auth), tx_missing_other_auth, "Missing Authority", ("auth",auth)("sigs",sigs) );
+      GRAPHENE_AUTHORITY_ASSERT( s.check_authority(&auth), tx_missing_other_auth, "Missing Authority",
+                                 ("auth",auth)("sigs",sigs) );
    }
 
    // fetch all of the top level authorities
    for( auto id : required_owner )
    {
-      GRAPHENE_ASSERT( owner_approvals.find(id) != owner_approvals.end() ||
+      GRAPHENE_AUTHORITY_ASSERT( owner_approvals.find(id) != owner_approvals.end() ||
                        s.check_authority(get_owner(id)),
                        tx_missing_owner_auth, "Missing Owner Authority ${id}", ("id",id)("auth",*get_owner(id)) );
    }
 
    for( auto id : required_active )
    {
-      GRAPHENE_ASSERT( s.check_authority(id) ||
+      GRAPHENE_AUTHORITY_ASSERT( s.check_authority(id) ||
                        s.check_authority(get_owner(id)),
                        tx_missing_active_auth, "Missing Active Authority ${id}",
                        ("id",id)("auth",*get_active(id))("owner",*get_owner(id)) );
    }
 
-   GRAPHENE_ASSERT(
+   GRAPHENE_AUTHORITY_ASSERT(
       !s.remove_unused_signatures(),
       tx_irrelevant_sig,
       "Unnecessary signature(s) detected"
       );
+   return true;
+}
+
+void verify_authority( const vector<operation>& ops, const flat_set<public_key_type>& sigs,
+                       const std::function<const authority*(account_id_type)>& get_active,
+                       const std::function<const authority*(account_id_type)>& get_owner,
+                       const custom_authority_lookup& get_custom,
+                       bool allow_non_immediate_owner,
+                       bool ignore_custom_operation_required_auths,
+                       uint32_t max_recursion_depth,
+                       bool  allow_committee,
+                       const flat_set<account_id_type>& active_aprovals,
+                       const flat_set<account_id_type>& owner_approvals )
+{
+   rejected_predicate_map rejected_custom_auths;
+   try {
+   check_authority_of_operations( ops, sigs, get_active, get_owner, get_custom, allow_non_immediate_owner,
+                                  ignore_custom_operation_required_auths, max_recursion_depth, allow_committee,
+                                  active_aprovals, owner_approvals, rejected_custom_auths, true );
 } FC_CAPTURE_AND_RETHROW( (rejected_custom_auths)(ops)(sigs) ) }
 
+bool is_authorized( const vector<operation>& ops, const flat_set<public_key_type>& sigs,
+                    const std::function<const authority*(account_id_type)>& get_active,
+                    const std::function<const authority*(account_id_type)>& get_owner,
+                    const custom_authority_lookup& get_custom,
+                    bool allow_non_immediate_owner,
+                    bool ignore_custom_operation_required_auths,
+                    uint32_t max_recursion_depth,
+                    bool  allow_committee,
+                    const flat_set<account_id_type>& active_aprovals,
+                    const flat_set<account_id_type>& owner_approvals )
+{
+   rejected_predicate_map rejected_custom_auths;
+   return check_authority_of_operations( ops, sigs, get_active, get_owner, get_custom, allow_non_immediate_owner,
+                                         ignore_custom_operation_required_auths, max_recursion_depth,
+                                         allow_committee, active_aprovals, owner_approvals, rejected_custom_auths,
+                                         false );
+}
+
 
 const flat_set<public_key_type>& signed_transaction::get_signature_keys( const chain_id_type& chain_id )const
+{
+   return get_signature_keys( chain_id, []( const signature_type& sig, const digest_type& d ) {
+      return public_key_type( fc::ecc::public_key( sig, d ) );
+   });
+}
+
+const flat_set<public_key_type>& signed_transaction::get_signature_keys( const chain_id_type& chain_id,
+                                                                         const key_recoverer& recover )const
+{
+   return extract_signature_keys( sig_digest( chain_id ), recover );
+}
+
+const flat_set<public_key_type>& signed_transaction::extract_signature_keys( const digest_type& d,
+                                                                             const key_recoverer& recover )const
 { try {
-   auto d = sig_digest( chain_id );
    flat_set<public_key_type> result;
    for( const auto&  sig : signatures )
    {
       GRAPHENE_ASSERT(
-         result.insert( fc::ecc::public_key(sig,d) ).second,
+         result.insert( recover(sig,d) ).second,
             tx_duplicate_sig,
             "Duplicate Signature detected" );
    }
@@ -431,10 +493,33 @@ set<public_key_type> signed_transaction::minimize_required_signatures(
    return set<public_key_type>( result.begin(), result.end() );
 }
 
+digest_type precomputable_transaction::cache_digests( const chain_id_type* chain_id )const
+{
+   const bool need_id = !_tx_id_buffer._hash[0].value();
+   if( chain_id == nullptr && !need_id && _packed_size != 0 )
+      return digest_type();
+
+   // the ID, the packed size and the signature digest are all derived from the same bytes, pack them only once
+   const std::vector<char> packed = fc::raw::pack( static_cast<const transaction&>( *this ) );
+   _packed_size = packed.size();
+   if( need_id )
+   {
+      const auto h = digest_type::hash( packed.data(), packed.size() );
+      memcpy(_tx_id_buffer._hash, h._hash, std::min(sizeof(_tx_id_buffer), sizeof(h)));
+   }
+   if( chain_id == nullptr )
+      return digest_type();
+
+   digest_type::encoder enc;
+   fc::raw::pack( enc, *chain_id );
+   enc.write( packed.data(), packed.size() );
+   return enc.result();
+}
+
 const transaction_id_type& precomputable_transaction::id()const
 {
    if( !_tx_id_buffer._hash[0].value() )
-      transaction::id();
+      cache_digests( nullptr );
    return _tx_id_buffer;
 }
 
@@ -445,10 +530,18 @@ void precomputable_transaction::validate() const
    _validated = true;
 }
 
+void precomputable_transaction::validate( const validity_lookup& is_known_valid )const
+{
+   if( _validated ) return;
+   if( !is_known_valid( id() ) )
+      transaction::validate();
+   _validated = true;
+}
+
 uint64_t precomputable_transaction::get_packed_size()const
 {
    if( _packed_size == 0 )
-      _packed_size = transaction::get_packed_size();
+      cache_digests( nullptr );
    return _packed_size;
 }
 
@@ -457,7 +550,17 @@ const flat_set<public_key_type>& precomputable_transaction::get_signature_keys(
    // Strictly we should check whether the given chain ID is same as the one used to initialize the `signees` field.
    // However, we don't pass in another chain ID so far, for better performance, we skip the check.
    if( _signees.empty() )
-      signed_transaction::get_signature_keys( chain_id );
+      extract_signature_keys( cache_digests( &chain_id ), []( const signature_type& sig, const digest_type& d ) {
+         return public_key_type( fc::ecc::public_key( sig, d ) );
+      });
+   return _signees;
+}
+
+const flat_set<public_key_type>& precomputable_transaction::get_signature_keys( const chain_id_type& chain_id,
+                                                                               const key_recoverer& recover )const
+{
+   if( _signees.empty() )
+      extract_signature_keys( cache_digests( &chain_id ), recover );
    return _signees;
 }
 
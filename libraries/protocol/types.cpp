@@ -23,6 +23,7 @@
  */
 
 #include <graphene/protocol/types.hpp>
+#include <graphene/protocol/base58.hpp>
 #include <graphene/protocol/fee_schedule.hpp>
 
 #include <fc/crypto/base58.hpp>
@@ -30,8 +31,69 @@
 #include <fc/exception/exception.hpp>
 #include <fc/io/raw.hpp>
 
+#include <array>
+#include <cstring>
+#include <mutex>
+
 namespace graphene { namespace protocol {
 
+namespace {
+
+/// Direct mapped cache of the strings of recently converted public keys
+class key_string_cache
+{
+   public:
+      static constexpr size_t slot_count = 4096;
+
+      bool get( const fc::ecc::public_key_data& key, std::string& str )
+      {
+         const size_t index = slot_index( key );
+         std::lock_guard<std::mutex> lock( _mutex );
+         const slot& s = _slots[index];
+         if( !s.used || s.key != key )
+            return false;
+         str = s.str;
+         return true;
+      }
+
+      void put( const fc::ecc::public_key_data& key, const std::string& str )
+      {
+         const size_t index = slot_index( key );
+         std::lock_guard<std::mutex> lock( _mutex );
+         slot& s = _slots[index];
+         s.used = true;
+         s.key = key;
+         s.str = str;
+      }
+
+   private:
+      struct slot
+      {
+         bool                       used = false;
+         fc::ecc::public_key_data   key;
+         std::string                str;
+      };
+
+      /// The first byte of a compressed key only holds its parity, the following ones are evenly distributed
+      static size_t slot_index( const fc::ecc::public_key_data& key )
+      {
+         uint32_t value;
+         memcpy( &value, key.data() + 1, sizeof(value) );
+         return value % slot_count;
+      }
+
+      std::mutex                       _mutex;
+      std::array<slot, slot_count>     _slots;
+};
+
+key_string_cache& get_key_string_cache()
+{
+   static key_string_cache cache;
+   return cache;
+}
+
+} // anonymous namespace
+
     public_key_type::public_key_type():key_data(){};
 
     public_key_type::public_key_type( const fc::ecc::public_key_data& data )
@@ -66,11 +128,16 @@ namespace graphene { namespace protocol {
 
     public_key_type::operator std::string() const
     {
+       std::string result;
+       if( get_key_string_cache().get( key_data, result ) )
+          return result;
        binary_key k;
        k.data = key_data;
        k.check = fc::ripemd160::hash( (char*) k.data.data(), k.data.size() )._hash[0].value();
        auto data = fc::raw::pack( k );
-       return GRAPHENE_ADDRESS_PREFIX + fc::to_base58( data.data(), data.size() );
+       result = GRAPHENE_ADDRESS_PREFIX + encode_base58( data.data(), data.size() );
+       get_key_string_cache().put( key_data, result );
+       return result;
     }
 
     bool operator == ( const public_key_type& p1, const fc::ecc::public_key& p2)
@@ -23,11 +23,14 @@
  */
 #include <graphene/utilities/elasticsearch.hpp>
 
-#include <boost/algorithm/string/join.hpp>
 #include <boost/algorithm/string.hpp>
 #include <fc/log/logger.hpp>
 #include <fc/io/json.hpp>
 
+#ifdef GRAPHENE_ES_REQUEST_COMPRESSION
+#include <zlib.h>
+#endif
+
 size_t WriteCallback(void *contents, size_t size, size_t nmemb, void *userp)
 {
    ((std::string*)userp)->append((char*)contents, size * nmemb);
@@ -36,6 +39,44 @@ size_t WriteCallback(void *contents, size_t size, size_t nmemb, void *userp)
 
 namespace graphene { namespace utilities {
 
+namespace {
+
+#ifdef GRAPHENE_ES_REQUEST_COMPRESSION
+/// @return @p data in gzip format, or an empty string if it could not be compressed
+std::string gzip( const std::string& data )
+{
+   z_stream stream{};
+   // a window size of 15 plus 16 selects the gzip format
+   if( deflateInit2( &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY ) != Z_OK )
+      return std::string();
+   std::string result( deflateBound( &stream, data.size() ), '\0' );
+   stream.next_in = (Bytef*)data.data();
+   stream.avail_in = data.size();
+   stream.next_out = (Bytef*)&result[0];
+   stream.avail_out = result.size();
+   const int rc = deflate( &stream, Z_FINISH );
+   result.resize( stream.total_out );
+   deflateEnd( &stream );
+   if( rc != Z_STREAM_END )
+      return std::string();
+   return result;
+}
+#endif
+
+/// Bodies smaller than this are not worth compressing
+const size_t min_compressed_size = 1024;
+
+} // anonymous namespace
+
+bool isCompressionSupported()
+{
+#ifdef GRAPHENE_ES_REQUEST_COMPRESSION
+   return true;
+#else
+   return false;
+#endif
+}
+
 bool checkES(ES& es)
 {
    graphene::utilities::CurlRequest curl_request;
@@ -71,6 +112,7 @@ bool SendBulk(ES&& es)
    curl_request.auth = es.auth;
    curl_request.type = "POST";
    curl_request.query = std::move(bulking);
+   curl_request.compress = es.compress;
 
    auto curlResponse = doCurl(curl_request);
 
@@ -81,9 +123,16 @@ bool SendBulk(ES&& es)
 
 const std::string joinBulkLines(const std::vector<std::string>& bulk)
 {
-   auto bulking = boost::algorithm::join(bulk, "\n");
-   bulking = bulking + "\n";
-
+   size_t size = 0;
+   for( const auto& line : bulk )
+      size += line.size() + 1;
+   std::string bulking;
+   bulking.reserve( size );
+   for( const auto& line : bulk )
+   {
+      bulking += line;
+      bulking += '\n';
+   }
    return bulking;
 }
 long getResponseCode(CURL *handler)
@@ -167,8 +216,21 @@ const std::string generateIndexName(const fc::time_point_sec& block_date, const
 const std::string doCurl(CurlRequest& curl)
 {
    std::string CurlReadBuffer;
+   const std::string* body = &curl.query;
    struct curl_slist *headers = NULL;
    headers = curl_slist_append(headers, "Content-Type: application/json");
+#ifdef GRAPHENE_ES_REQUEST_COMPRESSION
+   std::string compressed;
+   if(curl.compress && curl.type == "POST" && curl.query.size() >= min_compressed_size)
+   {
+      compressed = gzip(curl.query);
+      if(!compressed.empty())
+      {
+         body = &compressed;
+         headers = curl_slist_append(headers, "Content-Encoding: gzip");
+      }
+   }
+#endif
 
    curl_easy_setopt(curl.handler, CURLOPT_HTTPHEADER, headers);
    curl_easy_setopt(curl.handler, CURLOPT_URL, curl.url.c_str());
@@ -176,15 +238,31 @@ const std::string doCurl(CurlRequest& curl)
    if(curl.type == "POST")
    {
       curl_easy_setopt(curl.handler, CURLOPT_POST, true);
-      curl_easy_setopt(curl.handler, CURLOPT_POSTFIELDS, curl.query.c_str());
+      curl_easy_setopt(curl.handler, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)body->size());
+      curl_easy_setopt(curl.handler, CURLOPT_POSTFIELDS, body->data());
    }
+   else
+      curl_easy_setopt(curl.handler, CURLOPT_HTTPGET, true);
    curl_easy_setopt(curl.handler, CURLOPT_WRITEFUNCTION, WriteCallback);
    curl_easy_setopt(curl.handler, CURLOPT_WRITEDATA, (void *)&CurlReadBuffer);
    curl_easy_setopt(curl.handler, CURLOPT_USERAGENT, "libcrp/0.1");
+   // the connection of a handle is reused by its next request, keep it open in between
+   curl_easy_setopt(curl.handler, CURLOPT_TCP_KEEPALIVE, 1L);
+   // accept all response encodings supported by curl
+   curl_easy_setopt(curl.handler, CURLOPT_ACCEPT_ENCODING, "");
+#if LIBCURL_VERSION_NUM >= 0x072f00
+   // HTTP/2 if negotiated by TLS, plain connections stay HTTP/1.1
+   curl_easy_setopt(curl.handler, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+#endif
    if(!curl.auth.empty())
       curl_easy_setopt(curl.handler, CURLOPT_USERPWD, curl.auth.c_str());
    curl_easy_perform(curl.handler);
 
+   // the handle must not refer to the freed headers and body
+   curl_easy_setopt(curl.handler, CURLOPT_HTTPHEADER, NULL);
+   curl_easy_setopt(curl.handler, CURLOPT_POSTFIELDS, NULL);
+   curl_slist_free_all(headers);
+
    return CurlReadBuffer;
 }
 
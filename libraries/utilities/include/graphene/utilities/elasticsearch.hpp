@@ -43,6 +43,8 @@ namespace graphene { namespace utilities {
          std::string auth;
          std::string endpoint;
          std::string query;
+         /// Send bulks gzip compressed, ignored if not supported by this build
+         bool compress = false;
    };
    class CurlRequest {
       public:
@@ -51,6 +53,7 @@ namespace graphene { namespace utilities {
          std::string type;
          std::string auth;
          std::string query;
+         bool compress = false;
    };
 
    bool SendBulk(ES&& es);
@@ -64,5 +67,7 @@ namespace graphene { namespace utilities {
    const std::string doCurl(CurlRequest& curl);
    const std::string joinBulkLines(const std::vector<std::string>& bulk);
    long getResponseCode(CURL *handler);
+   /// @return true if requests can be sent compressed
+   bool isCompressionSupported();
 
 } } // end namespace graphene::utilities
@@ -430,6 +430,26 @@ class wallet_api
        */
       void remove_builder_transaction(transaction_handle_type handle);
 
+      /**
+       * @ingroup Transaction Builder API
+       *
+       * Pack many operations into as few transactions as the chain allows, then sign them and optionally
+       * broadcast them to the network.
+       *
+       * Fees are set in the core asset from a single lookup of the fee schedule. The required keys are looked up
+       * once for each set of accounts which must approve. Transactions are signed on all cores and broadcast
+       * without waiting for the previous broadcasts to be answered.
+       *
+       * @param ops the operations, they keep their order across the transactions
+       * @param max_ops_per_transaction maximum number of operations in a transaction, 0 for no limit other than
+       *        the maximum transaction size
+       * @param broadcast whether to broadcast the signed transactions to the network
+       * @return the signed transactions
+       */
+      vector<signed_transaction> sign_operations_in_batches(vector<operation> ops,
+                                                            uint32_t max_ops_per_transaction = 0,
+                                                            bool broadcast = true);
+
       /** Checks whether the wallet has just been created and has not yet had a password set.
        *
        * Calling \c set_password will transition the wallet to the locked state.
@@ -1981,6 +2001,7 @@ FC_API( graphene::wallet::wallet_api,
         (broadcast_transaction)
         (propose_builder_transaction)
         (remove_builder_transaction)
+        (sign_operations_in_batches)
         (is_new)
         (is_locked)
         (lock)(unlock)(set_password)
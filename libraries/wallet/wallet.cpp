@@ -308,6 +308,7 @@ vector<operation_detail> wallet_api::get_account_history(const string& name, uin
             operation_history_id_type(),
             page_limit,
             start );
+      my->prefetch_history_objects( current );
       bool first_row = true;
       for( auto& o : current )
       {
@@ -361,6 +362,7 @@ vector<operation_detail> wallet_api::get_relative_account_history(
             stop,
             page_size,
             start);
+      my->prefetch_history_objects( current );
       for (auto &o : current) {
          std::stringstream ss;
          auto memo = o.op.visit(detail::operation_printer(ss, *my, o));
@@ -394,10 +396,13 @@ account_history_operation_detail wallet_api::get_account_history_by_operations(
         result.total_count =stats.removed_ops;
     }
 
+    // operations of the same block share its transaction ids
+    map<uint32_t, optional<signed_block_with_info>> blocks;
     uint32_t default_page_size = 100;
     while (limit > 0 && start <= stats.total_ops) {
         uint32_t min_limit = std::min(default_page_size, limit);
         auto current = my->_remote_hist->get_account_history_by_operations(name, operation_types, start, min_limit);
+        my->prefetch_history_objects( current.operation_history_objs );
         auto his_rend = current.operation_history_objs.rend();
         for( auto it = current.operation_history_objs.rbegin(); it != his_rend; ++it )
         {
@@ -406,7 +411,10 @@ account_history_operation_detail wallet_api::get_account_history_by_operations(
             auto memo = obj.op.visit(detail::operation_printer(ss, *my, obj));
 
             transaction_id_type transaction_id;
-            auto block = get_block(obj.block_num);
+            auto block_itr = blocks.find( obj.block_num );
+            if( block_itr == blocks.end() )
+               block_itr = blocks.emplace( obj.block_num, get_block( obj.block_num ) ).first;
+            const auto& block = block_itr->second;
             if (block.valid() && obj.trx_in_block < block->transaction_ids.size()) {
                 transaction_id = block->transaction_ids[obj.trx_in_block];
             }
@@ -554,6 +562,13 @@ void wallet_api::remove_builder_transaction(transaction_handle_type handle)
    return my->remove_builder_transaction(handle);
 }
 
+vector<signed_transaction> wallet_api::sign_operations_in_batches(vector<operation> ops,
+                                                                  uint32_t max_ops_per_transaction,
+                                                                  bool broadcast)
+{
+   return my->sign_operations_in_batches(std::move(ops), max_ops_per_transaction, broadcast);
+}
+
 account_object wallet_api::get_account(string account_name_or_id) const
 {
    return my->get_account(account_name_or_id);
@@ -1517,7 +1532,7 @@ blind_confirmation wallet_api::transfer_from_blind( string from_blind_account_ke
    transfer_from_blind_operation from_blind;
 
 
-   auto fees  = my->_remote_db->get_global_properties().parameters.get_current_fees();
+   auto fees  = my->get_global_properties().parameters.get_current_fees();
    fc::optional<asset_object> asset_obj = get_asset(symbol);
    FC_ASSERT(asset_obj.valid(), "Could not find asset matching ${asset}", ("asset", symbol));
    auto amount = asset_obj->amount_from_string(amount_in);
@@ -1597,7 +1612,7 @@ blind_confirmation wallet_api::blind_transfer_help( string from_key_or_label,
    blind_transfer_operation blind_tr;
    blind_tr.outputs.resize(2);
 
-   auto fees  = my->_remote_db->get_global_properties().parameters.get_current_fees();
+   auto fees  = my->get_global_properties().parameters.get_current_fees();
 
    auto amount = asset_obj->amount_from_string(amount_in);
 
@@ -1825,7 +1840,7 @@ blind_confirmation wallet_api::transfer_to_blind( string from_account_id_or_name
               [&]( const blind_output& a, const blind_output& b ){ return a.commitment < b.commitment; } );
 
    confirm.trx.operations.push_back( bop );
-   my->set_operation_fees( confirm.trx, my->_remote_db->get_global_properties().parameters.get_current_fees());
+   my->set_operation_fees( confirm.trx, my->get_global_properties().parameters.get_current_fees());
    confirm.trx.validate();
    confirm.trx = sign_transaction(confirm.trx, broadcast);
 
@@ -76,7 +76,7 @@ namespace graphene { namespace wallet { namespace detail {
 
       signed_transaction tx;
       tx.operations.push_back( account_create_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.get_current_fees() );
+      set_operation_fees( tx, get_global_properties().parameters.get_current_fees() );
       tx.validate();
 
       return sign_transaction(tx, broadcast);
@@ -94,7 +94,7 @@ namespace graphene { namespace wallet { namespace detail {
       op.account_to_upgrade = account_obj.get_id();
       op.upgrade_to_lifetime_member = true;
       tx.operations = {op};
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.get_current_fees() );
+      set_operation_fees( tx, get_global_properties().parameters.get_current_fees() );
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -138,7 +138,7 @@ namespace graphene { namespace wallet { namespace detail {
 
          signed_transaction tx;
          tx.operations.push_back(op);
-         set_operation_fees( tx, _remote_db->get_global_properties().parameters.get_current_fees());
+         set_operation_fees( tx, get_global_properties().parameters.get_current_fees());
          tx.validate();
 
          return sign_transaction(tx, broadcast);
@@ -194,10 +194,17 @@ namespace graphene { namespace wallet { namespace detail {
 
    account_object wallet_api_impl::get_account(account_id_type id) const
    {
+      auto itr = _account_cache.find( id );
+      if( itr != _account_cache.end() )
+         return itr->second;
+
       std::string account_id = account_id_to_string(id);
 
-      auto rec = _remote_db->get_accounts({account_id}, {}).front();
+      auto rec = _remote_db->get_accounts({account_id}, true).front();
       FC_ASSERT(rec);
+      if( _account_cache.size() >= max_cached_objects )
+         _account_cache.clear();
+      _account_cache[id] = *rec;
       return *rec;
    }
 
@@ -210,8 +217,19 @@ namespace graphene { namespace wallet { namespace detail {
          // It's an ID
          return get_account(*id);
       } else {
-         auto rec = _remote_db->lookup_account_names({account_name_or_id}).front();
+         // names of accounts never change
+         auto name_itr = _account_ids_by_name.find( account_name_or_id );
+         if( name_itr != _account_ids_by_name.end() )
+            return get_account( name_itr->second );
+
+         auto rec = _remote_db->get_accounts({account_name_or_id}, true).front();
          FC_ASSERT( rec && rec->name == account_name_or_id );
+         if( _account_cache.size() >= max_cached_objects )
+            _account_cache.clear();
+         if( _account_ids_by_name.size() >= max_cached_objects )
+            _account_ids_by_name.clear();
+         _account_cache[rec->get_id()] = *rec;
+         _account_ids_by_name[rec->name] = rec->get_id();
          return *rec;
       }
    }
@@ -260,7 +278,7 @@ namespace graphene { namespace wallet { namespace detail {
 
          signed_transaction tx;
          tx.operations.push_back( account_create_op );
-         set_operation_fees( tx, _remote_db->get_global_properties().parameters.get_current_fees());
+         set_operation_fees( tx, get_global_properties().parameters.get_current_fees());
          tx.validate();
 
          // we do not insert owner_privkey here because
@@ -282,7 +300,7 @@ namespace graphene { namespace wallet { namespace detail {
 
       signed_transaction tx;
       tx.operations.push_back( whitelist_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.get_current_fees());
+      set_operation_fees( tx, get_global_properties().parameters.get_current_fees());
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -292,7 +310,7 @@ namespace graphene { namespace wallet { namespace detail {
    { try {
       fc::optional<vesting_balance_id_type> vbid = maybe_id<vesting_balance_id_type>( account_name );
       std::vector<vesting_balance_object_with_info> result;
-      fc::time_point_sec now = _remote_db->get_dynamic_global_properties().time;
+      fc::time_point_sec now = get_dynamic_global_properties().time;
 
       if( vbid )
       {
@@ -315,7 +333,7 @@ namespace graphene { namespace wallet { namespace detail {
          const vector<string>& wif_keys, bool broadcast )
    { try {
       FC_ASSERT(!is_locked());
-      const dynamic_global_property_object& dpo = _remote_db->get_dynamic_global_properties();
+      const dynamic_global_property_object& dpo = get_dynamic_global_properties();
       account_object claimer = get_account( name_or_id );
       uint32_t max_ops_per_tx = 30;
 
@@ -407,7 +425,7 @@ namespace graphene { namespace wallet { namespace detail {
          tx.operations.reserve( ctx.ops.size() );
          for( const balance_claim_operation& op : ctx.ops )
             tx.operations.emplace_back( op );
-         set_operation_fees( tx, _remote_db->get_global_properties().parameters.get_current_fees() );
+         set_operation_fees( tx, get_global_properties().parameters.get_current_fees() );
          tx.validate();
          signed_transaction signed_tx = sign_transaction( tx, false );
          for( const address& addr : ctx.addrs )
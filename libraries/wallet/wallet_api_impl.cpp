@@ -30,6 +30,7 @@
 #include <fc/thread/scoped_lock.hpp>
 #include <fc/io/fstream.hpp>
 
+#include <graphene/chain/impacted.hpp>
 #include <graphene/wallet/wallet.hpp>
 #include "wallet_api_impl.hpp"
 #include <graphene/utilities/git_revision.hpp>
@@ -78,6 +79,12 @@ namespace graphene { namespace wallet { namespace detail {
       {
          on_block_applied( block_id );
       } );
+      // only the objects cached by the wallet are subscribed to
+      _remote_db->set_subscribe_callback( [this](const variant& changes )
+      {
+         on_objects_changed( changes );
+      }, false );
+      _remote_db->set_auto_subscription( false );
 
       _wallet.chain_id = _chain_id;
       _wallet.ws_server = initial_data.ws_server;
@@ -176,11 +183,17 @@ namespace graphene { namespace wallet { namespace detail {
    }
    global_property_object wallet_api_impl::get_global_properties() const
    {
-      return _remote_db->get_global_properties();
+      if( !_global_properties_cache.valid() )
+         _global_properties_cache = _remote_db->get_objects( { global_property_id_type() }, true ).front()
+                                       .as<global_property_object>( GRAPHENE_MAX_NESTED_OBJECTS );
+      return *_global_properties_cache;
    }
    dynamic_global_property_object wallet_api_impl::get_dynamic_global_properties() const
    {
-      return _remote_db->get_dynamic_global_properties();
+      if( !_dynamic_global_properties_cache.valid() )
+         _dynamic_global_properties_cache = _remote_db->get_objects( { dynamic_global_property_id_type() }, true )
+                                               .front().as<dynamic_global_property_object>( GRAPHENE_MAX_NESTED_OBJECTS );
+      return *_dynamic_global_properties_cache;
    }
 
    void wallet_api_impl::on_block_applied( const variant& block_id )
@@ -188,6 +201,122 @@ namespace graphene { namespace wallet { namespace detail {
       fc::async([this]{resync();}, "Resync after block");
    }
 
+   void wallet_api_impl::on_objects_changed( const variant& changes )
+   {
+      if( !changes.is_array() )
+         return;
+      for( const variant& change : changes.get_array() )
+      {
+         if( !change.is_object() || !change.get_object().contains( "id" ) )
+            continue;
+         const object_id_type id = change["id"].as<object_id_type>( 1 );
+         if( id == global_property_id_type() )
+            _global_properties_cache = change.as<global_property_object>( GRAPHENE_MAX_NESTED_OBJECTS );
+         else if( id == dynamic_global_property_id_type() )
+            _dynamic_global_properties_cache = change.as<dynamic_global_property_object>( GRAPHENE_MAX_NESTED_OBJECTS );
+         else if( id.is<account_id_type>() )
+            _account_cache.erase( account_id_type( id ) );
+         else if( id.is<asset_id_type>() )
+            _asset_cache.erase( asset_id_type( id ) );
+      }
+   }
+
+   namespace {
+      /// Collects the assets which operation_printer shows
+      struct printed_asset_collector
+      {
+         typedef void result_type;
+         flat_set<asset_id_type>& assets;
+
+         void collect( const transfer_operation& op )const { assets.insert( op.amount.asset_id ); }
+         void collect( const override_transfer_operation& op )const { assets.insert( op.amount.asset_id ); }
+         void collect( const asset_update_operation& op )const { assets.insert( op.asset_to_update ); }
+         void collect( const asset_update_bitasset_operation& op )const { assets.insert( op.asset_to_update ); }
+         void collect( const asset_update_feed_producers_operation& op )const
+         { assets.insert( op.asset_to_update ); }
+         void collect( const asset_issue_operation& op )const { assets.insert( op.asset_to_issue.asset_id ); }
+         void collect( const asset_reserve_operation& op )const
+         { assets.insert( op.amount_to_reserve.asset_id ); }
+         void collect( const asset_settle_operation& op )const { assets.insert( op.amount.asset_id ); }
+         void collect( const asset_fund_fee_pool_operation& op )const
+         {
+            assets.insert( op.asset_id );
+            assets.insert( asset_id_type() );
+         }
+         void collect( const asset_claim_pool_operation& op )const
+         {
+            assets.insert( op.asset_id );
+            assets.insert( op.amount_to_claim.asset_id );
+         }
+         void collect( const asset_publish_feed_operation& op )const
+         {
+            assets.insert( op.feed.settlement_price.base.asset_id );
+            assets.insert( op.feed.settlement_price.quote.asset_id );
+         }
+         void collect( const call_order_update_operation& op )const
+         {
+            assets.insert( op.delta_debt.asset_id );
+            assets.insert( op.delta_collateral.asset_id );
+         }
+         void collect( const limit_order_create_operation& op )const
+         {
+            assets.insert( op.amount_to_sell.asset_id );
+            assets.insert( op.min_to_receive.asset_id );
+         }
+         void collect( const fill_order_operation& op )const
+         {
+            assets.insert( op.pays.asset_id );
+            assets.insert( op.receives.asset_id );
+         }
+         template<typename Op>
+         void collect( const Op& )const {}
+
+         template<typename Op>
+         void operator()( const Op& op )const
+         {
+            assets.insert( op.fee.asset_id );
+            collect( op );
+         }
+      };
+   }
+
+   void wallet_api_impl::prefetch_history_objects( const vector<operation_history_object>& history ) const
+   {
+      flat_set<account_id_type> accounts;
+      flat_set<asset_id_type> assets;
+      for( const auto& o : history )
+      {
+         operation_get_impacted_accounts( o.op, accounts, true );
+         o.op.visit( printed_asset_collector{ assets } );
+      }
+
+      vector<string> missing_accounts;
+      for( const auto& id : accounts )
+         if( _account_cache.find( id ) == _account_cache.end() )
+            missing_accounts.push_back( account_id_to_string( id ) );
+      if( !missing_accounts.empty() )
+      {
+         if( _account_cache.size() + missing_accounts.size() > max_cached_objects )
+            _account_cache.clear();
+         for( const auto& rec : _remote_db->get_accounts( missing_accounts, true ) )
+            if( rec )
+               _account_cache[rec->get_id()] = *rec;
+      }
+
+      vector<string> missing_assets;
+      for( const auto& id : assets )
+         if( _asset_cache.find( id ) == _asset_cache.end() )
+            missing_assets.push_back( asset_id_to_string( id ) );
+      if( !missing_assets.empty() )
+      {
+         if( _asset_cache.size() + missing_assets.size() > max_cached_objects )
+            _asset_cache.clear();
+         for( const auto& rec : _remote_db->get_assets( missing_assets, true ) )
+            if( rec )
+               _asset_cache[rec->get_id()] = *rec;
+      }
+   }
+
    void wallet_api_impl::set_operation_fees( signed_transaction& tx, const fee_schedule& s  )
    {
       for( auto& op : tx.operations )
@@ -112,6 +112,8 @@ public:
     * @brief called when a block is applied
     */
    void on_block_applied( const variant& block_id );
+   /// Updates or drops the cached objects which the node notified as changed
+   void on_objects_changed( const variant& changes );
 
    /**
     * @brief make a copy of the wallet file
@@ -172,6 +174,10 @@ public:
 
    asset_id_type get_asset_id(const string& asset_symbol_or_id) const;
 
+   /// Fetches the accounts and assets which are shown when printing @p history and not cached yet, with one
+   /// call for the accounts and one for the assets
+   void prefetch_history_objects( const vector<operation_history_object>& history ) const;
+
    string get_wallet_filename() const;
 
    fc::ecc::private_key get_private_key(const public_key_type& id)const;
@@ -230,6 +236,9 @@ public:
 
    void remove_builder_transaction(transaction_handle_type handle);
 
+   vector<signed_transaction> sign_operations_in_batches(vector<operation> ops, uint32_t max_ops_per_transaction,
+         bool broadcast);
+
    signed_transaction register_account(string name, public_key_type owner, public_key_type active,
          string  registrar_account, string  referrer_account, uint32_t referrer_percent,
          bool broadcast = false);
@@ -521,6 +530,17 @@ private:
 
    map<transaction_handle_type, signed_transaction> _builder_transactions;
 
+   // Chain state kept between commands, so that building and signing a transaction takes no round trips to the
+   // node. The node is subscribed to all cached objects. The global properties are updated from its
+   // notifications, and changed accounts and assets are dropped to be fetched again when needed.
+   static constexpr size_t max_cached_objects = 10000;
+   mutable optional<global_property_object>                 _global_properties_cache;
+   mutable optional<dynamic_global_property_object>         _dynamic_global_properties_cache;
+   mutable map<account_id_type, account_object>             _account_cache;
+   mutable map<string, account_id_type>                     _account_ids_by_name;
+   mutable map<asset_id_type, extended_asset_object>        _asset_cache;
+   mutable map<string, asset_id_type>                       _asset_ids_by_symbol;
+
    // if the user executes the same command twice in quick succession,
    // we might generate the same transaction id, and cause the second
    // transaction to be rejected.  This can be avoided by altering the
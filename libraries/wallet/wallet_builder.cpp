@@ -23,6 +23,12 @@
  */
 #include "wallet_api_impl.hpp"
 
+#include <fc/thread/thread.hpp>
+
+#include <atomic>
+#include <list>
+#include <thread>
+
 namespace graphene { namespace wallet { namespace detail {
 
    transaction_handle_type wallet_api_impl::begin_builder_transaction()
@@ -56,7 +62,7 @@ namespace graphene { namespace wallet { namespace detail {
       auto fee_asset_obj = get_asset(fee_asset);
       asset total_fee = fee_asset_obj.amount(0);
 
-      auto gprops = _remote_db->get_global_properties().parameters;
+      auto gprops = get_global_properties().parameters;
       if( fee_asset_obj.get_id() != asset_id_type() )
       {
          for( auto& op : _builder_transactions[handle].operations )
@@ -102,7 +108,7 @@ namespace graphene { namespace wallet { namespace detail {
       if( review_period_seconds )
          op.review_period_seconds = review_period_seconds;
       trx.operations = {op};
-      _remote_db->get_global_properties().parameters.get_current_fees().set_fee( trx.operations.front() );
+      get_global_properties().parameters.get_current_fees().set_fee( trx.operations.front() );
 
       return trx = sign_transaction(trx, broadcast);
    }
@@ -112,4 +118,138 @@ namespace graphene { namespace wallet { namespace detail {
       _builder_transactions.erase(handle);
    }
 
+   vector<signed_transaction> wallet_api_impl::sign_operations_in_batches( vector<operation> ops,
+         uint32_t max_ops_per_transaction, bool broadcast )
+   {
+      FC_ASSERT( !self.is_locked() );
+      FC_ASSERT( !ops.empty(), "No operations given" );
+
+      const auto gprops = get_global_properties();
+      const auto dyn_props = get_dynamic_global_properties();
+      const fee_schedule& fees = gprops.parameters.get_current_fees();
+      for( auto& op : ops )
+         fees.set_fee( op );
+
+      // leave room for the transaction header and the signatures
+      const uint64_t max_size = gprops.parameters.maximum_transaction_size > 2048
+                              ? gprops.parameters.maximum_transaction_size - 1024
+                              : gprops.parameters.maximum_transaction_size / 2;
+      vector<signed_transaction> result;
+      uint64_t size = 0;
+      for( auto& op : ops )
+      {
+         const uint64_t op_size = fc::raw::pack_size( op );
+         if( result.empty() || size + op_size > max_size
+               || ( max_ops_per_transaction > 0 && result.back().operations.size() >= max_ops_per_transaction ) )
+         {
+            result.emplace_back();
+            size = 0;
+         }
+         result.back().operations.emplace_back( std::move( op ) );
+         size += op_size;
+      }
+
+      // the transaction ID does not depend on the signatures, so duplicates are resolved before signing
+      fc::time_point_sec oldest_transaction_ids_to_track(dyn_props.time - fc::minutes(2));
+      auto& by_time = _recently_generated_transactions.get<timestamp_index>();
+      by_time.erase( by_time.begin(), by_time.lower_bound(oldest_transaction_ids_to_track) );
+
+      typedef std::pair< flat_set<account_id_type>, flat_set<account_id_type> > approvals_type;
+      std::map< approvals_type, set<public_key_type> > keys_by_approvals;
+      std::list< set<public_key_type> > uncached_keys;
+      vector< const set<public_key_type>* > transaction_keys;
+      transaction_keys.reserve( result.size() );
+      std::map< public_key_type, fc::ecc::private_key > private_keys;
+      for( auto& tx : result )
+      {
+         tx.set_reference_block( dyn_props.head_block_id );
+         uint32_t expiration_time_offset = 0;
+         for (;;)
+         {
+            tx.set_expiration( dyn_props.time + fc::seconds(30 + expiration_time_offset) );
+            recently_generated_transaction_record this_transaction_record;
+            this_transaction_record.generation_time = dyn_props.time;
+            this_transaction_record.transaction_id = tx.id();
+            if( _recently_generated_transactions.insert(this_transaction_record).second )
+               break;
+            ++expiration_time_offset;
+         }
+
+         // the required keys only depend on the accounts which must approve, unless other authorities are needed
+         approvals_type approvals;
+         vector<authority> other;
+         tx.get_required_authorities( approvals.first, approvals.second, other, true );
+         const set<public_key_type>* keys;
+         if( other.empty() )
+         {
+            auto itr = keys_by_approvals.find( approvals );
+            if( itr == keys_by_approvals.end() )
+               itr = keys_by_approvals.emplace( std::move( approvals ), get_owned_required_keys( tx ) ).first;
+            keys = &itr->second;
+         }
+         else
+         {
+            uncached_keys.push_back( get_owned_required_keys( tx ) );
+            keys = &uncached_keys.back();
+         }
+         for( const public_key_type& key : *keys )
+            if( private_keys.find( key ) == private_keys.end() )
+               private_keys.emplace( key, get_private_key( key ) );
+         transaction_keys.push_back( keys );
+      }
+
+      std::atomic<size_t> next_transaction( 0 );
+      auto sign_transactions = [&]() {
+         for( size_t i = next_transaction++; i < result.size(); i = next_transaction++ )
+            for( const public_key_type& key : *transaction_keys[i] )
+               result[i].sign( private_keys.at( key ), _chain_id );
+      };
+      const size_t num_threads = std::min<size_t>( std::max( 1u, std::thread::hardware_concurrency() ), result.size() );
+      vector<std::thread> threads;
+      for( size_t i = 1; i < num_threads; ++i )
+         threads.emplace_back( sign_transactions );
+      sign_transactions();
+      for( auto& t : threads )
+         t.join();
+
+      if( broadcast )
+      {
+         // up to this many broadcasts wait for their answer at a time
+         const size_t max_pending_broadcasts = 64;
+         vector< fc::future<void> > pending;
+         pending.reserve( result.size() );
+         uint32_t failed = 0;
+         fc::optional<fc::exception> first_error;
+         auto wait_for = [&]( size_t i ) {
+            try
+            {
+               pending[i].wait();
+            }
+            catch( const fc::exception& e )
+            {
+               elog( "Caught exception while broadcasting tx ${id}:  ${e}",
+                     ("id", result[i].id().str())("e", e.to_detail_string()) );
+               if( !first_error.valid() )
+                  first_error = e;
+               ++failed;
+            }
+         };
+         for( size_t i = 0; i < result.size(); ++i )
+         {
+            if( i >= max_pending_broadcasts )
+               wait_for( i - max_pending_broadcasts );
+            const signed_transaction& tx = result[i];
+            pending.push_back( fc::async( [this, &tx]() { _remote_net_broadcast->broadcast_transaction( tx ); },
+                                          "broadcast_transaction" ) );
+         }
+         for( size_t i = result.size() > max_pending_broadcasts ? result.size() - max_pending_broadcasts : 0;
+              i < result.size(); ++i )
+            wait_for( i );
+         FC_ASSERT( failed == 0, "${n} of ${t} transactions failed to broadcast, the first error: ${e}",
+                    ("n", failed)("t", result.size())("e", first_error->to_string()) );
+      }
+
+      return result;
+   }
+
 }}} // namespace graphene::wallet::detail1
@@ -26,6 +26,8 @@
 #include <fc/crypto/aes.hpp>
 #include <fc/crypto/base64.hpp>
 
+#include <deque>
+
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string.hpp>
 
@@ -472,19 +474,27 @@ namespace graphene { namespace wallet { namespace detail {
    set<public_key_type> wallet_api_impl::get_owned_required_keys( signed_transaction &tx,
          bool erase_existing_sigs )
    {
-      set<public_key_type> pks = _remote_db->get_potential_signatures( tx );
       flat_set<public_key_type> owned_keys;
-      owned_keys.reserve( pks.size() );
-      std::copy_if( pks.begin(), pks.end(),
-                    std::inserter( owned_keys, owned_keys.end() ),
-                    [this]( const public_key_type &pk ) {
-                       return _keys.find( pk ) != _keys.end();
-                    } );
+      owned_keys.reserve( _keys.size() );
+      for( const auto& item : _keys )
+         owned_keys.insert( owned_keys.end(), item.first );
 
       if ( erase_existing_sigs )
          tx.signatures.clear();
 
-      return _remote_db->get_required_signatures( tx, owned_keys );
+      // computed locally from the cached accounts like the node does in get_required_signatures,
+      // the authorities are copied since fetching an account which is not cached yet lets the cache change
+      std::deque<authority> authorities;
+      auto get_active = [this, &authorities]( account_id_type id ) {
+         authorities.push_back( get_account( id ).active );
+         return &authorities.back();
+      };
+      auto get_owner = [this, &authorities]( account_id_type id ) {
+         authorities.push_back( get_account( id ).owner );
+         return &authorities.back();
+      };
+      return tx.get_required_signatures( _chain_id, owned_keys, get_active, get_owner, true, false,
+                                         get_global_properties().parameters.max_authority_depth );
    }
 
    flat_set<public_key_type> wallet_api_impl::get_transaction_signers(const signed_transaction &tx) const
@@ -542,7 +552,7 @@ namespace graphene { namespace wallet { namespace detail {
 
       signed_transaction tx;
       tx.operations.push_back(create_pd_op);
-      set_operation_fees(tx, _remote_db->get_global_properties().parameters.get_current_fees());
+      set_operation_fees(tx, get_global_properties().parameters.get_current_fees());
       tx.validate();
 
       return sign_transaction(tx, broadcast);
@@ -570,7 +580,7 @@ namespace graphene { namespace wallet { namespace detail {
 
       signed_transaction tx;
       tx.operations.push_back(create_pd_op);
-      set_operation_fees(tx, _remote_db->get_global_properties().parameters.get_current_fees());
+      set_operation_fees(tx, get_global_properties().parameters.get_current_fees());
       tx.validate();
 
       return sign_transaction(tx, broadcast);
@@ -622,16 +632,42 @@ namespace graphene { namespace wallet { namespace detail {
    {
       auto subject_id = get_account(subject_account).get_id();
       auto operator_id = get_account(operator_account).get_id();
-      auto pd_data = _remote_db->get_personal_data(subject_id, operator_id);      
-      return pd_data;
+      // the node returns at most its configured limit per call, each page starts with the previous cursor
+      std::vector<personal_data_object> result;
+      optional<personal_data_id_type> start;
+      while( true )
+      {
+         auto pd_data = _remote_db->get_personal_data(subject_id, operator_id, start, optional<uint32_t>());
+         auto first = pd_data.begin();
+         if( start.valid() && first != pd_data.end() )
+            ++first;
+         if( first == pd_data.end() )
+            break;
+         result.insert( result.end(), first, pd_data.end() );
+         start = personal_data_id_type( result.back().id );
+      }
+      return result;
    }
 
    std::vector<personal_data_v2_object> wallet_api_impl::get_personal_data_v2( const string subject_account, const string operator_account) const
    {
       auto subject_id = get_account(subject_account).get_id();
       auto operator_id = get_account(operator_account).get_id();
-      auto pd_data = _remote_db->get_personal_data_v2(subject_id, operator_id);      
-      return pd_data;
+      // the node returns at most its configured limit per call, each page starts with the previous cursor
+      std::vector<personal_data_v2_object> result;
+      optional<personal_data_v2_id_type> start;
+      while( true )
+      {
+         auto pd_data = _remote_db->get_personal_data_v2(subject_id, operator_id, start, optional<uint32_t>());
+         auto first = pd_data.begin();
+         if( start.valid() && first != pd_data.end() )
+            ++first;
+         if( first == pd_data.end() )
+            break;
+         result.insert( result.end(), first, pd_data.end() );
+         start = personal_data_v2_id_type( result.back().id );
+      }
+      return result;
    }
 
    personal_data_object wallet_api_impl::get_last_personal_data( const string subject_account, const string operator_account) const
@@ -703,7 +739,7 @@ namespace graphene { namespace wallet { namespace detail {
 
       signed_transaction tx;
       tx.operations.push_back(create_content_op);
-      set_operation_fees(tx, _remote_db->get_global_properties().parameters.get_current_fees());
+      set_operation_fees(tx, get_global_properties().parameters.get_current_fees());
       tx.validate();
 
       return sign_transaction(tx, broadcast);
@@ -756,7 +792,7 @@ namespace graphene { namespace wallet { namespace detail {
 
       signed_transaction tx;
       tx.operations.push_back(update_content_op);
-      set_operation_fees(tx, _remote_db->get_global_properties().parameters.get_current_fees());
+      set_operation_fees(tx, get_global_properties().parameters.get_current_fees());
       tx.validate();
 
       return sign_transaction(tx, broadcast);
@@ -826,7 +862,7 @@ namespace graphene { namespace wallet { namespace detail {
 
       signed_transaction tx;
       tx.operations.push_back(create_perm_op);
-      set_operation_fees(tx, _remote_db->get_global_properties().parameters.get_current_fees());
+      set_operation_fees(tx, get_global_properties().parameters.get_current_fees());
       tx.validate();
 
       return sign_transaction(tx, broadcast);
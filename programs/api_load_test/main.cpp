@@ -0,0 +1,308 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Records API traffic of a node and replays it to measure API latency.
+ *
+ * In record mode the tool is a websocket proxy in front of a node: every call of a client is forwarded as is and
+ * written as one JSON object per line, with its time offset in microseconds, the API name, the method and the
+ * parameters. In replay mode the calls of such a file are sent to a node over a number of connections, keeping
+ * their recorded pacing divided by a speedup factor (or as fast as possible), and latency percentiles are reported
+ * for every method.
+ */
+
+#include <graphene/chain/config.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/network/http/websocket.hpp>
+#include <fc/rpc/websocket_api.hpp>
+#include <fc/thread/thread.hpp>
+#include <fc/variant_object.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+
+#ifndef WIN32
+#include <csignal>
+#endif
+
+using namespace std;
+namespace bpo = boost::program_options;
+
+namespace {
+
+struct recorded_call
+{
+   int64_t      offset_us = 0;
+   string       api;
+   string       method;
+   fc::variants params;
+};
+
+/// Extracts the API name, method and parameters of a JSON-RPC request, returns false if it is not a call
+bool parse_call( const string& message, recorded_call& call )
+{
+   const fc::variant_object request = fc::json::from_string( message ).get_object();
+   if( !request.contains( "method" ) || !request.contains( "params" ) )
+      return false;
+   const string method = request["method"].as_string();
+   const fc::variants params = request["params"].get_array();
+   if( method != "call" )
+   {
+      call.api = "database";
+      call.method = method;
+      call.params = params;
+      return true;
+   }
+   if( params.size() < 2 )
+      return false;
+   // The database API is registered first on every connection of a node, the others are known by name only
+   if( params[0].is_string() )
+      call.api = params[0].as_string();
+   else if( params[0].as_uint64() == 0 )
+      call.api = "database";
+   else
+      return false;
+   call.method = params[1].as_string();
+   if( params.size() > 2 )
+      call.params = params[2].get_array();
+   return call.api != "login" && call.method != "login";
+}
+
+int record( const string& listen, const string& node, const string& file )
+{
+   std::ofstream out( file, std::ios::app );
+   FC_ASSERT( out, "Unable to open ${f}", ("f", file) );
+   std::mutex out_mutex;
+   const fc::time_point start = fc::time_point::now();
+   uint64_t recorded = 0;
+
+   fc::http::websocket_client upstream_client;
+   fc::http::websocket_server server( "" );
+   server.on_connection( [&]( const fc::http::websocket_connection_ptr& c ) {
+      auto upstream = upstream_client.connect( node );
+      fc::http::websocket_connection* client = c.get();
+      upstream->on_message_handler( [client]( const string& reply ) {
+         client->send_message( reply );
+      });
+      c->on_message_handler( [&,upstream]( const string& message ) {
+         upstream->send_message( message );
+         try {
+            recorded_call call;
+            if( !parse_call( message, call ) )
+               return;
+            std::lock_guard<std::mutex> guard( out_mutex );
+            out << fc::json::to_string( fc::mutable_variant_object
+                                           ( "offset_us", ( fc::time_point::now() - start ).count() )
+                                           ( "api", call.api )
+                                           ( "method", call.method )
+                                           ( "params", call.params ) ) << "\n";
+            out.flush();
+            if( ++recorded % 1000 == 0 )
+               std::cerr << "\rrecorded " << recorded << " calls";
+         } catch( const fc::exception& e ) {
+            wlog( "Not recording a message: ${e}", ("e", e.to_string()) );
+         }
+      });
+      c->set_session_data( upstream );
+   });
+   server.listen( fc::ip::endpoint::from_string( listen ) );
+   server.start_accept();
+   std::cerr << "Recording calls to " << node << " made through " << listen << " into " << file
+             << ", press Ctrl-C to stop\n";
+
+   fc::promise<int>::ptr exit_promise = fc::promise<int>::create( "UNIX Signal Handler" );
+#ifndef WIN32
+   fc::set_signal_handler( [&exit_promise]( int signal ) { exit_promise->set_value( signal ); }, SIGINT );
+   fc::set_signal_handler( [&exit_promise]( int signal ) { exit_promise->set_value( signal ); }, SIGTERM );
+#endif
+   exit_promise->wait();
+   std::cerr << "\nrecorded " << recorded << " calls\n";
+   return 0;
+}
+
+struct method_stats
+{
+   vector<int64_t> latencies_us;
+   uint64_t        errors = 0;
+};
+
+int replay( const string& node, const string& file, uint32_t connections, double speedup, const string& report )
+{
+   vector<recorded_call> calls;
+   {
+      std::ifstream in( file );
+      FC_ASSERT( in, "Unable to open ${f}", ("f", file) );
+      string line;
+      while( std::getline( in, line ) )
+      {
+         if( line.empty() )
+            continue;
+         const fc::variant_object v = fc::json::from_string( line ).get_object();
+         recorded_call call;
+         call.offset_us = v["offset_us"].as_int64();
+         call.api = v["api"].as_string();
+         call.method = v["method"].as_string();
+         call.params = v["params"].get_array();
+         calls.push_back( std::move( call ) );
+      }
+   }
+   FC_ASSERT( !calls.empty(), "No calls in ${f}", ("f", file) );
+   connections = std::max<uint32_t>( connections, 1 );
+   std::cerr << "Replaying " << calls.size() << " calls to " << node << " over " << connections << " connections\n";
+
+   // Every connection runs in its own thread, calls are dealt to them in turn
+   vector<std::unique_ptr<fc::thread>> threads;
+   vector<std::map<string, method_stats>> results( connections );
+   vector<fc::future<void>> done;
+   const fc::time_point start = fc::time_point::now() + fc::milliseconds( 500 );
+   for( uint32_t w = 0; w < connections; ++w )
+   {
+      threads.emplace_back( new fc::thread( "replay" + std::to_string( w ) ) );
+      done.push_back( threads.back()->async( [&,w]() {
+         fc::http::websocket_client client;
+         auto apic = std::make_shared<fc::rpc::websocket_api_connection>( client.connect( node ),
+                                                                          GRAPHENE_MAX_NESTED_OBJECTS );
+         apic->send_call( 1, "login", { fc::variant( "" ), fc::variant( "" ) } );
+         std::map<string, fc::api_id_type> api_ids;
+         auto& stats = results[w];
+         for( size_t i = w; i < calls.size(); i += connections )
+         {
+            const recorded_call& call = calls[i];
+            if( speedup > 0 )
+            {
+               const fc::time_point due = start + fc::microseconds( int64_t( call.offset_us / speedup ) );
+               if( due > fc::time_point::now() )
+                  fc::usleep( due - fc::time_point::now() );
+            }
+            auto& method = stats[ call.api + "." + call.method ];
+            try {
+               auto id = api_ids.find( call.api );
+               if( id == api_ids.end() )
+                  id = api_ids.emplace( call.api, apic->send_call( 1, call.api ).as<fc::api_id_type>( 1 ) ).first;
+               const fc::time_point sent = fc::time_point::now();
+               apic->send_call( id->second, call.method, call.params );
+               method.latencies_us.push_back( ( fc::time_point::now() - sent ).count() );
+            } catch( const fc::exception& e ) {
+               ++method.errors;
+            }
+         }
+      }, "replay" ) );
+   }
+   for( auto& d : done )
+      d.wait();
+   const fc::microseconds elapsed = fc::time_point::now() - start;
+
+   std::map<string, method_stats> merged;
+   for( auto& r : results )
+      for( auto& item : r )
+      {
+         auto& m = merged[item.first];
+         m.latencies_us.insert( m.latencies_us.end(), item.second.latencies_us.begin(), item.second.latencies_us.end() );
+         m.errors += item.second.errors;
+      }
+
+   fc::variants methods;
+   std::cout << std::left << std::setw(48) << "method" << " calls errors  p50_us  p90_us  p99_us  max_us\n";
+   for( auto& item : merged )
+   {
+      auto& lat = item.second.latencies_us;
+      std::sort( lat.begin(), lat.end() );
+      auto percentile = [&lat]( uint32_t p ) { return lat.empty() ? 0 : lat[ ( ( lat.size() - 1 ) * p ) / 100 ]; };
+      std::cout << std::left << std::setw(48) << item.first << " " << lat.size() << " " << item.second.errors
+                << " " << percentile(50) << " " << percentile(90) << " " << percentile(99) << " " << percentile(100)
+                << "\n";
+      methods.emplace_back( fc::mutable_variant_object( "method", item.first )
+                                                      ( "calls", lat.size() )
+                                                      ( "errors", item.second.errors )
+                                                      ( "p50_us", percentile(50) )
+                                                      ( "p90_us", percentile(90) )
+                                                      ( "p99_us", percentile(99) )
+                                                      ( "max_us", percentile(100) ) );
+   }
+   std::cout << calls.size() << " calls in " << elapsed.count() / 1000 << "ms\n";
+   if( !report.empty() )
+   {
+      std::ofstream out( report, std::ios::trunc );
+      out << fc::json::to_pretty_string( fc::mutable_variant_object( "elapsed_us", elapsed.count() )
+                                                                   ( "connections", connections )
+                                                                   ( "speedup", speedup )
+                                                                   ( "methods", methods ) ) << "\n";
+   }
+   return 0;
+}
+
+} // namespace
+
+int main( int argc, char** argv )
+{
+   try
+   {
+      bpo::options_description cli_options("RevPop API load test");
+      cli_options.add_options()
+            ("help,h", "Print this help message and exit.")
+            ("mode", bpo::value<string>()->default_value("replay"), "Either record or replay")
+            ("node", bpo::value<string>()->default_value("ws://127.0.0.1:8090"), "Websocket endpoint of the node")
+            ("file,f", bpo::value<string>()->default_value("api_calls.jsonl"), "File of recorded calls")
+            ("listen", bpo::value<string>()->default_value("127.0.0.1:8091"),
+             "Endpoint to accept client connections on when recording")
+            ("connections,c", bpo::value<uint32_t>()->default_value(8), "Number of connections to replay over")
+            ("speedup,s", bpo::value<double>()->default_value(1),
+             "Replay the recorded pacing this many times as fast, 0 sends every call as soon as possible")
+            ("report", bpo::value<string>()->default_value(""), "File to write the replay results to as JSON")
+            ;
+
+      bpo::variables_map options;
+      try
+      {
+         bpo::store( bpo::parse_command_line(argc, argv, cli_options), options );
+      }
+      catch (const bpo::error& e)
+      {
+         std::cerr << "api_load_test:  error parsing command line: " << e.what() << "\n";
+         return 1;
+      }
+
+      if( options.count("help") )
+      {
+         std::cout << cli_options << "\n";
+         return 0;
+      }
+
+      const string mode = options["mode"].as<string>();
+      if( mode == "record" )
+         return record( options["listen"].as<string>(), options["node"].as<string>(), options["file"].as<string>() );
+      if( mode == "replay" )
+         return replay( options["node"].as<string>(), options["file"].as<string>(),
+                        options["connections"].as<uint32_t>(), options["speedup"].as<double>(),
+                        options["report"].as<string>() );
+      std::cerr << "api_load_test:  unknown mode " << mode << "\n";
+      return 1;
+   }
+   catch ( const fc::exception& e )
+   {
+      std::cerr << e.to_detail_string() << "\n";
+      return 1;
+   }
+}
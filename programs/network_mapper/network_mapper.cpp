@@ -10,9 +10,13 @@
 #include <queue>
 #include <future>
 
+#include <boost/program_options.hpp>
+
 #include <graphene/chain/database.hpp>
 #include <graphene/net/peer_connection.hpp>
 
+namespace bpo = boost::program_options;
+
 class peer_probe : public graphene::net::peer_connection_delegate
 {
 public:
@@ -25,6 +29,12 @@ public:
   bool _connection_was_rejected;
   bool _done;
   fc::promise<void>::ptr _probe_complete_promise;
+  fc::future<void> _start_task;
+
+  fc::time_point _start_time;
+  fc::time_point _hello_sent_time;
+  fc::time_point _first_reply_time;
+  fc::variant_object _user_data;
 
 public:
   peer_probe() :
@@ -41,6 +51,7 @@ public:
              const graphene::chain::chain_id_type& chain_id)
   {
     _remote = endpoint_to_probe;
+    _start_time = fc::time_point::now();
     fc::future<void> connect_task = fc::async([this](){ _connection->connect_to(_remote); }, "connect_task");
     try
     {
@@ -66,12 +77,31 @@ public:
 				  chain_id,
                                   fc::variant_object());
 
+    _hello_sent_time = fc::time_point::now();
     _connection->send_message(hello);
   }
 
+  /// Round trip of the handshake: our hello to the first reply of the peer
+  fc::optional<fc::microseconds> rtt()const
+  {
+    if( _first_reply_time == fc::time_point() || _hello_sent_time == fc::time_point() )
+      return {};
+    return _first_reply_time - _hello_sent_time;
+  }
+
+  /// Head block time the peer reported in its hello, if any
+  fc::optional<fc::time_point_sec> head_block_time()const
+  {
+    if( !_user_data.contains("last_known_block_time") )
+      return {};
+    return _user_data["last_known_block_time"].as<fc::time_point_sec>( 1 );
+  }
+
   void on_message(graphene::net::peer_connection* originating_peer,
                   const graphene::net::message& received_message) override
   {
+    if( _first_reply_time == fc::time_point() )
+      _first_reply_time = fc::time_point::now();
     graphene::net::message_hash_type message_hash = received_message.id();
     dlog( "handling message ${type} ${hash} size ${size} from peer ${endpoint}",
           ( "type", graphene::net::core_message_type_enum(received_message.msg_type.value() ) )("hash", message_hash )
@@ -105,6 +135,7 @@ public:
                         const graphene::net::hello_message& hello_message_received)
   {
     _node_id = hello_message_received.node_public_key;
+    _user_data = hello_message_received.user_data;
     if (hello_message_received.user_data.contains("node_id"))
       originating_peer->node_id = hello_message_received.user_data["node_id"].as<graphene::net::node_id_t>( 1 );
     originating_peer->send_message(graphene::net::connection_rejected_message());
@@ -165,32 +196,116 @@ public:
   }
 };
 
+/// What a probe found out about the latency of a node
+struct node_latency
+{
+  fc::ip::endpoint endpoint;
+  fc::optional<fc::microseconds> rtt;
+  /// Time the first reply of the node arrived minus half the round trip, minus the time of its head block
+  fc::optional<int64_t> head_lag_ms;
+  /// Block slots between the slot of the measurement and the head block of the node
+  fc::optional<int64_t> slots_behind;
+  uint32_t head_block_num = 0;
+  std::string platform;
+};
+
+/// Node colors in the graph by how far the head block of the node lags behind the slot time
+static const char* lag_color( const node_latency& l, uint32_t block_interval )
+{
+  if( !l.head_lag_ms.valid() )
+    return "gray";
+  if( *l.head_lag_ms <= int64_t( block_interval ) * 1000 )
+    return "green";
+  if( *l.head_lag_ms <= int64_t( block_interval ) * 3000 )
+    return "orange";
+  return "red";
+}
+
+static node_latency measure( const peer_probe& probe, uint32_t block_interval )
+{
+  node_latency result;
+  result.endpoint = probe._remote;
+  result.rtt = probe.rtt();
+  if( probe._user_data.contains("last_known_block_number") )
+    result.head_block_num = probe._user_data["last_known_block_number"].as<uint32_t>( 1 );
+  if( probe._user_data.contains("platform") )
+    result.platform = probe._user_data["platform"].as_string();
+  auto head_time = probe.head_block_time();
+  if( head_time.valid() && result.rtt.valid() )
+  {
+    // the node sent its hello about half a round trip before we received it
+    const fc::time_point measured_at = probe._first_reply_time - fc::microseconds( result.rtt->count() / 2 );
+    result.head_lag_ms = ( measured_at - fc::time_point( *head_time ) ).count() / 1000;
+    const int64_t slot_sec = measured_at.sec_since_epoch() / block_interval * block_interval;
+    result.slots_behind = ( slot_sec - int64_t( head_time->sec_since_epoch() ) ) / int64_t( block_interval );
+  }
+  return result;
+}
+
 int main(int argc, char** argv)
 {
   std::queue<fc::ip::endpoint> nodes_to_visit;
   std::set<fc::ip::endpoint> nodes_to_visit_set;
   std::set<fc::ip::endpoint> nodes_already_visited;
 
-  if ( argc < 3 ) {
-     std::cerr << "Usage: " << argv[0] << " <chain-id> <seed-addr> [<seed-addr> ...]\n";
+  bpo::options_description cli_options("Usage: network_mapper [options] <chain-id> <seed-addr> [<seed-addr> ...]\n"
+                                       "Options");
+  cli_options.add_options()
+     ("help,h", "Print this help message and exit")
+     ("max-connections", bpo::value<uint32_t>()->default_value(64), "Number of nodes probed at the same time")
+     ("probe-timeout", bpo::value<uint32_t>()->default_value(30), "Seconds after which a probe is given up")
+     ("block-interval", bpo::value<uint32_t>()->default_value(GRAPHENE_DEFAULT_BLOCK_INTERVAL),
+      "Block interval of the chain in seconds, for the head block lag of nodes")
+     ("output-dir,o", bpo::value<std::string>(),
+      "Directory for network_graph.dot and network_map.json, a temporary directory by default")
+     ("chain-id", bpo::value<std::string>(), "Chain ID of the network")
+     ("seed", bpo::value<std::vector<std::string>>()->composing(), "Address of a node to start at, host[:port]");
+  bpo::positional_options_description positional;
+  positional.add("chain-id", 1);
+  positional.add("seed", -1);
+
+  bpo::variables_map options;
+  try
+  {
+     bpo::store( bpo::command_line_parser(argc, argv).options(cli_options).positional(positional).run(), options );
+     bpo::notify( options );
+  }
+  catch (const std::exception& e)
+  {
+     std::cerr << e.what() << "\n" << cli_options << "\n";
      exit(1);
   }
+  if ( options.count("help") || !options.count("chain-id") || !options.count("seed") ) {
+     std::cerr << cli_options << "\n";
+     exit(1);
+  }
+
+  const uint32_t max_connections = std::max<uint32_t>( options["max-connections"].as<uint32_t>(), 1 );
+  const fc::microseconds probe_timeout = fc::seconds( options["probe-timeout"].as<uint32_t>() );
+  const uint32_t block_interval = std::max<uint32_t>( options["block-interval"].as<uint32_t>(), 1 );
 
-  const graphene::chain::chain_id_type chain_id( argv[1] );
-  for ( int i = 2; i < argc; i++ )
+  const graphene::chain::chain_id_type chain_id( options["chain-id"].as<std::string>() );
+  for ( const std::string& ep : options["seed"].as<std::vector<std::string>>() )
   {
-     std::string ep(argv[i]);
      uint16_t port;
      auto pos = ep.find(':');
-     if (pos > 0)
+     if (pos != std::string::npos)
         port = boost::lexical_cast<uint16_t>( ep.substr( pos+1, ep.size() ) );
      else
         port = 2771;
-     for (const auto& addr : fc::resolve( ep.substr( 0, pos > 0 ? pos : ep.size() ), port ))
-        nodes_to_visit.push( addr );
+     for (const auto& addr : fc::resolve( ep.substr( 0, pos != std::string::npos ? pos : ep.size() ), port ))
+     {
+        if( nodes_to_visit_set.insert( addr ).second )
+           nodes_to_visit.push( addr );
+     }
+  }
+  if ( nodes_to_visit.empty() ) {
+     std::cerr << "Unable to resolve any seed address\n";
+     exit(1);
   }
 
-  fc::path data_dir = fc::temp_directory_path() / ("network_map_" + (fc::string) chain_id);
+  fc::path data_dir = options.count("output-dir") ? fc::path( options["output-dir"].as<std::string>() )
+                                                  : fc::temp_directory_path() / ("network_map_" + (fc::string) chain_id);
   fc::create_directories(data_dir);
 
   fc::ip::endpoint seed_node1 = nodes_to_visit.front();
@@ -198,34 +313,41 @@ int main(int argc, char** argv)
   fc::ecc::private_key my_node_id = fc::ecc::private_key::generate();
   std::map<graphene::net::node_id_t, graphene::net::address_info> address_info_by_node_id;
   std::map<graphene::net::node_id_t, std::vector<graphene::net::address_info> > connections_by_node_id;
+  std::map<graphene::net::node_id_t, node_latency> latency_by_node_id;
   std::vector<std::shared_ptr<peer_probe>> probes;
+  // probes given up on are kept, their connection may still call them back
+  std::vector<std::shared_ptr<peer_probe>> abandoned_probes;
 
   while (!nodes_to_visit.empty() || !probes.empty())
   {
-    while (!nodes_to_visit.empty())
+    // connects run concurrently, up to max_connections nodes are probed at a time
+    while (!nodes_to_visit.empty() && probes.size() < max_connections)
     {
        fc::ip::endpoint remote = nodes_to_visit.front();
        nodes_to_visit.pop();
        nodes_to_visit_set.erase( remote );
        nodes_already_visited.insert( remote );
 
-       try
-       {
-          std::shared_ptr<peer_probe> probe(new peer_probe());
-          probe->start(remote, my_node_id, chain_id);
-          probes.emplace_back( std::move( probe ) );
-       }
-       catch (const fc::exception&)
-       {
-          std::cerr << "Failed to connect " << fc::string(remote) << " - skipping!" << std::endl;
-       }
+       std::shared_ptr<peer_probe> probe(new peer_probe());
+       peer_probe* p = probe.get();
+       probe->_start_task = fc::async( [p, remote, &my_node_id, &chain_id]() {
+          p->start(remote, my_node_id, chain_id);
+       }, "probe_start" );
+       probes.emplace_back( std::move( probe ) );
     }
 
     if (!probes.empty())
     {
-       fc::yield();
+       fc::usleep( fc::milliseconds(10) );
+       const fc::time_point now = fc::time_point::now();
        std::vector<std::shared_ptr<peer_probe>> running;
        for ( auto& probe : probes ) {
+          if (probe->_start_task.valid() && probe->_start_task.ready() && probe->_start_task.error())
+          {
+             std::cerr << "Failed to connect " << fc::string(probe->_remote) << " - skipping!" << std::endl;
+             abandoned_probes.push_back( probe );
+             continue;
+          }
           if (probe->_probe_complete_promise->error())
           {
              std::cerr << fc::string(probe->_remote) << " ran into an error!\n";
@@ -233,7 +355,14 @@ int main(int argc, char** argv)
           }
           if (!probe->_probe_complete_promise->ready())
           {
-             running.push_back( probe );
+             if( now - probe->_start_time > probe_timeout && probe->_start_task.ready() )
+             {
+                std::cerr << fc::string(probe->_remote) << " timed out - skipping!" << std::endl;
+                probe->_connection->close_connection();
+                abandoned_probes.push_back( probe );
+             }
+             else
+                running.push_back( probe );
              continue;
           }
 
@@ -248,6 +377,7 @@ int main(int argc, char** argv)
              connections_by_node_id[this_node_info.node_id] = probe->_peers;
              if (address_info_by_node_id.find(this_node_info.node_id) == address_info_by_node_id.end())
                 address_info_by_node_id[this_node_info.node_id] = this_node_info;
+             latency_by_node_id[this_node_info.node_id] = measure( *probe, block_interval );
           }
 
           for (const graphene::net::address_info& info : probe->_peers)
@@ -263,10 +393,11 @@ int main(int argc, char** argv)
                 address_info_by_node_id[info.node_id] = info;
           }
        }
+       if( running.size() != probes.size() )
+          std::cout << address_info_by_node_id.size() << " checked, "
+                    << running.size() << " active, "
+                    << nodes_to_visit.size() << " to do\n";
        probes = std::move( running );
-       std::cout << address_info_by_node_id.size() << " checked, "
-                 << probes.size() << " active, "
-                 << nodes_to_visit.size() << " to do\n";
     }
   }
 
@@ -298,21 +429,70 @@ int main(int argc, char** argv)
   dot_stream << "  // Seed node is missing connections to " << seed_node_missing_connections.size() << " non-firewalled nodes:\n";
   for (const graphene::net::node_id_t& id : seed_node_missing_connections)
     dot_stream << "  //           " << (std::string)address_info_by_node_id[id].remote_endpoint << "\n";
+  dot_stream << "  // Nodes are labeled with the round trip of the handshake and the lag of their head block behind the\n"
+             << "  // time they answered, green within one block interval (" << block_interval << "s), orange within three,\n"
+             << "  // red beyond. Edges to a lagging node are drawn in its color.\n";
 
   dot_stream << "  layout=\"circo\";\n";
 
   for (const auto& address_info_for_node : address_info_by_node_id)
   {
-    dot_stream << "  \"" << fc::variant( address_info_for_node.first, 1 ).as_string() << "\"[label=\"" << (std::string)address_info_for_node.second.remote_endpoint << "\"";
+    dot_stream << "  \"" << fc::variant( address_info_for_node.first, 1 ).as_string() << "\"[label=\"" << (std::string)address_info_for_node.second.remote_endpoint;
+    auto latency = latency_by_node_id.find( address_info_for_node.first );
+    if( latency != latency_by_node_id.end() )
+    {
+      if( latency->second.rtt.valid() )
+        dot_stream << "\\nrtt " << latency->second.rtt->count() / 1000 << " ms";
+      if( latency->second.head_lag_ms.valid() )
+        dot_stream << "\\nhead lag " << *latency->second.head_lag_ms << " ms";
+      dot_stream << "\",color=" << lag_color( latency->second, block_interval );
+    }
+    else
+      dot_stream << "\"";
     if (address_info_for_node.second.firewalled != graphene::net::firewalled_state::not_firewalled)
       dot_stream << ",shape=rectangle";
     dot_stream << "];\n";
   }
   for (auto& node_and_connections : connections_by_node_id)
     for (const graphene::net::address_info& this_connection : node_and_connections.second)
-      dot_stream << "  \"" << fc::variant( node_and_connections.first, 2 ).as_string() << "\" -- \"" << fc::variant( this_connection.node_id, 1 ).as_string() << "\";\n";
+    {
+      dot_stream << "  \"" << fc::variant( node_and_connections.first, 2 ).as_string() << "\" -- \"" << fc::variant( this_connection.node_id, 1 ).as_string() << "\"";
+      auto latency = latency_by_node_id.find( this_connection.node_id );
+      if( latency != latency_by_node_id.end() && latency->second.head_lag_ms.valid()
+          && *latency->second.head_lag_ms > int64_t( block_interval ) * 1000 )
+        dot_stream << "[color=" << lag_color( latency->second, block_interval ) << "]";
+      dot_stream << ";\n";
+    }
 
   dot_stream << "}\n";
 
+  fc::variants nodes;
+  for (const auto& address_info_for_node : address_info_by_node_id)
+  {
+    fc::mutable_variant_object node;
+    node( "node_id", fc::variant( address_info_for_node.first, 1 ) )
+        ( "endpoint", (std::string)address_info_for_node.second.remote_endpoint )
+        ( "firewalled", address_info_for_node.second.firewalled != graphene::net::firewalled_state::not_firewalled );
+    auto latency = latency_by_node_id.find( address_info_for_node.first );
+    if( latency != latency_by_node_id.end() )
+    {
+      if( latency->second.rtt.valid() )
+        node( "rtt_us", latency->second.rtt->count() );
+      if( latency->second.head_lag_ms.valid() )
+        node( "head_lag_ms", *latency->second.head_lag_ms )( "slots_behind", *latency->second.slots_behind );
+      node( "head_block_num", latency->second.head_block_num )( "platform", latency->second.platform );
+    }
+    fc::variants connections;
+    for (const graphene::net::address_info& info : connections_by_node_id[address_info_for_node.first])
+      connections.emplace_back( fc::variant( info.node_id, 1 ) );
+    node( "connections", connections );
+    nodes.emplace_back( node );
+  }
+  fc::json::save_to_file( fc::mutable_variant_object( "block_interval", block_interval )( "nodes", nodes ),
+                          data_dir / "network_map.json" );
+
+  std::cout << "Wrote " << (data_dir / "network_graph.dot").string() << " and "
+            << (data_dir / "network_map.json").string() << "\n";
+
   return 0;
 }
@@ -27,16 +27,21 @@
 #include <fc/variant.hpp>
 #include <fc/variant_object.hpp>
 
+#include <graphene/chain/block_database.hpp>
 #include <graphene/protocol/block.hpp>
 #include <graphene/protocol/fee_schedule.hpp>
 
+#include <boost/program_options.hpp>
+
 #include <algorithm>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <string>
 #include <vector>
 
 using namespace graphene::protocol;
+namespace bpo = boost::program_options;
 
 vector< fc::variant_object > g_op_types;
 
@@ -65,8 +70,231 @@ struct size_check_type_visitor
    }
 };
 
+/// Exact distribution of a size, sizes are few distinct values
+class size_distribution
+{
+   public:
+      void add( uint64_t size ) { ++_counts[size]; ++_count; _total += size; }
+      uint64_t count()const { return _count; }
+      uint64_t total()const { return _total; }
+
+      /// Smallest size at least @p fraction of the values are not larger than
+      uint64_t percentile( double fraction )const
+      {
+         const uint64_t wanted = std::max<uint64_t>( 1, uint64_t( fraction * _count + 0.5 ) );
+         uint64_t seen = 0;
+         for( const auto& item : _counts )
+         {
+            seen += item.second;
+            if( seen >= wanted )
+               return item.first;
+         }
+         return 0;
+      }
+
+      fc::mutable_variant_object to_variant()const
+      {
+         fc::mutable_variant_object vo;
+         vo["count"] = _count;
+         vo["total"] = _total;
+         if( _count > 0 )
+         {
+            vo["min"] = _counts.begin()->first;
+            vo["max"] = _counts.rbegin()->first;
+            vo["mean"] = double( _total ) / _count;
+            vo["p50"] = percentile( 0.5 );
+            vo["p90"] = percentile( 0.9 );
+            vo["p99"] = percentile( 0.99 );
+         }
+         return vo;
+      }
+
+   private:
+      std::map<uint64_t, uint64_t> _counts;
+      uint64_t _count = 0;
+      uint64_t _total = 0;
+};
+
+/// What the block log holds of one operation type
+struct operation_sizes
+{
+   std::string name;
+   size_distribution sizes;
+   /// Fees paid in the core asset and the size of the operations which paid them
+   uint64_t core_fees = 0;
+   uint64_t core_fee_bytes = 0;
+   uint64_t non_core_fee_count = 0;
+   std::map<std::string, size_distribution> string_fields;
+};
+
+/// Adds the lengths of the string members of an operation to its statistics
+template< typename Op >
+struct string_field_visitor
+{
+   const Op& op;
+   operation_sizes& stats;
+
+   template< typename Member, class Class, Member( Class::*member ) >
+   void operator()( const char* name )const
+   {
+      add( name, op.*member );
+   }
+
+   void add( const char* name, const std::string& value )const { stats.string_fields[name].add( value.size() ); }
+   void add( const char* name, const fc::optional<std::string>& value )const
+   {
+      if( value.valid() )
+         add( name, *value );
+   }
+   template< typename T >
+   void add( const char*, const T& )const {}
+};
+
+struct operation_scan_visitor
+{
+   typedef void result_type;
+
+   operation_sizes& stats;
+
+   template< typename Op >
+   void operator()( const Op& op )const
+   {
+      const uint64_t size = fc::raw::pack_size( op );
+      stats.sizes.add( size );
+      if( op.fee.asset_id == asset_id_type() )
+      {
+         stats.core_fees += op.fee.amount.value;
+         stats.core_fee_bytes += size;
+      }
+      else
+         ++stats.non_core_fee_count;
+      fc::reflector<Op>::visit( string_field_visitor<Op>{ op, stats } );
+   }
+};
+
+struct operation_name_visitor
+{
+   typedef void result_type;
+
+   std::string& name;
+
+   template< typename Op >
+   void operator()( const Op& )const { name = fc::get_typename<Op>::name(); }
+};
+
+/// Reports serialized sizes, fees per byte and string field lengths of the operations in a block log
+static void scan_block_log( const fc::path& blockchain_dir, uint32_t first, uint32_t last )
+{
+   graphene::chain::block_database blocks;
+   blocks.open( blockchain_dir / "database" / "block_num_to_block" );
+   auto head = blocks.last();
+   FC_ASSERT( head.valid(), "No blocks in ${d}", ("d", blockchain_dir) );
+   last = std::min( last, head->block_num() );
+   first = std::max( first, blocks.first_block_num() );
+
+   graphene::protocol::operation op;
+   vector<operation_sizes> stats( op.count() );
+   for( size_t i = 0; i < op.count(); ++i )
+   {
+      op.set_which(i);
+      op.visit( operation_name_visitor{ stats[i].name } );
+   }
+
+   size_distribution block_sizes;
+   size_distribution transaction_sizes;
+   uint64_t blocks_scanned = 0;
+   for( uint32_t block_num = first; block_num <= last; ++block_num )
+   {
+      auto block = blocks.fetch_by_number( block_num );
+      if( !block.valid() )
+         continue;
+      ++blocks_scanned;
+      block_sizes.add( fc::raw::pack_size( *block ) );
+      for( const auto& trx : block->transactions )
+      {
+         transaction_sizes.add( fc::raw::pack_size( trx ) );
+         for( const auto& o : trx.operations )
+            o.visit( operation_scan_visitor{ stats[ o.which() ] } );
+      }
+      if( block_num % 100000 == 0 )
+         std::cerr << "Scanned block " << block_num << " of " << last << "\n";
+   }
+   blocks.close();
+
+   // the operation types which take up most of the block log first
+   std::stable_sort( stats.begin(), stats.end(), []( const operation_sizes& a, const operation_sizes& b ) {
+      return a.sizes.total() > b.sizes.total();
+   });
+   fc::variants operations;
+   for( const auto& s : stats )
+   {
+      if( s.sizes.count() == 0 )
+         continue;
+      fc::mutable_variant_object vo;
+      vo["name"] = s.name;
+      vo["size"] = s.sizes.to_variant();
+      vo["core_fees"] = s.core_fees;
+      if( s.core_fee_bytes > 0 )
+         vo["core_fee_per_byte"] = double( s.core_fees ) / s.core_fee_bytes;
+      vo["non_core_fee_count"] = s.non_core_fee_count;
+      fc::mutable_variant_object fields;
+      for( const auto& field : s.string_fields )
+         fields[field.first] = field.second.to_variant();
+      vo["string_fields"] = fields;
+      operations.emplace_back( vo );
+   }
+
+   fc::mutable_variant_object report;
+   report["first_block"] = first;
+   report["last_block"] = last;
+   report["blocks"] = blocks_scanned;
+   report["block_size"] = block_sizes.to_variant();
+   report["transaction_size"] = transaction_sizes.to_variant();
+   report["operations"] = operations;
+   std::cout << fc::json::to_pretty_string( report ) << "\n";
+}
+
 int main( int argc, char** argv )
 {
+   bpo::options_description cli_options( "Without --blockchain-dir, prints the sizes of empty operations\nOptions" );
+   cli_options.add_options()
+      ( "help,h", "Print this help message and exit" )
+      ( "blockchain-dir", bpo::value<std::string>(),
+        "Report the sizes of the operations in the block log of a node, e.g. <data-dir>/blockchain" )
+      ( "first-block", bpo::value<uint32_t>()->default_value( 1 ), "First block to scan" )
+      ( "last-block", bpo::value<uint32_t>()->default_value( std::numeric_limits<uint32_t>::max() ),
+        "Last block to scan, the head block by default" );
+   bpo::variables_map options;
+   try
+   {
+      bpo::store( bpo::parse_command_line( argc, argv, cli_options ), options );
+      bpo::notify( options );
+   }
+   catch( const std::exception& e )
+   {
+      std::cerr << e.what() << "\n" << cli_options << "\n";
+      return 1;
+   }
+   if( options.count( "help" ) )
+   {
+      std::cout << cli_options << "\n";
+      return 0;
+   }
+   if( options.count( "blockchain-dir" ) )
+   {
+      try
+      {
+         scan_block_log( options["blockchain-dir"].as<std::string>(), options["first-block"].as<uint32_t>(),
+                         options["last-block"].as<uint32_t>() );
+      }
+      catch( const fc::exception& e )
+      {
+         edump((e.to_detail_string()));
+         return 1;
+      }
+      return 0;
+   }
+
    try
    {
       graphene::protocol::operation op;
@@ -37,6 +37,7 @@
 #include <graphene/api_helper_indexes/api_helper_indexes.hpp>
 #include <graphene/custom_operations/custom_operations_plugin.hpp>
 #include <graphene/content_cards/content_cards.hpp>
+#include <graphene/event_stream/event_stream_plugin.hpp>
 
 #include <fc/thread/thread.hpp>
 #include <fc/interprocess/signals.hpp>
@@ -123,6 +124,7 @@ int main(int argc, char** argv) {
       node->register_plugin<graphene::api_helper_indexes::api_helper_indexes>();
       node->register_plugin<graphene::custom_operations::custom_operations_plugin>();
       node->register_plugin<graphene::content_cards::content_cards_plugin>();
+      node->register_plugin<graphene::event_stream::event_stream_plugin>();
 
       // add plugin options to config
       try
@@ -211,6 +213,12 @@ int main(int argc, char** argv) {
 
       node->startup();
 
+      if( options.count("replay-end-block") > 0 )
+      {
+         ilog( "Replayed up to block ${h}, exiting", ("h", node->chain_database()->head_block_num()) );
+         return EXIT_SUCCESS;
+      }
+
       fc::promise<int>::ptr exit_promise = fc::promise<int>::create("UNIX Signal Handler");
 
       fc::set_signal_handler([&exit_promise](int the_signal) {
@@ -0,0 +1,278 @@
+/**
+ * The Revolution Populi Project
+ * Copyright (C) 2022 Revolution Populi Limited
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../common/init_unit_test_suite.hpp"
+
+#include <graphene/chain/database.hpp>
+
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/witness_object.hpp>
+
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/variant_object.hpp>
+
+#include "../common/database_fixture.hpp"
+
+#include <fstream>
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+
+/**
+ * Reproducible workloads for catching performance regressions.
+ *
+ * Every workload has a fixed size, multiplied by the CHAIN_BENCH_SCALE environment variable (default 1).
+ * The results are logged and written as JSON to the file named by CHAIN_BENCH_OUTPUT
+ * (default chain_bench_results.json) when the run ends.
+ */
+namespace {
+
+struct bench_result
+{
+   std::string name;
+   uint64_t    count;
+   int64_t     elapsed_us;
+};
+
+std::vector<bench_result>& bench_results()
+{
+   static std::vector<bench_result> results;
+   return results;
+}
+
+uint32_t bench_scale()
+{
+   const char* scale = getenv( "CHAIN_BENCH_SCALE" );
+   return scale != nullptr ? std::max<uint32_t>( std::stoul( scale ), 1 ) : 1;
+}
+
+void record( const std::string& name, uint64_t count, const fc::microseconds& elapsed )
+{
+   bench_results().push_back( { name, count, elapsed.count() } );
+   wlog( "${ops} ${what}/s over ${total}ms",
+         ("ops",(count*1000000)/std::max<int64_t>(elapsed.count(),1))("what",name)
+         ("total",elapsed.count()/1000) );
+}
+
+struct bench_output
+{
+   ~bench_output()
+   {
+      fc::variants results;
+      for( const auto& r : bench_results() )
+         results.emplace_back( fc::mutable_variant_object()
+                                  ( "name", r.name )
+                                  ( "count", r.count )
+                                  ( "elapsed_us", r.elapsed_us )
+                                  ( "per_second", ( r.count * 1000000 ) / std::max<int64_t>( r.elapsed_us, 1 ) ) );
+      const char* output = getenv( "CHAIN_BENCH_OUTPUT" );
+      std::ofstream out( output != nullptr ? output : "chain_bench_results.json", std::ios::trunc );
+      out << fc::json::to_pretty_string( fc::mutable_variant_object( "scale", bench_scale() )
+                                                                   ( "results", results ) ) << "\n";
+   }
+};
+
+} // namespace
+
+BOOST_GLOBAL_FIXTURE( bench_output );
+
+struct chain_bench_fixture : database_fixture
+{
+   const uint32_t scale = bench_scale();
+   std::vector<signed_transaction> transactions;
+
+   void build( const operation& op )
+   {
+      signed_transaction tx;
+      set_expiration( db, tx );
+      tx.operations.push_back( op );
+      for( auto& o : tx.operations ) db.current_fee_schedule().set_fee( o );
+      transactions.push_back( tx );
+   }
+
+   /// Applies the transactions built so far without undo and records their rate
+   void run( const std::string& what )
+   {
+      db._undo_db.disable();
+      auto start = fc::time_point::now();
+      for( const auto& tx : transactions )
+         db.apply_transaction( tx, ~0 );
+      record( what, transactions.size(), fc::time_point::now() - start );
+      db._undo_db.enable();
+      transactions.clear();
+   }
+};
+
+BOOST_FIXTURE_TEST_SUITE( chain_bench, chain_bench_fixture )
+
+BOOST_AUTO_TEST_CASE( revpop_operations )
+{ try {
+   ACTORS( (alice)(bob) );
+   const uint32_t cycles = 5000 * scale;
+   const std::string storage_data = "[\"GD\",\"1.0\",\"file_id_in_google_disk\"]";
+   fund( alice, asset( 10000000 ) );
+
+   content_card_v2_create_operation cco;
+   cco.subject_account = alice_id;
+   cco.url = "http://some.image.url/img.jpg";
+   cco.type = "image/png";
+   cco.description = "Some image";
+   cco.content_key = generate_private_key( "content" ).get_public_key().to_base58();
+   cco.storage_data = storage_data;
+   for( uint32_t i = 0; i < cycles; ++i )
+   {
+      cco.hash = fc::sha256::hash( fc::to_string(i) ).str();
+      build( cco );
+   }
+   run( "content_card_v2_create" );
+
+   content_vote_create_operation cvo;
+   cvo.subject_account = alice_id;
+   cvo.master_account = bob_id;
+   cvo.master_content_id = "1.0.0";
+   for( uint32_t i = 0; i < cycles; ++i )
+   {
+      cvo.content_id = "1.0." + fc::to_string(i);
+      build( cvo );
+   }
+   run( "content_vote_create" );
+
+   permission_create_operation pco;
+   pco.subject_account = alice_id;
+   pco.operator_account = bob_id;
+   pco.permission_type = "content_card";
+   pco.content_key = cco.content_key;
+   for( uint32_t i = 0; i < cycles; ++i )
+   {
+      pco.object_id = object_id_type( 1, 0, i );
+      build( pco );
+   }
+   run( "permission_create" );
+
+   // personal data is unique per subject and operator, so each one goes to a different operator
+   personal_data_v2_create_operation pdo;
+   pdo.subject_account = alice_id;
+   pdo.url = "http://some.storage.url/pd";
+   pdo.storage_data = storage_data;
+   pdo.hash = fc::sha256::hash( std::string("personal data") ).str();
+   for( uint32_t i = 0; i < cycles; ++i )
+   {
+      pdo.operator_account = create_account( "operator" + fc::to_string(i) ).id;
+      build( pdo );
+   }
+   run( "personal_data_v2_create" );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( order_matching )
+{ try {
+   ACTORS( (maker)(taker) );
+   const uint32_t cycles = 5000 * scale;
+   const asset_id_type uia_id = create_user_issued_asset( "BENCH", maker, 0 ).id;
+   issue_uia( maker, asset( 10 * cycles, uia_id ) );
+   fund( maker, asset( 1000000 ) );
+   fund( taker, asset( 200 * cycles + 1000000 ) );
+
+   limit_order_create_operation ask;
+   ask.seller = maker_id;
+   ask.expiration = time_point_sec::maximum();
+   for( uint32_t i = 0; i < cycles; ++i )
+   {
+      ask.amount_to_sell = asset( 10, uia_id );
+      ask.min_to_receive = asset( 100 + i % 7 );
+      build( ask );
+   }
+   run( "limit_order_create_into_book" );
+
+   // each bid fills one ask
+   limit_order_create_operation bid;
+   bid.seller = taker_id;
+   bid.expiration = time_point_sec::maximum();
+   for( uint32_t i = 0; i < cycles; ++i )
+   {
+      bid.amount_to_sell = asset( 110 );
+      bid.min_to_receive = asset( 10, uia_id );
+      build( bid );
+   }
+   run( "limit_order_create_filling" );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( maintenance )
+{ try {
+   const uint32_t num_accounts = 2000 * scale;
+   flat_set<vote_id_type> votes;
+   for( const witness_object& wit : db.get_index_type<witness_index>().indices() )
+      votes.insert( wit.vote_id );
+
+   account_update_operation auo;
+   for( uint32_t i = 0; i < num_accounts; ++i )
+   {
+      const account_object& voter = create_account( "voter" + fc::to_string(i) );
+      fund( voter, asset( 100000 + i ) );
+      auo.account = voter.id;
+      auo.new_options = voter.options;
+      auo.new_options->votes = votes;
+      auo.new_options->num_witness = static_cast<uint16_t>( votes.size() );
+      build( auo );
+   }
+   run( "account_update_votes" );
+
+   auto start = fc::time_point::now();
+   generate_blocks( db.get_dynamic_global_properties().next_maintenance_time );
+   record( "maintenance_accounts", num_accounts, fc::time_point::now() - start );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( reindex )
+{ try {
+   ACTORS( (alice)(bob) );
+   const uint32_t num_blocks = 200 * scale;
+   const uint32_t transfers_per_block = 50;
+   fund( alice, asset( 1000000000 ) );
+   generate_block();
+
+   for( uint32_t i = 0; i < num_blocks; ++i )
+   {
+      for( uint32_t j = 0; j < transfers_per_block; ++j )
+         transfer( alice_id, bob_id, asset( 1 + j ) );
+      generate_block();
+   }
+
+   // A copy of the chain in its own data directory, replayed from its block log
+   fc::temp_directory bench_dir( graphene::utilities::temp_directory_path() );
+   const auto genesis = genesis_state;
+   const uint32_t head_num = db.head_block_num();
+   {
+      database db2;
+      db2.open( bench_dir.path(), [&genesis]{ return genesis; }, "TEST" );
+      for( uint32_t n = 1; n <= head_num; ++n )
+         db2.push_block( *db.fetch_block_by_number( n ), database::skip_nothing );
+      db2.close( false );
+   }
+   {
+      database db2;
+      db2.wipe( bench_dir.path(), false );
+      auto start = fc::time_point::now();
+      db2.open( bench_dir.path(), [&genesis]{ return genesis; }, "TEST" );
+      record( "reindex_blocks", head_num, fc::time_point::now() - start );
+      BOOST_CHECK_EQUAL( db2.head_block_num(), head_num );
+   }
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -142,6 +142,71 @@ database_fixture_base::~database_fixture_base()
 
 }
 
+namespace {
+/// The blocks creating the prepared state, starting with block 1
+std::vector<signed_block>& prepared_state_blocks()
+{
+   static std::vector<signed_block> blocks;
+   return blocks;
+}
+} // namespace
+
+const share_type prepared_state_fixture::prepared_core_balance = 10000000;
+const share_type prepared_state_fixture::prepared_asset_balance = 1000000;
+
+prepared_state_fixture::prepared_state_fixture()
+   : alice_private_key( generate_private_key( "alice" ) ),
+     bob_private_key( generate_private_key( "bob" ) ),
+     alice_id( get_account( "alice" ).id ),
+     bob_id( get_account( "bob" ).id ),
+     prepared_asset_id( get_asset( "PREPARED" ).id )
+{
+}
+
+void prepared_state_fixture::init( database_fixture_init<prepared_state_fixture>& fixture )
+{ try {
+   fixture.data_dir = fc::temp_directory( graphene::utilities::temp_directory_path() );
+   fc::create_directories( fixture.data_dir.path() );
+   init_genesis( fixture );
+   fc::json::save_to_file( fixture.genesis_state, fixture.data_dir.path() / "genesis.json" );
+   auto options = init_options( fixture );
+   fc::set_option( *options, "genesis-json", boost::filesystem::path(fixture.data_dir.path() / "genesis.json") );
+   fixture.app.initialize( fixture.data_dir.path(), options );
+   fixture.app.startup();
+
+   auto& blocks = prepared_state_blocks();
+   if( blocks.empty() )
+   {
+      fixture.generate_block();
+      prepare( fixture );
+      for( uint32_t num = 1; num <= fixture.db.head_block_num(); ++num )
+         blocks.push_back( *fixture.db.fetch_block_by_number( num ) );
+   }
+   else
+   {
+      // the blocks were checked when they were generated
+      for( const signed_block& block : blocks )
+         PUSH_BLOCK( fixture.db, block, ~0 );
+      verify_asset_supplies( fixture.db );
+   }
+
+   test::set_expiration( fixture.db, fixture.trx );
+} FC_LOG_AND_RETHROW() }
+
+void prepared_state_fixture::prepare( database_fixture_base& fixture )
+{
+   const account_object& alice = fixture.create_account( "alice",
+                                                         public_key_type( generate_private_key( "alice" ).get_public_key() ) );
+   const account_object& bob = fixture.create_account( "bob",
+                                                       public_key_type( generate_private_key( "bob" ).get_public_key() ) );
+   fixture.transfer( fixture.committee_account, alice.id, asset( prepared_core_balance ) );
+   fixture.transfer( fixture.committee_account, bob.id, asset( prepared_core_balance ) );
+   const asset_object& prepared_asset = fixture.create_user_issued_asset( "PREPARED", alice, 0 );
+   fixture.issue_uia( alice, asset( prepared_asset_balance, prepared_asset.id ) );
+   fixture.issue_uia( bob, asset( prepared_asset_balance, prepared_asset.id ) );
+   fixture.generate_block();
+}
+
 void database_fixture_base::init_genesis( database_fixture_base& fixture )
 {
    fixture.genesis_state.initial_timestamp = fc::time_point_sec(GRAPHENE_TESTING_GENESIS_TIMESTAMP);
@@ -180,7 +245,8 @@ std::shared_ptr<boost::program_options::variables_map> database_fixture_base::in
    /**
     * Test specific settings
     */
-   if (fixture.current_test_name == "broadcast_transaction_with_callback_test")
+   if (fixture.current_test_name == "broadcast_transaction_with_callback_test"
+         || fixture.current_test_name == "broadcast_transactions_test")
       fc::set_option( options, "enable-p2p-network", true );
    else if (fixture.current_test_name == "broadcast_transaction_disabled_p2p_test")
       fc::set_option( options, "enable-p2p-network", false );
@@ -189,6 +255,15 @@ std::shared_ptr<boost::program_options::variables_map> database_fixture_base::in
    else if( rand() % 100 >= 50 ) // this should lead to no change
       fc::set_option( options, "enable-p2p-network", true );
 
+   if (fixture.current_test_name == "get_account_history_archive")
+   {
+      fc::set_option( options, "max-ops-per-account", (uint64_t)2 );
+      fc::set_option( options, "archive-account-history", true );
+   }
+   if (fixture.current_test_name == "get_account_history_by_operation_type")
+   {
+      fc::set_option( options, "index-history-by-operation-type", true );
+   }
    if (fixture.current_test_name == "get_account_history_operations")
    {
       fc::set_option( options, "max-ops-per-account", (uint64_t)75 );
@@ -364,6 +439,7 @@ std::shared_ptr<boost::program_options::variables_map> database_fixture_base::in
 
    if( fixture.current_test_name == "asset_in_collateral"
             || fixture.current_test_name == "htlc_database_api"
+            || fixture.current_test_name == "personal_data_proof"
             || fixture.current_suite_name == "database_api_tests"
             || fixture.current_suite_name == "api_limit_tests"
             || fixture.current_suite_name == "revpop_14_tests" )
@@ -372,7 +448,8 @@ std::shared_ptr<boost::program_options::variables_map> database_fixture_base::in
    }
 
    if(fixture.current_test_name == "custom_operations_account_storage_map_test" ||
-      fixture.current_test_name == "custom_operations_account_storage_list_test") {
+      fixture.current_test_name == "custom_operations_account_storage_list_test" ||
+      fixture.current_test_name == "custom_operations_account_storage_range_test") {
       fixture.app.register_plugin<graphene::custom_operations::custom_operations_plugin>(true);
       fc::set_option( options, "custom-operations-start-block", uint32_t(1) );
    }
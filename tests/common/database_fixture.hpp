@@ -469,4 +469,30 @@ struct database_fixture : database_fixture_init<database_fixture>
 {
 };
 
+/**
+ * @brief A database_fixture which starts from a prepared state shared by all test cases of the process
+ *
+ * The first fixture prepares the state: the accounts alice and bob, funded with core asset, and the user issued
+ * asset PREPARED issued to both of them. The blocks creating it are kept, and later fixtures push them again
+ * without checking them, instead of building and signing the transactions again. So every test case gets its own
+ * copy of the same state, which is seen by the plugins of the test case like any other pushed blocks.
+ */
+struct prepared_state_fixture : database_fixture_init<prepared_state_fixture>
+{
+   prepared_state_fixture();
+
+   static void init( database_fixture_init<prepared_state_fixture>& fixture );
+   /// Create the prepared state on top of the genesis state
+   static void prepare( database_fixture_base& fixture );
+
+   static const share_type prepared_core_balance;
+   static const share_type prepared_asset_balance;
+
+   const fc::ecc::private_key alice_private_key;
+   const fc::ecc::private_key bob_private_key;
+   account_id_type alice_id;
+   account_id_type bob_id;
+   asset_id_type   prepared_asset_id;
+};
+
 } }
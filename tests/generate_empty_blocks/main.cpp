@@ -26,12 +26,18 @@
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <fstream>
+#include <random>
+#include <sstream>
 
 #include <fc/io/fstream.hpp>
 #include <fc/io/json.hpp>
 #include <fc/io/stdio.hpp>
 
 #include <graphene/app/api.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/balance_object.hpp>
 #include <graphene/egenesis/egenesis.hpp>
 #include <graphene/utilities/key_conversion.hpp>
 
@@ -53,6 +59,191 @@ namespace graphene { namespace app { namespace detail {
 genesis_state_type create_example_genesis();
 } } } // graphene::app::detail
 
+/**
+ * Generates the transactions of a synthetic chain: accounts created in genesis, funded in the first blocks,
+ * then a random mix of operations in every block.
+ */
+class workload
+{
+   public:
+      enum op_kind { transfer, content, vote, order, num_kinds };
+
+      workload( database& db, const fc::ecc::private_key& key, uint32_t num_accounts, uint32_t ops_per_block,
+                const vector<uint32_t>& weights, uint32_t seed )
+      : _db( db ), _key( key ), _num_accounts( num_accounts ), _ops_per_block( ops_per_block ),
+        _pick_kind( weights.begin(), weights.end() ), _rng( seed )
+      {}
+
+      static void add_accounts( genesis_state_type& genesis, const fc::ecc::private_key& key, uint32_t num_accounts )
+      {
+         for( uint32_t i = 0; i < num_accounts; ++i )
+            genesis.initial_accounts.emplace_back( "gen" + fc::to_string(i), key.get_public_key(),
+                                                   key.get_public_key() );
+      }
+
+      /// Claims the genesis stake, creates the asset to trade and funds all accounts, generating blocks as needed
+      template<typename BlockGenerator>
+      void setup( BlockGenerator&& generate )
+      {
+         const auto& by_name = _db.get_index_type<account_index>().indices().get<by_name>();
+         FC_ASSERT( by_name.find( "nathan" ) != by_name.end(), "The genesis needs a nathan account to fund the workload" );
+         _nathan = by_name.find( "nathan" )->id;
+         for( uint32_t i = 0; i < _num_accounts; ++i )
+            _accounts.push_back( by_name.find( "gen" + fc::to_string(i) )->id );
+
+         vector<operation> ops;
+         for( const balance_object& bal : _db.get_index_type<balance_index>().indices() )
+         {
+            balance_claim_operation claim;
+            claim.deposit_to_account = _nathan;
+            claim.balance_to_claim = bal.id;
+            claim.balance_owner_key = _key.get_public_key();
+            claim.total_claimed = bal.balance;
+            ops.push_back( claim );
+         }
+         asset_create_operation create;
+         create.issuer = _nathan;
+         create.symbol = "GENUSD";
+         create.precision = 4;
+         create.common_options.core_exchange_rate = price( asset( 1, asset_id_type(1) ), asset( 1 ) );
+         ops.push_back( create );
+         push( ops );
+         generate();
+         _uia = _db.get_index_type<asset_index>().indices().get<by_symbol>().find( "GENUSD" )->id;
+
+         uint32_t txs = 0;
+         for( uint32_t i = 0; i < _num_accounts; i += 100 )
+         {
+            for( uint32_t j = i; j < std::min( i + 100, _num_accounts ); ++j )
+            {
+               transfer_operation fund;
+               fund.from = _nathan;
+               fund.to = _accounts[j];
+               fund.amount = asset( 1000000000 );
+               ops.push_back( fund );
+               asset_issue_operation issue;
+               issue.issuer = _nathan;
+               issue.asset_to_issue = asset( 100000000, _uia );
+               issue.issue_to_account = _accounts[j];
+               ops.push_back( issue );
+            }
+            push( ops );
+            if( ++txs % 20 == 0 )
+               generate();
+         }
+         generate();
+      }
+
+      /// Pushes the random operations of the next block, the count varies around ops-per-block
+      void fill_block()
+      {
+         if( _accounts.empty() || _ops_per_block == 0 )
+            return;
+         const uint32_t count = std::uniform_int_distribution<uint32_t>( 0, 2 * _ops_per_block )( _rng );
+         for( uint32_t i = 0; i < count; ++i )
+         {
+            vector<operation> ops;
+            ops.push_back( make_op() );
+            push( ops );
+         }
+      }
+
+      uint64_t failed()const { return _failed; }
+
+   private:
+      account_id_type random_account()
+      {
+         return _accounts[ std::uniform_int_distribution<size_t>( 0, _accounts.size() - 1 )( _rng ) ];
+      }
+
+      operation make_op()
+      {
+         const uint64_t n = ++_counter;
+         switch( _pick_kind( _rng ) )
+         {
+            case transfer:
+            {
+               transfer_operation op;
+               op.from = random_account();
+               op.to = random_account();
+               if( op.to == op.from )
+                  op.to = op.from == _accounts.front() ? _accounts.back() : _accounts.front();
+               op.amount = asset( 1 + n % 1000 );
+               return op;
+            }
+            case content:
+            {
+               content_card_v2_create_operation op;
+               op.subject_account = random_account();
+               op.hash = fc::sha256::hash( fc::to_string(n) ).str();
+               op.url = "http://some.image.url/img" + fc::to_string(n) + ".jpg";
+               op.type = "image/png";
+               op.description = "Generated content";
+               op.content_key = _key.get_public_key().to_base58();
+               op.storage_data = "[\"GD\",\"1.0\",\"file_id_in_google_disk\"]";
+               return op;
+            }
+            case vote:
+            {
+               content_vote_create_operation op;
+               op.subject_account = random_account();
+               op.content_id = "1.0." + fc::to_string(n);
+               op.master_account = random_account();
+               op.master_content_id = "1.0.0";
+               return op;
+            }
+            default:
+            {
+               limit_order_create_operation op;
+               op.seller = random_account();
+               op.expiration = _db.head_block_time() + fc::hours(1);
+               if( n % 2 == 0 )
+               {
+                  op.amount_to_sell = asset( 10, _uia );
+                  op.min_to_receive = asset( 9 + n % 3 );
+               }
+               else
+               {
+                  op.amount_to_sell = asset( 9 + n % 3 );
+                  op.min_to_receive = asset( 10, _uia );
+               }
+               return op;
+            }
+         }
+      }
+
+      /// Signs and pushes one transaction, operations which fail (e.g. duplicates) are counted and dropped
+      void push( vector<operation>& ops )
+      {
+         signed_transaction tx;
+         tx.operations = std::move( ops );
+         ops.clear();
+         for( auto& op : tx.operations )
+            _db.current_fee_schedule().set_fee( op );
+         tx.set_reference_block( _db.head_block_id() );
+         tx.set_expiration( _db.head_block_time() + fc::minutes(1) );
+         tx.sign( _key, _db.get_chain_id() );
+         try {
+            _db.push_transaction( precomputable_transaction( tx ) );
+         } catch( const fc::exception& e ) {
+            if( ++_failed <= 10 )
+               wlog( "Dropping a generated transaction: ${e}", ("e", e.to_string()) );
+         }
+      }
+
+      database&                             _db;
+      const fc::ecc::private_key            _key;
+      const uint32_t                        _num_accounts;
+      const uint32_t                        _ops_per_block;
+      std::discrete_distribution<uint32_t>  _pick_kind;
+      std::mt19937                          _rng;
+      account_id_type                       _nathan;
+      asset_id_type                         _uia;
+      vector<account_id_type>               _accounts;
+      uint64_t                              _counter = 0;
+      uint64_t                              _failed = 0;
+};
+
 int main( int argc, char** argv )
 {
    try
@@ -65,6 +256,18 @@ int main( int argc, char** argv )
             ("genesis-time,t", bpo::value<uint32_t>()->default_value(0), "Timestamp for genesis state (0=use value from file/example)")
             ("num-blocks,n", bpo::value<uint32_t>()->default_value(1000000), "Number of blocks to generate")
             ("miss-rate,r", bpo::value<uint32_t>()->default_value(3), "Percentage of blocks to miss")
+            ("num-accounts", bpo::value<uint32_t>()->default_value(0),
+             "Number of accounts to create in genesis and fund, 0 generates empty blocks only. "
+             "Generating a workload zeroes all fees")
+            ("ops-per-block", bpo::value<uint32_t>()->default_value(100),
+             "Average number of operations per block, the count in each block is random between 0 and twice that")
+            ("op-mix", bpo::value<string>()->default_value("40,30,20,10"),
+             "Relative weights of transfers, content cards, content votes and limit orders")
+            ("seed", bpo::value<uint32_t>()->default_value(0), "Seed of the random workload")
+            ("genesis-out", bpo::value<boost::filesystem::path>(),
+             "File to write the used genesis state to, default genesis.json in data-dir. "
+             "The chain can be replayed with --genesis-json set to it and this data-dir/db moved to "
+             "<node data-dir>/blockchain")
             ("verbose,v", "Enter verbose mode")
             ;
 
@@ -116,9 +319,37 @@ int main( int argc, char** argv )
 
       uint32_t num_blocks = options["num-blocks"].as<uint32_t>();
       uint32_t miss_rate = options["miss-rate"].as<uint32_t>();
+      uint32_t num_accounts = options["num-accounts"].as<uint32_t>();
+
+      vector<uint32_t> weights;
+      {
+         std::stringstream mix( options["op-mix"].as<string>() );
+         string weight;
+         while( std::getline( mix, weight, ',' ) )
+            weights.push_back( std::stoul( weight ) );
+         FC_ASSERT( weights.size() == workload::num_kinds, "op-mix needs ${n} weights", ("n", uint32_t(workload::num_kinds)) );
+      }
 
       fc::ecc::private_key nathan_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("nathan")));
 
+      if( num_accounts > 0 )
+      {
+         workload::add_accounts( genesis, nathan_priv_key, num_accounts );
+         genesis.initial_parameters.get_mutable_fees().zero_all_fees();
+      }
+      // Like a node loading it with --genesis-json, the chain ID is the hash of the genesis file
+      {
+         const string genesis_json = fc::json::to_pretty_string( genesis );
+         genesis.initial_chain_id = fc::sha256::hash( genesis_json );
+         fc::path genesis_out = options.count("genesis-out") ? fc::path( options["genesis-out"].as<boost::filesystem::path>() )
+                                                             : data_dir / "genesis.json";
+         fc::create_directories( genesis_out.parent_path() );
+         std::ofstream out( genesis_out.generic_string(), std::ios::trunc );
+         out << genesis_json;
+         std::cerr << "empty_blocks:  Wrote genesis to " << genesis_out.preferred_string()
+                   << ", chain ID " << genesis.initial_chain_id.str() << "\n";
+      }
+
       database db;
       fc::path db_path = data_dir / "db";
       db.open(db_path, [&]() { return genesis; }, "TEST" );
@@ -126,8 +357,17 @@ int main( int argc, char** argv )
       uint32_t slot = 1;
       uint32_t missed = 0;
 
-      for( uint32_t i = 1; i < num_blocks; ++i )
+      workload load( db, nathan_priv_key, num_accounts, options["ops-per-block"].as<uint32_t>(), weights,
+                     options["seed"].as<uint32_t>() );
+      if( num_accounts > 0 )
+         load.setup( [&db,&nathan_priv_key]() {
+            db.generate_block( db.get_slot_time(1), db.get_scheduled_witness(1), nathan_priv_key,
+                               database::skip_nothing );
+         });
+
+      for( uint32_t i = db.head_block_num() + 1; i < num_blocks; ++i )
       {
+         load.fill_block();
          signed_block b = db.generate_block(db.get_slot_time(slot), db.get_scheduled_witness(slot), nathan_priv_key, database::skip_nothing);
          FC_ASSERT( db.head_block_id() == b.id() );
          fc::sha256 h = b.digest();
@@ -161,6 +401,8 @@ int main( int argc, char** argv )
          }
       }
       std::cerr << "\n";
+      if( load.failed() > 0 )
+         std::cerr << "empty_blocks:  " << load.failed() << " generated transactions were dropped\n";
       db.close();
    }
    catch ( const fc::exception& e )
@@ -208,4 +208,215 @@ BOOST_AUTO_TEST_CASE( one_hundred_k_benchmark )
    db._undo_db.enable();
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( content_operations_benchmark )
+{ try {
+   ACTORS( (alice)(bob) );
+   db._undo_db.disable();
+
+   const uint32_t cycles = 20000;
+   const std::string storage_data = "[\"GD\",\"1.0\",\"file_id_in_google_disk\"]";
+   const auto& fees = db.current_fee_schedule();
+
+   std::vector<signed_transaction> transactions;
+   transactions.reserve( cycles );
+   share_type total_fees = 0;
+   auto build = [&]( const operation& op ) {
+      signed_transaction tx;
+      test::set_expiration( db, tx );
+      tx.operations.push_back( op );
+      transactions.push_back( tx );
+   };
+   auto run = [&]( const char* what, uint32_t count ) {
+      auto start = fc::time_point::now();
+      for( const auto& tx : transactions )
+         db.apply_transaction( tx, ~0 );
+      auto elapsed = fc::time_point::now() - start;
+      wlog( "${ops} ${what}/s over ${total}ms",
+            ("ops",(uint64_t(count)*1000000)/std::max<int64_t>(elapsed.count(),1))("what",what)
+            ("total",elapsed.count()/1000) );
+      transactions.clear();
+   };
+
+   content_card_v2_create_operation cco;
+   cco.subject_account = alice_id;
+   cco.url = "http://some.image.url/img.jpg";
+   cco.type = "image/png";
+   cco.description = "Some image";
+   cco.content_key = fc::ecc::private_key::generate().get_public_key().to_base58();
+   cco.storage_data = storage_data;
+   for( uint32_t i = 0; i < cycles; ++i )
+   {
+      cco.hash = fc::sha256::hash( fc::to_string(i) ).str();
+      cco.fee = fees.calculate_fee( cco );
+      total_fees += cco.fee.amount * 2; // again for the update below
+      build( cco );
+   }
+
+   personal_data_v2_create_operation pdo;
+   pdo.subject_account = alice_id;
+   pdo.url = "http://some.storage.url/pd";
+   pdo.storage_data = storage_data;
+   pdo.hash = fc::sha256::hash( std::string("personal data") ).str();
+   pdo.fee = fees.calculate_fee( pdo );
+   content_vote_create_operation cvo;
+   cvo.subject_account = alice_id;
+   cvo.master_account = bob_id;
+   cvo.master_content_id = "1.0.0";
+   cvo.fee = fees.calculate_fee( cvo );
+   total_fees += ( pdo.fee.amount + cvo.fee.amount ) * cycles;
+
+   fund( alice, asset( total_fees ) );
+
+   run( "content card creations", cycles );
+
+   content_card_v2_update_operation cuo;
+   cuo.subject_account = alice_id;
+   cuo.url = "http://some.image.url/img2.jpg";
+   cuo.type = "image/jpeg";
+   cuo.description = "Some other image";
+   cuo.content_key = cco.content_key;
+   cuo.storage_data = storage_data;
+   for( uint32_t i = 0; i < cycles; ++i )
+   {
+      cuo.hash = fc::sha256::hash( fc::to_string(i) ).str();
+      cuo.fee = fees.calculate_fee( cuo );
+      build( cuo );
+   }
+   run( "content card updates", cycles );
+
+   // personal data is unique per subject and operator, so each one goes to a different operator
+   std::vector<account_id_type> operators;
+   operators.reserve( cycles );
+   for( uint32_t i = 0; i < cycles; ++i )
+      operators.push_back( create_account( "operator" + fc::to_string(i) ).id );
+   for( uint32_t i = 0; i < cycles; ++i )
+   {
+      pdo.operator_account = operators[i];
+      build( pdo );
+   }
+   run( "personal data creations", cycles );
+
+   for( uint32_t i = 0; i < cycles; ++i )
+   {
+      cvo.content_id = "1.0." + fc::to_string(i);
+      build( cvo );
+   }
+   run( "content votes", cycles );
+
+   db._undo_db.enable();
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( market_benchmark )
+{ try {
+   ACTORS( (feeder)(maker)(taker) );
+   const asset_object& mpa = asset_id_type(1)(db);
+   const asset_id_type mpa_id = mpa.id;
+   const asset_object& core = asset_id_type()(db);
+
+   update_feed_producers( mpa, { feeder_id } );
+   price_feed feed;
+   feed.settlement_price = mpa.amount(1) / core.amount(5);
+   publish_feed( mpa, feeder, feed );
+
+   const uint32_t num_calls = 2000;
+   const uint32_t cycles = 2000;
+
+   auto push = [&]( const operation& op ) {
+      trx.operations = { op };
+      for( auto& o : trx.operations ) db.current_fee_schedule().set_fee( o );
+      test::set_expiration( db, trx );
+      PUSH_TX( db, trx, ~0 );
+      trx.clear();
+   };
+
+   // call orders with collateral ratios between 2 and 4, none of them can be margin called
+   for( uint32_t i = 0; i < num_calls; ++i )
+   {
+      const account_object& borrower = create_account( "borrower" + fc::to_string(i) );
+      fund( borrower, asset( 300000 ) );
+      call_order_update_operation cop;
+      cop.funding_account = borrower.id;
+      cop.delta_debt = asset( 10000, mpa_id );
+      cop.delta_collateral = asset( 100000 + 50 * i );
+      push( cop );
+   }
+   fund( maker, asset( 1000000 ) );
+   call_order_update_operation cop;
+   cop.funding_account = maker_id;
+   cop.delta_debt = asset( 10 * cycles, mpa_id );
+   cop.delta_collateral = asset( 150 * cycles );
+   push( cop );
+   fund( taker, asset( 1000000 ) );
+
+   db._undo_db.disable();
+
+   std::vector<signed_transaction> transactions;
+   transactions.reserve( cycles );
+   auto build = [&]( const operation& op ) {
+      signed_transaction tx;
+      test::set_expiration( db, tx );
+      tx.operations.push_back( op );
+      for( auto& o : tx.operations ) db.current_fee_schedule().set_fee( o );
+      transactions.push_back( tx );
+   };
+   auto run = [&]( const char* what, uint32_t count ) {
+      auto start = fc::time_point::now();
+      for( const auto& tx : transactions )
+         db.apply_transaction( tx, ~0 );
+      auto elapsed = fc::time_point::now() - start;
+      wlog( "${ops} ${what}/s over ${total}ms",
+            ("ops",(uint64_t(count)*1000000)/std::max<int64_t>(elapsed.count(),1))("what",what)
+            ("total",elapsed.count()/1000) );
+      transactions.clear();
+   };
+
+   // a deep book of asks below the maximum short squeeze price, which are good enough to match margin calls
+   limit_order_create_operation ask;
+   ask.seller = maker_id;
+   ask.expiration = time_point_sec::maximum();
+   for( uint32_t i = 0; i < cycles; ++i )
+   {
+      ask.amount_to_sell = asset( 10, mpa_id );
+      ask.min_to_receive = asset( 52 + i % 3 );
+      build( ask );
+   }
+   run( "asks into a deep book", cycles );
+
+   // each price feed checks the call orders
+   asset_publish_feed_operation pfo;
+   pfo.publisher = feeder_id;
+   pfo.asset_id = mpa_id;
+   for( uint32_t i = 0; i < cycles; ++i )
+   {
+      pfo.feed.settlement_price = mpa.amount(1000) / core.amount(5000 + i % 10);
+      pfo.feed.core_exchange_rate = pfo.feed.settlement_price;
+      pfo.feed.core_exchange_rate.quote.asset_id = asset_id_type();
+      build( pfo );
+   }
+   run( "price feeds without margin calls", cycles );
+
+   // bids which are not matched, and asks which are too expensive to match any bid or margin call
+   limit_order_create_operation bid;
+   bid.seller = taker_id;
+   bid.expiration = time_point_sec::maximum();
+   for( uint32_t i = 0; i < cycles; ++i )
+   {
+      bid.amount_to_sell = asset( 40 + i % 3 );
+      bid.min_to_receive = asset( 10, mpa_id );
+      build( bid );
+   }
+   run( "bids not crossing the book", cycles );
+
+   // bids which fill one ask each
+   for( uint32_t i = 0; i < cycles; ++i )
+   {
+      bid.amount_to_sell = asset( 60 );
+      bid.min_to_receive = asset( 10, mpa_id );
+      build( bid );
+   }
+   run( "bids filling an ask", cycles );
+
+   db._undo_db.enable();
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -26,6 +26,7 @@
 
 #include "../common/database_fixture.hpp"
 
+#include <graphene/app/api.hpp>
 #include <graphene/app/util.hpp>
 
 using namespace graphene::chain;
@@ -278,4 +279,60 @@ BOOST_AUTO_TEST_CASE(price_to_string_verify)
    }
 }
 
+BOOST_FIXTURE_TEST_CASE( api_metrics_test, database_fixture )
+{ try {
+   generate_block();
+
+   auto metrics = std::make_shared<api_metrics>();
+   fc::api<block_api> api( std::make_shared<block_api>( std::ref( db ) ) );
+   api->visit( api_call_instrumenter( metrics, nullptr, "block_api", "alice" ) );
+
+   BOOST_CHECK_EQUAL( api->get_blocks( 1, 1 ).size(), 1u );
+   BOOST_CHECK_EQUAL( api->get_blocks( 1, 1 ).size(), 1u );
+   GRAPHENE_CHECK_THROW( api->get_blocks( 2, 1 ), fc::exception );
+   api->get_block_cache_stats();
+
+   auto result = metrics->get_metrics();
+   BOOST_REQUIRE_EQUAL( result.size(), 2u );
+   BOOST_CHECK_EQUAL( result[0].api, "block_api" );
+   BOOST_CHECK_EQUAL( result[0].method, "get_block_cache_stats" );
+   BOOST_CHECK_EQUAL( result[0].user, "alice" );
+   BOOST_CHECK_EQUAL( result[0].calls, 1u );
+   BOOST_CHECK_EQUAL( result[0].errors, 0u );
+   BOOST_CHECK_EQUAL( result[1].method, "get_blocks" );
+   BOOST_CHECK_EQUAL( result[1].calls, 3u );
+   BOOST_CHECK_EQUAL( result[1].errors, 1u );
+   BOOST_REQUIRE_EQUAL( result[1].latency_histogram.size(), api_metrics::latency_bucket_bounds_us().size() + 1 );
+   uint64_t histogram_calls = 0;
+   for( uint64_t count : result[1].latency_histogram )
+      histogram_calls += count;
+   BOOST_CHECK_EQUAL( histogram_calls, 3u );
+   BOOST_CHECK_LE( result[1].max_time_us, result[1].total_time_us );
+
+   metrics->reset();
+   BOOST_CHECK( metrics->get_metrics().empty() );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( api_call_budget_test )
+{ try {
+   // 1 ms per second, up to 2 ms
+   api_call_budget budget( 1000, 2000 );
+   BOOST_CHECK_LE( budget.remaining_us(), 2000 );
+
+   budget.admit();
+   budget.charge( 1500 );
+   budget.admit();
+   budget.charge( 1500 );
+   // overdrawn by an expensive call
+   BOOST_CHECK_LT( budget.remaining_us(), 0 );
+   GRAPHENE_CHECK_THROW( budget.admit(), fc::exception );
+
+   fc::usleep( fc::milliseconds( 1200 ) );
+   BOOST_CHECK_GT( budget.remaining_us(), 0 );
+   budget.admit();
+
+   fc::usleep( fc::milliseconds( 3000 ) );
+   BOOST_CHECK_LE( budget.remaining_us(), 2000 );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
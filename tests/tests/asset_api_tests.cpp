@@ -61,6 +61,40 @@ BOOST_AUTO_TEST_CASE( asset_holders )
    BOOST_CHECK(holders[2].name == "alice");
    BOOST_CHECK(holders[3].name == "dan");
 }
+BOOST_AUTO_TEST_CASE( asset_holders_count_and_paging )
+{
+   graphene::app::asset_api asset_api(app);
+   const std::string core = std::string( static_cast<object_id_type>(asset_id_type()) );
+
+   auto dan = create_account("dan");
+   auto bob = create_account("bob");
+   auto alice = create_account("alice");
+
+   transfer(account_id_type()(db), dan, asset(100));
+   transfer(account_id_type()(db), alice, asset(200));
+   transfer(account_id_type()(db), bob, asset(300));
+
+   BOOST_CHECK_EQUAL( asset_api.get_asset_holders_count( core ), 4 );
+
+   vector<account_asset_balance> first = asset_api.get_asset_holders( core, 0, 2 );
+   BOOST_REQUIRE_EQUAL( first.size(), 2u );
+   BOOST_CHECK( first[1].name == "bob" );
+   vector<account_asset_balance> next = asset_api.get_asset_holders_after( core, first[1].amount,
+                                                                           first[1].account_id, 2 );
+   BOOST_REQUIRE_EQUAL( next.size(), 2u );
+   BOOST_CHECK( next[0].name == "alice" );
+   BOOST_CHECK( next[1].name == "dan" );
+   BOOST_CHECK( asset_api.get_asset_holders_after( core, next[1].amount, next[1].account_id, 2 ).empty() );
+
+   // a holder which gives away all of its balance is no longer counted
+   transfer(dan, bob, asset(100));
+   BOOST_CHECK_EQUAL( asset_api.get_asset_holders_count( core ), 3 );
+   auto all = asset_api.get_all_asset_holders();
+   auto itr = std::find_if( all.begin(), all.end(), []( const asset_holders& h ) { return h.asset_id == asset_id_type(); } );
+   BOOST_REQUIRE( itr != all.end() );
+   BOOST_CHECK_EQUAL( itr->count, 3 );
+}
+
 BOOST_AUTO_TEST_CASE( api_limit_get_asset_holders )
 {
    graphene::app::asset_api asset_api(app);
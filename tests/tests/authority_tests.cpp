@@ -1373,6 +1373,17 @@ BOOST_FIXTURE_TEST_CASE( nonminimal_sig_test, database_fixture )
       sign( tx, alice_private_key );
       tx.verify_authority( db.get_chain_id(), get_active, get_owner, make_get_custom(db), false, false );
       tx.verify_authority( db.get_chain_id(), get_active, get_owner, make_get_custom(db), true, false );
+
+      // the same results without an exception
+      BOOST_CHECK( !is_authorized( tx.operations, flat_set<public_key_type>(), get_active, get_owner,
+                                   make_get_custom(db), false, false ) );
+      BOOST_CHECK( !is_authorized( tx.operations, flat_set<public_key_type>{ bob_public_key }, get_active, get_owner,
+                                   make_get_custom(db), false, false ) );
+      BOOST_CHECK( is_authorized( tx.operations, flat_set<public_key_type>{ alice_public_key }, get_active, get_owner,
+                                  make_get_custom(db), false, false ) );
+      BOOST_CHECK( is_authorized( tx.operations, flat_set<public_key_type>(), get_active, get_owner,
+                                  make_get_custom(db), false, false, GRAPHENE_MAX_SIG_CHECK_DEPTH, false,
+                                  flat_set<account_id_type>{ thud_id } ) );
    }
    catch(fc::exception& e)
    {
@@ -28,10 +28,17 @@
 
 #include <graphene/chain/account_object.hpp>
 #include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/block_summary_object.hpp>
 #include <graphene/chain/exceptions.hpp>
 
 #include <graphene/db/simple_index.hpp>
 
+#include <graphene/protocol/base58.hpp>
+
+#include <graphene/witness/production_profile.hpp>
+#include <graphene/witness/commit_reveal_schedule.hpp>
+
+#include <fc/crypto/base58.hpp>
 #include <fc/crypto/digest.hpp>
 #include <fc/crypto/hex.hpp>
 #include "../common/database_fixture.hpp"
@@ -135,6 +142,36 @@ BOOST_AUTO_TEST_CASE( valid_symbol_test )
    BOOST_CHECK( is_valid_symbol( "AAA000AAA" ) );
 }
 
+BOOST_AUTO_TEST_CASE( base58_encoding_test )
+{
+   // same results as fc for leading zeroes, short and key sized data
+   std::vector<std::vector<char>> samples = { {}, { 0 }, { 0, 0, 1 }, { 57 }, { 58 }, { char(255), char(255) } };
+   std::mt19937 gen( 42 );
+   for( uint32_t size : { 1, 4, 24, 37, 64 } )
+      for( uint32_t round = 0; round < 20; ++round )
+      {
+         std::vector<char> data( size );
+         for( char& c : data )
+            c = char( gen() );
+         if( round % 4 == 0 )
+            data[0] = 0;
+         samples.push_back( data );
+      }
+   for( const auto& data : samples )
+      BOOST_CHECK_EQUAL( graphene::protocol::encode_base58( data.data(), data.size() ),
+                         fc::to_base58( data.data(), data.size() ) );
+
+   // cached strings of public keys are the same as computed ones
+   for( uint32_t i = 0; i < 10; ++i )
+   {
+      const public_key_type key = fc::ecc::private_key::regenerate( fc::sha256::hash( std::to_string(i) ) )
+                                    .get_public_key();
+      const std::string str = key;
+      BOOST_CHECK( public_key_type( str ) == key );
+      BOOST_CHECK_EQUAL( std::string( key ), str );
+   }
+}
+
 BOOST_AUTO_TEST_CASE( price_test )
 {
     auto price_max = []( uint32_t a, uint32_t b )
@@ -428,6 +465,65 @@ BOOST_AUTO_TEST_CASE( scaled_precision )
    GRAPHENE_CHECK_THROW( asset::scaled_precision(19), fc::exception );
 }
 
+BOOST_AUTO_TEST_CASE( simple_index_test )
+{
+   graphene::db::object_database odb;
+   primary_index< simple_index< block_summary_object > > idx( odb );
+   const uint32_t count = simple_index< block_summary_object >::page_size * 2 + 3;
+
+   vector<const block_summary_object*> created;
+   for( uint32_t i = 0; i < count; ++i )
+      created.push_back( static_cast<const block_summary_object*>( &idx.create( [i]( object& o ) {
+         static_cast<block_summary_object&>( o ).block_id._hash[0] = i;
+      }) ) );
+   BOOST_CHECK_EQUAL( idx.size(), count );
+
+   // objects never move and can be found by ID
+   for( uint32_t i = 0; i < count; ++i )
+   {
+      BOOST_CHECK( idx.find( block_summary_id_type( i ) ) == created[i] );
+      BOOST_CHECK_EQUAL( created[i]->block_id._hash[0].value(), i );
+   }
+
+   // removing leaves holes, which iteration skips
+   idx.remove( *created[0] );
+   idx.remove( *created[5] );
+   BOOST_CHECK( idx.find( block_summary_id_type( 5 ) ) == nullptr );
+   uint32_t seen = 0;
+   for( const block_summary_object& o : idx )
+   {
+      BOOST_CHECK( o.id != block_summary_id_type( 0 ) && o.id != block_summary_id_type( 5 ) );
+      ++seen;
+   }
+   BOOST_CHECK_EQUAL( seen, count - 2 );
+   seen = 0;
+   idx.inspect_all_objects( [&seen]( const object& ) { ++seen; } );
+   BOOST_CHECK_EQUAL( seen, count - 2 );
+   seen = 0;
+   idx.for_each_object( [&seen]( const block_summary_object& ) { ++seen; } );
+   BOOST_CHECK_EQUAL( seen, count - 2 );
+   seen = 0;
+   idx.for_each_object( 1, 6, [&seen]( const block_summary_object& o ) {
+      BOOST_CHECK_EQUAL( o.block_id._hash[0].value(), o.id.instance() );
+      ++seen;
+   });
+   BOOST_CHECK_EQUAL( seen, 4u );
+
+   // an object can be put back into its slot
+   block_summary_object restored;
+   restored.id = block_summary_id_type( 5 );
+   restored.block_id._hash[0] = 5;
+   idx.insert( std::move( restored ) );
+   BOOST_CHECK_EQUAL( static_cast<const block_summary_object*>( idx.find( block_summary_id_type( 5 ) ) )
+                         ->block_id._hash[0].value(), 5u );
+
+   // removing the last objects shrinks the index
+   idx.remove( *created[count - 1] );
+   idx.remove( *created[count - 2] );
+   BOOST_CHECK_EQUAL( idx.size(), count - 2 );
+   BOOST_CHECK( idx.find( block_summary_id_type( count - 1 ) ) == nullptr );
+}
+
 BOOST_AUTO_TEST_CASE( merkle_root )
 {
    clearable_block block;
@@ -629,4 +725,71 @@ BOOST_AUTO_TEST_CASE( bitasset_feed_expiration_test )
    BOOST_CHECK( !o.feed_is_expired( now ) );
 }
 
+BOOST_AUTO_TEST_CASE( latency_histogram_test )
+{
+   graphene::witness_plugin::latency_histogram h;
+   BOOST_CHECK_EQUAL( h.percentile_ms( 50 ), 0u );
+
+   for( int i = 0; i < 9; ++i )
+      h.add( fc::microseconds( 800 ) );
+   h.add( fc::milliseconds( 30 ) );
+
+   BOOST_CHECK_EQUAL( h.samples, 10u );
+   BOOST_CHECK_EQUAL( h.counts[0], 9u );
+   BOOST_CHECK_EQUAL( h.max_us, 30000u );
+   BOOST_CHECK_EQUAL( h.mean_us(), ( 9 * 800 + 30000 ) / 10u );
+   BOOST_CHECK_EQUAL( h.percentile_ms( 50 ), 1u );
+   BOOST_CHECK_EQUAL( h.percentile_ms( 90 ), 1u );
+   BOOST_CHECK_EQUAL( h.percentile_ms( 100 ), 50u );
+
+   // negative durations are counted as zero, durations beyond the last bound report the maximum
+   h.add( fc::microseconds( -5 ) );
+   h.add( fc::seconds( 3 ) );
+   BOOST_CHECK_EQUAL( h.counts[0], 10u );
+   BOOST_CHECK_EQUAL( h.percentile_ms( 100 ), 3000u );
+}
+
+BOOST_AUTO_TEST_CASE( commit_reveal_schedule_test )
+{
+   vector<account_id_type> participants;
+   for( uint64_t i = 10; i < 31; ++i )
+      participants.push_back( account_id_type(i) );
+   const fc::sha256 seed = fc::sha256::hash( std::string( "commit" ) );
+
+   // all participants are spread over the slots, with at most one per slot
+   graphene::witness_plugin::commit_reveal_schedule all;
+   all.reset( participants, participants, 3, 27, seed );
+   BOOST_REQUIRE_EQUAL( all.entries().size(), participants.size() );
+   for( size_t i = 0; i < all.entries().size(); ++i )
+   {
+      BOOST_CHECK_GE( all.entries()[i].first, 3u );
+      BOOST_CHECK_LT( all.entries()[i].first, 30u );
+      if( i > 0 )
+         BOOST_CHECK_LT( all.entries()[i-1].first, all.entries()[i].first );
+   }
+
+   // a node with some of the witnesses gets the same slots for them
+   graphene::witness_plugin::commit_reveal_schedule some;
+   some.reset( participants, { participants[4], participants[17], account_id_type(99) }, 3, 27, seed );
+   BOOST_REQUIRE_EQUAL( some.entries().size(), 3u );
+   for( const auto& e : some.entries() )
+   {
+      if( e.second == account_id_type(99) )
+         continue;
+      BOOST_CHECK( std::find( all.entries().begin(), all.entries().end(), e ) != all.entries().end() );
+   }
+
+   BOOST_CHECK( !some.next_due( 2 ).valid() );
+   size_t done = 0;
+   for( uint32_t slot = 0; slot < 40; slot += 5 )
+      for( auto acc = some.next_due( slot ); acc.valid(); acc = some.next_due( slot ) )
+      {
+         BOOST_CHECK( *acc == some.entries()[done].second );
+         some.pop();
+         ++done;
+      }
+   BOOST_CHECK_EQUAL( done, 3u );
+   BOOST_CHECK( !some.next_due( 100 ).valid() );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
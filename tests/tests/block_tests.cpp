@@ -24,6 +24,7 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <graphene/app/api.hpp>
 #include <graphene/chain/database.hpp>
 #include <graphene/chain/exceptions.hpp>
 
@@ -40,6 +41,11 @@
 
 #include <fc/crypto/digest.hpp>
 #include <fc/io/fstream.hpp>
+#include <fc/io/json.hpp>
+#include <fc/thread/parallel.hpp>
+
+#include <atomic>
+#include <thread>
 
 #include "../common/database_fixture.hpp"
 
@@ -133,6 +139,503 @@ BOOST_AUTO_TEST_CASE( block_database_test )
    }
 }
 
+BOOST_AUTO_TEST_CASE( block_database_batched_writes )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      block_database bdb;
+      bdb.open( data_dir.path() );
+      bdb.set_write_batch_size( 4 );
+
+      std::vector<block_id_type> ids;
+      clearable_block b;
+      for( uint32_t i = 0; i < 10; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         b.clear();
+         bdb.store( b.id(), b );
+         ids.push_back( b.id() );
+
+         // buffered and written blocks are both visible
+         for( uint32_t j = 0; j <= i; ++j )
+         {
+            BOOST_CHECK( bdb.contains( ids[j] ) );
+            BOOST_CHECK( bdb.fetch_block_id( j+1 ) == ids[j] );
+         }
+         BOOST_REQUIRE( bdb.last_id().valid() );
+         BOOST_CHECK( *bdb.last_id() == b.id() );
+
+         // ids are looked up together from both
+         std::vector<uint32_t> nums;
+         for( uint32_t j = i + 1; j > 0; j -= std::min<uint32_t>( j, 3 ) )
+            nums.push_back( j );
+         auto found = bdb.fetch_block_ids( nums );
+         BOOST_REQUIRE_EQUAL( found.size(), nums.size() );
+         for( size_t k = 0; k < nums.size(); ++k )
+            BOOST_CHECK( found[k] == ids[nums[k]-1] );
+         nums.push_back( i + 2 );
+         GRAPHENE_REQUIRE_THROW( bdb.fetch_block_ids( nums ), fc::key_not_found_exception );
+      }
+
+      // irreversible blocks are written without waiting for the batch to fill
+      bdb.flush_through( 9 );
+      {
+         block_database on_disk;
+         on_disk.open( data_dir.path() );
+         BOOST_CHECK( on_disk.contains( ids[8] ) );
+         BOOST_CHECK( !on_disk.contains( ids[9] ) );
+      }
+      BOOST_CHECK( bdb.contains( ids[9] ) );
+
+      // readers on other threads do not interfere with the writer
+      std::vector<fc::future<void>> readers;
+      for( uint32_t t = 0; t < 4; ++t )
+         readers.push_back( fc::do_parallel( [&bdb,&ids] () {
+            for( uint32_t round = 0; round < 100; ++round )
+               for( uint32_t j = 0; j < ids.size(); ++j )
+               {
+                  auto blk = bdb.fetch_by_number( j+1 );
+                  FC_ASSERT( blk.valid() && blk->id() == ids[j] );
+               }
+         }) );
+      for( uint32_t i = 10; i < 30; ++i )
+      {
+         b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         b.clear();
+         bdb.store( b.id(), b );
+         ids.push_back( b.id() );
+      }
+      for( auto& reader : readers )
+         reader.wait();
+
+      bdb.remove( ids.back() );
+      BOOST_CHECK( !bdb.contains( ids.back() ) );
+      BOOST_REQUIRE( bdb.last_id().valid() );
+      BOOST_CHECK( *bdb.last_id() == ids[ids.size() - 2] );
+      bdb.close();
+
+      bdb.open( data_dir.path() );
+      BOOST_REQUIRE( bdb.last_id().valid() );
+      BOOST_CHECK( *bdb.last_id() == ids[ids.size() - 2] );
+      for( uint32_t j = 0; j + 1 < ids.size(); ++j )
+      {
+         auto blk = bdb.fetch_by_number( j+1 );
+         BOOST_REQUIRE( blk.valid() );
+         BOOST_CHECK( blk->id() == ids[j] );
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_database_pruning )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      block_database bdb;
+      bdb.open( data_dir.path() );
+      bdb.set_write_batch_size( 4 );
+      BOOST_CHECK_EQUAL( bdb.first_block_num(), 1u );
+
+      std::vector<block_id_type> ids;
+      clearable_block b;
+      for( uint32_t i = 0; i < 40; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         b.clear();
+         bdb.store( b.id(), b );
+         ids.push_back( b.id() );
+         if( i == 20 )
+            bdb.prune( 11 );
+      }
+      bdb.flush();
+      BOOST_CHECK_EQUAL( bdb.first_block_num(), 11u );
+      for( uint32_t j = 0; j < ids.size(); ++j )
+      {
+         BOOST_CHECK_EQUAL( bdb.contains( ids[j] ), j >= 10 );
+         BOOST_CHECK_EQUAL( bdb.fetch_by_number( j+1 ).valid(), j >= 10 );
+      }
+
+      // pruning only moves forward
+      bdb.prune( 5 );
+      bdb.close();
+
+      bdb.open( data_dir.path() );
+      BOOST_CHECK_EQUAL( bdb.first_block_num(), 11u );
+      BOOST_REQUIRE( bdb.last_id().valid() );
+      BOOST_CHECK( *bdb.last_id() == ids.back() );
+      for( uint32_t j = 10; j < ids.size(); ++j )
+      {
+         auto blk = bdb.fetch_optional( ids[j] );
+         BOOST_REQUIRE( blk.valid() );
+         BOOST_CHECK( blk->id() == ids[j] );
+      }
+      bdb.close();
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( applied_ops_log_test )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      const fc::path file = data_dir.path() / "applied_ops";
+
+      auto ops_of = []( int64_t amount ) {
+         vector<optional<operation_history_object>> ops( 2 );
+         transfer_operation t;
+         t.amount = asset( amount );
+         ops[0] = operation_history_object();
+         ops[0]->op = t;
+         return std::make_shared< const vector<optional<operation_history_object>> >( std::move( ops ) );
+      };
+      auto read_all = []( const applied_ops_log& log ) {
+         vector<applied_ops_log_entry> entries;
+         log.for_each( [&entries]( const applied_ops_log_entry& e ) { entries.push_back( e ); } );
+         return entries;
+      };
+
+      applied_ops_log log;
+      log.open( file );
+      BOOST_CHECK_EQUAL( log.last_block_num(), 0u );
+      for( uint32_t i = 1; i <= 5; ++i )
+         log.add_block( i, fc::time_point_sec( 100 * i ), ops_of( i ) );
+      // block 4 is replaced in a chain reorganization, the old block 5 is dropped with it
+      log.add_block( 4, fc::time_point_sec( 401 ), ops_of( 40 ) );
+      // a block which would leave a gap is ignored
+      log.add_block( 6, fc::time_point_sec( 600 ), ops_of( 6 ) );
+      log.write_irreversible( 3 );
+      BOOST_CHECK_EQUAL( log.last_block_num(), 3u );
+      log.write_irreversible( 10 );
+      BOOST_CHECK_EQUAL( log.last_block_num(), 4u );
+      // blocks which are in the log already are not taken again
+      log.add_block( 2, fc::time_point_sec( 201 ), ops_of( 20 ) );
+      log.write_irreversible( 10 );
+
+      auto entries = read_all( log );
+      BOOST_REQUIRE_EQUAL( entries.size(), 4u );
+      for( uint32_t i = 0; i < entries.size(); ++i )
+      {
+         BOOST_CHECK_EQUAL( entries[i].block_num, i + 1 );
+         BOOST_REQUIRE_EQUAL( entries[i].ops.size(), 1u );
+      }
+      BOOST_CHECK( entries[1].timestamp == fc::time_point_sec( 200 ) );
+      BOOST_CHECK( entries[3].timestamp == fc::time_point_sec( 401 ) );
+      BOOST_CHECK_EQUAL( entries[3].ops[0].op.get<transfer_operation>().amount.amount.value, 40 );
+      log.close();
+
+      // an incomplete entry at the end is dropped when the log is opened
+      const uint64_t size = fc::file_size( file );
+      {
+         std::ofstream out( file.generic_string().c_str(), std::ios::binary | std::ios::app );
+         const uint32_t packed_size = 1000;
+         out.write( reinterpret_cast<const char*>( &packed_size ), sizeof(packed_size) );
+         out.write( "abc", 3 );
+      }
+      log.open( file );
+      BOOST_CHECK_EQUAL( fc::file_size( file ), size );
+      BOOST_CHECK_EQUAL( log.last_block_num(), 4u );
+      log.add_block( 5, fc::time_point_sec( 500 ), ops_of( 5 ) );
+      log.write_irreversible( 5 );
+      BOOST_CHECK_EQUAL( read_all( log ).size(), 5u );
+      log.close();
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( state_delta_log_gap )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      const fc::path file = data_dir.path() / "state_deltas";
+
+      std::vector<state_delta> deltas;
+      clearable_block b;
+      for( uint32_t i = 0; i < 6; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         b.clear();
+         state_delta delta;
+         delta.block = b;
+         deltas.push_back( delta );
+      }
+
+      state_delta_log log;
+      log.open( file );
+      for( uint32_t i = 0; i < 3; ++i )
+         log.add_block( state_delta( deltas[i] ) );
+      log.write_irreversible( 3 );
+      BOOST_CHECK_EQUAL( log.first_block_num(), 1u );
+      BOOST_CHECK_EQUAL( log.last_block_num(), 3u );
+
+      // block 4 is missing, the log starts over with block 5
+      log.add_block( state_delta( deltas[4] ) );
+      log.add_block( state_delta( deltas[5] ) );
+      log.write_irreversible( 6 );
+      BOOST_CHECK_EQUAL( log.first_block_num(), 5u );
+      BOOST_CHECK_EQUAL( log.last_block_num(), 6u );
+
+      vector<vector<char>> packed_deltas;
+      log.read_packed( 1, 100, [&packed_deltas]( const vector<char>& packed ) { packed_deltas.push_back( packed ); } );
+      BOOST_CHECK( packed_deltas.empty() );
+      log.read_packed( 5, 100, [&packed_deltas]( const vector<char>& packed ) { packed_deltas.push_back( packed ); } );
+      BOOST_CHECK_EQUAL( packed_deltas.size(), 2u );
+
+      log.close();
+      log.open( file );
+      BOOST_CHECK_EQUAL( log.first_block_num(), 5u );
+      BOOST_CHECK_EQUAL( log.last_block_num(), 6u );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( state_delta_replica )
+{
+   try {
+      fc::temp_directory data_dir1( graphene::utilities::temp_directory_path() );
+      fc::temp_directory data_dir2( graphene::utilities::temp_directory_path() );
+
+      database db1;
+      db1.enable_state_delta_log( true );
+      db1.open( data_dir1.path(), make_genesis, "TEST" );
+      db1.set_state_hash_blocks( 1 );
+      // the replica starts with the same state as the primary
+      database db2;
+      db2.open( data_dir2.path(), make_genesis, "TEST" );
+      db2.set_state_hash_blocks( 1 );
+      BOOST_CHECK( db1.get_state_hash() == db2.get_state_hash() );
+
+      auto init_account_priv_key  = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")) );
+      const auto first_slot = db1.get_slot_at_time( fc::time_point::now() );
+      db1.generate_block( db1.get_slot_time(first_slot), db1.get_scheduled_witness(first_slot),
+                          init_account_priv_key, database::skip_nothing );
+      for( uint32_t i = 0; i < 30; ++i )
+         db1.generate_block( db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key,
+                             database::skip_nothing );
+
+      // only the deltas of the irreversible blocks are written
+      const auto& log = db1.get_state_delta_log();
+      BOOST_CHECK_EQUAL( log.first_block_num(), 1u );
+      BOOST_REQUIRE_GT( log.last_block_num(), 1u );
+      BOOST_CHECK_LE( log.last_block_num(), db1.get_dynamic_global_properties().last_irreversible_block_num );
+
+      vector<vector<char>> packed_deltas;
+      log.read_packed( 1, 100, [&packed_deltas]( const vector<char>& packed ) {
+         packed_deltas.push_back( packed );
+      });
+      BOOST_REQUIRE_EQUAL( packed_deltas.size(), log.last_block_num() );
+      for( const auto& packed : packed_deltas )
+         db2.apply_state_delta( fc::raw::unpack<state_delta>( packed ) );
+      BOOST_CHECK_EQUAL( db2.head_block_num(), log.last_block_num() );
+      BOOST_CHECK( db2.fetch_block_by_number( db2.head_block_num() ).valid() );
+
+      // the replica has the state of the primary at the same block
+      while( db1.head_block_num() > db2.head_block_num() )
+         db1.pop_block();
+      BOOST_CHECK( db1.head_block_id() == db2.head_block_id() );
+      BOOST_CHECK( db1.get_state_hash() == db2.get_state_hash() );
+
+      // a delta which does not follow the head block is rejected
+      BOOST_CHECK_THROW( db2.apply_state_delta( fc::raw::unpack<state_delta>( packed_deltas.front() ) ),
+                         fc::exception );
+
+      // reading from the middle of the log
+      vector<vector<char>> tail;
+      log.read_packed( 3, 2, [&tail]( const vector<char>& packed ) { tail.push_back( packed ); } );
+      BOOST_REQUIRE_EQUAL( tail.size(), 2u );
+      BOOST_CHECK( tail[0] == packed_deltas[2] );
+      BOOST_CHECK( tail[1] == packed_deltas[3] );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_database_cache )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      block_database bdb;
+      bdb.open( data_dir.path() );
+      bdb.set_cache_size( 2 );
+
+      std::vector<block_id_type> ids;
+      clearable_block b;
+      for( uint32_t i = 0; i < 5; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         b.clear();
+         bdb.store( b.id(), b );
+         ids.push_back( b.id() );
+      }
+
+      BOOST_CHECK( bdb.fetch_by_number( 1 )->id() == ids[0] );
+      BOOST_CHECK( bdb.fetch_by_number( 1 )->id() == ids[0] );
+      BOOST_CHECK( bdb.fetch_optional( ids[0] )->id() == ids[0] );
+      auto stats = bdb.get_cache_stats();
+      BOOST_CHECK_EQUAL( stats.misses, 1u );
+      BOOST_CHECK_EQUAL( stats.hits, 2u );
+      BOOST_CHECK_EQUAL( stats.size, 1u );
+
+      // the least recently used block is evicted
+      bdb.fetch_by_number( 2 );
+      bdb.fetch_by_number( 1 );
+      bdb.fetch_by_number( 3 );
+      stats = bdb.get_cache_stats();
+      BOOST_CHECK_EQUAL( stats.size, 2u );
+      BOOST_CHECK( bdb.fetch_by_number( 1 ).valid() );
+      BOOST_CHECK_EQUAL( bdb.get_cache_stats().hits, stats.hits + 1 );
+      BOOST_CHECK( bdb.fetch_by_number( 2 ).valid() );
+      BOOST_CHECK_EQUAL( bdb.get_cache_stats().misses, stats.misses + 1 );
+
+      // removed and replaced blocks are not served from the cache
+      bdb.fetch_by_number( 5 );
+      bdb.remove( ids[4] );
+      BOOST_CHECK( !bdb.fetch_by_number( 5 ).valid() );
+      BOOST_CHECK( !bdb.fetch_optional( ids[4] ).valid() );
+      b.witness = witness_id_type(100);
+      b.clear();
+      bdb.store( b.id(), b );
+      BOOST_CHECK( bdb.fetch_by_number( 5 )->id() == b.id() );
+
+      bdb.set_cache_size( 0 );
+      BOOST_CHECK_EQUAL( bdb.get_cache_stats().size, 0u );
+      bdb.close();
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_database_cache_concurrent_replace )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      block_database bdb;
+      bdb.open( data_dir.path() );
+      bdb.set_cache_size( 10 );
+      bdb.set_write_batch_size( 1 );
+
+      clearable_block b;
+      for( uint32_t i = 0; i < 5; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         b.clear();
+         bdb.store( b.id(), b );
+      }
+
+      // a reader which read a block just before it was replaced must not put it back into the cache
+      std::atomic<bool> done{false};
+      std::thread reader( [&bdb,&done]() {
+         while( !done )
+         {
+            bdb.fetch_by_number( 5 );
+            bdb.fetch_by_number( 4 );
+         }
+      });
+      for( uint32_t i = 0; i < 500; ++i )
+      {
+         b.witness = witness_id_type(100+i);
+         b.clear();
+         bdb.store( b.id(), b );
+         BOOST_CHECK( bdb.fetch_by_number( 5 )->id() == b.id() );
+      }
+      done = true;
+      reader.join();
+
+      BOOST_CHECK( bdb.fetch_by_number( 5 )->id() == b.id() );
+      BOOST_CHECK( bdb.fetch_optional( b.id() ).valid() );
+      bdb.close();
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+#ifdef GRAPHENE_BLOCK_LOG_COMPRESSION
+BOOST_AUTO_TEST_CASE( block_database_compression )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      block_database bdb;
+      bdb.set_compression( 8 );
+      bdb.open( data_dir.path() );
+      BOOST_CHECK( bdb.is_compressed() );
+      BOOST_CHECK( fc::exists( data_dir.path() / "blocks.z" ) );
+
+      std::vector<block_id_type> ids;
+      clearable_block b;
+      signed_block first;
+      for( uint32_t i = 0; i < 20; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         b.clear();
+         bdb.store( b.id(), b );
+         ids.push_back( b.id() );
+         if( i == 0 ) first = b;
+      }
+      // the last frame is incomplete and still buffered
+      for( uint32_t j = 0; j < ids.size(); ++j )
+      {
+         auto blk = bdb.fetch_by_number( j+1 );
+         BOOST_REQUIRE( blk.valid() );
+         BOOST_CHECK( blk->id() == ids[j] );
+      }
+      bdb.remove( ids.back() );
+      bdb.close();
+
+      // an existing compressed log stays compressed
+      block_database bdb2;
+      bdb2.open( data_dir.path() );
+      BOOST_CHECK( bdb2.is_compressed() );
+      BOOST_REQUIRE( bdb2.last_id().valid() );
+      BOOST_CHECK( *bdb2.last_id() == ids[ids.size() - 2] );
+      for( uint32_t j = 0; j + 1 < ids.size(); ++j )
+      {
+         auto blk = bdb2.fetch_optional( ids[j] );
+         BOOST_REQUIRE( blk.valid() );
+         BOOST_CHECK( blk->id() == ids[j] );
+      }
+      BOOST_CHECK( !bdb2.contains( ids.back() ) );
+      bdb2.close();
+
+      // an existing uncompressed log stays uncompressed
+      fc::temp_directory plain_dir( graphene::utilities::temp_directory_path() );
+      bdb2.open( plain_dir.path() );
+      bdb2.store( ids[0], first );
+      bdb2.close();
+      block_database bdb3;
+      bdb3.set_compression( 8 );
+      bdb3.open( plain_dir.path() );
+      BOOST_CHECK( !bdb3.is_compressed() );
+      BOOST_CHECK( bdb3.contains( ids[0] ) );
+      bdb3.close();
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+#endif
+
 BOOST_AUTO_TEST_CASE( generate_empty_blocks )
 {
    try {
@@ -192,6 +695,120 @@ BOOST_AUTO_TEST_CASE( generate_empty_blocks )
    }
 }
 
+BOOST_AUTO_TEST_CASE( replay_blocks )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")) );
+      uint32_t last_block;
+      block_id_type last_id;
+      {
+         database db;
+         db.open(data_dir.path(), make_genesis, "TEST" );
+         for( uint32_t i = 0; i < 100; ++i )
+            db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key,
+                              database::skip_nothing);
+         last_block = db.head_block_num();
+         last_id = db.head_block_id();
+         db.close( false );
+      }
+      {
+         database db;
+         db.set_reindex_pipeline_depth( 7 );
+         db.set_replay_checkpoint_interval( 10 );
+         db.wipe( data_dir.path(), false );
+         BOOST_CHECK( !database::has_replay_checkpoint( data_dir.path(), db.get_node_properties().skip_flags ) );
+         db.open(data_dir.path(), make_genesis, "TEST" );
+         BOOST_CHECK_EQUAL( db.head_block_num(), last_block );
+         BOOST_CHECK( db.head_block_id() == last_id );
+         BOOST_CHECK( !fc::exists( data_dir.path() / "replay_checkpoint" ) );
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( replay_range_revalidation )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      fc::temp_directory archive_dir( graphene::utilities::temp_directory_path() );
+      auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")) );
+      {
+         database db;
+         db.open(data_dir.path(), make_genesis, "TEST" );
+         for( uint32_t i = 0; i < 100; ++i )
+            db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key,
+                              database::skip_nothing);
+         db.close( false );
+      }
+      // archive the range boundaries
+      {
+         database db;
+         db.set_replay_checkpoint_archive( archive_dir.path() );
+         db.set_replay_end_block( 50 );
+         db.wipe( data_dir.path(), false );
+         db.open(data_dir.path(), make_genesis, "TEST" );
+         BOOST_CHECK_EQUAL( db.head_block_num(), 50u );
+         BOOST_CHECK( fc::exists( data_dir.path() / "replay_checkpoint" ) );
+         db.close( false );
+      }
+      {
+         database db;
+         db.set_replay_checkpoint_archive( archive_dir.path() );
+         db.set_replay_end_block( 100 );
+         db.open(data_dir.path(), make_genesis, "TEST" );
+         BOOST_CHECK_EQUAL( db.head_block_num(), 100u );
+         db.close( false );
+      }
+      BOOST_REQUIRE( fc::exists( archive_dir.path() / "50" / "replay_checkpoint" ) );
+      BOOST_REQUIRE( fc::exists( archive_dir.path() / "100" / "replay_checkpoint" ) );
+
+      // revalidate the second range from the archived start
+      fc::remove_all( data_dir.path() / "object_database" );
+      fc::remove_all( data_dir.path() / "replay_checkpoint" );
+      fc::rename( archive_dir.path() / "50" / "object_database", data_dir.path() / "object_database" );
+      fc::copy( archive_dir.path() / "50" / "replay_checkpoint", data_dir.path() / "replay_checkpoint" );
+      BOOST_CHECK( database::has_replay_checkpoint( data_dir.path(), database::skip_nothing ) );
+      {
+         database db;
+         db.set_replay_checkpoint_archive( archive_dir.path() );
+         db.set_replay_end_block( 100 );
+         db.open(data_dir.path(), make_genesis, "TEST" );
+         BOOST_CHECK_EQUAL( db.head_block_num(), 100u );
+         db.close( false );
+      }
+
+      // a different end state is detected
+      {
+         database db;
+         db.set_replay_end_block( 50 );
+         db.wipe( data_dir.path(), false );
+         db.open(data_dir.path(), make_genesis, "TEST" );
+         db.close( false );
+      }
+      {
+         const fc::path file = archive_dir.path() / "100" / "replay_checkpoint";
+         fc::mutable_variant_object checkpoint( fc::json::from_file( file ).get_object() );
+         auto indexes = checkpoint["indexes"].as< vector<graphene::db::index_state_hash> >( 4 );
+         BOOST_REQUIRE( !indexes.empty() );
+         indexes.front().hash = fc::sha256::hash( string("changed") );
+         checkpoint( "indexes", fc::variant( indexes, 3 ) );
+         fc::json::save_to_file( fc::variant( checkpoint, 4 ), file );
+      }
+      {
+         database db;
+         db.set_replay_checkpoint_archive( archive_dir.path() );
+         db.set_replay_end_block( 100 );
+         GRAPHENE_REQUIRE_THROW( db.open(data_dir.path(), make_genesis, "TEST" ), fc::exception );
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( undo_block )
 {
    try {
@@ -504,13 +1121,47 @@ BOOST_AUTO_TEST_CASE( fork_db_tests )
         prev = b;
      }
      auto head = fdb.head();
-     FC_ASSERT( head && head->data.block_num() == 1799 );
+     FC_ASSERT( head && head->num == 1799 );
 
      fdb.push_block(skipped_block);
      head = fdb.head();
-     FC_ASSERT( head && head->data.block_num() == 2001, "", ("head",head->data.block_num()) );
+     FC_ASSERT( head && head->num == 2001, "", ("head",head->num) );
   } FC_LOG_AND_RETHROW() 
 }
+
+BOOST_AUTO_TEST_CASE( fork_db_shared_blocks )
+{
+   try {
+     fork_database fdb;
+     clearable_block b;
+     b.witness = witness_id_type(1);
+     fdb.push_block( b );
+     const auto first = fdb.head();
+     const auto first_id = b.id();
+
+     b.previous = b.id();
+     b.clear();
+     fdb.push_block( b );
+     BOOST_CHECK( fdb.head()->id == b.id() );
+
+     // the former head is decoded from its serialized form again
+     const auto decoded = first->block();
+     BOOST_REQUIRE( decoded );
+     BOOST_CHECK( decoded->id() == first_id );
+     BOOST_CHECK( decoded->witness == witness_id_type(1) );
+
+     // the block database keeps the same buffer until it is written
+     fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+     block_database bdb;
+     bdb.open( data_dir.path() );
+     const auto use_count = first->packed.use_count();
+     bdb.store( first->id, first->packed );
+     BOOST_CHECK_EQUAL( first->packed.use_count(), use_count + 1 );
+     BOOST_CHECK( bdb.fetch_optional( first_id ).valid() );
+     bdb.close();
+     BOOST_CHECK_EQUAL( first->packed.use_count(), use_count );
+  } FC_LOG_AND_RETHROW()
+}
 BOOST_AUTO_TEST_CASE( out_of_order_blocks )
 {
    try {
@@ -688,6 +1339,64 @@ BOOST_AUTO_TEST_CASE( switch_forks_undo_create )
    }
 }
 
+BOOST_AUTO_TEST_CASE( switch_back_to_applied_fork )
+{
+   try {
+      fc::temp_directory dir1( graphene::utilities::temp_directory_path() ),
+                         dir2( graphene::utilities::temp_directory_path() ),
+                         dir3( graphene::utilities::temp_directory_path() );
+      database db1,
+               db2,
+               db3;
+      db1.open(dir1.path(), make_genesis, "TEST");
+      db2.open(dir2.path(), make_genesis, "TEST");
+      db3.open(dir3.path(), make_genesis, "TEST");
+
+      auto init_account_priv_key  = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")) );
+
+      // generate blocks
+      // db1, db2 and db3 : 1
+      // db1 and db3      :   A2 A3       A4 A5
+      // db2              :         B2 B3 B4
+      {
+         auto b = db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+         PUSH_BLOCK( db2, b );
+         PUSH_BLOCK( db3, b );
+      }
+      for( int i = 0; i < 2; ++i )
+      {
+         auto b = db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+         PUSH_BLOCK( db3, b );
+      }
+      const block_id_type a3_id = db1.head_block_id();
+
+      uint32_t next_slot = 3;
+      for( int i = 0; i < 3; ++i )
+      {
+         auto b = db2.generate_block(db2.get_slot_time(next_slot), db2.get_scheduled_witness(next_slot), init_account_priv_key, database::skip_nothing);
+         next_slot = 1;
+         PUSH_BLOCK( db1, b );
+      }
+      BOOST_TEST_MESSAGE( "db1 switched to the longer fork of db2" );
+      BOOST_CHECK( db1.head_block_id() == db2.head_block_id() );
+      BOOST_CHECK( db1.fetch_block_by_number(3)->id() != a3_id );
+
+      for( int i = 0; i < 2; ++i )
+      {
+         auto b = db3.generate_block(db3.get_slot_time(next_slot), db3.get_scheduled_witness(next_slot), init_account_priv_key, database::skip_nothing);
+         next_slot = 1;
+         PUSH_BLOCK( db1, b );
+      }
+      BOOST_TEST_MESSAGE( "db1 switched back to its blocks which it had applied before" );
+      BOOST_CHECK( db1.head_block_id() == db3.head_block_id() );
+      BOOST_CHECK_EQUAL( db1.head_block_num(), 5u );
+      BOOST_CHECK( db1.fetch_block_by_number(3)->id() == a3_id );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( duplicate_transactions )
 {
    try {
@@ -740,6 +1449,57 @@ BOOST_AUTO_TEST_CASE( duplicate_transactions )
    }
 }
 
+BOOST_AUTO_TEST_CASE( checkpoint_merkle_check )
+{
+   try {
+      fc::temp_directory dir1( graphene::utilities::temp_directory_path() ),
+                         dir2( graphene::utilities::temp_directory_path() );
+      database db1,
+               db2;
+      db1.open(dir1.path(), make_genesis, "TEST");
+      db2.open(dir2.path(), make_genesis, "TEST");
+
+      auto init_account_priv_key  = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")) );
+
+      signed_transaction trx;
+      set_expiration( db1, trx );
+      account_create_operation cop;
+      cop.name = "nathan";
+      cop.owner = authority(1, init_account_priv_key.get_public_key(), 1);
+      cop.active = cop.owner;
+      trx.operations.push_back(cop);
+      trx.sign( init_account_priv_key, db1.get_chain_id() );
+      PUSH_TX( db1, trx );
+
+      auto b1 = db1.generate_block( db1.get_slot_time(1), db1.get_scheduled_witness( 1 ), init_account_priv_key,
+                                    database::skip_nothing );
+      auto b2 = db1.generate_block( db1.get_slot_time(1), db1.get_scheduled_witness( 1 ), init_account_priv_key,
+                                    database::skip_nothing );
+      BOOST_REQUIRE_EQUAL( b1.transactions.size(), 1u );
+
+      db2.add_checkpoints( { { b2.block_num(), b2.id() } } );
+      BOOST_CHECK_EQUAL( db2.checkpoint_skip_flags( b1.block_num(), database::skip_nothing ),
+                         ~uint32_t( database::skip_merkle_check ) );
+      BOOST_CHECK_EQUAL( db2.checkpoint_skip_flags( b2.block_num() + 1, database::skip_nothing ),
+                         uint32_t( database::skip_nothing ) );
+
+      // the block ID does not cover the transactions, so a block with altered transactions is still rejected
+      // the tampered block is serialized and decoded like a received one, so that no cached merkle root survives
+      signed_block tampered = b1;
+      tampered.transactions[0].signatures.clear();
+      const signed_block bad = fc::raw::unpack<signed_block>( fc::raw::pack( tampered ) );
+      BOOST_CHECK( bad.id() == b1.id() );
+      GRAPHENE_REQUIRE_THROW( PUSH_BLOCK( db2, bad ), fc::exception );
+
+      PUSH_BLOCK( db2, b1 );
+      PUSH_BLOCK( db2, b2 );
+      BOOST_CHECK( db2.head_block_id() == b2.id() );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( tapos )
 {
    try {
@@ -1872,4 +2632,423 @@ BOOST_FIXTURE_TEST_CASE( block_size_test, database_fixture )
    }
 }
 
+BOOST_FIXTURE_TEST_CASE( signature_cache_test, database_fixture )
+{
+   try
+   {
+      ACTORS((alice)(bob));
+      transfer(committee_account, alice_id, asset(10000000));
+      generate_block();
+
+      signature_cache cache;
+      const digest_type digest = digest_type::hash( std::string( "revpop" ) );
+      const signature_type sig = alice_private_key.sign_compact( digest );
+      BOOST_CHECK( cache.recover( sig, digest ) == public_key_type( alice_private_key.get_public_key() ) );
+      BOOST_CHECK_EQUAL( cache.get_stats().size, 0u ); // disabled by default
+
+      cache.set_capacity( 1 );
+      BOOST_CHECK( cache.recover( sig, digest ) == public_key_type( alice_private_key.get_public_key() ) );
+      BOOST_CHECK( cache.recover( sig, digest ) == public_key_type( alice_private_key.get_public_key() ) );
+      BOOST_CHECK_EQUAL( cache.get_stats().hits, 1u );
+      const signature_type bob_sig = bob_private_key.sign_compact( digest );
+      BOOST_CHECK( cache.recover( bob_sig, digest ) == public_key_type( bob_private_key.get_public_key() ) );
+      BOOST_CHECK_EQUAL( cache.get_stats().size, 1u );
+
+      BOOST_TEST_MESSAGE( "A transaction seen before is not recovered again when it arrives in a block" );
+      db.set_signature_cache_size( 100 );
+      signed_transaction tx;
+      transfer_operation op;
+      op.from = alice_id;
+      op.to = bob_id;
+      op.amount = asset(1);
+      tx.operations.push_back( op );
+      tx.set_expiration( db.head_block_time() + fc::minutes(5) );
+      tx.set_reference_block( db.head_block_id() );
+      sign( tx, alice_private_key );
+      precomputable_transaction ptx( tx );
+      db.precompute_parallel( ptx ).wait();
+      const auto misses = db.get_signature_cache_stats().misses;
+      PUSH_TX( db, ptx );
+
+      signed_block b = generate_block();
+      BOOST_REQUIRE_EQUAL( b.transactions.size(), 1u );
+      // a decoded copy does not carry the keys recovered before
+      const signed_block received = fc::raw::unpack<signed_block>( fc::raw::pack( b ) );
+      const auto hits = db.get_signature_cache_stats().hits;
+      db.precompute_parallel( received ).wait();
+      BOOST_CHECK_EQUAL( db.get_signature_cache_stats().misses, misses );
+      BOOST_CHECK_GT( db.get_signature_cache_stats().hits, hits );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( precompute_block_signatures, database_fixture )
+{
+   try
+   {
+      ACTORS((alice)(bob));
+
+      auto make_tx = [&]( int64_t amount ) {
+         signed_transaction tx;
+         transfer_operation op;
+         op.from = committee_account;
+         op.to = alice_id;
+         op.amount = asset(amount);
+         tx.operations.push_back( op );
+         tx.set_expiration( db.head_block_time() + fc::minutes(5) );
+         tx.set_reference_block( db.head_block_id() );
+         return tx;
+      };
+
+      // most signatures are in one transaction
+      signed_block b;
+      signed_transaction heavy = make_tx(1);
+      sign( heavy, alice_private_key );
+      sign( heavy, bob_private_key );
+      sign( heavy, init_account_priv_key );
+      b.transactions.push_back( processed_transaction( heavy ) );
+      for( int64_t amount = 2; amount < 5; ++amount )
+      {
+         signed_transaction light = make_tx( amount );
+         sign( light, bob_private_key );
+         b.transactions.push_back( processed_transaction( light ) );
+      }
+
+      const signed_block received = fc::raw::unpack<signed_block>( fc::raw::pack( b ) );
+      db.precompute_parallel( received, database::skip_witness_signature ).wait();
+      const flat_set<public_key_type> heavy_keys = { alice_private_key.get_public_key(),
+                                                     bob_private_key.get_public_key(),
+                                                     init_account_priv_key.get_public_key() };
+      BOOST_CHECK( received.transactions[0].get_signature_keys( db.get_chain_id() ) == heavy_keys );
+      for( size_t i = 1; i < received.transactions.size(); ++i )
+      {
+         const auto& keys = received.transactions[i].get_signature_keys( db.get_chain_id() );
+         BOOST_REQUIRE_EQUAL( keys.size(), 1u );
+         BOOST_CHECK( *keys.begin() == public_key_type( bob_private_key.get_public_key() ) );
+      }
+
+      BOOST_TEST_MESSAGE( "Duplicate signatures are reported through the future" );
+      signed_block dup;
+      signed_transaction twice = make_tx(5);
+      sign( twice, alice_private_key );
+      twice.signatures.push_back( twice.signatures.front() );
+      dup.transactions.push_back( processed_transaction( twice ) );
+      dup.transactions.push_back( processed_transaction( heavy ) );
+      GRAPHENE_REQUIRE_THROW( db.precompute_parallel( dup, database::skip_witness_signature ).wait(),
+                              fc::exception );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( transaction_pool_limits, database_fixture )
+{
+   try
+   {
+      ACTORS((alice)(bob));
+      transfer(committee_account, alice_id, asset(10000000));
+      generate_block();
+
+      auto make_transfer = [&]( int64_t amount ) {
+         signed_transaction tx;
+         transfer_operation op;
+         op.from = alice_id;
+         op.to = bob_id;
+         op.amount = asset(amount);
+         tx.operations.push_back( op );
+         tx.set_expiration( db.head_block_time() + fc::minutes(5) );
+         tx.set_reference_block( db.head_block_id() );
+         sign( tx, alice_private_key );
+         return tx;
+      };
+
+      BOOST_TEST_MESSAGE( "Per account limit" );
+      transaction_pool_limits limits;
+      limits.max_transactions_per_account = 2;
+      db.set_transaction_pool_limits( limits );
+      PUSH_TX( db, make_transfer(1) );
+      const auto tx2 = make_transfer(2);
+      PUSH_TX( db, tx2 );
+      GRAPHENE_REQUIRE_THROW( PUSH_TX( db, make_transfer(3) ), fc::exception );
+      BOOST_CHECK_EQUAL( db.get_transaction_pool().size(), 2u );
+      BOOST_CHECK( db.get_transaction_pool().contains( tx2.id() ) );
+      BOOST_CHECK( db.is_known_transaction( tx2.id() ) );
+      generate_block();
+      BOOST_CHECK( db.get_transaction_pool().empty() );
+      BOOST_CHECK_EQUAL( db.fetch_block_by_number( db.head_block_num() )->transactions.size(), 2u );
+
+      BOOST_TEST_MESSAGE( "Pool size limit" );
+      limits = transaction_pool_limits();
+      limits.max_transactions = 2;
+      db.set_transaction_pool_limits( limits );
+      PUSH_TX( db, make_transfer(4) );
+      PUSH_TX( db, make_transfer(5) );
+      // does not pay more than the pending transactions
+      GRAPHENE_REQUIRE_THROW( PUSH_TX( db, make_transfer(6) ), fc::exception );
+      generate_block();
+      BOOST_CHECK( db.get_transaction_pool().empty() );
+
+      BOOST_TEST_MESSAGE( "Limited reapplication after a block" );
+      limits = transaction_pool_limits();
+      limits.max_reapplied = 1;
+      db.set_transaction_pool_limits( limits );
+      PUSH_TX( db, make_transfer(7) );
+      PUSH_TX( db, make_transfer(8) );
+      PUSH_TX( db, make_transfer(9) );
+
+      signed_block empty;
+      empty.previous = db.head_block_id();
+      empty.timestamp = db.get_slot_time(1);
+      empty.witness = db.get_scheduled_witness(1);
+      empty.transaction_merkle_root = empty.calculate_merkle_root();
+      empty.sign( init_account_priv_key );
+      PUSH_BLOCK( db, empty );
+
+      BOOST_CHECK_EQUAL( db.get_transaction_pool().size(), 3u );
+      size_t applied = 0;
+      for( const auto& entry : db.get_transaction_pool().transactions() )
+         if( entry.applied )
+            ++applied;
+      BOOST_CHECK_EQUAL( applied, 1u );
+
+      // all of them are included in the next produced block
+      generate_block();
+      BOOST_CHECK( db.get_transaction_pool().empty() );
+      BOOST_CHECK_EQUAL( db.fetch_block_by_number( db.head_block_num() )->transactions.size(), 3u );
+
+      BOOST_TEST_MESSAGE( "Network admission under pressure" );
+      limits = transaction_pool_limits();
+      limits.max_transactions = 4;
+      limits.network_pressure_percent = 50;
+      db.set_transaction_pool_limits( limits );
+      PUSH_TX( db, make_transfer(10) );
+      db.check_network_transaction_admission( precomputable_transaction( make_transfer(11) ) );
+      PUSH_TX( db, make_transfer(12) );
+      BOOST_CHECK_EQUAL( db.get_transaction_pool().fill_percent(), 50u );
+      // the network transaction does not pay more than the pending ones, a local one is still accepted
+      const signed_transaction cheap = make_transfer(13);
+      GRAPHENE_REQUIRE_THROW( db.check_network_transaction_admission( precomputable_transaction( cheap ) ),
+                              fc::exception );
+      PUSH_TX( db, cheap );
+
+      signed_transaction generous = make_transfer(14);
+      generous.operations.front().get<transfer_operation>().fee = asset(1000);
+      generous.clear_signatures();
+      sign( generous, alice_private_key );
+      db.check_network_transaction_admission( precomputable_transaction( generous ) );
+
+      // expensive transactions are refused too
+      limits.network_max_cost_us = 1;
+      db.set_transaction_pool_limits( limits );
+      GRAPHENE_REQUIRE_THROW( db.check_network_transaction_admission( precomputable_transaction( generous ) ),
+                              fc::exception );
+      generate_block();
+   } catch(const fc::exception& e) {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
+BOOST_FIXTURE_TEST_CASE( block_packing_budget, database_fixture )
+{
+   try
+   {
+      ACTORS((alice)(bob));
+      transfer(committee_account, alice_id, asset(10000000));
+      generate_block();
+
+      // every measured operation costs at least 1 microsecond, so each of these exceeds a budget of 1
+      for( int64_t amount = 1; amount <= 6; amount += 2 )
+      {
+         signed_transaction tx;
+         transfer_operation op;
+         op.from = alice_id;
+         op.to = bob_id;
+         op.amount = asset(amount);
+         tx.operations.push_back( op );
+         op.amount = asset(amount + 1);
+         tx.operations.push_back( op );
+         tx.set_expiration( db.head_block_time() + fc::minutes(5) );
+         tx.set_reference_block( db.head_block_id() );
+         sign( tx, alice_private_key );
+         PUSH_TX( db, tx );
+      }
+      const auto& costs = db.get_recent_operation_costs();
+      BOOST_REQUIRE_GT( costs.size(), size_t(operation::tag<transfer_operation>::value) );
+      BOOST_CHECK_GT( costs[operation::tag<transfer_operation>::value], 0u );
+
+      BOOST_TEST_MESSAGE( "Transactions exceeding the cost budget are deferred, except one per block" );
+      db.set_block_packing_budget( fc::microseconds(0), fc::microseconds(1) );
+      generate_block();
+      BOOST_CHECK_EQUAL( db.fetch_block_by_number( db.head_block_num() )->transactions.size(), 1u );
+      BOOST_CHECK_EQUAL( db.get_last_block_generation_timings().deferred_by_budget, 2u );
+      BOOST_CHECK_EQUAL( db.get_transaction_pool().size(), 2u );
+
+      BOOST_TEST_MESSAGE( "Deferred transactions are packed once the budget allows" );
+      db.set_block_packing_budget( fc::seconds(1), fc::microseconds(0) );
+      generate_block();
+      BOOST_CHECK_EQUAL( db.fetch_block_by_number( db.head_block_num() )->transactions.size(), 2u );
+      BOOST_CHECK_EQUAL( db.get_last_block_generation_timings().deferred_by_budget, 0u );
+      BOOST_CHECK( db.get_transaction_pool().empty() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( speculative_block_assembly, database_fixture )
+{
+   try
+   {
+      ACTORS((alice)(bob));
+      transfer(committee_account, alice_id, asset(10000000));
+      generate_block();
+      db.set_speculative_block_assembly( true );
+
+      auto push_transfer = [&]( int64_t amount, fc::time_point_sec expiration, uint32_t skip = 0 ) {
+         signed_transaction tx;
+         transfer_operation op;
+         op.from = alice_id;
+         op.to = bob_id;
+         op.amount = asset(amount);
+         tx.operations.push_back( op );
+         tx.set_expiration( expiration );
+         tx.set_reference_block( db.head_block_id() );
+         sign( tx, alice_private_key );
+         PUSH_TX( db, tx, skip );
+      };
+
+      BOOST_TEST_MESSAGE( "The pending transactions are packed as they are" );
+      push_transfer( 1, db.head_block_time() + fc::minutes(5) );
+      push_transfer( 2, db.head_block_time() + fc::minutes(5) );
+      generate_block();
+      BOOST_CHECK( db.get_last_block_generation_timings().from_pending_state );
+      BOOST_CHECK_EQUAL( db.fetch_block_by_number( db.head_block_num() )->transactions.size(), 2u );
+      BOOST_CHECK_EQUAL( get_balance( bob_id, asset_id_type() ), 3 );
+
+      BOOST_TEST_MESSAGE( "A transaction expiring before the block time makes the pending transactions be applied again" );
+      push_transfer( 4, db.head_block_time() + fc::minutes(5) );
+      push_transfer( 8, db.get_slot_time(1) );
+      generate_block( ~0, init_account_priv_key, 1 );
+      BOOST_CHECK( !db.get_last_block_generation_timings().from_pending_state );
+      BOOST_CHECK_EQUAL( db.fetch_block_by_number( db.head_block_num() )->transactions.size(), 1u );
+      BOOST_CHECK_EQUAL( get_balance( bob_id, asset_id_type() ), 7 );
+
+      BOOST_TEST_MESSAGE( "Transactions applied with fewer checks than the generation are applied again" );
+      push_transfer( 16, db.head_block_time() + fc::minutes(5), database::skip_tapos_check );
+      generate_block( database::skip_nothing );
+      BOOST_CHECK( !db.get_last_block_generation_timings().from_pending_state );
+      BOOST_CHECK_EQUAL( get_balance( bob_id, asset_id_type() ), 23 );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( fetch_packed_blocks, database_fixture )
+{
+   try
+   {
+      generate_blocks( 5 );
+      const uint32_t head_num = db.head_block_num();
+
+      vector<char> data;
+      for( uint32_t num = 1; num <= head_num; ++num )
+      {
+         BOOST_REQUIRE( db.fetch_packed_block_by_number( num, data ) );
+         const auto block = fc::raw::unpack<signed_block>( data );
+         BOOST_CHECK( block.id() == db.get_block_id_for_num( num ) );
+         BOOST_CHECK( data == fc::raw::pack( *db.fetch_block_by_number( num ) ) );
+      }
+      BOOST_CHECK( !db.fetch_packed_block_by_number( head_num + 1, data ) );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( light_client_proofs, database_fixture )
+{
+   try
+   {
+      // trees of every shape up to a few levels
+      for( uint32_t count = 1; count <= 9; ++count )
+      {
+         signed_block block;
+         vector<digest_type> leaves;
+         for( uint32_t i = 0; i < count; ++i )
+         {
+            block.transactions.emplace_back();
+            block.transactions.back().ref_block_num = i;
+            leaves.push_back( block.transactions.back().merkle_digest() );
+         }
+         const auto tree = graphene::protocol::merkle_proof::calculate_tree( std::move( leaves ) );
+         for( uint32_t i = 0; i < count; ++i )
+         {
+            const graphene::protocol::merkle_proof proof( tree, i );
+            BOOST_CHECK( proof.calculate_merkle_root( tree.front()[i] ) == block.calculate_merkle_root() );
+            if( count > 1 )
+               BOOST_CHECK( proof.calculate_merkle_root( tree.front()[(i + 1) % count] )
+                            != block.calculate_merkle_root() );
+         }
+         GRAPHENE_REQUIRE_THROW( (void)graphene::protocol::merkle_proof( tree, count ), fc::exception );
+      }
+
+      ACTOR( alice );
+      fund( alice );
+      for( int64_t amount = 1; amount <= 5; ++amount )
+         transfer( alice_id, account_id_type(), asset( amount ) );
+      generate_block();
+      const uint32_t head_num = db.head_block_num();
+      const auto block = db.fetch_block_by_number( head_num );
+      BOOST_REQUIRE_EQUAL( block->transactions.size(), 5u );
+
+      graphene::app::block_api api( db );
+      const auto headers = api.get_block_headers( head_num - 1, head_num + 1 );
+      BOOST_REQUIRE_EQUAL( headers.size(), 3u );
+      BOOST_REQUIRE( headers[0].valid() && headers[1].valid() );
+      BOOST_CHECK( headers[1]->id() == block->id() );
+      BOOST_CHECK( headers[1]->previous == headers[0]->id() );
+      BOOST_CHECK( !headers[2].valid() );
+      GRAPHENE_REQUIRE_THROW( api.get_block_headers( 1, graphene::app::block_api::max_block_headers + 1 ),
+                              fc::exception );
+
+      for( uint32_t i = 0; i < block->transactions.size(); ++i )
+      {
+         const auto proof = api.get_transaction_inclusion_proof( head_num, i );
+         BOOST_REQUIRE( proof.valid() );
+         BOOST_CHECK( proof->header.id() == block->id() );
+         BOOST_CHECK( proof->leaf == block->transactions[i].merkle_digest() );
+         BOOST_CHECK( proof->proof.calculate_merkle_root( block->transactions[i].merkle_digest() )
+                      == proof->header.transaction_merkle_root );
+      }
+      BOOST_CHECK( !api.get_transaction_inclusion_proof( head_num + 1, 0 ).valid() );
+      GRAPHENE_REQUIRE_THROW( api.get_transaction_inclusion_proof( head_num, 5 ), fc::exception );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+/// Each test case gets its own copy of the prepared state, changes of one test case are not seen by the other one
+static void check_prepared_state_fork( prepared_state_fixture& f )
+{
+   BOOST_CHECK_EQUAL( f.get_balance( f.alice_id, asset_id_type() ), f.prepared_core_balance.value );
+   BOOST_CHECK_EQUAL( f.get_balance( f.bob_id, asset_id_type() ), f.prepared_core_balance.value );
+   BOOST_CHECK_EQUAL( f.get_balance( f.alice_id, f.prepared_asset_id ), f.prepared_asset_balance.value );
+   BOOST_CHECK_EQUAL( f.get_balance( f.bob_id, f.prepared_asset_id ), f.prepared_asset_balance.value );
+
+   f.transfer( f.alice_id, f.bob_id, asset( 1000 ) );
+   f.transfer( f.bob_id, f.alice_id, asset( 1000, f.prepared_asset_id ) );
+   f.generate_block();
+   BOOST_CHECK_EQUAL( f.get_balance( f.bob_id, asset_id_type() ), f.prepared_core_balance.value + 1000 );
+}
+
+BOOST_FIXTURE_TEST_CASE( prepared_state_fork1, prepared_state_fixture )
+{
+   try {
+      check_prepared_state_fork( *this );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( prepared_state_fork2, prepared_state_fixture )
+{
+   try {
+      check_prepared_state_fork( *this );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -128,6 +128,55 @@ BOOST_AUTO_TEST_CASE( confidential_test )
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( confidential_proof_cache_test )
+{ try {
+   ACTORS( (dan) )
+   const asset_object& core = asset_id_type()(db);
+   transfer(account_id_type()(db), dan, core.amount(1000000));
+   generate_block();
+   db.set_confidential_proof_cache_size( 10 );
+
+   auto owner_key = fc::ecc::private_key::generate();
+   auto blind_factor = fc::sha256::hash("InB1");
+   blind_output out;
+   out.owner = authority( 1, public_key_type(owner_key.get_public_key()), 1 );
+   out.commitment  = fc::ecc::blind(blind_factor,1000);
+   out.range_proof = fc::ecc::range_proof_sign( 0, out.commitment, blind_factor, fc::sha256::hash("nonce"), 0, 0, 1000 );
 
+   transfer_to_blind_operation to_blind;
+   to_blind.amount = core.amount(1000);
+   to_blind.from   = dan_id;
+   to_blind.blinding_factor = fc::ecc::blind_sum( {blind_factor}, 1 );
+   to_blind.outputs = {out};
+
+   BOOST_TEST_MESSAGE( "A transaction whose commitments do not add up is not remembered" );
+   signed_transaction bad_tx;
+   transfer_to_blind_operation bad_op = to_blind;
+   bad_op.amount = core.amount(999);
+   bad_tx.operations.push_back( bad_op );
+   set_expiration( db, bad_tx );
+   precomputable_transaction bad_ptx( bad_tx );
+   BOOST_CHECK_THROW( db.precompute_parallel( bad_ptx ).wait(), fc::exception );
+   BOOST_CHECK_EQUAL( db.get_confidential_proof_cache_stats().size, 0u );
+
+   BOOST_TEST_MESSAGE( "A transaction seen before is not verified again when it arrives in a block" );
+   signed_transaction tx;
+   tx.operations.push_back( to_blind );
+   set_expiration( db, tx );
+   sign( tx, dan_private_key );
+   precomputable_transaction ptx( tx );
+   db.precompute_parallel( ptx ).wait();
+   BOOST_CHECK_EQUAL( db.get_confidential_proof_cache_stats().size, 1u );
+   PUSH_TX( db, ptx );
+
+   signed_block b = generate_block();
+   BOOST_REQUIRE_EQUAL( b.transactions.size(), 1u );
+   const signed_block received = fc::raw::unpack<signed_block>( fc::raw::pack( b ) );
+   const auto stats = db.get_confidential_proof_cache_stats();
+   db.precompute_parallel( received ).wait();
+   BOOST_CHECK_EQUAL( db.get_confidential_proof_cache_stats().misses, stats.misses );
+   BOOST_CHECK_GT( db.get_confidential_proof_cache_stats().hits, stats.hits );
+
+} FC_LOG_AND_RETHROW() }
 
 BOOST_AUTO_TEST_SUITE_END()
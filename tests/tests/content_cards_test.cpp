@@ -26,7 +26,10 @@
 #include <boost/test/unit_test.hpp>
 
 #include <graphene/app/database_api.hpp>
+#include <graphene/chain/vote_master_summary_object.hpp>
 #include <graphene/content_cards/content_cards.hpp>
+#include <graphene/content_cards/content_store.hpp>
+#include <graphene/utilities/tempdir.hpp>
 
 #include "../common/database_fixture.hpp"
 
@@ -125,4 +128,385 @@ catch (fc::exception &e) {
    throw;
 } }
 
+BOOST_AUTO_TEST_CASE(content_cards_feed_test)
+{
+try {
+   ACTORS((alice)(bob));
+
+   auto plugin = app.register_plugin<graphene::content_cards::content_cards_plugin>(true);
+   plugin->plugin_startup();
+   plugin->plugin_load_state();
+
+   auto create_card = [&]( account_id_type subject, const std::string& card_hash, const std::string& type ) {
+      content_card_v2_create_operation op;
+      op.subject_account = subject;
+      op.hash = card_hash;
+      op.url = content_url;
+      op.type = type;
+      op.description = content_description;
+      op.content_key = content_key;
+      op.storage_data = content_storage_data;
+      op.fee = db.get_global_properties().parameters.get_current_fees().calculate_fee(op);
+
+      signed_transaction trx;
+      set_expiration(db, trx);
+      trx.operations.push_back(op);
+      processed_transaction ptx = PUSH_TX(db, trx, ~0);
+      return content_card_v2_id_type( ptx.operation_results[0].get<object_id_type>() );
+   };
+   const auto png1 = create_card( alice_id, "hash1", content_type );
+   const auto text = create_card( alice_id, "hash2", "text/plain" );
+   const auto png2 = create_card( bob_id, "hash3", content_type );
+
+   graphene::app::database_api db_api(db, &(app.get_options()));
+   const fc::time_point_sec all_from;
+   const fc::time_point_sec all_to = fc::time_point_sec::maximum();
+
+   // newest first, cards of the same second are ordered by id
+   auto pngs = db_api.get_content_cards_v2_by_type( content_type, all_from, all_to, 10 );
+   BOOST_REQUIRE_EQUAL( pngs.size(), 2u );
+   BOOST_CHECK( pngs[0].id == png2 );
+   BOOST_CHECK( pngs[1].id == png1 );
+   BOOST_CHECK_EQUAL( db_api.get_content_cards_v2_by_type( content_type, all_from, all_to, 1 ).size(), 1u );
+   BOOST_CHECK_EQUAL( db_api.get_content_cards_v2_by_type( "video/mp4", all_from, all_to, 10 ).size(), 0u );
+
+   auto alice_cards = db_api.get_content_cards_v2_by_time( alice_id, all_from, all_to, 10 );
+   BOOST_REQUIRE_EQUAL( alice_cards.size(), 2u );
+   BOOST_CHECK( alice_cards[0].id == text );
+   BOOST_CHECK( alice_cards[1].id == png1 );
+
+   // a window in the future is empty
+   const fc::time_point_sec later = fc::time_point::now() + fc::hours(1);
+   BOOST_CHECK_EQUAL( db_api.get_content_cards_v2_by_time( alice_id, later, all_to, 10 ).size(), 0u );
+
+   const uint32_t configured_limit = app.get_options().api_limit_get_content_cards;
+   GRAPHENE_REQUIRE_THROW( db_api.get_content_cards_v2_by_type( content_type, all_from, all_to, configured_limit + 1 ),
+                           fc::exception );
+}
+catch (fc::exception &e) {
+   edump((e.to_detail_string()));
+   throw;
+} }
+
+BOOST_AUTO_TEST_CASE(content_cards_search_test)
+{
+try {
+   ACTORS((alice));
+
+   auto plugin = app.register_plugin<graphene::content_cards::content_cards_plugin>(true);
+   plugin->plugin_startup();
+   plugin->plugin_load_state();
+
+   auto create_card = [&]( const std::string& card_hash, const std::string& description ) {
+      content_card_v2_create_operation op;
+      op.subject_account = alice_id;
+      op.hash = card_hash;
+      op.url = content_url;
+      op.type = content_type;
+      op.description = description;
+      op.content_key = content_key;
+      op.storage_data = content_storage_data;
+      op.fee = db.get_global_properties().parameters.get_current_fees().calculate_fee(op);
+
+      signed_transaction trx;
+      set_expiration(db, trx);
+      trx.operations.push_back(op);
+      processed_transaction ptx = PUSH_TX(db, trx, ~0);
+      return content_card_v2_id_type( ptx.operation_results[0].get<object_id_type>() );
+   };
+   const auto cat = create_card( "hash1", "A black Cat, sleeping." );
+   const auto dog = create_card( "hash2", "a dog" );
+   const auto cats = create_card( "hash3", "black cats and a dog" );
+
+   graphene::app::database_api db_api(db, &(app.get_options()));
+   auto ids = db_api.search_content_cards( "cat", 10 );
+   BOOST_REQUIRE_EQUAL( ids.size(), 1u );
+   BOOST_CHECK( ids[0] == cat );
+
+   // more matching words rank higher, then newer cards
+   ids = db_api.search_content_cards( "BLACK dog", 10 );
+   BOOST_REQUIRE_EQUAL( ids.size(), 3u );
+   BOOST_CHECK( ids[0] == cats );
+   BOOST_CHECK( ids[1] == dog );
+   BOOST_CHECK( ids[2] == cat );
+   BOOST_CHECK_EQUAL( db_api.search_content_cards( "BLACK dog", 1 ).size(), 1u );
+
+   ids = db_api.search_content_cards( "ca*", 10 );
+   BOOST_REQUIRE_EQUAL( ids.size(), 2u );
+   BOOST_CHECK( ids[0] == cats );
+   BOOST_CHECK( ids[1] == cat );
+   BOOST_CHECK( db_api.search_content_cards( "bird", 10 ).empty() );
+
+   // cards of popped blocks are no longer found
+   generate_block();
+   create_card( "hash4", "a bird" );
+   BOOST_CHECK_EQUAL( db_api.search_content_cards( "bird", 10 ).size(), 1u );
+   db.clear_pending();
+   BOOST_CHECK( db_api.search_content_cards( "bird", 10 ).empty() );
+
+   const uint32_t configured_limit = app.get_options().api_limit_get_content_cards;
+   GRAPHENE_REQUIRE_THROW( db_api.search_content_cards( "cat", configured_limit + 1 ), fc::exception );
+}
+catch (fc::exception &e) {
+   edump((e.to_detail_string()));
+   throw;
+} }
+
+BOOST_AUTO_TEST_CASE(content_vote_counts_test)
+{
+try {
+   ACTORS((alice)(bob)(master));
+
+   auto plugin = app.register_plugin<graphene::content_cards::content_cards_plugin>(true);
+   plugin->plugin_startup();
+   plugin->plugin_load_state();
+
+   auto vote = [&]( account_id_type voter, const std::string& content_id ) {
+      content_vote_create_operation op;
+      op.subject_account = voter;
+      op.content_id = content_id;
+      op.master_account = master_id;
+      op.master_content_id = content_id;
+      op.fee = db.get_global_properties().parameters.get_current_fees().calculate_fee(op);
+
+      signed_transaction trx;
+      set_expiration(db, trx);
+      trx.operations.push_back(op);
+      processed_transaction ptx = PUSH_TX(db, trx, ~0);
+      return content_vote_id_type( ptx.operation_results[0].get<object_id_type>() );
+   };
+   vote( alice_id, "1.20.1" );
+   const auto bob_vote = vote( bob_id, "1.20.1" );
+   vote( alice_id, "1.20.2" );
+
+   graphene::app::database_api db_api(db, &(app.get_options()));
+   auto counts = db_api.get_content_vote_counts( { "1.20.1", "1.20.2", "1.20.3" } );
+   BOOST_REQUIRE_EQUAL( counts.size(), 3u );
+   BOOST_CHECK_EQUAL( counts[0].total_votes, 2u );
+   BOOST_CHECK_EQUAL( counts[1].total_votes, 1u );
+   BOOST_CHECK_EQUAL( counts[2].total_votes, 0u );
+   BOOST_CHECK_EQUAL( counts[0].last_update_block, db.head_block_num() + 1 );
+
+   content_vote_remove_operation rop;
+   rop.subject_account = bob_id;
+   rop.vote_id = bob_vote;
+   rop.fee = db.get_global_properties().parameters.get_current_fees().calculate_fee(rop);
+   signed_transaction trx;
+   set_expiration(db, trx);
+   trx.operations.push_back(rop);
+   PUSH_TX(db, trx, ~0);
+   BOOST_CHECK_EQUAL( db_api.get_content_vote_counts( { "1.20.1" } )[0].total_votes, 1u );
+
+   // votes of discarded pending transactions are no longer counted
+   generate_block();
+   vote( bob_id, "1.20.2" );
+   BOOST_CHECK_EQUAL( db_api.get_content_vote_counts( { "1.20.2" } )[0].total_votes, 2u );
+   db.clear_pending();
+   BOOST_CHECK_EQUAL( db_api.get_content_vote_counts( { "1.20.2" } )[0].total_votes, 1u );
+}
+catch (fc::exception &e) {
+   edump((e.to_detail_string()));
+   throw;
+} }
+
+BOOST_AUTO_TEST_CASE(vote_master_summary_batch_test)
+{
+try {
+   ACTORS((alice)(bob)(master1)(master2));
+
+   auto vote_op = [&]( account_id_type voter, const std::string& content_id, account_id_type master ) {
+      content_vote_create_operation op;
+      op.subject_account = voter;
+      op.content_id = content_id;
+      op.master_account = master;
+      op.master_content_id = content_id;
+      op.fee = db.get_global_properties().parameters.get_current_fees().calculate_fee(op);
+      return op;
+   };
+   auto master_votes = [&]( account_id_type master ) {
+      const auto& idx = db.get_index_type<vote_master_summary_index>().indices().get<by_master_account>();
+      auto itr = idx.find( master );
+      return itr == idx.end() ? 0u : itr->total_votes;
+   };
+
+   signed_transaction trx;
+   set_expiration(db, trx);
+   trx.operations.push_back( vote_op( alice_id, "1.20.1", master2_id ) );
+   trx.operations.push_back( vote_op( alice_id, "1.20.2", master1_id ) );
+   trx.operations.push_back( vote_op( bob_id, "1.20.1", master2_id ) );
+   trx.operations.push_back( vote_op( bob_id, "1.20.2", master2_id ) );
+   PUSH_TX(db, trx, ~0);
+
+   BOOST_CHECK_EQUAL( master_votes( master1_id ), 1u );
+   BOOST_CHECK_EQUAL( master_votes( master2_id ), 3u );
+   // summaries are created in order of the first vote
+   const auto& idx = db.get_index_type<vote_master_summary_index>().indices().get<by_master_account>();
+   BOOST_CHECK( idx.find( master2_id )->id < idx.find( master1_id )->id );
+
+   // a failing vote discards the votes counted before it
+   trx.clear();
+   set_expiration(db, trx);
+   trx.operations.push_back( vote_op( alice_id, "1.20.3", master1_id ) );
+   trx.operations.push_back( vote_op( alice_id, "1.20.1", master1_id ) );
+   GRAPHENE_REQUIRE_THROW( PUSH_TX(db, trx, ~0), fc::exception );
+   BOOST_CHECK_EQUAL( master_votes( master1_id ), 1u );
+}
+catch (fc::exception &e) {
+   edump((e.to_detail_string()));
+   throw;
+} }
+
+BOOST_AUTO_TEST_CASE(content_card_history_test)
+{
+try {
+   ACTORS((alice));
+
+   fc::temp_directory store_dir( graphene::utilities::temp_directory_path() );
+   auto plugin = app.register_plugin<graphene::content_cards::content_cards_plugin>(true);
+   boost::program_options::variables_map options;
+   fc::set_option( options, "content-cards-store-dir", store_dir.path().generic_string() );
+   fc::set_option( options, "content-cards-history", true );
+   plugin->plugin_initialize( options );
+   plugin->plugin_startup();
+   plugin->plugin_load_state();
+
+   auto push = [&]( const operation& op ) {
+      signed_transaction trx;
+      set_expiration(db, trx);
+      trx.operations.push_back(op);
+      return PUSH_TX(db, trx, ~0);
+   };
+
+   content_card_v2_create_operation create_op;
+   create_op.subject_account = alice_id;
+   create_op.hash = hash;
+   create_op.url = content_url;
+   create_op.type = content_type;
+   create_op.description = content_description;
+   create_op.content_key = content_key;
+   create_op.storage_data = content_storage_data;
+   create_op.fee = db.get_global_properties().parameters.get_current_fees().calculate_fee(create_op);
+   const content_card_v2_id_type card_id = push( create_op ).operation_results[0].get<object_id_type>();
+
+   content_card_v2_update_operation update_op;
+   update_op.subject_account = alice_id;
+   update_op.hash = hash;
+   update_op.url = content_url;
+   update_op.type = content_type;
+   update_op.description = "first update";
+   update_op.content_key = content_key;
+   update_op.storage_data = content_storage_data;
+   update_op.fee = db.get_global_properties().parameters.get_current_fees().calculate_fee(update_op);
+   generate_block();
+   push( update_op );
+   generate_block();
+
+   // two updates of the card in one block
+   update_op.description = "second update";
+   push( update_op );
+   update_op.url = "http://some.image.url/other.jpg";
+   push( update_op );
+   generate_block();
+
+   graphene::app::database_api db_api(db, &(app.get_options()));
+   auto versions = db_api.get_content_card_history( card_id, 10 );
+   BOOST_REQUIRE_EQUAL( versions.size(), 4u );
+   BOOST_CHECK_EQUAL( versions[0].version, 4u );
+   BOOST_CHECK_EQUAL( versions[0].url, "http://some.image.url/other.jpg" );
+   BOOST_CHECK_EQUAL( versions[0].description, "second update" );
+   BOOST_CHECK_EQUAL( versions[1].version, 3u );
+   BOOST_CHECK_EQUAL( versions[1].url, content_url );
+   BOOST_CHECK_EQUAL( versions[1].description, "second update" );
+   BOOST_CHECK_EQUAL( versions[2].version, 2u );
+   BOOST_CHECK_EQUAL( versions[2].description, "first update" );
+   BOOST_CHECK_EQUAL( versions[3].version, 1u );
+   BOOST_CHECK_EQUAL( versions[3].description, content_description );
+   BOOST_CHECK_EQUAL( versions[3].type, content_type );
+   BOOST_CHECK_EQUAL( versions[3].storage_data, content_storage_data );
+   BOOST_CHECK_EQUAL( versions[3].replaced_in_block, versions[2].replaced_in_block - 1 );
+   BOOST_CHECK_EQUAL( versions[2].replaced_in_block, versions[1].replaced_in_block );
+
+   // only the changed fields are stored
+   const auto& deltas = db.get_index_type<graphene::content_cards::content_card_version_index>().indices();
+   BOOST_REQUIRE_EQUAL( deltas.size(), 3u );
+   for( const auto& delta : deltas )
+   {
+      BOOST_CHECK( !delta.type.valid() );
+      BOOST_CHECK( !delta.storage_data.valid() );
+   }
+
+   versions = db_api.get_content_card_history( card_id, 2 );
+   BOOST_REQUIRE_EQUAL( versions.size(), 2u );
+   BOOST_CHECK_EQUAL( versions[1].version, 3u );
+
+   // versions of popped blocks are dropped
+   db.pop_block();
+   BOOST_CHECK_EQUAL( db_api.get_content_card_history( card_id, 10 ).size(), 2u );
+   generate_block();
+
+   // versions are dropped with the card
+   content_card_v2_remove_operation remove_op;
+   remove_op.subject_account = alice_id;
+   remove_op.content_id = card_id;
+   remove_op.fee = db.get_global_properties().parameters.get_current_fees().calculate_fee(remove_op);
+   push( remove_op );
+   generate_block();
+   BOOST_CHECK( db_api.get_content_card_history( card_id, 10 ).empty() );
+   BOOST_CHECK( deltas.empty() );
+
+   const uint32_t configured_limit = app.get_options().api_limit_get_content_cards;
+   GRAPHENE_REQUIRE_THROW( db_api.get_content_card_history( card_id, configured_limit + 1 ), fc::exception );
+}
+catch (fc::exception &e) {
+   edump((e.to_detail_string()));
+   throw;
+} }
+
+BOOST_AUTO_TEST_CASE(content_store_test)
+{
+try {
+   using graphene::content_cards::content_store;
+
+   fc::temp_directory store_dir( graphene::utilities::temp_directory_path() );
+   const std::vector<char> small( content_buffer.begin(), content_buffer.end() );
+   const std::string small_hash = fc::sha256::hash( content_buffer ).str();
+   const std::vector<char> large( 100, 'x' );
+   const std::string large_hash = fc::sha256::hash( large.data(), large.size() ).str();
+
+   // the memory tier fits the small blob only
+   content_store store( store_dir.path(), 50 );
+   BOOST_CHECK( content_store::is_valid_hash( small_hash ) );
+   BOOST_CHECK( !content_store::is_valid_hash( "../" + small_hash.substr( 3 ) ) );
+   BOOST_CHECK( !store.contains( small_hash ) );
+   BOOST_CHECK( !store.get_size( small_hash ).valid() );
+   GRAPHENE_REQUIRE_THROW( store.read( small_hash, 0, 10 ), fc::exception );
+
+   // content must match its hash
+   GRAPHENE_REQUIRE_THROW( store.store( small_hash, large ), fc::exception );
+   BOOST_CHECK( !store.contains( small_hash ) );
+
+   store.store( small_hash, small );
+   store.store( large_hash, large );
+   BOOST_CHECK( store.contains( small_hash ) );
+   BOOST_CHECK_EQUAL( *store.get_size( small_hash ), small.size() );
+   BOOST_CHECK_EQUAL( *store.get_size( large_hash ), large.size() );
+
+   BOOST_CHECK( store.read( small_hash, 0, 1000 ) == small );
+   BOOST_CHECK_EQUAL( store.memory_used(), small.size() );
+   BOOST_CHECK( store.read( small_hash, 5, 3 ) == std::vector<char>( small.begin() + 5, small.begin() + 8 ) );
+   BOOST_CHECK( store.read( small_hash, small.size(), 3 ).empty() );
+
+   BOOST_CHECK( store.read( large_hash, 90, 20 ) == std::vector<char>( 10, 'x' ) );
+   BOOST_CHECK_EQUAL( store.memory_used(), small.size() );
+
+   // blobs survive a restart
+   content_store reopened( store_dir.path(), 1000 );
+   BOOST_CHECK( reopened.read( large_hash, 0, 1000 ) == large );
+   BOOST_CHECK_EQUAL( reopened.memory_used(), large.size() );
+}
+catch (fc::exception &e) {
+   edump((e.to_detail_string()));
+   throw;
+} }
+
 BOOST_AUTO_TEST_SUITE_END()
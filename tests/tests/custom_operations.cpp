@@ -329,4 +329,73 @@ catch (fc::exception &e) {
    throw;
 } }
 
+BOOST_AUTO_TEST_CASE(custom_operations_account_storage_range_test)
+{
+try {
+   ACTORS((nathan)(alice));
+
+   app.enable_plugin("custom_operations");
+   custom_operations_api custom_operations_api(app);
+
+   generate_block();
+   enable_fees();
+   transfer(committee_account, nathan_id, asset(10000 * GRAPHENE_BLOCKCHAIN_PRECISION));
+   transfer(committee_account, alice_id, asset(10000 * GRAPHENE_BLOCKCHAIN_PRECISION));
+
+   // keys of one operation are merged with the stored ones in a single pass
+   string catalog = "settings";
+   flat_map<string, optional<string>> pairs;
+   pairs["color.background"] = fc::json::to_string("black");
+   pairs["color.text"] = fc::json::to_string("white");
+   pairs["font"] = fc::json::to_string("serif");
+   map_operation(pairs, false, catalog, nathan_id, nathan_private_key, db);
+   generate_block();
+
+   pairs.clear();
+   pairs["color.border"] = fc::json::to_string("red");
+   pairs["color.text"] = fc::json::to_string("grey");
+   pairs["language"] = fc::json::to_string("en");
+   map_operation(pairs, false, catalog, nathan_id, nathan_private_key, db);
+   string other_catalog = "settings2";
+   map_operation(pairs, false, other_catalog, nathan_id, nathan_private_key, db);
+   map_operation(pairs, false, catalog, alice_id, alice_private_key, db);
+   generate_block();
+
+   auto colors = custom_operations_api.get_storage_range("nathan", catalog, "color.", "", 100);
+   BOOST_REQUIRE_EQUAL(colors.size(), 3u);
+   BOOST_CHECK_EQUAL(colors[0].key, "color.background");
+   BOOST_CHECK_EQUAL(colors[1].key, "color.border");
+   BOOST_CHECK_EQUAL(colors[2].key, "color.text");
+   BOOST_CHECK_EQUAL(colors[2].value->as_string(), "grey");
+   BOOST_CHECK_EQUAL(custom_operations_api.get_storage_range("nathan", catalog, "", "", 100).size(), 5u);
+
+   // paging
+   auto page = custom_operations_api.get_storage_range("nathan", catalog, "color.", "", 2);
+   BOOST_REQUIRE_EQUAL(page.size(), 2u);
+   page = custom_operations_api.get_storage_range("nathan", catalog, "color.", page[1].key + '\0', 2);
+   BOOST_REQUIRE_EQUAL(page.size(), 1u);
+   BOOST_CHECK_EQUAL(page[0].key, "color.text");
+
+   // removal in one pass as well
+   pairs.clear();
+   pairs["color.background"];
+   pairs["color.text"];
+   pairs["missing"];
+   map_operation(pairs, true, catalog, nathan_id, nathan_private_key, db);
+   generate_block();
+   colors = custom_operations_api.get_storage_range("nathan", catalog, "color.", "", 100);
+   BOOST_REQUIRE_EQUAL(colors.size(), 1u);
+   BOOST_CHECK_EQUAL(colors[0].key, "color.border");
+   BOOST_CHECK_EQUAL(custom_operations_api.get_storage_range("nathan", other_catalog, "", "", 100).size(), 3u);
+   BOOST_CHECK_EQUAL(custom_operations_api.get_storage_range("alice", catalog, "", "", 100).size(), 3u);
+
+   const uint32_t configured_limit = app.get_options().api_limit_get_storage_range;
+   GRAPHENE_REQUIRE_THROW(custom_operations_api.get_storage_range("nathan", catalog, "", "", configured_limit + 1),
+                          fc::exception);
+}
+catch (fc::exception &e) {
+   edump((e.to_detail_string()));
+   throw;
+} }
+
 BOOST_AUTO_TEST_SUITE_END()
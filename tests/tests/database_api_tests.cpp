@@ -789,6 +789,115 @@ BOOST_AUTO_TEST_CASE( subscription_key_collision_test )
    BOOST_CHECK_EQUAL( objects_changed, 0 ); // UIATEST did not change in this block, so no notification
 }
 
+BOOST_AUTO_TEST_CASE( subscription_dispatch_test )
+{ try {
+   ACTORS( (alice)(bob) );
+   fund( alice );
+   fund( bob );
+   generate_block();
+
+   uint32_t alice_changed = 0;
+   uint32_t bob_changed = 0;
+   graphene::app::database_api alice_api( db );
+   alice_api.set_subscribe_callback( [&]( const variant& ) { ++alice_changed; }, false );
+   alice_api.get_objects( { alice_id } );
+   graphene::app::database_api bob_api( db );
+   bob_api.set_subscribe_callback( [&]( const variant& ) { ++bob_changed; }, false );
+   bob_api.get_objects( { bob_id } );
+   {
+      // a session which goes away before the objects change
+      graphene::app::database_api gone_api( db );
+      gone_api.set_subscribe_callback( [&]( const variant& ) { BOOST_FAIL( "notified a destroyed session" ); },
+                                       false );
+      gone_api.get_objects( { alice_id, bob_id } );
+   }
+
+   upgrade_to_lifetime_member( alice );
+   generate_block();
+   fc::usleep(fc::milliseconds(200)); // sleep a while to execute callback in another thread
+
+   BOOST_CHECK_GT( alice_changed, 0u );
+   BOOST_CHECK_EQUAL( bob_changed, 0u );
+
+   alice_changed = 0;
+   alice_api.cancel_all_subscriptions();
+   bob_api.cancel_all_subscriptions();
+   upgrade_to_lifetime_member( bob );
+   generate_block();
+   fc::usleep(fc::milliseconds(200));
+
+   BOOST_CHECK_EQUAL( alice_changed, 0u );
+   BOOST_CHECK_EQUAL( bob_changed, 0u );
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( content_event_subscription_test )
+{ try {
+   ACTORS( (alice)(bob) );
+   fund( alice );
+   fund( bob );
+   generate_block();
+
+   auto create_permission = [&]( const account_object& subject, const fc::ecc::private_key& key,
+                                 const account_object& op_account, const string& type ) {
+      permission_create_operation op;
+      op.subject_account = subject.get_id();
+      op.operator_account = op_account.get_id();
+      op.permission_type = type;
+      op.object_id = object_id_type(1, 2, 3);
+      op.content_key = "content";
+      signed_transaction trx;
+      set_expiration( db, trx );
+      trx.operations.push_back( op );
+      sign( trx, key );
+      PUSH_TX( db, trx );
+   };
+
+   uint32_t by_subject = 0;
+   uint32_t by_type = 0;
+   uint32_t by_operator = 0;
+   uint32_t all = 0;
+   auto count_events = []( uint32_t& counter ) {
+      return [&counter]( const variant& v ) { counter += v.get_array().size(); };
+   };
+   graphene::app::database_api subject_api( db );
+   subject_api.subscribe_to_content_events( count_events( by_subject ), { {}, { alice_id }, {} } );
+   graphene::app::database_api type_api( db );
+   type_api.subscribe_to_content_events( count_events( by_type ), { { "read" }, {}, {} } );
+   graphene::app::database_api operator_api( db );
+   operator_api.subscribe_to_content_events( count_events( by_operator ), { {}, {}, { alice_id } } );
+   graphene::app::database_api all_api( db );
+   all_api.subscribe_to_content_events( count_events( all ), content_event_filter() );
+
+   create_permission( bob, bob_private_key, alice, "read" );
+   transfer( account_id_type(), alice_id, asset(1) );
+   generate_block();
+   fc::usleep(fc::milliseconds(200)); // sleep a while to execute callback in another thread
+
+   BOOST_CHECK_EQUAL( by_subject, 0u );
+   BOOST_CHECK_EQUAL( by_type, 1u );
+   BOOST_CHECK_EQUAL( by_operator, 1u );
+   BOOST_CHECK_EQUAL( all, 1u );
+
+   type_api.unsubscribe_from_content_events();
+   operator_api.cancel_all_subscriptions();
+   create_permission( alice, alice_private_key, bob, "read" );
+   generate_block();
+   fc::usleep(fc::milliseconds(200));
+
+   BOOST_CHECK_EQUAL( by_subject, 1u );
+   BOOST_CHECK_EQUAL( by_type, 1u );
+   BOOST_CHECK_EQUAL( by_operator, 1u );
+   BOOST_CHECK_EQUAL( all, 2u );
+
+   content_event_filter too_large;
+   for( uint32_t i = 0; i <= 1000; ++i )
+      too_large.types.insert( std::to_string( i ) );
+   GRAPHENE_CHECK_THROW( subject_api.subscribe_to_content_events( count_events( by_subject ), too_large ),
+                         fc::exception );
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( subscription_notification_test )
 {
    try {
@@ -1190,6 +1299,210 @@ BOOST_AUTO_TEST_CASE( lookup_vote_ids )
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( get_account_ids_from_strings )
+{ try {
+   graphene::app::database_api db_api( db, &( app.get_options() ));
+   ACTORS( (alice) );
+   create_user_issued_asset( "UIATEST", alice, 0 );
+   generate_block();
+
+   vector<string> names_or_ids = { "alice", string( alice_id ), "1.2.0", "bob", "1.2.999999", "1.3.0", "" };
+   auto ids = db_api.get_account_ids_from_strings( names_or_ids );
+   BOOST_REQUIRE_EQUAL( ids.size(), names_or_ids.size() );
+   BOOST_REQUIRE( ids[0].valid() );
+   BOOST_CHECK( *ids[0] == alice_id );
+   BOOST_REQUIRE( ids[1].valid() );
+   BOOST_CHECK( *ids[1] == alice_id );
+   BOOST_REQUIRE( ids[2].valid() );
+   BOOST_CHECK( *ids[2] == GRAPHENE_COMMITTEE_ACCOUNT );
+   BOOST_CHECK( !ids[3].valid() );
+   BOOST_CHECK( !ids[4].valid() );
+   BOOST_CHECK( !ids[6].valid() );
+
+   BOOST_CHECK( db_api.get_account_id_from_string( "alice" ) == alice_id );
+   BOOST_CHECK( db_api.get_asset_id_from_string( "UIATEST" ) == db_api.get_assets( { "UIATEST" } )[0]->id );
+
+   // the accounts created in a block are dropped from the lookup when the block is popped
+   ACTORS( (bob) );
+   generate_block();
+   BOOST_CHECK( db_api.get_account_ids_from_strings( { "bob" } )[0].valid() );
+   db.pop_block();
+   BOOST_CHECK( !db_api.get_account_ids_from_strings( { "bob" } )[0].valid() );
+   BOOST_CHECK( db_api.get_account_ids_from_strings( { "alice" } )[0].valid() );
+
+   vector<string> too_many( app.get_options().api_limit_lookup_accounts + 1, "alice" );
+   GRAPHENE_CHECK_THROW( db_api.get_account_ids_from_strings( too_many ), fc::exception );
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( search_accounts_and_asset_symbols )
+{ try {
+   graphene::app::database_api db_api( db, &( app.get_options() ));
+   ACTORS( (alice)(alicia)(bob) );
+   create_user_issued_asset( "ALPHA", alice, 0 );
+   create_user_issued_asset( "ALPS", alice, 0 );
+   create_user_issued_asset( "BETA", alice, 0 );
+   generate_block();
+
+   auto accounts = db_api.search_accounts( "ali", 10 );
+   BOOST_REQUIRE_EQUAL( accounts.size(), 2u );
+   BOOST_CHECK( accounts["alice"] == alice_id );
+   BOOST_CHECK( accounts["alicia"] == alicia_id );
+   BOOST_CHECK_EQUAL( db_api.search_accounts( "ALI", 1 ).size(), 1u );
+   BOOST_CHECK( db_api.search_accounts( "alx", 10 ).empty() );
+   BOOST_CHECK( db_api.search_accounts( "ali", 0 ).empty() );
+
+   auto symbols = db_api.search_asset_symbols( "alp", 10 );
+   BOOST_REQUIRE_EQUAL( symbols.size(), 2u );
+   BOOST_CHECK( symbols.count( "ALPHA" ) == 1 );
+   BOOST_CHECK( symbols.count( "ALPS" ) == 1 );
+   BOOST_CHECK( db_api.search_asset_symbols( "BETAX", 10 ).empty() );
+
+   GRAPHENE_CHECK_THROW( db_api.search_accounts( "a", app.get_options().api_limit_lookup_accounts + 1 ),
+                         fc::exception );
+   GRAPHENE_CHECK_THROW( db_api.search_asset_symbols( "A", app.get_options().api_limit_get_assets + 1 ),
+                         fc::exception );
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( get_required_fees_in_assets )
+{ try {
+   graphene::app::database_api db_api( db, &( app.get_options() ));
+   ACTORS( (alice)(bob) );
+   const asset_object& alpha = create_user_issued_asset( "ALPHA", alice, 0,
+                                                         price( asset( 3, asset_id_type(1) ), asset( 1 ) ) );
+   const asset_id_type alpha_id = alpha.id;
+   change_fees( { transfer_operation::fee_parameters_type() } );
+   generate_block();
+
+   transfer_operation op;
+   op.from = alice_id;
+   op.to = bob_id;
+   op.amount = asset( 100 );
+   const vector<operation> ops = { op };
+
+   auto fees = db_api.get_required_fees_in_assets( ops, { "RVP", "ALPHA" } );
+   BOOST_REQUIRE_EQUAL( fees.size(), 2u );
+   BOOST_REQUIRE_EQUAL( fees[0].size(), 1u );
+   BOOST_REQUIRE_EQUAL( fees[1].size(), 1u );
+   const asset core_fee = fees[0][0].as<asset>( 1 );
+   const asset alpha_fee = fees[1][0].as<asset>( 1 );
+   BOOST_CHECK( core_fee.amount > 0 );
+   BOOST_CHECK( core_fee == db.current_fee_schedule().calculate_fee( op ) );
+   BOOST_CHECK( alpha_fee.asset_id == alpha_id );
+   BOOST_CHECK_EQUAL( alpha_fee.amount.value, core_fee.amount.value * 3 );
+
+   // cached results are the same as computed ones
+   BOOST_CHECK( db_api.get_required_fees( ops, "ALPHA" )[0].as<asset>( 1 ) == alpha_fee );
+
+   // results are recomputed after the fees changed
+   change_fees( {}, GRAPHENE_100_PERCENT * 2 );
+   generate_block();
+   BOOST_CHECK_EQUAL( db_api.get_required_fees( ops, "RVP" )[0].as<asset>( 1 ).amount.value,
+                      core_fee.amount.value * 2 );
+
+   vector<string> too_many( app.get_options().api_limit_get_assets + 1, "RVP" );
+   GRAPHENE_CHECK_THROW( db_api.get_required_fees_in_assets( ops, too_many ), fc::exception );
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( get_changed_full_accounts )
+{ try {
+   graphene::app::database_api db_api( db, &( app.get_options() ));
+   ACTORS( (alice)(bob) );
+   generate_block();
+
+   auto results = db_api.get_changed_full_accounts( { { "alice", 0 }, { "bob", 0 }, { "carol", 0 } } );
+   BOOST_REQUIRE_EQUAL( results.size(), 2u );
+   BOOST_CHECK( results["alice"].account.account.id == alice_id );
+   const uint64_t alice_version = results["alice"].version;
+   const uint64_t bob_version = results["bob"].version;
+   BOOST_CHECK_GT( alice_version, 0u );
+
+   // nothing changed
+   results = db_api.get_changed_full_accounts( { { "alice", alice_version }, { "bob", bob_version } } );
+   BOOST_CHECK( results.empty() );
+
+   transfer( committee_account, alice_id, asset( 1000 ) );
+   generate_block();
+
+   results = db_api.get_changed_full_accounts( { { "alice", alice_version }, { "bob", bob_version } } );
+   BOOST_REQUIRE_EQUAL( results.size(), 1u );
+   BOOST_CHECK_GT( results["alice"].version, alice_version );
+   BOOST_REQUIRE_EQUAL( results["alice"].account.balances.size(), 1u );
+   BOOST_CHECK_EQUAL( results["alice"].account.balances[0].balance.value, 1000 );
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( get_order_book_cache )
+{ try {
+   graphene::app::database_api db_api( db, &( app.get_options() ));
+   ACTORS( (alice) );
+   const auto& uia = create_user_issued_asset( "UIATEST", alice, 0 );
+   issue_uia( alice, uia.amount( 1000 ) );
+   fund( alice, asset( 1000000 ) );
+   generate_block();
+
+   create_sell_order( alice_id, uia.amount( 100 ), asset( 100 ) );
+   auto book = db_api.get_order_book( "UIATEST", GRAPHENE_SYMBOL, 10 );
+   BOOST_CHECK_EQUAL( book.bids.size(), 1u );
+   BOOST_CHECK_EQUAL( db_api.get_order_book( "UIATEST", GRAPHENE_SYMBOL, 10 ).bids.size(), 1u );
+
+   // a pending transaction drops the cached result
+   create_sell_order( alice_id, asset( 100 ), uia.amount( 200 ) );
+   book = db_api.get_order_book( "UIATEST", GRAPHENE_SYMBOL, 10 );
+   BOOST_CHECK_EQUAL( book.bids.size(), 1u );
+   BOOST_CHECK_EQUAL( book.asks.size(), 1u );
+
+   generate_block();
+   book = db_api.get_order_book( "UIATEST", GRAPHENE_SYMBOL, 10 );
+   BOOST_CHECK_EQUAL( book.bids.size(), 1u );
+   BOOST_CHECK_EQUAL( book.asks.size(), 1u );
+
+   // another session gets the same result
+   graphene::app::database_api db_api2( db, &( app.get_options() ));
+   BOOST_CHECK_EQUAL( db_api2.get_order_book( "UIATEST", GRAPHENE_SYMBOL, 10 ).asks.size(), 1u );
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( get_order_book_levels )
+{ try {
+   graphene::app::database_api db_api( db, &( app.get_options() ));
+   ACTORS( (alice)(bob) );
+   const auto& uia = create_user_issued_asset( "UIATEST", alice, 0 );
+   issue_uia( alice, uia.amount( 1000 ) );
+   fund( alice, asset( 1000000 ) );
+   fund( bob, asset( 1000000 ) );
+   generate_block();
+
+   // orders at equal prices share a level, also if the prices are expressed by different amounts
+   create_sell_order( alice_id, uia.amount( 100 ), asset( 100 ) );
+   const limit_order_object* order = create_sell_order( alice_id, uia.amount( 200 ), asset( 200 ) );
+   create_sell_order( alice_id, uia.amount( 100 ), asset( 200 ) );
+   generate_block();
+
+   auto book = db_api.get_order_book( "UIATEST", GRAPHENE_SYMBOL, 10 );
+   BOOST_REQUIRE_EQUAL( book.bids.size(), 2u );
+   BOOST_CHECK_EQUAL( book.bids[0].base, "300" );
+   BOOST_CHECK_EQUAL( book.bids[1].base, "100" );
+   BOOST_CHECK( book.asks.empty() );
+   BOOST_CHECK_EQUAL( db_api.get_order_book( "UIATEST", GRAPHENE_SYMBOL, 1 ).bids.size(), 1u );
+
+   // a partial fill reduces the level
+   create_sell_order( bob_id, asset( 50 ), uia.amount( 50 ) );
+   generate_block();
+   book = db_api.get_order_book( "UIATEST", GRAPHENE_SYMBOL, 10 );
+   BOOST_REQUIRE_EQUAL( book.bids.size(), 2u );
+   BOOST_CHECK_EQUAL( book.bids[0].base, "250" );
+
+   cancel_limit_order( *order );
+   generate_block();
+   book = db_api.get_order_book( "UIATEST", GRAPHENE_SYMBOL, 10 );
+   BOOST_REQUIRE_EQUAL( book.bids.size(), 2u );
+   BOOST_CHECK_EQUAL( book.bids[0].base, "50" );
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( get_transaction_hex )
 { try {
    graphene::app::database_api db_api(db);
@@ -1285,6 +1598,43 @@ BOOST_AUTO_TEST_CASE( any_two_of_three )
    }
 }
 
+BOOST_AUTO_TEST_CASE( get_withdrawable_vesting_balances )
+{ try {
+   ACTORS( (alice)(bob) );
+   fund( alice, asset(1000000) );
+
+   vesting_balance_create_operation create_op;
+   create_op.creator = alice_id;
+   create_op.owner = alice_id;
+   create_op.amount = asset(10000);
+   create_op.policy = cdd_vesting_policy_initializer( 60*60*24 );
+   trx.operations.push_back( create_op );
+   create_op.policy = linear_vesting_policy_initializer{ db.head_block_time(), 0, 60*60*24 };
+   trx.operations.push_back( create_op );
+   for( auto& op : trx.operations )
+      db.current_fee_schedule().set_fee( op );
+   set_expiration( db, trx );
+   PUSH_TX( db, trx, ~0 );
+   trx.clear();
+
+   generate_blocks( db.head_block_time() + fc::hours(12) );
+
+   graphene::app::database_api db_api( db, &( app.get_options() ) );
+   const auto result = db_api.get_withdrawable_vesting_balances( { "alice", string( bob_id ) } );
+   BOOST_REQUIRE_EQUAL( result.size(), 2u );
+   BOOST_REQUIRE_EQUAL( result[0].size(), 2u );
+   BOOST_CHECK( result[1].empty() );
+   for( const auto& b : result[0] )
+   {
+      BOOST_CHECK( b.allowed_withdraw == b.get_allowed_withdraw( db.head_block_time() ) );
+      BOOST_CHECK_GT( b.allowed_withdraw.amount.value, 0 );
+      BOOST_CHECK_LT( b.allowed_withdraw.amount.value, 10000 );
+   }
+
+   vector<string> too_many( app.get_options().api_limit_get_full_accounts + 1, "alice" );
+   GRAPHENE_CHECK_THROW( db_api.get_withdrawable_vesting_balances( too_many ), fc::exception );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( verify_authority_multiple_accounts )
 {
    try {
@@ -27,9 +27,22 @@
 #include <graphene/chain/database.hpp>
 
 #include <graphene/chain/account_object.hpp>
+#include <graphene/chain/content_vote_object.hpp>
 #include <graphene/chain/proposal_object.hpp>
 
+#include <graphene/db/interned_string.hpp>
+#include <graphene/db/task_pool.hpp>
+
+#include <graphene/utilities/tempdir.hpp>
+
 #include <fc/crypto/digest.hpp>
+#include <fc/io/raw.hpp>
+
+#include <boost/multi_index/identity.hpp>
+
+#include <algorithm>
+#include <future>
+#include <mutex>
 
 #include "../common/database_fixture.hpp"
 
@@ -108,6 +121,466 @@ BOOST_AUTO_TEST_CASE( merge_test )
    }
 }
 
+BOOST_AUTO_TEST_CASE( merge_entries_test )
+{ try {
+   using graphene::db::undo_entry;
+   database db;
+   auto ses0 = db._undo_db.start_undo_session();
+   const account_balance_id_type a_id = db.create<account_balance_object>( []( account_balance_object& obj ){
+      obj.balance = 1;
+   }).id;
+   ses0.commit();
+
+   auto add = []( int64_t amount ) {
+      return [amount]( account_balance_object& obj ){ obj.balance += amount; };
+   };
+   {
+      auto outer = db._undo_db.start_undo_session();
+      db.modify( db.get( a_id ), add( 1 ) );
+      const account_balance_id_type b_id = db.create<account_balance_object>( []( account_balance_object& obj ){
+         obj.balance = 100;
+      }).id;
+      for( int i = 0; i < 3; ++i )
+      {
+         auto inner = db._undo_db.start_undo_session();
+         db.modify( db.get( a_id ), add( 1 ) );
+         db.modify( db.get( a_id ), add( 1 ) );
+         db.modify( db.get( b_id ), add( 1 ) );
+         inner.merge();
+      }
+      // the merged sessions did not record the objects again
+      BOOST_CHECK_EQUAL( 1u, db._undo_db.head().count( undo_entry::modified ) );
+      BOOST_CHECK_EQUAL( 1u, db._undo_db.head().count( undo_entry::created ) );
+      db.modify( db.get( a_id ), add( 1 ) );
+      BOOST_CHECK_EQUAL( 1u, db._undo_db.head().count( undo_entry::modified ) );
+
+      {
+         auto inner = db._undo_db.start_undo_session();
+         db.modify( db.get( a_id ), add( 1 ) );
+         inner.undo();
+      }
+      BOOST_CHECK_EQUAL( 9, db.get( a_id ).balance.value );
+
+      {
+         auto inner = db._undo_db.start_undo_session();
+         db.remove( db.get( b_id ) );
+         db.remove( db.get( a_id ) );
+         inner.merge();
+      }
+      BOOST_CHECK_EQUAL( 0u, db._undo_db.head().count( undo_entry::created ) );
+      BOOST_CHECK_EQUAL( 0u, db._undo_db.head().count( undo_entry::modified ) );
+      BOOST_CHECK_EQUAL( 1u, db._undo_db.head().count( undo_entry::removed ) );
+      outer.undo();
+      BOOST_CHECK( db.find( b_id ) == nullptr );
+   }
+   BOOST_CHECK_EQUAL( 1, db.get( a_id ).balance.value );
+
+   // the restored object is recorded again by later sessions
+   auto ses = db._undo_db.start_undo_session();
+   db.modify( db.get( a_id ), add( 1 ) );
+   BOOST_CHECK_EQUAL( 1u, db._undo_db.head().count( undo_entry::modified ) );
+   ses.undo();
+   BOOST_CHECK_EQUAL( 1, db.get( a_id ).balance.value );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( modify_batch_test )
+{ try {
+   database db;
+   vector<const account_balance_object*> objs;
+   for( int64_t i = 1; i <= 3; ++i )
+      objs.push_back( &db.create<account_balance_object>( [i]( account_balance_object& obj ){ obj.balance = i; } ) );
+
+   auto ses = db._undo_db.start_undo_session();
+   db.modify_batch( objs, []( account_balance_object& obj ){ obj.balance *= 10; } );
+   for( int64_t i = 1; i <= 3; ++i )
+      BOOST_CHECK_EQUAL( objs[i-1]->balance.value, i * 10 );
+
+   // every object was recorded for undo
+   ses.undo();
+   for( int64_t i = 1; i <= 3; ++i )
+      BOOST_CHECK_EQUAL( objs[i-1]->balance.value, i );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( object_view_test )
+{ try {
+   database db;
+   const auto& kept = db.create<account_balance_object>( []( account_balance_object& obj ){ obj.balance = 1; } );
+   const auto& changed = db.create<account_balance_object>( []( account_balance_object& obj ){ obj.balance = 2; } );
+   const auto& removed = db.create<account_balance_object>( []( account_balance_object& obj ){ obj.balance = 3; } );
+   const auto kept_id = kept.id;
+   const auto changed_id = changed.id;
+   const auto removed_id = removed.id;
+
+   auto view = db.create_view();
+
+   // changes are seen by the view whether they are recorded for undo or not
+   auto ses = db._undo_db.start_undo_session();
+   db.modify( changed, []( account_balance_object& obj ){ obj.balance = 20; } );
+   db.remove( removed );
+   const auto new_id = db.create<account_balance_object>( []( account_balance_object& obj ){
+      obj.balance = 4;
+   }).id;
+   ses.commit();
+   db.modify( changed, []( account_balance_object& obj ){ obj.balance = 200; } );
+
+   BOOST_CHECK_EQUAL( view->find<account_balance_object>( kept_id )->balance.value, 1 );
+   BOOST_CHECK_EQUAL( view->find<account_balance_object>( changed_id )->balance.value, 2 );
+   BOOST_CHECK_EQUAL( view->find<account_balance_object>( removed_id )->balance.value, 3 );
+   BOOST_CHECK( view->find<account_balance_object>( new_id ) == nullptr );
+   BOOST_CHECK_EQUAL( db.get<account_balance_object>( changed_id ).balance.value, 200 );
+
+   share_type total;
+   uint32_t count = 0;
+   view->inspect_all_objects( account_balance_object::space_id, account_balance_object::type_id,
+                              [&total,&count]( const object& o ) {
+      total += static_cast<const account_balance_object&>( o ).balance;
+      ++count;
+   });
+   BOOST_CHECK_EQUAL( count, 3u );
+   BOOST_CHECK_EQUAL( total.value, 6 );
+
+   // a released view no longer receives changes
+   view.reset();
+   db.modify( db.get<account_balance_object>( kept_id ), []( account_balance_object& obj ){ obj.balance = 10; } );
+   BOOST_CHECK_EQUAL( db.get<account_balance_object>( kept_id ).balance.value, 10 );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( compact_undo_test )
+{ try {
+   database db;
+   db._undo_db.set_compact( true );
+
+   auto ses0 = db._undo_db.start_undo_session();
+   const auto& bal = db.create<account_balance_object>( []( account_balance_object& obj ){
+      obj.balance = 10;
+   });
+   const account_balance_id_type bal_id = bal.id;
+   ses0.commit();
+
+   {
+      auto ses = db._undo_db.start_undo_session();
+      db.modify( bal, []( account_balance_object& obj ){ obj.balance = 20; } );
+      BOOST_CHECK_EQUAL( 1u, db._undo_db.head().packed_count() );
+      BOOST_CHECK_EQUAL( 1u, db._undo_db.head().count( graphene::db::undo_entry::modified ) );
+      db.modify( bal, []( account_balance_object& obj ){ obj.balance = 30; } );
+      ses.undo();
+   }
+   BOOST_CHECK_EQUAL( 10, db.get( bal_id ).balance.value );
+
+   // modify + remove restores the value from before the modification
+   {
+      auto ses = db._undo_db.start_undo_session();
+      db.modify( db.get( bal_id ), []( account_balance_object& obj ){ obj.balance = 40; } );
+      db.remove( db.get( bal_id ) );
+      BOOST_CHECK( db.find( bal_id ) == nullptr );
+      ses.undo();
+   }
+   BOOST_CHECK_EQUAL( 10, db.get( bal_id ).balance.value );
+
+   // merging a removal into a compact modification
+   {
+      auto outer = db._undo_db.start_undo_session();
+      db.modify( db.get( bal_id ), []( account_balance_object& obj ){ obj.balance = 50; } );
+      {
+         auto inner = db._undo_db.start_undo_session();
+         db.modify( db.get( bal_id ), []( account_balance_object& obj ){ obj.balance = 60; } );
+         db.remove( db.get( bal_id ) );
+         inner.merge();
+      }
+      BOOST_CHECK_EQUAL( 0u, db._undo_db.head().packed_count() );
+      BOOST_CHECK_EQUAL( 1u, db._undo_db.head().count( graphene::db::undo_entry::removed ) );
+      outer.undo();
+   }
+   BOOST_CHECK_EQUAL( 10, db.get( bal_id ).balance.value );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( compact_depth_test )
+{ try {
+   database db;
+   auto ses0 = db._undo_db.start_undo_session();
+   const auto& bal = db.create<account_balance_object>( []( account_balance_object& obj ){
+      obj.balance = 10;
+   });
+   ses0.commit();
+
+   db._undo_db.set_compact_depth( 1 );
+   auto ses1 = db._undo_db.start_undo_session();
+   db.modify( bal, []( account_balance_object& obj ){ obj.balance = 20; } );
+   BOOST_CHECK_EQUAL( 1u, db._undo_db.head().count( graphene::db::undo_entry::modified ) );
+   BOOST_CHECK_EQUAL( 0u, db._undo_db.packed_size() );
+
+   // starting another session compacts the state of ses1
+   auto ses2 = db._undo_db.start_undo_session();
+   BOOST_CHECK_GT( db._undo_db.packed_size(), 0u );
+   db.modify( bal, []( account_balance_object& obj ){ obj.balance = 30; } );
+   BOOST_CHECK_EQUAL( 1u, db._undo_db.head().count( graphene::db::undo_entry::modified ) );
+
+   ses2.undo();
+   BOOST_CHECK_EQUAL( 20, bal.balance.value );
+   ses1.undo();
+   BOOST_CHECK_EQUAL( 10, bal.balance.value );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( incremental_flush_test )
+{ try {
+   fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+   database db;
+   db.object_database::open( data_dir.path() ); // nothing on disk yet
+   const auto& bal_idx = db.get_index( account_balance_object::space_id, account_balance_object::type_id );
+   const auto& acc_idx = db.get_index( account_object::space_id, account_object::type_id );
+   BOOST_CHECK( bal_idx.is_dirty() );
+   BOOST_CHECK( acc_idx.is_dirty() );
+
+   db.flush();
+   BOOST_CHECK( !bal_idx.is_dirty() );
+   BOOST_CHECK( !acc_idx.is_dirty() );
+
+   db.create<account_balance_object>( []( account_balance_object& obj ){
+      obj.balance = 42;
+   });
+   BOOST_CHECK( bal_idx.is_dirty() );
+   BOOST_CHECK( !acc_idx.is_dirty() );
+
+   // account index file is reused, balance index is saved again
+   db.flush();
+   BOOST_CHECK( !bal_idx.is_dirty() );
+   BOOST_CHECK( fc::exists( data_dir.path() / "object_database" / fc::to_string( account_object::space_id )
+                                            / fc::to_string( account_object::type_id ) ) );
+
+   database db2;
+   db2.object_database::open( data_dir.path() );
+   BOOST_CHECK( !db2.get_index( account_balance_object::space_id, account_balance_object::type_id ).is_dirty() );
+   BOOST_CHECK_EQUAL( 42, db2.get_balance( account_id_type(), asset_id_type() ).amount.value );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( index_file_checksum_test )
+{ try {
+   fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+   const fc::path file = data_dir.path() / "object_database" / fc::to_string( account_balance_object::space_id )
+                                         / fc::to_string( account_balance_object::type_id );
+
+   {
+      database db;
+      db.object_database::open( data_dir.path() );
+      // enough objects for several chunks
+      for( int64_t i = 0; i < 100000; ++i )
+         db.create<account_balance_object>( [i]( account_balance_object& obj ){
+            obj.owner = account_id_type( i );
+            obj.balance = i;
+         });
+      db.flush();
+   }
+
+   {
+      database db;
+      db.object_database::open( data_dir.path() );
+      BOOST_CHECK_EQUAL( 99999, db.get_balance( account_id_type( 99999 ), asset_id_type() ).amount.value );
+   }
+
+   // damage the last chunk
+   std::string content;
+   fc::read_file_contents( file, content );
+   content.back() ^= 0x5a;
+   {
+      std::ofstream out( file.generic_string(), std::ios::out | std::ios::binary | std::ios::trunc );
+      out.write( content.data(), content.size() );
+   }
+   database db;
+   GRAPHENE_REQUIRE_THROW( db.object_database::open( data_dir.path() ), fc::exception );
+} FC_LOG_AND_RETHROW() }
+
+namespace {
+   struct node_pool_test_tag;
+   struct huge_node_pool_test_tag;
+}
+
+BOOST_AUTO_TEST_CASE( node_pool_test )
+{ try {
+   typedef boost::multi_index_container<
+      uint64_t,
+      boost::multi_index::indexed_by< boost::multi_index::ordered_unique< boost::multi_index::identity<uint64_t> > >,
+      graphene::db::node_allocator< uint64_t, node_pool_test_tag >
+   > pooled_set;
+   typedef graphene::db::node_pool_traits< pooled_set::allocator_type > pool_traits;
+
+   BOOST_CHECK( pool_traits::pooled );
+   BOOST_CHECK( !pool_traits::stats().enabled );
+
+   pooled_set before;
+   before.insert( 1 );
+   BOOST_CHECK_EQUAL( 0u, pool_traits::stats().chunks );
+
+   pool_traits::enable();
+   {
+      pooled_set values;
+      for( uint64_t i = 0; i < 100; ++i )
+         values.insert( i );
+      const auto stats = pool_traits::stats();
+      BOOST_CHECK( stats.enabled );
+      BOOST_CHECK_EQUAL( 1u, stats.chunks );
+      BOOST_CHECK_GE( stats.live_nodes, 100u );
+      values.erase( values.begin(), values.find( 50 ) );
+      BOOST_CHECK_GE( pool_traits::stats().free_nodes, 50u + stats.free_nodes );
+   }
+   // nodes allocated before pooling was enabled can be released safely, they go back to the heap
+   const auto stats = pool_traits::stats();
+   before.clear();
+   BOOST_CHECK_EQUAL( 1u, pool_traits::stats().chunks );
+   BOOST_CHECK_EQUAL( stats.free_nodes, pool_traits::stats().free_nodes );
+   BOOST_CHECK_EQUAL( stats.live_nodes, pool_traits::stats().live_nodes );
+
+   // indexes without a node_allocator can not be pooled
+   database db;
+   BOOST_CHECK( !db.enable_node_pool( account_object::space_id, account_object::type_id ) );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( node_pool_huge_pages_test )
+{ try {
+   typedef boost::multi_index_container<
+      uint64_t,
+      boost::multi_index::indexed_by< boost::multi_index::ordered_unique< boost::multi_index::identity<uint64_t> > >,
+      graphene::db::node_allocator< uint64_t, huge_node_pool_test_tag >
+   > pooled_set;
+   typedef graphene::db::node_pool_traits< pooled_set::allocator_type > pool_traits;
+
+   graphene::db::set_node_pool_pages( graphene::db::node_pool_pages::transparent_huge );
+   pool_traits::enable();
+   {
+      pooled_set values;
+      for( uint64_t i = 0; i < 10000; ++i )
+         values.insert( i );
+      values.erase( values.begin(), values.find( 5000 ) );
+      BOOST_CHECK_EQUAL( 5000u, values.size() );
+      const auto stats = pool_traits::stats();
+#ifdef __linux__
+      // chunks are whole huge pages, which hold all nodes at once
+      BOOST_CHECK_EQUAL( 1u, stats.chunks );
+      BOOST_CHECK_EQUAL( 0u, stats.reserved_bytes % ( 2 * 1024 * 1024 ) );
+#endif
+      BOOST_CHECK_GE( stats.reserved_bytes, stats.node_size * 10000 );
+   }
+   graphene::db::set_node_pool_pages( graphene::db::node_pool_pages::heap );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( task_pool_test )
+{ try {
+   using graphene::db::task_priority;
+   graphene::db::task_pool pool;
+   pool.set_thread_count( 1 );
+   BOOST_CHECK_EQUAL( 1u, pool.thread_count() );
+
+   // keep the only worker busy until all tasks are queued
+   std::promise<void> release;
+   std::shared_future<void> released = release.get_future().share();
+   auto blocker = pool.run( [released] () { released.wait(); } );
+
+   std::mutex order_mutex;
+   std::vector<int> order;
+   auto record = [&order,&order_mutex] ( int n ) {
+      std::lock_guard<std::mutex> lock( order_mutex );
+      order.push_back( n );
+   };
+   auto low = pool.run( [&record] () { record( 3 ); }, task_priority::low );
+   auto normal = pool.run( [&record] () { record( 2 ); return 42; } );
+   auto high = pool.run( [&record] () { record( 1 ); }, task_priority::high );
+   auto failing = pool.run( [] () -> int { FC_THROW( "task failed" ); }, task_priority::low );
+   BOOST_CHECK_EQUAL( 2u, pool.get_stats().low.queued );
+   release.set_value();
+
+   blocker.wait();
+   high.wait();
+   BOOST_CHECK_EQUAL( 42, normal.wait() );
+   low.wait();
+   GRAPHENE_REQUIRE_THROW( failing.wait(), fc::exception );
+   BOOST_REQUIRE_EQUAL( 3u, order.size() );
+   BOOST_CHECK_EQUAL( 1, order[0] );
+   BOOST_CHECK_EQUAL( 2, order[1] );
+   BOOST_CHECK_EQUAL( 3, order[2] );
+   // the only worker records the statistics of a task before it takes the next one
+   pool.run( [] () {}, task_priority::high ).wait();
+
+   const auto stats = pool.get_stats();
+   BOOST_CHECK_EQUAL( 1u, stats.threads );
+   BOOST_CHECK_EQUAL( 2u, stats.normal.completed );
+   BOOST_CHECK_EQUAL( 2u, stats.low.completed );
+   BOOST_CHECK_EQUAL( 0u, stats.low.queued );
+   pool.reset_stats();
+   BOOST_CHECK_EQUAL( 0u, pool.get_stats().low.completed );
+   GRAPHENE_REQUIRE_THROW( pool.set_thread_count( 2 ), fc::exception );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( interned_string_test )
+{ try {
+   using graphene::db::interned_string;
+
+   const std::string png = "interned_string_test/png";
+   interned_string a( png );
+   interned_string b;
+   BOOST_CHECK( b.empty() );
+   const size_t pool_size = interned_string::pool_size();
+
+   b = png;
+   BOOST_CHECK( a == b );
+   BOOST_CHECK( &a.str() == &b.str() );
+   BOOST_CHECK_EQUAL( a, png );
+   BOOST_CHECK_EQUAL( interned_string::pool_size(), pool_size );
+
+   interned_string c( "interned_string_test/jpeg" );
+   BOOST_CHECK( a != c );
+   BOOST_CHECK( c < a );
+   BOOST_CHECK_EQUAL( interned_string::pool_size(), pool_size + 1 );
+
+   // serialized like a plain string
+   BOOST_CHECK( fc::raw::pack( a ) == fc::raw::pack( png ) );
+   interned_string d = fc::raw::unpack<interned_string>( fc::raw::pack( png ) );
+   BOOST_CHECK( d == a );
+   fc::variant v;
+   fc::to_variant( c, v, 1 );
+   BOOST_CHECK_EQUAL( v.as_string(), c.str() );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( compact_content_id_test )
+{ try {
+   using graphene::chain::compact_content_id;
+
+   for( const std::string s : { "1.20.5", "0.0.0", "255.255.281474976710655" } )
+   {
+      compact_content_id id( s );
+      BOOST_CHECK( id.is_object_id() );
+      BOOST_CHECK_EQUAL( id.str(), s );
+   }
+   // anything that does not print back to the same text stays a string
+   for( const std::string s : { "", "1.20", "1.20.5.", "1.20.05", "01.20.5", "256.0.1", "1.20.281474976710656",
+                                "1.20.-5", "http://some.content/1.20.5" } )
+   {
+      compact_content_id id( s );
+      BOOST_CHECK( !id.is_object_id() );
+      BOOST_CHECK_EQUAL( id.str(), s );
+   }
+
+   BOOST_CHECK( compact_content_id( "1.20.5" ) == compact_content_id( std::string( "1.20.5" ) ) );
+   BOOST_CHECK( compact_content_id( "1.20.5" ) != compact_content_id( "1.20.05" ) );
+   BOOST_CHECK( compact_content_id( "1.20.9" ) < compact_content_id( "1.20.10" ) );
+   BOOST_CHECK( compact_content_id( "1.20.10" ) < compact_content_id( "1.20.05" ) );
+   BOOST_CHECK( compact_content_id( "a" ) < compact_content_id( "b" ) );
+   BOOST_CHECK( !( compact_content_id( "b" ) < compact_content_id( "1.20.5" ) ) );
+
+   compact_content_id a( "some content" );
+   compact_content_id b( a );
+   b = compact_content_id( "1.20.5" );
+   BOOST_CHECK_EQUAL( a.str(), "some content" );
+   a = b;
+   BOOST_CHECK( a == b );
+
+   // serialized like a plain string
+   BOOST_CHECK( fc::raw::pack( a ) == fc::raw::pack( std::string( "1.20.5" ) ) );
+   BOOST_CHECK( fc::raw::unpack<compact_content_id>( fc::raw::pack( std::string( "x" ) ) ) == compact_content_id( "x" ) );
+   fc::variant v;
+   fc::to_variant( a, v, 1 );
+   BOOST_CHECK_EQUAL( v.as_string(), "1.20.5" );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( direct_index_test )
 { try {
    try {
@@ -135,14 +608,13 @@ BOOST_AUTO_TEST_CASE( direct_index_test )
    BOOST_CHECK( nullptr != direct.find( account_id_type( 1 ) ) );
    BOOST_CHECK_EQUAL( test_account.name, direct.get( test_account.id ).name );
 
-   // The following assumes that MAX_HOLE = 100
    test_account.id = account_id_type(102);
    test_account.name = "account102";
-   // highest insert was 1, direct.next is 2 => 102 is highest allowed instance
    my_accounts.load( fc::raw::pack( test_account ) );
    BOOST_CHECK_EQUAL( test_account.name, direct.get( test_account.id ).name );
+   BOOST_CHECK_EQUAL( 1u, direct.allocated_chunks() );
 
-   // direct.next is now 103, but index sequence counter is 0
+   // the index sequence counter is 0
    my_accounts.create( [] ( object& o ) {
        account_object& acct = dynamic_cast< account_object& >( o );
        BOOST_CHECK_EQUAL( 0u, acct.id.instance() );
@@ -163,13 +635,23 @@ BOOST_AUTO_TEST_CASE( direct_index_test )
       _outer.options.voting_account = GRAPHENE_PROXY_TO_SELF_ACCOUNT;
    });
 
-   // direct.next is still 103, so 204 is not allowed
+   // gaps of any size are allowed, 204 is in the next chunk
    test_account.id = account_id_type(204);
    test_account.name = "account204";
-   GRAPHENE_REQUIRE_THROW( my_accounts.load( fc::raw::pack( test_account ) ), fc::assert_exception );
-   // This is actually undefined behaviour. The object has been inserted into
-   // the primary index, but the secondary has refused to insert it!
+   my_accounts.load( fc::raw::pack( test_account ) );
    BOOST_CHECK_EQUAL( 5u, my_accounts.indices().size() );
+   BOOST_CHECK_EQUAL( 2u, direct.allocated_chunks() );
+   BOOST_CHECK( nullptr == direct.find( account_id_type( 203 ) ) );
+   BOOST_CHECK( nullptr == direct.find( account_id_type( 100000 ) ) );
+
+   // inserting an object twice is refused, a chunk is released with its last object
+   graphene::db::direct_index< account_object, 8 > standalone;
+   standalone.object_inserted( direct.get( account_id_type(50) ) );
+   GRAPHENE_REQUIRE_THROW( standalone.object_inserted( direct.get( account_id_type(50) ) ), fc::assert_exception );
+   BOOST_CHECK_EQUAL( 1u, standalone.allocated_chunks() );
+   standalone.object_removed( direct.get( account_id_type(50) ) );
+   BOOST_CHECK_EQUAL( 0u, standalone.allocated_chunks() );
+   BOOST_CHECK( nullptr == standalone.find( account_id_type(50) ) );
 
    uint32_t count = 0;
    for( uint32_t i = 0; i < 250; i++ )
@@ -179,12 +661,12 @@ BOOST_AUTO_TEST_CASE( direct_index_test )
       {
          count++;
          BOOST_CHECK( aptr->id.instance() == 0 || aptr->id.instance() == 1
-                      || aptr->id.instance() == 50 || aptr->id.instance() == 102 );
+                      || aptr->id.instance() == 50 || aptr->id.instance() == 102 || aptr->id.instance() == 204 );
          BOOST_CHECK_EQUAL( i, aptr->id.instance() );
          BOOST_CHECK_EQUAL( "account" + std::to_string( i ), aptr->name );
       }
    }
-   BOOST_CHECK_EQUAL( count, my_accounts.indices().size() - 1 );
+   BOOST_CHECK_EQUAL( count, my_accounts.indices().size() );
 
    GRAPHENE_REQUIRE_THROW( my_accounts.modify( direct.get( account_id_type( 1 ) ), [] ( object& acct ) {
       acct.id = account_id_type(2);
@@ -280,4 +762,138 @@ BOOST_AUTO_TEST_CASE( required_approval_index_test ) // see https://github.com/b
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( apply_timing_test )
+{ try {
+   ACTORS( (alice)(bob) );
+   fund( alice, asset( 1000 ) );
+
+   // nothing is timed unless enabled
+   BOOST_CHECK( db.get_apply_timing().operations.empty() );
+
+   db.enable_apply_timing( true );
+   transfer( alice_id, bob_id, asset( 10 ) );
+   transfer( alice_id, bob_id, asset( 20 ) );
+   generate_block();
+
+   const auto timing = db.get_apply_timing();
+   BOOST_CHECK( timing.enabled );
+   auto itr = std::find_if( timing.operations.begin(), timing.operations.end(),
+                            []( const apply_timing_stats& s ) { return s.name == "transfer_operation"; } );
+   BOOST_REQUIRE( itr != timing.operations.end() );
+   BOOST_CHECK_GE( itr->count, 2u );
+   uint64_t in_histogram = 0;
+   for( uint64_t n : itr->histogram )
+      in_histogram += n;
+   BOOST_CHECK_EQUAL( in_histogram, itr->count );
+   BOOST_REQUIRE( !timing.handlers.empty() );
+   BOOST_CHECK_EQUAL( timing.handlers.front().name, "transaction" );
+   BOOST_CHECK_GE( timing.handlers.front().count, 2u );
+
+   db.reset_apply_timing();
+   BOOST_CHECK( db.get_apply_timing().operations.empty() );
+   db.enable_apply_timing( false );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( async_block_handler_test )
+{ try {
+   ACTORS( (alice)(bob) );
+   fund( alice, asset( 1000 ) );
+
+   std::mutex mutex;
+   vector<uint32_t> handled;
+   uint32_t transfers = 0;
+   auto handler = db.connect_applied_block_async( "test", 2, [&]( const applied_block_event& e ) {
+      std::lock_guard<std::mutex> guard( mutex );
+      handled.push_back( e.block.block_num() );
+      for( const auto& oho : *e.applied_operations )
+         if( oho.valid() && oho->op.is_type<transfer_operation>() )
+            ++transfers;
+   });
+
+   transfer( alice_id, bob_id, asset( 10 ) );
+   generate_blocks( 5 );
+   handler->drain();
+
+   const auto stats = db.get_async_block_handler_stats();
+   BOOST_REQUIRE_EQUAL( stats.size(), 1u );
+   BOOST_CHECK_EQUAL( stats.front().name, "test" );
+   BOOST_CHECK_EQUAL( stats.front().queued, 0u );
+   BOOST_CHECK_EQUAL( stats.front().last_handled_block, db.head_block_num() );
+   BOOST_CHECK_EQUAL( stats.front().last_queued_block, db.head_block_num() );
+   BOOST_CHECK_LE( stats.front().max_queued, 2u );
+
+   std::lock_guard<std::mutex> guard( mutex );
+   BOOST_REQUIRE_EQUAL( handled.size(), 5u );
+   for( size_t i = 1; i < handled.size(); ++i )
+      BOOST_CHECK_EQUAL( handled[i], handled[i-1] + 1 );
+   BOOST_CHECK_EQUAL( transfers, 1u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( startup_timing_test )
+{ try {
+   const auto& timing = app.get_startup_timing();
+   auto find_phase = [&timing]( const std::string& phase ) {
+      return std::find_if( timing.begin(), timing.end(), [&phase]( const graphene::app::startup_phase_timing& t ) {
+         return t.phase == phase;
+      });
+   };
+   const auto open = find_phase( "open chain database" );
+   const auto started = find_phase( "start plugin api_helper_indexes" );
+   const auto loaded = find_phase( "load plugin state api_helper_indexes" );
+   BOOST_REQUIRE( open != timing.end() );
+   BOOST_REQUIRE( started != timing.end() );
+   BOOST_REQUIRE( loaded != timing.end() );
+   BOOST_CHECK( find_phase( "initialize plugin api_helper_indexes" ) < open );
+   BOOST_CHECK( open < started );
+   BOOST_CHECK( started < loaded );
+   BOOST_CHECK( find_phase( "load plugin states" ) != timing.end() );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( state_hash_test )
+{ try {
+   ACTORS( (alice)(bob) );
+   fund( alice, asset( 1000 ) );
+
+   db.set_state_hash_blocks( 10 );
+   generate_block();
+   // a block without operations, so that plugins do not change objects after its hash is taken
+   generate_block();
+   const uint32_t first = db.head_block_num();
+   const auto first_hash = db.get_block_state_hash( first );
+   BOOST_REQUIRE( first_hash.valid() );
+   BOOST_CHECK( first_hash->block_id == db.head_block_id() );
+   BOOST_CHECK( first_hash->state_hash == db.get_state_hash() );
+
+   transfer( alice_id, bob_id, asset( 10 ) );
+   generate_block();
+   const auto second_hash = db.get_block_state_hash( first + 1 );
+   BOOST_REQUIRE( second_hash.valid() );
+   BOOST_CHECK( second_hash->state_hash != first_hash->state_hash );
+
+   // the incrementally updated hash matches a hash of all objects
+   graphene::db::state_hash_index scratch( account_object::space_id, account_object::type_id );
+   db.get_index_type<account_index>().inspect_all_objects( [&scratch]( const graphene::db::object& obj ) {
+      scratch.object_inserted( obj );
+   });
+   bool found = false;
+   for( const auto& idx : db.get_index_state_hashes() )
+   {
+      if( idx.space_id != account_object::space_id || idx.type_id != account_object::type_id )
+         continue;
+      found = true;
+      BOOST_CHECK_EQUAL( idx.object_count, scratch.get_state().object_count );
+      BOOST_CHECK( idx.hash == scratch.get_state().hash );
+   }
+   BOOST_CHECK( found );
+
+   // undoing the block restores the hash
+   db.pop_block();
+   BOOST_CHECK( db.get_state_hash() == first_hash->state_hash );
+   BOOST_CHECK( !db.get_block_state_hash( first + 1 ).valid() );
+
+   db.set_state_hash_blocks( 1 );
+   BOOST_CHECK( db.get_block_state_hash( first ).valid() );
+   BOOST_CHECK( !db.get_block_state_hash( first - 1 ).valid() );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -82,4 +82,115 @@ BOOST_AUTO_TEST_CASE(get_account_history) {
    }
 }
 
+BOOST_AUTO_TEST_CASE(get_account_history_archive) {
+   try {
+      graphene::app::history_api hist_api(app);
+
+      // only 2 entries per account stay in memory, the older ones are archived
+      auto nathan = create_account("nathan");
+      create_user_issued_asset("USD", nathan, 0);
+      create_account("dan");
+      create_account("bob");
+
+      generate_block();
+      fc::usleep(fc::milliseconds(2000));
+
+      int account_create_op_id = operation::tag<account_create_operation>::value;
+
+      const auto& stats = account_id_type()(db).statistics(db);
+      BOOST_CHECK_EQUAL(stats.total_ops, 3u);
+      BOOST_CHECK_EQUAL(stats.removed_ops, 1u);
+
+      // the archived entry is returned after the ones in memory
+      vector<operation_history_object> histories = hist_api.get_account_history("1.2.0", operation_history_id_type(), 100, operation_history_id_type());
+      BOOST_REQUIRE_EQUAL(histories.size(), 3u);
+      BOOST_CHECK_EQUAL(histories[2].id.instance(), 0u);
+      BOOST_CHECK_EQUAL(histories[2].op.which(), account_create_op_id);
+      BOOST_CHECK(histories[0].id.instance() > histories[1].id.instance());
+
+      histories = hist_api.get_account_history("1.2.0", operation_history_id_type(1), 100, operation_history_id_type());
+      BOOST_CHECK_EQUAL(histories.size(), 2u);
+
+      histories = hist_api.get_relative_account_history("1.2.0", 0, 100, 0);
+      BOOST_REQUIRE_EQUAL(histories.size(), 3u);
+      BOOST_CHECK_EQUAL(histories[2].id.instance(), 0u);
+
+      histories = hist_api.get_relative_account_history("1.2.0", 1, 1, 1);
+      BOOST_REQUIRE_EQUAL(histories.size(), 1u);
+      BOOST_CHECK_EQUAL(histories[0].id.instance(), 0u);
+
+      histories = hist_api.get_account_history_operations("1.2.0", account_create_op_id, operation_history_id_type(),
+                                                           operation_history_id_type(), 100);
+      BOOST_CHECK_EQUAL(histories.size(), 3u);
+
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE(get_account_history_by_operation_type) {
+   try {
+      graphene::app::history_api hist_api(app);
+
+      // history entries are looked up in the index by operation type
+      auto nathan = create_account("nathan");
+      create_user_issued_asset("USD", nathan, 0);
+      create_account("dan");
+      create_account("bob");
+
+      generate_block();
+      fc::usleep(fc::milliseconds(2000));
+
+      int asset_create_op_id = operation::tag<asset_create_operation>::value;
+      int account_create_op_id = operation::tag<account_create_operation>::value;
+
+      vector<operation_history_object> histories = hist_api.get_account_history_operations("1.2.0",
+            account_create_op_id, operation_history_id_type(), operation_history_id_type(), 100);
+      BOOST_REQUIRE_EQUAL(histories.size(), 3u);
+      BOOST_CHECK_EQUAL(histories[2].id.instance(), 0u);
+      BOOST_CHECK(histories[0].id.instance() > histories[1].id.instance());
+
+      histories = hist_api.get_account_history_operations("1.2.0", account_create_op_id,
+            operation_history_id_type(), operation_history_id_type(1), 100);
+      BOOST_CHECK_EQUAL(histories.size(), 2u);
+
+      histories = hist_api.get_account_history_operations("1.2.0", account_create_op_id,
+            operation_history_id_type(), operation_history_id_type(), 1);
+      BOOST_REQUIRE_EQUAL(histories.size(), 1u);
+      BOOST_CHECK(histories[0].id.instance() != 0u);
+
+      histories = hist_api.get_account_history_operations("nathan", asset_create_op_id,
+            operation_history_id_type(), operation_history_id_type(), 100);
+      BOOST_REQUIRE_EQUAL(histories.size(), 1u);
+      BOOST_CHECK_EQUAL(histories[0].op.which(), asset_create_op_id);
+
+      histories = hist_api.get_account_history_operations("nathan", account_create_op_id,
+            operation_history_id_type(), operation_history_id_type(), 100);
+      BOOST_CHECK_EQUAL(histories.size(), 1u);
+
+      history_operation_detail detail = hist_api.get_account_history_by_operations("nathan",
+            { static_cast<uint16_t>(asset_create_op_id) }, 1, 100);
+      BOOST_CHECK_EQUAL(detail.total_count, 2u);
+      BOOST_REQUIRE_EQUAL(detail.operation_history_objs.size(), 1u);
+      BOOST_CHECK_EQUAL(detail.operation_history_objs[0].op.which(), asset_create_op_id);
+
+      detail = hist_api.get_account_history_by_operations("nathan",
+            { static_cast<uint16_t>(asset_create_op_id), static_cast<uint16_t>(account_create_op_id) }, 1, 100);
+      BOOST_REQUIRE_EQUAL(detail.operation_history_objs.size(), 2u);
+      BOOST_CHECK_EQUAL(detail.operation_history_objs[0].op.which(), asset_create_op_id);
+      BOOST_CHECK_EQUAL(detail.operation_history_objs[1].op.which(), account_create_op_id);
+
+      // the index follows chain reorganizations
+      db.pop_block();
+      histories = hist_api.get_account_history_operations("1.2.0", account_create_op_id,
+            operation_history_id_type(), operation_history_id_type(), 100);
+      BOOST_CHECK_EQUAL(histories.size(), 0u);
+
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -26,6 +26,8 @@
 
 #include <graphene/app/api.hpp>
 #include <graphene/chain/hardfork.hpp>
+#include <graphene/net/core_messages.hpp>
+#include <graphene/net/message.hpp>
 
 #include <fc/crypto/digest.hpp>
 
@@ -72,6 +74,67 @@ BOOST_AUTO_TEST_CASE( broadcast_transaction_with_callback_test ) {
    } FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( broadcast_transactions_test ) {
+   try {
+
+      vector<variant> confirmations;
+      auto callback = [&]( const variant& v )
+      {
+         confirmations.push_back( v );
+      };
+
+      fc::ecc::private_key cid_key = fc::ecc::private_key::regenerate( fc::digest("key") );
+      const account_id_type cid_id = create_account( "cid", cid_key.get_public_key() ).id;
+      fund( cid_id(db) );
+
+      auto nb_api = std::make_shared< graphene::app::network_broadcast_api >( app );
+
+      vector<precomputable_transaction> trxs;
+      for( int i = 1; i <= 3; ++i )
+      {
+         set_expiration( db, trx );
+         transfer_operation trans;
+         trans.from = cid_id;
+         trans.to   = account_id_type();
+         trans.amount = asset(i);
+         trx.operations.push_back( trans );
+         sign( trx, cid_key );
+         trxs.push_back( trx );
+         trx.clear();
+      }
+      // not signed
+      set_expiration( db, trx );
+      transfer_operation trans;
+      trans.from = cid_id;
+      trans.to   = account_id_type();
+      trans.amount = asset(4);
+      trx.operations.push_back( trans );
+      trxs.push_back( trx );
+      trx.clear();
+
+      auto results = nb_api->broadcast_transactions_with_callback( callback, trxs );
+      BOOST_REQUIRE_EQUAL( results.size(), 4u );
+      for( size_t i = 0; i < 3; ++i )
+      {
+         BOOST_CHECK( results[i].accepted );
+         BOOST_CHECK( results[i].id == trxs[i].id() );
+      }
+      BOOST_CHECK( !results[3].accepted );
+      BOOST_CHECK( !results[3].error.empty() );
+
+      generate_block();
+
+      fc::usleep(fc::milliseconds(200)); // sleep a while to execute callback in another thread
+
+      // a single callback for the block with all transactions of the batch
+      BOOST_REQUIRE_EQUAL( confirmations.size(), 1u );
+      auto confirmed = confirmations.front().as< vector<graphene::app::network_broadcast_api::transaction_confirmation> >(
+                             GRAPHENE_MAX_NESTED_OBJECTS );
+      BOOST_CHECK_EQUAL( confirmed.size(), 3u );
+
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_CASE( broadcast_transaction_too_large ) {
    try {
 
@@ -95,4 +158,50 @@ BOOST_AUTO_TEST_CASE( broadcast_transaction_too_large ) {
    } FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( compact_block_with_missing_transaction ) {
+   try {
+
+      fc::ecc::private_key cid_key = fc::ecc::private_key::regenerate( fc::digest("key") );
+      const account_id_type cid_id = create_account( "cid", cid_key.get_public_key() ).id;
+      fund( cid_id(db) );
+
+      for( int64_t amount = 1; amount <= 2; ++amount )
+      {
+         set_expiration( db, trx );
+         transfer_operation trans;
+         trans.from = cid_id;
+         trans.to   = account_id_type();
+         trans.amount = asset(amount);
+         trx.operations.push_back( trans );
+         sign( trx, cid_key );
+         PUSH_TX( db, trx );
+         trx.clear();
+      }
+
+      const signed_block b = generate_block();
+      BOOST_REQUIRE_EQUAL( b.transactions.size(), 2u );
+      const graphene::net::message block_msg( graphene::net::block_message( b ) );
+      const graphene::net::compact_block_message compact( b, block_msg.id() );
+
+      // only the first transaction is in the pool of the receiver
+      std::vector<fc::optional<signed_transaction>> pending( 2 );
+      pending[0] = signed_transaction( b.transactions[0] );
+
+      signed_block rebuilt;
+      const std::vector<uint32_t> missing = compact.rebuild( rebuilt, pending );
+      BOOST_REQUIRE_EQUAL( missing.size(), 1u );
+      BOOST_CHECK_EQUAL( missing[0], 1u );
+
+      graphene::net::compact_block_transactions_message reply;
+      reply.block_id = compact.block_id;
+      reply.transaction_indexes = missing;
+      reply.transactions.push_back( signed_transaction( b.transactions[1] ) );
+      reply.add_to( rebuilt );
+
+      BOOST_CHECK( rebuilt.calculate_merkle_root() == b.transaction_merkle_root );
+      BOOST_CHECK( graphene::net::message( graphene::net::block_message( rebuilt ) ).id() == block_msg.id() );
+
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
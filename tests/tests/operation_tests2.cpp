@@ -1984,6 +1984,18 @@ BOOST_AUTO_TEST_CASE( top_n_special )
          BOOST_CHECK( stan_id(db).owner  == authority( 41376, bob_id, 32750,                  dan_id, 50000 ) );
          BOOST_CHECK( stan_id(db).active == authority( 57751, bob_id, 32750, chloe_id, 32750, dan_id, 50000 ) );
 
+         // Stan is not modified by a maintenance which leaves the holders as they are
+         bool stan_changed = false;
+         auto connection = db.changed_objects.connect( [&]( const vector<object_id_type>& ids,
+                                                             const impacted_accounts_provider& ) {
+            if( std::find( ids.begin(), ids.end(), object_id_type( stan_id ) ) != ids.end() )
+               stan_changed = true;
+         } );
+         generate_blocks(db.get_dynamic_global_properties().next_maintenance_time);
+         connection.disconnect();
+         BOOST_CHECK( !stan_changed );
+         BOOST_CHECK( stan_id(db).active == authority( 57751, bob_id, 32750, chloe_id, 32750, dan_id, 50000 ) );
+
          // TODO more rounding checks
       }
 
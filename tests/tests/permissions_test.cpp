@@ -26,6 +26,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <graphene/app/database_api.hpp>
+#include <graphene/content_cards/content_cards.hpp>
 
 #include "../common/database_fixture.hpp"
 
@@ -144,4 +145,108 @@ BOOST_AUTO_TEST_CASE( multiple_permissions )
    BOOST_CHECK(db_api.get_permissions(account.get_id(), last_permission_id, 2u).size() == 1u);
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( get_permissions_by_accounts )
+{ try {
+   ACTORS((alice)(bob)(carol));
+   graphene::app::database_api db_api(db, &(this->app.get_options()));
+
+   auto grant = [&]( account_id_type oper, const std::string& permission_type ) {
+      permission_create_operation op;
+      op.subject_account = alice_id;
+      op.operator_account = oper;
+      op.permission_type = permission_type;
+      op.content_key = "content";
+
+      signed_transaction trx;
+      set_expiration( db, trx );
+      trx.operations.push_back(op);
+      sign(trx, alice_private_key);
+      PUSH_TX(db, trx);
+   };
+   grant( bob_id, "type1" );
+   grant( carol_id, "type1" );
+   grant( bob_id, "type2" );
+
+   auto perms = db_api.get_permissions_by_accounts({ carol_id, alice_id, bob_id }, 100);
+   BOOST_REQUIRE_EQUAL(perms.size(), 3u);
+   BOOST_REQUIRE_EQUAL(perms[0].size(), 1u);
+   BOOST_CHECK(perms[0][0].operator_account == carol_id);
+   BOOST_CHECK(perms[1].empty());
+   BOOST_REQUIRE_EQUAL(perms[2].size(), 2u);
+   BOOST_CHECK_EQUAL(perms[2][0].permission_type, "type1");
+   BOOST_CHECK_EQUAL(perms[2][1].permission_type, "type2");
+
+   // the limit applies to all accounts together
+   perms = db_api.get_permissions_by_accounts({ carol_id, bob_id, carol_id }, 2);
+   BOOST_REQUIRE_EQUAL(perms.size(), 3u);
+   BOOST_CHECK_EQUAL(perms[0].size(), 1u);
+   BOOST_CHECK_EQUAL(perms[1].size(), 1u);
+   BOOST_CHECK(perms[2].empty());
+
+   GRAPHENE_CHECK_THROW(db_api.get_permissions_by_accounts({ bob_id }, 101), fc::exception);
+   GRAPHENE_CHECK_THROW(db_api.get_permissions_by_accounts(vector<account_id_type>(101, bob_id), 1), fc::exception);
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( get_permissions_by_object )
+{ try {
+   ACTORS((alice)(bob)(carol));
+
+   auto plugin = app.register_plugin<graphene::content_cards::content_cards_plugin>(true);
+   plugin->plugin_startup();
+   plugin->plugin_load_state();
+   graphene::app::database_api db_api(db, &(this->app.get_options()));
+
+   const object_id_type card( 1, 20, 7 );
+   auto grant = [&]( account_id_type subject, const fc::ecc::private_key& key, account_id_type oper,
+                     optional<object_id_type> object_id, const std::string& content_key ) {
+      permission_create_operation op;
+      op.subject_account = subject;
+      op.operator_account = oper;
+      op.permission_type = "type";
+      op.object_id = object_id;
+      op.content_key = content_key;
+
+      signed_transaction trx;
+      set_expiration( db, trx );
+      trx.operations.push_back(op);
+      sign(trx, key);
+      return permission_id_type( PUSH_TX(db, trx).operation_results[0].get<object_id_type>() );
+   };
+
+   BOOST_CHECK(db_api.get_permissions_by_object(carol_id, card, 100).empty());
+   const auto alice_perm = grant( alice_id, alice_private_key, carol_id, card, "alice_key" );
+   grant( bob_id, bob_private_key, carol_id, card, "bob_key" );
+   grant( bob_id, bob_private_key, carol_id, object_id_type( 1, 20, 8 ), "other_key" );
+   grant( bob_id, bob_private_key, carol_id, optional<object_id_type>(), "any_key" );
+   grant( bob_id, bob_private_key, alice_id, card, "alice_access" );
+
+   auto perms = db_api.get_permissions_by_object(carol_id, card, 100);
+   BOOST_REQUIRE_EQUAL(perms.size(), 2u);
+   BOOST_CHECK(perms[0].subject_account == alice_id);
+   BOOST_CHECK_EQUAL(perms[0].content_key, "alice_key");
+   BOOST_CHECK(perms[1].subject_account == bob_id);
+   BOOST_CHECK_EQUAL(perms[1].content_key, "bob_key");
+   BOOST_CHECK_EQUAL(db_api.get_permissions_by_object(carol_id, card, 1).size(), 1u);
+   GRAPHENE_CHECK_THROW(db_api.get_permissions_by_object(carol_id, card, 101), fc::exception);
+
+   // removal and undo keep the lookup in sync
+   generate_block();
+   permission_remove_operation rop;
+   rop.subject_account = alice_id;
+   rop.permission_id = alice_perm;
+   signed_transaction trx;
+   set_expiration( db, trx );
+   trx.operations.push_back(rop);
+   sign(trx, alice_private_key);
+   PUSH_TX(db, trx);
+   perms = db_api.get_permissions_by_object(carol_id, card, 100);
+   BOOST_REQUIRE_EQUAL(perms.size(), 1u);
+   BOOST_CHECK(perms[0].subject_account == bob_id);
+
+   db.clear_pending();
+   perms = db_api.get_permissions_by_object(carol_id, card, 100);
+   BOOST_REQUIRE_EQUAL(perms.size(), 2u);
+   BOOST_CHECK(perms[0].id == alice_perm);
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
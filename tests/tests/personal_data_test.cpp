@@ -26,6 +26,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <graphene/app/database_api.hpp>
+#include <graphene/api_helper_indexes/api_helper_indexes.hpp>
 
 #include "../common/database_fixture.hpp"
 
@@ -125,4 +126,99 @@ BOOST_AUTO_TEST_CASE( get_personal_data_v2 )
    } FC_LOG_AND_RETHROW()
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( get_personal_data_v2_paging )
+{ try {
+   const auto owner_private_key = generate_private_key("owner of the data");
+   const auto owner_account = create_account("owner", owner_private_key.get_public_key());
+   const auto owner_id = owner_account.get_id();
+
+   for( const std::string data : { "data1", "data2", "data3" } )
+   {
+      personal_data_v2_create_operation op;
+      op.subject_account = owner_id;
+      op.operator_account = owner_id;
+      op.url = "url";
+      op.hash = fc::sha256::hash(data);
+      op.storage_data = "storage_data";
+
+      signed_transaction trx;
+      set_expiration( db, trx );
+      trx.operations.push_back(op);
+      sign(trx, owner_private_key);
+      PUSH_TX(db, trx);
+   }
+
+   graphene::app::database_api db_api(db, &(this->app.get_options()));
+   const auto all = db_api.get_personal_data_v2(owner_id, owner_id);
+   BOOST_REQUIRE_EQUAL(all.size(), 3u);
+
+   const auto first_page = db_api.get_personal_data_v2(owner_id, owner_id, {}, 2);
+   BOOST_REQUIRE_EQUAL(first_page.size(), 2u);
+   BOOST_CHECK(first_page[0].id == all[0].id);
+
+   // the cursor object is returned again as the first one
+   const auto second_page = db_api.get_personal_data_v2(owner_id, owner_id, personal_data_v2_id_type(first_page[1].id), 2);
+   BOOST_REQUIRE_EQUAL(second_page.size(), 2u);
+   BOOST_CHECK(second_page[0].id == all[1].id);
+   BOOST_CHECK(second_page[1].id == all[2].id);
+
+   // the cursor has to belong to the queried accounts
+   const auto op_account = create_account("op");
+   GRAPHENE_REQUIRE_THROW(db_api.get_personal_data_v2(owner_id, op_account.get_id(), personal_data_v2_id_type(all[0].id), 2),
+                          fc::exception);
+
+   const uint32_t configured_limit = this->app.get_options().api_limit_get_personal_data;
+   GRAPHENE_REQUIRE_THROW(db_api.get_personal_data_v2(owner_id, owner_id, {}, configured_limit + 1), fc::exception);
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( personal_data_proof )
+{ try {
+   using graphene::api_helper_indexes::personal_data_merkle_index;
+
+   const auto owner_private_key = generate_private_key("owner of the data");
+   const auto owner_account = create_account("owner", owner_private_key.get_public_key());
+   const auto owner_id = owner_account.get_id();
+   graphene::app::database_api db_api(db, &(this->app.get_options()));
+
+   vector<std::string> hashes;
+   auto add = [&]( const std::string& data ) {
+      personal_data_v2_create_operation op;
+      op.subject_account = owner_id;
+      op.operator_account = owner_id;
+      op.url = "url";
+      op.hash = fc::sha256::hash(data);
+      op.storage_data = "storage_data";
+
+      signed_transaction trx;
+      set_expiration( db, trx );
+      trx.operations.push_back(op);
+      sign(trx, owner_private_key);
+      PUSH_TX(db, trx);
+      hashes.push_back( op.hash );
+   };
+
+   BOOST_CHECK(!db_api.get_personal_data_proof(owner_id, owner_id, fc::sha256::hash(std::string("data0"))).valid());
+
+   // every tree size up to a few levels, including odd ones
+   fc::sha256 previous_root;
+   for( int i = 1; i <= 7; ++i )
+   {
+      add( "data" + fc::to_string(i) );
+      for( const auto& hash : hashes )
+      {
+         const auto proof = db_api.get_personal_data_proof(owner_id, owner_id, hash);
+         BOOST_REQUIRE(proof.valid());
+         BOOST_CHECK_EQUAL(proof->leaf_count, hashes.size());
+         BOOST_CHECK(personal_data_merkle_index::verify(*proof, hash));
+         BOOST_CHECK(!personal_data_merkle_index::verify(*proof, hash + "x"));
+         BOOST_CHECK(proof->root != previous_root);
+      }
+      previous_root = db_api.get_personal_data_proof(owner_id, owner_id, hashes[0])->root;
+   }
+
+   // other accounts have their own tree
+   const auto other = create_account("other");
+   BOOST_CHECK(!db_api.get_personal_data_proof(owner_id, other.get_id(), hashes[0]).valid());
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
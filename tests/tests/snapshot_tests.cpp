@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2018-2022 Revolution Populi Limited, and contributors.
+ * 
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/snapshot/binary_snapshot.hpp>
+
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/config.hpp>
+
+#include <graphene/utilities/tempdir.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+using namespace graphene::snapshot_plugin;
+
+BOOST_FIXTURE_TEST_SUITE( snapshot_tests, database_fixture )
+
+BOOST_AUTO_TEST_CASE( binary_snapshot_import )
+{ try {
+   ACTORS( (alice)(bob) );
+   generate_blocks( 5 );
+
+   fc::temp_directory dir( graphene::utilities::temp_directory_path() );
+   const fc::path snapshot_file = dir.path() / "snapshot.bin";
+   const auto signing_key = fc::ecc::private_key::regenerate( fc::sha256::hash( string("snapshot") ) );
+   write_binary_snapshot( db, snapshot_file, signing_key );
+
+   // the snapshot must be signed by the trusted key
+   const auto other_key = fc::ecc::private_key::regenerate( fc::sha256::hash( string("other") ) );
+   GRAPHENE_REQUIRE_THROW( import_binary_snapshot( snapshot_file, dir.path() / "untrusted",
+                                                   public_key_type( other_key.get_public_key() ) ),
+                           fc::exception );
+   BOOST_CHECK( !fc::exists( dir.path() / "untrusted" / "object_database" ) );
+
+   const fc::path data_dir = dir.path() / "blockchain";
+   import_binary_snapshot( snapshot_file, data_dir, public_key_type( signing_key.get_public_key() ) );
+   // importing twice is refused
+   GRAPHENE_REQUIRE_THROW( import_binary_snapshot( snapshot_file, data_dir, {} ), fc::exception );
+
+   database db2;
+   db2.open( data_dir, [] { return genesis_state_type(); }, GRAPHENE_CURRENT_DB_VERSION );
+   BOOST_CHECK_EQUAL( db2.head_block_num(), db.head_block_num() );
+   BOOST_CHECK( db2.head_block_id() == db.head_block_id() );
+   BOOST_CHECK( db2.get_chain_id() == db.get_chain_id() );
+   BOOST_CHECK( db2.get( alice_id ).name == "alice" );
+   BOOST_CHECK( db2.get( bob_id ).name == "bob" );
+   BOOST_CHECK_EQUAL( db2.get_index_type<account_index>().indices().size(),
+                      db.get_index_type<account_index>().indices().size() );
+   BOOST_CHECK( db2.fetch_block_by_number( db.head_block_num() ).valid() );
+
+   // the imported node continues with new blocks
+   db2.push_block( generate_block(), database::skip_witness_signature );
+   BOOST_CHECK( db2.head_block_id() == db.head_block_id() );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( binary_snapshot_is_detached )
+{ try {
+   ACTORS( (alice) );
+   generate_block();
+
+   const snapshot_data data = capture_binary_snapshot( db );
+   const block_id_type captured_head = db.head_block_id();
+   BOOST_CHECK( data.header.head_block_id == captured_head );
+   for( const auto& index : data.indexes )
+   {
+      BOOST_CHECK_EQUAL( index.first.chunk_count, index.second.size() );
+      for( const snapshot_chunk& chunk : index.second )
+         BOOST_CHECK( chunk.hash == fc::sha256::hash( chunk.data.data(), chunk.data.size() ) );
+   }
+
+   // changes after the capture do not end up in the snapshot
+   ACTORS( (bob) );
+   generate_block();
+
+   fc::temp_directory dir( graphene::utilities::temp_directory_path() );
+   write_binary_snapshot( data, dir.path() / "snapshot.bin", {} );
+   import_binary_snapshot( dir.path() / "snapshot.bin", dir.path() / "blockchain", {} );
+
+   database db2;
+   db2.open( dir.path() / "blockchain", [] { return genesis_state_type(); }, GRAPHENE_CURRENT_DB_VERSION );
+   BOOST_CHECK( db2.head_block_id() == captured_head );
+   BOOST_CHECK( db2.find( alice_id ) != nullptr );
+   BOOST_CHECK( db2.find( bob_id ) == nullptr );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -950,4 +950,54 @@ BOOST_AUTO_TEST_CASE( committee_votes_calculation )
    } FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( witness_votes_calculation_incremental )
+{
+   try
+   {
+      db.enable_incremental_vote_tally( true, true );
+      INVOKE( witness_votes_calculation );
+
+      const auto stats = db.get_vote_tally_stats();
+      BOOST_CHECK( stats.enabled );
+      BOOST_CHECK_GT( stats.accounts, 0u );
+      BOOST_CHECK_EQUAL( stats.mismatches, 0u );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( committee_votes_calculation_incremental )
+{
+   try
+   {
+      db.enable_incremental_vote_tally( true, true );
+      INVOKE( committee_votes_calculation );
+      BOOST_CHECK_EQUAL( db.get_vote_tally_stats().mismatches, 0u );
+
+      BOOST_TEST_MESSAGE( "Unchanged accounts are not tallied again" );
+      db.enable_incremental_vote_tally( true );
+      generate_blocks( db.get_dynamic_global_properties().next_maintenance_time );
+      generate_blocks( db.get_dynamic_global_properties().next_maintenance_time );
+      const auto stats = db.get_vote_tally_stats();
+      BOOST_CHECK_GT( stats.reused, 0u );
+      BOOST_CHECK_EQUAL( stats.mismatches, 0u );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( witness_votes_calculation_parallel )
+{
+   try
+   {
+      db.enable_parallel_maintenance( true );
+      INVOKE( witness_votes_calculation );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( committee_votes_calculation_parallel )
+{
+   try
+   {
+      db.enable_parallel_maintenance( true );
+      INVOKE( committee_votes_calculation );
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()